@@ -7,6 +7,7 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -16,12 +17,96 @@ namespace Dynarmic {
 class Coprocessor;
 class Jit;
 
+/// A host implementation of a guest function (see Jit::SetHostFunction).
+using HostFunction = void (*)(Jit* jit, void* user_arg);
+
+/// Hint instructions reported to UserCallbacks::CallHint.
+enum class Hint : std::uint8_t {
+    Yield,
+    WaitForEvent,
+    WaitForInterrupt,
+    SendEvent,
+};
+
+/// The accesses watched by a watchpoint (see Jit::SetWatchpoint).
+enum class WatchpointKind : std::uint8_t {
+    None = 0,
+    Read = 1 << 0,
+    Write = 1 << 1,
+    ReadWrite = Read | Write,
+};
+
+/// Why execution left the emitted code of a block other than by a direct link (see UserCallbacks::count_exits).
+enum class ExitReason : std::uint8_t {
+    CycleBudget,     ///< The cycle budget given to Jit::Run ran out at the end of the block
+    Halt,            ///< A halt was requested, e.g. by Jit::HaltExecution or a write to translated code
+    Unlinked,        ///< A direct branch to a block that is not in the cache, or cannot be linked to
+    RSBMiss,         ///< A return (PopRSBHint) whose target was not the one predicted by the return stack buffer
+    InlineCacheMiss, ///< An indirect branch whose target was not in the inline cache of its block
+    Dispatch,        ///< An indirect branch that went straight to the dispatcher, as with concurrent execution
+    Interpret,       ///< An instruction that had to be run by UserCallbacks::InterpreterFallback
+    TierUp,          ///< The block became hot and returned to be retranslated (see hot_block_threshold)
+    RegisterGuard,   ///< A register did not hold the value the block was specialized on (see specialize_register_values)
+};
+constexpr std::size_t ExitReasonCount = 9;
+
+/// The kinds of callback from emitted code whose durations are measured (see UserCallbacks::measure_latency).
+enum class CallbackKind : std::uint8_t {
+    Memory,      ///< Memory.Read*/Memory.Write*, their MemoryWithUserArg variants and MMIO handlers
+    Supervisor,  ///< CallSVC and svc_handlers
+    Coprocessor, ///< Callbacks returned by a Coprocessor's Compile* methods
+    Interpreter, ///< InterpreterFallback
+};
+constexpr std::size_t CallbackKindCount = 4;
+
+/// Buckets of a LatencyHistogram: bucket i > 0 counts durations in [2^i, 2^(i+1)) ticks, bucket 0 those under 2.
+constexpr std::size_t LatencyBucketCount = 64;
+
+/// A guest memory access recorded by memory access tracing (see UserCallbacks::memory_trace_size).
+struct MemoryAccessRecord {
+    std::uint32_t pc;    ///< Address of the guest instruction that made the access
+    std::uint32_t vaddr;
+    std::uint8_t size;   ///< Bytes accessed; all the bytes transferred for LDM, STM, VLDM and VSTM
+    bool is_write;
+};
+
+/// The calls to one guest function seen by call profiling (see UserCallbacks::profile_guest_calls).
+struct GuestFunctionProfile {
+    std::uint32_t entry;             ///< Address the function was called at, without the Thumb bit
+    std::uint64_t calls;             ///< Calls that have returned
+    std::uint64_t inclusive_cycles;  ///< Guest cycles from call to return, counting recursive calls once
+    std::uint64_t exclusive_cycles;  ///< Inclusive cycles less those spent in the functions it called
+};
+
+/// The handlers for the accesses to a memory-mapped device (see UserCallbacks::mmio_pages).
+struct MmioHandler {
+    /// Passed to each of the handlers, e.g. the device being accessed.
+    void* device;
+
+    // Any of these may be nullptr, in which case accesses of that size go to the Memory.Read*/Memory.Write*
+    // callbacks as usual. Accesses may not be aligned and are passed the full vaddr.
+    // Memory must be interpreted as if ENDIANSTATE == 0, endianness will be corrected by the JIT.
+    std::uint8_t (*Read8)(void* device, std::uint32_t vaddr);
+    std::uint16_t (*Read16)(void* device, std::uint32_t vaddr);
+    std::uint32_t (*Read32)(void* device, std::uint32_t vaddr);
+    std::uint64_t (*Read64)(void* device, std::uint32_t vaddr);
+
+    void (*Write8)(void* device, std::uint32_t vaddr, std::uint8_t value);
+    void (*Write16)(void* device, std::uint32_t vaddr, std::uint16_t value);
+    void (*Write32)(void* device, std::uint32_t vaddr, std::uint32_t value);
+    void (*Write64)(void* device, std::uint32_t vaddr, std::uint64_t value);
+};
+
 /// These function pointers may be inserted into compiled code.
 struct UserCallbacks {
     struct Memory {
         // All reads through this callback are 4-byte aligned.
         // Memory must be interpreted as little endian.
         std::uint32_t (*ReadCode)(std::uint32_t vaddr);
+        // Optional. If not nullptr, returns a pointer to the 4 KiB of host memory holding the code page
+        // that begins at the page-aligned vaddr, or nullptr if ReadCode should be used for that page.
+        // Instructions are then read directly from there when blocks are translated.
+        const std::uint8_t* (*GetCodePage)(std::uint32_t vaddr);
 
         // Reads through these callbacks may not be aligned.
         // Memory must be interpreted as if ENDIANSTATE == 0, endianness will be corrected by the JIT.
@@ -41,6 +126,7 @@ struct UserCallbacks {
         // return the same value at any point in time for this vaddr. The JIT may use this information
         // in optimizations.
         // An conservative implementation that always returns false is safe.
+        // Not called if read_only_pages is set. May be nullptr, which is treated as always returning false.
         bool (*IsReadOnlyMemory)(std::uint32_t vaddr);
     } memory = {};
 
@@ -48,9 +134,49 @@ struct UserCallbacks {
     void (*InterpreterFallback)(std::uint32_t pc, Jit* jit, void* user_arg);
     void* user_arg = nullptr;
 
+    /// Variants of the Memory.Read*/Memory.Write* callbacks that are also passed user_arg, so that each
+    /// Jit's accesses can reach its own state. Each of these that is not nullptr is called from
+    /// emitted code and during optimization in place of the corresponding Memory callback.
+    struct MemoryWithUserArg {
+        std::uint8_t (*Read8)(void* user_arg, std::uint32_t vaddr);
+        std::uint16_t (*Read16)(void* user_arg, std::uint32_t vaddr);
+        std::uint32_t (*Read32)(void* user_arg, std::uint32_t vaddr);
+        std::uint64_t (*Read64)(void* user_arg, std::uint32_t vaddr);
+
+        void (*Write8)(void* user_arg, std::uint32_t vaddr, std::uint8_t value);
+        void (*Write16)(void* user_arg, std::uint32_t vaddr, std::uint16_t value);
+        void (*Write32)(void* user_arg, std::uint32_t vaddr, std::uint32_t value);
+        void (*Write64)(void* user_arg, std::uint32_t vaddr, std::uint64_t value);
+    } memory_with_user_arg = {};
+
     // This callback is called whenever a SVC instruction is executed.
     void (*CallSVC)(std::uint32_t swi);
 
+    // Hint instructions
+    // If not nullptr, YIELD, WFE, WFI and SEV end the block they are in and call this callback, with PC
+    // already set to the next instruction. It may e.g. park the thread until an event, hand the rest of
+    // the slice to another core with Jit::HaltExecution, or skip ahead to the next timer event with
+    // Jit::SetCyclesRemaining. Otherwise these instructions are NOPs, so an idle loop spins until the
+    // cycle budget runs out. Hints in Thumb IT blocks are always NOPs.
+    void (*CallHint)(Hint hint, Jit* jit, void* user_arg) = nullptr;
+
+    // Watchpoints
+    // If not nullptr, enables Jit::SetWatchpoint: each guest access to a watched page is made through the
+    // MemoryRead*/MemoryWrite* callbacks and first calls this callback with the address being accessed, e.g.
+    // so that a debugger can compare it against its watched ranges and stop with Jit::HaltExecution once the
+    // block ends. Accesses to other pages only pay for a check of the page, and stay on the fast path.
+    // Reads that are optimized away (see memory_forwarding and read_only_pages) and accesses to constant
+    // addresses of mmio_pages devices are not seen.
+    void (*WatchpointHit)(std::uint32_t vaddr, bool is_write, Jit* jit, void* user_arg) = nullptr;
+
+    // SVC handlers
+    // If not nullptr, a SVC instruction whose immediate is less than NUM_SVC_HANDLERS calls the entry
+    // for that immediate directly instead of CallSVC, unless the entry is nullptr. The table is read
+    // when a block is translated, so changes to it only affect blocks translated afterwards
+    // (see Jit::ClearCache).
+    static constexpr std::size_t NUM_SVC_HANDLERS = 256;
+    const std::array<void (*)(std::uint32_t swi), NUM_SVC_HANDLERS>* svc_handlers = nullptr;
+
     // Page Table
     // The page table is used for faster memory access. If an entry in the table is nullptr,
     // the JIT will fallback to calling the MemoryRead*/MemoryWrite* callbacks.
@@ -58,8 +184,253 @@ struct UserCallbacks {
     static constexpr std::size_t NUM_PAGE_TABLE_ENTRIES = 1 << (32 - PAGE_BITS);
     std::array<std::uint8_t*, NUM_PAGE_TABLE_ENTRIES>* page_table = nullptr;
 
+    // Two-level page table
+    // An alternative to page_table for sparse address spaces: rather than 8 MiB, it takes 8 KiB plus 8 KiB
+    // for each 4 MiB of the address space that has pages mapped. Entry (vaddr >> 22) of the directory is
+    // nullptr if no page in those 4 MiB is mapped, or else a second-level table whose entry
+    // ((vaddr >> PAGE_BITS) & 1023) is the host page as in page_table. Each access takes one more load
+    // than with page_table. Only used if page_table is nullptr.
+    static constexpr std::size_t PAGE_DIRECTORY_BITS = 10;
+    static constexpr std::size_t NUM_PAGE_DIRECTORY_ENTRIES = 1 << PAGE_DIRECTORY_BITS;
+    static constexpr std::size_t NUM_SECOND_LEVEL_PAGE_TABLE_ENTRIES = 1 << (32 - PAGE_BITS - PAGE_DIRECTORY_BITS);
+    using SecondLevelPageTable = std::array<std::uint8_t*, NUM_SECOND_LEVEL_PAGE_TABLE_ENTRIES>;
+    std::array<SecondLevelPageTable*, NUM_PAGE_DIRECTORY_ENTRIES>* page_directory = nullptr;
+
+    // Read-only pages
+    // If not nullptr, this replaces Memory.IsReadOnlyMemory: the bit for page (vaddr >> PAGE_BITS) is
+    // set if and only if that vaddr is read-only memory in the sense described above. Constant reads
+    // from read-only pages that are also present in the page table are then done directly, without calling
+    // the MemoryRead* callbacks. Code may still hold values read from a page after its bit is cleared,
+    // until that code is invalidated (see Jit::InvalidateCacheRange).
+    const std::bitset<NUM_PAGE_TABLE_ENTRIES>* read_only_pages = nullptr;
+
+    // Memory-mapped I/O
+    // If not nullptr, an access to a page (vaddr >> PAGE_BITS) whose entry is not nullptr calls that
+    // entry's handler for the access size instead of the MemoryRead*/MemoryWrite* callbacks, so that
+    // each device is reached directly. A device spanning several pages has its handler in each of them.
+    // The pages of devices must be nullptr in the page table, inaccessible through fastmem_pointer, and not
+    // read-only memory. Accesses to constant addresses are bound to their handler when translated, so
+    // changes to the table only take effect for them once the code is invalidated (see Jit::ClearCache).
+    const std::array<const MmioHandler*, NUM_PAGE_TABLE_ENTRIES>* mmio_pages = nullptr;
+
+    // Fastmem
+    // If not nullptr, guest address vaddr is accessed directly at host address fastmem_pointer + vaddr,
+    // so this must point to a 4 GiB reservation of host address space mirroring guest memory.
+    // Pages that are not accessible through it must be left inaccessible (e.g. PROT_NONE): the JIT
+    // catches the resulting access fault and falls back to calling the MemoryRead*/MemoryWrite*
+    // callbacks for that access from then on. Takes precedence over page_table and page_directory.
+    std::uint8_t* fastmem_pointer = nullptr;
+
+    // Address spaces
+    // The number of guest address spaces (e.g. processes) that code is kept for at once, at most 8.
+    // Jit::SetAddressSpace switches between them, each with its own fastmem reservation, page table or
+    // page directory of the same kind as configured above, which is that of address space 0. Blocks are
+    // looked up by address space as well as by address, so switching needs no invalidation. The callbacks,
+    // read_only_pages, mmio_pages and detect_self_modifying_code apply in every address space alike; the
+    // callbacks must read from the current one. If greater than 1, read-only memory is read at translation
+    // time through the callbacks rather than the page tables. Cannot be combined with background_translation.
+    std::size_t address_space_count = 1;
+
+    // Memory forwarding
+    // If true, optimized blocks may replace a memory read with the value most recently written to or
+    // read from that address earlier in the same block, instead of calling the MemoryRead* callbacks.
+    // Known values are dropped at DMB and DSB, and at accesses to constant addresses of mmio_pages devices.
+    // Only enable this if no other read may have side effects or return a value other than the last
+    // write, e.g. because another core or a device modifies that memory.
+    bool memory_forwarding = false;
+
+    // Register passing
+    // If true, a direct link between two blocks passes up to four of the guest registers that the
+    // target block reads in host registers, so the target does not have to load them from the CPU state.
+    // Guest registers are still written back as they are set. The MemoryRead*/MemoryWrite* callbacks
+    // must then not modify the guest registers (through Jit::Regs), as a block may not reload them.
+    bool pass_registers_across_links = false;
+
+    // Exclusive monitor
+    // If true, STREX and friends are emitted as a host atomic compare-and-exchange against the value
+    // observed by the preceding LDREX, which makes exclusive accesses coherent between Jits running on
+    // different host threads and sharing guest memory. The store succeeds whenever memory still holds
+    // that value, even if it was written in the meantime. Requires fastmem_pointer or a page table;
+    // accesses that cannot go through either fall back to the MemoryWrite* callbacks non-atomically.
+    bool global_exclusive_monitor = false;
+
+    // Spin loops
+    // If true, a block that branches back to itself without writing memory and without carrying any
+    // register or flag value from one iteration to the next (e.g. ldr; cmp; bne polling memory) uses up
+    // the rest of the cycle budget when it loops, as it would otherwise keep repeating itself until memory
+    // changes. Jit::Run then returns, so the caller can skip ahead to its next event. Set this only if
+    // the MemoryRead* callbacks have no side effects that such a loop could be waiting on.
+    bool skip_spin_loops = false;
+
+    // Self-modifying code
+    // If true, the JIT tracks the guest pages it has translated code from, and a guest write to such a page
+    // invalidates all the code translated from that page once the block making the write has ended, as
+    // Jit::InvalidateCacheRange would. Guest code that generates or patches code then runs correctly without
+    // the cache being invalidated by hand. Writes made by the host rather than the guest (e.g. loading a
+    // program into memory) must still be followed by Jit::InvalidateCacheRange. Each write to memory needs an
+    // extra check, and code sharing a page with data that is written while the code runs is translated repeatedly.
+    // With background_translation, a write made while a block is being translated from its page may be missed.
+    bool detect_self_modifying_code = false;
+
+    // Memory access tracing
+    // If nonzero, each guest memory access is recorded in a ring buffer of this many MemoryAccessRecords
+    // belonging to the Jit, which the host drains with Jit::ReadMemoryTrace, possibly from another thread
+    // while the Jit runs. The oldest records are overwritten when the buffer is full. Must be a power of 2.
+    // Accesses are recorded as they are made by optimized code: reads replaced by memory_forwarding, or by
+    // constants read from read-only memory at translation time, are not recorded.
+    std::size_t memory_trace_size = 0;
+
+    // Guest call profiling
+    // If true, BL and BLX record a call to their target, and returns (BX LR and pops of PC) record the
+    // return of the call whose return address they branch to, each timestamped with the guest cycle
+    // counter. Jit::GetCallProfile then gives the cycles spent in each function called. Returns that skip
+    // frames (e.g. longjmp) end the frames they skip, and returns that match no call are ignored. Each
+    // call and return costs a call out of emitted code.
+    bool profile_guest_calls = false;
+
+    // Floating point accuracy
+    // If false, NaNs are not fixed up to match ARM: results are not replaced with the default NaN
+    // when FPSCR.DN is set, and conversions of NaN to an integer saturate instead of returning zero.
+    // Guest code that never produces or inspects NaNs behaves the same either way; FP-heavy code
+    // runs faster without the extra instructions. Denormal handling is unaffected.
+    bool accurate_nan = true;
+
     // Coprocessors
     std::array<std::shared_ptr<Coprocessor>, 16> coprocessors;
+    // If true, reads of the PMU cycle counter PMCCNTR (MRC p15, 0, <Rt>, c9, c13, 0) are emitted inline
+    // instead of going through coprocessors[15]. The counter counts the cycles executed by this Jit, as
+    // Jit::Run does, including those of the instructions before the read in its block. It is set with
+    // Jit::SetCycleCounter. Other CP15 accesses still go to coprocessors[15].
+    bool inline_cycle_counter = false;
+
+    // Return stack buffer
+    // Depth of the return stack used to predict the targets of function returns.
+    // MUST be a power of 2 and at most 64. Only the top entry is checked on a return, so a deeper
+    // stack costs no extra time.
+    std::size_t rsb_size = 32;
+
+    // Code cache
+    // Size in bytes of the address space reserved for this Jit's code cache. Memory is only committed
+    // as it is used, so a large reservation costs little. Must be less than 2 GiB, as generated code
+    // relies on rel32 branches within the cache.
+    std::size_t code_cache_size = 128 * 1024 * 1024;
+    // If true, the code cache is mapped twice: code is written through a read-write view and executed
+    // from a separate read-execute view, so no page is ever writable and executable at once. Use this
+    // on hosts that forbid RWX mappings. Costs address space, not memory.
+    bool dual_mapped_code_cache = false;
+    // If true, the code cache is aligned to and backed by huge pages where the host allows it
+    // (transparent huge pages on Linux, large pages on Windows, which need SeLockMemoryPrivilege and are
+    // committed up front). Fewer iTLB misses when hot code is spread over a large cache.
+    bool huge_page_code_cache = false;
+    // If nonzero, the optimized IR of up to this many of the most recently translated blocks is kept,
+    // so that a block emitted again after a cache clear or eviction is rebuilt from it rather than
+    // translated and optimized again. IR is only reused if the guest code it came from, and any read-only
+    // memory folded into it, is unchanged. IR that folded a constant coprocessor register is not kept.
+    // No IR is kept if GetInstructionCycles is set, as the cycle counts of blocks are part of their IR.
+    std::size_t ir_cache_capacity = 0;
+
+    // Tiering
+    // If nonzero, newly translated blocks count their executions and are retranslated with the full
+    // set of optimizations after executing this many times. This keeps translation of cold code cheap.
+    // If zero, all blocks are fully optimized when first translated. Must be less than 2^31.
+    std::size_t hot_block_threshold = 0;
+    // If nonzero and tiering is enabled, hot blocks keep counting their executions, and after every this
+    // many tier-ups the most frequently executed of them are re-emitted contiguously into a region of the
+    // code cache reserved for them, each next to a block it links to. Keeps hot loops on few pages.
+    std::size_t hot_layout_interval = 0;
+    // If nonzero, tiering is driven by samples instead: blocks are emitted without counting their executions,
+    // and the host passes Jit::RecordSample the host PC at which execution was interrupted, e.g. from the
+    // handler of a periodic timer signal. A block is retranslated with the full set of optimizations once
+    // this many samples have fallen in its code, and the hot layout places the most sampled hot blocks.
+    // Hot code thus carries no instrumentation. hot_block_threshold is ignored, and traces are not recorded.
+    std::size_t hot_block_samples = 0;
+    // If true and hot_block_threshold is set, cold blocks also record the values of up to four of the
+    // registers they read on entry, and a block that becomes hot is translated assuming that those that
+    // held the same value on every entry keep it, as a loop-invariant base address or `this` pointer
+    // would, so that it is folded into addresses and reads of read-only memory. The hot block checks
+    // the values on entry; if one differs, the block is retranslated without the assumption, for good.
+    // Has no effect with hot_block_samples.
+    bool specialize_register_values = false;
+
+    // Block size
+    // If nonzero, translation ends a block after this many guest instructions, and the rest of the code
+    // is translated as the blocks that follow. Shorter blocks are quicker to translate and optimize, but
+    // are linked more often and optimized across fewer instructions. Zero leaves blocks, superblocks and
+    // traces bounded only by the length whose code is sure to fit in the code cache, which grows with
+    // code_cache_size (about 500 instructions for the default).
+    std::size_t max_block_instructions = 0;
+
+    // Superblocks
+    // If nonzero, translation follows unconditional direct branches (B, BL) so that straight-line
+    // code spanning several basic blocks is translated as one block of at most this many instructions.
+    // If tiering is enabled, only hot blocks are translated this way.
+    std::size_t superblock_instruction_budget = 0;
+
+    // Traces
+    // If nonzero and tiering is enabled, a block of ARM code that becomes hot first has the blocks executed
+    // after it recorded, one at a time, and if execution comes back to it, as at the head of a loop, it is
+    // retranslated along that path as one block of at most this many instructions. Conditional branches
+    // on the path continue in the direction they took while recorded, with an exit from the middle of the
+    // block for the other. Suits loops whose hot path crosses branches that mostly go the same way.
+    // Ignored if background_translation is set.
+    std::size_t trace_instruction_budget = 0;
+
+    // Interpreter tier
+    // If nonzero, newly translated blocks are run by an interpreter over their IR until they have executed
+    // this many times, and only then is host code emitted for them. This saves emitting code that runs
+    // only a few times, such as initialisation code. Blocks with floating point arithmetic, vector,
+    // exclusive or coprocessor instructions are always emitted. Ignored if background_translation is set.
+    std::size_t interpreter_threshold = 0;
+
+    // Background translation
+    // If true, blocks that are not in the cache are translated on a worker thread while the guest
+    // makes progress one instruction at a time through InterpreterFallback. Finished blocks are
+    // added to the cache whenever execution returns to the dispatcher loop.
+    // Memory.ReadCode, Memory.GetCodePage, Memory.IsReadOnlyMemory and the Memory.Read* callbacks for read-only memory
+    // are then called from the worker thread, concurrently with emulation.
+    bool background_translation = false;
+    // If nonzero, when a block is translated on a cache miss, the blocks it directly links to are translated
+    // too, and theirs in turn, this many blocks deep, so that straight-line code runs linked from its first
+    // execution rather than returning to the dispatcher at every new edge. With background_translation
+    // they are queued on the worker thread. Each If terminal doubles the blocks per level; keep this small.
+    std::size_t speculative_translation_depth = 0;
+
+    // Cycle costs
+    // The cycles each guest instruction counts for against the budget given to Jit::Run. By default
+    // every instruction counts for one. An instruction whose condition fails always counts for one.
+    // Costs are added up when a block is translated, so they cost nothing when it runs.
+    std::size_t cycles_per_instruction = 1;
+    // Added for each memory access; LDM, STM, VLDM and VSTM add it for each register they transfer.
+    std::size_t cycles_per_memory_access = 0;
+    // Added for each multiply, including those of multiply-accumulates and long multiplies.
+    std::size_t cycles_per_multiply = 0;
+    // If not nullptr, returns the cycles the instruction at pc counts for, in place of the costs above.
+    // For a 32-bit Thumb instruction, `instruction` holds its first halfword in its upper half. Called
+    // when a block is translated, on the worker thread with background_translation.
+    std::size_t (*GetInstructionCycles)(std::uint32_t pc, std::uint32_t instruction, bool is_thumb, void* user_arg) = nullptr;
+
+    // Profiling
+    // If true, every block is recorded in /tmp/perf-<pid>.map as it is emitted, named after its guest
+    // PC and location hash, so that perf can attribute time spent in emitted code to guest code.
+    // Only supported on Linux. Entries are not removed when blocks are invalidated.
+    bool perf_map = false;
+
+    // If true, each block records the host code offsets at which the guest instruction being executed
+    // changes, so that Jit::HostPcToGuestPc can map any address in emitted code to a guest PC.
+    bool guest_pc_map = false;
+
+    // If true, emitted code counts the times execution leaves each block for each ExitReason, and
+    // the times each block branches directly to each other block, whether linked or not. The totals
+    // are reported in JitStatistics::exits; Jit::DumpCodeCache exports the counts of each block with
+    // the link graph. A block's counts are discarded with its code. Makes every exit a little slower.
+    bool count_exits = false;
+
+    // If true, the time-stamp counter is read around the latency-sensitive parts of Jit::Run, which are
+    // reported as histograms in JitStatistics: from the call to Run to entering the first block, each
+    // lookup of the block to execute (including translating it if it is missing), and each callback
+    // from emitted code by CallbackKind. Adds a few instructions around each callback made by blocks
+    // emitted while set; it applies to all Jits sharing the code cache if set for the one creating it.
+    bool measure_latency = false;
 };
 
 } // namespace Dynarmic
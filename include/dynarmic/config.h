@@ -0,0 +1,57 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <dynarmic/callbacks.h>
+
+namespace Dynarmic {
+
+/// Presets for JitConfig, from the least time spent compiling guest code to the fastest emitted code.
+enum class OptimizationLevel {
+    /// Short blocks, interpreted for their first few executions, and only fully optimized if they stay hot.
+    FastCompile,
+    /// Blocks are emitted with few optimizations at first, and fully optimized, as superblocks, once hot.
+    Balanced,
+    /// Every block is fully optimized as a superblock when first translated, along with the blocks it links to.
+    MaxThroughput,
+};
+
+/**
+ * Settings that trade the time spent compiling guest code against the speed of the code emitted, kept apart
+ * from the UserCallbacks that describe the guest. A configuration starts from a preset whose settings can then
+ * be changed one by one; ApplyTo puts them in the UserCallbacks a Jit is constructed with. Each setting is
+ * described at the UserCallbacks member of the same name.
+ */
+struct JitConfig {
+    explicit JitConfig(OptimizationLevel level = OptimizationLevel::Balanced);
+
+    // Translation
+    std::size_t max_block_instructions;
+    std::size_t superblock_instruction_budget;
+    std::size_t trace_instruction_budget;
+    std::size_t speculative_translation_depth;
+
+    // Tiering
+    std::size_t interpreter_threshold;
+    std::size_t hot_block_threshold;
+    std::size_t hot_layout_interval;
+
+    // Accuracy
+    bool accurate_nan;
+
+    // Caches
+    std::size_t code_cache_size;
+    std::size_t ir_cache_capacity;
+    std::size_t rsb_size;
+
+    /// Returns `callbacks` with the settings of this configuration in place of its own.
+    UserCallbacks ApplyTo(UserCallbacks callbacks) const;
+};
+
+} // namespace Dynarmic
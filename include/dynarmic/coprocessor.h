@@ -82,6 +82,18 @@ public:
      */
     virtual CallbackOrAccessOneWord CompileGetOneWord(bool two, unsigned opc1, CoprocReg CRn, CoprocReg CRm, unsigned opc2) = 0;
 
+    /**
+     * Called when compiling MRC or MRC2 for this coprocessor, before CompileGetOneWord.
+     * Returns the value of the register read if it is fixed for the lifetime of the Jit (e.g. an ID register),
+     * in which case reads of it will be compiled as this value, which lets the optimizer fold code that
+     * depends on it. A return value of boost::none compiles the read as described by CompileGetOneWord.
+     * This may be called more than once for the same instruction, including from the background
+     * translation thread if UserCallbacks::background_translation is set, and must return the same each time.
+     */
+    virtual boost::optional<std::uint32_t> GetConstantOneWord(bool /*two*/, unsigned /*opc1*/, CoprocReg /*CRn*/, CoprocReg /*CRm*/, unsigned /*opc2*/) {
+        return boost::none;
+    }
+
     /**
      * Called when compiling MRRC or MRRC2 for this coprocessor.
      * A return value of boost::blank will cause a coprocessor exception to be compiled.
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <dynarmic/callbacks.h>
+#include <dynarmic/config.h>
 
 namespace Dynarmic {
 
@@ -19,9 +22,142 @@ namespace IR {
 class LocationDescriptor;
 }
 
+/**
+ * Durations measured with the time-stamp counter of the host (see UserCallbacks::measure_latency),
+ * bucketed by powers of two of ticks (see LatencyBucketCount). A thread that is moved to another
+ * core mid-measurement may count a duration in the last bucket.
+ */
+struct LatencyHistogram {
+    std::array<std::uint64_t, LatencyBucketCount> counts{};
+};
+
+/// Counters describing the work done by a Jit, for monitoring. See Jit::GetStatistics.
+struct JitStatistics {
+    // Shared by all Jits sharing a code cache with this one.
+    std::uint64_t blocks_translated = 0;     ///< Blocks translated from guest code, including retranslations of hot blocks
+    std::uint64_t bytes_emitted = 0;         ///< Bytes of host code emitted for blocks, excluding rarely executed paths
+    std::uint64_t cache_hits = 0;            ///< Lookups by Jit::Run of the block to execute that found it already emitted
+    std::uint64_t cache_misses = 0;          ///< Lookups by Jit::Run of the block to execute that had to translate it
+    std::uint64_t translate_time_ns = 0;     ///< Time spent decoding guest code into IR
+    std::uint64_t optimize_time_ns = 0;      ///< Time spent in IR optimization passes
+    std::uint64_t emit_time_ns = 0;          ///< Time spent emitting host code
+    std::uint64_t ir_cache_hits = 0;         ///< Translations skipped by rebuilding retained IR (see UserCallbacks::ir_cache_capacity)
+
+    /// Totals over all runs of one optimization pass.
+    struct Pass {
+        std::string name;                    ///< Pipeline and pass, e.g. "hot.ConstantPropagation"
+        std::uint64_t runs;
+        std::uint64_t time_ns;
+        std::uint64_t instructions_before;   ///< Sum of the number of IR instructions in each block before the pass
+        std::uint64_t instructions_after;    ///< Sum of the number of IR instructions in each block after the pass
+    };
+    /// Passes in the order they run. Cold blocks are those translated before they become hot (see hot_block_threshold),
+    /// and step blocks those of Jit::RunInstructions.
+    std::vector<Pass> passes;
+
+    // Specific to this Jit, counted since it was constructed.
+    std::uint64_t dispatcher_exits = 0;      ///< Times emitted code returned to Jit::Run
+    std::uint64_t interpreter_fallbacks = 0; ///< Calls to UserCallbacks::InterpreterFallback
+    std::uint64_t blocks_interpreted = 0;    ///< Blocks run by the interpreter tier (see UserCallbacks::interpreter_threshold)
+    std::uint64_t spin_loops_skipped = 0;    ///< Times a spin loop used up the cycle budget (see UserCallbacks::skip_spin_loops)
+    /// Times emitted code was left for each reason, indexed by ExitReason. Only counted with UserCallbacks::count_exits.
+    std::array<std::uint64_t, ExitReasonCount> exits{};
+
+    // Specific to this Jit and only measured with UserCallbacks::measure_latency.
+    std::uint64_t tsc_frequency = 0;         ///< Ticks of the time-stamp counter per second, estimated from the time since the Jit was constructed
+    LatencyHistogram run_entry;              ///< From each call to Jit::Run to entering the first block to execute, or interpreting it
+    LatencyHistogram dispatch_hits;          ///< Lookups by Jit::Run of the block to execute that found it, including waiting for the code cache
+    LatencyHistogram dispatch_misses;        ///< Lookups by Jit::Run of the block to execute that translated it
+    /// Callbacks made from emitted code, indexed by CallbackKind.
+    std::array<LatencyHistogram, CallbackKindCount> callbacks{};
+};
+
+/// A block translated as hot, as recorded for a warm start of a later run of the same program (see Jit::GetHotBlocks).
+struct HotBlockRecord {
+    std::uint64_t location;        ///< The block's location hash, as in Jit::DumpCodeCache, which encodes its PC, modes and address space
+    std::uint64_t execution_count; ///< Executions counted for the hot layout, or samples with sampled tiering; 0 if not counted
+};
+
+/// Approximate memory used by a Jit and its code cache, as returned by Jit::GetMemoryUsage. Sizes are in bytes.
+struct JitMemoryUsage {
+    // Shared by all Jits sharing a code cache with this one.
+    std::size_t code_space_reserved = 0;      ///< Address space reserved for the code cache (see UserCallbacks::code_cache_size)
+    std::size_t code_space_used = 0;          ///< Of the code cache, the bytes holding code and data, including invalidated blocks that are yet to be evicted
+    std::size_t prelude_bytes = 0;            ///< Of code_space_used, those of the code and data emitted once per cache, such as the dispatcher
+    std::size_t constant_bytes = 0;           ///< Of prelude_bytes, those of constants used by emitted code
+    std::size_t block_count = 0;              ///< Blocks in the code cache
+    std::size_t block_descriptor_bytes = 0;   ///< Host memory describing the blocks in the code cache
+    std::size_t patch_site_count = 0;         ///< Locations in emitted code that are patched as the blocks they jump to are emitted or invalidated
+    std::size_t patch_information_bytes = 0;  ///< Host memory recording patch sites and other locations in emitted code that are rewritten
+    std::size_t ir_bytes = 0;                 ///< Host memory holding the IR of blocks that are interpreted (see interpreter_threshold) or retained (see ir_cache_capacity)
+
+    // Specific to this Jit.
+    std::size_t jit_state_bytes = 0;          ///< The guest state, including the return stack buffer and the memory trace (see memory_trace_size)
+};
+
+/**
+ * A saved copy of all of a Jit's guest CPU state: the registers, CPSR, FPSCR, exclusive monitor and
+ * return stack buffer. See Jit::SaveContext and Jit::LoadContext.
+ */
+class JitContext final {
+public:
+    JitContext();
+    JitContext(const JitContext& other);
+    JitContext& operator=(const JitContext& other);
+    ~JitContext();
+
+private:
+    friend class Jit;
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/**
+ * Keeps the code caches of destroyed Jits for reuse. Constructing a Jit from a pool takes an idle
+ * cache when there is one, which avoids reserving code space and generating the dispatcher and
+ * memory accessor thunks again; only the new Jit's CPU state is fresh. The cache of a Jit from a
+ * pool is cleared and returned to the pool when the Jit (and any Jit sharing its cache) is destroyed.
+ * All Jits constructed from a pool must use callbacks identical to those the pool was constructed
+ * with, except for user_arg. Jits may outlive their pool; their caches are then destroyed with them.
+ */
+class JitPool final {
+public:
+    /// @param max_idle_caches The number of idle caches to keep. Each keeps its code space committed.
+    explicit JitPool(Dynarmic::UserCallbacks callbacks, std::size_t max_idle_caches = 16);
+    ~JitPool();
+
+    /// Constructs idle caches ahead of time, until there are count (at most max_idle_caches) of them.
+    void Reserve(std::size_t count);
+
+private:
+    friend class Jit;
+    struct Impl;
+    std::shared_ptr<Impl> impl;
+};
+
+/**
+ * An emulated CPU. Multi-core guests are emulated with one Jit per core, all sharing one code cache
+ * (see the constructor taking another Jit). These Jits may run simultaneously on different host
+ * threads over the same guest memory; each of them must only be used by one thread at a time.
+ * Code invalidated through any of them is invalidated for all, and an exclusive write that succeeds
+ * on one core clears the reservations of the other cores on the same address. For deterministic
+ * execution, the cores can also be run in turn on one thread with RunLockstep.
+ */
 class Jit final {
 public:
     explicit Jit(Dynarmic::UserCallbacks callbacks);
+
+    /**
+     * Constructs a Jit that shares its code cache with `other`, e.g. to emulate another core of the same guest.
+     * Code translated by any Jit sharing the cache is used by all of them, and invalidating the cache
+     * through any of them halts the others while it happens. Each Jit has its own CPU state.
+     * The Jits may run on different threads. `callbacks` must be identical to those `other` was
+     * constructed with, except for user_arg.
+     */
+    Jit(Dynarmic::UserCallbacks callbacks, Jit& other);
+
+    /// Constructs a Jit with a code cache taken from `pool` (see JitPool).
+    Jit(Dynarmic::UserCallbacks callbacks, JitPool& pool);
     ~Jit();
 
     /**
@@ -32,34 +168,239 @@ public:
      */
     std::size_t Run(std::size_t cycle_count);
 
+    /**
+     * Runs the emulated CPU for exactly instruction_count instructions, e.g. to single-step in a debugger or
+     * to replay a recording deterministically. An instruction whose condition fails counts as executed.
+     * Execution stops early where Run would halt: on HaltExecution, SignalInterrupt, a breakpoint or a
+     * write to translated code. Each instruction counts for one cycle, whatever the cycle costs, both in
+     * the cycle counter and towards GetCyclesRemaining within callbacks.
+     * The code run is translated into blocks of at most a few instructions that return to the dispatcher
+     * after every block; they are cached apart from the code of Run, which they neither link to nor
+     * replace, and are discarded along with it.
+     * Cannot be recursively called, nor called from a callback.
+     * @returns The number of instructions executed.
+     */
+    std::size_t RunInstructions(std::size_t instruction_count);
+
+    /**
+     * Executes the instruction at PC (see RunInstructions).
+     * @returns Whether it was executed, i.e. execution was not stopped before it.
+     */
+    bool Step();
+
+    /**
+     * Returns the number of cycles executed so far by the current Jit::Run. The cycles of the block
+     * making the callback are counted when the block ends.
+     * Can only be called from a callback.
+     */
+    std::size_t GetCyclesExecuted() const;
+
+    /**
+     * Returns the number of cycles the current Jit::Run has left to execute.
+     * Can only be called from a callback.
+     */
+    std::size_t GetCyclesRemaining() const;
+
+    /**
+     * Shortens or extends the current Jit::Run so that it runs for about cycle_count more cycles, e.g. to
+     * stop at a newly scheduled event. Unlike HaltExecution, execution continues without leaving emitted
+     * code until the new budget is used up. The final block may overrun it, as with Run's cycle_count.
+     * Can only be called from a callback.
+     */
+    void SetCyclesRemaining(std::size_t cycle_count);
+
+    /**
+     * Returns the value of the guest cycle counter (see UserCallbacks::inline_cycle_counter), which counts
+     * the cycles executed by this Jit. Within a callback, the cycles of the block making it are not yet counted.
+     */
+    std::uint64_t GetCycleCounter() const;
+
+    /**
+     * Sets the guest cycle counter (see UserCallbacks::inline_cycle_counter), which counts on from value.
+     * Can be called at any time.
+     */
+    void SetCycleCounter(std::uint64_t value);
+
     /**
      * Clears the code cache of all compiled code.
      * Can be called at any time. Halts execution if called within a callback.
      */
     void ClearCache();
 
+    /**
+     * Invalidate the code cache at a range of addresses.
+     * Only blocks containing guest code in this range are discarded; the rest of the cache is kept.
+     * Can be called at any time. Halts execution if called within a callback.
+     * @param start_address The starting address of the range to invalidate.
+     * @param length The length (in bytes) of the range to invalidate.
+     */
+    void InvalidateCacheRange(std::uint32_t start_address, std::size_t length);
+
+    /**
+     * Switches guest memory to another address space (see UserCallbacks::address_space_count), e.g. on
+     * a guest process switch. Code translated in each address space is kept and only runs in it, so
+     * switching back to a process reuses its code. Can be called at any time, and is saved with the
+     * rest of the CPU state by SaveContext. Within a callback, it takes effect at the end of the current block.
+     * @param address_space The slot of the address space, less than address_space_count.
+     * @param memory_base Its fastmem reservation, page table or page directory, whichever is configured
+     *                    in UserCallbacks, or nullptr if none is. Address space 0 starts with that of UserCallbacks.
+     */
+    void SetAddressSpace(std::size_t address_space, void* memory_base);
+    std::size_t GetAddressSpace() const;
+
+    /**
+     * Discards all code translated in an address space, e.g. before its slot is reused for another process.
+     * Can be called at any time. Halts execution if called within a callback.
+     */
+    void InvalidateAddressSpace(std::size_t address_space);
+
     /**
      * Reset CPU state to state at startup. Does not clear code cache.
      * Cannot be called from a callback.
      */
     void Reset();
 
+    /**
+     * Copies the CPU state into context, e.g. for savestates or rewinding. Reusing the same context
+     * for every save does not allocate.
+     */
+    JitContext SaveContext() const;
+    void SaveContext(JitContext& context) const;
+
+    /**
+     * Restores CPU state saved by SaveContext, replacing the whole of the current state; there is
+     * no need to call Reset first. The return stack buffer is kept if no code has been discarded
+     * from the cache since the context was saved. Statistics are not restored.
+     * Cannot be called from a callback.
+     */
+    void LoadContext(const JitContext& context);
+
+    /**
+     * Calls `function` in place of the guest function at `address` (e.g. memcpy or __aeabi_idiv) whenever
+     * guest code branches to it, in either ARM or Thumb state. The host function reads its arguments from
+     * and writes its results to Regs(), and execution then continues at the return address that was in
+     * LR. Pass nullptr to remove the replacement. Applies to all Jits sharing this Jit's code cache.
+     * Cannot be called from a callback.
+     */
+    void SetHostFunction(std::uint32_t address, HostFunction function);
+
+    /**
+     * Sets or clears a breakpoint at `address`. Execution stops before the instruction at a breakpoint, in
+     * either ARM or Thumb state, whether or not its condition passes: Jit::Run returns as if HaltExecution
+     * had been called, with PC set to `address`. The next Run starting there executes the instruction rather
+     * than stopping again. Only the blocks containing `address` are retranslated; all other code keeps
+     * running at full speed. Has no effect at the address of a host function (see SetHostFunction).
+     * Applies to all Jits sharing this Jit's code cache.
+     * Cannot be called from a callback.
+     */
+    void SetBreakpoint(std::uint32_t address, bool enabled);
+
+    /**
+     * Translates the guest code reachable from `entry_point` by direct branches, as far as it lies within
+     * [start_address, start_address + length), so that it is not translated when first executed. Code is
+     * translated for the current instruction set, processor mode and FPSCR mode. With
+     * UserCallbacks::background_translation it is translated on the worker thread and emitted by later calls
+     * to Run; otherwise Precompile returns once it has been emitted.
+     * Cannot be called from a callback.
+     */
+    void Precompile(std::uint32_t entry_point, std::uint32_t start_address, std::size_t length);
+
+    /**
+     * Returns the blocks in the code cache that have been translated as hot (every block if tiering is
+     * disabled), hottest first, e.g. to be saved when the program exits. Blocks whose heat is not counted
+     * (see HotBlockRecord::execution_count) come last. Only locations are recorded, not code or IR, so the
+     * list stays valid across builds of dynarmic and changes to the guest code.
+     * Cannot be called from a callback.
+     */
+    std::vector<HotBlockRecord> GetHotBlocks() const;
+
+    /**
+     * Translates the blocks of `blocks`, as returned by GetHotBlocks in an earlier run, as hot and in order,
+     * skipping those already translated as hot and those in address spaces this Jit does not have. With
+     * UserCallbacks::background_translation they are translated on the worker thread and emitted by later
+     * calls to Run, so that execution starts right away while the working set warms up; otherwise
+     * PrecompileHotBlocks returns once they have been emitted. Use Precompile for code to translate
+     * regardless of how hot it was.
+     * Cannot be called from a callback.
+     */
+    void PrecompileHotBlocks(const std::vector<HotBlockRecord>& blocks);
+
+    /**
+     * Writes the optimized IR retained by this Jit's code cache (see UserCallbacks::ir_cache_capacity) to the
+     * file at `path`, so that a later run of the same program can load it with LoadIRCache and skip
+     * translating and optimizing again. The calls of host functions (see SetHostFunction) and blocks stopping
+     * at breakpoints are not retained, so they are not saved. Returns false if the file could not be written.
+     */
+    bool SaveIRCache(const std::string& path) const;
+
+    /**
+     * Adds the IR in the file at `path`, written by SaveIRCache, to the IR retained by this Jit's code cache,
+     * up to UserCallbacks::ir_cache_capacity blocks. Blocks are only used if their guest code is unchanged
+     * when they are first needed. Returns false, loading nothing, if the file could not be read or was written
+     * by a different build of dynarmic or with different translation or optimization settings.
+     * Cannot be called from a callback.
+     */
+    bool LoadIRCache(const std::string& path);
+
+    /**
+     * Watches the accesses of `kind` to the pages overlapping [start_address, start_address + length), replacing
+     * what was watched on them before; WatchpointKind::None stops watching them. Each such access calls
+     * UserCallbacks::WatchpointHit, which must be set. Takes effect immediately without invalidating any code,
+     * and applies to all Jits sharing this Jit's code cache.
+     * Can be called at any time, except from callbacks made while translating guest code.
+     */
+    void SetWatchpoint(std::uint32_t start_address, std::size_t length, WatchpointKind kind);
+
     /**
      * Stops execution in Jit::Run.
      * Can only be called from a callback.
      */
     void HaltExecution();
 
+    /**
+     * Makes Jit::Run return once the block being executed ends, e.g. to deliver an interrupt. Unlike
+     * HaltExecution, can be called at any time from any thread. If Run is not executing, the next call
+     * to Run returns without executing anything.
+     */
+    void SignalInterrupt();
+
+    /**
+     * Clears this Jit's exclusive monitor, as CLREX would, so that the next exclusive write fails unless
+     * preceded by another exclusive read, e.g. when delivering an exception or switching guest threads.
+     * Can be called from a callback.
+     */
+    void ClearExclusiveState();
+
     /// View and modify registers.
     std::array<std::uint32_t, 16>& Regs();
     const std::array<std::uint32_t, 16>& Regs() const;
     std::array<std::uint32_t, 64>& ExtRegs();
     const std::array<std::uint32_t, 64>& ExtRegs() const;
 
-    /// View and modify CPSR.
+    /// View and modify CPSR. Writing the mode bits here does not switch the banked registers; use SetMode.
     std::uint32_t& Cpsr();
     std::uint32_t Cpsr() const;
 
+    /// View and modify the SPSR of the current mode. User and System modes have no SPSR.
+    std::uint32_t& Spsr();
+    std::uint32_t Spsr() const;
+
+    /**
+     * Switches to processor mode `mode` (CPSR.M), saving the banked registers (R13, R14, SPSR, and R8-R12
+     * for FIQ mode) of the current mode and restoring those of the new one.
+     * Cannot be called from a callback.
+     */
+    void SetMode(std::uint32_t mode);
+
+    /**
+     * Enters an exception: switches to `mode` with the current CPSR saved in its SPSR, sets LR to
+     * return_address and continues in ARM state at vector_address with IRQs (and for FIQ mode, FIQs)
+     * disabled. return_address is the value of LR expected by the guest's exception handler,
+     * e.g. the address of the next instruction plus 4 for an IRQ.
+     * Cannot be called from a callback.
+     */
+    void TakeException(std::uint32_t mode, std::uint32_t vector_address, std::uint32_t return_address);
+
     /// View and modify FPSCR.
     std::uint32_t Fpscr() const;
     void SetFpscr(std::uint32_t value) const;
@@ -73,11 +414,89 @@ public:
     }
 
     /**
+     * Cannot be called from a callback.
      * @param descriptor Basic block descriptor.
      * @return A string containing disassembly of the host machine code produced for the basic block.
      */
     std::string Disassemble(const IR::LocationDescriptor& descriptor);
 
+    /**
+     * Writes every block in the code cache to the file at `path` as JSON, for offline analysis, e.g. with an
+     * external disassembler. The file holds an object with an array "blocks", each element of which has:
+     * - "location": the block's location hash, as hexadecimal; "pc" and "thumb": where it starts;
+     * - "tier": "cold" (to be retranslated once hot), "hot" or "counted" (hot, counting for the hot layout),
+     *   and "execution_count" for blocks that count their executions;
+     * - "guest_ranges": the [first, last) ranges of guest code it was translated from;
+     * - "links": the blocks it branches to directly, by "location" and "pc", and whether each is "linked",
+     *   i.e. in the cache; with UserCallbacks::count_exits, also the "count" of times it branched to each;
+     * - with UserCallbacks::count_exits, "exits": the times it was left for each ExitReason, e.g. "rsb_miss";
+     * - "ir": its optimized IR, as dumped by IR::DumpBlock. This is the IR retained for the block (see
+     *   UserCallbacks::ir_cache_capacity) if any, otherwise it is translated again from the current guest code;
+     * - "host_address", "host_size" and "host_code": its emitted code, as hexadecimal bytes. Code placed out
+     *   of line (e.g. slow paths) is not included.
+     * Returns false if the file could not be written.
+     * Cannot be called from a callback.
+     */
+    bool DumpCodeCache(const std::string& path);
+
+    /**
+     * Finds the guest instruction that the emitted code at host_pc (e.g. a sampled instruction pointer)
+     * was translated from. This is only exact with UserCallbacks::guest_pc_map; otherwise the start of
+     * the containing block is found. Cannot be called from a signal handler, as it takes the cache lock.
+     * @return true and sets guest_pc if host_pc is within the emitted code of a block in the cache.
+     */
+    bool HostPcToGuestPc(const void* host_pc, std::uint32_t& guest_pc) const;
+
+    /**
+     * Records a sample of the host PC at which this Jit's thread was interrupted, for sampled tiering
+     * (see UserCallbacks::hot_block_samples). Samples outside emitted code are ignored. Does not block or
+     * allocate, so it can be called from a signal handler, by one thread or handler at a time. Samples are
+     * attributed to blocks in batches between blocks, the oldest being dropped if too many are pending.
+     */
+    void RecordSample(const void* host_pc);
+
+    /**
+     * Returns the current values of this Jit's statistics counters. These are always maintained.
+     * Can be called from a callback, except from callbacks made while translating guest code.
+     */
+    JitStatistics GetStatistics() const;
+
+    /**
+     * Returns an estimate of the memory used by this Jit and its code cache.
+     * Can be called from a callback, except from callbacks made while translating guest code.
+     */
+    JitMemoryUsage GetMemoryUsage() const;
+
+    /**
+     * Returns the memory of the parts of the code cache that hold no live code to the OS. These are
+     * the unused ends of the code cache's regions and regions all of whose blocks have been invalidated,
+     * e.g. by InvalidateCacheRange. Blocks are not moved, so the space taken by invalidated blocks in
+     * regions that are still in use is only reclaimed when those regions are evicted.
+     * Cannot be called from a callback.
+     */
+    void CompactCodeCache();
+
+    /**
+     * Replaces the contents of `records` with the memory accesses recorded since the last call, oldest
+     * first (see UserCallbacks::memory_trace_size). Can be called at any time from any one thread, including
+     * while the Jit is running on another.
+     * @returns The number of records that were overwritten before they could be read.
+     */
+    std::uint64_t ReadMemoryTrace(std::vector<MemoryAccessRecord>& records);
+
+    /**
+     * Returns the functions that calls have returned from since the last ResetCallProfile, by exclusive
+     * cycles, most first (see UserCallbacks::profile_guest_calls). Empty if calls are not profiled.
+     * Can be called from a callback, or while the Jit is not running.
+     */
+    std::vector<GuestFunctionProfile> GetCallProfile() const;
+
+    /**
+     * Discards the profile gathered so far, as well as the calls that have not returned yet.
+     * Can be called from a callback, or while the Jit is not running.
+     */
+    void ResetCallProfile();
+
 private:
     bool is_executing = false;
 
@@ -85,4 +504,77 @@ private:
     std::unique_ptr<Impl> impl;
 };
 
+/**
+ * Runs the Jits in `cores` round-robin on the calling thread, each for about slice_cycles cycles at a
+ * time, until each has been run for cycle_count cycles. A core only starts its slice once the previous
+ * core's slice has ended, so with deterministic callbacks the interleaving of the cores, and hence the
+ * whole run, can be replayed exactly. Smaller slices interleave the cores more finely, at the cost of
+ * leaving emitted code more often. Stops early after the round in which a core's Jit::Run returned
+ * before its slice was up (see Jit::HaltExecution, Jit::SignalInterrupt and Jit::SetCyclesRemaining).
+ * Cannot be called from a callback.
+ * @returns The number of cycles each core was run for, not counting overruns of the final block of a slice.
+ */
+std::size_t RunLockstep(const std::vector<Jit*>& cores, std::size_t cycle_count, std::size_t slice_cycles);
+
+/**
+ * Runs many Jits on a fixed pool of host threads, so that hosting a large number of guests does not need a
+ * thread for each. Each added Jit is run for its quantum of cycles at a time, round-robin with the other Jits
+ * queued on the same worker thread. A worker whose queue is empty steals a Jit from another worker's queue,
+ * and a Jit then stays with the worker that last ran it, to keep its code and CPU state in that core's caches.
+ *
+ * A Jit whose Run returns early, e.g. through Jit::HaltExecution or Jit::SignalInterrupt, is queued again as
+ * if its quantum had ended. To stop running an idle guest, e.g. from UserCallbacks::CallHint on a WFI or WFE,
+ * put its Jit to sleep with Sleep; it is not run again until it is woken with Wake, e.g. when an interrupt
+ * is raised for it. While a Jit is added, it must not be run or modified other than from its own callbacks.
+ */
+class Executor final {
+public:
+    /// @param worker_count The number of worker threads, or 0 for one per hardware thread.
+    explicit Executor(std::size_t worker_count = 0);
+
+    /// Stops the workers once the quanta they are running end. Jits are not run again, and may be destroyed.
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /// The number of worker threads.
+    std::size_t WorkerCount() const;
+
+    /**
+     * Starts running `jit`, for about quantum_cycles cycles at a time. The Jit must not already be added.
+     * Can be called from any thread.
+     */
+    void Add(Jit& jit, std::size_t quantum_cycles);
+
+    /**
+     * Stops running `jit`, waiting for its current quantum to end.
+     * Can be called from any thread, except from the Jit's own callbacks.
+     */
+    void Remove(Jit& jit);
+
+    /**
+     * Stops running `jit` until Wake is called. From one of its callbacks this halts the current Run, as
+     * Jit::HaltExecution would; from another thread its current quantum ends with the block being executed.
+     * Can be called from any thread.
+     */
+    void Sleep(Jit& jit);
+
+    /// Runs `jit` again after Sleep. Has no effect if it is not asleep. Can be called from any thread.
+    void Wake(Jit& jit);
+
+    /// Runs all sleeping Jits again, e.g. for a SEV. Can be called from any thread.
+    void WakeAll();
+
+    /**
+     * Waits until no Jit is running or waiting to run, i.e. until every added Jit is asleep.
+     * Cannot be called from a callback of an added Jit.
+     */
+    void WaitIdle();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
 } // namespace Dynarmic
@@ -127,5 +127,13 @@ void ABI_PopCallerSaveRegistersAndAdjustStack(Xbyak::CodeGenerator* code, size_t
     ABI_PopRegistersAndAdjustStack(code, frame_size, ABI_ALL_CALLER_SAVE);
 }
 
+void ABI_PushRegistersAndAdjustStack(Xbyak::CodeGenerator* code, size_t frame_size, const std::vector<HostLoc>& regs) {
+    ABI_PushRegistersAndAdjustStack<std::vector<HostLoc>>(code, frame_size, regs);
+}
+
+void ABI_PopRegistersAndAdjustStack(Xbyak::CodeGenerator* code, size_t frame_size, const std::vector<HostLoc>& regs) {
+    ABI_PopRegistersAndAdjustStack<std::vector<HostLoc>>(code, frame_size, regs);
+}
+
 } // namespace BackendX64
 } // namespace Dynarmic
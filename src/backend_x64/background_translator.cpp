@@ -0,0 +1,81 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <utility>
+
+#include "backend_x64/background_translator.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+BackgroundTranslator::BackgroundTranslator(TranslateFunc translate)
+        : translate(std::move(translate))
+        , worker([this]{ WorkerMain(); })
+{}
+
+BackgroundTranslator::~BackgroundTranslator() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stop_requested = true;
+    }
+    work_available.notify_one();
+    worker.join();
+}
+
+void BackgroundTranslator::Enqueue(IR::LocationDescriptor descriptor, bool hot) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!pending.insert(descriptor.UniqueHash()).second)
+            return;
+        queue.push_back({descriptor, hot});
+    }
+    work_available.notify_one();
+}
+
+std::vector<BackgroundTranslator::TranslatedBlock> BackgroundTranslator::TakeFinished() {
+    std::vector<TranslatedBlock> result;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    result.swap(finished);
+    for (const TranslatedBlock& translated : result) {
+        pending.erase(translated.block.Location().UniqueHash());
+    }
+
+    return result;
+}
+
+void BackgroundTranslator::Discard() {
+    std::lock_guard<std::mutex> lock{mutex};
+    queue.clear();
+    finished.clear();
+    pending.clear();
+    epoch++;
+}
+
+void BackgroundTranslator::WorkerMain() {
+    std::unique_lock<std::mutex> lock{mutex};
+
+    while (true) {
+        work_available.wait(lock, [this]{ return stop_requested || !queue.empty(); });
+        if (stop_requested)
+            return;
+
+        const Request request = queue.front();
+        queue.pop_front();
+        const size_t request_epoch = epoch;
+
+        lock.unlock();
+        IR::Block block = translate(request.descriptor, request.hot);
+        lock.lock();
+
+        if (request_epoch == epoch) {
+            finished.push_back({std::move(block), request.hot});
+        }
+    }
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -0,0 +1,70 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "common/common_types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/location_descriptor.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+/**
+ * Translates and optimizes blocks on a worker thread.
+ * Emission is left to the emulation thread, since it modifies the code cache and block links.
+ */
+class BackgroundTranslator final {
+public:
+    /// Translates the block at a location, at the hot or cold tier. Called on the worker thread.
+    using TranslateFunc = std::function<IR::Block(IR::LocationDescriptor descriptor, bool hot)>;
+
+    struct TranslatedBlock {
+        IR::Block block;
+        bool hot;
+    };
+
+    explicit BackgroundTranslator(TranslateFunc translate);
+    ~BackgroundTranslator();
+
+    /// Queues the block at `descriptor` for translation, unless it is already pending.
+    void Enqueue(IR::LocationDescriptor descriptor, bool hot);
+    /// Takes all translations that have finished since the last call.
+    std::vector<TranslatedBlock> TakeFinished();
+    /// Drops all queued, in-flight and finished translations. Used when guest code may have changed.
+    void Discard();
+
+private:
+    struct Request {
+        IR::LocationDescriptor descriptor;
+        bool hot;
+    };
+
+    void WorkerMain();
+
+    TranslateFunc translate;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::deque<Request> queue;
+    std::vector<TranslatedBlock> finished;
+    std::unordered_set<u64> pending; ///< UniqueHash of every block that is queued, in-flight or finished
+    size_t epoch = 0;                ///< Incremented on Discard so that in-flight results are dropped
+    bool stop_requested = false;
+
+    std::thread worker;
+};
+
+} // namespace BackendX64
+} // namespace Dynarmic
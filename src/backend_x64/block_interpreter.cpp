@@ -0,0 +1,944 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/variant/get.hpp>
+
+#include "backend_x64/block_interpreter.h"
+#include "common/assert.h"
+#include "common/bit_util.h"
+#include "frontend/arm/types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/location_descriptor.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/semantics.h"
+#include "frontend/ir/terminal.h"
+#include "frontend/ir/value.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+namespace {
+
+/// An index into the values of a running Program. Slot 0 receives results that are never read.
+using Slot = u16;
+constexpr Slot discard_slot = 0;
+
+struct Instruction {
+    IR::Opcode opcode;
+    Slot result = discard_slot;
+    // Receive the results of the GetCarryFromOp, GetOverflowFromOp and GetGEFromOp of this instruction.
+    Slot carry = discard_slot;
+    Slot overflow = discard_slot;
+    Slot ge = discard_slot;
+    std::array<Slot, 4> args{};
+};
+
+} // anonymous namespace
+
+struct BlockInterpreter::Program {
+    explicit Program(const IR::Block& block)
+            : location(block.Location())
+            , cond(block.GetCondition())
+            , cond_failed_location(block.HasConditionFailedLocation() ? block.ConditionFailedLocation() : block.Location())
+            , cond_failed_cycle_count(block.ConditionFailedCycleCount())
+            , cycle_count(block.CycleCount())
+            , terminal(block.GetTerminal())
+    {}
+
+    IR::LocationDescriptor location;
+    Arm::Cond cond;
+    IR::LocationDescriptor cond_failed_location;
+    size_t cond_failed_cycle_count;
+    size_t cycle_count;
+    IR::Terminal terminal;
+
+    std::vector<Instruction> instructions;
+    /// The values of all slots before the block runs: immediate operands, and zero elsewhere.
+    std::vector<u64> initial_values;
+};
+
+static bool IsSupported(IR::Opcode opcode) {
+    switch (opcode) {
+    case IR::Opcode::Breakpoint:
+    case IR::Opcode::SideExit:
+    case IR::Opcode::GetVector:
+    case IR::Opcode::SetVector:
+    case IR::Opcode::GetFpscr:
+    case IR::Opcode::SetFpscr:
+    case IR::Opcode::GetFpscrNZCV:
+    case IR::Opcode::SetFpscrNZCV:
+    case IR::Opcode::VectorAdd8:
+    case IR::Opcode::VectorAdd16:
+    case IR::Opcode::VectorAdd32:
+    case IR::Opcode::VectorAdd64:
+    case IR::Opcode::VectorSub8:
+    case IR::Opcode::VectorSub16:
+    case IR::Opcode::VectorSub32:
+    case IR::Opcode::VectorSub64:
+    case IR::Opcode::VectorMultiply16:
+    case IR::Opcode::VectorMultiply32:
+    case IR::Opcode::VectorAnd:
+    case IR::Opcode::VectorOr:
+    case IR::Opcode::VectorEor:
+    case IR::Opcode::VectorNot:
+    case IR::Opcode::FPAdd32:
+    case IR::Opcode::FPAdd64:
+    case IR::Opcode::FPCompare32:
+    case IR::Opcode::FPCompare64:
+    case IR::Opcode::FPDiv32:
+    case IR::Opcode::FPDiv64:
+    case IR::Opcode::FPMul32:
+    case IR::Opcode::FPMul64:
+    case IR::Opcode::FPMulAdd32:
+    case IR::Opcode::FPMulAdd64:
+    case IR::Opcode::FPSqrt32:
+    case IR::Opcode::FPSqrt64:
+    case IR::Opcode::FPSub32:
+    case IR::Opcode::FPSub64:
+    case IR::Opcode::FPSingleToDouble:
+    case IR::Opcode::FPDoubleToSingle:
+    case IR::Opcode::FPSingleToU32:
+    case IR::Opcode::FPSingleToS32:
+    case IR::Opcode::FPDoubleToU32:
+    case IR::Opcode::FPDoubleToS32:
+    case IR::Opcode::FPU32ToSingle:
+    case IR::Opcode::FPS32ToSingle:
+    case IR::Opcode::FPU32ToDouble:
+    case IR::Opcode::FPS32ToDouble:
+    case IR::Opcode::ReadMemory128:
+    case IR::Opcode::WriteMemory128:
+    case IR::Opcode::ClearExclusive:
+    case IR::Opcode::SetExclusive:
+    case IR::Opcode::ExclusiveReadMemory8:
+    case IR::Opcode::ExclusiveReadMemory16:
+    case IR::Opcode::ExclusiveReadMemory32:
+    case IR::Opcode::ExclusiveReadMemory64:
+    case IR::Opcode::ExclusiveWriteMemory8:
+    case IR::Opcode::ExclusiveWriteMemory16:
+    case IR::Opcode::ExclusiveWriteMemory32:
+    case IR::Opcode::ExclusiveWriteMemory64:
+    case IR::Opcode::CoprocInternalOperation:
+    case IR::Opcode::CoprocSendOneWord:
+    case IR::Opcode::CoprocSendTwoWords:
+    case IR::Opcode::CoprocGetOneWord:
+    case IR::Opcode::CoprocGetTwoWords:
+    case IR::Opcode::CoprocLoadWords:
+    case IR::Opcode::CoprocStoreWords:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/// Follows Identity instructions to the value they forward.
+static IR::Value Resolve(IR::Value value) {
+    while (!value.IsImmediate() && value.GetInst()->GetOpcode() == IR::Opcode::Identity) {
+        value = value.GetInst()->GetArg(0);
+    }
+    return value;
+}
+
+static u64 GetImmediateBits(const IR::Value& value) {
+    switch (value.GetType()) {
+    case IR::Type::RegRef:
+        return static_cast<u64>(value.GetRegRef());
+    case IR::Type::ExtRegRef:
+        return static_cast<u64>(value.GetExtRegRef());
+    case IR::Type::U1:
+        return value.GetU1() ? 1 : 0;
+    case IR::Type::U8:
+        return value.GetU8();
+    case IR::Type::U16:
+        return value.GetU16();
+    case IR::Type::U32:
+        return value.GetU32();
+    case IR::Type::U64:
+        return value.GetU64();
+    default:
+        ASSERT_MSG(false, "Unsupported immediate type");
+        return 0;
+    }
+}
+
+std::shared_ptr<const BlockInterpreter::Program> BlockInterpreter::Compile(const IR::Block& block) {
+    // Only emitted code stops at breakpoints.
+    if (block.HasBreakpoint())
+        return nullptr;
+    for (const auto& inst : block) {
+        if (!IsSupported(inst.GetOpcode()))
+            return nullptr;
+    }
+    if (block.size() >= std::numeric_limits<Slot>::max() / (1 + 4))
+        return nullptr;
+
+    auto program = std::make_shared<Program>(block);
+    program->initial_values.push_back(0); // discard_slot
+
+    std::unordered_map<const IR::Inst*, Slot> result_slots;
+    std::unordered_map<const IR::Inst*, size_t> instruction_indices;
+    const auto new_slot = [&program](u64 initial_value) {
+        program->initial_values.push_back(initial_value);
+        return static_cast<Slot>(program->initial_values.size() - 1);
+    };
+
+    for (const auto& inst : block) {
+        const IR::Opcode opcode = inst.GetOpcode();
+        if (opcode == IR::Opcode::Identity)
+            continue;
+
+        if (opcode == IR::Opcode::GetCarryFromOp || opcode == IR::Opcode::GetOverflowFromOp || opcode == IR::Opcode::GetGEFromOp) {
+            // The instruction this reads from writes the result into its slot as a side effect.
+            const IR::Value source = Resolve(inst.GetArg(0));
+            ASSERT(!source.IsImmediate());
+            Instruction& source_instruction = program->instructions[instruction_indices.at(source.GetInst())];
+            const Slot slot = new_slot(0);
+            switch (opcode) {
+            case IR::Opcode::GetCarryFromOp:
+                source_instruction.carry = slot;
+                break;
+            case IR::Opcode::GetOverflowFromOp:
+                source_instruction.overflow = slot;
+                break;
+            default:
+                source_instruction.ge = slot;
+                break;
+            }
+            result_slots[&inst] = slot;
+            continue;
+        }
+
+        Instruction instruction;
+        instruction.opcode = opcode;
+        for (size_t i = 0; i < inst.NumArgs(); i++) {
+            const IR::Value arg = Resolve(inst.GetArg(i));
+            instruction.args[i] = arg.IsImmediate() ? new_slot(GetImmediateBits(arg)) : result_slots.at(arg.GetInst());
+        }
+        if (IR::GetTypeOf(opcode) != IR::Type::Void) {
+            instruction.result = new_slot(0);
+            result_slots[&inst] = instruction.result;
+        }
+
+        instruction_indices[&inst] = program->instructions.size();
+        program->instructions.push_back(instruction);
+    }
+
+    return program;
+}
+
+BlockInterpreter::BlockInterpreter(const UserCallbacks& callbacks, CodePtr dispatcher) : callbacks(callbacks), dispatcher(dispatcher) {}
+
+namespace {
+
+constexpr u32 N_bit = 1u << 31;
+constexpr u32 Z_bit = 1u << 30;
+constexpr u32 C_bit = 1u << 29;
+constexpr u32 V_bit = 1u << 28;
+constexpr u32 Q_bit = 1u << 27;
+constexpr u32 GE_mask = 0xFu << 16;
+constexpr u32 T_bit = 1u << 5;
+constexpr u32 E_bit = 1u << 9;
+constexpr u32 IT_mask = 0x0600FC00;
+
+bool ConditionPasses(Arm::Cond cond, u32 cpsr) {
+    const bool n = (cpsr & N_bit) != 0;
+    const bool z = (cpsr & Z_bit) != 0;
+    const bool c = (cpsr & C_bit) != 0;
+    const bool v = (cpsr & V_bit) != 0;
+
+    switch (cond) {
+    case Arm::Cond::EQ: return z;
+    case Arm::Cond::NE: return !z;
+    case Arm::Cond::CS: return c;
+    case Arm::Cond::CC: return !c;
+    case Arm::Cond::MI: return n;
+    case Arm::Cond::PL: return !n;
+    case Arm::Cond::VS: return v;
+    case Arm::Cond::VC: return !v;
+    case Arm::Cond::HI: return c && !z;
+    case Arm::Cond::LS: return !c || z;
+    case Arm::Cond::GE: return n == v;
+    case Arm::Cond::LT: return n != v;
+    case Arm::Cond::GT: return !z && n == v;
+    case Arm::Cond::LE: return z || n != v;
+    case Arm::Cond::AL:
+    case Arm::Cond::NV:
+        return true;
+    }
+    ASSERT_MSG(false, "Unknown cond %zu", static_cast<size_t>(cond));
+    return false;
+}
+
+void SetCpsrBit(JitState& jit_state, u32 bit, bool value) {
+    jit_state.Cpsr = value ? jit_state.Cpsr | bit : jit_state.Cpsr & ~bit;
+}
+
+/// Updates the CPSR T, E and IT bits to those of `next`, as the emitted LinkBlock terminals do.
+void SetLocationFlags(JitState& jit_state, IR::LocationDescriptor next) {
+    SetCpsrBit(jit_state, T_bit, next.TFlag());
+    SetCpsrBit(jit_state, E_bit, next.EFlag());
+
+    Arm::PSR it_bits;
+    it_bits.IT(next.IT().Value());
+    jit_state.Cpsr = (jit_state.Cpsr & ~IT_mask) | it_bits.Value();
+}
+
+void ClearITState(JitState& jit_state) {
+    jit_state.Cpsr &= ~IT_mask;
+}
+
+using namespace IR::Semantics;
+
+/// Runs the instructions of one Program, holding the values of its slots.
+class Machine final {
+public:
+    Machine(const UserCallbacks& callbacks, JitState& jit_state, std::vector<u64>& values)
+        : callbacks(callbacks), jit_state(jit_state), values(values) {}
+
+    void Execute(const Instruction& inst);
+
+private:
+    const UserCallbacks& callbacks;
+    JitState& jit_state;
+    std::vector<u64>& values;
+
+    u64 Arg(const Instruction& inst, size_t i) const {
+        return values[inst.args[i]];
+    }
+    u32 Arg32(const Instruction& inst, size_t i) const {
+        return static_cast<u32>(values[inst.args[i]]);
+    }
+    bool Arg1(const Instruction& inst, size_t i) const {
+        return values[inst.args[i]] != 0;
+    }
+
+    void SetResult(const Instruction& inst, u64 value) {
+        values[inst.result] = value;
+    }
+    void SetResultAndCarry(const Instruction& inst, ResultAndCarry result) {
+        values[inst.result] = result.result;
+        values[inst.carry] = result.carry ? 1 : 0;
+    }
+    void SetPackedResult(const Instruction& inst, PackedResult packed) {
+        values[inst.result] = packed.result;
+        values[inst.ge] = packed.ge;
+    }
+    void SetAddWithCarry(const Instruction& inst, u32 a, u32 b, bool carry_in) {
+        const u64 sum = u64(a) + u64(b) + (carry_in ? 1 : 0);
+        const u32 result = static_cast<u32>(sum);
+        values[inst.result] = result;
+        values[inst.carry] = sum >> 32;
+        values[inst.overflow] = Common::Bit<31>(~(a ^ b) & (a ^ result)) ? 1 : 0;
+    }
+    void SetSaturated(const Instruction& inst, s64 value, s64 min, s64 max) {
+        const s64 result = std::max(min, std::min(value, max));
+        values[inst.result] = static_cast<u32>(result);
+        values[inst.overflow] = result != value ? 1 : 0;
+    }
+
+    /// The device at vaddr, if any (see UserCallbacks::mmio_pages).
+    const MmioHandler* GetMmioHandler(u32 vaddr) const {
+        return callbacks.mmio_pages ? (*callbacks.mmio_pages)[vaddr >> UserCallbacks::PAGE_BITS] : nullptr;
+    }
+    /// Calls UserCallbacks::WatchpointHit if accesses of `kind` are watched on either page touched by the access
+    /// of `size` bytes at vaddr.
+    void ReportWatchpoint(u32 vaddr, size_t size, WatchpointKind kind) const {
+        const u8* watched_pages = jit_state.watched_pages;
+        if (!watched_pages)
+            return;
+        const u8 first = watched_pages[vaddr >> UserCallbacks::PAGE_BITS];
+        const u8 last = watched_pages[static_cast<u32>(vaddr + size - 1) >> UserCallbacks::PAGE_BITS];
+        if ((first | last) & static_cast<u8>(kind))
+            callbacks.WatchpointHit(vaddr, kind == WatchpointKind::Write, jit_state.jit_interface, jit_state.user_arg);
+    }
+    template <typename T>
+    T ReadMemory(u32 vaddr, T (*fn)(u32), T (*fn_with_user_arg)(void*, u32), T (*MmioHandler::*mmio_fn)(void*, u32)) const {
+        ReportWatchpoint(vaddr, sizeof(T), WatchpointKind::Read);
+        const MmioHandler* mmio = GetMmioHandler(vaddr);
+        if (mmio && mmio->*mmio_fn)
+            return (mmio->*mmio_fn)(mmio->device, vaddr);
+        return fn_with_user_arg ? fn_with_user_arg(jit_state.user_arg, vaddr) : fn(vaddr);
+    }
+    template <typename T>
+    void WriteMemory(u32 vaddr, T value, void (*fn)(u32, T), void (*fn_with_user_arg)(void*, u32, T), void (*MmioHandler::*mmio_fn)(void*, u32, T)) const {
+        jit_state.RecordCodeWrite(vaddr, sizeof(T));
+        ReportWatchpoint(vaddr, sizeof(T), WatchpointKind::Write);
+        const MmioHandler* mmio = GetMmioHandler(vaddr);
+        if (mmio && mmio->*mmio_fn) {
+            (mmio->*mmio_fn)(mmio->device, vaddr, value);
+        } else if (fn_with_user_arg) {
+            fn_with_user_arg(jit_state.user_arg, vaddr, value);
+        } else {
+            fn(vaddr, value);
+        }
+    }
+    u32 Read32(u32 vaddr) const {
+        return ReadMemory(vaddr, callbacks.memory.Read32, callbacks.memory_with_user_arg.Read32, &MmioHandler::Read32);
+    }
+    void Write32(u32 vaddr, u32 value) const {
+        WriteMemory(vaddr, value, callbacks.memory.Write32, callbacks.memory_with_user_arg.Write32, &MmioHandler::Write32);
+    }
+
+    /// The words of the ExtReg array transferred by a ReadMemoryToExtRegisters or WriteMemoryFromExtRegisters.
+    std::pair<size_t, size_t> ExtRegisterWords(const Instruction& inst) const {
+        const auto first = static_cast<Arm::ExtReg>(Arg(inst, 1));
+        const size_t words_per_reg = Arm::IsSingleExtReg(first) ? 1 : 2;
+        return {Arm::RegNumber(first) * words_per_reg, Arg(inst, 2) * words_per_reg};
+    }
+
+    u64 GetExtReg64(Arm::ExtReg reg) const {
+        const size_t index = Arm::RegNumber(reg) * 2;
+        return u64(jit_state.ExtReg[index]) | (u64(jit_state.ExtReg[index + 1]) << 32);
+    }
+    void SetExtReg64(Arm::ExtReg reg, u64 value) {
+        const size_t index = Arm::RegNumber(reg) * 2;
+        jit_state.ExtReg[index] = static_cast<u32>(value);
+        jit_state.ExtReg[index + 1] = static_cast<u32>(value >> 32);
+    }
+};
+
+void Machine::Execute(const Instruction& inst) {
+    switch (inst.opcode) {
+    case IR::Opcode::GetRegister:
+        SetResult(inst, jit_state.Reg[Arg(inst, 0)]);
+        break;
+    case IR::Opcode::SetRegister:
+        jit_state.Reg[Arg(inst, 0)] = Arg32(inst, 1);
+        break;
+    case IR::Opcode::GetExtendedRegister32:
+        SetResult(inst, jit_state.ExtReg[Arm::RegNumber(static_cast<Arm::ExtReg>(Arg(inst, 0)))]);
+        break;
+    case IR::Opcode::GetExtendedRegister64:
+        SetResult(inst, GetExtReg64(static_cast<Arm::ExtReg>(Arg(inst, 0))));
+        break;
+    case IR::Opcode::SetExtendedRegister32:
+        jit_state.ExtReg[Arm::RegNumber(static_cast<Arm::ExtReg>(Arg(inst, 0)))] = Arg32(inst, 1);
+        break;
+    case IR::Opcode::SetExtendedRegister64:
+        SetExtReg64(static_cast<Arm::ExtReg>(Arg(inst, 0)), Arg(inst, 1));
+        break;
+    case IR::Opcode::GetCpsr:
+        SetResult(inst, jit_state.Cpsr);
+        break;
+    case IR::Opcode::SetCpsr:
+        jit_state.Cpsr = Arg32(inst, 0);
+        break;
+    case IR::Opcode::SetCpsrAndSwitchMode:
+        jit_state.SetCpsrAndSwitchMode(Arg32(inst, 0));
+        break;
+    case IR::Opcode::GetSpsr:
+        SetResult(inst, jit_state.Spsr);
+        break;
+    case IR::Opcode::SetSpsr:
+        jit_state.Spsr = Arg32(inst, 0);
+        break;
+    case IR::Opcode::GetNFlag:
+        SetResult(inst, Common::Bit<31>(jit_state.Cpsr));
+        break;
+    case IR::Opcode::SetNFlag:
+        SetCpsrBit(jit_state, N_bit, Arg1(inst, 0));
+        break;
+    case IR::Opcode::GetZFlag:
+        SetResult(inst, Common::Bit<30>(jit_state.Cpsr));
+        break;
+    case IR::Opcode::SetZFlag:
+        SetCpsrBit(jit_state, Z_bit, Arg1(inst, 0));
+        break;
+    case IR::Opcode::GetCFlag:
+        SetResult(inst, Common::Bit<29>(jit_state.Cpsr));
+        break;
+    case IR::Opcode::SetCFlag:
+        SetCpsrBit(jit_state, C_bit, Arg1(inst, 0));
+        break;
+    case IR::Opcode::GetVFlag:
+        SetResult(inst, Common::Bit<28>(jit_state.Cpsr));
+        break;
+    case IR::Opcode::SetVFlag:
+        SetCpsrBit(jit_state, V_bit, Arg1(inst, 0));
+        break;
+    case IR::Opcode::SetNZCVFlags:
+    case IR::Opcode::SetNZCVFlagsAtExit:
+        SetCpsrBit(jit_state, V_bit, Arg1(inst, 3));
+        // [[fallthrough]]
+    case IR::Opcode::SetNZCFlags:
+        SetCpsrBit(jit_state, C_bit, Arg1(inst, 2));
+        // [[fallthrough]]
+    case IR::Opcode::SetNZFlags:
+        SetCpsrBit(jit_state, Z_bit, Arg1(inst, 1));
+        SetCpsrBit(jit_state, N_bit, Arg1(inst, 0));
+        break;
+    case IR::Opcode::OrQFlag:
+        if (Arg1(inst, 0))
+            jit_state.Cpsr |= Q_bit;
+        break;
+    case IR::Opcode::GetGEFlags:
+        SetResult(inst, (jit_state.Cpsr & GE_mask) >> 16);
+        break;
+    case IR::Opcode::SetGEFlags:
+        jit_state.Cpsr = (jit_state.Cpsr & ~GE_mask) | ((Arg32(inst, 0) << 16) & GE_mask);
+        break;
+    case IR::Opcode::TestCondition:
+        SetResult(inst, ConditionPasses(static_cast<Arm::Cond>(Arg(inst, 0)), jit_state.Cpsr));
+        break;
+    case IR::Opcode::BXWritePC: {
+        const u32 new_pc = Arg32(inst, 0);
+        const bool thumb = Common::Bit<0>(new_pc);
+        SetCpsrBit(jit_state, T_bit, thumb);
+        jit_state.Reg[15] = new_pc & (thumb ? 0xFFFFFFFE : 0xFFFFFFFC);
+        break;
+    }
+    case IR::Opcode::CallSupervisor: {
+        const u32 imm32 = Arg32(inst, 0);
+        void (*handler)(u32) = callbacks.CallSVC;
+        if (callbacks.svc_handlers && imm32 < UserCallbacks::NUM_SVC_HANDLERS && (*callbacks.svc_handlers)[imm32])
+            handler = (*callbacks.svc_handlers)[imm32];
+        handler(imm32);
+        break;
+    }
+    case IR::Opcode::CallHostFunction:
+        reinterpret_cast<HostFunction>(Arg(inst, 0))(jit_state.jit_interface, jit_state.user_arg);
+        break;
+    case IR::Opcode::SkipSpinLoop:
+        if (Arg(inst, 0)) {
+            jit_state.cycles_remaining = 0;
+            jit_state.spin_loops_skipped++;
+        }
+        break;
+    case IR::Opcode::GetCycleCounter:
+        SetResult(inst, static_cast<u32>(jit_state.cycle_counter_base - static_cast<u64>(jit_state.cycles_remaining) + Arg32(inst, 0)));
+        break;
+    case IR::Opcode::TraceMemoryAccess:
+        jit_state.TraceMemoryAccess(Arg32(inst, 1), Arg32(inst, 0), static_cast<u8>(Arg(inst, 2)), Arg(inst, 3) != 0);
+        break;
+    case IR::Opcode::CallHint:
+        callbacks.CallHint(static_cast<Hint>(Arg(inst, 0)), jit_state.jit_interface, jit_state.user_arg);
+        break;
+    case IR::Opcode::PushRSB:
+        // Handled by BlockInterpreter::Run, which knows the dispatcher address.
+        ASSERT_MSG(false, "PushRSB is executed by BlockInterpreter::Run");
+        break;
+    case IR::Opcode::ProfileCall:
+        jit_state.ProfileCall(Arg32(inst, 0), Arg32(inst, 1), Arg32(inst, 2));
+        break;
+    case IR::Opcode::ProfileReturn:
+        jit_state.ProfileReturn(Arg32(inst, 0), Arg32(inst, 1));
+        break;
+    case IR::Opcode::Pack2x32To1x64:
+        SetResult(inst, (Arg(inst, 1) << 32) | Arg32(inst, 0));
+        break;
+    case IR::Opcode::LeastSignificantWord:
+        SetResult(inst, Arg32(inst, 0));
+        break;
+    case IR::Opcode::MostSignificantWord:
+        SetResultAndCarry(inst, {static_cast<u32>(Arg(inst, 0) >> 32), Common::Bit<31>(Arg(inst, 0))});
+        break;
+    case IR::Opcode::LeastSignificantHalf:
+        SetResult(inst, static_cast<u16>(Arg(inst, 0)));
+        break;
+    case IR::Opcode::LeastSignificantByte:
+        SetResult(inst, static_cast<u8>(Arg(inst, 0)));
+        break;
+    case IR::Opcode::MostSignificantBit:
+        SetResult(inst, Common::Bit<31>(Arg32(inst, 0)));
+        break;
+    case IR::Opcode::IsZero:
+        SetResult(inst, Arg32(inst, 0) == 0);
+        break;
+    case IR::Opcode::IsZero64:
+        SetResult(inst, Arg(inst, 0) == 0);
+        break;
+    case IR::Opcode::ConditionalSelect32:
+    case IR::Opcode::ConditionalSelect1:
+        SetResult(inst, Arg1(inst, 0) ? Arg(inst, 1) : Arg(inst, 2));
+        break;
+    case IR::Opcode::LogicalShiftLeft:
+        SetResultAndCarry(inst, LogicalShiftLeft(Arg32(inst, 0), static_cast<u8>(Arg(inst, 1)), Arg1(inst, 2)));
+        break;
+    case IR::Opcode::LogicalShiftRight:
+        SetResultAndCarry(inst, LogicalShiftRight(Arg32(inst, 0), static_cast<u8>(Arg(inst, 1)), Arg1(inst, 2)));
+        break;
+    case IR::Opcode::LogicalShiftRight64:
+        SetResult(inst, Arg(inst, 1) < 64 ? Arg(inst, 0) >> Arg(inst, 1) : 0);
+        break;
+    case IR::Opcode::ArithmeticShiftRight:
+        SetResultAndCarry(inst, ArithmeticShiftRight(Arg32(inst, 0), static_cast<u8>(Arg(inst, 1)), Arg1(inst, 2)));
+        break;
+    case IR::Opcode::RotateRight:
+        SetResultAndCarry(inst, RotateRight(Arg32(inst, 0), static_cast<u8>(Arg(inst, 1)), Arg1(inst, 2)));
+        break;
+    case IR::Opcode::RotateRightExtended: {
+        SetResultAndCarry(inst, RotateRightExtended(Arg32(inst, 0), Arg1(inst, 1)));
+        break;
+    }
+    case IR::Opcode::AddWithCarry:
+        SetAddWithCarry(inst, Arg32(inst, 0), Arg32(inst, 1), Arg1(inst, 2));
+        break;
+    case IR::Opcode::SubWithCarry:
+        SetAddWithCarry(inst, Arg32(inst, 0), ~Arg32(inst, 1), Arg1(inst, 2));
+        break;
+    case IR::Opcode::Add64:
+        SetResult(inst, Arg(inst, 0) + Arg(inst, 1));
+        break;
+    case IR::Opcode::Sub64:
+        SetResult(inst, Arg(inst, 0) - Arg(inst, 1));
+        break;
+    case IR::Opcode::Mul:
+        SetResult(inst, Arg32(inst, 0) * Arg32(inst, 1));
+        break;
+    case IR::Opcode::Mul64:
+        SetResult(inst, Arg(inst, 0) * Arg(inst, 1));
+        break;
+    case IR::Opcode::SignedDiv:
+        SetResult(inst, SignedDivide(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::UnsignedDiv:
+        SetResult(inst, Arg32(inst, 1) == 0 ? 0 : Arg32(inst, 0) / Arg32(inst, 1));
+        break;
+    case IR::Opcode::And:
+        SetResult(inst, Arg32(inst, 0) & Arg32(inst, 1));
+        break;
+    case IR::Opcode::AndNot:
+        SetResult(inst, Arg32(inst, 0) & ~Arg32(inst, 1));
+        break;
+    case IR::Opcode::Eor:
+        SetResult(inst, Arg32(inst, 0) ^ Arg32(inst, 1));
+        break;
+    case IR::Opcode::Or:
+        SetResult(inst, Arg32(inst, 0) | Arg32(inst, 1));
+        break;
+    case IR::Opcode::Not:
+        SetResult(inst, ~Arg32(inst, 0));
+        break;
+    case IR::Opcode::SignExtendWordToLong:
+        SetResult(inst, static_cast<u64>(static_cast<s64>(static_cast<s32>(Arg32(inst, 0)))));
+        break;
+    case IR::Opcode::SignExtendHalfToWord:
+        SetResult(inst, static_cast<u32>(static_cast<s32>(static_cast<s16>(Arg(inst, 0)))));
+        break;
+    case IR::Opcode::SignExtendByteToWord:
+        SetResult(inst, static_cast<u32>(static_cast<s32>(static_cast<s8>(Arg(inst, 0)))));
+        break;
+    case IR::Opcode::ZeroExtendWordToLong:
+        SetResult(inst, Arg32(inst, 0));
+        break;
+    case IR::Opcode::ZeroExtendHalfToWord:
+        SetResult(inst, static_cast<u16>(Arg(inst, 0)));
+        break;
+    case IR::Opcode::ZeroExtendByteToWord:
+        SetResult(inst, static_cast<u8>(Arg(inst, 0)));
+        break;
+    case IR::Opcode::ByteReverseWord:
+        SetResult(inst, ByteReverse(Arg32(inst, 0)));
+        break;
+    case IR::Opcode::ByteReverseHalf: {
+        const u16 half = static_cast<u16>(Arg(inst, 0));
+        SetResult(inst, static_cast<u16>((half >> 8) | (half << 8)));
+        break;
+    }
+    case IR::Opcode::ByteReverseDual: {
+        const u64 value = Arg(inst, 0);
+        SetResult(inst, (u64(ByteReverse(static_cast<u32>(value))) << 32) | ByteReverse(static_cast<u32>(value >> 32)));
+        break;
+    }
+    case IR::Opcode::BitReverseWord:
+        SetResult(inst, BitReverse(Arg32(inst, 0)));
+        break;
+    case IR::Opcode::CountLeadingZeros: {
+        const u32 value = Arg32(inst, 0);
+        u32 count = 0;
+        while (count < 32 && !Common::Bit(31 - count, value)) {
+            count++;
+        }
+        SetResult(inst, count);
+        break;
+    }
+    case IR::Opcode::SignedSaturatedAdd:
+        SetSaturated(inst, s64(static_cast<s32>(Arg32(inst, 0))) + static_cast<s32>(Arg32(inst, 1)), std::numeric_limits<s32>::min(), std::numeric_limits<s32>::max());
+        break;
+    case IR::Opcode::SignedSaturatedSub:
+        SetSaturated(inst, s64(static_cast<s32>(Arg32(inst, 0))) - static_cast<s32>(Arg32(inst, 1)), std::numeric_limits<s32>::min(), std::numeric_limits<s32>::max());
+        break;
+    case IR::Opcode::UnsignedSaturation: {
+        const size_t n = static_cast<size_t>(Arg(inst, 1));
+        SetSaturated(inst, static_cast<s32>(Arg32(inst, 0)), 0, (s64(1) << n) - 1);
+        break;
+    }
+    case IR::Opcode::SignedSaturation: {
+        const size_t n = static_cast<size_t>(Arg(inst, 1));
+        SetSaturated(inst, static_cast<s32>(Arg32(inst, 0)), -(s64(1) << (n - 1)), (s64(1) << (n - 1)) - 1);
+        break;
+    }
+    case IR::Opcode::PackedAddU8:
+        SetPackedResult(inst, PackedAdd<8, false>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedAddS8:
+        SetPackedResult(inst, PackedAdd<8, true>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedSubU8:
+        SetPackedResult(inst, PackedSub<8, false>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedSubS8:
+        SetPackedResult(inst, PackedSub<8, true>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedAddU16:
+        SetPackedResult(inst, PackedAdd<16, false>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedAddS16:
+        SetPackedResult(inst, PackedAdd<16, true>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedSubU16:
+        SetPackedResult(inst, PackedSub<16, false>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedSubS16:
+        SetPackedResult(inst, PackedSub<16, true>(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::PackedSubAddU16:
+        SetPackedResult(inst, PackedSubAdd16<false>(Arg32(inst, 0), Arg32(inst, 1), Arg1(inst, 2), false));
+        break;
+    case IR::Opcode::PackedSubAddS16:
+        SetPackedResult(inst, PackedSubAdd16<true>(Arg32(inst, 0), Arg32(inst, 1), Arg1(inst, 2), false));
+        break;
+    case IR::Opcode::PackedHalvingAddU8:
+        SetResult(inst, PackedHalving<8, false>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedHalvingAddS8:
+        SetResult(inst, PackedHalving<8, true>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedHalvingSubU8:
+        SetResult(inst, PackedHalving<8, false>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedHalvingSubS8:
+        SetResult(inst, PackedHalving<8, true>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedHalvingAddU16:
+        SetResult(inst, PackedHalving<16, false>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedHalvingAddS16:
+        SetResult(inst, PackedHalving<16, true>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedHalvingSubU16:
+        SetResult(inst, PackedHalving<16, false>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedHalvingSubS16:
+        SetResult(inst, PackedHalving<16, true>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedHalvingSubAddU16:
+        SetResult(inst, PackedSubAdd16<false>(Arg32(inst, 0), Arg32(inst, 1), Arg1(inst, 2), true).result);
+        break;
+    case IR::Opcode::PackedHalvingSubAddS16:
+        SetResult(inst, PackedSubAdd16<true>(Arg32(inst, 0), Arg32(inst, 1), Arg1(inst, 2), true).result);
+        break;
+    case IR::Opcode::PackedSaturatedAddU8:
+        SetResult(inst, PackedSaturated<8, false>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedSaturatedAddS8:
+        SetResult(inst, PackedSaturated<8, true>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedSaturatedSubU8:
+        SetResult(inst, PackedSaturated<8, false>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedSaturatedSubS8:
+        SetResult(inst, PackedSaturated<8, true>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedSaturatedAddU16:
+        SetResult(inst, PackedSaturated<16, false>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedSaturatedAddS16:
+        SetResult(inst, PackedSaturated<16, true>(Arg32(inst, 0), Arg32(inst, 1), false));
+        break;
+    case IR::Opcode::PackedSaturatedSubU16:
+        SetResult(inst, PackedSaturated<16, false>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedSaturatedSubS16:
+        SetResult(inst, PackedSaturated<16, true>(Arg32(inst, 0), Arg32(inst, 1), true));
+        break;
+    case IR::Opcode::PackedAbsDiffSumS8:
+        SetResult(inst, PackedAbsDiffSum8(Arg32(inst, 0), Arg32(inst, 1)));
+        break;
+    case IR::Opcode::TransferToFP32:
+    case IR::Opcode::TransferToFP64:
+    case IR::Opcode::TransferFromFP32:
+    case IR::Opcode::TransferFromFP64:
+        // Floating point values are held as their bit patterns.
+        SetResult(inst, Arg(inst, 0));
+        break;
+    case IR::Opcode::FPPack2x32To1x64:
+        SetResult(inst, (u64(Arg32(inst, 1)) << 32) | Arg32(inst, 0));
+        break;
+    case IR::Opcode::FPLeastSignificantWord:
+        SetResult(inst, static_cast<u32>(Arg(inst, 0)));
+        break;
+    case IR::Opcode::FPMostSignificantWord:
+        SetResult(inst, static_cast<u32>(Arg(inst, 0) >> 32));
+        break;
+    case IR::Opcode::FPAbs32:
+        SetResult(inst, Arg32(inst, 0) & 0x7FFFFFFF);
+        break;
+    case IR::Opcode::FPAbs64:
+        SetResult(inst, Arg(inst, 0) & 0x7FFFFFFFFFFFFFFF);
+        break;
+    case IR::Opcode::FPNeg32:
+        SetResult(inst, Arg32(inst, 0) ^ 0x80000000);
+        break;
+    case IR::Opcode::FPNeg64:
+        SetResult(inst, Arg(inst, 0) ^ 0x8000000000000000);
+        break;
+    case IR::Opcode::DataMemoryBarrier:
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        break;
+    case IR::Opcode::ReadMemory8:
+        SetResult(inst, ReadMemory(Arg32(inst, 0), callbacks.memory.Read8, callbacks.memory_with_user_arg.Read8, &MmioHandler::Read8));
+        break;
+    case IR::Opcode::ReadMemory16:
+        SetResult(inst, ReadMemory(Arg32(inst, 0), callbacks.memory.Read16, callbacks.memory_with_user_arg.Read16, &MmioHandler::Read16));
+        break;
+    case IR::Opcode::ReadMemory32:
+        SetResult(inst, Read32(Arg32(inst, 0)));
+        break;
+    case IR::Opcode::ReadMemory64:
+        SetResult(inst, ReadMemory(Arg32(inst, 0), callbacks.memory.Read64, callbacks.memory_with_user_arg.Read64, &MmioHandler::Read64));
+        break;
+    case IR::Opcode::WriteMemory8:
+        WriteMemory(Arg32(inst, 0), static_cast<u8>(Arg(inst, 1)), callbacks.memory.Write8, callbacks.memory_with_user_arg.Write8, &MmioHandler::Write8);
+        break;
+    case IR::Opcode::WriteMemory16:
+        WriteMemory(Arg32(inst, 0), static_cast<u16>(Arg(inst, 1)), callbacks.memory.Write16, callbacks.memory_with_user_arg.Write16, &MmioHandler::Write16);
+        break;
+    case IR::Opcode::WriteMemory32:
+        Write32(Arg32(inst, 0), Arg32(inst, 1));
+        break;
+    case IR::Opcode::WriteMemory64:
+        WriteMemory(Arg32(inst, 0), Arg(inst, 1), callbacks.memory.Write64, callbacks.memory_with_user_arg.Write64, &MmioHandler::Write64);
+        break;
+    case IR::Opcode::ReadMemoryToRegisters: {
+        u32 vaddr = Arg32(inst, 0);
+        const u32 list = Arg32(inst, 1);
+        for (size_t i = 0; i <= 14; i++) {
+            if (Common::Bit(i, list)) {
+                jit_state.Reg[i] = Read32(vaddr);
+                vaddr += 4;
+            }
+        }
+        break;
+    }
+    case IR::Opcode::WriteMemoryFromRegisters: {
+        u32 vaddr = Arg32(inst, 0);
+        const u32 list = Arg32(inst, 1);
+        for (size_t i = 0; i <= 14; i++) {
+            if (Common::Bit(i, list)) {
+                Write32(vaddr, jit_state.Reg[i]);
+                vaddr += 4;
+            }
+        }
+        break;
+    }
+    case IR::Opcode::ReadMemoryToExtRegisters: {
+        const auto words = ExtRegisterWords(inst);
+        for (size_t i = 0; i < words.second; i++) {
+            jit_state.ExtReg[words.first + i] = Read32(Arg32(inst, 0) + static_cast<u32>(i * 4));
+        }
+        break;
+    }
+    case IR::Opcode::WriteMemoryFromExtRegisters: {
+        const auto words = ExtRegisterWords(inst);
+        for (size_t i = 0; i < words.second; i++) {
+            Write32(Arg32(inst, 0) + static_cast<u32>(i * 4), jit_state.ExtReg[words.first + i]);
+        }
+        break;
+    }
+    default:
+        ASSERT_MSG(false, "Cannot interpret %s", IR::GetNameOf(inst.opcode));
+        break;
+    }
+}
+
+} // anonymous namespace
+
+size_t BlockInterpreter::Run(const Program& program, JitState& jit_state) const {
+    const auto link_to = [&jit_state](IR::LocationDescriptor next) {
+        SetLocationFlags(jit_state, next);
+        jit_state.Reg[15] = next.PC();
+    };
+
+    if (!ConditionPasses(program.cond, jit_state.Cpsr)) {
+        link_to(program.cond_failed_location);
+        return program.cond_failed_cycle_count;
+    }
+
+    // Blocks may be interpreted by several threads at once, and callbacks may run Jits of their own.
+    thread_local std::vector<u64> values;
+    std::vector<u64> saved_values;
+    saved_values.swap(values);
+    values = program.initial_values;
+
+    Machine machine{callbacks, jit_state, values};
+    for (const Instruction& inst : program.instructions) {
+        if (inst.opcode == IR::Opcode::PushRSB) {
+            // Interpreted blocks have no host code to return to, so a return to them goes through the dispatcher.
+            jit_state.rsb_ptr = (jit_state.rsb_ptr + 1) & static_cast<u32>(callbacks.rsb_size - 1);
+            jit_state.rsb_location_descriptors[jit_state.rsb_ptr] = values[inst.args[0]];
+            jit_state.rsb_codeptrs[jit_state.rsb_ptr] = reinterpret_cast<u64>(dispatcher);
+            continue;
+        }
+        machine.Execute(inst);
+    }
+
+    values.swap(saved_values);
+
+    // Walked by pointer: copying a terminal with nested terminals allocates.
+    const IR::Terminal* terminal = &program.terminal;
+    while (true) {
+        switch (terminal->which()) {
+        case 1: {
+            const auto& interpret = boost::get<IR::Term::Interpret>(*terminal);
+            link_to(interpret.next);
+            jit_state.interpreter_fallback_count++;
+            callbacks.InterpreterFallback(interpret.next.PC(), jit_state.jit_interface, jit_state.user_arg);
+            return program.cycle_count;
+        }
+        case 2: // ReturnToDispatch
+            ClearITState(jit_state);
+            return program.cycle_count;
+        case 3:
+            link_to(boost::get<IR::Term::LinkBlock>(*terminal).next);
+            return program.cycle_count;
+        case 4:
+            link_to(boost::get<IR::Term::LinkBlockFast>(*terminal).next);
+            return program.cycle_count;
+        case 5: // PopRSBHint
+            ClearITState(jit_state);
+            jit_state.rsb_ptr = (jit_state.rsb_ptr - 1) & static_cast<u32>(callbacks.rsb_size - 1);
+            return program.cycle_count;
+        case 6: {
+            const auto& if_ = boost::get<IR::Term::If>(*terminal);
+            terminal = ConditionPasses(if_.if_, jit_state.Cpsr) ? &if_.then_ : &if_.else_;
+            continue;
+        }
+        case 7: {
+            const IR::Terminal& next = boost::get<IR::Term::CheckHalt>(*terminal).else_;
+            if (boost::get<IR::Term::PopRSBHint>(&next) || boost::get<IR::Term::ReturnToDispatch>(&next))
+                ClearITState(jit_state);
+            if (jit_state.halt_requested)
+                return program.cycle_count;
+            terminal = &next;
+            continue;
+        }
+        default:
+            ASSERT_MSG(false, "Invalid Terminal. Bad programmer.");
+            return program.cycle_count;
+        }
+    }
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
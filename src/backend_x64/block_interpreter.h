@@ -0,0 +1,51 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "backend_x64/jitstate.h"
+#include "common/common_types.h"
+#include "dynarmic/callbacks.h"
+
+namespace Dynarmic {
+
+namespace IR {
+class Block;
+} // namespace IR
+
+namespace BackendX64 {
+
+/**
+ * Runs IR blocks directly on a JitState without emitting host code, for blocks that are not executed
+ * often enough to be worth emitting. A block is first compiled into a Program, a flat list of
+ * instructions whose operands are indices into a table of values, so that running it does not walk
+ * the IR. The guest state after running a Program is the same as after running the emitted block.
+ */
+class BlockInterpreter final {
+public:
+    struct Program;
+
+    /// `dispatcher` is pushed onto the return stack buffer as the target of calls made by interpreted blocks.
+    BlockInterpreter(const UserCallbacks& callbacks, CodePtr dispatcher);
+
+    /**
+     * Compiles block for interpretation. Returns nullptr if the block uses instructions that are not
+     * supported by the interpreter: floating point arithmetic, vector, exclusive and coprocessor instructions.
+     */
+    static std::shared_ptr<const Program> Compile(const IR::Block& block);
+
+    /// Runs program once, including its terminal. Returns the number of cycles it took.
+    size_t Run(const Program& program, JitState& jit_state) const;
+
+private:
+    const UserCallbacks callbacks;
+    CodePtr dispatcher;
+};
+
+} // namespace BackendX64
+} // namespace Dynarmic
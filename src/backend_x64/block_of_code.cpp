@@ -4,8 +4,21 @@
  * General Public License version 2 or any later version.
  */
 
+#include <atomic>
+#include <algorithm>
 #include <cstring>
 #include <limits>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include <xbyak.h>
 
@@ -18,19 +31,449 @@
 namespace Dynarmic {
 namespace BackendX64 {
 
-BlockOfCode::BlockOfCode(UserCallbacks cb) : Xbyak::CodeGenerator(128 * 1024 * 1024), cb(cb) {
+/// Access rights of a view of the code cache.
+enum class CodeSpaceAccess {
+    ReadWriteExecute,
+    ReadWrite,
+    ReadExecute,
+};
+
+#ifdef _WIN32
+static DWORD ToPageProtection(CodeSpaceAccess access) {
+    switch (access) {
+    case CodeSpaceAccess::ReadWriteExecute:
+        return PAGE_EXECUTE_READWRITE;
+    case CodeSpaceAccess::ReadWrite:
+        return PAGE_READWRITE;
+    case CodeSpaceAccess::ReadExecute:
+        return PAGE_EXECUTE_READ;
+    }
+    return PAGE_NOACCESS;
+}
+#else
+static int ToPageProtection(CodeSpaceAccess access) {
+    switch (access) {
+    case CodeSpaceAccess::ReadWriteExecute:
+        return PROT_READ | PROT_WRITE | PROT_EXEC;
+    case CodeSpaceAccess::ReadWrite:
+        return PROT_READ | PROT_WRITE;
+    case CodeSpaceAccess::ReadExecute:
+        return PROT_READ | PROT_EXEC;
+    }
+    return PROT_NONE;
+}
+#endif
+
+// Size of the huge pages requested with UserCallbacks::huge_page_code_cache.
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+#ifndef _WIN32
+/// mmap, but the mapping is aligned to `alignment` bytes if that exceeds the page size.
+static void* MapAligned(size_t size, int prot, int flags, int fd, size_t alignment) {
+    if (alignment <= static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+        return mmap(nullptr, size, prot, flags, fd, 0);
+
+    // Reserve enough address space to contain an aligned mapping, map over it and trim the excess.
+    u8* reservation = static_cast<u8*>(mmap(nullptr, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    if (reservation == MAP_FAILED)
+        return MAP_FAILED;
+    u8* aligned = reinterpret_cast<u8*>((reinterpret_cast<uintptr_t>(reservation) + alignment - 1) & ~(alignment - 1));
+    if (aligned != reservation)
+        munmap(reservation, aligned - reservation);
+    munmap(aligned + size, reservation + alignment - aligned);
+    void* ptr = mmap(aligned, size, prot, flags | MAP_FIXED, fd, 0);
+    if (ptr == MAP_FAILED)
+        munmap(aligned, size);
+    return ptr;
+}
+
+/// Asks for [ptr, ptr + size) to be backed by transparent huge pages where the host supports it.
+static void AdviseHugePages(void* ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, size, MADV_HUGEPAGE);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+#endif
+
+/// Reserves address space for the code cache. Memory is committed lazily (see CommitCodeSpace),
+/// except for large pages on Windows, which must be committed up front.
+static u8* ReserveCodeSpace(size_t size, bool huge_pages) {
+#ifdef _WIN32
+    if (huge_pages) {
+        // Requires SeLockMemoryPrivilege; falls back to normal pages without it.
+        const size_t large_page_size = GetLargePageMinimum();
+        if (large_page_size != 0) {
+            const size_t rounded_size = (size + large_page_size - 1) & ~(large_page_size - 1);
+            void* ptr = VirtualAlloc(nullptr, rounded_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, ToPageProtection(CodeSpaceAccess::ReadWriteExecute));
+            if (ptr)
+                return static_cast<u8*>(ptr);
+        }
+    }
+    return static_cast<u8*>(VirtualAlloc(nullptr, size, MEM_RESERVE, ToPageProtection(CodeSpaceAccess::ReadWriteExecute)));
+#else
+    // MAP_NORESERVE: Pages are only backed by memory once they are touched.
+    // Transparent huge pages are used rather than MAP_HUGETLB, which needs a preallocated pool and cannot commit lazily.
+    void* ptr = MapAligned(size, ToPageProtection(CodeSpaceAccess::ReadWriteExecute), MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, huge_pages ? huge_page_size : 0);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+    if (huge_pages)
+        AdviseHugePages(ptr, size);
+    return static_cast<u8*>(ptr);
+#endif
+}
+
+/**
+ * Reserves address space for the code cache and maps the same memory a second time, so that no page
+ * is ever writable and executable at once. Returns {nullptr, nullptr} if this is unsupported.
+ */
+static std::pair<u8*, u8*> ReserveDualMappedCodeSpace(size_t size, bool huge_pages) {
+#ifdef _WIN32
+    // Large page sections cannot be committed lazily, so huge_pages is not supported here.
+    (void)huge_pages;
+    const u64 size64 = size;
+    HANDLE section = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_EXECUTE_READWRITE | SEC_RESERVE,
+                                        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+    if (!section)
+        return {nullptr, nullptr};
+    void* writable = MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, size);
+    void* executable = MapViewOfFile(section, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, size);
+    // The views keep the section alive.
+    CloseHandle(section);
+    if (!writable || !executable) {
+        if (writable)
+            UnmapViewOfFile(writable);
+        if (executable)
+            UnmapViewOfFile(executable);
+        return {nullptr, nullptr};
+    }
+    return {static_cast<u8*>(writable), static_cast<u8*>(executable)};
+#else
+#if defined(__linux__)
+    const int fd = memfd_create("dynarmic-code-cache", MFD_CLOEXEC);
+#else
+    char name[64];
+    std::snprintf(name, sizeof(name), "/dynarmic-code-cache-%ld-%p", static_cast<long>(getpid()), static_cast<void*>(name));
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1)
+        shm_unlink(name);
+#endif
+    if (fd == -1)
+        return {nullptr, nullptr};
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return {nullptr, nullptr};
+    }
+    // As with a single mapping, pages are only backed by memory once they are touched.
+    const size_t alignment = huge_pages ? huge_page_size : 0;
+    void* writable = MapAligned(size, ToPageProtection(CodeSpaceAccess::ReadWrite), MAP_SHARED | MAP_NORESERVE, fd, alignment);
+    void* executable = MapAligned(size, ToPageProtection(CodeSpaceAccess::ReadExecute), MAP_SHARED | MAP_NORESERVE, fd, alignment);
+    // The mappings keep the memory alive.
+    close(fd);
+    if (writable == MAP_FAILED || executable == MAP_FAILED) {
+        if (writable != MAP_FAILED)
+            munmap(writable, size);
+        if (executable != MAP_FAILED)
+            munmap(executable, size);
+        return {nullptr, nullptr};
+    }
+    if (huge_pages) {
+        // Only effective if the host enables transparent huge pages for shared memory.
+        AdviseHugePages(writable, size);
+        AdviseHugePages(executable, size);
+    }
+    return {static_cast<u8*>(writable), static_cast<u8*>(executable)};
+#endif
+}
+
+/// Ensures [begin, begin + size) of a reserved view of the code space is usable.
+static void CommitCodeSpace(const void* begin, size_t size, CodeSpaceAccess access) {
+#ifdef _WIN32
+    // Large pages are committed on reservation.
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(begin, &info, sizeof(info)) && info.State == MEM_COMMIT && (info.Type & MEM_PRIVATE) && info.RegionSize >= size)
+        return;
+    void* ptr = VirtualAlloc(const_cast<void*>(begin), size, MEM_COMMIT, ToPageProtection(access));
+    ASSERT_MSG(ptr, "Failed to commit code space");
+#else
+    // The kernel commits pages on first touch.
+    (void)begin;
+    (void)size;
+    (void)access;
+#endif
+}
+
+/// Returns the memory backing [begin, begin + size) of the writable view, which must be page aligned, to the OS.
+static void DecommitCodeSpace(u8* begin, size_t size, bool dual_mapped) {
+#ifdef _WIN32
+    // Views of a section cannot be decommitted. Neither can large pages, for which this fails harmlessly.
+    if (!dual_mapped)
+        VirtualFree(begin, size, MEM_DECOMMIT);
+#elif defined(__linux__)
+    // The pages of a shared mapping remain in the memfd unless removed from it.
+    madvise(begin, size, dual_mapped ? MADV_REMOVE : MADV_DONTNEED);
+#else
+    if (!dual_mapped)
+        madvise(begin, size, MADV_DONTNEED);
+#endif
+}
+
+static size_t PageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+static void ReleaseCodeSpace(u8* ptr, size_t size, bool dual_mapped) {
+#ifdef _WIN32
+    (void)size;
+    if (dual_mapped)
+        UnmapViewOfFile(ptr);
+    else
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    (void)dual_mapped;
+    munmap(ptr, size);
+#endif
+}
+
+BlockOfCode::CodeSpace BlockOfCode::MapCodeSpace(const UserCallbacks& cb) {
+    ASSERT_MSG(cb.code_cache_size < 0x80000000, "Code cache must be smaller than 2 GiB");
+    if (cb.dual_mapped_code_cache) {
+        const auto views = ReserveDualMappedCodeSpace(cb.code_cache_size, cb.huge_page_code_cache);
+        ASSERT_MSG(views.first, "Failed to map code cache twice");
+        return {views.first, views.second};
+    }
+    u8* ptr = ReserveCodeSpace(cb.code_cache_size, cb.huge_page_code_cache);
+    ASSERT_MSG(ptr, "Failed to map code cache");
+    return {ptr, ptr};
+}
+
+// Space committed up-front for the prelude (constants, dispatcher, thunks) before regions are known.
+constexpr size_t prelude_commit_size = 1024 * 1024;
+
+BlockOfCode::BlockOfCode(UserCallbacks cb)
+        : BlockOfCode(cb, MapCodeSpace(cb))
+{}
+
+BlockOfCode::BlockOfCode(UserCallbacks cb, CodeSpace code_space)
+        : Xbyak::CodeGenerator(cb.code_cache_size, code_space.writable)
+        , cb(cb)
+        , executable_offset(code_space.executable - code_space.writable)
+{
+    CommitCode(getCode(), std::min(maxSize_, prelude_commit_size));
+    const u8* constants_begin = getCurr();
     GenConstants();
+    constant_pool = static_cast<u8*>(AllocateFromCodeSpace(ConstantPoolSize));
+    constants_size = static_cast<size_t>(getCurr() - constants_begin);
+    call_thunks = static_cast<u8*>(AllocateFromCodeSpace(CallThunkCount * 16));
     GenRunCode();
     GenReturnFromRunCode();
     GenMemoryAccessors();
+    GenDispatcher();
     unwind_handler.Register(this);
     user_code_begin = getCurr<CodePtr>();
+    region_size = (maxSize_ - size_) / (HasHotRegion() ? CodeRegionCount + 1 : CodeRegionCount);
+    for (size_t region = 0; region < region_extents.size(); region++) {
+        region_extents[region] = EmptyRegionExtent(region);
+    }
+    CommitCode(GetRegionBegin(0), region_size);
+    far_code_ptr = GetRegionFarBegin(0);
+}
+
+BlockOfCode::~BlockOfCode() {
+    const bool dual_mapped = cb.dual_mapped_code_cache;
+    ReleaseCodeSpace(top_, maxSize_, dual_mapped);
+    if (dual_mapped)
+        ReleaseCodeSpace(top_ + executable_offset, maxSize_, dual_mapped);
+}
+
+void BlockOfCode::CommitCode(CodePtr begin, size_t size) {
+    if (!cb.dual_mapped_code_cache) {
+        CommitCodeSpace(begin, size, CodeSpaceAccess::ReadWriteExecute);
+        return;
+    }
+    CommitCodeSpace(GetWritablePointer(begin), size, CodeSpaceAccess::ReadWrite);
+    CommitCodeSpace(begin, size, CodeSpaceAccess::ReadExecute);
+}
+
+void BlockOfCode::DecommitCode(CodePtr begin, CodePtr end) {
+    // Huge pages are kept whole.
+    const uintptr_t alignment = cb.huge_page_code_cache ? huge_page_size : PageSize();
+    const uintptr_t aligned_begin = (reinterpret_cast<uintptr_t>(begin) + alignment - 1) & ~(alignment - 1);
+    const uintptr_t aligned_end = reinterpret_cast<uintptr_t>(end) & ~(alignment - 1);
+    if (aligned_begin >= aligned_end)
+        return;
+    DecommitCodeSpace(GetWritablePointer(reinterpret_cast<CodePtr>(aligned_begin)), aligned_end - aligned_begin, cb.dual_mapped_code_cache);
 }
 
 void BlockOfCode::ClearCache() {
+    ASSERT(!in_far_code && !in_hot_region);
+    for (size_t region = 0; region < region_extents.size(); region++) {
+        region_extents[region] = EmptyRegionExtent(region);
+    }
+    current_region = 0;
+    far_code_ptr = GetRegionFarBegin(0);
     SetCodePtr(user_code_begin);
 }
 
+// The last quarter of each region is used for far code.
+CodePtr BlockOfCode::GetRegionBegin(size_t region) const {
+    return static_cast<const u8*>(user_code_begin) + region * region_size;
+}
+
+CodePtr BlockOfCode::GetRegionFarBegin(size_t region) const {
+    return static_cast<const u8*>(GetRegionBegin(region)) + region_size - region_size / 4;
+}
+
+// Assumed to bound the host code of any one guest instruction, the largest being transfers of every register
+// with an inline page table path and a far code fallback for each. AssertWithinCurrentRegion catches a block
+// for which it does not hold.
+constexpr size_t max_bytes_per_guest_instruction = 2048;
+
+bool BlockOfCode::IsCurrentRegionNearlyFull() const {
+    ASSERT(!in_far_code);
+    const u8* near_end = static_cast<const u8*>(GetRegionFarBegin(current_region));
+    const u8* far_end = static_cast<const u8*>(GetRegionBegin(current_region)) + region_size;
+    const size_t margin = GetRegionMargin();
+    return getCurr<const u8*>() + margin > near_end
+        || static_cast<const u8*>(far_code_ptr) + margin > far_end;
+}
+
+size_t BlockOfCode::GetMaxBlockInstructions() const {
+    return std::max<size_t>(1, GetRegionMargin() / max_bytes_per_guest_instruction);
+}
+
+void BlockOfCode::AssertWithinCurrentRegion() const {
+    ASSERT(!in_far_code);
+    const u8* near_end = static_cast<const u8*>(GetRegionFarBegin(current_region));
+    const u8* far_end = static_cast<const u8*>(GetRegionBegin(current_region)) + region_size;
+    ASSERT_MSG(getCurr<const u8*>() <= near_end && static_cast<const u8*>(far_code_ptr) <= far_end,
+               "Block overran code region %zu", current_region);
+}
+
+std::pair<CodePtr, CodePtr> BlockOfCode::GetNextRegionBounds() const {
+    return GetRegionBounds((current_region + 1) % CodeRegionCount);
+}
+
+void BlockOfCode::AdvanceToNextRegion() {
+    ASSERT(!in_far_code && !in_hot_region);
+    region_extents[current_region] = GetRegionExtent(current_region);
+    current_region = (current_region + 1) % CodeRegionCount;
+    CommitCode(GetRegionBegin(current_region), region_size);
+    far_code_ptr = GetRegionFarBegin(current_region);
+    SetCodePtr(GetRegionBegin(current_region));
+}
+
+bool BlockOfCode::HasHotRegion() const {
+    return cb.hot_layout_interval != 0 && cb.hot_block_threshold != 0;
+}
+
+std::pair<CodePtr, CodePtr> BlockOfCode::GetHotRegionBounds() const {
+    ASSERT(HasHotRegion());
+    return GetRegionBounds(CodeRegionCount);
+}
+
+void BlockOfCode::BeginHotRegion() {
+    ASSERT(HasHotRegion() && !in_hot_region && !in_far_code);
+    in_hot_region = true;
+    saved_region = current_region;
+    saved_code_ptr = getCurr();
+    saved_far_code_ptr = far_code_ptr;
+
+    // The hot region is the region after the last, so IsCurrentRegionNearlyFull also applies to it.
+    current_region = CodeRegionCount;
+    CommitCode(GetRegionBegin(current_region), region_size);
+    far_code_ptr = GetRegionFarBegin(current_region);
+    SetCodePtr(GetRegionBegin(current_region));
+}
+
+void BlockOfCode::EndHotRegion() {
+    ASSERT(in_hot_region && !in_far_code);
+    region_extents[CodeRegionCount] = GetRegionExtent(CodeRegionCount);
+    in_hot_region = false;
+    current_region = saved_region;
+    far_code_ptr = saved_far_code_ptr;
+    SetCodePtr(saved_code_ptr);
+}
+
+size_t BlockOfCode::GetRegionCount() const {
+    return HasHotRegion() ? CodeRegionCount + 1 : CodeRegionCount;
+}
+
+size_t BlockOfCode::GetCurrentRegion() const {
+    return current_region;
+}
+
+std::pair<CodePtr, CodePtr> BlockOfCode::GetRegionBounds(size_t region) const {
+    ASSERT(region < GetRegionCount());
+    const u8* begin = static_cast<const u8*>(GetRegionBegin(region));
+    return {begin, begin + region_size};
+}
+
+BlockOfCode::RegionExtent BlockOfCode::EmptyRegionExtent(size_t region) const {
+    return {GetRegionBegin(region), GetRegionFarBegin(region)};
+}
+
+BlockOfCode::RegionExtent BlockOfCode::GetRegionExtent(size_t region) const {
+    if (region == current_region)
+        return in_far_code ? RegionExtent{near_code_ptr, getCurr()} : RegionExtent{getCurr(), far_code_ptr};
+    if (in_hot_region && region == saved_region)
+        return {saved_code_ptr, saved_far_code_ptr};
+    return region_extents[region];
+}
+
+void BlockOfCode::DiscardRegion(size_t region) {
+    ASSERT(region != current_region && !in_hot_region);
+    region_extents[region] = EmptyRegionExtent(region);
+}
+
+void BlockOfCode::ReleaseUnusedCode() {
+    ASSERT(!in_far_code && !in_hot_region);
+    for (size_t region = 0; region < GetRegionCount(); region++) {
+        // The rest of the current region is about to be emitted into.
+        if (region == current_region)
+            continue;
+        const RegionExtent extent = region_extents[region];
+        DecommitCode(extent.near_end, GetRegionFarBegin(region));
+        DecommitCode(extent.far_end, static_cast<const u8*>(GetRegionBegin(region)) + region_size);
+    }
+}
+
+size_t BlockOfCode::GetUsedSize() const {
+    size_t used = GetPreludeSize();
+    for (size_t region = 0; region < GetRegionCount(); region++) {
+        const RegionExtent extent = GetRegionExtent(region);
+        used += static_cast<size_t>(static_cast<const u8*>(extent.near_end) - static_cast<const u8*>(GetRegionBegin(region)));
+        used += static_cast<size_t>(static_cast<const u8*>(extent.far_end) - static_cast<const u8*>(GetRegionFarBegin(region)));
+    }
+    return used;
+}
+
+size_t BlockOfCode::GetPreludeSize() const {
+    return static_cast<size_t>(static_cast<const u8*>(user_code_begin) - getCode());
+}
+
+void BlockOfCode::SwitchToFarCode() {
+    ASSERT(!in_far_code);
+    in_far_code = true;
+    near_code_ptr = getCurr();
+    SetCodePtr(far_code_ptr);
+}
+
+void BlockOfCode::SwitchToNearCode() {
+    ASSERT(in_far_code);
+    in_far_code = false;
+    far_code_ptr = getCurr();
+    SetCodePtr(near_code_ptr);
+}
+
 size_t BlockOfCode::RunCode(JitState* jit_state, CodePtr basic_block, size_t cycles_to_run) const {
     constexpr size_t max_cycles_to_run = static_cast<size_t>(std::numeric_limits<decltype(jit_state->cycles_remaining)>::max());
     ASSERT(cycles_to_run <= max_cycles_to_run);
@@ -44,6 +487,39 @@ void BlockOfCode::ReturnFromRunCode(bool MXCSR_switch) {
     jmp(MXCSR_switch ? return_from_run_code : return_from_run_code_without_mxcsr_switch);
 }
 
+Xbyak::Address BlockOfCode::MConst(const Xbyak::AddressFrame& frame, u64 lower, u64 upper) {
+    const auto key = std::make_pair(lower, upper);
+    auto iter = constant_pool_entries.find(key);
+    if (iter == constant_pool_entries.end()) {
+        ASSERT_MSG(constant_pool_used + 16 <= ConstantPoolSize, "Constant pool is full");
+        u8* entry = constant_pool + constant_pool_used;
+        std::memcpy(entry, &lower, sizeof(u64));
+        std::memcpy(entry + sizeof(u64), &upper, sizeof(u64));
+        constant_pool_used += 16;
+        iter = constant_pool_entries.emplace(key, entry).first;
+    }
+    return frame[rip + iter->second];
+}
+
+const void* BlockOfCode::GetCallThunk(u64 address) {
+    const auto iter = call_thunk_entries.find(address);
+    if (iter != call_thunk_entries.end())
+        return iter->second;
+    if (call_thunks_used == CallThunkCount)
+        return nullptr;
+
+    // jmp qword [rip + 2]; int3; int3; followed by the target address.
+    static constexpr std::array<u8, 8> jmp_to_target = {0xFF, 0x25, 0x02, 0x00, 0x00, 0x00, 0xCC, 0xCC};
+    u8* thunk = call_thunks + call_thunks_used * 16;
+    std::memcpy(thunk, jmp_to_target.data(), jmp_to_target.size());
+    std::memcpy(thunk + jmp_to_target.size(), &address, sizeof(u64));
+    call_thunks_used++;
+
+    const void* executable_thunk = GetExecutablePointer(thunk);
+    call_thunk_entries.emplace(address, executable_thunk);
+    return executable_thunk;
+}
+
 void BlockOfCode::GenConstants() {
     align();
     L(consts.FloatNegativeZero32);
@@ -105,7 +581,14 @@ void BlockOfCode::GenRunCode() {
     ABI_PushCalleeSaveRegistersAndAdjustStack(this);
 
     mov(r15, ABI_PARAM1);
-    SwitchMxcsrOnEntry();
+    // R14 holds the base of guest memory for memory accesses in emitted code: the fastmem_pointer, page_table
+    // or page_directory of the current address space. It is loaded here so that switching address spaces
+    // only has to return to this point (see Jit::SetAddressSpace).
+    if (cb.fastmem_pointer || cb.page_table || cb.page_directory) {
+        mov(r14, qword[r15 + offsetof(JitState, memory_base)]);
+    }
+    // The guest MXCSR is switched in lazily, by the first block that needs it (see EmitX64::Emit).
+    mov(byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
     jmp(ABI_PARAM2);
 }
 
@@ -120,72 +603,427 @@ void BlockOfCode::GenReturnFromRunCode() {
     ret();
 }
 
+size_t BlockOfCode::FastDispatchIndex(u64 unique_hash) {
+    // This calculation has to match up with BlockOfCode::GenDispatcher
+    u32 folded = static_cast<u32>(unique_hash) ^ static_cast<u32>(unique_hash >> 32);
+    return (folded >> 1) & (FastDispatchTableSize - 1);
+}
+
+void BlockOfCode::GenDispatcher() {
+    align(64);
+    fast_dispatch_table = static_cast<FastDispatchEntry*>(AllocateFromCodeSpace(FastDispatchTableSize * sizeof(FastDispatchEntry)));
+    ClearFastDispatchTable();
+
+    align();
+    dispatcher = getCurr<const void*>();
+
+    Xbyak::Label miss;
+
+    cmp(qword[r15 + offsetof(JitState, cycles_remaining)], 0);
+    jle(miss, T_NEAR);
+    cmp(byte[r15 + offsetof(JitState, halt_requested)], u8(0));
+    jne(miss, T_NEAR);
+
+    CalculateUniqueHash();
+
+    // This calculation has to match up with BlockOfCode::FastDispatchIndex
+    // The result is the byte offset of the entry: ((folded >> 1) & mask) * sizeof(FastDispatchEntry).
+    auto emit_lookup = [this]{
+        mov(rax, rbx);
+        shr(rax, 32);
+        xor_(eax, ebx);
+        shl(eax, 3);
+        and_(eax, u32((FastDispatchTableSize - 1) * sizeof(FastDispatchEntry)));
+        mov(rdx, reinterpret_cast<u64>(fast_dispatch_table));
+        cmp(rbx, qword[rdx + rax + offsetof(FastDispatchEntry, location_descriptor)]);
+    };
+
+    emit_lookup();
+    jne(miss, T_NEAR);
+    jmp(qword[rdx + rax + offsetof(FastDispatchEntry, code_ptr)]);
+
+    align();
+    inline_cache_miss = getCurr<const void*>();
+
+    // The caller has already checked cycles_remaining and halt_requested.
+    emit_lookup();
+    jne(miss, T_NEAR);
+    mov(rax, qword[rdx + rax + offsetof(FastDispatchEntry, code_ptr)]);
+    for (size_t i = InlineCacheSize - 1; i > 0; i--) {
+        mov(rcx, qword[rsi + (i - 1) * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, location_descriptor)]);
+        mov(rdx, qword[rsi + (i - 1) * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, code_ptr)]);
+        mov(qword[rsi + i * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, location_descriptor)], rcx);
+        mov(qword[rsi + i * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, code_ptr)], rdx);
+    }
+    mov(qword[rsi + offsetof(FastDispatchEntry, location_descriptor)], rbx);
+    mov(qword[rsi + offsetof(FastDispatchEntry, code_ptr)], rax);
+    jmp(rax);
+
+    L(miss);
+    jmp(return_from_run_code);
+}
+
+void BlockOfCode::StartCallbackTimer() {
+    if (!cb.measure_latency)
+        return;
+
+    // rdtsc writes edx, which may hold an argument.
+    mov(r11, rdx);
+    rdtsc();
+    shl(rdx, 32);
+    or_(rax, rdx);
+    mov(qword[r15 + offsetof(JitState, callback_start)], rax);
+    mov(rdx, r11);
+}
+
+void BlockOfCode::StopCallbackTimer(CallbackKind kind) {
+    if (!cb.measure_latency)
+        return;
+
+    const size_t histogram_offset = offsetof(JitState, callback_latency) + static_cast<size_t>(kind) * LatencyBucketCount * sizeof(u64);
+
+    mov(r11, rax);
+    rdtsc();
+    shl(rdx, 32);
+    or_(rax, rdx);
+    sub(rax, qword[r15 + offsetof(JitState, callback_start)]);
+    // Durations of 0 and 1 ticks share bucket 0, and bsr is undefined for 0.
+    or_(rax, 1);
+    bsr(rax, rax);
+    inc(qword[r15 + rax * 8 + histogram_offset]);
+    mov(rax, r11);
+}
+
+void BlockOfCode::CalculateUniqueHash() {
+    // This calculation has to match up with IR::LocationDescriptor::UniqueHash
+    mov(ebx, dword[r15 + offsetof(JitState, Cpsr)]);
+    and_(ebx, u32((1 << 5) | (1 << 9)));
+    shr(ebx, 2);
+    or_(ebx, dword[r15 + offsetof(JitState, FPSCR_mode)]);
+    // IT[7:2] (CPSR bits 10-15) goes to bits 26-31 and IT[1:0] (CPSR bits 25-26) to bits 0-1.
+    mov(ecx, dword[r15 + offsetof(JitState, Cpsr)]);
+    and_(ecx, u32(0x0000FC00));
+    shl(ecx, 16);
+    or_(ebx, ecx);
+    mov(ecx, dword[r15 + offsetof(JitState, Cpsr)]);
+    and_(ecx, u32(0x06000000));
+    shr(ecx, 25);
+    or_(ebx, ecx);
+    // M[0] goes to bit 2 and M[3:1] to bits 4-6.
+    mov(ecx, dword[r15 + offsetof(JitState, Cpsr)]);
+    and_(ecx, u32(0x1));
+    shl(ecx, 2);
+    or_(ebx, ecx);
+    mov(ecx, dword[r15 + offsetof(JitState, Cpsr)]);
+    and_(ecx, u32(0xE));
+    shl(ecx, 3);
+    or_(ebx, ecx);
+    or_(ebx, dword[r15 + offsetof(JitState, address_space_hash)]);
+    shl(rbx, 32);
+    mov(ecx, dword[r15 + offsetof(JitState, Reg) + sizeof(u32) * 15]);
+    or_(rbx, rcx);
+}
+
+void BlockOfCode::SetFastDispatchEntry(u64 unique_hash, CodePtr code_ptr) {
+    FastDispatchEntry& entry = fast_dispatch_table[FastDispatchIndex(unique_hash)];
+    entry.location_descriptor = unique_hash;
+    entry.code_ptr = code_ptr;
+}
+
+void BlockOfCode::SetFastDispatchEntryIfUnused(u64 unique_hash, CodePtr code_ptr) {
+    FastDispatchEntry& entry = fast_dispatch_table[FastDispatchIndex(unique_hash)];
+    if (entry.code_ptr)
+        return;
+    // The dispatcher reads location_descriptor before code_ptr, so code_ptr must be visible first.
+    entry.code_ptr = code_ptr;
+    std::atomic_signal_fence(std::memory_order_release);
+    entry.location_descriptor = unique_hash;
+}
+
+void BlockOfCode::ClearFastDispatchEntry(u64 unique_hash) {
+    FastDispatchEntry& entry = fast_dispatch_table[FastDispatchIndex(unique_hash)];
+    if (entry.location_descriptor == unique_hash) {
+        entry = {0xFFFFFFFFFFFFFFFFull, nullptr};
+    }
+}
+
+void BlockOfCode::ClearFastDispatchTable() {
+    // The invalid descriptor can never be produced by the dispatcher since the FPSCR mode mask excludes bit 0.
+    std::fill_n(fast_dispatch_table, FastDispatchTableSize, FastDispatchEntry{0xFFFFFFFFFFFFFFFFull, nullptr});
+}
+
 void BlockOfCode::GenMemoryAccessors() {
     align();
     read_memory_8 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Read8);
+    CallMemoryReadFunction(8);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     read_memory_16 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Read16);
+    CallMemoryReadFunction(16);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     read_memory_32 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Read32);
+    CallMemoryReadFunction(32);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     read_memory_64 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Read64);
+    CallMemoryReadFunction(64);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     write_memory_8 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Write8);
+    CallMemoryWriteFunction(8);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     write_memory_16 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Write16);
+    CallMemoryWriteFunction(16);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     write_memory_32 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Write32);
+    CallMemoryWriteFunction(32);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 
     align();
     write_memory_64 = getCurr<const void*>();
     ABI_PushCallerSaveRegistersAndAdjustStack(this);
-    CallFunction(cb.memory.Write64);
+    CallMemoryWriteFunction(64);
     ABI_PopCallerSaveRegistersAndAdjustStack(this);
     ret();
 }
 
+/**
+ * Calls the handler at handler_offset in the MmioHandler of the page of the vaddr in ABI_PARAM1, if
+ * there is one, with the handler's device prepended to the arguments, and then jumps to `end`.
+ * Falls through otherwise.
+ */
+static void EmitMmioDispatch(BlockOfCode* code, const UserCallbacks& cb, size_t handler_offset, Xbyak::Label& end) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label generic;
+
+    code->mov(eax, code->ABI_PARAM1.cvt32());
+    code->shr(eax, UserCallbacks::PAGE_BITS);
+    code->mov(r11, reinterpret_cast<u64>(cb.mmio_pages));
+    code->mov(rax, qword[r11 + rax * 8]);
+    code->test(rax, rax);
+    code->jz(generic);
+    code->mov(r11, qword[rax + handler_offset]);
+    code->test(r11, r11);
+    code->jz(generic);
+
+    code->mov(code->ABI_PARAM3, code->ABI_PARAM2);
+    code->mov(code->ABI_PARAM2, code->ABI_PARAM1);
+    code->mov(code->ABI_PARAM1, qword[rax + offsetof(MmioHandler, device)]);
+    code->call(r11);
+    code->jmp(end, code->T_NEAR);
+
+    code->L(generic);
+}
+
+/**
+ * Calls the MMIO handler at handler_offset for the page being accessed if there is one (see
+ * UserCallbacks::mmio_pages), and otherwise `fn_with_user_arg` with user_arg prepended to the
+ * arguments if it is set, and `fn` if not.
+ */
+template <typename FunctionPointer, typename FunctionPointerWithUserArg>
+static void CallMemoryFunction(BlockOfCode* code, const UserCallbacks& cb, size_t handler_offset, FunctionPointer fn, FunctionPointerWithUserArg fn_with_user_arg) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label end;
+
+    code->StartCallbackTimer();
+
+    if (cb.mmio_pages) {
+        EmitMmioDispatch(code, cb, handler_offset, end);
+    }
+
+    if (!fn_with_user_arg) {
+        code->CallFunction(fn);
+    } else {
+        code->mov(code->ABI_PARAM3, code->ABI_PARAM2);
+        code->mov(code->ABI_PARAM2, code->ABI_PARAM1);
+        code->mov(code->ABI_PARAM1, qword[r15 + offsetof(JitState, user_arg)]);
+        code->CallFunction(fn_with_user_arg);
+    }
+
+    code->L(end);
+    code->StopCallbackTimer(CallbackKind::Memory);
+}
+
+/**
+ * Calls UserCallbacks::WatchpointHit if accesses of `kind` are watched on either page touched by the
+ * access of `access_size` bytes at the vaddr in ABI_PARAM1 (see EmitX64::GetWatchedPages). Preserves
+ * ABI_PARAM1 and ABI_PARAM2.
+ */
+static void EmitReportWatchpoint(BlockOfCode* code, const UserCallbacks& cb, WatchpointKind kind, size_t access_size) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label report, end;
+
+    code->mov(eax, code->ABI_PARAM1.cvt32());
+    code->shr(eax, UserCallbacks::PAGE_BITS);
+    code->mov(r11, qword[r15 + offsetof(JitState, watched_pages)]);
+    code->test(code->byte[r11 + rax], static_cast<u8>(kind));
+    if (access_size > 1) {
+        code->jnz(report);
+        code->lea(eax, ptr[code->ABI_PARAM1 + static_cast<u32>(access_size - 1)]);
+        code->shr(eax, UserCallbacks::PAGE_BITS);
+        code->test(code->byte[r11 + rax], static_cast<u8>(kind));
+    }
+    code->jz(end, code->T_NEAR);
+
+    code->L(report);
+    ABI_PushRegistersAndAdjustStack(code, 0, {ABI_PARAM1, ABI_PARAM2});
+    code->mov(code->ABI_PARAM2.cvt32(), u32(kind == WatchpointKind::Write));
+    code->mov(code->ABI_PARAM3, qword[r15 + offsetof(JitState, jit_interface)]);
+    code->mov(code->ABI_PARAM4, qword[r15 + offsetof(JitState, user_arg)]);
+    code->CallFunction(cb.WatchpointHit);
+    ABI_PopRegistersAndAdjustStack(code, 0, {ABI_PARAM1, ABI_PARAM2});
+
+    code->L(end);
+}
+
+void BlockOfCode::CallMemoryReadFunction(size_t bit_size) {
+    if (cb.WatchpointHit) {
+        EmitReportWatchpoint(this, cb, WatchpointKind::Read, bit_size / 8);
+    }
+
+    switch (bit_size) {
+    case 8:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Read8), cb.memory.Read8, cb.memory_with_user_arg.Read8);
+        break;
+    case 16:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Read16), cb.memory.Read16, cb.memory_with_user_arg.Read16);
+        break;
+    case 32:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Read32), cb.memory.Read32, cb.memory_with_user_arg.Read32);
+        break;
+    case 64:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Read64), cb.memory.Read64, cb.memory_with_user_arg.Read64);
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+}
+
+/// Does what JitState::RecordCodeWrite does for a write of `access_size` bytes at the vaddr in ABI_PARAM1.
+/// Clobbers RAX and R11.
+static void EmitRecordCodeWrite(BlockOfCode* code, size_t access_size) {
+    using namespace Xbyak::util;
+
+    // The pages of the first and of the last byte written, which are the same unless the write crosses a page.
+    for (u32 last_byte : {0u, static_cast<u32>(access_size - 1)}) {
+        Xbyak::Label end, not_first, not_last;
+
+        code->lea(eax, ptr[code->ABI_PARAM1 + last_byte]);
+        code->shr(eax, UserCallbacks::PAGE_BITS);
+        code->mov(r11, qword[r15 + offsetof(JitState, code_pages)]);
+        code->cmp(code->byte[r11 + rax], u8(0));
+        code->je(end);
+        code->cmp(eax, dword[r15 + offsetof(JitState, code_write_first_page)]);
+        code->jae(not_first);
+        code->mov(dword[r15 + offsetof(JitState, code_write_first_page)], eax);
+        code->L(not_first);
+        code->cmp(eax, dword[r15 + offsetof(JitState, code_write_last_page)]);
+        code->jbe(not_last);
+        code->mov(dword[r15 + offsetof(JitState, code_write_last_page)], eax);
+        code->L(not_last);
+        code->mov(code->byte[r15 + offsetof(JitState, halt_requested)], u8(1));
+        code->L(end);
+
+        if (access_size == 1)
+            break;
+    }
+}
+
+void BlockOfCode::CallMemoryWriteFunction(size_t bit_size) {
+    if (cb.detect_self_modifying_code) {
+        EmitRecordCodeWrite(this, bit_size / 8);
+    }
+    if (cb.WatchpointHit) {
+        EmitReportWatchpoint(this, cb, WatchpointKind::Write, bit_size / 8);
+    }
+
+    switch (bit_size) {
+    case 8:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Write8), cb.memory.Write8, cb.memory_with_user_arg.Write8);
+        break;
+    case 16:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Write16), cb.memory.Write16, cb.memory_with_user_arg.Write16);
+        break;
+    case 32:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Write32), cb.memory.Write32, cb.memory_with_user_arg.Write32);
+        break;
+    case 64:
+        CallMemoryFunction(this, cb, offsetof(MmioHandler, Write64), cb.memory.Write64, cb.memory_with_user_arg.Write64);
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+}
+
+void BlockOfCode::CallSavingRegisters(const std::vector<HostLoc>& registers, std::function<void()> emit_call) {
+    Xbyak::Label thunk, end;
+
+    call(thunk);
+
+    // Fallback paths are already in far code, in which case the thunk is simply jumped over.
+    const bool was_in_far_code = in_far_code;
+    if (was_in_far_code) {
+        jmp(end, T_NEAR);
+    } else {
+        SwitchToFarCode();
+    }
+
+    L(thunk);
+    ABI_PushRegistersAndAdjustStack(this, 0, registers);
+    emit_call();
+    ABI_PopRegistersAndAdjustStack(this, 0, registers);
+    ret();
+
+    if (was_in_far_code) {
+        L(end);
+    } else {
+        SwitchToNearCode();
+    }
+}
+
 void BlockOfCode::SwitchMxcsrOnEntry() {
     stmxcsr(dword[r15 + offsetof(JitState, save_host_MXCSR)]);
     ldmxcsr(dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    mov(byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(1));
 }
 
 void BlockOfCode::SwitchMxcsrOnExit() {
+    Xbyak::Label end;
+
+    cmp(byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    je(end);
     stmxcsr(dword[r15 + offsetof(JitState, guest_MXCSR)]);
     ldmxcsr(dword[r15 + offsetof(JitState, save_host_MXCSR)]);
+    mov(byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    L(end);
 }
 
 void BlockOfCode::nop(size_t size) {
@@ -232,7 +1070,8 @@ void* BlockOfCode::AllocateFromCodeSpace(size_t alloc_size) {
         throw Xbyak::Error(Xbyak::ERR_CODE_IS_TOO_BIG);
     }
 
-    void* ret = getCurr<void*>();
+    // Returned in the writable view, since both host and emitted code write to such memory.
+    void* ret = top_ + size_;
     size_ += alloc_size;
     memset(ret, 0, alloc_size);
     return ret;
@@ -250,5 +1089,9 @@ void BlockOfCode::EnsurePatchLocationSize(CodePtr begin, size_t size) {
     nop(size - current_size);
 }
 
+void BlockOfCode::SetFaultCallback(FaultCallback callback) {
+    exception_handler.Register(this, std::move(callback));
+}
+
 } // namespace BackendX64
 } // namespace Dynarmic
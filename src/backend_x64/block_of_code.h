@@ -6,11 +6,18 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <xbyak.h>
 
+#include "backend_x64/hostloc.h"
 #include "backend_x64/jitstate.h"
 #include "common/common_types.h"
 #include "dynarmic/callbacks.h"
@@ -21,20 +28,85 @@ namespace BackendX64 {
 class BlockOfCode final : public Xbyak::CodeGenerator {
 public:
     explicit BlockOfCode(UserCallbacks cb);
+    ~BlockOfCode();
 
     /// Clears this block of code and resets code pointer to beginning.
     void ClearCache();
 
+    /// The code space after the prelude is split into this many equally sized regions.
+    /// Regions are filled and evicted in FIFO order.
+    /// Each region consists of a near code area followed by a far code area.
+    static constexpr size_t CodeRegionCount = 8;
+    /// Returns true if the current region is too full to safely emit another block into.
+    bool IsCurrentRegionNearlyFull() const;
+    /// Returns the most guest instructions a block may be translated with, so that its code fits in the
+    /// space that IsCurrentRegionNearlyFull leaves free in the near and far areas of a region.
+    size_t GetMaxBlockInstructions() const;
+    /// Asserts that the code emitted into the current region has stayed within its near and far areas.
+    void AssertWithinCurrentRegion() const;
+    /// Returns the bounds [begin, end) of the region that AdvanceToNextRegion will move to.
+    std::pair<CodePtr, CodePtr> GetNextRegionBounds() const;
+    /// Moves the code pointer to the start of the next region, wrapping around after the last one.
+    /// The caller must have evicted all code in that region beforehand.
+    void AdvanceToNextRegion();
+
+    /// With UserCallbacks::hot_layout_interval, one more region of the same size follows the others,
+    /// into which hot blocks are laid out. It is never evicted by AdvanceToNextRegion.
+    bool HasHotRegion() const;
+    /// Returns the bounds [begin, end) of the hot region.
+    std::pair<CodePtr, CodePtr> GetHotRegionBounds() const;
+    /// Moves the code pointer to the start of the hot region. The caller must have evicted all code in it beforehand.
+    void BeginHotRegion();
+    /// Moves the code pointer back to where it was before BeginHotRegion.
+    void EndHotRegion();
+
+    /// Number of regions, including the hot region if there is one.
+    size_t GetRegionCount() const;
+    /// Returns the index of the region code is currently emitted into.
+    size_t GetCurrentRegion() const;
+    /// Returns the bounds [begin, end) of `region`. The hot region is the last region.
+    std::pair<CodePtr, CodePtr> GetRegionBounds(size_t region) const;
+    /// Marks `region` as empty. The caller must have evicted all code in it beforehand.
+    void DiscardRegion(size_t region);
+    /**
+     * Returns the memory backing the parts of the regions that hold no code, other than the current
+     * region, to the OS. It is committed again when the region is next emitted into. Memory that cannot
+     * be decommitted, such as large pages on Windows, is kept.
+     */
+    void ReleaseUnusedCode();
+
+    /// Bytes of the code space holding code or data, including the prelude.
+    size_t GetUsedSize() const;
+    /// Bytes of the code space used by the prelude: constants, the dispatcher and thunks.
+    size_t GetPreludeSize() const;
+    /// Bytes of the prelude used by constants.
+    size_t GetConstantsSize() const {
+        return constants_size;
+    }
+    /// Bytes of address space reserved for the code space.
+    size_t GetReservedSize() const {
+        return maxSize_;
+    }
+
     /// Runs emulated code for approximately `cycles_to_run` cycles.
     size_t RunCode(JitState* jit_state, CodePtr basic_block, size_t cycles_to_run) const;
     /// Code emitter: Returns to host
     void ReturnFromRunCode(bool MXCSR_switch = true);
     /// Code emitter: Makes guest MXCSR the current MXCSR
     void SwitchMxcsrOnEntry();
-    /// Code emitter: Makes saved host MXCSR the current MXCSR
+    /// Code emitter: Makes saved host MXCSR the current MXCSR, if the guest MXCSR is current. Clobbers flags.
     void SwitchMxcsrOnExit();
+    /// Code emitter: Calculates the UniqueHash of the current guest location into rbx. Clobbers rcx.
+    void CalculateUniqueHash();
+
+    /// Code emitter: Subsequent code is emitted into the far code area of the current region.
+    /// Rarely executed paths go here, so that the near code of a block stays dense.
+    void SwitchToFarCode();
+    /// Code emitter: Subsequent code is emitted into the near code area of the current region.
+    void SwitchToNearCode();
 
-    /// Code emitter: Calls the function
+    /// Code emitter: Calls the function. Functions out of reach of a direct call are called through a
+    /// thunk (see GetCallThunk), or else through rax.
     template <typename FunctionPointer>
     void CallFunction(FunctionPointer fn) {
         static_assert(std::is_pointer<FunctionPointer>() && std::is_function<std::remove_pointer_t<FunctionPointer>>(),
@@ -45,13 +117,50 @@ public:
 
         if (distance >= 0x0000000080000000ULL && distance < 0xFFFFFFFF80000000ULL) {
             // Far call
+            if (const void* thunk = GetCallThunk(address)) {
+                call(thunk);
+                return;
+            }
             mov(rax, address);
             call(rax);
         } else {
-            call(fn);
+            call(reinterpret_cast<const void*>(fn));
         }
     }
 
+    /// Code emitter: Calls the function as CallFunction does. With UserCallbacks::measure_latency, also counts
+    /// the duration of the call in JitState::callback_latency under `kind`, clobbering r11, and rdx after the call.
+    template <typename FunctionPointer>
+    void CallCallback(CallbackKind kind, FunctionPointer fn) {
+        StartCallbackTimer();
+        CallFunction(fn);
+        StopCallbackTimer(kind);
+    }
+    /// Code emitter: With UserCallbacks::measure_latency, starts timing a callback. Preserves the argument registers.
+    void StartCallbackTimer();
+    /// Code emitter: With UserCallbacks::measure_latency, counts the time since StartCallbackTimer under `kind`. Preserves rax.
+    void StopCallbackTimer(CallbackKind kind);
+
+    /// Number of distinct far functions that can be called through thunks.
+    static constexpr size_t CallThunkCount = 256;
+    /// Returns a thunk in the prelude that jumps to `address`, so that code anywhere in the code space can
+    /// reach it with a direct call. Thunks are made the first time they are asked for and are never removed.
+    /// Returns nullptr once CallThunkCount thunks have been made.
+    const void* GetCallThunk(u64 address);
+
+    /// Code emitter: Calls the memory read callback (or MMIO handler) for accesses of `bit_size` bits, with vaddr in ABI_PARAM1.
+    /// Also reports reads of watched pages (see UserCallbacks::WatchpointHit).
+    /// Clobbers all caller-saved registers; use GetMemoryReadCallback to preserve them.
+    void CallMemoryReadFunction(size_t bit_size);
+    /// Code emitter: Calls the memory write callback (or MMIO handler) for accesses of `bit_size` bits, with vaddr in ABI_PARAM1
+    /// and the value in ABI_PARAM2. Also records writes to code pages (see JitState::RecordCodeWrite) and reports writes to watched pages.
+    /// Clobbers all caller-saved registers; use GetMemoryWriteCallback to preserve them.
+    void CallMemoryWriteFunction(size_t bit_size);
+    /// Code emitter: Calls a thunk that saves `registers`, makes the call emitted by `emit_call` and restores them.
+    /// Unlike the memory callback thunks, which save all caller-saved registers, this is emitted once per call site,
+    /// so only the registers live there need to be saved. The thunk is placed in the far code area.
+    void CallSavingRegisters(const std::vector<HostLoc>& registers, std::function<void()> emit_call);
+
     Xbyak::Address MFloatPositiveZero32() {
         return xword[rip + consts.FloatPositiveZero32];
     }
@@ -92,10 +201,53 @@ public:
         return xword[rip + consts.FloatMaxU32];
     }
 
+    /// Size of the constant pool, which is never cleared: it is for constants chosen by the emitter, not for
+    /// values taken from guest code.
+    static constexpr size_t ConstantPoolSize = 4096 * 16;
+    /**
+     * Returns a rip-relative memory operand of size `frame` for the 128-bit constant whose low and high
+     * quadwords are `lower` and `upper`, e.g. MConst(xword, 0x...) to use it as an operand of SSE instructions
+     * or MConst(qword, 0x...) for a 64-bit constant. The constant is added to the constant pool the first time
+     * it is asked for, and is 16-byte aligned.
+     */
+    Xbyak::Address MConst(const Xbyak::AddressFrame& frame, u64 lower, u64 upper = 0);
+
     const void* GetReturnFromRunCodeAddress() const {
         return return_from_run_code;
     }
 
+    /// Address of the dispatcher, which looks up the block for the current guest state in the
+    /// fast dispatch table and jumps to it. Returns to host on a miss, halt or when out of cycles.
+    const void* GetDispatcherAddress() const {
+        return dispatcher;
+    }
+
+    /// An entry of the fast dispatch table or of an inline cache.
+    struct FastDispatchEntry {
+        u64 location_descriptor;
+        CodePtr code_ptr;
+    };
+    static_assert(sizeof(FastDispatchEntry) == 16, "FastDispatchEntry layout is relied upon by emitted code");
+    /// Number of entries in the inline cache of an indirect branch. Most recently used entry first.
+    static constexpr size_t InlineCacheSize = 2;
+
+    /// Address of the inline cache miss handler. Expects the UniqueHash of the current guest location
+    /// in rbx and the inline cache in rsi. Looks up the block in the fast dispatch table, inserts it
+    /// at the front of the inline cache and jumps to it. Returns to host on a miss.
+    const void* GetInlineCacheMissAddress() const {
+        return inline_cache_miss;
+    }
+
+    /// Records that the block with location descriptor hash `unique_hash` is at `code_ptr`.
+    void SetFastDispatchEntry(u64 unique_hash, CodePtr code_ptr);
+    /// As SetFastDispatchEntry, but leaves an entry that is in use by another block untouched.
+    /// Safe to call while other threads are executing the dispatcher.
+    void SetFastDispatchEntryIfUnused(u64 unique_hash, CodePtr code_ptr);
+    /// Removes the block with location descriptor hash `unique_hash` from the fast dispatch table, if present.
+    void ClearFastDispatchEntry(u64 unique_hash);
+    /// Empties the fast dispatch table.
+    void ClearFastDispatchTable();
+
     const void* GetMemoryReadCallback(size_t bit_size) const {
         switch (bit_size) {
         case 8:
@@ -137,6 +289,57 @@ public:
     void SetCodePtr(CodePtr code_ptr);
     void EnsurePatchLocationSize(CodePtr begin, size_t size);
 
+    /// The code cache may be mapped twice (see UserCallbacks::dual_mapped_code_cache): code is written
+    /// through a writable view and executed from an executable view at a different address. All code
+    /// pointers handed out by this class, including getCurr and getCode, are in the executable view.
+    /// Returns the address at which `executable_ptr` can be written.
+    u8* GetWritablePointer(CodePtr executable_ptr) const {
+        return const_cast<u8*>(static_cast<const u8*>(executable_ptr)) - executable_offset;
+    }
+    /// Returns the address at which `writable_ptr` is executed.
+    CodePtr GetExecutablePointer(const void* writable_ptr) const {
+        return static_cast<const u8*>(writable_ptr) + executable_offset;
+    }
+
+    template <typename T = const u8*>
+    T getCurr() const {
+        return reinterpret_cast<T>(top_ + size_ + executable_offset);
+    }
+    const u8* getCode() const {
+        return top_ + executable_offset;
+    }
+
+    // Branches to absolute addresses take addresses in the executable view; Xbyak encodes them
+    // relative to the writable view.
+    using Xbyak::CodeGenerator::call;
+    void call(const void* addr) {
+        Xbyak::CodeGenerator::call(ToEmitterAddress(addr));
+    }
+    using Xbyak::CodeGenerator::jmp;
+    void jmp(const void* addr, LabelType type = T_AUTO) {
+        Xbyak::CodeGenerator::jmp(ToEmitterAddress(addr), type);
+    }
+#define DYNARMIC_ABSOLUTE_JCC(name)                               \
+    using Xbyak::CodeGenerator::name;                             \
+    void name(const void* addr) {                                 \
+        Xbyak::CodeGenerator::name(ToEmitterAddress(addr));       \
+    }
+    DYNARMIC_ABSOLUTE_JCC(ja) DYNARMIC_ABSOLUTE_JCC(jae) DYNARMIC_ABSOLUTE_JCC(jb) DYNARMIC_ABSOLUTE_JCC(jbe)
+    DYNARMIC_ABSOLUTE_JCC(jc) DYNARMIC_ABSOLUTE_JCC(je) DYNARMIC_ABSOLUTE_JCC(jg) DYNARMIC_ABSOLUTE_JCC(jge)
+    DYNARMIC_ABSOLUTE_JCC(jl) DYNARMIC_ABSOLUTE_JCC(jle) DYNARMIC_ABSOLUTE_JCC(jna) DYNARMIC_ABSOLUTE_JCC(jnae)
+    DYNARMIC_ABSOLUTE_JCC(jnb) DYNARMIC_ABSOLUTE_JCC(jnbe) DYNARMIC_ABSOLUTE_JCC(jnc) DYNARMIC_ABSOLUTE_JCC(jne)
+    DYNARMIC_ABSOLUTE_JCC(jng) DYNARMIC_ABSOLUTE_JCC(jnge) DYNARMIC_ABSOLUTE_JCC(jnl) DYNARMIC_ABSOLUTE_JCC(jnle)
+    DYNARMIC_ABSOLUTE_JCC(jno) DYNARMIC_ABSOLUTE_JCC(jnp) DYNARMIC_ABSOLUTE_JCC(jns) DYNARMIC_ABSOLUTE_JCC(jnz)
+    DYNARMIC_ABSOLUTE_JCC(jo) DYNARMIC_ABSOLUTE_JCC(jp) DYNARMIC_ABSOLUTE_JCC(jpe) DYNARMIC_ABSOLUTE_JCC(jpo)
+    DYNARMIC_ABSOLUTE_JCC(js) DYNARMIC_ABSOLUTE_JCC(jz)
+#undef DYNARMIC_ABSOLUTE_JCC
+
+    /// Called when emitted code faults on a memory access at `fault_location`. Returns the location
+    /// in emitted code to resume execution at, or nullptr if the fault is not to be handled.
+    using FaultCallback = std::function<CodePtr(CodePtr fault_location)>;
+    /// Installs a handler for memory access faults that occur in emitted code.
+    void SetFaultCallback(FaultCallback callback);
+
 #ifdef _WIN32
     Xbyak::Reg64 ABI_RETURN = rax;
     Xbyak::Reg64 ABI_PARAM1 = rcx;
@@ -152,9 +355,56 @@ public:
 #endif
 
 private:
+    /// The views through which the code cache is written and executed. Identical unless dual mapped.
+    struct CodeSpace {
+        u8* writable;
+        u8* executable;
+    };
+    static CodeSpace MapCodeSpace(const UserCallbacks& cb);
+    BlockOfCode(UserCallbacks cb, CodeSpace code_space);
+
     UserCallbacks cb;
     CodePtr user_code_begin;
 
+    /// Address of the executable view minus that of the writable view.
+    std::ptrdiff_t executable_offset;
+    const void* ToEmitterAddress(const void* addr) const {
+        return static_cast<const u8*>(addr) - executable_offset;
+    }
+    void CommitCode(CodePtr begin, size_t size);
+    /// Decommits the whole pages within [begin, end).
+    void DecommitCode(CodePtr begin, CodePtr end);
+
+    size_t region_size = 0;
+    size_t current_region = 0;
+    CodePtr GetRegionBegin(size_t region) const;
+    CodePtr GetRegionFarBegin(size_t region) const;
+    /// Space kept free in both areas of the current region for the next block.
+    size_t GetRegionMargin() const {
+        return region_size / 16;
+    }
+
+    /// The ends of the near and far code emitted into a region.
+    struct RegionExtent {
+        CodePtr near_end;
+        CodePtr far_end;
+    };
+    /// Extents of each region (the hot region last) as of when code was last emitted into it.
+    /// That of the region being emitted into is given by the code pointers instead, see GetRegionExtent.
+    std::array<RegionExtent, CodeRegionCount + 1> region_extents;
+    RegionExtent GetRegionExtent(size_t region) const;
+    RegionExtent EmptyRegionExtent(size_t region) const;
+    size_t constants_size = 0;
+
+    bool in_far_code = false;
+    CodePtr near_code_ptr;
+    CodePtr far_code_ptr;
+
+    bool in_hot_region = false;
+    size_t saved_region;
+    CodePtr saved_code_ptr;
+    CodePtr saved_far_code_ptr;
+
     struct Consts {
         Xbyak::Label FloatPositiveZero32;
         Xbyak::Label FloatNegativeZero32;
@@ -172,6 +422,16 @@ private:
     } consts;
     void GenConstants();
 
+    /// The constants of MConst: 16 bytes each, in the writable view, which rip-relative operands are encoded against.
+    u8* constant_pool = nullptr;
+    size_t constant_pool_used = 0;
+    std::map<std::pair<u64, u64>, const u8*> constant_pool_entries;
+
+    /// The thunks of GetCallThunk, 16 bytes each, in the writable view.
+    u8* call_thunks = nullptr;
+    size_t call_thunks_used = 0;
+    std::map<u64, const void*> call_thunk_entries;
+
     using RunCodeFuncType = void(*)(JitState*, CodePtr);
     RunCodeFuncType run_code = nullptr;
     void GenRunCode();
@@ -180,6 +440,14 @@ private:
     const void* return_from_run_code_without_mxcsr_switch = nullptr;
     void GenReturnFromRunCode();
 
+    // Direct-mapped cache of UniqueHash -> CodePtr consulted by the dispatcher.
+    static constexpr size_t FastDispatchTableSize = 0x1000; // MUST be a power of 2.
+    static size_t FastDispatchIndex(u64 unique_hash);
+    FastDispatchEntry* fast_dispatch_table = nullptr;
+    const void* dispatcher = nullptr;
+    const void* inline_cache_miss = nullptr;
+    void GenDispatcher();
+
     const void* read_memory_8 = nullptr;
     const void* read_memory_16 = nullptr;
     const void* read_memory_32 = nullptr;
@@ -201,6 +469,18 @@ private:
         std::unique_ptr<Impl> impl;
     };
     UnwindHandler unwind_handler;
+
+    class ExceptionHandler final {
+    public:
+        ExceptionHandler();
+        ~ExceptionHandler();
+
+        void Register(BlockOfCode* code, FaultCallback callback);
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+    };
+    ExceptionHandler exception_handler;
 };
 
 } // namespace BackendX64
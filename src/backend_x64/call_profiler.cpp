@@ -0,0 +1,75 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+
+#include "backend_x64/call_profiler.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+void CallProfiler::Call(u32 function, u32 return_address, u64 now) {
+    function &= ~u32(1);
+    if (stack.size() >= MaxDepth) {
+        // The outermost frame never returns as far as the profile is concerned.
+        --functions[stack.front().function].active_frames;
+        stack.pop_front();
+    }
+    stack.push_back({function, return_address & ~u32(1), now, 0});
+    ++functions[function].active_frames;
+}
+
+void CallProfiler::Return(u32 target, u64 now) {
+    target &= ~u32(1);
+    const auto frame = std::find_if(stack.rbegin(), stack.rend(), [target](const Frame& f) { return f.return_address == target; });
+    if (frame == stack.rend())
+        return;
+
+    // Frames inside the one being returned from were left without a return of their own.
+    const size_t depth = stack.rend() - frame;
+    while (stack.size() >= depth) {
+        PopFrame(now);
+    }
+}
+
+void CallProfiler::PopFrame(u64 now) {
+    const Frame frame = stack.back();
+    stack.pop_back();
+
+    const u64 inclusive = now - frame.entry;
+    FunctionInfo& info = functions[frame.function];
+    info.profile.entry = frame.function;
+    info.profile.calls++;
+    info.profile.exclusive_cycles += inclusive - std::min(inclusive, frame.callee_cycles);
+    if (--info.active_frames == 0) {
+        info.profile.inclusive_cycles += inclusive;
+    }
+
+    if (!stack.empty()) {
+        stack.back().callee_cycles += inclusive;
+    }
+}
+
+std::vector<GuestFunctionProfile> CallProfiler::GetProfile() const {
+    std::vector<GuestFunctionProfile> result;
+    for (const auto& entry : functions) {
+        if (entry.second.profile.calls != 0) {
+            result.push_back(entry.second.profile);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const GuestFunctionProfile& a, const GuestFunctionProfile& b) {
+        return a.exclusive_cycles != b.exclusive_cycles ? a.exclusive_cycles > b.exclusive_cycles : a.entry < b.entry;
+    });
+    return result;
+}
+
+void CallProfiler::Reset() {
+    stack.clear();
+    functions.clear();
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
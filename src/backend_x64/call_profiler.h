@@ -0,0 +1,56 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+#include "dynarmic/callbacks.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+/**
+ * Gathers the cycles spent in each guest function from the ProfileCall and ProfileReturn instructions
+ * of one Jit (see UserCallbacks::profile_guest_calls). Only used by the thread running that Jit.
+ */
+class CallProfiler final {
+public:
+    /// Calls deeper than this drop their outermost frames, e.g. for runaway recursion.
+    static constexpr size_t MaxDepth = 4096;
+
+    /// A call to function that returns to return_address, at cycle counter value `now`.
+    void Call(u32 function, u32 return_address, u64 now);
+    /// A return to target, which ends the innermost call returning there and the calls made from it.
+    void Return(u32 target, u64 now);
+
+    std::vector<GuestFunctionProfile> GetProfile() const;
+    void Reset();
+
+private:
+    struct Frame {
+        u32 function;
+        u32 return_address;
+        u64 entry;
+        u64 callee_cycles; ///< Inclusive cycles of the calls made from this one that have returned
+    };
+
+    struct FunctionInfo {
+        GuestFunctionProfile profile{};
+        size_t active_frames = 0; ///< Frames of this function on the stack; only the outermost counts as inclusive
+    };
+
+    void PopFrame(u64 now);
+
+    std::deque<Frame> stack;
+    std::unordered_map<u32, FunctionInfo> functions;
+};
+
+} // namespace BackendX64
+} // namespace Dynarmic
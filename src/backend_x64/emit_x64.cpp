@@ -4,14 +4,24 @@
  * General Public License version 2 or any later version.
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <dynarmic/coprocessor.h>
+#include <fmt/format.h>
 
 #include "backend_x64/abi.h"
 #include "backend_x64/block_of_code.h"
 #include "backend_x64/emit_x64.h"
 #include "backend_x64/jitstate.h"
+#include "backend_x64/perf_map.h"
 #include "common/assert.h"
 #include "common/bit_util.h"
 #include "frontend/arm/types.h"
@@ -19,6 +29,7 @@
 #include "frontend/ir/location_descriptor.h"
 #include "frontend/ir/microinstruction.h"
 #include "frontend/ir/opcodes.h"
+#include "ir_opt/passes.h"
 
 // TODO: Have ARM flags in host flags and not have them use up GPR registers unless necessary.
 // TODO: Actually implement that proper instruction selector you've always wanted to sweetheart.
@@ -41,6 +52,10 @@ static Xbyak::Address MJitStateExtReg(Arm::ExtReg reg) {
         size_t index = static_cast<size_t>(reg) - static_cast<size_t>(Arm::ExtReg::D0);
         return qword[r15 + offsetof(JitState, ExtReg) + sizeof(u64) * index];
     }
+    if (Arm::IsQuadExtReg(reg)) {
+        size_t index = static_cast<size_t>(reg) - static_cast<size_t>(Arm::ExtReg::Q0);
+        return xword[r15 + offsetof(JitState, ExtReg) + 2 * sizeof(u64) * index];
+    }
     ASSERT_MSG(false, "Should never happen.");
 }
 
@@ -54,21 +69,667 @@ static void EraseInstruction(IR::Block& block, IR::Inst* inst) {
     inst->Invalidate();
 }
 
-EmitX64::EmitX64(BlockOfCode* code, UserCallbacks cb, Jit* jit_interface)
-    : code(code), cb(cb), jit_interface(jit_interface) {
+// Host registers in which links pass guest registers to a register entrypoint, in order. These are
+// callee-saved, so that a passed value survives host calls made before the block uses it.
+static const std::array<HostLoc, 4> entry_register_hostlocs = {{HostLoc::RBX, HostLoc::RBP, HostLoc::R12, HostLoc::R13}};
+
+/// Whether inst may change guest core registers other than through SetRegister, e.g. by calling back into user code.
+static bool MayChangeCoreRegisters(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::BXWritePC:
+    case IR::Opcode::ReadMemoryToRegisters:
+        return true;
+    default:
+        return inst.CausesCPUException() || inst.IsCoprocessorInstruction();
+    }
+}
+
+/**
+ * Finds the first read of each guest register that happens before the block could change that register,
+ * up to one per entry_register_hostlocs. These reads can equally be done at the start of the block.
+ */
+static std::vector<IR::Inst*> FindEntryRegisterReads(IR::Block& block) {
+    std::vector<IR::Inst*> reads;
+    std::array<bool, 16> seen{};
+
+    for (auto& inst : block) {
+        if (reads.size() == entry_register_hostlocs.size() || MayChangeCoreRegisters(inst))
+            break;
+        if (inst.GetOpcode() != IR::Opcode::GetRegister && inst.GetOpcode() != IR::Opcode::SetRegister)
+            continue;
+
+        const Arm::Reg reg = inst.GetArg(0).GetRegRef();
+        if (inst.GetOpcode() == IR::Opcode::GetRegister && !seen[static_cast<size_t>(reg)] && reg != Arm::Reg::PC && inst.HasUses()) {
+            reads.push_back(&inst);
+        }
+        seen[static_cast<size_t>(reg)] = true;
+    }
+
+    return reads;
+}
+
+/// Finds the value each of `registers` has at the end of the block, or an empty value if it may have been changed outside of the IR.
+static std::vector<IR::Value> GetRegisterValuesAtExit(IR::Block& block, const std::vector<Arm::Reg>& registers) {
+    std::array<IR::Value, 16> values;
+
+    for (auto& inst : block) {
+        if (MayChangeCoreRegisters(inst)) {
+            values.fill({});
+            continue;
+        }
+
+        if (inst.GetOpcode() == IR::Opcode::SetRegister) {
+            values[static_cast<size_t>(inst.GetArg(0).GetRegRef())] = inst.GetArg(1);
+        } else if (inst.GetOpcode() == IR::Opcode::GetRegister) {
+            IR::Value& value = values[static_cast<size_t>(inst.GetArg(0).GetRegRef())];
+            if (value.IsEmpty()) {
+                value = IR::Value(&inst);
+            }
+        }
+    }
+
+    std::vector<IR::Value> result;
+    for (Arm::Reg reg : registers) {
+        result.push_back(values[static_cast<size_t>(reg)]);
+    }
+    return result;
+}
+
+/// Whether the emitter of inst reads argument `index` with RegAlloc::UseOpArg or UseDefOpArgGpr whenever it is not an immediate.
+static bool ReadsArgumentAsOperand(const IR::Block& block, const IR::Inst& inst, size_t index) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::AddWithCarry:
+    case IR::Opcode::SubWithCarry:
+    case IR::Opcode::And:
+    case IR::Opcode::Eor:
+    case IR::Opcode::Or:
+    case IR::Opcode::FPCompare32:
+    case IR::Opcode::FPCompare64:
+        return index == 1;
+    case IR::Opcode::Mul:
+        return index == 1 && !inst.GetArg(0).IsImmediate();
+    case IR::Opcode::AndNot:
+        return index == 0 && !inst.GetArg(1).IsImmediate();
+    case IR::Opcode::Pack2x32To1x64:
+    case IR::Opcode::SignExtendHalfToWord:
+    case IR::Opcode::SignExtendByteToWord:
+    case IR::Opcode::ZeroExtendHalfToWord:
+    case IR::Opcode::ZeroExtendByteToWord:
+        return index == 0;
+    case IR::Opcode::FPAdd32:
+    case IR::Opcode::FPAdd64:
+    case IR::Opcode::FPDiv32:
+    case IR::Opcode::FPDiv64:
+    case IR::Opcode::FPMul32:
+    case IR::Opcode::FPMul64:
+    case IR::Opcode::FPSub32:
+    case IR::Opcode::FPSub64:
+        // With FPSCR.FTZ the operand is checked for denormals in a register.
+        return index == 1 && !block.Location().FPSCR().FTZ();
+    default:
+        return false;
+    }
+}
+
+/// The bytes of JitState holding the guest register that inst reads or writes, as [first, last).
+static std::pair<size_t, size_t> GuestRegisterBytes(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::GetRegister:
+    case IR::Opcode::SetRegister: {
+        const size_t first = offsetof(JitState, Reg) + sizeof(u32) * static_cast<size_t>(inst.GetArg(0).GetRegRef());
+        return {first, first + sizeof(u32)};
+    }
+    default: {
+        const Arm::ExtReg reg = inst.GetArg(0).GetExtRegRef();
+        const size_t size = Arm::IsSingleExtReg(reg) ? 4 : Arm::IsDoubleExtReg(reg) ? 8 : 16;
+        const size_t first = offsetof(JitState, ExtReg) + size * Arm::RegNumber(reg);
+        return {first, first + size};
+    }
+    }
+}
+
+/**
+ * Finds the reads of guest registers whose only use can take the register straight from JitState as a
+ * memory operand (see ReadsArgumentAsOperand), because nothing in between may have changed it.
+ */
+static std::unordered_set<const IR::Inst*> FindFoldableRegisterReads(const IR::Block& block, const std::vector<IR::Inst*>& entry_register_reads) {
+    std::unordered_set<const IR::Inst*> foldable;
+    std::unordered_map<const IR::Inst*, std::pair<size_t, size_t>> pending;
+
+    for (const auto& inst : block) {
+        for (size_t i = 0; i < inst.NumArgs() && !pending.empty(); i++) {
+            const IR::Value arg = inst.GetArg(i);
+            if (arg.IsImmediate() || arg.IsEmpty())
+                continue;
+            const auto read = pending.find(arg.GetInst());
+            if (read == pending.end())
+                continue;
+            if (ReadsArgumentAsOperand(block, inst, i)) {
+                foldable.insert(read->first);
+            }
+            pending.erase(read);
+        }
+
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::GetRegister:
+        case IR::Opcode::GetExtendedRegister32:
+        case IR::Opcode::GetExtendedRegister64:
+            if (inst.UseCount() == 1 && std::find(entry_register_reads.begin(), entry_register_reads.end(), &inst) == entry_register_reads.end()) {
+                pending.emplace(&inst, GuestRegisterBytes(inst));
+            }
+            break;
+        case IR::Opcode::SetRegister:
+        case IR::Opcode::SetExtendedRegister32:
+        case IR::Opcode::SetExtendedRegister64:
+        case IR::Opcode::SetVector: {
+            const auto written = GuestRegisterBytes(inst);
+            for (auto iter = pending.begin(); iter != pending.end();) {
+                const bool overlaps = iter->second.first < written.second && written.first < iter->second.second;
+                iter = overlaps ? pending.erase(iter) : std::next(iter);
+            }
+            break;
+        }
+        case IR::Opcode::ReadMemoryToExtRegisters:
+        case IR::Opcode::SetCpsrAndSwitchMode:
+            pending.clear();
+            break;
+        default:
+            if (MayChangeCoreRegisters(inst)) {
+                pending.clear();
+            }
+            break;
+        }
+    }
+
+    return foldable;
+}
+
+/// Places `values`, the values of `registers` at the end of the block, in the host registers a register entrypoint expects them in.
+static void EmitPassRegisters(BlockOfCode* code, RegAlloc& reg_alloc, const std::vector<Arm::Reg>& registers, const std::vector<IR::Value>& values) {
+    for (size_t i = 0; i < registers.size(); i++) {
+        const HostLoc location = entry_register_hostlocs[i];
+        const IR::Value& value = values[i];
+
+        if (value.IsEmpty()) {
+            Xbyak::Reg32 reg = reg_alloc.ScratchGpr({location}).cvt32();
+            code->mov(reg, MJitStateReg(registers[i]));
+            continue;
+        }
+
+        if (!value.IsImmediate()) {
+            // Two guest registers may hold the same value, which a host register can only be in once.
+            const auto earlier = std::find_if(values.begin(), values.begin() + i, [&value](const IR::Value& other) {
+                return !other.IsEmpty() && !other.IsImmediate() && other.GetInst() == value.GetInst();
+            });
+            if (earlier != values.begin() + i) {
+                Xbyak::Reg32 reg = reg_alloc.ScratchGpr({location}).cvt32();
+                code->mov(reg, HostLocToReg64(entry_register_hostlocs[earlier - values.begin()]).cvt32());
+                value.GetInst()->DecrementRemainingUses();
+                continue;
+            }
+        }
+
+        reg_alloc.UseGpr(value, {location});
+    }
+
+    reg_alloc.EndOfAllocScope();
+}
+
+/**
+ * Packs the flags of `inst`, a SetNZCVFlagsAtExit, into their CPSR bit positions in a register that the
+ * terminal may use, without storing them. The register is not one that EmitPassRegisters places values in.
+ */
+static Xbyak::Reg32 EmitPackExitFlags(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst) {
+    const Xbyak::Reg32 packed = reg_alloc.ScratchGpr({HostLoc::RSI}).cvt32();
+    code->xor_(packed, packed);
+    for (size_t i = 0; i < 4; i++) {
+        const size_t flag_bit = 31 - i;
+        IR::Value arg = inst->GetArg(i);
+        if (arg.IsImmediate()) {
+            if (arg.GetU1())
+                code->or_(packed, u32(1u << flag_bit));
+            continue;
+        }
+
+        Xbyak::Reg32 flag = reg_alloc.UseScratchGpr(arg).cvt32();
+        code->shl(flag, flag_bit);
+        code->or_(packed, flag);
+    }
+    return packed;
+}
+
+/// The location a terminal links to when the block branches, with the registers placed before the terminal.
+static boost::optional<IR::LocationDescriptor> GetTakenLinkTarget(const IR::Terminal& terminal) {
+    if (auto link_block = boost::get<IR::Term::LinkBlock>(&terminal))
+        return link_block->next;
+    if (auto link_block_fast = boost::get<IR::Term::LinkBlockFast>(&terminal))
+        return link_block_fast->next;
+    if (auto if_ = boost::get<IR::Term::If>(&terminal))
+        return GetTakenLinkTarget(if_->then_);
+    if (auto check_halt = boost::get<IR::Term::CheckHalt>(&terminal))
+        return GetTakenLinkTarget(check_halt->else_);
+    return boost::none;
+}
+
+/**
+ * Whether block branches back to its own start through a LinkBlock, and nothing in it can call into user
+ * code or otherwise observe the guest state while it loops. Such a block is emitted as a host loop that
+ * keeps the guest registers it passes back to itself in host registers (see EmitNativeLoopTerminal).
+ */
+static bool IsNativeLoop(const IR::Block& block) {
+    if (block.GetCondition() != Arm::Cond::AL)
+        return false;
+
+    const IR::Terminal& terminal = block.GetTerminal();
+    const IR::Term::LinkBlock* back_edge = boost::get<IR::Term::LinkBlock>(&terminal);
+    if (const auto* if_ = boost::get<IR::Term::If>(&terminal)) {
+        back_edge = boost::get<IR::Term::LinkBlock>(&if_->then_);
+    }
+    if (!back_edge || back_edge->next != block.Location())
+        return false;
+
+    return std::none_of(block.begin(), block.end(), [](const IR::Inst& inst) {
+        return inst.IsMemoryReadOrWrite() || inst.CausesCPUException() || inst.IsCoprocessorInstruction()
+               || MayChangeCoreRegisters(inst) || inst.GetOpcode() == IR::Opcode::SkipSpinLoop
+               || inst.GetOpcode() == IR::Opcode::SideExit;
+    });
+}
+
+/**
+ * The FPCompare whose result the If terminal of block tests, when block copies it to the CPSR flags with
+ * VMRS APSR_nzcv, FPSCR: the last write of the CPSR is SetCpsr(Or(GetFpscrNZCV, And(GetCpsr, 0x0FFFFFFF)))
+ * and the last write of the FPSCR flags before that GetFpscrNZCV is the FPCompare. The terminal compares
+ * the operands again and branches on the host flags (see EmitFPCompareCond) rather than loading the CPSR.
+ */
+static IR::Inst* FindFPCompareBranch(IR::Block& block) {
+    const auto* if_ = boost::get<IR::Term::If>(&block.GetTerminal());
+    if (!if_ || if_->if_ == Arm::Cond::AL || if_->if_ == Arm::Cond::NV)
+        return nullptr;
+
+    const auto is_inst = [](const IR::Value& value, const IR::Inst* inst) {
+        return !value.IsImmediate() && value.GetInst() == inst;
+    };
+    const auto is_masked_cpsr = [](const IR::Value& value) {
+        if (value.IsImmediate() || value.GetInst()->GetOpcode() != IR::Opcode::And)
+            return false;
+        const IR::Inst* and_ = value.GetInst();
+        for (size_t i = 0; i < 2; i++) {
+            const IR::Value mask = and_->GetArg(i);
+            if (mask.IsImmediate() && mask.GetU32() == 0x0FFFFFFF)
+                return true;
+        }
+        return false;
+    };
+
+    IR::Inst* last_compare = nullptr;
+    const IR::Inst* nzcv_read = nullptr;
+    IR::Inst* nzcv_read_compare = nullptr;
+    IR::Inst* branch_compare = nullptr;
+    for (auto& inst : block) {
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::FPCompare32:
+        case IR::Opcode::FPCompare64:
+            last_compare = &inst;
+            break;
+        case IR::Opcode::SetFpscr:
+        case IR::Opcode::SetFpscrNZCV:
+            last_compare = nullptr;
+            break;
+        case IR::Opcode::GetFpscrNZCV:
+            nzcv_read = &inst;
+            nzcv_read_compare = last_compare;
+            break;
+        case IR::Opcode::SetCpsr: {
+            const IR::Value value = inst.GetArg(0);
+            branch_compare = nullptr;
+            if (value.IsImmediate() || value.GetInst()->GetOpcode() != IR::Opcode::Or)
+                break;
+            const IR::Inst* or_ = value.GetInst();
+            if ((is_inst(or_->GetArg(0), nzcv_read) && is_masked_cpsr(or_->GetArg(1))) || (is_inst(or_->GetArg(1), nzcv_read) && is_masked_cpsr(or_->GetArg(0)))) {
+                branch_compare = nzcv_read_compare;
+            }
+            break;
+        }
+        default:
+            if (inst.WritesToCPSR()) {
+                branch_compare = nullptr;
+            }
+            if (inst.CausesCPUException() || inst.IsCoprocessorInstruction()) {
+                // User code may change the guest state.
+                last_compare = nullptr;
+                nzcv_read_compare = nullptr;
+                branch_compare = nullptr;
+            }
+            break;
+        }
+    }
+
+    if (branch_compare && (branch_compare->GetArg(0).IsImmediate() || branch_compare->GetArg(1).IsImmediate()))
+        return nullptr;
+    return branch_compare;
+}
+
+/// The last SetRegister of reg in block, if nothing in the block reads reg after it.
+static IR::Inst* FindFinalRegisterStore(IR::Block& block, Arm::Reg reg) {
+    IR::Inst* last_store = nullptr;
+    for (auto& inst : block) {
+        if (inst.GetOpcode() != IR::Opcode::SetRegister && inst.GetOpcode() != IR::Opcode::GetRegister)
+            continue;
+        if (inst.GetArg(0).GetRegRef() != reg)
+            continue;
+        last_store = inst.GetOpcode() == IR::Opcode::SetRegister ? &inst : nullptr;
+    }
+    return last_store;
+}
+
+/// Whether guest memory is accessed through UserCallbacks::page_table or UserCallbacks::page_directory.
+static bool HasPageTable(const UserCallbacks& cb) {
+    return cb.page_table || cb.page_directory;
+}
+
+/**
+ * Finds the byte reversal of the value that `inst`, a memory read or write, reads or writes, as big-endian
+ * guest code does, if the inline access can do the reversal itself with movbe. The reversal must have no
+ * other use and, for a read, directly follow it. It is then not emitted by itself (see ReadMemory and
+ * WriteMemory). Accesses that can only go through the memory callbacks are left as they are.
+ */
+static IR::Inst* FindMovbeByteReverse(IR::Block& block, IR::Inst& inst, const UserCallbacks& cb) {
+    IR::Opcode reverse_opcode;
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::ReadMemory32:
+    case IR::Opcode::WriteMemory32:
+        reverse_opcode = IR::Opcode::ByteReverseWord;
+        break;
+    case IR::Opcode::ReadMemory64:
+    case IR::Opcode::WriteMemory64:
+        reverse_opcode = IR::Opcode::ByteReverseDual;
+        break;
+    case IR::Opcode::WriteMemory16:
+        // A movbe load of a halfword would leave the upper bits of the result unchanged, so only stores gain.
+        reverse_opcode = IR::Opcode::ByteReverseHalf;
+        break;
+    default:
+        return nullptr;
+    }
+    if (!cb.fastmem_pointer && !HasPageTable(cb))
+        return nullptr;
+    // Constant addresses may be bound to MMIO handlers, which are passed the value as it is.
+    if (cb.mmio_pages && inst.GetArg(0).IsImmediate())
+        return nullptr;
+
+    if (inst.IsMemoryRead()) {
+        if (inst.UseCount() != 1)
+            return nullptr;
+        const auto next = std::next(IR::Block::iterator(&inst));
+        if (next == block.end() || next->GetOpcode() != reverse_opcode || next->GetArg(0).IsImmediate() || next->GetArg(0).GetInst() != &inst)
+            return nullptr;
+        return &*next;
+    }
+
+    const IR::Value value = inst.GetArg(1);
+    if (value.IsImmediate() || value.GetInst()->GetOpcode() != reverse_opcode || value.GetInst()->UseCount() != 1)
+        return nullptr;
+    return value.GetInst();
+}
+
+EmitX64::EmitX64(BlockOfCode* code, UserCallbacks cb)
+    : code(code), cb(cb) {
+    ASSERT_MSG(Common::BitCount(cb.rsb_size) == 1 && cb.rsb_size <= JitState::MaxRSBSize,
+               "rsb_size must be a power of 2 no larger than %zu", JitState::MaxRSBSize);
+    ASSERT_MSG(cb.hot_block_threshold <= 0x7FFFFFFF, "hot_block_threshold must fit in a signed 32-bit immediate");
+    ASSERT_MSG(!cb.global_exclusive_monitor || cb.fastmem_pointer || HasPageTable(cb),
+               "global_exclusive_monitor requires fastmem_pointer, page_table or page_directory");
+    if (cb.fastmem_pointer) {
+        code->SetFaultCallback([this](CodePtr fault_location) { return HandleFastmemFault(fault_location); });
+    }
+    if (cb.detect_self_modifying_code) {
+        code_pages = std::make_unique<u8[]>(UserCallbacks::NUM_PAGE_TABLE_ENTRIES);
+    }
+    if (cb.WatchpointHit) {
+        watched_pages = std::make_unique<u8[]>(UserCallbacks::NUM_PAGE_TABLE_ENTRIES);
+    }
+}
+
+static void AppendLEB128(std::vector<u8>& out, u64 value) {
+    do {
+        const u8 byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(value != 0 ? byte | 0x80 : byte);
+    } while (value != 0);
+}
+
+static u64 ReadLEB128(const std::vector<u8>& in, size_t& pos) {
+    u64 value = 0;
+    for (size_t shift = 0; pos < in.size(); shift += 7) {
+        const u8 byte = in[pos++];
+        value |= u64(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+    }
+    return value;
 }
 
-EmitX64::BlockDescriptor EmitX64::Emit(IR::Block& block) {
+/**
+ * Collects the guest PC at each point of a block's host code where it changes, and encodes them as
+ * BlockDescriptor::guest_pc_map: pairs of the host offset delta and the zigzag-encoded guest PC delta,
+ * each as an LEB128. Host code before the first pair belongs to the block's start PC.
+ */
+class GuestPCMapBuilder final {
+public:
+    explicit GuestPCMapBuilder(u32 start_pc) : start_pc(start_pc) {}
+
+    void Record(size_t host_offset, u32 guest_pc) {
+        const u32 previous_pc = entries.empty() ? start_pc : entries.back().second;
+        if (guest_pc == previous_pc)
+            return;
+        if (!entries.empty() && entries.back().first == host_offset) {
+            entries.back().second = guest_pc; // The previous guest instruction emitted no host code.
+            return;
+        }
+        entries.emplace_back(host_offset, guest_pc);
+    }
+
+    std::vector<u8> Encode() const {
+        std::vector<u8> result;
+        size_t host_offset = 0;
+        u32 guest_pc = start_pc;
+        for (const auto& entry : entries) {
+            const u32 pc_delta = entry.second - guest_pc;
+            AppendLEB128(result, entry.first - host_offset);
+            AppendLEB128(result, (pc_delta << 1) ^ (0 - (pc_delta >> 31)));
+            host_offset = entry.first;
+            guest_pc = entry.second;
+        }
+        return result;
+    }
+
+private:
+    u32 start_pc;
+    std::vector<std::pair<size_t, u32>> entries;
+};
+
+/**
+ * Finds the shift of a register by one to three that `add` adds to its first operand, when the sum can be
+ * computed by a single `lea` with the shift as the index scale: neither has flag outputs, and the shift
+ * has no other use. The shift is then not emitted by itself (see EmitAddWithCarry).
+ */
+static IR::Inst* FindScaledIndex(IR::Inst& add) {
+    if (add.GetOpcode() != IR::Opcode::AddWithCarry)
+        return nullptr;
+    if (add.GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp) || add.GetAssociatedPseudoOperation(IR::Opcode::GetOverflowFromOp))
+        return nullptr;
+
+    const IR::Value base = add.GetArg(0);
+    const IR::Value index = add.GetArg(1);
+    const IR::Value carry_in = add.GetArg(2);
+    if (base.IsImmediate() || index.IsImmediate() || !carry_in.IsImmediate() || carry_in.GetU1())
+        return nullptr;
+
+    IR::Inst* shift = index.GetInst();
+    if (shift->GetOpcode() != IR::Opcode::LogicalShiftLeft || shift->UseCount() != 1 || shift->GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp))
+        return nullptr;
+    if (shift->GetArg(0).IsImmediate() || !shift->GetArg(1).IsImmediate() || shift->GetArg(1).GetU8() < 1 || shift->GetArg(1).GetU8() > 3)
+        return nullptr;
+    return shift;
+}
+
+EmitX64::BlockDescriptor EmitX64::Emit(IR::Block& block, Profiling profiling) {
+    const bool profile = profiling == Profiling::TierUp || profiling == Profiling::Count;
+    u64* execution_count = nullptr;
+    if (profile) {
+        ASSERT(cb.hot_block_threshold != 0);
+        code->align(sizeof(u64));
+        execution_count = static_cast<u64*>(code->AllocateFromCodeSpace(sizeof(u64)));
+        *execution_count = 0;
+    }
+
     code->align();
     const u8* const emitted_code_start_ptr = code->getCurr();
+    current_exit_counts = cb.count_exits ? AllocateCounters(ExitReasonCount) : nullptr;
+    current_link_counts.clear();
+
+    if (profile) {
+        EmitExecutionCount(execution_count, profiling);
+    }
+
+    std::vector<Arm::Reg> profiled_registers;
+    u64* register_profile = nullptr;
+    if (profiling == Profiling::TierUp && cb.specialize_register_values) {
+        profiled_registers = Optimization::FindEntryRegisters(block);
+        if (profiled_registers.size() > MaxProfiledRegisters)
+            profiled_registers.resize(MaxProfiledRegisters);
+    }
+    if (!profiled_registers.empty()) {
+        register_profile = AllocateCounters(profiled_registers.size() * 2);
+        EmitRegisterProfile(profiled_registers, register_profile);
+    }
+
+    if (block.HasBreakpoint()) {
+        EmitBreakpointCheck(block);
+    }
+
+    const bool guarded = !block.RegisterGuards().empty();
+    u64* guard_failures = nullptr;
+    if (guarded) {
+        guard_failures = AllocateCounters(1);
+        EmitRegisterGuards(block, guard_failures);
+    }
+
+    // Entrypoints past the guards would skip them. An isolated block returns after a single pass.
+    const bool native_loop = !profile && !block.HasBreakpoint() && !guarded && !emitting_isolated && IsNativeLoop(block);
 
     EmitCondPrelude(block);
 
     RegAlloc reg_alloc{code};
+    reg_alloc.AnalyzeBlock(block, [this](const IR::Inst& inst) { return IsHostCall(inst); });
+
+    // A block that is always entered at its start can also be entered by links that have already
+    // placed the guest registers it reads first in host registers, skipping the loads below.
+    // A native loop branches back to there with its registers in place, whatever the setting.
+    std::vector<IR::Inst*> entry_register_reads;
+    std::vector<Arm::Reg> entry_registers;
+    CodePtr register_entry_ptr = nullptr;
+    if ((cb.pass_registers_across_links || native_loop) && !profile && !block.HasBreakpoint() && !guarded && !emitting_isolated && block.GetCondition() == Arm::Cond::AL) {
+        entry_register_reads = FindEntryRegisterReads(block);
+        for (size_t i = 0; i < entry_register_reads.size(); i++) {
+            const Arm::Reg reg = entry_register_reads[i]->GetArg(0).GetRegRef();
+            code->mov(HostLocToReg64(entry_register_hostlocs[i]).cvt32(), MJitStateReg(reg));
+            reg_alloc.RegisterEntryValue(entry_register_reads[i], entry_register_hostlocs[i]);
+            entry_registers.push_back(reg);
+        }
+        if (!entry_registers.empty()) {
+            register_entry_ptr = code->getCurr();
+        }
+    }
+    const CodePtr loop_head = code->getCurr();
+
+    // The values passed to the register entrypoint this block links to are kept alive until the terminal.
+    boost::optional<RegisterLink> register_link;
+    std::vector<IR::Value> register_link_values;
+    if ((cb.pass_registers_across_links || native_loop) && !emitting_isolated) {
+        register_link = FindRegisterLink(block, register_entry_ptr, entry_registers);
+    }
+    if (register_link) {
+        register_link_values = GetRegisterValuesAtExit(block, register_link->registers);
+        for (const IR::Value& value : register_link_values) {
+            if (!value.IsEmpty() && !value.IsImmediate()) {
+                value.GetInst()->IncrementRemainingUses();
+            }
+        }
+    }
+
+    // The terminal compares the operands of the FP compare it branches on again, so they are kept alive until then.
+    IR::Inst* const fp_compare = native_loop ? nullptr : FindFPCompareBranch(block);
+    if (fp_compare) {
+        fp_compare->GetArg(0).GetInst()->IncrementRemainingUses();
+        fp_compare->GetArg(1).GetInst()->IncrementRemainingUses();
+    }
+
+    // Nothing can see the guest registers while a native loop runs, so the last store of each register it
+    // passes back to itself is left to the exits of the loop, which store it from its host register.
+    std::unordered_set<const IR::Inst*> deferred_stores;
+    std::vector<std::pair<Arm::Reg, HostLoc>> loop_exit_stores;
+    if (native_loop && register_link) {
+        for (size_t i = 0; i < register_link->registers.size(); i++) {
+            const Arm::Reg reg = register_link->registers[i];
+            if (const IR::Inst* store = FindFinalRegisterStore(block, reg)) {
+                deferred_stores.insert(store);
+                loop_exit_stores.emplace_back(reg, entry_register_hostlocs[i]);
+            }
+        }
+    }
+
+    // Every entrypoint of the block passes through here, so the guest MXCSR is switched in here if any
+    // instruction needs it. Integer-only code never switches it in.
+    if (BlockUsesGuestMxcsr(block)) {
+        EmitEnsureGuestMxcsr();
+    }
+
+    GuestPCMapBuilder guest_pc_map{block.Location().PC()};
+
+    // Counted after the uses added for register_link, so that a read passed to the next block is not folded.
+    const std::unordered_set<const IR::Inst*> foldable_reads = FindFoldableRegisterReads(block, entry_register_reads);
+    std::unordered_set<const IR::Inst*> fused_insts;
+    const bool use_movbe = cpu_info.has(Xbyak::util::Cpu::tMOVBE);
+    for (auto& inst : block) {
+        if (const IR::Inst* shift = FindScaledIndex(inst)) {
+            fused_insts.insert(shift);
+        }
+        if (const IR::Inst* reverse = use_movbe ? FindMovbeByteReverse(block, inst, cb) : nullptr) {
+            fused_insts.insert(reverse);
+        }
+    }
 
     for (auto iter = block.begin(); iter != block.end(); ++iter) {
         IR::Inst* inst = &*iter;
 
+        if (std::find(entry_register_reads.begin(), entry_register_reads.end(), inst) != entry_register_reads.end())
+            continue; // Already loaded at the start of the block
+
+        if (fused_insts.count(inst) != 0)
+            continue; // Emitted as part of another instruction (see FindScaledIndex and FindMovbeByteReverse)
+
+        if (deferred_stores.count(inst) != 0) {
+            // Stored at the exits of the loop instead
+            if (!inst->GetArg(1).IsImmediate()) {
+                inst->GetArg(1).GetInst()->DecrementRemainingUses();
+            }
+            continue;
+        }
+
+        if (foldable_reads.count(inst) != 0) {
+            // Read by its use instead
+            const bool is_core_register = inst->GetOpcode() == IR::Opcode::GetRegister;
+            reg_alloc.RegisterFoldedValue(inst, is_core_register ? MJitStateReg(inst->GetArg(0).GetRegRef()) : MJitStateExtReg(inst->GetArg(0).GetExtRegRef()));
+            continue;
+        }
+
+        if (cb.guest_pc_map) {
+            guest_pc_map.Record(static_cast<size_t>(code->getCurr() - emitted_code_start_ptr), inst->GuestPC());
+        }
+
+        reg_alloc.SetCurrentInstruction(inst);
+
         // Call the relevant Emit* member function.
         switch (inst->GetOpcode()) {
 
@@ -87,21 +748,114 @@ EmitX64::BlockDescriptor EmitX64::Emit(IR::Block& block) {
         reg_alloc.EndOfAllocScope();
     }
 
+    // Packed in the same allocation scope as the registers are passed, so neither overwrites the other.
+    const auto exit_flags = std::find_if(block.begin(), block.end(), [](const IR::Inst& inst) { return inst.GetOpcode() == IR::Opcode::SetNZCVFlagsAtExit; });
+    if (exit_flags != block.end()) {
+        exit_nzcv = EmitPackExitFlags(code, reg_alloc, &*exit_flags);
+    }
+    if (fp_compare) {
+        const Xbyak::Xmm a = reg_alloc.UseXmm(fp_compare->GetArg(0));
+        const Xbyak::Xmm b = reg_alloc.UseXmm(fp_compare->GetArg(1));
+        fp_compare_branch = FPCompareBranch{fp_compare->GetOpcode() == IR::Opcode::FPCompare64, a, b};
+    }
+    if (register_link) {
+        EmitPassRegisters(code, reg_alloc, register_link->registers, register_link_values);
+    }
+    reg_alloc.EndOfAllocScope();
+
     reg_alloc.AssertNoMoreUses();
 
-    EmitAddCycles(block.CycleCount());
-    EmitTerminal(block.GetTerminal(), block.Location());
+    if (native_loop) {
+        EmitNativeLoopTerminal(block, loop_head, loop_exit_stores);
+    } else {
+        EmitAddCycles(block.CycleCount());
+        current_register_link = register_link;
+        EmitTerminal(block.GetTerminal(), block.Location());
+        current_register_link = boost::none;
+    }
+    exit_nzcv = boost::none;
+    fp_compare_branch = boost::none;
     code->int3();
 
-    const IR::LocationDescriptor descriptor = block.Location();
-    Patch(descriptor, emitted_code_start_ptr);
+    // Code past the end of either area would have overwritten that of other blocks.
+    code->AssertWithinCurrentRegion();
 
-    EmitX64::BlockDescriptor& block_desc = block_descriptors[descriptor.UniqueHash()];
+    const IR::LocationDescriptor descriptor = block.Location();
     size_t emitted_code_size = static_cast<size_t>(code->getCurr() - emitted_code_start_ptr);
-    block_desc = {emitted_code_start_ptr, emitted_code_size};
+    // A block that can return to the dispatcher on entry, to tier up or on a failed guard, may not have flags left unstored for it.
+    const bool discards_nzcv = profiling != Profiling::TierUp && !guarded && Optimization::DiscardsNZCVOnEntry(block);
+    if (!cb.pass_registers_across_links) {
+        // Only the block's own loop enters it with registers.
+        register_entry_ptr = nullptr;
+        entry_registers.clear();
+    }
+    EmitX64::BlockDescriptor block_desc{emitted_code_start_ptr, emitted_code_size, descriptor, block.GuestRanges(), profiling, execution_count, register_entry_ptr, entry_registers, discards_nzcv, guest_pc_map.Encode(), current_exit_counts, std::move(current_link_counts),
+                                      std::move(profiled_registers), register_profile, guard_failures};
+    current_link_counts.clear();
+
+    if (emitting_isolated) {
+        // Writes to its guest code are still detected, so that the caller can discard it.
+        MarkCodePages(block_desc.guest_ranges);
+        return block_desc;
+    }
+
+    block_descriptors.emplace(descriptor.UniqueHash(), block_desc);
+
+    if (cb.perf_map) {
+        PerfMapRegister(emitted_code_start_ptr, emitted_code_size, fmt::format("dynarmic_{:08x}_{:016x}", descriptor.PC(), descriptor.UniqueHash()));
+    }
+
+    if (concurrent_execution) {
+        deferred_links.emplace_back(descriptor);
+    } else {
+        Patch(descriptor, emitted_code_start_ptr);
+    }
+
+    if (concurrent_execution) {
+        code->SetFastDispatchEntryIfUnused(descriptor.UniqueHash(), emitted_code_start_ptr);
+    } else {
+        code->SetFastDispatchEntry(descriptor.UniqueHash(), emitted_code_start_ptr);
+    }
+
+    for (const auto& range : block_desc.guest_ranges) {
+        if (range.first == range.second)
+            continue;
+        const u32 first_page = range.first >> GUEST_PAGE_BITS;
+        const u32 last_page = (range.second - 1) >> GUEST_PAGE_BITS;
+        for (u32 page = first_page; page <= last_page; page++) {
+            block_ranges[page].insert(descriptor.UniqueHash());
+        }
+    }
+    MarkCodePages(block_desc.guest_ranges);
+
+    return block_desc;
+}
+
+EmitX64::BlockDescriptor EmitX64::EmitIsolated(IR::Block& block) {
+    emitting_isolated = true;
+    const BlockDescriptor block_desc = Emit(block, Profiling::None);
+    emitting_isolated = false;
     return block_desc;
 }
 
+boost::optional<EmitX64::RegisterLink> EmitX64::FindRegisterLink(const IR::Block& block, CodePtr own_register_entry_ptr, const std::vector<Arm::Reg>& own_entry_registers) const {
+    const auto target = GetTakenLinkTarget(block.GetTerminal());
+    if (!target)
+        return boost::none;
+
+    // The block being emitted is not in the cache yet, but a loop may link back to it.
+    if (*target == block.Location()) {
+        if (!own_register_entry_ptr)
+            return boost::none;
+        return RegisterLink{*target, own_register_entry_ptr, own_entry_registers};
+    }
+
+    const auto target_block = GetBasicBlock(*target);
+    if (!target_block || !target_block->register_entry_ptr)
+        return boost::none;
+    return RegisterLink{*target, target_block->register_entry_ptr, target_block->entry_registers};
+}
+
 boost::optional<EmitX64::BlockDescriptor> EmitX64::GetBasicBlock(IR::LocationDescriptor descriptor) const {
     auto iter = block_descriptors.find(descriptor.UniqueHash());
     if (iter == block_descriptors.end())
@@ -109,6 +863,69 @@ boost::optional<EmitX64::BlockDescriptor> EmitX64::GetBasicBlock(IR::LocationDes
     return boost::make_optional<BlockDescriptor>(iter->second);
 }
 
+std::vector<EmitX64::BlockDescriptor> EmitX64::GetCountedBlocks() const {
+    std::vector<BlockDescriptor> result;
+    for (const auto& iter : block_descriptors) {
+        if (iter.second.profiling == Profiling::Count)
+            result.push_back(iter.second);
+    }
+    std::sort(result.begin(), result.end(), [](const BlockDescriptor& a, const BlockDescriptor& b) {
+        return *a.execution_count > *b.execution_count;
+    });
+    return result;
+}
+
+std::vector<EmitX64::BlockDescriptor> EmitX64::GetBlocks() const {
+    std::vector<BlockDescriptor> result;
+    result.reserve(block_descriptors.size());
+    for (const auto& iter : block_descriptors) {
+        result.push_back(iter.second);
+    }
+    std::sort(result.begin(), result.end(), [](const BlockDescriptor& a, const BlockDescriptor& b) {
+        return a.code_ptr < b.code_ptr;
+    });
+    return result;
+}
+
+boost::optional<u32> EmitX64::HostPcToGuestPc(CodePtr host_pc) const {
+    const u8* ptr = static_cast<const u8*>(host_pc);
+
+    for (const auto& iter : block_descriptors) {
+        const BlockDescriptor& block = iter.second;
+        const u8* block_begin = static_cast<const u8*>(block.code_ptr);
+        if (ptr < block_begin || ptr >= block_begin + block.size)
+            continue;
+
+        const size_t target_offset = static_cast<size_t>(ptr - block_begin);
+        size_t host_offset = 0;
+        u32 guest_pc = block.start_location.PC();
+        for (size_t pos = 0; pos < block.guest_pc_map.size();) {
+            host_offset += static_cast<size_t>(ReadLEB128(block.guest_pc_map, pos));
+            const u32 zigzag = static_cast<u32>(ReadLEB128(block.guest_pc_map, pos));
+            if (host_offset > target_offset)
+                break;
+            guest_pc += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        }
+        return guest_pc;
+    }
+
+    return boost::none;
+}
+
+std::vector<EmitX64::BlockSamples> EmitX64::CountSamples(const std::vector<CodePtr>& host_pcs) const {
+    std::vector<BlockSamples> result;
+    for (const auto& iter : block_descriptors) {
+        const BlockDescriptor& block = iter.second;
+        const u8* block_begin = static_cast<const u8*>(block.code_ptr);
+        const auto first = std::lower_bound(host_pcs.begin(), host_pcs.end(), block.code_ptr, std::less<const void*>());
+        const auto last = std::lower_bound(first, host_pcs.end(), static_cast<CodePtr>(block_begin + block.size), std::less<const void*>());
+        if (first != last) {
+            result.push_back({block.start_location, block.profiling, static_cast<size_t>(last - first)});
+        }
+    }
+    return result;
+}
+
 void EmitX64::EmitBreakpoint(RegAlloc&, IR::Block&, IR::Inst*) {
     code->int3();
 }
@@ -140,6 +957,17 @@ void EmitX64::EmitGetExtendedRegister64(RegAlloc& reg_alloc, IR::Block&, IR::Ins
     code->movsd(result, MJitStateExtReg(reg));
 }
 
+void EmitX64::EmitGetVector(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
+    ASSERT(Arm::IsDoubleExtReg(reg) || Arm::IsQuadExtReg(reg));
+    Xbyak::Xmm result = reg_alloc.DefXmm(inst);
+    if (Arm::IsDoubleExtReg(reg)) {
+        code->movq(result, MJitStateExtReg(reg));
+    } else {
+        code->movups(result, MJitStateExtReg(reg));
+    }
+}
+
 void EmitX64::EmitSetRegister(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     Arm::Reg reg = inst->GetArg(0).GetRegRef();
     IR::Value arg = inst->GetArg(1);
@@ -165,6 +993,17 @@ void EmitX64::EmitSetExtendedRegister64(RegAlloc& reg_alloc, IR::Block&, IR::Ins
     code->movsd(MJitStateExtReg(reg), source);
 }
 
+void EmitX64::EmitSetVector(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
+    ASSERT(Arm::IsDoubleExtReg(reg) || Arm::IsQuadExtReg(reg));
+    Xbyak::Xmm source = reg_alloc.UseXmm(inst->GetArg(1));
+    if (Arm::IsDoubleExtReg(reg)) {
+        code->movq(MJitStateExtReg(reg), source);
+    } else {
+        code->movups(MJitStateExtReg(reg), source);
+    }
+}
+
 void EmitX64::EmitGetCpsr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
     code->mov(result, MJitStateCpsr());
@@ -175,6 +1014,32 @@ void EmitX64::EmitSetCpsr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     code->mov(MJitStateCpsr(), arg);
 }
 
+static void SetCpsrAndSwitchModeFallback(JitState* jit_state, u32 value) {
+    jit_state->SetCpsrAndSwitchMode(value);
+}
+
+void EmitX64::EmitSetCpsrAndSwitchMode(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    reg_alloc.HostCall(nullptr, {}, inst->GetArg(0));
+    code->mov(code->ABI_PARAM1, r15);
+    code->CallFunction(&SetCpsrAndSwitchModeFallback);
+}
+
+void EmitX64::EmitGetSpsr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+    code->mov(result, dword[r15 + offsetof(JitState, Spsr)]);
+}
+
+void EmitX64::EmitSetSpsr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    Xbyak::Reg32 arg = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+    code->mov(dword[r15 + offsetof(JitState, Spsr)], arg);
+}
+
 void EmitX64::EmitGetNFlag(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
     code->mov(result, MJitStateCpsr());
@@ -278,17 +1143,81 @@ void EmitX64::EmitSetVFlag(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     }
 }
 
-void EmitX64::EmitOrQFlag(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    constexpr size_t flag_bit = 27;
-    constexpr u32 flag_mask = 1u << flag_bit;
-    IR::Value arg = inst->GetArg(0);
-    if (arg.IsImmediate()) {
-        if (arg.GetU1())
-            code->or_(MJitStateCpsr(), flag_mask);
-    } else {
-        Xbyak::Reg32 to_store = reg_alloc.UseScratchGpr(arg).cvt32();
+/// Writes the flags in args to consecutive CPSR bits, starting with bit 31, with a single store to the CPSR.
+static void EmitSetFlags(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst) {
+    const size_t flag_count = inst->NumArgs();
 
-        code->shl(to_store, flag_bit);
+    u32 flag_mask = 0;
+    u32 immediate_flags = 0;
+    boost::optional<Xbyak::Reg32> flags;
+    for (size_t i = 0; i < flag_count; i++) {
+        const size_t flag_bit = 31 - i;
+        IR::Value arg = inst->GetArg(i);
+        flag_mask |= 1u << flag_bit;
+        if (arg.IsImmediate()) {
+            if (arg.GetU1())
+                immediate_flags |= 1u << flag_bit;
+            continue;
+        }
+
+        Xbyak::Reg32 to_store = reg_alloc.UseScratchGpr(arg).cvt32();
+        code->shl(to_store, flag_bit);
+        if (flags) {
+            code->or_(*flags, to_store);
+        } else {
+            flags = to_store;
+        }
+    }
+
+    Xbyak::Reg32 cpsr = reg_alloc.ScratchGpr().cvt32();
+    code->mov(cpsr, MJitStateCpsr());
+    code->and_(cpsr, ~flag_mask);
+    if (immediate_flags)
+        code->or_(cpsr, immediate_flags);
+    if (flags)
+        code->or_(cpsr, *flags);
+    code->mov(MJitStateCpsr(), cpsr);
+}
+
+void EmitX64::EmitSetNZFlags(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitSetFlags(code, reg_alloc, inst);
+}
+
+void EmitX64::EmitSetNZCFlags(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitSetFlags(code, reg_alloc, inst);
+}
+
+void EmitX64::EmitSetNZCVFlags(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitSetFlags(code, reg_alloc, inst);
+}
+
+void EmitX64::EmitSetNZCVFlagsAtExit(RegAlloc&, IR::Block&, IR::Inst*) {
+    // The flags are packed before the terminal, which stores them on the exits that need them.
+}
+
+void EmitX64::EmitStoreExitNZCV() {
+    code->and_(MJitStateCpsr(), u32(0x0FFFFFFF));
+    code->or_(MJitStateCpsr(), *exit_nzcv);
+}
+
+bool EmitX64::MayLinkWithExitNZCV(const IR::LocationDescriptor& target) const {
+    if (!exit_nzcv)
+        return true;
+    const auto block = block_descriptors.find(target.UniqueHash());
+    return block != block_descriptors.end() && block->second.discards_nzcv;
+}
+
+void EmitX64::EmitOrQFlag(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    constexpr size_t flag_bit = 27;
+    constexpr u32 flag_mask = 1u << flag_bit;
+    IR::Value arg = inst->GetArg(0);
+    if (arg.IsImmediate()) {
+        if (arg.GetU1())
+            code->or_(MJitStateCpsr(), flag_mask);
+    } else {
+        Xbyak::Reg32 to_store = reg_alloc.UseScratchGpr(arg).cvt32();
+
+        code->shl(to_store, flag_bit);
         code->or_(MJitStateCpsr(), to_store);
     }
 }
@@ -318,6 +1247,57 @@ void EmitX64::EmitSetGEFlags(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     }
 }
 
+static bool ConditionPassesForNZCV(Arm::Cond cond, u32 nzcv) {
+    const bool n = Common::Bit<3>(nzcv);
+    const bool z = Common::Bit<2>(nzcv);
+    const bool c = Common::Bit<1>(nzcv);
+    const bool v = Common::Bit<0>(nzcv);
+
+    switch (cond) {
+    case Arm::Cond::EQ: return z;
+    case Arm::Cond::NE: return !z;
+    case Arm::Cond::CS: return c;
+    case Arm::Cond::CC: return !c;
+    case Arm::Cond::MI: return n;
+    case Arm::Cond::PL: return !n;
+    case Arm::Cond::VS: return v;
+    case Arm::Cond::VC: return !v;
+    case Arm::Cond::HI: return c && !z;
+    case Arm::Cond::LS: return !c || z;
+    case Arm::Cond::GE: return n == v;
+    case Arm::Cond::LT: return n != v;
+    case Arm::Cond::GT: return !z && n == v;
+    case Arm::Cond::LE: return z || n != v;
+    case Arm::Cond::AL:
+    case Arm::Cond::NV:
+        return true;
+    }
+    ASSERT_MSG(false, "Unknown cond %zu", static_cast<size_t>(cond));
+    return false;
+}
+
+void EmitX64::EmitTestCondition(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    const Arm::Cond cond = static_cast<Arm::Cond>(inst->GetArg(0).GetU8());
+
+    // Bit n of pass_mask is set if the condition passes when NZCV is n.
+    u32 pass_mask = 0;
+    for (u32 nzcv = 0; nzcv < 16; nzcv++) {
+        if (ConditionPassesForNZCV(cond, nzcv)) {
+            pass_mask |= 1u << nzcv;
+        }
+    }
+
+    Xbyak::Reg32 nzcv = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+    code->mov(nzcv, MJitStateCpsr());
+    code->shr(nzcv, 28);
+    code->mov(result, pass_mask);
+    code->bt(result, nzcv);
+    code->setc(result.cvt8());
+    code->movzx(result, result.cvt8());
+}
+
 void EmitX64::EmitBXWritePC(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     const u32 T_bit = 1 << 5;
     auto arg = inst->GetArg(0);
@@ -363,42 +1343,195 @@ void EmitX64::EmitBXWritePC(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     }
 }
 
-void EmitX64::EmitCallSupervisor(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+void EmitX64::EmitCallSupervisor(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
     auto imm32 = inst->GetArg(0);
 
+    // The immediate is known at translation time, so a handler registered for it can be called directly.
+    void (*handler)(u32) = cb.CallSVC;
+    if (cb.svc_handlers && imm32.GetU32() < UserCallbacks::NUM_SVC_HANDLERS) {
+        void (*svc_handler)(u32) = (*cb.svc_handlers)[imm32.GetU32()];
+        if (svc_handler)
+            handler = svc_handler;
+    }
+
     reg_alloc.HostCall(nullptr, imm32);
 
     code->SwitchMxcsrOnExit();
-    code->CallFunction(cb.CallSVC);
-    code->SwitchMxcsrOnEntry();
+    code->CallCallback(CallbackKind::Supervisor, handler);
+    if (BlockUsesGuestMxcsr(block)) {
+        code->SwitchMxcsrOnEntry();
+    }
 }
 
-static u32 GetFpscrImpl(JitState* jit_state) {
-    return jit_state->Fpscr();
+void EmitX64::EmitCallHostFunction(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const auto host_function = reinterpret_cast<HostFunction>(inst->GetArg(0).GetU64());
+
+    reg_alloc.HostCall();
+
+    code->mov(code->ABI_PARAM1, qword[r15 + offsetof(JitState, jit_interface)]);
+    code->mov(code->ABI_PARAM2, qword[r15 + offsetof(JitState, user_arg)]);
+    code->SwitchMxcsrOnExit();
+    code->CallFunction(host_function);
+    if (BlockUsesGuestMxcsr(block)) {
+        code->SwitchMxcsrOnEntry();
+    }
 }
 
-void EmitX64::EmitGetFpscr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    reg_alloc.HostCall(inst);
-    code->mov(code->ABI_PARAM1, code->r15);
+void EmitX64::EmitCallHint(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const u8 hint = inst->GetArg(0).GetU8();
 
+    reg_alloc.HostCall();
+
+    code->mov(code->ABI_PARAM1.cvt32(), u32(hint));
+    code->mov(code->ABI_PARAM2, qword[r15 + offsetof(JitState, jit_interface)]);
+    code->mov(code->ABI_PARAM3, qword[r15 + offsetof(JitState, user_arg)]);
     code->SwitchMxcsrOnExit();
-    code->CallFunction(&GetFpscrImpl);
-    code->SwitchMxcsrOnEntry();
+    code->CallFunction(cb.CallHint);
+    if (BlockUsesGuestMxcsr(block)) {
+        code->SwitchMxcsrOnEntry();
+    }
+}
+
+void EmitX64::EmitSkipSpinLoop(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label end;
+
+    if (!inst->GetArg(0).IsImmediate()) {
+        Xbyak::Reg32 taken = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+        code->test(taken, taken);
+        code->jz(end);
+    }
+    // The terminal then finds no cycles remaining and returns from Jit::Run.
+    code->mov(qword[r15 + offsetof(JitState, cycles_remaining)], 0);
+    code->inc(qword[r15 + offsetof(JitState, spin_loops_skipped)]);
+    code->L(end);
 }
 
-static void SetFpscrImpl(u32 value, JitState* jit_state) {
-    jit_state->SetFpscr(value);
+void EmitX64::EmitGetCycleCounter(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const u32 cycles_before = inst->GetArg(0).GetU32();
+    Xbyak::Reg64 result = reg_alloc.DefGpr(inst);
+
+    code->mov(result, qword[r15 + offsetof(JitState, cycle_counter_base)]);
+    code->sub(result, qword[r15 + offsetof(JitState, cycles_remaining)]);
+    if (cycles_before != 0) {
+        code->add(result.cvt32(), cycles_before);
+    }
 }
 
-void EmitX64::EmitSetFpscr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    auto a = inst->GetArg(0);
+void EmitX64::EmitSideExit(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    const IR::Value taken = inst->GetArg(0);
+    const IR::LocationDescriptor target = block.Location().SetPC(inst->GetArg(1).GetU32());
+    const u32 cycles = inst->GetArg(2).GetU32();
 
-    reg_alloc.HostCall(nullptr, a);
-    code->mov(code->ABI_PARAM2, code->r15);
+    if (taken.IsImmediate() && !taken.GetU1())
+        return;
 
-    code->SwitchMxcsrOnExit();
-    code->CallFunction(&SetFpscrImpl);
-    code->SwitchMxcsrOnEntry();
+    Xbyak::Label stay;
+    if (!taken.IsImmediate()) {
+        Xbyak::Reg32 taken_reg = reg_alloc.UseGpr(taken).cvt32();
+        code->test(taken_reg, taken_reg);
+        code->jz(stay, code->T_NEAR);
+    }
+    // The guest state is stored up to this point (see GetSetElimination), and the exit never comes back
+    // to the block, so it can leave the way a failed block condition does (see EmitCondPrelude).
+    EmitAddCycles(cycles);
+    EmitTerminalLinkBlock(IR::Term::LinkBlock{target}, block.Location());
+    code->L(stay);
+}
+
+void EmitX64::EmitGetFpscr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+    Xbyak::Reg32 tmp = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Label mxcsr_saved;
+
+    // The cumulative exception flags are only up to date in MXCSR itself while the guest MXCSR is current.
+    code->cmp(code->byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    code->je(mxcsr_saved);
+    code->stmxcsr(dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    code->L(mxcsr_saved);
+
+    // This must match JitState::Fpscr.
+    code->mov(result, dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    code->mov(tmp, result);
+    code->and_(result, u32(0b0000000000001)); // IOC = IE
+    code->and_(tmp, u32(0b0000000111100));
+    code->shr(tmp, 1);                         // IXC, UFC, OFC, DZC = PE, UE, OE, ZE
+    code->or_(result, tmp);
+    code->or_(result, dword[r15 + offsetof(JitState, FPSCR_mode)]);
+    code->or_(result, dword[r15 + offsetof(JitState, FPSCR_nzcv)]);
+    code->or_(result, dword[r15 + offsetof(JitState, FPSCR_IDC)]);
+    code->or_(result, dword[r15 + offsetof(JitState, FPSCR_UFC)]);
+}
+
+void EmitX64::EmitSetFpscr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    Xbyak::Reg32 value = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+    Xbyak::Reg32 mxcsr = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Reg32 tmp = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Label mxcsr_saved, unchanged;
+
+    // Bring guest_MXCSR up to date so it can be compared against below.
+    code->cmp(code->byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    code->je(mxcsr_saved);
+    code->stmxcsr(dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    code->L(mxcsr_saved);
+
+    // This must match JitState::SetFpscr.
+    code->mov(dword[r15 + offsetof(JitState, old_FPSCR)], value);
+    code->mov(tmp, value);
+    code->and_(tmp, IR::LocationDescriptor::FPSCR_MODE_MASK);
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_mode)], tmp);
+    code->mov(tmp, value);
+    code->and_(tmp, u32(0xF0000000));
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_nzcv)], tmp);
+    code->mov(tmp, value);
+    code->and_(tmp, u32(1 << 7));
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_IDC)], tmp);
+    code->mov(tmp, value);
+    code->and_(tmp, u32(1 << 3));
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_UFC)], tmp);
+
+    code->mov(mxcsr, value);
+    code->and_(mxcsr, u32(0b0000000000001));  // IE = IOC
+    code->or_(mxcsr, u32(0x00001f80));        // mask all
+    code->lea(tmp, ptr[value.cvt64() + value.cvt64()]);
+    code->and_(tmp, u32(0b0000000111100));
+    code->or_(mxcsr, tmp);                    // PE, UE, OE, ZE = IXC, UFC, OFC, DZC
+    code->mov(tmp, value);
+    code->shr(tmp, 8);
+    code->and_(tmp, u32(0x4000));
+    code->or_(mxcsr, tmp);                    // RC bit 14 = RMode bit 22
+    code->mov(tmp, value);
+    code->shr(tmp, 10);
+    code->and_(tmp, u32(0x2000));
+    code->or_(mxcsr, tmp);                    // RC bit 13 = RMode bit 23
+    code->mov(tmp, value);
+    code->shr(tmp, 9);
+    code->and_(tmp, u32(1 << 15));
+    code->or_(mxcsr, tmp);                    // FTZ = FZ
+    code->mov(tmp, value);
+    code->shr(tmp, 18);
+    code->and_(tmp, u32(1 << 6));
+    code->or_(mxcsr, tmp);                    // DAZ = FZ
+
+    // Guest code commonly writes back the FPSCR it read earlier, so MXCSR is only reloaded if it changes.
+    code->cmp(mxcsr, dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    code->je(unchanged);
+    code->mov(dword[r15 + offsetof(JitState, guest_MXCSR)], mxcsr);
+    code->cmp(code->byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    code->je(unchanged);
+    code->ldmxcsr(dword[r15 + offsetof(JitState, guest_MXCSR)]);
+    code->L(unchanged);
 }
 
 void EmitX64::EmitGetFpscrNZCV(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
@@ -426,7 +1559,7 @@ void EmitX64::EmitPushRSB(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     auto iter = block_descriptors.find(unique_hash_of_target);
     CodePtr target_code_ptr = iter != block_descriptors.end()
                             ? iter->second.code_ptr
-                            : code->GetReturnFromRunCodeAddress();
+                            : code->GetDispatcherAddress();
 
     Xbyak::Reg64 code_ptr_reg = reg_alloc.ScratchGpr({HostLoc::RCX});
     Xbyak::Reg64 loc_desc_reg = reg_alloc.ScratchGpr();
@@ -434,23 +1567,40 @@ void EmitX64::EmitPushRSB(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
 
     code->mov(index_reg, dword[r15 + offsetof(JitState, rsb_ptr)]);
     code->add(index_reg, 1);
-    code->and_(index_reg, u32(JitState::RSBSize - 1));
+    code->and_(index_reg, u32(cb.rsb_size - 1));
 
     code->mov(loc_desc_reg, unique_hash_of_target);
 
-    patch_information[unique_hash_of_target].mov_rcx.emplace_back(code->getCurr());
+    AddPatchSite(unique_hash_of_target, PatchType::MovRcx);
     EmitPatchMovRcx(target_code_ptr);
 
-    Xbyak::Label label;
-    for (size_t i = 0; i < JitState::RSBSize; ++i) {
-        code->cmp(loc_desc_reg, qword[r15 + offsetof(JitState, rsb_location_descriptors) + i * sizeof(u64)]);
-        code->je(label, code->T_SHORT);
-    }
-
     code->mov(dword[r15 + offsetof(JitState, rsb_ptr)], index_reg);
     code->mov(qword[r15 + index_reg.cvt64() * 8 + offsetof(JitState, rsb_location_descriptors)], loc_desc_reg);
     code->mov(qword[r15 + index_reg.cvt64() * 8 + offsetof(JitState, rsb_codeptrs)], code_ptr_reg);
-    code->L(label);
+}
+
+static void ProfileCallFallback(JitState* jit_state, u32 function, u32 return_address, u32 cycles_before) {
+    jit_state->ProfileCall(function, return_address, cycles_before);
+}
+
+static void ProfileReturnFallback(JitState* jit_state, u32 target, u32 cycles_before) {
+    jit_state->ProfileReturn(target, cycles_before);
+}
+
+void EmitX64::EmitProfileCall(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    reg_alloc.HostCall(nullptr, {}, inst->GetArg(0), inst->GetArg(1), inst->GetArg(2));
+    code->mov(code->ABI_PARAM1, r15);
+    code->CallFunction(&ProfileCallFallback);
+}
+
+void EmitX64::EmitProfileReturn(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    reg_alloc.HostCall(nullptr, {}, inst->GetArg(0), inst->GetArg(1));
+    code->mov(code->ABI_PARAM1, r15);
+    code->CallFunction(&ProfileReturnFallback);
 }
 
 void EmitX64::EmitGetCarryFromOp(RegAlloc&, IR::Block&, IR::Inst*) {
@@ -538,11 +1688,26 @@ void EmitX64::EmitIsZero64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     code->movzx(result, result.cvt8());
 }
 
+static void EmitConditionalSelect(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst) {
+    Xbyak::Reg32 cond = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+    Xbyak::Reg32 then_ = reg_alloc.UseGpr(inst->GetArg(1)).cvt32();
+    Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(2), inst).cvt32();
+
+    code->test(cond, cond);
+    code->cmovnz(result, then_);
+}
+
+void EmitX64::EmitConditionalSelect32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitConditionalSelect(code, reg_alloc, inst);
+}
+
+void EmitX64::EmitConditionalSelect1(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitConditionalSelect(code, reg_alloc, inst);
+}
+
 void EmitX64::EmitLogicalShiftLeft(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
     auto carry_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp);
 
-    // TODO: Consider using BMI2 instructions like SHLX when arm-in-host flags is implemented.
-
     if (!carry_inst) {
         if (!inst->GetArg(2).IsImmediate()) {
             // TODO: Remove redundant argument.
@@ -560,6 +1725,18 @@ void EmitX64::EmitLogicalShiftLeft(RegAlloc& reg_alloc, IR::Block& block, IR::In
             } else {
                 code->xor_(result, result);
             }
+        } else if (cpu_info.has(Xbyak::util::Cpu::tBMI2)) {
+            Xbyak::Reg32 shift = reg_alloc.UseGpr(shift_arg).cvt32();
+            Xbyak::Reg32 operand = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+            Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+            Xbyak::Reg32 zero = reg_alloc.ScratchGpr().cvt32();
+
+            // SHLX masks the shift count like SHL does, but the count can be in any register.
+
+            code->shlx(result, operand, shift);
+            code->xor_(zero, zero);
+            code->cmp(shift.cvt8(), 32);
+            code->cmovnb(result, zero);
         } else {
             Xbyak::Reg8 shift = reg_alloc.UseGpr(shift_arg, {HostLoc::RCX}).cvt8();
             Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
@@ -652,6 +1829,18 @@ void EmitX64::EmitLogicalShiftRight(RegAlloc& reg_alloc, IR::Block& block, IR::I
             } else {
                 code->xor_(result, result);
             }
+        } else if (cpu_info.has(Xbyak::util::Cpu::tBMI2)) {
+            Xbyak::Reg32 shift = reg_alloc.UseGpr(shift_arg).cvt32();
+            Xbyak::Reg32 operand = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+            Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+            Xbyak::Reg32 zero = reg_alloc.ScratchGpr().cvt32();
+
+            // SHRX masks the shift count like SHR does, but the count can be in any register.
+
+            code->shrx(result, operand, shift);
+            code->xor_(zero, zero);
+            code->cmp(shift.cvt8(), 32);
+            code->cmovnb(result, zero);
         } else {
             Xbyak::Reg8 shift = reg_alloc.UseGpr(shift_arg, {HostLoc::RCX}).cvt8();
             Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
@@ -752,6 +1941,18 @@ void EmitX64::EmitArithmeticShiftRight(RegAlloc& reg_alloc, IR::Block& block, IR
             Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
 
             code->sar(result, u8(shift < 31 ? shift : 31));
+        } else if (cpu_info.has(Xbyak::util::Cpu::tBMI2)) {
+            Xbyak::Reg32 shift = reg_alloc.UseScratchGpr(shift_arg).cvt32();
+            Xbyak::Reg32 operand = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+            Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+            Xbyak::Reg32 const31 = reg_alloc.ScratchGpr().cvt32();
+
+            // As below, shift counts above 31 are saturated to 31. SARX can take the count in any register.
+            code->mov(const31, 31);
+            code->movzx(shift, shift.cvt8());
+            code->cmp(shift, u32(31));
+            code->cmovg(shift, const31);
+            code->sarx(result, operand, shift);
         } else {
             Xbyak::Reg32 shift = reg_alloc.UseScratchGpr(shift_arg, {HostLoc::RCX}).cvt32();
             Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
@@ -829,7 +2030,14 @@ void EmitX64::EmitRotateRight(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* i
 
         auto shift_arg = inst->GetArg(1);
 
-        if (shift_arg.IsImmediate()) {
+        if (shift_arg.IsImmediate() && cpu_info.has(Xbyak::util::Cpu::tBMI2)) {
+            u8 shift = shift_arg.GetU8();
+            Xbyak::Reg32 operand = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+            Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+            // RORX does not modify the source or the flags.
+            code->rorx(result, operand, u8(shift & 0x1F));
+        } else if (shift_arg.IsImmediate()) {
             u8 shift = shift_arg.GetU8();
             Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
 
@@ -919,6 +2127,102 @@ static Xbyak::Reg8 DoCarry(RegAlloc& reg_alloc, const IR::Value& carry_in, IR::I
     }
 }
 
+/**
+ * An AddWithCarry or SubWithCarry that directly follows one of the same kind and takes its carry in from
+ * it, as Optimization::CarryChainFusion arranges. It is emitted together with the first, taking the carry
+ * from the host carry flag, so all its registers are allocated before the first is emitted.
+ */
+struct CarryChainSuccessor {
+    IR::Inst* inst = nullptr;
+    Xbyak::Reg32 result;
+    OpArg op_arg;
+    IR::Inst* carry_inst = nullptr;
+    IR::Inst* overflow_inst = nullptr;
+    Xbyak::Reg8 carry;
+    Xbyak::Reg8 overflow;
+};
+
+static IR::Inst* FindCarryChainSuccessor(IR::Block& block, IR::Inst* inst, IR::Inst* carry_inst) {
+    if (!carry_inst)
+        return nullptr;
+
+    const auto is_own_pseudo_operation = [inst](const IR::Inst& other) {
+        return (other.GetOpcode() == IR::Opcode::GetCarryFromOp || other.GetOpcode() == IR::Opcode::GetOverflowFromOp) && other.GetArg(0).GetInst() == inst;
+    };
+
+    auto iter = std::next(IR::Block::iterator(inst));
+    while (iter != block.end() && is_own_pseudo_operation(*iter))
+        ++iter;
+    if (iter == block.end() || iter->GetOpcode() != inst->GetOpcode())
+        return nullptr;
+
+    const IR::Value carry_in = iter->GetArg(2);
+    if (carry_in.IsImmediate() || carry_in.GetInst() != carry_inst)
+        return nullptr;
+    for (size_t i = 0; i < 2; i++) {
+        const IR::Value arg = iter->GetArg(i);
+        if (!arg.IsImmediate() && (arg.GetInst() == inst || is_own_pseudo_operation(*arg.GetInst())))
+            return nullptr;
+    }
+    return &*iter;
+}
+
+static CarryChainSuccessor AllocateCarryChainSuccessor(RegAlloc& reg_alloc, IR::Inst* inst, IR::Inst* carry_inst) {
+    CarryChainSuccessor next;
+    next.inst = inst;
+    next.carry_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp);
+    next.overflow_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetOverflowFromOp);
+
+    next.result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
+    if (!inst->GetArg(1).IsImmediate()) {
+        next.op_arg = reg_alloc.UseOpArg(inst->GetArg(1), any_gpr);
+        next.op_arg.setBit(32);
+    }
+    next.carry = next.carry_inst ? reg_alloc.DefGpr(next.carry_inst).cvt8() : INVALID_REG.cvt8();
+    next.overflow = next.overflow_inst ? reg_alloc.DefGpr(next.overflow_inst).cvt8() : INVALID_REG.cvt8();
+
+    // Its carry in is taken from the host carry flag rather than from a register.
+    carry_inst->DecrementRemainingUses();
+    return next;
+}
+
+/// Emits `next` directly after the operation it takes its carry from, which has left the carry in the host carry flag.
+static void EmitCarryChainSuccessor(BlockOfCode* code, IR::Block& block, CarryChainSuccessor& next) {
+    const IR::Value b = next.inst->GetArg(1);
+    if (next.inst->GetOpcode() == IR::Opcode::AddWithCarry) {
+        if (b.IsImmediate()) {
+            code->adc(next.result, b.GetU32());
+        } else {
+            code->adc(next.result, *next.op_arg);
+        }
+    } else {
+        // The host carry flag is the inverse of the ARM carry flag here, as sbb expects.
+        if (b.IsImmediate()) {
+            code->sbb(next.result, b.GetU32());
+        } else {
+            code->sbb(next.result, *next.op_arg);
+        }
+    }
+
+    if (next.carry_inst) {
+        EraseInstruction(block, next.carry_inst);
+
+        if (next.inst->GetOpcode() == IR::Opcode::AddWithCarry) {
+            code->setc(next.carry);
+        } else {
+            code->setnc(next.carry);
+        }
+    }
+    if (next.overflow_inst) {
+        EraseInstruction(block, next.overflow_inst);
+
+        code->seto(next.overflow);
+    }
+
+    // Already emitted, so the emission loop must not reach it. Its arguments have been used up above.
+    block.Instructions().erase(next.inst);
+}
+
 void EmitX64::EmitAddWithCarry(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
     auto carry_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp);
     auto overflow_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetOverflowFromOp);
@@ -927,11 +2231,39 @@ void EmitX64::EmitAddWithCarry(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     IR::Value b = inst->GetArg(1);
     IR::Value carry_in = inst->GetArg(2);
 
+    if (IR::Inst* shift = FindScaledIndex(*inst)) {
+        // The shift was skipped, so its uses are consumed here.
+        if (!shift->GetArg(2).IsImmediate()) {
+            shift->GetArg(2).GetInst()->DecrementRemainingUses();
+        }
+        shift->DecrementRemainingUses();
+
+        Xbyak::Reg64 base = reg_alloc.UseGpr(a);
+        Xbyak::Reg64 index = reg_alloc.UseGpr(shift->GetArg(0));
+        Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+        code->lea(result, code->ptr[base + index * (1 << shift->GetArg(1).GetU8())]);
+        return;
+    }
+    if (!carry_inst && !overflow_inst && !a.IsImmediate() && b.IsImmediate() && carry_in.IsImmediate()) {
+        // Only the low 32 bits of the sum are kept, so the immediate can be taken as signed.
+        const s32 displacement = static_cast<s32>(b.GetU32() + (carry_in.GetU1() ? 1 : 0));
+        Xbyak::Reg64 base = reg_alloc.UseGpr(a);
+        Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+        code->lea(result, code->ptr[base + displacement]);
+        return;
+    }
+
+    // A carry passed on only to the next operation in its chain is not materialized.
+    IR::Inst* const next_inst = FindCarryChainSuccessor(block, inst, carry_inst);
+    IR::Inst* const stored_carry_inst = next_inst && carry_inst->UseCount() == 1 ? nullptr : carry_inst;
+
     Xbyak::Reg32 result = reg_alloc.UseDefGpr(a, inst).cvt32();
-    Xbyak::Reg8 carry = DoCarry(reg_alloc, carry_in, carry_inst);
+    Xbyak::Reg8 carry = DoCarry(reg_alloc, carry_in, stored_carry_inst);
     Xbyak::Reg8 overflow = overflow_inst ? reg_alloc.DefGpr(overflow_inst).cvt8() : INVALID_REG.cvt8();
+    CarryChainSuccessor next = next_inst ? AllocateCarryChainSuccessor(reg_alloc, next_inst, carry_inst) : CarryChainSuccessor();
 
-    // TODO: Consider using LEA.
 
     if (b.IsImmediate()) {
         u32 op_arg = b.GetU32();
@@ -965,13 +2297,18 @@ void EmitX64::EmitAddWithCarry(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     if (carry_inst) {
         EraseInstruction(block, carry_inst);
 
-        code->setc(carry);
+        if (stored_carry_inst) {
+            code->setc(carry);
+        }
     }
     if (overflow_inst) {
         EraseInstruction(block, overflow_inst);
 
         code->seto(overflow);
     }
+    if (next.inst) {
+        EmitCarryChainSuccessor(code, block, next);
+    }
 }
 
 void EmitX64::EmitAdd64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
@@ -992,11 +2329,25 @@ void EmitX64::EmitSubWithCarry(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     IR::Value b = inst->GetArg(1);
     IR::Value carry_in = inst->GetArg(2);
 
+    if (!carry_inst && !overflow_inst && !a.IsImmediate() && b.IsImmediate() && carry_in.IsImmediate()) {
+        // a + ~b + carry_in, of which only the low 32 bits are kept.
+        const s32 displacement = static_cast<s32>(~b.GetU32() + (carry_in.GetU1() ? 1 : 0));
+        Xbyak::Reg64 base = reg_alloc.UseGpr(a);
+        Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+        code->lea(result, code->ptr[base + displacement]);
+        return;
+    }
+
+    // A carry passed on only to the next operation in its chain is not materialized.
+    IR::Inst* const next_inst = FindCarryChainSuccessor(block, inst, carry_inst);
+    IR::Inst* const stored_carry_inst = next_inst && carry_inst->UseCount() == 1 ? nullptr : carry_inst;
+
     Xbyak::Reg32 result = reg_alloc.UseDefGpr(a, inst).cvt32();
-    Xbyak::Reg8 carry = DoCarry(reg_alloc, carry_in, carry_inst);
+    Xbyak::Reg8 carry = DoCarry(reg_alloc, carry_in, stored_carry_inst);
     Xbyak::Reg8 overflow = overflow_inst ? reg_alloc.DefGpr(overflow_inst).cvt8() : INVALID_REG.cvt8();
+    CarryChainSuccessor next = next_inst ? AllocateCarryChainSuccessor(reg_alloc, next_inst, carry_inst) : CarryChainSuccessor();
 
-    // TODO: Consider using LEA.
     // TODO: Optimize CMP case.
     // Note that x64 CF is inverse of what the ARM carry flag is here.
 
@@ -1034,13 +2385,18 @@ void EmitX64::EmitSubWithCarry(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     if (carry_inst) {
         EraseInstruction(block, carry_inst);
 
-        code->setnc(carry);
+        if (stored_carry_inst) {
+            code->setnc(carry);
+        }
     }
     if (overflow_inst) {
         EraseInstruction(block, overflow_inst);
 
         code->seto(overflow);
     }
+    if (next.inst) {
+        EmitCarryChainSuccessor(code, block, next);
+    }
 }
 
 void EmitX64::EmitSub64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
@@ -1080,6 +2436,52 @@ void EmitX64::EmitMul64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     code->imul(result, *op_arg);
 }
 
+void EmitX64::EmitSignedDiv(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    // idiv takes its dividend in rdx:rax and leaves the quotient in rax.
+    reg_alloc.ScratchGpr({HostLoc::RAX});
+    reg_alloc.ScratchGpr({HostLoc::RDX});
+    Xbyak::Reg32 dividend = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+    Xbyak::Reg64 divisor = reg_alloc.UseScratchGpr(inst->GetArg(1));
+    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+    using namespace Xbyak::util;
+
+    // ARM defines division by zero to give zero. Dividing in 64 bits means INT_MIN / -1 does not
+    // fault, and its low word is INT_MIN as ARM requires.
+    Xbyak::Label end;
+    code->xor_(result, result);
+    code->movsxd(divisor, divisor.cvt32());
+    code->test(divisor, divisor);
+    code->jz(end);
+    code->movsxd(rax, dividend);
+    code->cqo();
+    code->idiv(divisor);
+    code->mov(result, eax);
+    code->L(end);
+}
+
+void EmitX64::EmitUnsignedDiv(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    // div takes its dividend in edx:eax and leaves the quotient in eax.
+    reg_alloc.ScratchGpr({HostLoc::RAX});
+    reg_alloc.ScratchGpr({HostLoc::RDX});
+    Xbyak::Reg32 dividend = reg_alloc.UseGpr(inst->GetArg(0)).cvt32();
+    Xbyak::Reg32 divisor = reg_alloc.UseGpr(inst->GetArg(1)).cvt32();
+    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+
+    using namespace Xbyak::util;
+
+    // ARM defines division by zero to give zero.
+    Xbyak::Label end;
+    code->xor_(result, result);
+    code->test(divisor, divisor);
+    code->jz(end);
+    code->mov(eax, dividend);
+    code->xor_(edx, edx);
+    code->div(divisor);
+    code->mov(result, eax);
+    code->L(end);
+}
+
 void EmitX64::EmitAnd(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
@@ -1098,6 +2500,31 @@ void EmitX64::EmitAnd(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     }
 }
 
+void EmitX64::EmitAndNot(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    IR::Value a = inst->GetArg(0);
+    IR::Value b = inst->GetArg(1);
+
+    if (b.IsImmediate()) {
+        Xbyak::Reg32 result = reg_alloc.UseDefGpr(a, inst).cvt32();
+
+        code->and_(result, u32(~b.GetU32()));
+    } else if (cpu_info.has(Xbyak::util::Cpu::tBMI1)) {
+        Xbyak::Reg32 not_operand = reg_alloc.UseGpr(b).cvt32();
+        OpArg op_arg = reg_alloc.UseOpArg(a, any_gpr);
+        Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
+        op_arg.setBit(32);
+
+        code->andn(result, not_operand, *op_arg);
+    } else {
+        Xbyak::Reg32 result = reg_alloc.UseDefGpr(b, inst).cvt32();
+        OpArg op_arg = reg_alloc.UseOpArg(a, any_gpr);
+        op_arg.setBit(32);
+
+        code->not_(result);
+        code->and_(result, *op_arg);
+    }
+}
+
 void EmitX64::EmitEor(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
@@ -1256,6 +2683,25 @@ void EmitX64::EmitByteReverseDual(RegAlloc& reg_alloc, IR::Block&, IR::Inst* ins
     code->bswap(result);
 }
 
+void EmitX64::EmitBitReverseWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Reg32 result = reg_alloc.UseDefGpr(inst->GetArg(0), inst).cvt32();
+    Xbyak::Reg32 tmp = reg_alloc.ScratchGpr().cvt32();
+
+    // x64 has no bit reversal: reverse the bytes, then swap nibbles, bit pairs and bits within them.
+    const auto swap_groups = [&](int group_bits, u32 low_mask) {
+        code->mov(tmp, result);
+        code->shr(tmp, group_bits);
+        code->and_(tmp, low_mask);
+        code->and_(result, low_mask);
+        code->shl(result, group_bits);
+        code->or_(result, tmp);
+    };
+    code->bswap(result);
+    swap_groups(4, 0x0F0F0F0F);
+    swap_groups(2, 0x33333333);
+    swap_groups(1, 0x55555555);
+}
+
 void EmitX64::EmitCountLeadingZeros(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     IR::Value a = inst->GetArg(0);
 
@@ -1399,24 +2845,18 @@ void EmitX64::EmitSignedSaturation(RegAlloc& reg_alloc, IR::Block& block, IR::In
 }
 
 /**
- * Extracts the most significant bits from each of the packed bytes, and packs them together.
+ * Extracts the most significant bits from each of the four low packed bytes of an Xmm register, and packs them together.
+ * For the result of a packed 16-bit comparison this duplicates the bit of each word, as the GE flags require.
  *
- *     value before:    a-------b-------c-------d-------
- *     value after:     0000000000000000000000000000abcd
+ *     value before:    ...a-------b-------c-------d-------
+ *     result after:    0000000000000000000000000000abcd
  *
- * @param value The register containing the value to operate on. Result will be stored in the same register.
- * @param a_tmp A register which can be used as a scratch register.
+ * @param result The register the packed bits are stored in.
+ * @param value The register containing the value to operate on. Its upper twelve bytes are ignored.
  */
-static void ExtractMostSignificantBitFromPackedBytes(const Xbyak::util::Cpu& cpu_info, BlockOfCode* code, RegAlloc& reg_alloc, Xbyak::Reg32 value, boost::optional<Xbyak::Reg32> a_tmp = boost::none) {
-    if (cpu_info.has(Xbyak::util::Cpu::tBMI2)) {
-        Xbyak::Reg32 tmp = a_tmp ? *a_tmp : reg_alloc.ScratchGpr().cvt32();
-        code->mov(tmp, 0x80808080);
-        code->pext(value, value, tmp);
-    } else {
-        code->and_(value, 0x80808080);
-        code->imul(value, value, 0x00204081);
-        code->shr(value, 28);
-    }
+static void ExtractMostSignificantBitFromPackedBytes(BlockOfCode* code, Xbyak::Reg32 result, Xbyak::Xmm value) {
+    code->pmovmskb(result, value);
+    code->and_(result, 0xF);
 }
 
 /**
@@ -1440,36 +2880,34 @@ void EmitX64::EmitPackedAddU8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* i
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
 
-    Xbyak::Reg32 reg_a = reg_alloc.UseScratchGpr(a).cvt32();
-    Xbyak::Reg32 reg_b = reg_alloc.UseScratchGpr(b).cvt32();
-    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
-    Xbyak::Reg32 reg_ge, tmp;
+    Xbyak::Reg32 reg_a = reg_alloc.UseDefGpr(a, inst).cvt32();
+    Xbyak::Reg32 reg_b = reg_alloc.UseGpr(b).cvt32();
+    Xbyak::Reg32 reg_ge;
+
+    Xbyak::Xmm xmm_a = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_b = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_ge;
 
     if (ge_inst) {
         EraseInstruction(block, ge_inst);
 
         reg_ge = reg_alloc.DefGpr(ge_inst).cvt32();
-        tmp = reg_alloc.ScratchGpr().cvt32();
-
-        code->mov(reg_ge, reg_a);
-        code->and_(reg_ge, reg_b);
+        xmm_ge = reg_alloc.ScratchXmm();
     }
 
-    // SWAR Arithmetic
-    code->mov(result, reg_a);
-    code->xor_(result, reg_b);
-    code->and_(result, 0x80808080);
-    code->and_(reg_a, 0x7F7F7F7F);
-    code->and_(reg_b, 0x7F7F7F7F);
-    code->add(reg_a, reg_b);
+    code->movd(xmm_a, reg_a);
+    code->movd(xmm_b, reg_b);
     if (ge_inst) {
-        code->mov(tmp, result);
-        code->and_(tmp, reg_a);
-        code->or_(reg_ge, tmp);
+        code->movdqa(xmm_ge, xmm_a);
+        code->paddusb(xmm_ge, xmm_b);
     }
-    code->xor_(result, reg_a);
+    code->paddb(xmm_a, xmm_b);
+    code->movd(reg_a, xmm_a);
     if (ge_inst) {
-        ExtractMostSignificantBitFromPackedBytes(cpu_info, code, reg_alloc, reg_ge, tmp);
+        // Only the bytes that carried out saturate, so those are the ones that differ from the sum.
+        code->pcmpeqb(xmm_ge, xmm_a);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
+        code->xor_(reg_ge, 0xF);
     }
 }
 
@@ -1498,14 +2936,11 @@ void EmitX64::EmitPackedAddS8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* i
         Xbyak::Xmm saturated_sum = reg_alloc.ScratchXmm();
         code->movdqa(saturated_sum, xmm_a);
         code->paddsb(saturated_sum, xmm_b);
-        code->movd(reg_ge, saturated_sum);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, saturated_sum);
+        code->xor_(reg_ge, 0xF);
     }
     code->paddb(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
-    if (ge_inst) {
-        code->not_(reg_ge);
-        ExtractMostSignificantBitFromPackedBytes(cpu_info, code, reg_alloc, reg_ge);
-    }
 }
 
 void EmitX64::EmitPackedAddU16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
@@ -1514,36 +2949,34 @@ void EmitX64::EmitPackedAddU16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
 
-    Xbyak::Reg32 reg_a = reg_alloc.UseScratchGpr(a).cvt32();
-    Xbyak::Reg32 reg_b = reg_alloc.UseScratchGpr(b).cvt32();
-    Xbyak::Reg32 result = reg_alloc.DefGpr(inst).cvt32();
-    Xbyak::Reg32 reg_ge, tmp;
+    Xbyak::Reg32 reg_a = reg_alloc.UseDefGpr(a, inst).cvt32();
+    Xbyak::Reg32 reg_b = reg_alloc.UseGpr(b).cvt32();
+    Xbyak::Reg32 reg_ge;
+
+    Xbyak::Xmm xmm_a = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_b = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_ge;
 
     if (ge_inst) {
         EraseInstruction(block, ge_inst);
 
         reg_ge = reg_alloc.DefGpr(ge_inst).cvt32();
-
-        code->mov(reg_ge, reg_a);
-        code->and_(reg_ge, reg_b);
+        xmm_ge = reg_alloc.ScratchXmm();
     }
 
-    // SWAR Arithmetic
-    code->mov(result, reg_a);
-    code->xor_(result, reg_b);
-    code->and_(result, 0x80008000);
-    code->and_(reg_a, 0x7FFF7FFF);
-    code->and_(reg_b, 0x7FFF7FFF);
-    code->add(reg_a, reg_b);
+    code->movd(xmm_a, reg_a);
+    code->movd(xmm_b, reg_b);
     if (ge_inst) {
-        tmp = reg_alloc.ScratchGpr().cvt32();
-        code->mov(tmp, result);
-        code->and_(tmp, reg_a);
-        code->or_(reg_ge, tmp);
+        code->movdqa(xmm_ge, xmm_a);
+        code->paddusw(xmm_ge, xmm_b);
     }
-    code->xor_(result, reg_a);
+    code->paddw(xmm_a, xmm_b);
+    code->movd(reg_a, xmm_a);
     if (ge_inst) {
-        ExtractAndDuplicateMostSignificantBitFromPackedWords(code, reg_ge);
+        // Only the words that carried out saturate, so those are the ones that differ from the sum.
+        code->pcmpeqw(xmm_ge, xmm_a);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
+        code->xor_(reg_ge, 0xF);
     }
 }
 
@@ -1572,14 +3005,12 @@ void EmitX64::EmitPackedAddS16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         Xbyak::Xmm saturated_sum = reg_alloc.ScratchXmm();
         code->movdqa(saturated_sum, xmm_a);
         code->paddsw(saturated_sum, xmm_b);
-        code->movd(reg_ge, saturated_sum);
+        code->psraw(saturated_sum, 15);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, saturated_sum);
+        code->xor_(reg_ge, 0xF);
     }
     code->paddw(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
-    if (ge_inst) {
-        code->not_(reg_ge);
-        ExtractAndDuplicateMostSignificantBitFromPackedWords(code, reg_ge);
-    }
 }
 
 void EmitX64::EmitPackedSubU8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
@@ -1609,17 +3040,12 @@ void EmitX64::EmitPackedSubU8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* i
         code->movdqa(xmm_ge, xmm_a);
         code->pmaxub(xmm_ge, xmm_b);
         code->pcmpeqb(xmm_ge, xmm_a);
-        code->movd(reg_ge, xmm_ge);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
     }
     code->psubb(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
-
-    if (ge_inst) {
-        ExtractMostSignificantBitFromPackedBytes(cpu_info, code, reg_alloc, reg_ge);
-    }
 }
 
-
 void EmitX64::EmitPackedSubS8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
     auto ge_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetGEFromOp);
 
@@ -1644,14 +3070,11 @@ void EmitX64::EmitPackedSubS8(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* i
         Xbyak::Xmm xmm_ge = reg_alloc.ScratchXmm();
         code->movdqa(xmm_ge, xmm_a);
         code->psubsb(xmm_ge, xmm_b);
-        code->movd(reg_ge, xmm_ge);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
+        code->xor_(reg_ge, 0xF);
     }
     code->psubb(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
-    if (ge_inst) {
-        code->not_(reg_ge);
-        ExtractMostSignificantBitFromPackedBytes(cpu_info, code, reg_alloc, reg_ge);
-    }
 }
 
 void EmitX64::EmitPackedSubU16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
@@ -1678,16 +3101,22 @@ void EmitX64::EmitPackedSubU16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     code->movd(xmm_a, reg_a);
     code->movd(xmm_b, reg_b);
     if (ge_inst) {
-        code->movdqa(xmm_ge, xmm_a);
-        code->pmaxuw(xmm_ge, xmm_b);
-        code->pcmpeqw(xmm_ge, xmm_a);
-        code->movd(reg_ge, xmm_ge);
+        if (cpu_info.has(Xbyak::util::Cpu::tSSE41)) {
+            code->movdqa(xmm_ge, xmm_a);
+            code->pmaxuw(xmm_ge, xmm_b);
+            code->pcmpeqw(xmm_ge, xmm_a);
+        } else {
+            // b - a saturates to zero exactly when a >= b.
+            Xbyak::Xmm zero = reg_alloc.ScratchXmm();
+            code->movdqa(xmm_ge, xmm_b);
+            code->psubusw(xmm_ge, xmm_a);
+            code->pxor(zero, zero);
+            code->pcmpeqw(xmm_ge, zero);
+        }
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
     }
     code->psubw(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
-    if (ge_inst) {
-        ExtractAndDuplicateMostSignificantBitFromPackedWords(code, reg_ge);
-    }
 }
 
 void EmitX64::EmitPackedSubS16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
@@ -1715,70 +3144,187 @@ void EmitX64::EmitPackedSubS16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         Xbyak::Xmm xmm_ge = reg_alloc.ScratchXmm();
         code->movdqa(xmm_ge, xmm_a);
         code->psubsw(xmm_ge, xmm_b);
-        code->movd(reg_ge, xmm_ge);
+        code->psraw(xmm_ge, 15);
+        ExtractMostSignificantBitFromPackedBytes(code, reg_ge, xmm_ge);
+        code->xor_(reg_ge, 0xF);
     }
     code->psubw(xmm_a, xmm_b);
     code->movd(reg_a, xmm_a);
+}
+
+/**
+ * Emits PackedSubAdd with SSE4.1: the halves of b are swapped so that both the sums and the differences
+ * can be computed lane-wise, and the lane needed from each is then blended together.
+ */
+static void EmitPackedSubAddSSE41(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool is_signed) {
+    auto ge_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetGEFromOp);
+
+    IR::Value a = inst->GetArg(0);
+    IR::Value b = inst->GetArg(1);
+    bool asx = inst->GetArg(2).GetU1();
+
+    // PBLENDW takes the words selected by this mask from the differences.
+    const u8 diff_mask = asx ? 0b01 : 0b10;
+
+    Xbyak::Reg32 reg_a = reg_alloc.UseDefGpr(a, inst).cvt32();
+    Xbyak::Reg32 reg_b = reg_alloc.UseGpr(b).cvt32();
+    Xbyak::Reg32 reg_ge;
+
+    Xbyak::Xmm xmm_a = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_b = reg_alloc.ScratchXmm();
+    Xbyak::Xmm xmm_sum = reg_alloc.ScratchXmm();
+
     if (ge_inst) {
-        code->not_(reg_ge);
-        ExtractAndDuplicateMostSignificantBitFromPackedWords(code, reg_ge);
+        EraseInstruction(block, ge_inst);
+
+        reg_ge = reg_alloc.DefGpr(ge_inst).cvt32();
+    }
+
+    code->movd(xmm_a, reg_a);
+    code->movd(xmm_b, reg_b);
+    code->pshuflw(xmm_b, xmm_b, 0b11100001);
+
+    if (ge_inst) {
+        Xbyak::Xmm ge_sum = reg_alloc.ScratchXmm();
+        Xbyak::Xmm ge_diff = reg_alloc.ScratchXmm();
+
+        code->movdqa(ge_sum, xmm_a);
+        code->movdqa(ge_diff, xmm_a);
+        if (is_signed) {
+            // Saturation preserves the sign of each result, which is the inverse of its GE bit.
+            code->paddsw(ge_sum, xmm_b);
+            code->psubsw(ge_diff, xmm_b);
+            code->pblendw(ge_sum, ge_diff, diff_mask);
+            code->psraw(ge_sum, 15);
+            ExtractMostSignificantBitFromPackedBytes(code, reg_ge, ge_sum);
+            code->xor_(reg_ge, 0xF);
+        } else {
+            // A sum is GE if it carried out, in which case it saturates; a difference is GE if a >= b.
+            code->paddusw(ge_sum, xmm_b);
+            code->movdqa(xmm_sum, xmm_a);
+            code->paddw(xmm_sum, xmm_b);
+            code->pcmpeqw(ge_sum, xmm_sum);
+            code->pxor(ge_sum, code->MConst(code->xword, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF));
+            code->pminuw(ge_diff, xmm_b);
+            code->pcmpeqw(ge_diff, xmm_b);
+            code->pblendw(ge_sum, ge_diff, diff_mask);
+            ExtractMostSignificantBitFromPackedBytes(code, reg_ge, ge_sum);
+        }
     }
+
+    code->movdqa(xmm_sum, xmm_a);
+    code->paddw(xmm_sum, xmm_b);
+    code->psubw(xmm_a, xmm_b);
+    code->pblendw(xmm_sum, xmm_a, diff_mask);
+    code->movd(reg_a, xmm_sum);
 }
 
-void EmitX64::EmitPackedHalvingAddU8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+static void EmitPackedSubAdd(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool is_signed) {
+    auto ge_inst = inst->GetAssociatedPseudoOperation(IR::Opcode::GetGEFromOp);
+
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
 
-    // This code path requires SSSE3 because of the PSHUFB instruction.
-    // A fallback implementation is provided below.
-    if (cpu_info.has(Xbyak::util::Cpu::tSSSE3)) {
-        Xbyak::Reg32 result = reg_alloc.UseDefGpr(a, inst).cvt32();
-        Xbyak::Reg32 arg = reg_alloc.UseGpr(b).cvt32();
-
-        // Load the operands into Xmm registers
-        Xbyak::Xmm xmm_scratch_a = reg_alloc.ScratchXmm();
-        Xbyak::Xmm xmm_scratch_b = reg_alloc.ScratchXmm();
+    // If asx is true, the high word contains the sum and the low word the difference.
+    // If false, the high word contains the difference and the low word the sum.
+    bool asx = inst->GetArg(2).GetU1();
 
-        Xbyak::Xmm xmm_mask = reg_alloc.ScratchXmm();
-        Xbyak::Reg64 mask = reg_alloc.ScratchGpr();
+    Xbyak::Reg32 reg_a_hi = reg_alloc.UseDefGpr(a, inst).cvt32();
+    Xbyak::Reg32 reg_b_hi = reg_alloc.UseScratchGpr(b).cvt32();
+    Xbyak::Reg32 reg_a_lo = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Reg32 reg_b_lo = reg_alloc.ScratchGpr().cvt32();
+    Xbyak::Reg32 reg_ge;
 
-        code->movd(xmm_scratch_a, result);
-        code->movd(xmm_scratch_b, arg);
+    if (ge_inst) {
+        EraseInstruction(block, ge_inst);
 
-        // Set the mask to expand the values
-        // 0xAABBCCDD becomes 0x00AA00BB00CC00DD
-        code->mov(mask, 0x8003800280018000);
-        code->movq(xmm_mask, mask);
+        reg_ge = reg_alloc.DefGpr(ge_inst).cvt32();
+    }
 
-        // Expand each 8-bit value to 16-bit
-        code->pshufb(xmm_scratch_a, xmm_mask);
-        code->pshufb(xmm_scratch_b, xmm_mask);
+    if (is_signed) {
+        code->movsx(reg_a_lo, reg_a_hi.cvt16());
+        code->movsx(reg_b_lo, reg_b_hi.cvt16());
+        code->sar(reg_a_hi, 16);
+        code->sar(reg_b_hi, 16);
+    } else {
+        code->movzx(reg_a_lo, reg_a_hi.cvt16());
+        code->movzx(reg_b_lo, reg_b_hi.cvt16());
+        code->shr(reg_a_hi, 16);
+        code->shr(reg_b_hi, 16);
+    }
 
-        // Add the individual 16-bit values
-        code->paddw(xmm_scratch_a, xmm_scratch_b);
+    Xbyak::Reg32 reg_sum, reg_diff;
+    if (asx) {
+        code->sub(reg_a_lo, reg_b_hi);
+        code->add(reg_a_hi, reg_b_lo);
+        reg_diff = reg_a_lo;
+        reg_sum = reg_a_hi;
+    } else {
+        code->add(reg_a_lo, reg_b_hi);
+        code->sub(reg_a_hi, reg_b_lo);
+        reg_diff = reg_a_hi;
+        reg_sum = reg_a_lo;
+    }
 
-        // Shift the 16-bit values to the right to halve them
-        code->psrlw(xmm_scratch_a, 1);
+    if (ge_inst) {
+        // reg_b_lo is no longer required, so it is used to hold the GE bit of the difference.
+        Xbyak::Reg32 ge_sum = reg_ge;
+        Xbyak::Reg32 ge_diff = reg_b_lo;
+
+        // Place each GE bit in bit 31: the difference is GE if it is non-negative, and so is a signed sum.
+        // An unsigned sum is GE if it carried out of 16 bits.
+        code->mov(ge_sum, reg_sum);
+        code->mov(ge_diff, reg_diff);
+        if (is_signed) {
+            code->not_(ge_sum);
+        } else {
+            code->shl(ge_sum, 15);
+        }
+        code->not_(ge_diff);
+
+        // Move the GE bit of the low word down to bit 15 and merge them.
+        Xbyak::Reg32 ge_hi = asx ? ge_sum : ge_diff;
+        Xbyak::Reg32 ge_lo = asx ? ge_diff : ge_sum;
+        code->and_(ge_hi, 0x80000000);
+        code->shr(ge_lo, 16);
+        code->or_(ge_sum, ge_diff);
+        ExtractAndDuplicateMostSignificantBitFromPackedWords(code, reg_ge);
+    }
 
-        // Set the mask to pack the values again
-        // 0x00AA00BB00CC00DD becomes 0xAABBCCDD
-        code->mov(mask, 0x06040200);
-        code->movq(xmm_mask, mask);
+    // Merge the low word and the high word into reg_a_hi.
+    code->shl(reg_a_lo, 16);
+    code->shld(reg_a_hi, reg_a_lo, 16);
+}
 
-        // Shuffle them back to 8-bit values
-        code->pshufb(xmm_scratch_a, xmm_mask);
+void EmitX64::EmitPackedSubAddU16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (cpu_info.has(Xbyak::util::Cpu::tSSE41)) {
+        EmitPackedSubAddSSE41(code, reg_alloc, block, inst, false);
+        return;
+    }
+    EmitPackedSubAdd(code, reg_alloc, block, inst, false);
+}
 
-        code->movd(result, xmm_scratch_a);
+void EmitX64::EmitPackedSubAddS16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (cpu_info.has(Xbyak::util::Cpu::tSSE41)) {
+        EmitPackedSubAddSSE41(code, reg_alloc, block, inst, true);
         return;
     }
+    EmitPackedSubAdd(code, reg_alloc, block, inst, true);
+}
+
+void EmitX64::EmitPackedHalvingAddU8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    IR::Value a = inst->GetArg(0);
+    IR::Value b = inst->GetArg(1);
 
-    // Fallback implementation in case the CPU doesn't support SSSE3
     Xbyak::Reg32 reg_a = reg_alloc.UseDefGpr(a, inst).cvt32();
     Xbyak::Reg32 reg_b = reg_alloc.UseGpr(b).cvt32();
     Xbyak::Reg32 xor_a_b = reg_alloc.ScratchGpr().cvt32();
     Xbyak::Reg32 and_a_b = reg_a;
     Xbyak::Reg32 result = reg_a;
 
+    // This relies on the same equality as EmitPackedHalvingAddU16 below, and is shorter than widening
+    // the bytes to words in an Xmm register. (PAVGB rounds up instead of down, so it cannot be used.)
+
     code->mov(xor_a_b, reg_a);
     code->and(and_a_b, reg_b);
     code->xor(xor_a_b, reg_b);
@@ -2130,91 +3676,163 @@ void EmitX64::EmitPackedAbsDiffSumS8(RegAlloc& reg_alloc, IR::Block&, IR::Inst*
     EmitPackedOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::psadbw);
 }
 
-static void DenormalsAreZero32(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg32 gpr_scratch) {
-    using namespace Xbyak::util;
-    Xbyak::Label end;
+static void EmitVectorOperation(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Mmx& mmx, const Xbyak::Operand&)) {
+    IR::Value a = inst->GetArg(0);
+    IR::Value b = inst->GetArg(1);
 
-    // We need to report back whether we've found a denormal on input.
-    // SSE doesn't do this for us when SSE's DAZ is enabled.
+    Xbyak::Xmm xmm_a = reg_alloc.UseDefXmm(a, inst);
+    Xbyak::Xmm xmm_b = reg_alloc.UseXmm(b);
 
-    code->movd(gpr_scratch, xmm_value);
-    code->and_(gpr_scratch, u32(0x7FFFFFFF));
-    code->sub(gpr_scratch, u32(1));
-    code->cmp(gpr_scratch, u32(0x007FFFFE));
-    code->ja(end);
-    code->pxor(xmm_value, xmm_value);
-    code->mov(dword[r15 + offsetof(JitState, FPSCR_IDC)], u32(1 << 7));
-    code->L(end);
+    (code->*fn)(xmm_a, xmm_b);
+}
+
+void EmitX64::EmitVectorAdd8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::paddb);
+}
+
+void EmitX64::EmitVectorAdd16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::paddw);
+}
+
+void EmitX64::EmitVectorAdd32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::paddd);
+}
+
+void EmitX64::EmitVectorAdd64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::paddq);
+}
+
+void EmitX64::EmitVectorSub8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::psubb);
+}
+
+void EmitX64::EmitVectorSub16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::psubw);
+}
+
+void EmitX64::EmitVectorSub32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::psubd);
+}
+
+void EmitX64::EmitVectorSub64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::psubq);
+}
+
+void EmitX64::EmitVectorMultiply16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::pmullw);
+}
+
+void EmitX64::EmitVectorMultiply32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    IR::Value a = inst->GetArg(0);
+    IR::Value b = inst->GetArg(1);
+
+    Xbyak::Xmm xmm_a = reg_alloc.UseDefXmm(a, inst);
+    Xbyak::Xmm xmm_b = reg_alloc.UseXmm(b);
+
+    if (cpu_info.has(Xbyak::util::Cpu::tSSE41)) {
+        code->pmulld(xmm_a, xmm_b);
+        return;
+    }
+
+    Xbyak::Xmm tmp_a = reg_alloc.ScratchXmm();
+    Xbyak::Xmm tmp_b = reg_alloc.ScratchXmm();
+
+    // pmuludq multiplies the even elements, so multiply the odd elements separately and interleave the products.
+    code->pshufd(tmp_a, xmm_a, 0b11110101);
+    code->pshufd(tmp_b, xmm_b, 0b11110101);
+    code->pmuludq(xmm_a, xmm_b);
+    code->pmuludq(tmp_a, tmp_b);
+    code->pshufd(xmm_a, xmm_a, 0b00001000);
+    code->pshufd(tmp_a, tmp_a, 0b00001000);
+    code->punpckldq(xmm_a, tmp_a);
+}
+
+void EmitX64::EmitVectorAnd(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::pand);
+}
+
+void EmitX64::EmitVectorOr(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::por);
+}
+
+void EmitX64::EmitVectorEor(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitVectorOperation(code, reg_alloc, inst, &Xbyak::CodeGenerator::pxor);
 }
 
-static void DenormalsAreZero64(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg64 gpr_scratch) {
+void EmitX64::EmitVectorNot(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     using namespace Xbyak::util;
-    Xbyak::Label end;
 
-    auto mask = code->MFloatNonSignMask64();
-    mask.setBit(64);
-    auto penult_denormal = code->MFloatPenultimatePositiveDenormal64();
-    penult_denormal.setBit(64);
+    Xbyak::Xmm xmm_a = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
 
-    code->movq(gpr_scratch, xmm_value);
-    code->and_(gpr_scratch, mask);
-    code->sub(gpr_scratch, u32(1));
-    code->cmp(gpr_scratch, penult_denormal);
-    code->ja(end);
-    code->pxor(xmm_value, xmm_value);
-    code->mov(dword[r15 + offsetof(JitState, FPSCR_IDC)], u32(1 << 7));
-    code->L(end);
+    code->pxor(xmm_a, code->MConst(xword, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF));
 }
 
-static void FlushToZero32(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg32 gpr_scratch) {
+// When FPSCR.FZ is set, MXCSR.DAZ and MXCSR.FTZ are set too (see JitState::SetFpscr), so the host flushes
+// denormal inputs and outputs itself. An output flush is reported by MXCSR.UE, which becomes FPSCR.UFC.
+// Unlike ARM however, the host does not report flushed inputs, so each input is checked for FPSCR.IDC.
+
+static void ReportDenormal32(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg32 gpr_scratch) {
     using namespace Xbyak::util;
-    Xbyak::Label end;
+    Xbyak::Label end, fixup;
 
     code->movd(gpr_scratch, xmm_value);
     code->and_(gpr_scratch, u32(0x7FFFFFFF));
     code->sub(gpr_scratch, u32(1));
     code->cmp(gpr_scratch, u32(0x007FFFFE));
-    code->ja(end);
-    code->pxor(xmm_value, xmm_value);
-    code->mov(dword[r15 + offsetof(JitState, FPSCR_UFC)], u32(1 << 3));
+    code->jbe(fixup, code->T_NEAR);
     code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(fixup);
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_IDC)], u32(1 << 7));
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
 }
 
-static void FlushToZero64(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg64 gpr_scratch) {
+static void ReportDenormal64(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Reg64 gpr_scratch) {
     using namespace Xbyak::util;
-    Xbyak::Label end;
-
-    auto mask = code->MFloatNonSignMask64();
-    mask.setBit(64);
-    auto penult_denormal = code->MFloatPenultimatePositiveDenormal64();
-    penult_denormal.setBit(64);
+    Xbyak::Label end, fixup;
 
     code->movq(gpr_scratch, xmm_value);
-    code->and_(gpr_scratch, mask);
+    code->and_(gpr_scratch, code->MConst(qword, 0x7FFFFFFFFFFFFFFF));
     code->sub(gpr_scratch, u32(1));
-    code->cmp(gpr_scratch, penult_denormal);
-    code->ja(end);
-    code->pxor(xmm_value, xmm_value);
-    code->mov(dword[r15 + offsetof(JitState, FPSCR_UFC)], u32(1 << 3));
+    code->cmp(gpr_scratch, code->MConst(qword, 0x000FFFFFFFFFFFFE));
+    code->jbe(fixup, code->T_NEAR);
     code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(fixup);
+    code->mov(dword[r15 + offsetof(JitState, FPSCR_IDC)], u32(1 << 7));
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
 }
 
 static void DefaultNaN32(BlockOfCode* code, Xbyak::Xmm xmm_value) {
-    Xbyak::Label end;
+    Xbyak::Label end, fixup;
 
     code->ucomiss(xmm_value, xmm_value);
-    code->jnp(end);
-    code->movaps(xmm_value, code->MFloatNaN32());
+    code->jp(fixup, code->T_NEAR);
     code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(fixup);
+    code->movaps(xmm_value, code->MFloatNaN32());
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
 }
 
 static void DefaultNaN64(BlockOfCode* code, Xbyak::Xmm xmm_value) {
-    Xbyak::Label end;
+    Xbyak::Label end, fixup;
 
     code->ucomisd(xmm_value, xmm_value);
-    code->jnp(end);
-    code->movaps(xmm_value, code->MFloatNaN64());
+    code->jp(fixup, code->T_NEAR);
     code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(fixup);
+    code->movaps(xmm_value, code->MFloatNaN64());
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
 }
 
 static void ZeroIfNaN64(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Xmm xmm_scratch) {
@@ -2223,82 +3841,80 @@ static void ZeroIfNaN64(BlockOfCode* code, Xbyak::Xmm xmm_value, Xbyak::Xmm xmm_
     code->pand(xmm_value, xmm_scratch);
 }
 
-static void FPThreeOp32(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
+static void FPThreeOp32(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool default_nan, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
 
     Xbyak::Xmm result = reg_alloc.UseDefXmm(a, inst);
-    Xbyak::Xmm operand = reg_alloc.UseXmm(b);
-    Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero32(code, result, gpr_scratch);
-        DenormalsAreZero32(code, operand, gpr_scratch);
-    }
-    (code->*fn)(result, operand);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero32(code, result, gpr_scratch);
+        Xbyak::Xmm operand = reg_alloc.UseXmm(b);
+        Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
+
+        ReportDenormal32(code, result, gpr_scratch);
+        ReportDenormal32(code, operand, gpr_scratch);
+        (code->*fn)(result, operand);
+    } else {
+        OpArg operand = reg_alloc.UseOpArg(b, any_xmm);
+
+        (code->*fn)(result, *operand);
     }
-    if (block.Location().FPSCR().DN()) {
+    if (default_nan) {
         DefaultNaN32(code, result);
     }
 }
 
-static void FPThreeOp64(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
+static void FPThreeOp64(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool default_nan, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
     IR::Value a = inst->GetArg(0);
     IR::Value b = inst->GetArg(1);
 
     Xbyak::Xmm result = reg_alloc.UseDefXmm(a, inst);
-    Xbyak::Xmm operand = reg_alloc.UseXmm(b);
-    Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero64(code, result, gpr_scratch);
-        DenormalsAreZero64(code, operand, gpr_scratch);
-    }
-    (code->*fn)(result, operand);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero64(code, result, gpr_scratch);
+        Xbyak::Xmm operand = reg_alloc.UseXmm(b);
+        Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
+
+        ReportDenormal64(code, result, gpr_scratch);
+        ReportDenormal64(code, operand, gpr_scratch);
+        (code->*fn)(result, operand);
+    } else {
+        OpArg operand = reg_alloc.UseOpArg(b, any_xmm);
+
+        (code->*fn)(result, *operand);
     }
-    if (block.Location().FPSCR().DN()) {
+    if (default_nan) {
         DefaultNaN64(code, result);
     }
 }
 
-static void FPTwoOp32(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
+static void FPTwoOp32(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool default_nan, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
     IR::Value a = inst->GetArg(0);
 
     Xbyak::Xmm result = reg_alloc.UseDefXmm(a, inst);
     Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero32(code, result, gpr_scratch);
+        ReportDenormal32(code, result, gpr_scratch);
     }
 
     (code->*fn)(result, result);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero32(code, result, gpr_scratch);
-    }
-    if (block.Location().FPSCR().DN()) {
+    if (default_nan) {
         DefaultNaN32(code, result);
     }
 }
 
-static void FPTwoOp64(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
+static void FPTwoOp64(BlockOfCode* code, RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst, bool default_nan, void (Xbyak::CodeGenerator::*fn)(const Xbyak::Xmm&, const Xbyak::Operand&)) {
     IR::Value a = inst->GetArg(0);
 
     Xbyak::Xmm result = reg_alloc.UseDefXmm(a, inst);
     Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero64(code, result, gpr_scratch);
+        ReportDenormal64(code, result, gpr_scratch);
     }
 
     (code->*fn)(result, result);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero64(code, result, gpr_scratch);
-    }
-    if (block.Location().FPSCR().DN()) {
+    if (default_nan) {
         DefaultNaN64(code, result);
     }
 }
@@ -2341,6 +3957,26 @@ void EmitX64::EmitTransferToFP64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst
     }
 }
 
+void EmitX64::EmitFPPack2x32To1x64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Xmm result = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
+    Xbyak::Xmm hi = reg_alloc.UseXmm(inst->GetArg(1));
+    code->unpcklps(result, hi);
+}
+
+// Single-precision values are kept with bits 32-63 clear, as they are when loaded, since some
+// emitters (e.g. EmitFPU32ToSingle) move the low 64 bits of their operand into a GPR.
+
+void EmitX64::EmitFPLeastSignificantWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Xmm result = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
+    code->psllq(result, 32);
+    code->psrlq(result, 32);
+}
+
+void EmitX64::EmitFPMostSignificantWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Xmm result = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
+    code->psrlq(result, 32);
+}
+
 void EmitX64::EmitFPAbs32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     IR::Value a = inst->GetArg(0);
 
@@ -2374,43 +4010,157 @@ void EmitX64::EmitFPNeg64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
 }
 
 void EmitX64::EmitFPAdd32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp32(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::addss);
+    FPThreeOp32(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::addss);
 }
 
 void EmitX64::EmitFPAdd64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp64(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::addsd);
+    FPThreeOp64(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::addsd);
 }
 
 void EmitX64::EmitFPDiv32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp32(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::divss);
+    FPThreeOp32(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::divss);
 }
 
 void EmitX64::EmitFPDiv64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp64(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::divsd);
+    FPThreeOp64(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::divsd);
 }
 
 void EmitX64::EmitFPMul32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp32(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::mulss);
+    FPThreeOp32(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::mulss);
 }
 
 void EmitX64::EmitFPMul64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp64(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::mulsd);
+    FPThreeOp64(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::mulsd);
+}
+
+/**
+ * Fused multiply-add for hosts without FMA3. Operands and result are passed as bit patterns, and
+ * FPSCR.FZ and FPSCR.DN are applied the same way as the inline FP emitters do.
+ */
+static u32 FPMulAdd32Fallback(u32 addend, u32 op1, u32 op2, JitState* jit_state) {
+    const bool ftz = Common::Bit<24>(jit_state->FPSCR_mode);
+    const auto is_denormal = [](u32 value) { return (value & 0x7F800000) == 0 && (value & 0x007FFFFF) != 0; };
+
+    std::array<u32, 3> operands{{addend, op1, op2}};
+    std::array<float, 3> values;
+    for (size_t i = 0; i < operands.size(); i++) {
+        if (ftz && is_denormal(operands[i])) {
+            operands[i] = 0;
+            jit_state->FPSCR_IDC = 1 << 7;
+        }
+        std::memcpy(&values[i], &operands[i], sizeof(float));
+    }
+
+    const float result_value = std::fma(values[1], values[2], values[0]);
+    u32 result;
+    std::memcpy(&result, &result_value, sizeof(u32));
+
+    if (ftz && is_denormal(result)) {
+        result = 0;
+        jit_state->FPSCR_UFC = 1 << 3;
+    }
+    if (Common::Bit<25>(jit_state->FPSCR_mode) && std::isnan(result_value)) {
+        result = 0x7FC00000;
+    }
+    return result;
+}
+
+static u64 FPMulAdd64Fallback(u64 addend, u64 op1, u64 op2, JitState* jit_state) {
+    const bool ftz = Common::Bit<24>(jit_state->FPSCR_mode);
+    const auto is_denormal = [](u64 value) { return (value & 0x7FF0000000000000) == 0 && (value & 0x000FFFFFFFFFFFFF) != 0; };
+
+    std::array<u64, 3> operands{{addend, op1, op2}};
+    std::array<double, 3> values;
+    for (size_t i = 0; i < operands.size(); i++) {
+        if (ftz && is_denormal(operands[i])) {
+            operands[i] = 0;
+            jit_state->FPSCR_IDC = 1 << 7;
+        }
+        std::memcpy(&values[i], &operands[i], sizeof(double));
+    }
+
+    const double result_value = std::fma(values[1], values[2], values[0]);
+    u64 result;
+    std::memcpy(&result, &result_value, sizeof(u64));
+
+    if (ftz && is_denormal(result)) {
+        result = 0;
+        jit_state->FPSCR_UFC = 1 << 3;
+    }
+    if (Common::Bit<25>(jit_state->FPSCR_mode) && std::isnan(result_value)) {
+        result = 0x7FF8000000000000;
+    }
+    return result;
+}
+
+void EmitX64::EmitFPMulAdd32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    if (!cpu_info.has(Xbyak::util::Cpu::tFMA)) {
+        reg_alloc.HostCall(inst, inst->GetArg(0), inst->GetArg(1), inst->GetArg(2));
+        code->mov(code->ABI_PARAM4, r15);
+        code->CallFunction(&FPMulAdd32Fallback);
+        return;
+    }
+
+    const bool ftz = block.Location().FPSCR().FTZ();
+    Xbyak::Xmm result = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
+    Xbyak::Xmm op1 = reg_alloc.UseXmm(inst->GetArg(1));
+    Xbyak::Xmm op2 = reg_alloc.UseXmm(inst->GetArg(2));
+    Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
+
+    if (ftz) {
+        ReportDenormal32(code, result, gpr_scratch);
+        ReportDenormal32(code, op1, gpr_scratch);
+        ReportDenormal32(code, op2, gpr_scratch);
+    }
+    code->vfmadd231ss(result, op1, op2);
+    if (UseDefaultNaN(block)) {
+        DefaultNaN32(code, result);
+    }
+}
+
+void EmitX64::EmitFPMulAdd64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    if (!cpu_info.has(Xbyak::util::Cpu::tFMA)) {
+        reg_alloc.HostCall(inst, inst->GetArg(0), inst->GetArg(1), inst->GetArg(2));
+        code->mov(code->ABI_PARAM4, r15);
+        code->CallFunction(&FPMulAdd64Fallback);
+        return;
+    }
+
+    const bool ftz = block.Location().FPSCR().FTZ();
+    Xbyak::Xmm result = reg_alloc.UseDefXmm(inst->GetArg(0), inst);
+    Xbyak::Xmm op1 = reg_alloc.UseXmm(inst->GetArg(1));
+    Xbyak::Xmm op2 = reg_alloc.UseXmm(inst->GetArg(2));
+    Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
+
+    if (ftz) {
+        ReportDenormal64(code, result, gpr_scratch);
+        ReportDenormal64(code, op1, gpr_scratch);
+        ReportDenormal64(code, op2, gpr_scratch);
+    }
+    code->vfmadd231sd(result, op1, op2);
+    if (UseDefaultNaN(block)) {
+        DefaultNaN64(code, result);
+    }
 }
 
 void EmitX64::EmitFPSqrt32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPTwoOp32(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::sqrtss);
+    FPTwoOp32(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::sqrtss);
 }
 
 void EmitX64::EmitFPSqrt64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPTwoOp64(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::sqrtsd);
+    FPTwoOp64(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::sqrtsd);
 }
 
 void EmitX64::EmitFPSub32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp32(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::subss);
+    FPThreeOp32(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::subss);
 }
 
 void EmitX64::EmitFPSub64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
-    FPThreeOp64(code, reg_alloc, block, inst, &Xbyak::CodeGenerator::subsd);
+    FPThreeOp64(code, reg_alloc, block, inst, UseDefaultNaN(block), &Xbyak::CodeGenerator::subsd);
 }
 
 static void SetFpscrNzcvFromFlags(BlockOfCode* code, RegAlloc& reg_alloc) {
@@ -2442,12 +4192,12 @@ void EmitX64::EmitFPCompare32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     bool quiet = inst->GetArg(2).GetU1();
 
     Xbyak::Xmm reg_a = reg_alloc.UseXmm(a);
-    Xbyak::Xmm reg_b = reg_alloc.UseXmm(b);
+    OpArg op_b = reg_alloc.UseOpArg(b, any_xmm);
 
     if (quiet) {
-        code->ucomiss(reg_a, reg_b);
+        code->ucomiss(reg_a, *op_b);
     } else {
-        code->comiss(reg_a, reg_b);
+        code->comiss(reg_a, *op_b);
     }
 
     SetFpscrNzcvFromFlags(code, reg_alloc);
@@ -2459,12 +4209,12 @@ void EmitX64::EmitFPCompare64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     bool quiet = inst->GetArg(2).GetU1();
 
     Xbyak::Xmm reg_a = reg_alloc.UseXmm(a);
-    Xbyak::Xmm reg_b = reg_alloc.UseXmm(b);
+    OpArg op_b = reg_alloc.UseOpArg(b, any_xmm);
 
     if (quiet) {
-        code->ucomisd(reg_a, reg_b);
+        code->ucomisd(reg_a, *op_b);
     } else {
-        code->comisd(reg_a, reg_b);
+        code->comisd(reg_a, *op_b);
     }
 
     SetFpscrNzcvFromFlags(code, reg_alloc);
@@ -2477,13 +4227,10 @@ void EmitX64::EmitFPSingleToDouble(RegAlloc& reg_alloc, IR::Block& block, IR::In
     Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero32(code, result, gpr_scratch.cvt32());
+        ReportDenormal32(code, result, gpr_scratch.cvt32());
     }
     code->cvtss2sd(result, result);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero64(code, result, gpr_scratch);
-    }
-    if (block.Location().FPSCR().DN()) {
+    if (UseDefaultNaN(block)) {
         DefaultNaN64(code, result);
     }
 }
@@ -2495,13 +4242,10 @@ void EmitX64::EmitFPDoubleToSingle(RegAlloc& reg_alloc, IR::Block& block, IR::In
     Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero64(code, result, gpr_scratch);
+        ReportDenormal64(code, result, gpr_scratch);
     }
     code->cvtsd2ss(result, result);
-    if (block.Location().FPSCR().FTZ()) {
-        FlushToZero32(code, result, gpr_scratch.cvt32());
-    }
-    if (block.Location().FPSCR().DN()) {
+    if (UseDefaultNaN(block)) {
         DefaultNaN32(code, result);
     }
 }
@@ -2513,13 +4257,12 @@ void EmitX64::EmitFPSingleToS32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     Xbyak::Xmm from = reg_alloc.UseScratchXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
     Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
-    Xbyak::Xmm xmm_scratch = reg_alloc.ScratchXmm();
 
     // ARM saturates on conversion; this differs from x64 which returns a sentinel value.
     // Conversion to double is lossless, and allows for clamping.
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero32(code, from, gpr_scratch);
+        ReportDenormal32(code, from, gpr_scratch);
     }
     code->cvtss2sd(from, from);
     // First time is to set flags
@@ -2529,7 +4272,9 @@ void EmitX64::EmitFPSingleToS32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
     }
     // Clamp to output range
-    ZeroIfNaN64(code, from, xmm_scratch);
+    if (cb.accurate_nan) {
+        ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
+    }
     code->minsd(from, code->MFloatMaxS32());
     code->maxsd(from, code->MFloatMinS32());
     // Second time is for real
@@ -2548,9 +4293,31 @@ void EmitX64::EmitFPSingleToU32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     Xbyak::Xmm from = reg_alloc.UseScratchXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
     Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
-    Xbyak::Xmm xmm_scratch = reg_alloc.ScratchXmm();
 
     // ARM saturates on conversion; this differs from x64 which returns a sentinel value.
+
+    if (cpu_info.has(Xbyak::util::Cpu::tAVX512F)) {
+        // The sentinel of unsigned conversions is 0xFFFFFFFF, which is also ARM's result for values that
+        // are too large. maxss replaces NaNs (and negative values) with its second operand, zero.
+        if (block.Location().FPSCR().FTZ()) {
+            ReportDenormal32(code, from, gpr_scratch);
+        }
+        // First time is to set flags
+        if (round_towards_zero) {
+            code->vcvttss2usi(gpr_scratch, from);
+        } else {
+            code->vcvtss2usi(gpr_scratch, from);
+        }
+        code->maxss(from, code->MFloatMinU32()); // The low half of the double 0 is the float 0
+        if (round_towards_zero) {
+            code->vcvttss2usi(gpr_scratch, from);
+        } else {
+            code->vcvtss2usi(gpr_scratch, from);
+        }
+        code->movd(to, gpr_scratch);
+        return;
+    }
+
     // Conversion to double is lossless, and allows for accurate clamping.
     //
     // Since SSE2 doesn't provide an unsigned conversion, we shift the range as appropriate.
@@ -2559,10 +4326,12 @@ void EmitX64::EmitFPSingleToU32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
 
     if (block.Location().FPSCR().RMode() != Arm::FPSCR::RoundingMode::TowardsZero && !round_towards_zero) {
         if (block.Location().FPSCR().FTZ()) {
-            DenormalsAreZero32(code, from, gpr_scratch);
+            ReportDenormal32(code, from, gpr_scratch);
         }
         code->cvtss2sd(from, from);
-        ZeroIfNaN64(code, from, xmm_scratch);
+        if (cb.accurate_nan) {
+            ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
+        }
         // Bring into SSE range
         code->addsd(from, code->MFloatMinS32());
         // First time is to set flags
@@ -2580,10 +4349,12 @@ void EmitX64::EmitFPSingleToU32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         Xbyak::Reg32 gpr_mask = reg_alloc.ScratchGpr().cvt32();
 
         if (block.Location().FPSCR().FTZ()) {
-            DenormalsAreZero32(code, from, gpr_scratch);
+            ReportDenormal32(code, from, gpr_scratch);
         }
         code->cvtss2sd(from, from);
-        ZeroIfNaN64(code, from, xmm_scratch);
+        if (cb.accurate_nan) {
+            ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
+        }
         // Generate masks if out-of-signed-range
         code->movaps(xmm_mask, code->MFloatMaxS32());
         code->cmpltsd(xmm_mask, from);
@@ -2612,12 +4383,11 @@ void EmitX64::EmitFPDoubleToS32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     Xbyak::Xmm from = reg_alloc.UseScratchXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
     Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
-    Xbyak::Xmm xmm_scratch = reg_alloc.ScratchXmm();
 
     // ARM saturates on conversion; this differs from x64 which returns a sentinel value.
 
     if (block.Location().FPSCR().FTZ()) {
-        DenormalsAreZero64(code, from, gpr_scratch.cvt64());
+        ReportDenormal64(code, from, gpr_scratch.cvt64());
     }
     // First time is to set flags
     if (round_towards_zero) {
@@ -2626,7 +4396,9 @@ void EmitX64::EmitFPDoubleToS32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
     }
     // Clamp to output range
-    ZeroIfNaN64(code, from, xmm_scratch);
+    if (cb.accurate_nan) {
+        ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
+    }
     code->minsd(from, code->MFloatMaxS32());
     code->maxsd(from, code->MFloatMinS32());
     // Second time is for real
@@ -2645,26 +4417,48 @@ void EmitX64::EmitFPDoubleToU32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
     Xbyak::Xmm from = reg_alloc.UseScratchXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
     Xbyak::Reg32 gpr_scratch = reg_alloc.ScratchGpr().cvt32();
-    Xbyak::Xmm xmm_scratch = reg_alloc.ScratchXmm();
 
     // ARM saturates on conversion; this differs from x64 which returns a sentinel value.
-    // TODO: Use VCVTPD2UDQ when AVX512VL is available.
-    // FIXME: Inexact exception not correctly signalled with the below code
 
-    if (block.Location().FPSCR().RMode() != Arm::FPSCR::RoundingMode::TowardsZero && !round_towards_zero) {
+    if (cpu_info.has(Xbyak::util::Cpu::tAVX512F)) {
+        // As in EmitFPSingleToU32.
         if (block.Location().FPSCR().FTZ()) {
-            DenormalsAreZero64(code, from, gpr_scratch.cvt64());
+            ReportDenormal64(code, from, gpr_scratch.cvt64());
         }
-        ZeroIfNaN64(code, from, xmm_scratch);
-        // Bring into SSE range
-        code->addsd(from, code->MFloatMinS32());
         // First time is to set flags
-        code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
-        // Clamp to output range
-        code->minsd(from, code->MFloatMaxS32());
-        code->maxsd(from, code->MFloatMinS32());
-        // Actually convert
-        code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
+        if (round_towards_zero) {
+            code->vcvttsd2usi(gpr_scratch, from);
+        } else {
+            code->vcvtsd2usi(gpr_scratch, from);
+        }
+        code->maxsd(from, code->MFloatMinU32());
+        if (round_towards_zero) {
+            code->vcvttsd2usi(gpr_scratch, from);
+        } else {
+            code->vcvtsd2usi(gpr_scratch, from);
+        }
+        code->movd(to, gpr_scratch);
+        return;
+    }
+
+    // FIXME: Inexact exception not correctly signalled with the below code
+
+    if (block.Location().FPSCR().RMode() != Arm::FPSCR::RoundingMode::TowardsZero && !round_towards_zero) {
+        if (block.Location().FPSCR().FTZ()) {
+            ReportDenormal64(code, from, gpr_scratch.cvt64());
+        }
+        if (cb.accurate_nan) {
+            ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
+        }
+        // Bring into SSE range
+        code->addsd(from, code->MFloatMinS32());
+        // First time is to set flags
+        code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
+        // Clamp to output range
+        code->minsd(from, code->MFloatMaxS32());
+        code->maxsd(from, code->MFloatMinS32());
+        // Actually convert
+        code->cvtsd2si(gpr_scratch, from); // 32 bit gpr
         // Bring back into original range
         code->add(gpr_scratch, u32(2147483648u));
         code->movd(to, gpr_scratch);
@@ -2673,9 +4467,11 @@ void EmitX64::EmitFPDoubleToU32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst*
         Xbyak::Reg32 gpr_mask = reg_alloc.ScratchGpr().cvt32();
 
         if (block.Location().FPSCR().FTZ()) {
-            DenormalsAreZero64(code, from, gpr_scratch.cvt64());
+            ReportDenormal64(code, from, gpr_scratch.cvt64());
+        }
+        if (cb.accurate_nan) {
+            ZeroIfNaN64(code, from, reg_alloc.ScratchXmm());
         }
-        ZeroIfNaN64(code, from, xmm_scratch);
         // Generate masks if out-of-signed-range
         code->movaps(xmm_mask, code->MFloatMaxS32());
         code->cmpltsd(xmm_mask, from);
@@ -2717,9 +4513,15 @@ void EmitX64::EmitFPU32ToSingle(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst)
 
     Xbyak::Xmm from = reg_alloc.UseXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
-    // Use a 64-bit register to ensure we don't end up treating the input as signed
     Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
+    if (cpu_info.has(Xbyak::util::Cpu::tAVX512F)) {
+        code->movd(gpr_scratch.cvt32(), from);
+        code->vcvtusi2ss(to, from, gpr_scratch.cvt32());
+        return;
+    }
+
+    // Use a 64-bit register to ensure we don't end up treating the input as signed
     code->movq(gpr_scratch, from);
     code->cvtsi2ss(to, gpr_scratch);
 }
@@ -2744,9 +4546,15 @@ void EmitX64::EmitFPU32ToDouble(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst)
 
     Xbyak::Xmm from = reg_alloc.UseXmm(a);
     Xbyak::Xmm to = reg_alloc.DefXmm(inst);
-    // Use a 64-bit register to ensure we don't end up treating the input as signed
     Xbyak::Reg64 gpr_scratch = reg_alloc.ScratchGpr();
 
+    if (cpu_info.has(Xbyak::util::Cpu::tAVX512F)) {
+        code->movd(gpr_scratch.cvt32(), from);
+        code->vcvtusi2sd(to, from, gpr_scratch.cvt32());
+        return;
+    }
+
+    // Use a 64-bit register to ensure we don't end up treating the input as signed
     code->movq(gpr_scratch, from);
     code->cvtsi2sd(to, gpr_scratch);
 }
@@ -2758,6 +4566,11 @@ void EmitX64::EmitClearExclusive(RegAlloc&, IR::Block&, IR::Inst*) {
     code->mov(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
 }
 
+void EmitX64::EmitDataMemoryBarrier(RegAlloc&, IR::Block&, IR::Inst*) {
+    // Only a store followed by a load can be reordered under x86-TSO.
+    code->mfence();
+}
+
 void EmitX64::EmitSetExclusive(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
     using namespace Xbyak::util;
 
@@ -2768,137 +4581,900 @@ void EmitX64::EmitSetExclusive(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst)
     code->mov(dword[r15 + offsetof(JitState, exclusive_address)], address);
 }
 
-template <typename FunctionPointer>
-static void ReadMemory(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, UserCallbacks& cb, size_t bit_size, FunctionPointer fn) {
-    if (!cb.page_table) {
-        reg_alloc.HostCall(inst, inst->GetArg(0));
-        code->CallFunction(fn);
+/**
+ * Looks up the host page holding vaddr in the page table or page directory in r14 (see BlockOfCode::GenRunCode),
+ * leaving the host address of the page in `page` and the offset of vaddr within it in `page_offset`.
+ * Emits a jump to `abort` if the page is not mapped.
+ */
+static void EmitPageTableLookup(BlockOfCode* code, const UserCallbacks& cb, Xbyak::Reg32 vaddr, Xbyak::Reg64 page, Xbyak::Reg64 page_offset, Xbyak::Label& abort) {
+    using namespace Xbyak::util;
+
+    code->mov(page.cvt32(), vaddr);
+    if (cb.page_table) {
+        code->shr(page.cvt32(), 12);
+        code->mov(page, qword[r14 + page * 8]);
+    } else {
+        code->shr(page.cvt32(), 22);
+        code->mov(page, qword[r14 + page * 8]);
+        code->test(page, page);
+        code->jz(abort, code->T_NEAR);
+        code->mov(page_offset.cvt32(), vaddr);
+        code->shr(page_offset.cvt32(), 12);
+        code->and_(page_offset.cvt32(), 1023);
+        code->mov(page, qword[page + page_offset * 8]);
+    }
+    code->test(page, page);
+    code->jz(abort, code->T_NEAR);
+    code->mov(page_offset.cvt32(), vaddr);
+    code->and_(page_offset.cvt32(), 4095);
+}
+
+/**
+ * The inline page table path can only access a single page. Emits a jump to `abort` if an access of
+ * `access_size` bytes at `page_offset` would cross into the next page, unless `vaddr` proves it does not.
+ * Such accesses are split up by the memory callbacks instead.
+ */
+static void EmitPageCrossingCheck(BlockOfCode* code, const IR::Value& vaddr, Xbyak::Reg32 page_offset, size_t access_size, Xbyak::Label& abort) {
+    const u32 last_safe_offset = 4096 - static_cast<u32>(access_size);
+    if (access_size == 1)
+        return;
+    if (!vaddr.IsEmpty() && vaddr.IsImmediate() && (vaddr.GetU32() & 4095) <= last_safe_offset)
+        return;
+
+    code->cmp(page_offset, last_safe_offset);
+    code->ja(abort, code->T_NEAR);
+}
+
+/**
+ * Fastmem accesses are not split at page boundaries, but the code page and watchpoint checks below only
+ * look at the page of vaddr. Emits a jump to `slow_path` if an access of `access_size` bytes at vaddr may
+ * cross into the next page while either check applies to it, so that the memory callbacks, which check
+ * both pages, make it instead. An empty `vaddr_arg` proves nothing about vaddr. Clobbers RAX.
+ */
+static void EmitFastmemPageCrossingCheck(BlockOfCode* code, const UserCallbacks& cb, const IR::Value& vaddr_arg, Xbyak::Reg32 vaddr, size_t access_size, bool is_write, Xbyak::Label& slow_path) {
+    using namespace Xbyak::util;
+
+    if (!cb.WatchpointHit && !(is_write && cb.detect_self_modifying_code))
+        return;
+    if (access_size == 1 || (!vaddr_arg.IsEmpty() && vaddr_arg.IsImmediate() && (vaddr_arg.GetU32() & 4095) <= 4096 - access_size))
+        return;
+
+    code->mov(eax, vaddr);
+    code->and_(eax, 4095);
+    EmitPageCrossingCheck(code, vaddr_arg, eax, access_size, slow_path);
+}
+
+/**
+ * Emits a jump to `slow_path` if the page of vaddr may hold translated code, so that the write is made
+ * by the memory write callbacks, which record it (see UserCallbacks::detect_self_modifying_code). Writes
+ * that cross into the next page must already have been sent to `slow_path`, by EmitPageCrossingCheck or
+ * EmitFastmemPageCrossingCheck. Clobbers RAX.
+ */
+static void EmitCodePageCheck(BlockOfCode* code, const UserCallbacks& cb, Xbyak::Reg32 vaddr, Xbyak::Label& slow_path) {
+    using namespace Xbyak::util;
+
+    if (!cb.detect_self_modifying_code)
+        return;
+
+    code->mov(eax, vaddr);
+    code->shr(eax, 12);
+    code->add(rax, qword[r15 + offsetof(JitState, code_pages)]);
+    code->cmp(code->byte[rax], u8(0));
+    code->jne(slow_path, code->T_NEAR);
+}
+
+/**
+ * Emits a jump to `slow_path` if accesses of `kind` are watched on the page of vaddr, so that the access
+ * is made by the memory callbacks, which report it (see UserCallbacks::WatchpointHit). As with
+ * EmitCodePageCheck, accesses that cross into the next page must already have been sent to `slow_path`
+ * if they are made inline. Clobbers RAX.
+ */
+static void EmitWatchpointCheck(BlockOfCode* code, const UserCallbacks& cb, Xbyak::Reg32 vaddr, WatchpointKind kind, Xbyak::Label& slow_path) {
+    using namespace Xbyak::util;
+
+    if (!cb.WatchpointHit)
         return;
+
+    code->mov(eax, vaddr);
+    code->shr(eax, 12);
+    code->add(rax, qword[r15 + offsetof(JitState, watched_pages)]);
+    code->test(code->byte[rax], static_cast<u8>(kind));
+    code->jnz(slow_path, code->T_NEAR);
+}
+
+/// Reverses the bytes of the bit_size-bit value that a memory callback has read or is about to write.
+static void EmitByteReverse(BlockOfCode* code, Xbyak::Reg64 value, size_t bit_size) {
+    switch (bit_size) {
+    case 16:
+        code->rol(value.cvt16(), 8);
+        break;
+    case 32:
+        code->bswap(value.cvt32());
+        break;
+    case 64:
+        code->bswap(value);
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+}
+
+/// If byte_reverse is not nullptr, the value read is defined as that of byte_reverse instead (see FindMovbeByteReverse).
+static Xbyak::Reg64 ReadMemory(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, UserCallbacks& cb, size_t bit_size, IR::Inst* byte_reverse = nullptr) {
+    if (!HasPageTable(cb)) {
+        ASSERT(!byte_reverse);
+        const auto live = reg_alloc.HostCallSavingLiveRegisters(inst, inst->GetArg(0));
+        code->CallSavingRegisters(live, [code, bit_size]{ code->CallMemoryReadFunction(bit_size); });
+        return code->ABI_RETURN;
     }
 
     using namespace Xbyak::util;
 
-    Xbyak::Reg64 result = reg_alloc.DefGpr(inst, { ABI_RETURN });
-    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(inst->GetArg(0), { ABI_PARAM1 }).cvt32();
-    Xbyak::Reg64 page_index = reg_alloc.ScratchGpr();
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    if (byte_reverse) {
+        inst->DecrementRemainingUses();
+    }
+    Xbyak::Reg64 result = reg_alloc.DefGpr(byte_reverse ? byte_reverse : inst, { ABI_RETURN });
+    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 }).cvt32();
+    Xbyak::Reg64 page = reg_alloc.ScratchGpr();
     Xbyak::Reg64 page_offset = reg_alloc.ScratchGpr();
 
     Xbyak::Label abort, end;
 
-    code->mov(rax, reinterpret_cast<u64>(cb.page_table));
-    code->mov(page_index.cvt32(), vaddr);
-    code->shr(page_index.cvt32(), 12);
-    code->mov(rax, qword[rax + page_index * 8]);
-    code->test(rax, rax);
-    code->jz(abort);
-    code->mov(page_offset.cvt32(), vaddr);
-    code->and_(page_offset.cvt32(), 4095);
+    EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Read, abort);
+    EmitPageTableLookup(code, cb, vaddr, page, page_offset, abort);
+    EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), bit_size / 8, abort);
     switch (bit_size) {
     case 8:
-        code->movzx(result, code->byte[rax + page_offset]);
+        code->movzx(result, code->byte[page + page_offset]);
         break;
     case 16:
-        code->movzx(result, word[rax + page_offset]);
+        code->movzx(result, word[page + page_offset]);
         break;
     case 32:
-        code->mov(result.cvt32(), dword[rax + page_offset]);
+        if (byte_reverse) {
+            code->movbe(result.cvt32(), dword[page + page_offset]);
+        } else {
+            code->mov(result.cvt32(), dword[page + page_offset]);
+        }
         break;
     case 64:
-        code->mov(result.cvt64(), qword[rax + page_offset]);
+        if (byte_reverse) {
+            code->movbe(result.cvt64(), qword[page + page_offset]);
+        } else {
+            code->mov(result.cvt64(), qword[page + page_offset]);
+        }
         break;
     default:
         ASSERT_MSG(false, "Invalid bit_size");
         break;
     }
-    code->jmp(end);
-    code->L(abort);
-    code->call(code->GetMemoryReadCallback(bit_size));
     code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(abort);
+    code->CallSavingRegisters(reg_alloc.LiveCallerSaveRegisters(), [code, bit_size]{ code->CallMemoryReadFunction(bit_size); });
+    if (byte_reverse) {
+        EmitByteReverse(code, result, bit_size);
+    }
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+
+    return result;
 }
 
-template<typename FunctionPointer>
-static void WriteMemory(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, UserCallbacks& cb, size_t bit_size, FunctionPointer fn) {
-    if (!cb.page_table) {
-        reg_alloc.HostCall(inst, inst->GetArg(0), inst->GetArg(1));
-        code->CallFunction(fn);
+/// If byte_reverse is not nullptr, it is the value written, which is stored byte-reversed (see FindMovbeByteReverse).
+static void WriteMemory(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, UserCallbacks& cb, size_t bit_size, IR::Inst* byte_reverse = nullptr) {
+    if (!HasPageTable(cb)) {
+        ASSERT(!byte_reverse);
+        const auto live = reg_alloc.HostCallSavingLiveRegisters(nullptr, inst->GetArg(0), inst->GetArg(1));
+        code->CallSavingRegisters(live, [code, bit_size]{ code->CallMemoryWriteFunction(bit_size); });
         return;
     }
 
     using namespace Xbyak::util;
 
-    reg_alloc.ScratchGpr({ HostLoc::RAX });
-    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(inst->GetArg(0), { ABI_PARAM1 }).cvt32();
-    Xbyak::Reg64 value = reg_alloc.UseScratchGpr(inst->GetArg(1), { ABI_PARAM2 });
-    Xbyak::Reg64 page_index = reg_alloc.ScratchGpr();
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    reg_alloc.ScratchGpr({ HostLoc::RAX }); // Clobbered by the memory write thunks
+    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 }).cvt32();
+    Xbyak::Reg64 value = reg_alloc.UseScratchGpr(byte_reverse ? byte_reverse->GetArg(0) : inst->GetArg(1), { ABI_PARAM2 });
+    if (byte_reverse) {
+        byte_reverse->DecrementRemainingUses();
+    }
+    Xbyak::Reg64 page = reg_alloc.ScratchGpr();
     Xbyak::Reg64 page_offset = reg_alloc.ScratchGpr();
 
     Xbyak::Label abort, end;
 
-    code->mov(rax, reinterpret_cast<u64>(cb.page_table));
-    code->mov(page_index.cvt32(), vaddr);
-    code->shr(page_index.cvt32(), 12);
-    code->mov(rax, qword[rax + page_index * 8]);
-    code->test(rax, rax);
-    code->jz(abort);
-    code->mov(page_offset.cvt32(), vaddr);
-    code->and_(page_offset.cvt32(), 4095);
+    EmitPageTableLookup(code, cb, vaddr, page, page_offset, abort);
+    EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), bit_size / 8, abort);
+    EmitCodePageCheck(code, cb, vaddr, abort);
+    EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Write, abort);
     switch (bit_size) {
     case 8:
-        code->mov(code->byte[rax + page_offset], value.cvt8());
+        code->mov(code->byte[page + page_offset], value.cvt8());
         break;
     case 16:
-        code->mov(word[rax + page_offset], value.cvt16());
+        if (byte_reverse) {
+            code->movbe(word[page + page_offset], value.cvt16());
+        } else {
+            code->mov(word[page + page_offset], value.cvt16());
+        }
         break;
     case 32:
-        code->mov(dword[rax + page_offset], value.cvt32());
+        if (byte_reverse) {
+            code->movbe(dword[page + page_offset], value.cvt32());
+        } else {
+            code->mov(dword[page + page_offset], value.cvt32());
+        }
         break;
     case 64:
-        code->mov(qword[rax + page_offset], value.cvt64());
+        if (byte_reverse) {
+            code->movbe(qword[page + page_offset], value.cvt64());
+        } else {
+            code->mov(qword[page + page_offset], value.cvt64());
+        }
         break;
     default:
         ASSERT_MSG(false, "Invalid bit_size");
         break;
     }
-    code->jmp(end);
+    code->L(end);
+
+    code->SwitchToFarCode();
     code->L(abort);
-    code->call(code->GetMemoryWriteCallback(bit_size));
+    if (byte_reverse) {
+        EmitByteReverse(code, value, bit_size);
+    }
+    code->CallSavingRegisters(reg_alloc.LiveCallerSaveRegisters(), [code, bit_size]{ code->CallMemoryWriteFunction(bit_size); });
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+}
+
+/// Length of a fastmem access, which is large enough to be backpatched with a jmp rel32 to its fallback.
+constexpr size_t fastmem_access_size = 5;
+
+Xbyak::Reg64 EmitX64::EmitFastmemRead(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size, IR::Inst* byte_reverse) {
+    using namespace Xbyak::util;
+
+    // The register assignment matches the memory read thunks, so that the fallback is just a call.
+    if (byte_reverse) {
+        inst->DecrementRemainingUses();
+    }
+    Xbyak::Reg64 result = reg_alloc.DefGpr(byte_reverse ? byte_reverse : inst, { ABI_RETURN });
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(inst->GetArg(0), { ABI_PARAM1 });
+
+    Xbyak::Label end, slow_path;
+
+    // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+    code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+    EmitFastmemPageCrossingCheck(code, cb, inst->GetArg(0), vaddr.cvt32(), bit_size / 8, false, slow_path);
+    EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Read, slow_path);
+    const CodePtr access_location = code->getCurr();
+    switch (bit_size) {
+    case 8:
+        code->movzx(result.cvt32(), code->byte[r14 + vaddr]);
+        break;
+    case 16:
+        code->movzx(result.cvt32(), word[r14 + vaddr]);
+        break;
+    case 32:
+        if (byte_reverse) {
+            code->movbe(result.cvt32(), dword[r14 + vaddr]);
+        } else {
+            code->mov(result.cvt32(), dword[r14 + vaddr]);
+        }
+        break;
+    case 64:
+        if (byte_reverse) {
+            code->movbe(result, qword[r14 + vaddr]);
+        } else {
+            code->mov(result, qword[r14 + vaddr]);
+        }
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+    code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+    code->L(end);
+
+    code->SwitchToFarCode();
+    const CodePtr fallback = code->getCurr();
+    code->L(slow_path);
+    code->CallSavingRegisters(reg_alloc.LiveCallerSaveRegisters(), [this, bit_size]{ code->CallMemoryReadFunction(bit_size); });
+    if (byte_reverse) {
+        EmitByteReverse(code, result, bit_size);
+    }
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+
+    RegisterFastmemAccess(access_location, fallback);
+
+    return result;
+}
+
+void EmitX64::EmitFastmemWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size, IR::Inst* byte_reverse) {
+    using namespace Xbyak::util;
+
+    // The register assignment matches the memory write thunks, so that the fallback is just a call.
+    reg_alloc.ScratchGpr({ HostLoc::RAX }); // Clobbered by the memory write thunks
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(inst->GetArg(0), { ABI_PARAM1 });
+    Xbyak::Reg64 value = reg_alloc.UseScratchGpr(byte_reverse ? byte_reverse->GetArg(0) : inst->GetArg(1), { ABI_PARAM2 });
+    if (byte_reverse) {
+        byte_reverse->DecrementRemainingUses();
+    }
+
+    Xbyak::Label end, slow_path;
+
+    // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+    code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+    EmitFastmemPageCrossingCheck(code, cb, inst->GetArg(0), vaddr.cvt32(), bit_size / 8, true, slow_path);
+    EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+    EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+    const CodePtr access_location = code->getCurr();
+    switch (bit_size) {
+    case 8:
+        code->mov(code->byte[r14 + vaddr], value.cvt8());
+        break;
+    case 16:
+        if (byte_reverse) {
+            code->movbe(word[r14 + vaddr], value.cvt16());
+        } else {
+            code->mov(word[r14 + vaddr], value.cvt16());
+        }
+        break;
+    case 32:
+        if (byte_reverse) {
+            code->movbe(dword[r14 + vaddr], value.cvt32());
+        } else {
+            code->mov(dword[r14 + vaddr], value.cvt32());
+        }
+        break;
+    case 64:
+        if (byte_reverse) {
+            code->movbe(qword[r14 + vaddr], value);
+        } else {
+            code->mov(qword[r14 + vaddr], value);
+        }
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+    code->EnsurePatchLocationSize(access_location, fastmem_access_size);
     code->L(end);
+
+    code->SwitchToFarCode();
+    const CodePtr fallback = code->getCurr();
+    code->L(slow_path);
+    if (byte_reverse) {
+        EmitByteReverse(code, value, bit_size);
+    }
+    code->CallSavingRegisters(reg_alloc.LiveCallerSaveRegisters(), [this, bit_size]{ code->CallMemoryWriteFunction(bit_size); });
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+
+    RegisterFastmemAccess(access_location, fallback);
+}
+
+void EmitX64::RegisterFastmemAccess(CodePtr access_location, CodePtr fallback) {
+    std::lock_guard<std::mutex> lock(fastmem_mutex);
+    fastmem_fallbacks.emplace(access_location, fallback);
+}
+
+CodePtr EmitX64::HandleFastmemFault(CodePtr fault_location) {
+    std::lock_guard<std::mutex> lock(fastmem_mutex);
+
+    auto iter = fastmem_fallbacks.find(fault_location);
+    if (iter == fastmem_fallbacks.end())
+        return nullptr;
+
+    // Other threads may be executing this code, so it is only backpatched in ApplyDeferredLinks.
+    faulted_fastmem_accesses.emplace_back(fault_location);
+    return iter->second;
+}
+
+/**
+ * Returns the `fn` handler of the MMIO device at the constant address vaddr and sets `device` to the
+ * device's context, or returns nullptr if vaddr is not constant or has no such handler.
+ */
+template <typename FunctionPointer>
+static FunctionPointer GetConstantMmioHandler(const UserCallbacks& cb, const IR::Value& vaddr, FunctionPointer MmioHandler::*fn, void*& device) {
+    if (!cb.mmio_pages || !vaddr.IsImmediate())
+        return nullptr;
+    const MmioHandler* handler = (*cb.mmio_pages)[vaddr.GetU32() >> UserCallbacks::PAGE_BITS];
+    if (!handler || !(handler->*fn))
+        return nullptr;
+    device = handler->device;
+    return handler->*fn;
+}
+
+/// Calls the MMIO handler bound to the constant address of a memory read directly. Returns false if there is none.
+template <typename FunctionPointer>
+static bool ReadMmio(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, const UserCallbacks& cb, FunctionPointer MmioHandler::*fn) {
+    void* device = nullptr;
+    const FunctionPointer handler = GetConstantMmioHandler(cb, inst->GetArg(0), fn, device);
+    if (!handler)
+        return false;
+
+    const u32 vaddr = inst->GetArg(0).GetU32();
+    const auto live = reg_alloc.HostCallSavingLiveRegisters(inst);
+    code->CallSavingRegisters(live, [code, handler, device, vaddr]{
+        code->mov(code->ABI_PARAM1, reinterpret_cast<u64>(device));
+        code->mov(code->ABI_PARAM2.cvt32(), vaddr);
+        code->CallCallback(CallbackKind::Memory, handler);
+    });
+    return true;
+}
+
+/// Calls the MMIO handler bound to the constant address of a memory write directly. Returns false if there is none.
+template <typename FunctionPointer>
+static bool WriteMmio(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, const UserCallbacks& cb, FunctionPointer MmioHandler::*fn) {
+    void* device = nullptr;
+    const FunctionPointer handler = GetConstantMmioHandler(cb, inst->GetArg(0), fn, device);
+    if (!handler)
+        return false;
+
+    const u32 vaddr = inst->GetArg(0).GetU32();
+    const auto live = reg_alloc.HostCallSavingLiveRegisters(nullptr, {}, {}, inst->GetArg(1));
+    code->CallSavingRegisters(live, [code, handler, device, vaddr]{
+        code->mov(code->ABI_PARAM1, reinterpret_cast<u64>(device));
+        code->mov(code->ABI_PARAM2.cvt32(), vaddr);
+        code->CallCallback(CallbackKind::Memory, handler);
+    });
+    return true;
 }
 
 void EmitX64::EmitReadMemory8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ReadMemory(code, reg_alloc, inst, cb, 8, cb.memory.Read8);
+    if (ReadMmio(code, reg_alloc, inst, cb, &MmioHandler::Read8))
+        return;
+    if (cb.fastmem_pointer) {
+        EmitFastmemRead(reg_alloc, inst, 8);
+        return;
+    }
+    ReadMemory(code, reg_alloc, inst, cb, 8);
 }
 
 void EmitX64::EmitReadMemory16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ReadMemory(code, reg_alloc, inst, cb, 16, cb.memory.Read16);
+    if (ReadMmio(code, reg_alloc, inst, cb, &MmioHandler::Read16))
+        return;
+    if (cb.fastmem_pointer) {
+        EmitFastmemRead(reg_alloc, inst, 16);
+        return;
+    }
+    ReadMemory(code, reg_alloc, inst, cb, 16);
 }
 
-void EmitX64::EmitReadMemory32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ReadMemory(code, reg_alloc, inst, cb, 32, cb.memory.Read32);
+void EmitX64::EmitReadMemory32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (ReadMmio(code, reg_alloc, inst, cb, &MmioHandler::Read32))
+        return;
+    IR::Inst* const byte_reverse = cpu_info.has(Xbyak::util::Cpu::tMOVBE) ? FindMovbeByteReverse(block, *inst, cb) : nullptr;
+    if (cb.fastmem_pointer) {
+        EmitFastmemRead(reg_alloc, inst, 32, byte_reverse);
+        return;
+    }
+    ReadMemory(code, reg_alloc, inst, cb, 32, byte_reverse);
 }
 
-void EmitX64::EmitReadMemory64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ReadMemory(code, reg_alloc, inst, cb, 64, cb.memory.Read64);
+void EmitX64::EmitReadMemory64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (ReadMmio(code, reg_alloc, inst, cb, &MmioHandler::Read64))
+        return;
+    IR::Inst* const byte_reverse = cpu_info.has(Xbyak::util::Cpu::tMOVBE) ? FindMovbeByteReverse(block, *inst, cb) : nullptr;
+    if (cb.fastmem_pointer) {
+        EmitFastmemRead(reg_alloc, inst, 64, byte_reverse);
+        return;
+    }
+    ReadMemory(code, reg_alloc, inst, cb, 64, byte_reverse);
 }
 
 void EmitX64::EmitWriteMemory8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    WriteMemory(code, reg_alloc, inst, cb, 8, cb.memory.Write8);
+    if (WriteMmio(code, reg_alloc, inst, cb, &MmioHandler::Write8))
+        return;
+    if (cb.fastmem_pointer) {
+        EmitFastmemWrite(reg_alloc, inst, 8);
+        return;
+    }
+    WriteMemory(code, reg_alloc, inst, cb, 8);
 }
 
-void EmitX64::EmitWriteMemory16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    WriteMemory(code, reg_alloc, inst, cb, 16, cb.memory.Write16);
+void EmitX64::EmitWriteMemory16(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (WriteMmio(code, reg_alloc, inst, cb, &MmioHandler::Write16))
+        return;
+    IR::Inst* const byte_reverse = cpu_info.has(Xbyak::util::Cpu::tMOVBE) ? FindMovbeByteReverse(block, *inst, cb) : nullptr;
+    if (cb.fastmem_pointer) {
+        EmitFastmemWrite(reg_alloc, inst, 16, byte_reverse);
+        return;
+    }
+    WriteMemory(code, reg_alloc, inst, cb, 16, byte_reverse);
 }
 
-void EmitX64::EmitWriteMemory32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    WriteMemory(code, reg_alloc, inst, cb, 32, cb.memory.Write32);
+void EmitX64::EmitWriteMemory32(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (WriteMmio(code, reg_alloc, inst, cb, &MmioHandler::Write32))
+        return;
+    IR::Inst* const byte_reverse = cpu_info.has(Xbyak::util::Cpu::tMOVBE) ? FindMovbeByteReverse(block, *inst, cb) : nullptr;
+    if (cb.fastmem_pointer) {
+        EmitFastmemWrite(reg_alloc, inst, 32, byte_reverse);
+        return;
+    }
+    WriteMemory(code, reg_alloc, inst, cb, 32, byte_reverse);
 }
 
-void EmitX64::EmitWriteMemory64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    WriteMemory(code, reg_alloc, inst, cb, 64, cb.memory.Write64);
+void EmitX64::EmitWriteMemory64(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst) {
+    if (WriteMmio(code, reg_alloc, inst, cb, &MmioHandler::Write64))
+        return;
+    IR::Inst* const byte_reverse = cpu_info.has(Xbyak::util::Cpu::tMOVBE) ? FindMovbeByteReverse(block, *inst, cb) : nullptr;
+    if (cb.fastmem_pointer) {
+        EmitFastmemWrite(reg_alloc, inst, 64, byte_reverse);
+        return;
+    }
+    WriteMemory(code, reg_alloc, inst, cb, 64, byte_reverse);
 }
 
-template <typename FunctionPointer>
-static void ExclusiveWrite(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, FunctionPointer fn) {
+/**
+ * Emits a 128-bit read into an XMM register, with a single movups through fastmem or the page table. The slow
+ * path reads the two halves with the 64-bit memory read thunks, whose callbacks split accesses that cross a page.
+ */
+void EmitX64::EmitReadMemory128(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    // The register assignment matches the memory read thunks, which preserve the XMM registers.
+    reg_alloc.ScratchGpr({ HostLoc::RAX });
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 });
+    Xbyak::Xmm result = reg_alloc.DefXmm(inst);
+    Xbyak::Xmm hi = reg_alloc.ScratchXmm();
+    const bool has_inline_path = cb.fastmem_pointer || HasPageTable(cb);
+    const bool uses_page_table = !cb.fastmem_pointer && HasPageTable(cb);
+    Xbyak::Reg64 page = uses_page_table ? reg_alloc.ScratchGpr() : Xbyak::Reg64{};
+    Xbyak::Reg64 page_offset = uses_page_table ? reg_alloc.ScratchGpr() : Xbyak::Reg64{};
+
+    Xbyak::Label end, slow_path;
+    CodePtr access_location = nullptr;
+    CodePtr fallback = nullptr;
+
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+        EmitFastmemPageCrossingCheck(code, cb, vaddr_arg, vaddr.cvt32(), 16, false, slow_path);
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Read, slow_path);
+        access_location = code->getCurr();
+        code->movups(result, xword[r14 + vaddr]);
+        code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+    } else if (uses_page_table) {
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Read, slow_path);
+        EmitPageTableLookup(code, cb, vaddr.cvt32(), page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), 16, slow_path);
+        code->movups(result, xword[page + page_offset]);
+    }
+    if (has_inline_path) {
+        code->L(end);
+        code->SwitchToFarCode();
+        fallback = code->getCurr();
+        code->L(slow_path);
+    }
+
+    code->call(code->GetMemoryReadCallback(64));
+    code->movq(result, rax);
+    code->add(vaddr.cvt32(), 8);
+    code->call(code->GetMemoryReadCallback(64));
+    code->movq(hi, rax);
+    code->punpcklqdq(result, hi);
+
+    if (has_inline_path) {
+        code->jmp(end, code->T_NEAR);
+        code->SwitchToNearCode();
+    }
+    if (access_location) {
+        RegisterFastmemAccess(access_location, fallback);
+    }
+}
+
+/// Emits a 128-bit write from an XMM register, as EmitReadMemory128 emits a read.
+void EmitX64::EmitWriteMemory128(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    // The register assignment matches the memory write thunks, which preserve the XMM registers.
+    reg_alloc.ScratchGpr({ HostLoc::RAX });
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 });
+    Xbyak::Xmm value = reg_alloc.UseXmm(inst->GetArg(1));
+    Xbyak::Reg64 half = reg_alloc.ScratchGpr({ ABI_PARAM2 });
+    Xbyak::Xmm hi = reg_alloc.ScratchXmm();
+    const bool has_inline_path = cb.fastmem_pointer || HasPageTable(cb);
+    const bool uses_page_table = !cb.fastmem_pointer && HasPageTable(cb);
+    Xbyak::Reg64 page = uses_page_table ? reg_alloc.ScratchGpr() : Xbyak::Reg64{};
+    Xbyak::Reg64 page_offset = uses_page_table ? reg_alloc.ScratchGpr() : Xbyak::Reg64{};
+
+    Xbyak::Label end, slow_path;
+    CodePtr access_location = nullptr;
+    CodePtr fallback = nullptr;
+
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+        EmitFastmemPageCrossingCheck(code, cb, vaddr_arg, vaddr.cvt32(), 16, true, slow_path);
+        EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+        access_location = code->getCurr();
+        code->movups(xword[r14 + vaddr], value);
+        code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+    } else if (uses_page_table) {
+        EmitPageTableLookup(code, cb, vaddr.cvt32(), page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), 16, slow_path);
+        EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+        code->movups(xword[page + page_offset], value);
+    }
+    if (has_inline_path) {
+        code->L(end);
+        code->SwitchToFarCode();
+        fallback = code->getCurr();
+        code->L(slow_path);
+    }
+
+    code->movq(half, value);
+    code->call(code->GetMemoryWriteCallback(64));
+    code->movhlps(hi, value);
+    code->movq(half, hi);
+    code->add(vaddr.cvt32(), 8);
+    code->call(code->GetMemoryWriteCallback(64));
+
+    if (has_inline_path) {
+        code->jmp(end, code->T_NEAR);
+        code->SwitchToNearCode();
+    }
+    if (access_location) {
+        RegisterFastmemAccess(access_location, fallback);
+    }
+}
+
+/// Records the value read by an exclusive read as the expected value of the next exclusive write.
+static void SaveExclusiveValue(BlockOfCode* code, Xbyak::Reg64 value, size_t bit_size) {
+    using namespace Xbyak::util;
+
+    // Memory callbacks leave the upper bits of their return value undefined.
+    switch (bit_size) {
+    case 8:
+        code->movzx(value.cvt32(), value.cvt8());
+        break;
+    case 16:
+        code->movzx(value.cvt32(), value.cvt16());
+        break;
+    case 32:
+        code->mov(value.cvt32(), value.cvt32());
+        break;
+    case 64:
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+    code->mov(qword[r15 + offsetof(JitState, exclusive_value)], value);
+}
+
+void EmitX64::EmitExclusiveReadMemory8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Reg64 result = cb.fastmem_pointer ? EmitFastmemRead(reg_alloc, inst, 8) : ReadMemory(code, reg_alloc, inst, cb, 8);
+    if (cb.global_exclusive_monitor) {
+        SaveExclusiveValue(code, result, 8);
+    }
+}
+
+void EmitX64::EmitExclusiveReadMemory16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Reg64 result = cb.fastmem_pointer ? EmitFastmemRead(reg_alloc, inst, 16) : ReadMemory(code, reg_alloc, inst, cb, 16);
+    if (cb.global_exclusive_monitor) {
+        SaveExclusiveValue(code, result, 16);
+    }
+}
+
+void EmitX64::EmitExclusiveReadMemory32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Reg64 result = cb.fastmem_pointer ? EmitFastmemRead(reg_alloc, inst, 32) : ReadMemory(code, reg_alloc, inst, cb, 32);
+    if (cb.global_exclusive_monitor) {
+        SaveExclusiveValue(code, result, 32);
+    }
+}
+
+void EmitX64::EmitExclusiveReadMemory64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    Xbyak::Reg64 result = cb.fastmem_pointer ? EmitFastmemRead(reg_alloc, inst, 64) : ReadMemory(code, reg_alloc, inst, cb, 64);
+    if (cb.global_exclusive_monitor) {
+        SaveExclusiveValue(code, result, 64);
+    }
+}
+
+/**
+ * Emits an exclusive write for the global exclusive monitor. The write is a lock cmpxchg against the
+ * value saved by the last exclusive read, so it fails if another core has changed memory in the meantime.
+ * Accesses that the inline path cannot perform are handed to the memory write thunks instead.
+ */
+void EmitX64::EmitGlobalExclusiveWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size) {
+    using namespace Xbyak::util;
+
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    // The register assignment matches the memory write thunks, so that the slow path is just a call.
+    Xbyak::Reg64 expected = reg_alloc.ScratchGpr({ HostLoc::RAX }); // Implicit operand of cmpxchg, clobbered by the thunks
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 });
+    Xbyak::Reg64 value = reg_alloc.UseScratchGpr(inst->GetArg(1), { ABI_PARAM2 });
+    Xbyak::Reg64 value_hi = bit_size == 64 ? reg_alloc.UseScratchGpr(inst->GetArg(2)) : Xbyak::Reg64{};
+    Xbyak::Reg64 page = cb.fastmem_pointer ? Xbyak::Reg64{} : reg_alloc.ScratchGpr();
+    Xbyak::Reg64 page_offset = cb.fastmem_pointer ? Xbyak::Reg64{} : reg_alloc.ScratchGpr();
+    Xbyak::Reg32 passed = reg_alloc.DefGpr(inst).cvt32();
+
+    Xbyak::Label end, slow_path;
+
+    code->mov(passed, u32(1));
+    code->cmp(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
+    code->je(end, code->T_NEAR);
+    code->mov(expected.cvt32(), vaddr.cvt32());
+    code->xor_(expected.cvt32(), dword[r15 + offsetof(JitState, exclusive_address)]);
+    code->test(expected.cvt32(), JitState::RESERVATION_GRANULE_MASK);
+    code->jne(end, code->T_NEAR);
+    code->mov(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
+    if (bit_size == 64) {
+        code->mov(value.cvt32(), value.cvt32()); // zero extend to 64-bits
+        code->shl(value_hi, 32);
+        code->or_(value, value_hi);
+    }
+    if (cb.fastmem_pointer) {
+        EmitFastmemPageCrossingCheck(code, cb, vaddr_arg, vaddr.cvt32(), bit_size / 8, true, slow_path);
+    }
+    EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+    EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+    code->mov(expected, qword[r15 + offsetof(JitState, exclusive_value)]);
+
+    CodePtr access_location = nullptr;
+    Xbyak::RegExp address;
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+        address = r14 + vaddr;
+        access_location = code->getCurr();
+    } else {
+        EmitPageTableLookup(code, cb, vaddr.cvt32(), page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), bit_size / 8, slow_path);
+        address = page + page_offset;
+    }
+    code->lock();
+    switch (bit_size) {
+    case 8:
+        code->cmpxchg(code->byte[address], value.cvt8());
+        break;
+    case 16:
+        code->cmpxchg(word[address], value.cvt16());
+        break;
+    case 32:
+        code->cmpxchg(dword[address], value.cvt32());
+        break;
+    case 64:
+        code->cmpxchg(qword[address], value);
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+    if (access_location) {
+        // Most of these are already long enough to be backpatched.
+        const size_t access_size = code->getCurr<const u8*>() - static_cast<const u8*>(access_location);
+        if (access_size < fastmem_access_size) {
+            code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+        }
+    }
+    code->jne(end, code->T_NEAR);
+    code->xor_(passed, passed);
+    code->L(end);
+
+    code->SwitchToFarCode();
+    const CodePtr fallback = code->getCurr();
+    code->L(slow_path);
+    code->call(code->GetMemoryWriteCallback(bit_size));
+    code->xor_(passed, passed);
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+
+    if (access_location) {
+        RegisterFastmemAccess(access_location, fallback);
+    }
+}
+
+/**
+ * Emits an exclusive write for the local exclusive monitor that stores directly through the page table
+ * or fastmem, as WriteMemory does, once the monitor check has passed. Accesses that the inline path cannot
+ * perform are handed to the memory write thunks instead. Only used when there is no exclusive write callback.
+ */
+void EmitX64::EmitInlineExclusiveWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size) {
+    using namespace Xbyak::util;
+
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    // The register assignment matches the memory write thunks, so that the slow path is just a call.
+    Xbyak::Reg32 tmp = reg_alloc.ScratchGpr({ HostLoc::RAX }).cvt32(); // Clobbered by the thunks
+    Xbyak::Reg64 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 });
+    Xbyak::Reg64 value = reg_alloc.UseScratchGpr(inst->GetArg(1), { ABI_PARAM2 });
+    Xbyak::Reg64 value_hi = bit_size == 64 ? reg_alloc.UseScratchGpr(inst->GetArg(2)) : Xbyak::Reg64{};
+    Xbyak::Reg64 page = cb.fastmem_pointer ? Xbyak::Reg64{} : reg_alloc.ScratchGpr();
+    Xbyak::Reg64 page_offset = cb.fastmem_pointer ? Xbyak::Reg64{} : reg_alloc.ScratchGpr();
+    Xbyak::Reg32 passed = reg_alloc.DefGpr(inst).cvt32();
+
+    Xbyak::Label end, written, slow_path;
+
+    code->mov(passed, u32(1));
+    code->cmp(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
+    code->je(end, code->T_NEAR);
+    code->mov(tmp, vaddr.cvt32());
+    code->xor_(tmp, dword[r15 + offsetof(JitState, exclusive_address)]);
+    code->test(tmp, JitState::RESERVATION_GRANULE_MASK);
+    code->jne(end, code->T_NEAR);
+    code->mov(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
+    if (bit_size == 64) {
+        code->mov(value.cvt32(), value.cvt32()); // zero extend to 64-bits
+        code->shl(value_hi, 32);
+        code->or_(value, value_hi);
+    }
+
+    CodePtr access_location = nullptr;
+    Xbyak::RegExp address;
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr.cvt32(), vaddr.cvt32()); // Zero-extend
+        EmitFastmemPageCrossingCheck(code, cb, vaddr_arg, vaddr.cvt32(), bit_size / 8, true, slow_path);
+        EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+        address = r14 + vaddr;
+        access_location = code->getCurr();
+    } else {
+        EmitPageTableLookup(code, cb, vaddr.cvt32(), page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), bit_size / 8, slow_path);
+        EmitCodePageCheck(code, cb, vaddr.cvt32(), slow_path);
+        EmitWatchpointCheck(code, cb, vaddr.cvt32(), WatchpointKind::Write, slow_path);
+        address = page + page_offset;
+    }
+    switch (bit_size) {
+    case 8:
+        code->mov(code->byte[address], value.cvt8());
+        break;
+    case 16:
+        code->mov(word[address], value.cvt16());
+        break;
+    case 32:
+        code->mov(dword[address], value.cvt32());
+        break;
+    case 64:
+        code->mov(qword[address], value);
+        break;
+    default:
+        ASSERT_MSG(false, "Invalid bit_size");
+        break;
+    }
+    if (access_location) {
+        code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+    }
+    code->L(written);
+    code->xor_(passed, passed);
+    code->L(end);
+
+    code->SwitchToFarCode();
+    const CodePtr fallback = code->getCurr();
+    code->L(slow_path);
+    code->call(code->GetMemoryWriteCallback(bit_size));
+    code->jmp(written, code->T_NEAR);
+    code->SwitchToNearCode();
+
+    if (access_location) {
+        RegisterFastmemAccess(access_location, fallback);
+    }
+}
+
+/// Calls `callback` (see EmitX64::SetExclusiveWriteCallback), if any. Clobbers the caller-saved registers.
+static void CallExclusiveWriteCallback(BlockOfCode* code, EmitX64::ExclusiveWriteCallback callback, void* arg) {
+    using namespace Xbyak::util;
+
+    if (!callback)
+        return;
+    code->mov(code->ABI_PARAM1, reinterpret_cast<u64>(arg));
+    code->mov(code->ABI_PARAM2, r15);
+    code->CallFunction(callback);
+}
+
+static void ExclusiveWrite(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size, EmitX64::ExclusiveWriteCallback callback, void* callback_arg) {
     using namespace Xbyak::util;
     Xbyak::Label end;
 
@@ -2914,24 +5490,283 @@ static void ExclusiveWrite(BlockOfCode* code, RegAlloc& reg_alloc, IR::Inst* ins
     code->test(tmp, JitState::RESERVATION_GRANULE_MASK);
     code->jne(end);
     code->mov(code->byte[r15 + offsetof(JitState, exclusive_state)], u8(0));
-    code->CallFunction(fn);
+    code->CallMemoryWriteFunction(bit_size);
+    CallExclusiveWriteCallback(code, callback, callback_arg);
     code->xor_(passed, passed);
     code->L(end);
 }
 
+/// Offsets into JitState of the guest registers transferred by a block memory access, in memory order.
+static std::vector<size_t> GetTransferredRegisterOffsets(IR::Inst* inst) {
+    std::vector<size_t> offsets;
+    switch (inst->GetOpcode()) {
+    case IR::Opcode::ReadMemoryToRegisters:
+    case IR::Opcode::WriteMemoryFromRegisters: {
+        const u32 list = inst->GetArg(1).GetU32();
+        for (size_t i = 0; i <= 14; i++) {
+            if (Common::Bit(i, list)) {
+                offsets.emplace_back(offsetof(JitState, Reg) + sizeof(u32) * i);
+            }
+        }
+        break;
+    }
+    case IR::Opcode::ReadMemoryToExtRegisters:
+    case IR::Opcode::WriteMemoryFromExtRegisters: {
+        // A double register occupies the two words that alias its pair of single registers.
+        const Arm::ExtReg first = inst->GetArg(1).GetExtRegRef();
+        const size_t words_per_reg = Arm::IsSingleExtReg(first) ? 1 : 2;
+        const size_t first_word = Arm::RegNumber(first) * words_per_reg;
+        const size_t word_count = inst->GetArg(2).GetU8() * words_per_reg;
+        for (size_t i = 0; i < word_count; i++) {
+            offsets.emplace_back(offsetof(JitState, ExtReg) + sizeof(u32) * (first_word + i));
+        }
+        break;
+    }
+    default:
+        ASSERT_MSG(false, "Not a block memory access");
+        break;
+    }
+    return offsets;
+}
+
+void EmitX64::EmitReadMemoryBlock(RegAlloc& reg_alloc, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const std::vector<size_t> offsets = GetTransferredRegisterOffsets(inst);
+    const IR::Value vaddr_arg = inst->GetArg(0);
+
+    // The register assignment matches the memory read thunks, which the slow path calls once per word.
+    reg_alloc.ScratchGpr({ HostLoc::RAX });
+    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 }).cvt32();
+
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr, vaddr); // Zero-extend
+        for (size_t offset : offsets) {
+            Xbyak::Label end, slow_path;
+
+            EmitFastmemPageCrossingCheck(code, cb, IR::Value{}, vaddr, sizeof(u32), false, slow_path);
+            EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Read, slow_path);
+            const CodePtr access_location = code->getCurr();
+            code->mov(eax, dword[r14 + vaddr.cvt64()]);
+            code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+            code->L(end);
+            code->mov(dword[r15 + offset], eax);
+            code->add(vaddr, 4);
+
+            code->SwitchToFarCode();
+            const CodePtr fallback = code->getCurr();
+            code->L(slow_path);
+            code->call(code->GetMemoryReadCallback(32));
+            code->jmp(end, code->T_NEAR);
+            code->SwitchToNearCode();
+
+            RegisterFastmemAccess(access_location, fallback);
+        }
+        return;
+    }
+
+    Xbyak::Label slow_path, end;
+
+    if (HasPageTable(cb)) {
+        Xbyak::Reg64 page = reg_alloc.ScratchGpr();
+        Xbyak::Reg64 page_offset = reg_alloc.ScratchGpr();
+
+        // A single page check covers the whole range.
+        EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Read, slow_path);
+        EmitPageTableLookup(code, cb, vaddr, page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), offsets.size() * sizeof(u32), slow_path);
+        for (size_t i = 0; i < offsets.size(); i++) {
+            code->mov(eax, dword[page + page_offset + i * sizeof(u32)]);
+            code->mov(dword[r15 + offsets[i]], eax);
+        }
+        code->L(end);
+
+        code->SwitchToFarCode();
+        code->L(slow_path);
+    }
+
+    for (size_t offset : offsets) {
+        code->call(code->GetMemoryReadCallback(32));
+        code->mov(dword[r15 + offset], eax);
+        code->add(vaddr, 4);
+    }
+
+    if (HasPageTable(cb)) {
+        code->jmp(end, code->T_NEAR);
+        code->SwitchToNearCode();
+    }
+}
+
+void EmitX64::EmitWriteMemoryBlock(RegAlloc& reg_alloc, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    const std::vector<size_t> offsets = GetTransferredRegisterOffsets(inst);
+    const IR::Value vaddr_arg = inst->GetArg(0);
+
+    // The register assignment matches the memory write thunks, which the slow path calls once per word.
+    reg_alloc.ScratchGpr({ HostLoc::RAX });
+    Xbyak::Reg32 vaddr = reg_alloc.UseScratchGpr(vaddr_arg, { ABI_PARAM1 }).cvt32();
+    Xbyak::Reg32 value = reg_alloc.ScratchGpr({ ABI_PARAM2 }).cvt32();
+
+    if (cb.fastmem_pointer) {
+        // r14 contains fastmem_pointer (see BlockOfCode::GenRunCode)
+        code->mov(vaddr, vaddr); // Zero-extend
+        for (size_t offset : offsets) {
+            Xbyak::Label end, slow_path;
+
+            code->mov(value, dword[r15 + offset]);
+            EmitFastmemPageCrossingCheck(code, cb, IR::Value{}, vaddr, sizeof(u32), true, slow_path);
+            EmitCodePageCheck(code, cb, vaddr, slow_path);
+            EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Write, slow_path);
+            const CodePtr access_location = code->getCurr();
+            code->mov(dword[r14 + vaddr.cvt64()], value);
+            code->EnsurePatchLocationSize(access_location, fastmem_access_size);
+            code->L(end);
+            code->add(vaddr, 4);
+
+            code->SwitchToFarCode();
+            const CodePtr fallback = code->getCurr();
+            code->L(slow_path);
+            code->call(code->GetMemoryWriteCallback(32));
+            code->jmp(end, code->T_NEAR);
+            code->SwitchToNearCode();
+
+            RegisterFastmemAccess(access_location, fallback);
+        }
+        return;
+    }
+
+    Xbyak::Label slow_path, end;
+
+    if (HasPageTable(cb)) {
+        Xbyak::Reg64 page = reg_alloc.ScratchGpr();
+        Xbyak::Reg64 page_offset = reg_alloc.ScratchGpr();
+
+        // A single page check covers the whole range.
+        EmitPageTableLookup(code, cb, vaddr, page, page_offset, slow_path);
+        EmitPageCrossingCheck(code, vaddr_arg, page_offset.cvt32(), offsets.size() * sizeof(u32), slow_path);
+        EmitCodePageCheck(code, cb, vaddr, slow_path);
+        EmitWatchpointCheck(code, cb, vaddr, WatchpointKind::Write, slow_path);
+        for (size_t i = 0; i < offsets.size(); i++) {
+            code->mov(value, dword[r15 + offsets[i]]);
+            code->mov(dword[page + page_offset + i * sizeof(u32)], value);
+        }
+        code->L(end);
+
+        code->SwitchToFarCode();
+        code->L(slow_path);
+    }
+
+    for (size_t offset : offsets) {
+        code->mov(value, dword[r15 + offset]);
+        code->call(code->GetMemoryWriteCallback(32));
+        code->add(vaddr, 4);
+    }
+
+    if (HasPageTable(cb)) {
+        code->jmp(end, code->T_NEAR);
+        code->SwitchToNearCode();
+    }
+}
+
+void EmitX64::EmitTraceMemoryAccess(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    using namespace Xbyak::util;
+
+    static_assert(sizeof(MemoryAccessRecord) == 12, "The offset computation below relies on the size of a record");
+
+    const IR::Value vaddr_arg = inst->GetArg(0);
+    const u32 pc = inst->GetArg(1).GetU32();
+    const u8 size = inst->GetArg(2).GetU8();
+    const bool is_write = inst->GetArg(3).GetU1();
+    boost::optional<Xbyak::Reg32> vaddr;
+    if (!vaddr_arg.IsImmediate()) {
+        vaddr = reg_alloc.UseGpr(vaddr_arg).cvt32();
+    }
+    Xbyak::Reg64 count = reg_alloc.ScratchGpr();
+    Xbyak::Reg64 record = reg_alloc.ScratchGpr();
+
+    code->mov(count, qword[r15 + offsetof(JitState, memory_trace_count)]);
+    code->mov(record.cvt32(), count.cvt32());
+    code->and_(record.cvt32(), static_cast<u32>(cb.memory_trace_size - 1));
+    code->lea(record, ptr[record + record * 2]);
+    code->shl(record, 2);
+    code->add(record, qword[r15 + offsetof(JitState, memory_trace)]);
+    code->mov(dword[record + offsetof(MemoryAccessRecord, pc)], pc);
+    if (vaddr) {
+        code->mov(dword[record + offsetof(MemoryAccessRecord, vaddr)], *vaddr);
+    } else {
+        code->mov(dword[record + offsetof(MemoryAccessRecord, vaddr)], vaddr_arg.GetU32());
+    }
+    code->mov(code->byte[record + offsetof(MemoryAccessRecord, size)], size);
+    code->mov(code->byte[record + offsetof(MemoryAccessRecord, is_write)], u8(is_write ? 1 : 0));
+    // x64 does not reorder stores, so readers that see the new count also see the record.
+    code->inc(count);
+    code->mov(qword[r15 + offsetof(JitState, memory_trace_count)], count);
+}
+
+void EmitX64::EmitReadMemoryToRegisters(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitReadMemoryBlock(reg_alloc, inst);
+}
+
+void EmitX64::EmitWriteMemoryFromRegisters(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitWriteMemoryBlock(reg_alloc, inst);
+}
+
+void EmitX64::EmitReadMemoryToExtRegisters(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitReadMemoryBlock(reg_alloc, inst);
+}
+
+void EmitX64::EmitWriteMemoryFromExtRegisters(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    EmitWriteMemoryBlock(reg_alloc, inst);
+}
+
 void EmitX64::EmitExclusiveWriteMemory8(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ExclusiveWrite(code, reg_alloc, inst, cb.memory.Write8);
+    if (cb.global_exclusive_monitor) {
+        EmitGlobalExclusiveWrite(reg_alloc, inst, 8);
+        return;
+    }
+    if (!(concurrent_execution && exclusive_write_callback) && (HasPageTable(cb) || cb.fastmem_pointer)) {
+        EmitInlineExclusiveWrite(reg_alloc, inst, 8);
+        return;
+    }
+    ExclusiveWrite(code, reg_alloc, inst, 8, concurrent_execution ? exclusive_write_callback : nullptr, exclusive_write_callback_arg);
 }
 
 void EmitX64::EmitExclusiveWriteMemory16(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ExclusiveWrite(code, reg_alloc, inst, cb.memory.Write16);
+    if (cb.global_exclusive_monitor) {
+        EmitGlobalExclusiveWrite(reg_alloc, inst, 16);
+        return;
+    }
+    if (!(concurrent_execution && exclusive_write_callback) && (HasPageTable(cb) || cb.fastmem_pointer)) {
+        EmitInlineExclusiveWrite(reg_alloc, inst, 16);
+        return;
+    }
+    ExclusiveWrite(code, reg_alloc, inst, 16, concurrent_execution ? exclusive_write_callback : nullptr, exclusive_write_callback_arg);
 }
 
 void EmitX64::EmitExclusiveWriteMemory32(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    ExclusiveWrite(code, reg_alloc, inst, cb.memory.Write32);
+    if (cb.global_exclusive_monitor) {
+        EmitGlobalExclusiveWrite(reg_alloc, inst, 32);
+        return;
+    }
+    if (!(concurrent_execution && exclusive_write_callback) && (HasPageTable(cb) || cb.fastmem_pointer)) {
+        EmitInlineExclusiveWrite(reg_alloc, inst, 32);
+        return;
+    }
+    ExclusiveWrite(code, reg_alloc, inst, 32, concurrent_execution ? exclusive_write_callback : nullptr, exclusive_write_callback_arg);
 }
 
 void EmitX64::EmitExclusiveWriteMemory64(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    if (cb.global_exclusive_monitor) {
+        EmitGlobalExclusiveWrite(reg_alloc, inst, 64);
+        return;
+    }
+    if (!(concurrent_execution && exclusive_write_callback) && (HasPageTable(cb) || cb.fastmem_pointer)) {
+        EmitInlineExclusiveWrite(reg_alloc, inst, 64);
+        return;
+    }
+
     using namespace Xbyak::util;
     Xbyak::Label end;
 
@@ -2952,7 +5787,8 @@ void EmitX64::EmitExclusiveWriteMemory64(RegAlloc& reg_alloc, IR::Block&, IR::In
     code->mov(value.cvt32(), value.cvt32()); // zero extend to 64-bits
     code->shl(value_hi, 32);
     code->or_(value, value_hi);
-    code->CallFunction(cb.memory.Write64);
+    code->CallMemoryWriteFunction(64);
+    CallExclusiveWriteCallback(code, concurrent_execution ? exclusive_write_callback : nullptr, exclusive_write_callback_arg);
     code->xor_(passed, passed);
     code->L(end);
 }
@@ -2961,15 +5797,19 @@ static void EmitCoprocessorException() {
     ASSERT_MSG(false, "Should raise coproc exception here");
 }
 
-static void CallCoprocCallback(BlockOfCode* code, RegAlloc& reg_alloc, Jit* jit_interface, Coprocessor::Callback callback, IR::Inst* inst = nullptr, IR::Value arg0 = {}, IR::Value arg1 = {}) {
-    reg_alloc.HostCall(inst, {}, {}, arg0, arg1);
+static void CallCoprocCallback(BlockOfCode* code, RegAlloc& reg_alloc, Coprocessor::Callback callback, IR::Inst* inst = nullptr, IR::Value arg0 = {}, IR::Value arg1 = {}) {
+    using namespace Xbyak::util;
 
-    code->mov(code->ABI_PARAM1, reinterpret_cast<u64>(jit_interface));
-    if (callback.user_arg) {
-        code->mov(code->ABI_PARAM2, reinterpret_cast<u64>(*callback.user_arg));
-    }
+    const auto live = reg_alloc.HostCallSavingLiveRegisters(inst, {}, {}, arg0, arg1);
 
-    code->CallFunction(callback.function);
+    code->CallSavingRegisters(live, [code, callback]{
+        code->mov(code->ABI_PARAM1, qword[r15 + offsetof(JitState, jit_interface)]);
+        if (callback.user_arg) {
+            code->mov(code->ABI_PARAM2, reinterpret_cast<u64>(*callback.user_arg));
+        }
+
+        code->CallCallback(CallbackKind::Coprocessor, callback.function);
+    });
 }
 
 void EmitX64::EmitCoprocInternalOperation(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
@@ -2995,7 +5835,7 @@ void EmitX64::EmitCoprocInternalOperation(RegAlloc& reg_alloc, IR::Block&, IR::I
         return;
     }
 
-    CallCoprocCallback(code, reg_alloc, jit_interface, *action);
+    CallCoprocCallback(code, reg_alloc, *action);
 }
 
 void EmitX64::EmitCoprocSendOneWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
@@ -3022,7 +5862,7 @@ void EmitX64::EmitCoprocSendOneWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* i
         EmitCoprocessorException();
         return;
     case 1:
-        CallCoprocCallback(code, reg_alloc, jit_interface, boost::get<Coprocessor::Callback>(action), nullptr, word);
+        CallCoprocCallback(code, reg_alloc, boost::get<Coprocessor::Callback>(action), nullptr, word);
         return;
     case 2: {
         u32* destination_ptr = boost::get<u32*>(action);
@@ -3063,7 +5903,7 @@ void EmitX64::EmitCoprocSendTwoWords(RegAlloc& reg_alloc, IR::Block&, IR::Inst*
         EmitCoprocessorException();
         return;
     case 1:
-        CallCoprocCallback(code, reg_alloc, jit_interface, boost::get<Coprocessor::Callback>(action), nullptr, word1, word2);
+        CallCoprocCallback(code, reg_alloc, boost::get<Coprocessor::Callback>(action), nullptr, word1, word2);
         return;
     case 2: {
         auto destination_ptrs = boost::get<std::array<u32*, 2>>(action);
@@ -3100,13 +5940,20 @@ void EmitX64::EmitCoprocGetOneWord(RegAlloc& reg_alloc, IR::Block&, IR::Inst* in
         return;
     }
 
+    if (const auto constant = coproc->GetConstantOneWord(two, opc1, CRn, CRm, opc2)) {
+        // Usually folded by constant propagation already, but cold blocks are not constant propagated.
+        Xbyak::Reg32 reg_word = reg_alloc.DefGpr(inst).cvt32();
+        code->mov(reg_word, *constant);
+        return;
+    }
+
     auto action = coproc->CompileGetOneWord(two, opc1, CRn, CRm, opc2);
     switch (action.which()) {
     case 0:
         EmitCoprocessorException();
         return;
     case 1:
-        CallCoprocCallback(code, reg_alloc, jit_interface, boost::get<Coprocessor::Callback>(action), inst);
+        CallCoprocCallback(code, reg_alloc, boost::get<Coprocessor::Callback>(action), inst);
         return;
     case 2: {
         u32* source_ptr = boost::get<u32*>(action);
@@ -3144,7 +5991,7 @@ void EmitX64::EmitCoprocGetTwoWords(RegAlloc& reg_alloc, IR::Block&, IR::Inst* i
         EmitCoprocessorException();
         return;
     case 1:
-        CallCoprocCallback(code, reg_alloc, jit_interface, boost::get<Coprocessor::Callback>(action), inst);
+        CallCoprocCallback(code, reg_alloc, boost::get<Coprocessor::Callback>(action), inst);
         return;
     case 2: {
         auto source_ptrs = boost::get<std::array<u32*, 2>>(action);
@@ -3191,40 +6038,253 @@ void EmitX64::EmitCoprocLoadWords(RegAlloc& reg_alloc, IR::Block&, IR::Inst* ins
         return;
     }
 
-    CallCoprocCallback(code, reg_alloc, jit_interface, *action, nullptr, address);
+    CallCoprocCallback(code, reg_alloc, *action, nullptr, address);
+}
+
+void EmitX64::EmitCoprocStoreWords(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
+    auto coproc_info = inst->GetArg(0).GetCoprocInfo();
+
+    size_t coproc_num = coproc_info[0];
+    bool two = coproc_info[1] != 0;
+    bool long_transfer = coproc_info[2] != 0;
+    Arm::CoprocReg CRd = static_cast<Arm::CoprocReg>(coproc_info[3]);
+    bool has_option = coproc_info[4] != 0;
+    boost::optional<u8> option{has_option, coproc_info[5]};
+
+    IR::Value address = inst->GetArg(1);
+
+    std::shared_ptr<Coprocessor> coproc = cb.coprocessors[coproc_num];
+    if (!coproc) {
+        EmitCoprocessorException();
+        return;
+    }
+
+    auto action = coproc->CompileStoreWords(two, long_transfer, CRd, option);
+    if (!action) {
+        EmitCoprocessorException();
+        return;
+    }
+
+    CallCoprocCallback(code, reg_alloc, *action, nullptr, address);
+}
+
+/// Whether the emitted code for an instruction with this opcode depends on or updates the guest MXCSR.
+static bool UsesGuestMxcsr(IR::Opcode opcode) {
+    switch (opcode) {
+    case IR::Opcode::FPAdd32:
+    case IR::Opcode::FPAdd64:
+    case IR::Opcode::FPCompare32:
+    case IR::Opcode::FPCompare64:
+    case IR::Opcode::FPDiv32:
+    case IR::Opcode::FPDiv64:
+    case IR::Opcode::FPMul32:
+    case IR::Opcode::FPMul64:
+    case IR::Opcode::FPMulAdd32:
+    case IR::Opcode::FPMulAdd64:
+    case IR::Opcode::FPSqrt32:
+    case IR::Opcode::FPSqrt64:
+    case IR::Opcode::FPSub32:
+    case IR::Opcode::FPSub64:
+    case IR::Opcode::FPSingleToDouble:
+    case IR::Opcode::FPDoubleToSingle:
+    case IR::Opcode::FPSingleToU32:
+    case IR::Opcode::FPSingleToS32:
+    case IR::Opcode::FPDoubleToU32:
+    case IR::Opcode::FPDoubleToS32:
+    case IR::Opcode::FPU32ToSingle:
+    case IR::Opcode::FPS32ToSingle:
+    case IR::Opcode::FPU32ToDouble:
+    case IR::Opcode::FPS32ToDouble:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Whether any instruction in block needs the guest MXCSR. Other blocks run with whichever MXCSR is current.
+bool EmitX64::BlockUsesGuestMxcsr(const IR::Block& block) {
+    return std::any_of(block.begin(), block.end(), [](const IR::Inst& inst) { return UsesGuestMxcsr(inst.GetOpcode()); });
+}
+
+/// Switches in the guest MXCSR unless it is already current, which it is once any block since entry has done this.
+void EmitX64::EmitEnsureGuestMxcsr() {
+    using namespace Xbyak::util;
+
+    Xbyak::Label end, switch_mxcsr;
+
+    code->cmp(code->byte[r15 + offsetof(JitState, guest_MXCSR_active)], u8(0));
+    code->je(switch_mxcsr, code->T_NEAR);
+    code->L(end);
+
+    code->SwitchToFarCode();
+    code->L(switch_mxcsr);
+    code->SwitchMxcsrOnEntry();
+    code->jmp(end, code->T_NEAR);
+    code->SwitchToNearCode();
+}
+
+/// Whether inst is emitted as a call to the host whose arguments are allocated as by RegAlloc::HostCall, in order.
+bool EmitX64::IsHostCall(const IR::Inst& inst) const {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::CallSupervisor:
+    case IR::Opcode::ProfileCall:
+    case IR::Opcode::ProfileReturn:
+        return true;
+    case IR::Opcode::ReadMemory8:
+    case IR::Opcode::ReadMemory16:
+    case IR::Opcode::ReadMemory32:
+    case IR::Opcode::ReadMemory64:
+    case IR::Opcode::WriteMemory8:
+    case IR::Opcode::WriteMemory16:
+    case IR::Opcode::WriteMemory32:
+    case IR::Opcode::WriteMemory64:
+        return !cb.fastmem_pointer && !HasPageTable(cb);
+    case IR::Opcode::ExclusiveWriteMemory8:
+    case IR::Opcode::ExclusiveWriteMemory16:
+    case IR::Opcode::ExclusiveWriteMemory32:
+    case IR::Opcode::ExclusiveWriteMemory64:
+        // See EmitExclusiveWriteMemory64 for when the write is made inline instead.
+        if (cb.global_exclusive_monitor)
+            return false;
+        return (concurrent_execution && exclusive_write_callback) || (!cb.fastmem_pointer && !HasPageTable(cb));
+    default:
+        return false;
+    }
+}
+
+/// Whether NaN results of FP operations in block must be replaced with the default NaN, as FPSCR.DN requires.
+bool EmitX64::UseDefaultNaN(const IR::Block& block) const {
+    return cb.accurate_nan && block.Location().FPSCR().DN();
+}
+
+void EmitX64::EmitAddCycles(size_t cycles) {
+    using namespace Xbyak::util;
+    ASSERT(cycles < std::numeric_limits<u32>::max());
+    code->sub(qword[r15 + offsetof(JitState, cycles_remaining)], static_cast<u32>(cycles));
+}
+
+void EmitX64::EmitExecutionCount(u64* execution_count, Profiling profiling) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label hot;
+
+    code->mov(rax, reinterpret_cast<u64>(execution_count));
+    code->inc(qword[rax]);
+    if (profiling == Profiling::Count)
+        return;
+    code->cmp(qword[rax], static_cast<u32>(cb.hot_block_threshold));
+    code->je(hot, code->T_NEAR);
+
+    // Guest state is that of the start of this block, so we can return to host to have it retranslated.
+    code->SwitchToFarCode();
+    code->L(hot);
+    EmitCountExit(ExitReason::TierUp);
+    code->ReturnFromRunCode();
+    code->SwitchToNearCode();
+}
+
+void EmitX64::EmitRegisterProfile(const std::vector<Arm::Reg>& registers, u64* profile) {
+    using namespace Xbyak::util;
+
+    code->mov(rax, reinterpret_cast<u64>(profile));
+    for (size_t i = 0; i < registers.size(); i++) {
+        Xbyak::Label record, unchanged;
+        code->mov(ecx, MJitStateReg(registers[i]));
+        // Until the first entry has been recorded, the count is zero and the value slot holds nothing.
+        code->cmp(qword[rax + i * 16 + 8], 0);
+        code->je(record);
+        code->cmp(ecx, dword[rax + i * 16]);
+        code->je(unchanged);
+        code->L(record);
+        code->mov(dword[rax + i * 16], ecx);
+        code->inc(qword[rax + i * 16 + 8]);
+        code->L(unchanged);
+    }
+}
+
+void EmitX64::EmitRegisterGuards(const IR::Block& block, u64* guard_failures) {
+    using namespace Xbyak::util;
+
+    Xbyak::Label failed;
+
+    for (const auto& guard : block.RegisterGuards()) {
+        code->cmp(MJitStateReg(guard.first), guard.second);
+        code->jne(failed, code->T_NEAR);
+    }
+
+    // Guest state is that of the start of this block, so we can return to host to have it retranslated.
+    code->SwitchToFarCode();
+    code->L(failed);
+    code->mov(rax, reinterpret_cast<u64>(guard_failures));
+    code->inc(qword[rax]);
+    EmitCountExit(ExitReason::RegisterGuard);
+    code->ReturnFromRunCode();
+    code->SwitchToNearCode();
+}
+
+u64* EmitX64::AllocateCounters(size_t count) {
+    code->SwitchToFarCode();
+    code->align(sizeof(u64));
+    u64* counters = reinterpret_cast<u64*>(code->GetWritablePointer(code->getCurr()));
+    for (size_t i = 0; i < count; i++) {
+        code->dq(0);
+    }
+    code->SwitchToNearCode();
+    return counters;
 }
 
-void EmitX64::EmitCoprocStoreWords(RegAlloc& reg_alloc, IR::Block&, IR::Inst* inst) {
-    auto coproc_info = inst->GetArg(0).GetCoprocInfo();
+void EmitX64::EmitCountExit(ExitReason reason) {
+    using namespace Xbyak::util;
 
-    size_t coproc_num = coproc_info[0];
-    bool two = coproc_info[1] != 0;
-    bool long_transfer = coproc_info[2] != 0;
-    Arm::CoprocReg CRd = static_cast<Arm::CoprocReg>(coproc_info[3]);
-    bool has_option = coproc_info[4] != 0;
-    boost::optional<u8> option{has_option, coproc_info[5]};
+    if (!cb.count_exits)
+        return;
 
-    IR::Value address = inst->GetArg(1);
+    const size_t index = static_cast<size_t>(reason);
+    code->inc(qword[r15 + offsetof(JitState, exit_counts) + index * sizeof(u64)]);
+    code->mov(rax, reinterpret_cast<u64>(&current_exit_counts[index]));
+    code->inc(qword[rax]);
+}
 
-    std::shared_ptr<Coprocessor> coproc = cb.coprocessors[coproc_num];
-    if (!coproc) {
-        EmitCoprocessorException();
-        return;
-    }
+void EmitX64::EmitCountLink(const IR::LocationDescriptor& target) {
+    using namespace Xbyak::util;
 
-    auto action = coproc->CompileStoreWords(two, long_transfer, CRd, option);
-    if (!action) {
-        EmitCoprocessorException();
+    if (!cb.count_exits)
         return;
-    }
 
-    CallCoprocCallback(code, reg_alloc, jit_interface, *action, nullptr, address);
+    u64* const counter = AllocateCounters(1);
+    current_link_counts.emplace_back(target, counter);
+    code->mov(rax, reinterpret_cast<u64>(counter));
+    code->inc(qword[rax]);
 }
 
-void EmitX64::EmitAddCycles(size_t cycles) {
+Xbyak::Label EmitX64::EmitCountedExit(ExitReason reason, const void* target) {
+    Xbyak::Label label;
+    code->SwitchToFarCode();
+    code->L(label);
+    EmitCountExit(reason);
+    code->jmp(target);
+    code->SwitchToNearCode();
+    return label;
+}
+
+/// Stops execution before anything in `block` is executed, unless execution is resuming from its breakpoint.
+void EmitX64::EmitBreakpointCheck(const IR::Block& block) {
     using namespace Xbyak::util;
-    ASSERT(cycles < std::numeric_limits<u32>::max());
-    code->sub(qword[r15 + offsetof(JitState, cycles_remaining)], static_cast<u32>(cycles));
+
+    Xbyak::Label stop;
+
+    const u32 pc = block.Location().PC();
+    code->cmp(dword[r15 + offsetof(JitState, breakpoint_resume_pc)], pc);
+    code->jne(stop, code->T_NEAR);
+    code->mov(dword[r15 + offsetof(JitState, breakpoint_resume_pc)], u32(0xFFFFFFFF));
+
+    // Guest state is that of the start of this block, except for PC, which links to it do not write.
+    code->SwitchToFarCode();
+    code->L(stop);
+    code->mov(MJitStateReg(Arm::Reg::PC), pc);
+    code->mov(code->byte[r15 + offsetof(JitState, breakpoint_hit)], u8(1));
+    code->ReturnFromRunCode();
+    code->SwitchToNearCode();
 }
 
 static Xbyak::Label EmitCond(BlockOfCode* code, Arm::Cond cond) {
@@ -3232,107 +6292,143 @@ static Xbyak::Label EmitCond(BlockOfCode* code, Arm::Cond cond) {
 
     Xbyak::Label label;
 
-    const Xbyak::Reg32 cpsr = eax;
-    code->mov(cpsr, MJitStateCpsr());
-
-    constexpr size_t n_shift = 31;
-    constexpr size_t z_shift = 30;
-    constexpr size_t c_shift = 29;
-    constexpr size_t v_shift = 28;
-    constexpr u32 n_mask = 1u << n_shift;
-    constexpr u32 z_mask = 1u << z_shift;
-    constexpr u32 c_mask = 1u << c_shift;
-    constexpr u32 v_mask = 1u << v_shift;
+    // Load NZCV into the host flags, so every condition is tested by a single jump:
+    // N to SF, Z to ZF and C to CF (via sahf), and V to OF (via the add).
+    code->mov(eax, MJitStateCpsr());
+    code->shr(eax, 28);
+    code->imul(eax, eax, 0b0001000010000001); // ah = N Z C V 0 N Z C, al = V 0 0 0 N Z C V
+    code->add(al, al);
+    code->sahf();
 
     switch (cond) {
     case Arm::Cond::EQ: //z
-        code->test(cpsr, z_mask);
-        code->jnz(label);
+        code->jz(label);
         break;
     case Arm::Cond::NE: //!z
-        code->test(cpsr, z_mask);
-        code->jz(label);
+        code->jnz(label);
         break;
     case Arm::Cond::CS: //c
-        code->test(cpsr, c_mask);
-        code->jnz(label);
+        code->jc(label);
         break;
     case Arm::Cond::CC: //!c
-        code->test(cpsr, c_mask);
-        code->jz(label);
+        code->jnc(label);
         break;
     case Arm::Cond::MI: //n
-        code->test(cpsr, n_mask);
-        code->jnz(label);
+        code->js(label);
         break;
     case Arm::Cond::PL: //!n
-        code->test(cpsr, n_mask);
-        code->jz(label);
+        code->jns(label);
         break;
     case Arm::Cond::VS: //v
-        code->test(cpsr, v_mask);
-        code->jnz(label);
+        code->jo(label);
         break;
     case Arm::Cond::VC: //!v
-        code->test(cpsr, v_mask);
-        code->jz(label);
+        code->jno(label);
         break;
-    case Arm::Cond::HI: { //c & !z
-        code->and_(cpsr, z_mask | c_mask);
-        code->cmp(cpsr, c_mask);
-        code->je(label);
+    case Arm::Cond::HI: //c & !z
+        code->cmc();
+        code->ja(label);
         break;
-    }
-    case Arm::Cond::LS: { //!c | z
-        code->and_(cpsr, z_mask | c_mask);
-        code->cmp(cpsr, c_mask);
-        code->jne(label);
+    case Arm::Cond::LS: //!c | z
+        code->cmc();
+        code->jbe(label);
+        break;
+    case Arm::Cond::GE: // n == v
+        code->jge(label);
+        break;
+    case Arm::Cond::LT: // n != v
+        code->jl(label);
+        break;
+    case Arm::Cond::GT: // !z & (n == v)
+        code->jg(label);
+        break;
+    case Arm::Cond::LE: // z | (n != v)
+        code->jle(label);
+        break;
+    default:
+        ASSERT_MSG(false, "Unknown cond %zu", static_cast<size_t>(cond));
         break;
     }
-    case Arm::Cond::GE: { // n == v
-        code->and_(cpsr, n_mask | v_mask);
-        code->jz(label);
-        code->cmp(cpsr, n_mask | v_mask);
+
+    return label;
+}
+
+/**
+ * Branches on cond as EmitCond would once VMRS APSR_nzcv, FPSCR has copied the result of comparing the
+ * operands of branch to the CPSR flags, but from the host flags of comparing them again. ucomiss sets
+ * ZF, PF and CF to 1 1 1 when unordered, 0 0 1 when less, 1 0 0 when equal and 0 0 0 when greater, so
+ * the conditions that are false when unordered compare the operands the other way around.
+ */
+Xbyak::Label EmitX64::EmitFPCompareCond(const FPCompareBranch& branch, Arm::Cond cond) {
+    Xbyak::Label label;
+
+    // The first compare has already raised any exception, so both are quiet.
+    const auto compare = [&](bool swapped) {
+        const Xbyak::Xmm& lhs = swapped ? branch.b : branch.a;
+        const Xbyak::Xmm& rhs = swapped ? branch.a : branch.b;
+        if (branch.is_double) {
+            code->ucomisd(lhs, rhs);
+        } else {
+            code->ucomiss(lhs, rhs);
+        }
+    };
+
+    switch (cond) {
+    case Arm::Cond::EQ: { // equal
+        Xbyak::Label unordered;
+        compare(false);
+        code->jp(unordered);
         code->je(label);
+        code->L(unordered);
         break;
     }
-    case Arm::Cond::LT: { // n != v
-        Xbyak::Label fail;
-        code->and_(cpsr, n_mask | v_mask);
-        code->jz(fail);
-        code->cmp(cpsr, n_mask | v_mask);
+    case Arm::Cond::NE: // not equal
+        compare(false);
+        code->jp(label);
         code->jne(label);
-        code->L(fail);
-        break;
-    }
-    case Arm::Cond::GT: { // !z & (n == v)
-        const Xbyak::Reg32 tmp1 = ebx;
-        const Xbyak::Reg32 tmp2 = esi;
-        code->mov(tmp1, cpsr);
-        code->mov(tmp2, cpsr);
-        code->shr(tmp1, n_shift);
-        code->shr(tmp2, v_shift);
-        code->shr(cpsr, z_shift);
-        code->xor_(tmp1, tmp2);
-        code->or_(tmp1, cpsr);
-        code->test(tmp1, 1);
-        code->jz(label);
         break;
-    }
-    case Arm::Cond::LE: { // z | (n != v)
-        const Xbyak::Reg32 tmp1 = ebx;
-        const Xbyak::Reg32 tmp2 = esi;
-        code->mov(tmp1, cpsr);
-        code->mov(tmp2, cpsr);
-        code->shr(tmp1, n_shift);
-        code->shr(tmp2, v_shift);
-        code->shr(cpsr, z_shift);
-        code->xor_(tmp1, tmp2);
-        code->or_(tmp1, cpsr);
-        code->test(tmp1, 1);
-        code->jnz(label);
+    case Arm::Cond::CS: // not less
+    case Arm::Cond::PL:
+        compare(true);
+        code->jbe(label);
+        break;
+    case Arm::Cond::CC: // less
+    case Arm::Cond::MI:
+        compare(true);
+        code->ja(label);
+        break;
+    case Arm::Cond::VS: // unordered
+        compare(false);
+        code->jp(label);
+        break;
+    case Arm::Cond::VC: // ordered
+        compare(false);
+        code->jnp(label);
+        break;
+    case Arm::Cond::HI: // greater or unordered
+        compare(true);
+        code->jb(label);
+        break;
+    case Arm::Cond::LS: // less or equal
+        compare(true);
+        code->jae(label);
+        break;
+    case Arm::Cond::GE: // greater or equal
+        compare(false);
+        code->jae(label);
+        break;
+    case Arm::Cond::LT: // less or unordered
+        compare(false);
+        code->jb(label);
+        break;
+    case Arm::Cond::GT: // greater
+        compare(false);
+        code->ja(label);
+        break;
+    case Arm::Cond::LE: // not greater
+        compare(false);
+        code->jbe(label);
         break;
-    }
     default:
         ASSERT_MSG(false, "Unknown cond %zu", static_cast<size_t>(cond));
         break;
@@ -3355,7 +6451,26 @@ void EmitX64::EmitCondPrelude(const IR::Block& block) {
     code->L(pass);
 }
 
-void EmitX64::EmitTerminal(IR::Terminal terminal, IR::LocationDescriptor initial_location) {
+/// Updates the CPSR IT bits to the If-Then state of `next`, given they hold that of `initial_location`.
+static void EmitUpdateITState(BlockOfCode* code, IR::LocationDescriptor next, IR::LocationDescriptor initial_location) {
+    if (next.IT() == initial_location.IT())
+        return;
+
+    Arm::PSR it_bits;
+    it_bits.IT(next.IT().Value());
+
+    code->and_(MJitStateCpsr(), u32(~0x0600FC00));
+    if (it_bits.Value() != 0) {
+        code->or_(MJitStateCpsr(), it_bits.Value());
+    }
+}
+
+/// An indirect branch cannot be followed by more of its IT block, so the location it reaches has no If-Then state.
+static void EmitClearITState(BlockOfCode* code, IR::LocationDescriptor initial_location) {
+    EmitUpdateITState(code, initial_location.SetIT(Arm::ITState{0}), initial_location);
+}
+
+void EmitX64::EmitTerminal(const IR::Terminal& terminal, IR::LocationDescriptor initial_location) {
     switch (terminal.which()) {
     case 1:
         EmitTerminalInterpret(boost::get<IR::Term::Interpret>(terminal), initial_location);
@@ -3385,20 +6500,78 @@ void EmitX64::EmitTerminal(IR::Terminal terminal, IR::LocationDescriptor initial
 }
 
 void EmitX64::EmitTerminalInterpret(IR::Term::Interpret terminal, IR::LocationDescriptor initial_location) {
+    using namespace Xbyak::util;
+
     ASSERT_MSG(terminal.next.TFlag() == initial_location.TFlag(), "Unimplemented");
     ASSERT_MSG(terminal.next.EFlag() == initial_location.EFlag(), "Unimplemented");
 
+    EmitUpdateITState(code, terminal.next, initial_location);
+
     code->mov(code->ABI_PARAM1.cvt32(), terminal.next.PC());
-    code->mov(code->ABI_PARAM2, reinterpret_cast<u64>(jit_interface));
-    code->mov(code->ABI_PARAM3, reinterpret_cast<u64>(cb.user_arg));
+    code->mov(code->ABI_PARAM2, qword[r15 + offsetof(JitState, jit_interface)]);
+    code->mov(code->ABI_PARAM3, qword[r15 + offsetof(JitState, user_arg)]);
     code->mov(MJitStateReg(Arm::Reg::PC), code->ABI_PARAM1.cvt32());
+    code->inc(qword[r15 + offsetof(JitState, interpreter_fallback_count)]);
+    EmitCountExit(ExitReason::Interpret);
     code->SwitchMxcsrOnExit();
-    code->CallFunction(cb.InterpreterFallback);
+    code->CallCallback(CallbackKind::Interpreter, cb.InterpreterFallback);
     code->ReturnFromRunCode(false); // TODO: Check cycles
 }
 
-void EmitX64::EmitTerminalReturnToDispatch(IR::Term::ReturnToDispatch, IR::LocationDescriptor) {
-    code->ReturnFromRunCode();
+void EmitX64::EmitTerminalReturnToDispatch(IR::Term::ReturnToDispatch, IR::LocationDescriptor initial_location) {
+    using namespace Xbyak::util;
+    using FastDispatchEntry = BlockOfCode::FastDispatchEntry;
+
+    EmitClearITState(code, initial_location);
+
+    if (emitting_isolated) {
+        code->ReturnFromRunCode();
+        return;
+    }
+
+    if (concurrent_execution) {
+        // Inline caches are updated non-atomically by emitted code, so cannot be shared between threads.
+        EmitCountExit(ExitReason::Dispatch);
+        code->jmp(code->GetDispatcherAddress());
+        return;
+    }
+
+    // Each indirect branch site gets its own small cache of recent targets, which the inline cache
+    // miss handler fills in. The entries are data and live in far code so they are evicted with this block.
+    code->SwitchToFarCode();
+    code->align(16);
+    auto* inline_cache = reinterpret_cast<FastDispatchEntry*>(code->GetWritablePointer(code->getCurr()));
+    for (size_t i = 0; i < BlockOfCode::InlineCacheSize; i++) {
+        code->dq(0xFFFFFFFFFFFFFFFFull);
+        code->dq(0);
+    }
+    code->SwitchToNearCode();
+    inline_caches.emplace_back(inline_cache);
+
+    code->cmp(qword[r15 + offsetof(JitState, cycles_remaining)], 0);
+    if (cb.count_exits) {
+        code->jle(EmitCountedExit(ExitReason::CycleBudget, code->GetReturnFromRunCodeAddress()), code->T_NEAR);
+    } else {
+        code->jle(code->GetReturnFromRunCodeAddress());
+    }
+    code->cmp(code->byte[r15 + offsetof(JitState, halt_requested)], u8(0));
+    if (cb.count_exits) {
+        code->jne(EmitCountedExit(ExitReason::Halt, code->GetReturnFromRunCodeAddress()), code->T_NEAR);
+    } else {
+        code->jne(code->GetReturnFromRunCodeAddress());
+    }
+
+    code->CalculateUniqueHash();
+    code->mov(rsi, reinterpret_cast<u64>(inline_cache));
+    for (size_t i = 0; i < BlockOfCode::InlineCacheSize; i++) {
+        Xbyak::Label next;
+        code->cmp(rbx, qword[rsi + i * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, location_descriptor)]);
+        code->jne(next);
+        code->jmp(qword[rsi + i * sizeof(FastDispatchEntry) + offsetof(FastDispatchEntry, code_ptr)]);
+        code->L(next);
+    }
+    EmitCountExit(ExitReason::InlineCacheMiss);
+    code->jmp(code->GetInlineCacheMissAddress());
 }
 
 void EmitX64::EmitTerminalLinkBlock(IR::Term::LinkBlock terminal, IR::LocationDescriptor initial_location) {
@@ -3418,16 +6591,58 @@ void EmitX64::EmitTerminalLinkBlock(IR::Term::LinkBlock terminal, IR::LocationDe
             code->and_(MJitStateCpsr(), u32(~(1 << 9)));
         }
     }
+    EmitUpdateITState(code, terminal.next, initial_location);
+
+    if (emitting_isolated) {
+        if (exit_nzcv) {
+            EmitStoreExitNZCV();
+        }
+        code->mov(MJitStateReg(Arm::Reg::PC), terminal.next.PC());
+        code->ReturnFromRunCode();
+        return;
+    }
+
+    EmitCountLink(terminal.next);
 
+    // Checked here as well as in the dispatcher, so that a halt (e.g. from Jit::SignalInterrupt) is
+    // seen within one block even when the guest only branches between linked blocks.
+    Xbyak::Label halt;
+    code->cmp(code->byte[r15 + offsetof(JitState, halt_requested)], u8(0));
+    code->jne(halt, cb.count_exits ? code->T_NEAR : code->T_AUTO);
     code->cmp(qword[r15 + offsetof(JitState, cycles_remaining)], 0);
 
-    patch_information[terminal.next.UniqueHash()].jg.emplace_back(code->getCurr());
-    if (auto next_bb = GetBasicBlock(terminal.next)) {
-        EmitPatchJg(next_bb->code_ptr);
+    const bool defers_nzcv = static_cast<bool>(exit_nzcv);
+    const bool may_link = MayLinkWithExitNZCV(terminal.next);
+    if (current_register_link && current_register_link->target == terminal.next) {
+        AddPatchSite(terminal.next.UniqueHash(), PatchType::Jg, current_register_link->registers, defers_nzcv);
+        EmitPatchJg(may_link ? current_register_link->register_entry_ptr : nullptr);
     } else {
-        EmitPatchJg();
+        AddPatchSite(terminal.next.UniqueHash(), PatchType::Jg, {}, defers_nzcv);
+        if (auto next_bb = GetBasicBlock(terminal.next)) {
+            EmitPatchJg(may_link ? next_bb->code_ptr : nullptr);
+        } else {
+            EmitPatchJg();
+        }
     }
 
+    if (cb.count_exits) {
+        // The flags are still those of the cycle check whether or not the site is linked.
+        Xbyak::Label out_of_cycles, exit;
+        code->jle(out_of_cycles);
+        EmitCountExit(ExitReason::Unlinked);
+        code->jmp(exit);
+        code->L(halt);
+        EmitCountExit(ExitReason::Halt);
+        code->jmp(exit);
+        code->L(out_of_cycles);
+        EmitCountExit(ExitReason::CycleBudget);
+        code->L(exit);
+    } else {
+        code->L(halt);
+    }
+    if (exit_nzcv) {
+        EmitStoreExitNZCV();
+    }
     code->mov(MJitStateReg(Arm::Reg::PC), terminal.next.PC());
     code->ReturnFromRunCode(); // TODO: Check cycles, Properly do a link
 }
@@ -3435,6 +6650,11 @@ void EmitX64::EmitTerminalLinkBlock(IR::Term::LinkBlock terminal, IR::LocationDe
 void EmitX64::EmitTerminalLinkBlockFast(IR::Term::LinkBlockFast terminal, IR::LocationDescriptor initial_location) {
     using namespace Xbyak::util;
 
+    if (emitting_isolated) {
+        EmitTerminalLinkBlock(IR::Term::LinkBlock{terminal.next}, initial_location);
+        return;
+    }
+
     if (terminal.next.TFlag() != initial_location.TFlag()) {
         if (terminal.next.TFlag()) {
             code->or_(MJitStateCpsr(), u32(1 << 5));
@@ -3449,70 +6669,212 @@ void EmitX64::EmitTerminalLinkBlockFast(IR::Term::LinkBlockFast terminal, IR::Lo
             code->and_(MJitStateCpsr(), u32(~(1 << 9)));
         }
     }
+    EmitUpdateITState(code, terminal.next, initial_location);
+    EmitCountLink(terminal.next);
 
-    patch_information[terminal.next.UniqueHash()].jmp.emplace_back(code->getCurr());
-    if (auto next_bb = GetBasicBlock(terminal.next)) {
-        EmitPatchJmp(terminal.next, next_bb->code_ptr);
+    const bool defers_nzcv = static_cast<bool>(exit_nzcv);
+    CodePtr target_code_ptr = nullptr;
+    if (current_register_link && current_register_link->target == terminal.next) {
+        AddPatchSite(terminal.next.UniqueHash(), PatchType::Jmp, current_register_link->registers, defers_nzcv);
+        target_code_ptr = current_register_link->register_entry_ptr;
     } else {
-        EmitPatchJmp(terminal.next);
+        AddPatchSite(terminal.next.UniqueHash(), PatchType::Jmp, {}, defers_nzcv);
+        if (auto next_bb = GetBasicBlock(terminal.next)) {
+            target_code_ptr = next_bb->code_ptr;
+        }
+    }
+    EmitPatchJmp(terminal.next, MayLinkWithExitNZCV(terminal.next) ? target_code_ptr : nullptr, defers_nzcv || cb.count_exits);
+
+    if (defers_nzcv || cb.count_exits) {
+        // Reached only while the site is unlinked.
+        EmitCountExit(ExitReason::Unlinked);
+        if (defers_nzcv) {
+            EmitStoreExitNZCV();
+        }
+        code->mov(MJitStateReg(Arm::Reg::PC), terminal.next.PC());
+        code->jmp(code->GetReturnFromRunCodeAddress());
     }
 }
 
-void EmitX64::EmitTerminalPopRSBHint(IR::Term::PopRSBHint, IR::LocationDescriptor) {
+void EmitX64::EmitTerminalPopRSBHint(IR::Term::PopRSBHint, IR::LocationDescriptor initial_location) {
     using namespace Xbyak::util;
 
-    // This calculation has to match up with IREmitter::PushRSB
-    code->mov(ebx, MJitStateCpsr());
-    code->mov(ecx, MJitStateReg(Arm::Reg::PC));
-    code->and_(ebx, u32((1 << 5) | (1 << 9)));
-    code->shr(ebx, 2);
-    code->or_(ebx, dword[r15 + offsetof(JitState, FPSCR_mode)]);
-    code->shl(rbx, 32);
-    code->or_(rbx, rcx);
+    EmitClearITState(code, initial_location);
 
-    code->mov(rax, reinterpret_cast<u64>(code->GetReturnFromRunCodeAddress()));
-    for (size_t i = 0; i < JitState::RSBSize; ++i) {
-        code->cmp(rbx, qword[r15 + offsetof(JitState, rsb_location_descriptors) + i * sizeof(u64)]);
-        code->cmove(rax, qword[r15 + offsetof(JitState, rsb_codeptrs) + i * sizeof(u64)]);
+    if (emitting_isolated) {
+        // The entry is still popped, so that the RSB stays in step with the guest's calls.
+        code->mov(eax, dword[r15 + offsetof(JitState, rsb_ptr)]);
+        code->sub(eax, 1);
+        code->and_(eax, u32(cb.rsb_size - 1));
+        code->mov(dword[r15 + offsetof(JitState, rsb_ptr)], eax);
+        code->ReturnFromRunCode();
+        return;
     }
 
-    code->jmp(rax);
+    code->CalculateUniqueHash();
+
+    // Pop the top entry regardless of whether it is a hit, like a hardware return stack.
+    code->mov(eax, dword[r15 + offsetof(JitState, rsb_ptr)]);
+    code->lea(edx, ptr[rax - 1]);
+    code->and_(edx, u32(cb.rsb_size - 1));
+    code->mov(dword[r15 + offsetof(JitState, rsb_ptr)], edx);
+
+    code->cmp(rbx, qword[r15 + rax * 8 + offsetof(JitState, rsb_location_descriptors)]);
+    if (cb.count_exits) {
+        code->jne(EmitCountedExit(ExitReason::RSBMiss, code->GetDispatcherAddress()), code->T_NEAR);
+    } else {
+        code->jne(code->GetDispatcherAddress());
+    }
+    code->jmp(qword[r15 + rax * 8 + offsetof(JitState, rsb_codeptrs)]);
 }
 
-void EmitX64::EmitTerminalIf(IR::Term::If terminal, IR::LocationDescriptor initial_location) {
-    Xbyak::Label pass = EmitCond(code, terminal.if_);
+void EmitX64::EmitTerminalIf(const IR::Term::If& terminal, IR::LocationDescriptor initial_location) {
+    Xbyak::Label pass = fp_compare_branch ? EmitFPCompareCond(*fp_compare_branch, terminal.if_) : EmitCond(code, terminal.if_);
+    fp_compare_branch = boost::none; // Any nested If tests the CPSR as usual
     EmitTerminal(terminal.else_, initial_location);
     code->L(pass);
     EmitTerminal(terminal.then_, initial_location);
 }
 
-void EmitX64::EmitTerminalCheckHalt(IR::Term::CheckHalt terminal, IR::LocationDescriptor initial_location) {
+/**
+ * Emits the branch of a native loop (see IsNativeLoop) back to loop_head, which follows the loads of the
+ * registers the loop keeps in host registers, and its exits. The branch does not go through a patch site:
+ * it stays within the block. The loop is left when its branch is not taken, and when the cycle budget runs
+ * out or a halt is requested; each exit first stores the registers in exit_stores from their host registers.
+ */
+void EmitX64::EmitNativeLoopTerminal(const IR::Block& block, CodePtr loop_head, const std::vector<std::pair<Arm::Reg, HostLoc>>& exit_stores) {
+    using namespace Xbyak::util;
+
+    const auto store_registers = [&] {
+        for (const auto& store : exit_stores) {
+            code->mov(MJitStateReg(store.first), HostLocToReg64(store.second).cvt32());
+        }
+    };
+
+    if (const auto* if_ = boost::get<IR::Term::If>(&block.GetTerminal())) {
+        Xbyak::Label loop = EmitCond(code, if_->if_);
+        EmitAddCycles(block.CycleCount());
+        store_registers();
+        EmitTerminal(if_->else_, block.Location());
+        code->L(loop);
+    }
+
+    if (exit_nzcv && !Optimization::DiscardsNZCVOnEntry(block)) {
+        EmitStoreExitNZCV();
+    }
+
+    // The flags of the subtraction tell whether the budget has run out, so they need no separate compare.
+    Xbyak::Label exit;
+    EmitCountLink(block.Location());
+    code->sub(qword[r15 + offsetof(JitState, cycles_remaining)], static_cast<u32>(block.CycleCount()));
+    if (cb.count_exits) {
+        Xbyak::Label out_of_cycles;
+        code->jle(out_of_cycles, code->T_NEAR);
+        code->cmp(code->byte[r15 + offsetof(JitState, halt_requested)], u8(0));
+        code->je(loop_head);
+        EmitCountExit(ExitReason::Halt);
+        code->jmp(exit);
+        code->L(out_of_cycles);
+        EmitCountExit(ExitReason::CycleBudget);
+    } else {
+        code->jle(exit, code->T_NEAR);
+        code->cmp(code->byte[r15 + offsetof(JitState, halt_requested)], u8(0));
+        code->je(loop_head);
+    }
+
+    code->L(exit);
+    store_registers();
+    if (exit_nzcv) {
+        EmitStoreExitNZCV();
+    }
+    code->mov(MJitStateReg(Arm::Reg::PC), block.Location().PC());
+    code->ReturnFromRunCode();
+}
+
+void EmitX64::EmitTerminalCheckHalt(const IR::Term::CheckHalt& terminal, IR::LocationDescriptor initial_location) {
     using namespace Xbyak::util;
 
+    // The halt check returns to the dispatcher, so the If-Then state has to be in place before it.
+    if (boost::get<IR::Term::PopRSBHint>(&terminal.else_) || boost::get<IR::Term::ReturnToDispatch>(&terminal.else_)) {
+        EmitClearITState(code, initial_location);
+        initial_location = initial_location.SetIT(Arm::ITState{0});
+    }
+
     code->cmp(code->byte[r15 + offsetof(JitState, halt_requested)], u8(0));
-    code->jne(code->GetReturnFromRunCodeAddress());
+    if (cb.count_exits) {
+        code->jne(EmitCountedExit(ExitReason::Halt, code->GetReturnFromRunCodeAddress()), code->T_NEAR);
+    } else {
+        code->jne(code->GetReturnFromRunCodeAddress());
+    }
     EmitTerminal(terminal.else_, initial_location);
 }
 
-void EmitX64::Patch(const IR::LocationDescriptor& desc, CodePtr bb) {
-    const CodePtr save_code_ptr = code->getCurr();
-    const PatchInformation& patch_info = patch_information[desc.UniqueHash()];
-
-    for (CodePtr location : patch_info.jg) {
-        code->SetCodePtr(location);
-        EmitPatchJg(bb);
+u16 EmitX64::PackRegisters(const std::vector<Arm::Reg>& registers) {
+    ASSERT(registers.size() <= entry_register_hostlocs.size());
+    u16 packed = 0;
+    for (size_t i = 0; i < registers.size(); i++) {
+        packed |= static_cast<u16>(static_cast<size_t>(registers[i]) << (4 * i));
     }
+    return packed;
+}
+
+void EmitX64::AddPatchSite(u64 target_hash, PatchType type, const std::vector<Arm::Reg>& registers, bool defers_nzcv) {
+    u32& list = patch_lists.emplace(target_hash, NoPatchSite).first->second;
+    const PatchSite site{code->getCurr(), list, PackRegisters(registers), static_cast<u8>(registers.size()), defers_nzcv, type};
 
-    for (CodePtr location : patch_info.jmp) {
-        code->SetCodePtr(location);
-        EmitPatchJmp(desc, bb);
+    if (free_patch_site != NoPatchSite) {
+        list = free_patch_site;
+        free_patch_site = patch_sites[list].next;
+        patch_sites[list] = site;
+    } else {
+        list = static_cast<u32>(patch_sites.size());
+        patch_sites.push_back(site);
     }
+}
+
+void EmitX64::Patch(const IR::LocationDescriptor& desc, CodePtr bb) {
+    const auto list = patch_lists.find(desc.UniqueHash());
+    if (list == patch_lists.end())
+        return;
 
-    for (CodePtr location : patch_info.mov_rcx) {
-        code->SetCodePtr(location);
-        EmitPatchMovRcx(bb);
+    // A link that passes registers may only use the register entrypoint if it expects the same registers.
+    // A link that leaves the flags unstored may only be made to a block that overwrites them.
+    CodePtr register_entry_ptr = nullptr;
+    u16 entry_registers = 0;
+    u8 entry_register_count = 0;
+    bool discards_nzcv = false;
+    if (bb) {
+        const auto block = block_descriptors.find(desc.UniqueHash());
+        if (block != block_descriptors.end()) {
+            discards_nzcv = block->second.discards_nzcv;
+            if (block->second.register_entry_ptr) {
+                register_entry_ptr = block->second.register_entry_ptr;
+                entry_registers = PackRegisters(block->second.entry_registers);
+                entry_register_count = static_cast<u8>(block->second.entry_registers.size());
+            }
+        }
     }
 
+    const CodePtr save_code_ptr = code->getCurr();
+    for (u32 index = list->second; index != NoPatchSite; index = patch_sites[index].next) {
+        const PatchSite& site = patch_sites[index];
+        const bool with_registers = register_entry_ptr && site.register_count == entry_register_count && site.registers == entry_registers;
+        const CodePtr target = site.defers_nzcv && !discards_nzcv ? nullptr : with_registers ? register_entry_ptr : bb;
+
+        code->SetCodePtr(site.location);
+        switch (site.type) {
+        case PatchType::Jg:
+            EmitPatchJg(target);
+            break;
+        case PatchType::Jmp:
+            // With exit counting, every unlinked site falls through to the code that counts its exit.
+            EmitPatchJmp(desc, target, site.defers_nzcv || cb.count_exits);
+            break;
+        case PatchType::MovRcx:
+            EmitPatchMovRcx(bb);
+            break;
+        }
+    }
     code->SetCodePtr(save_code_ptr);
 }
 
@@ -3528,11 +6890,11 @@ void EmitX64::EmitPatchJg(CodePtr target_code_ptr) {
     code->EnsurePatchLocationSize(patch_location, 6);
 }
 
-void EmitX64::EmitPatchJmp(const IR::LocationDescriptor& target_desc, CodePtr target_code_ptr) {
+void EmitX64::EmitPatchJmp(const IR::LocationDescriptor& target_desc, CodePtr target_code_ptr, bool falls_through) {
     const CodePtr patch_location = code->getCurr();
     if (target_code_ptr) {
         code->jmp(target_code_ptr);
-    } else {
+    } else if (!falls_through) {
         code->mov(MJitStateReg(Arm::Reg::PC), target_desc.PC());
         code->jmp(code->GetReturnFromRunCodeAddress());
     }
@@ -3541,16 +6903,280 @@ void EmitX64::EmitPatchJmp(const IR::LocationDescriptor& target_desc, CodePtr ta
 
 void EmitX64::EmitPatchMovRcx(CodePtr target_code_ptr) {
     if (!target_code_ptr) {
-        target_code_ptr = code->GetReturnFromRunCodeAddress();
+        target_code_ptr = code->GetDispatcherAddress();
     }
     const CodePtr patch_location = code->getCurr();
     code->mov(code->rcx, reinterpret_cast<u64>(target_code_ptr));
     code->EnsurePatchLocationSize(patch_location, 10);
 }
 
+void EmitX64::SetConcurrentExecution(bool concurrent) {
+    concurrent_execution = concurrent;
+}
+
+void EmitX64::SetExclusiveWriteCallback(ExclusiveWriteCallback callback, void* arg) {
+    exclusive_write_callback = callback;
+    exclusive_write_callback_arg = arg;
+}
+
+void EmitX64::ApplyDeferredLinks() {
+    for (const IR::LocationDescriptor& descriptor : deferred_links) {
+        auto iter = block_descriptors.find(descriptor.UniqueHash());
+        if (iter == block_descriptors.end())
+            continue; // Invalidated before it could be linked
+        Patch(descriptor, iter->second.code_ptr);
+        code->SetFastDispatchEntry(descriptor.UniqueHash(), iter->second.code_ptr);
+    }
+    deferred_links.clear();
+
+    std::lock_guard<std::mutex> lock(fastmem_mutex);
+    if (faulted_fastmem_accesses.empty())
+        return;
+    const CodePtr save_code_ptr = code->getCurr();
+    for (CodePtr access_location : faulted_fastmem_accesses) {
+        auto iter = fastmem_fallbacks.find(access_location);
+        if (iter == fastmem_fallbacks.end())
+            continue; // Already backpatched, or evicted
+        code->SetCodePtr(access_location);
+        code->jmp(iter->second);
+        fastmem_fallbacks.erase(iter);
+    }
+    code->SetCodePtr(save_code_ptr);
+    faulted_fastmem_accesses.clear();
+}
+
 void EmitX64::ClearCache() {
+    deferred_links.clear();
     block_descriptors.clear();
-    patch_information.clear();
+    patch_lists.clear();
+    patch_sites.clear();
+    free_patch_site = NoPatchSite;
+    block_ranges.clear();
+    inline_caches.clear();
+    code->ClearFastDispatchTable();
+    if (code_pages) {
+        std::fill_n(code_pages.get(), UserCallbacks::NUM_PAGE_TABLE_ENTRIES, u8(0));
+    }
+
+    std::lock_guard<std::mutex> lock(fastmem_mutex);
+    fastmem_fallbacks.clear();
+    faulted_fastmem_accesses.clear();
+}
+
+void EmitX64::InvalidateCacheRange(u32 start_address, size_t length) {
+    if (length == 0)
+        return;
+
+    // Inclusive range. Computed in 64 bits as the range may extend to the top of the address space.
+    const u64 range_start = start_address;
+    const u64 range_end = std::min<u64>(range_start + length - 1, 0xFFFFFFFF);
+
+    std::vector<u64> to_invalidate;
+    for (u64 page = range_start >> GUEST_PAGE_BITS; page <= range_end >> GUEST_PAGE_BITS; page++) {
+        auto iter = block_ranges.find(static_cast<u32>(page));
+        if (iter == block_ranges.end())
+            continue;
+
+        for (u64 unique_hash : iter->second) {
+            const BlockDescriptor& block = block_descriptors.at(unique_hash);
+            const bool overlaps = std::any_of(block.guest_ranges.begin(), block.guest_ranges.end(), [&](const auto& guest_range) {
+                const u64 block_start = guest_range.first;
+                const u64 block_end = u64(guest_range.second) - 1;
+                return guest_range.first != guest_range.second && block_start <= range_end && range_start <= block_end;
+            });
+            if (overlaps) {
+                to_invalidate.emplace_back(unique_hash);
+            }
+        }
+    }
+
+    for (u64 unique_hash : to_invalidate) {
+        InvalidateBasicBlock(unique_hash);
+    }
+
+    PurgeInlineCaches();
+}
+
+void EmitX64::InvalidateAddressSpace(size_t address_space) {
+    const u64 hash_mask = IR::LocationDescriptor::AddressSpaceHash(IR::LocationDescriptor::MAX_ADDRESS_SPACES - 1);
+    const u64 hash_bits = IR::LocationDescriptor::AddressSpaceHash(address_space);
+
+    std::vector<u64> to_invalidate;
+    for (const auto& block : block_descriptors) {
+        if ((block.first & hash_mask) == hash_bits) {
+            to_invalidate.emplace_back(block.first);
+        }
+    }
+
+    for (u64 unique_hash : to_invalidate) {
+        InvalidateBasicBlock(unique_hash);
+    }
+
+    PurgeInlineCaches();
+}
+
+void EmitX64::MarkCodePages(const std::vector<std::pair<u32, u32>>& guest_ranges) {
+    if (!code_pages)
+        return;
+
+    for (const auto& range : guest_ranges) {
+        if (range.first == range.second)
+            continue;
+        const u32 first_page = range.first >> GUEST_PAGE_BITS;
+        const u32 last_page = (range.second - 1) >> GUEST_PAGE_BITS;
+        for (u32 page = first_page; page <= last_page; page++) {
+            code_pages[page] = 1;
+        }
+    }
+}
+
+void EmitX64::UnmarkCodePages(u32 first_page, u32 last_page) {
+    if (!code_pages)
+        return;
+
+    std::fill(code_pages.get() + first_page, code_pages.get() + last_page + 1, u8(0));
+}
+
+void EmitX64::SetWatchedPages(u32 first_page, u32 last_page, WatchpointKind kind) {
+    ASSERT_MSG(watched_pages, "Watchpoints require UserCallbacks::WatchpointHit");
+
+    std::fill(watched_pages.get() + first_page, watched_pages.get() + last_page + 1, static_cast<u8>(kind));
+}
+
+void EmitX64::InvalidateCodeRegion(CodePtr begin, CodePtr end) {
+    const u8* evict_begin = static_cast<const u8*>(begin);
+    const u8* evict_end = static_cast<const u8*>(end);
+
+    std::vector<u64> to_invalidate;
+    for (const auto& iter : block_descriptors) {
+        const u8* block_begin = static_cast<const u8*>(iter.second.code_ptr);
+        const u8* block_end = block_begin + iter.second.size;
+        if (block_begin < static_cast<const u8*>(end) && static_cast<const u8*>(begin) < block_end) {
+            to_invalidate.emplace_back(iter.first);
+            // A block may straddle the region boundary; all of its code is going away.
+            evict_begin = std::min(evict_begin, block_begin);
+            evict_end = std::max(evict_end, block_end);
+        }
+    }
+
+    for (u64 unique_hash : to_invalidate) {
+        InvalidateBasicBlock(unique_hash);
+    }
+
+    // Patch locations within evicted code must be forgotten, since that memory will be reused.
+    auto is_evicted = [evict_begin, evict_end](CodePtr location) {
+        const u8* ptr = static_cast<const u8*>(location);
+        return ptr >= evict_begin && ptr < evict_end;
+    };
+    for (auto list = patch_lists.begin(); list != patch_lists.end();) {
+        u32* link = &list->second;
+        while (*link != NoPatchSite) {
+            PatchSite& site = patch_sites[*link];
+            if (is_evicted(site.location)) {
+                const u32 index = *link;
+                *link = site.next;
+                site.next = free_patch_site;
+                free_patch_site = index;
+            } else {
+                link = &site.next;
+            }
+        }
+        if (list->second == NoPatchSite)
+            list = patch_lists.erase(list);
+        else
+            ++list;
+    }
+    const auto is_inline_cache_evicted = [this, &is_evicted](const BlockOfCode::FastDispatchEntry* inline_cache) { return is_evicted(code->GetExecutablePointer(inline_cache)); };
+    inline_caches.erase(std::remove_if(inline_caches.begin(), inline_caches.end(), is_inline_cache_evicted), inline_caches.end());
+    {
+        std::lock_guard<std::mutex> lock(fastmem_mutex);
+        for (auto iter = fastmem_fallbacks.begin(); iter != fastmem_fallbacks.end();) {
+            if (is_evicted(iter->first))
+                iter = fastmem_fallbacks.erase(iter);
+            else
+                ++iter;
+        }
+        faulted_fastmem_accesses.erase(std::remove_if(faulted_fastmem_accesses.begin(), faulted_fastmem_accesses.end(), is_evicted), faulted_fastmem_accesses.end());
+    }
+
+    PurgeInlineCaches();
+}
+
+void EmitX64::InvalidateBlock(IR::LocationDescriptor descriptor) {
+    InvalidateBasicBlock(descriptor.UniqueHash());
+    PurgeInlineCaches();
+}
+
+bool EmitX64::HasBlocksInCodeRegion(CodePtr begin, CodePtr end) const {
+    return std::any_of(block_descriptors.begin(), block_descriptors.end(), [begin, end](const auto& iter) {
+        const u8* block_begin = static_cast<const u8*>(iter.second.code_ptr);
+        const u8* block_end = block_begin + iter.second.size;
+        return block_begin < static_cast<const u8*>(end) && static_cast<const u8*>(begin) < block_end;
+    });
+}
+
+EmitX64::MemoryUsage EmitX64::GetMemoryUsage() const {
+    MemoryUsage usage;
+
+    usage.block_count = block_descriptors.size();
+    usage.block_descriptor_bytes = block_descriptors.AllocatedBytes();
+    for (const auto& iter : block_descriptors) {
+        const BlockDescriptor& block = iter.second;
+        usage.block_descriptor_bytes += block.guest_ranges.capacity() * sizeof(block.guest_ranges[0])
+                                        + block.entry_registers.capacity() * sizeof(Arm::Reg)
+                                        + block.guest_pc_map.capacity();
+    }
+    // Approximates each node of an unordered container as its value and a pointer.
+    for (const auto& page : block_ranges) {
+        usage.block_descriptor_bytes += sizeof(page) + sizeof(void*) + page.second.size() * (sizeof(u64) + sizeof(void*));
+    }
+
+    usage.patch_site_count = patch_sites.size();
+    for (u32 site = free_patch_site; site != NoPatchSite; site = patch_sites[site].next) {
+        usage.patch_site_count--;
+    }
+    usage.patch_information_bytes = patch_lists.AllocatedBytes()
+                                    + patch_sites.capacity() * sizeof(PatchSite)
+                                    + inline_caches.capacity() * sizeof(BlockOfCode::FastDispatchEntry*)
+                                    + deferred_links.capacity() * sizeof(IR::LocationDescriptor);
+    std::lock_guard<std::mutex> lock(fastmem_mutex);
+    usage.patch_information_bytes += fastmem_fallbacks.size() * (sizeof(std::pair<CodePtr, CodePtr>) + sizeof(void*))
+                                     + faulted_fastmem_accesses.capacity() * sizeof(CodePtr);
+
+    return usage;
+}
+
+void EmitX64::InvalidateBasicBlock(u64 unique_hash) {
+    auto iter = block_descriptors.find(unique_hash);
+    if (iter == block_descriptors.end())
+        return; // Already invalidated (e.g. block spans multiple pages)
+
+    const BlockDescriptor block = iter->second;
+    block_descriptors.erase(iter);
+
+    Unpatch(block.start_location);
+    code->ClearFastDispatchEntry(unique_hash);
+
+    for (const auto& range : block.guest_ranges) {
+        if (range.first == range.second)
+            continue;
+        const u32 first_page = range.first >> GUEST_PAGE_BITS;
+        const u32 last_page = (range.second - 1) >> GUEST_PAGE_BITS;
+        for (u32 page = first_page; page <= last_page; page++) {
+            block_ranges[page].erase(unique_hash);
+        }
+    }
+}
+
+void EmitX64::PurgeInlineCaches() {
+    for (BlockOfCode::FastDispatchEntry* inline_cache : inline_caches) {
+        for (size_t i = 0; i < BlockOfCode::InlineCacheSize; i++) {
+            BlockOfCode::FastDispatchEntry& entry = inline_cache[i];
+            if (entry.code_ptr && block_descriptors.count(entry.location_descriptor) == 0) {
+                entry = {0xFFFFFFFFFFFFFFFFull, nullptr};
+            }
+        }
+    }
 }
 
 } // namespace BackendX64
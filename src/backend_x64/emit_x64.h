@@ -6,22 +6,27 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <boost/optional.hpp>
 
 #include <xbyak_util.h>
 
+#include "backend_x64/block_of_code.h"
 #include "backend_x64/reg_alloc.h"
+#include "common/flat_hash_map.h"
 #include "dynarmic/callbacks.h"
+#include "frontend/arm/types.h"
 #include "frontend/ir/location_descriptor.h"
 #include "frontend/ir/terminal.h"
 
 namespace Dynarmic {
 
-class Jit;
-
 namespace IR {
 class Block;
 class Inst;
@@ -29,29 +34,168 @@ class Inst;
 
 namespace BackendX64 {
 
-class BlockOfCode;
-
 class EmitX64 final {
 public:
+    /// How an emitted block counts its executions.
+    enum class Profiling {
+        None,    ///< The block does not count its executions
+        TierUp,  ///< The block counts its executions and returns to host when it becomes hot
+        Count,   ///< The block only counts its executions (see UserCallbacks::hot_layout_interval)
+        Sampled, ///< The block does not count its executions, and is retranslated when sampled often enough (see UserCallbacks::hot_block_samples)
+    };
+
     struct BlockDescriptor {
         CodePtr code_ptr; ///< Entrypoint of emitted code
         size_t size;      ///< Length in bytes of emitted code
+
+        IR::LocationDescriptor start_location;         ///< Location of the first guest instruction in this block
+        std::vector<std::pair<u32, u32>> guest_ranges; ///< Ranges [first, second) of guest code in this block
+
+        Profiling profiling;                           ///< How this block counts its executions
+        u64* execution_count;                          ///< Number of times a profiled block was entered, otherwise nullptr
+
+        CodePtr register_entry_ptr;                    ///< Entrypoint for links that pass entry_registers in host registers, or nullptr
+        std::vector<Arm::Reg> entry_registers;         ///< Guest registers expected in host registers at register_entry_ptr
+        bool discards_nzcv;                            ///< Whether links that leave the NZCV flags unstored may jump here, see Optimization::DiscardsNZCVOnEntry
+
+        std::vector<u8> guest_pc_map;                  ///< Delta-encoded host offsets at which the guest PC changes (see UserCallbacks::guest_pc_map)
+
+        /// With UserCallbacks::count_exits, the times this block was left for each ExitReason, indexed by reason. Otherwise nullptr.
+        const u64* exit_counts;
+        /// With UserCallbacks::count_exits, the times this block branched directly to each location. A location may appear more than once.
+        std::vector<std::pair<IR::LocationDescriptor, const u64*>> link_counts;
+
+        /// With UserCallbacks::specialize_register_values, the registers a TierUp block records on entry, and for each
+        /// a pair of counters: the value it last had, and the times that value was recorded, which is on the first entry
+        /// and on each entry where it differed from the one before. Otherwise nullptr.
+        std::vector<Arm::Reg> profiled_registers;
+        const u64* register_profile;
+        /// For a block with register guards (see IR::Block::RegisterGuards), the times they have failed. Otherwise nullptr.
+        const u64* guard_failures;
     };
 
-    EmitX64(BlockOfCode* code, UserCallbacks cb, Jit* jit_interface);
+    /// Most registers a block records the values of on entry (see UserCallbacks::specialize_register_values).
+    static constexpr size_t MaxProfiledRegisters = 4;
+
+    EmitX64(BlockOfCode* code, UserCallbacks cb);
 
     /**
      * Emit host machine code for a basic block with intermediate representation `ir`.
+     * `profiling` selects whether and how the block counts its executions.
      * @note ir is modified.
      */
-    BlockDescriptor Emit(IR::Block& ir);
+    BlockDescriptor Emit(IR::Block& ir, Profiling profiling);
+    /**
+     * Emit host machine code for `ir` that is not added to the cache: no block links to it, and it returns
+     * to the dispatcher at each of its exits instead of linking to or looking up the next block. The caller
+     * keeps track of it, and must discard it when its guest code is invalidated or its region is evicted.
+     * Used for the blocks of Jit::RunInstructions. The block does not count its executions.
+     * @note ir is modified.
+     */
+    BlockDescriptor EmitIsolated(IR::Block& ir);
 
     /// Looks up an emitted host block in the cache.
     boost::optional<BlockDescriptor> GetBasicBlock(IR::LocationDescriptor descriptor) const;
+    /// Returns all blocks in the cache emitted with Profiling::Count, most frequently executed first.
+    std::vector<BlockDescriptor> GetCountedBlocks() const;
+    /// Returns all blocks in the cache, in the order of their host code.
+    std::vector<BlockDescriptor> GetBlocks() const;
+
+    /**
+     * Finds the guest instruction that the emitted code at host_pc was translated from. The guest PC is
+     * only exact for blocks emitted with UserCallbacks::guest_pc_map; for others it is the block's start.
+     * Returns boost::none if host_pc is not in the near code of any block in the cache.
+     */
+    boost::optional<u32> HostPcToGuestPc(CodePtr host_pc) const;
+
+    struct BlockSamples {
+        IR::LocationDescriptor location;
+        Profiling profiling;
+        size_t samples;
+    };
+    /**
+     * Attributes sampled host PCs to the blocks whose near code contains them, in one pass over the cache.
+     * `host_pcs` must be sorted. Returns each block that has samples, with their number.
+     */
+    std::vector<BlockSamples> CountSamples(const std::vector<CodePtr>& host_pcs) const;
+
+    /**
+     * Set if other threads may be executing emitted code while new code is emitted.
+     * Emitted code then avoids inline caches, and links to new blocks are deferred until ApplyDeferredLinks,
+     * so that live code is never modified.
+     */
+    void SetConcurrentExecution(bool concurrent);
+    /**
+     * While executing concurrently, emitted code calls `callback` with `arg` and the writing core's
+     * JitState after each exclusive write that succeeds, so that the local exclusive monitors of the
+     * other cores can be cleared. Unused with the global exclusive monitor, which needs no such call.
+     */
+    using ExclusiveWriteCallback = void (*)(void* arg, JitState* jit_state);
+    void SetExclusiveWriteCallback(ExclusiveWriteCallback callback, void* arg);
+    /**
+     * Links blocks emitted since the last call into existing code, and backpatches fastmem accesses
+     * that have faulted since the last call. No other thread may be executing emitted code.
+     */
+    void ApplyDeferredLinks();
 
     /// Empties the cache.
     void ClearCache();
 
+    /**
+     * Invalidates all blocks that contain guest code in the range [start_address, start_address + length).
+     * Links into invalidated blocks are undone; all other blocks remain in the cache.
+     */
+    void InvalidateCacheRange(u32 start_address, size_t length);
+
+    /**
+     * Invalidates all blocks whose host code overlaps [begin, end), and forgets all patch locations
+     * inside them. Used to evict a region of the code cache before it is reused.
+     */
+    void InvalidateCodeRegion(CodePtr begin, CodePtr end);
+
+    /// Invalidates the block at `descriptor`, if present, so that it can be emitted again.
+    void InvalidateBlock(IR::LocationDescriptor descriptor);
+
+    /// Invalidates all blocks translated from `address_space` (see IR::LocationDescriptor::AddressSpace).
+    void InvalidateAddressSpace(size_t address_space);
+
+    /// Whether any block in the cache has host code overlapping [begin, end).
+    bool HasBlocksInCodeRegion(CodePtr begin, CodePtr end) const;
+
+    /// Approximate host memory used by the bookkeeping of emitted code.
+    struct MemoryUsage {
+        size_t block_count;
+        size_t block_descriptor_bytes;  ///< Block descriptors and the index of blocks by guest page
+        size_t patch_site_count;
+        size_t patch_information_bytes; ///< Patch sites, inline caches and fastmem accesses
+    };
+    MemoryUsage GetMemoryUsage() const;
+
+    /**
+     * With UserCallbacks::detect_self_modifying_code, the table of guest pages that emitted code checks
+     * writes against: nonzero for each page that may hold translated code. Otherwise nullptr.
+     * Pages are marked as blocks are emitted, or by MarkCodePages, and remain marked until the cache is
+     * cleared or they are unmarked by UnmarkCodePages.
+     */
+    const u8* GetCodePages() const {
+        return code_pages.get();
+    }
+    /// Marks the pages of `guest_ranges` as holding translated code, e.g. that of blocks translated but not emitted.
+    void MarkCodePages(const std::vector<std::pair<u32, u32>>& guest_ranges);
+    /// Unmarks the pages first_page to last_page, which must no longer hold any translated code.
+    void UnmarkCodePages(u32 first_page, u32 last_page);
+
+    /**
+     * With UserCallbacks::WatchpointHit, the table of guest pages that emitted code checks accesses
+     * against: the WatchpointKind of the accesses watched on each page. Otherwise nullptr.
+     * Not affected by clearing the cache.
+     */
+    const u8* GetWatchedPages() const {
+        return watched_pages.get();
+    }
+    /// Sets the accesses watched on the pages first_page to last_page to `kind`.
+    void SetWatchedPages(u32 first_page, u32 last_page, WatchpointKind kind);
+
 private:
     // Microinstruction emitters
 #define OPCODE(name, type, ...) void Emit##name(RegAlloc& reg_alloc, IR::Block& block, IR::Inst* inst);
@@ -59,40 +203,141 @@ private:
 #undef OPCODE
 
     // Helpers
+    bool IsHostCall(const IR::Inst& inst) const;
+    bool UseDefaultNaN(const IR::Block& block) const;
+    static bool BlockUsesGuestMxcsr(const IR::Block& block);
+    void EmitEnsureGuestMxcsr();
     void EmitAddCycles(size_t cycles);
     void EmitCondPrelude(const IR::Block& block);
+    void EmitExecutionCount(u64* execution_count, Profiling profiling);
+    void EmitRegisterProfile(const std::vector<Arm::Reg>& registers, u64* profile);
+    void EmitRegisterGuards(const IR::Block& block, u64* guard_failures);
+    void EmitBreakpointCheck(const IR::Block& block);
+    Xbyak::Reg64 EmitFastmemRead(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size, IR::Inst* byte_reverse = nullptr);
+    void EmitFastmemWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size, IR::Inst* byte_reverse = nullptr);
+    void EmitGlobalExclusiveWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size);
+    void EmitInlineExclusiveWrite(RegAlloc& reg_alloc, IR::Inst* inst, size_t bit_size);
+    void EmitReadMemoryBlock(RegAlloc& reg_alloc, IR::Inst* inst);
+    void EmitWriteMemoryBlock(RegAlloc& reg_alloc, IR::Inst* inst);
 
     // Terminal instruction emitters
-    void EmitTerminal(IR::Terminal terminal, IR::LocationDescriptor initial_location);
+    void EmitTerminal(const IR::Terminal& terminal, IR::LocationDescriptor initial_location);
     void EmitTerminalInterpret(IR::Term::Interpret terminal, IR::LocationDescriptor initial_location);
     void EmitTerminalReturnToDispatch(IR::Term::ReturnToDispatch terminal, IR::LocationDescriptor initial_location);
     void EmitTerminalLinkBlock(IR::Term::LinkBlock terminal, IR::LocationDescriptor initial_location);
     void EmitTerminalLinkBlockFast(IR::Term::LinkBlockFast terminal, IR::LocationDescriptor initial_location);
     void EmitTerminalPopRSBHint(IR::Term::PopRSBHint terminal, IR::LocationDescriptor initial_location);
-    void EmitTerminalIf(IR::Term::If terminal, IR::LocationDescriptor initial_location);
-    void EmitTerminalCheckHalt(IR::Term::CheckHalt terminal, IR::LocationDescriptor initial_location);
+    void EmitTerminalIf(const IR::Term::If& terminal, IR::LocationDescriptor initial_location);
+    void EmitTerminalCheckHalt(const IR::Term::CheckHalt& terminal, IR::LocationDescriptor initial_location);
+    void EmitNativeLoopTerminal(const IR::Block& block, CodePtr loop_head, const std::vector<std::pair<Arm::Reg, HostLoc>>& exit_stores);
+
+    // Register passing
+    /// A link that passes `registers` in host registers to the register entrypoint of `target`.
+    struct RegisterLink {
+        IR::LocationDescriptor target;
+        CodePtr register_entry_ptr;
+        std::vector<Arm::Reg> registers;
+    };
+    boost::optional<RegisterLink> FindRegisterLink(const IR::Block& block, CodePtr own_register_entry_ptr, const std::vector<Arm::Reg>& own_entry_registers) const;
+    /// The link from the block being emitted for which registers have been placed, if any.
+    boost::optional<RegisterLink> current_register_link;
+
+    // Flags stored at exit
+    /// The NZCV flags that the block being emitted leaves for the terminal to store (see
+    /// Optimization::DeadFlagStoreElimination), packed into the CPSR's bit positions, if any.
+    boost::optional<Xbyak::Reg32> exit_nzcv;
+    void EmitStoreExitNZCV();
+    /// Whether the terminal may jump straight to the block at `target`, leaving exit_nzcv unstored.
+    bool MayLinkWithExitNZCV(const IR::LocationDescriptor& target) const;
+
+    // FP compare branches
+    /// The operands, in host registers, of the FPCompare that the If terminal of the block being emitted branches on.
+    struct FPCompareBranch {
+        bool is_double;
+        Xbyak::Xmm a;
+        Xbyak::Xmm b;
+    };
+    /// Set for the terminal when the block copies an FP compare to the CPSR flags before it, if any.
+    boost::optional<FPCompareBranch> fp_compare_branch;
+    Xbyak::Label EmitFPCompareCond(const FPCompareBranch& branch, Arm::Cond cond);
+
+    // Exit counting (see UserCallbacks::count_exits)
+    /// The counters of the block being emitted: ExitReasonCount of them for its exits, and one for each link site.
+    u64* current_exit_counts = nullptr;
+    std::vector<std::pair<IR::LocationDescriptor, const u64*>> current_link_counts;
+    /// Allocates `count` counters in the far code of the block being emitted, so that they are discarded with it. Only called from near code.
+    u64* AllocateCounters(size_t count);
+    /// Counts an exit of the block being emitted for `reason`. Clobbers rax and the host flags.
+    void EmitCountExit(ExitReason reason);
+    /// Counts a direct branch of the block being emitted to `target`. Clobbers rax and the host flags.
+    void EmitCountLink(const IR::LocationDescriptor& target);
+    /// A label in far code that counts an exit for `reason` and jumps to `target`, for exits taken by conditional jumps.
+    Xbyak::Label EmitCountedExit(ExitReason reason, const void* target);
 
     // Patching
-    struct PatchInformation {
-        std::vector<CodePtr> jg;
-        std::vector<CodePtr> jmp;
-        std::vector<CodePtr> mov_rcx;
+    enum class PatchType : u8 {
+        Jg,
+        Jmp,
+        MovRcx,
     };
+    /**
+     * A location in emitted code that refers to a block, and is patched whenever that block is emitted or
+     * invalidated. The sites referring to each block form a list in patch_sites, starting at patch_lists.
+     */
+    struct PatchSite {
+        CodePtr location;
+        u32 next;          ///< Index in patch_sites of the next site in the same list, or NoPatchSite
+        u16 registers;          ///< Guest registers the site passes in host registers, see PackRegisters
+        u8 register_count : 4;
+        u8 defers_nzcv : 1;     ///< The site leaves exit_nzcv unstored, and is followed by code that stores it if unlinked
+        PatchType type;
+    };
+    static constexpr u32 NoPatchSite = 0xFFFFFFFF;
+    static u16 PackRegisters(const std::vector<Arm::Reg>& registers);
+    /// Records a site of `type` at the current code pointer, referring to the block with location hash `target_hash`.
+    void AddPatchSite(u64 target_hash, PatchType type, const std::vector<Arm::Reg>& registers = {}, bool defers_nzcv = false);
     void Patch(const IR::LocationDescriptor& target_desc, CodePtr target_code_ptr);
     void Unpatch(const IR::LocationDescriptor& target_desc);
     void EmitPatchJg(CodePtr target_code_ptr = nullptr);
-    void EmitPatchJmp(const IR::LocationDescriptor& target_desc, CodePtr target_code_ptr = nullptr);
+    /// If `falls_through` and there is no target, the site falls through to the code after it rather than returning to the dispatcher.
+    void EmitPatchJmp(const IR::LocationDescriptor& target_desc, CodePtr target_code_ptr = nullptr, bool falls_through = false);
     void EmitPatchMovRcx(CodePtr target_code_ptr = nullptr);
 
+    // Fastmem
+    void RegisterFastmemAccess(CodePtr access_location, CodePtr fallback);
+    /// Called from the fault handler. Returns the fallback of the fastmem access at `fault_location`, if any.
+    CodePtr HandleFastmemFault(CodePtr fault_location);
+
+    // Cache management
+    void InvalidateBasicBlock(u64 unique_hash);
+    /// Clears inline cache entries that refer to blocks that are no longer in the cache.
+    void PurgeInlineCaches();
+
     // Global CPU information
     Xbyak::util::Cpu cpu_info;
 
     // State
     BlockOfCode* code;
     UserCallbacks cb;
-    Jit* jit_interface;
-    std::unordered_map<u64, BlockDescriptor> block_descriptors;
-    std::unordered_map<u64, PatchInformation> patch_information;
+    bool concurrent_execution = false;
+    bool emitting_isolated = false;                                  ///< Set while EmitIsolated emits a block
+    ExclusiveWriteCallback exclusive_write_callback = nullptr;
+    void* exclusive_write_callback_arg = nullptr;
+    Common::FlatHashMap<BlockDescriptor> block_descriptors;
+    Common::FlatHashMap<u32> patch_lists;                            ///< UniqueHash of a block -> First site referring to it
+    std::vector<PatchSite> patch_sites;                              ///< All patch sites; unused ones form a list from free_patch_site
+    u32 free_patch_site = NoPatchSite;
+    std::unordered_map<u32, std::unordered_set<u64>> block_ranges; ///< Guest page number -> UniqueHash of blocks overlapping it
+    std::vector<BlockOfCode::FastDispatchEntry*> inline_caches;     ///< Inline caches of all emitted indirect branches
+    std::vector<IR::LocationDescriptor> deferred_links;             ///< Blocks emitted but not yet linked into existing code
+    std::unique_ptr<u8[]> code_pages;                                ///< See GetCodePages
+    std::unique_ptr<u8[]> watched_pages;                             ///< See GetWatchedPages
+
+    mutable std::mutex fastmem_mutex;                                ///< Guards the below, which are accessed from the fault handler
+    std::unordered_map<CodePtr, CodePtr> fastmem_fallbacks;          ///< Fastmem access location -> Its fallback in far code
+    std::vector<CodePtr> faulted_fastmem_accesses;                   ///< Fastmem accesses to backpatch to their fallback
+
+    static constexpr size_t GUEST_PAGE_BITS = 12;
 };
 
 } // namespace BackendX64
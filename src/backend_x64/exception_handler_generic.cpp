@@ -0,0 +1,24 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include "backend_x64/block_of_code.h"
+#include "common/assert.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+struct BlockOfCode::ExceptionHandler::Impl final {
+};
+
+BlockOfCode::ExceptionHandler::ExceptionHandler() = default;
+BlockOfCode::ExceptionHandler::~ExceptionHandler() = default;
+
+void BlockOfCode::ExceptionHandler::Register(BlockOfCode*, FaultCallback) {
+    ASSERT_MSG(false, "Fastmem is not supported on this platform");
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -0,0 +1,145 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <signal.h>
+#include <ucontext.h>
+
+#include "backend_x64/block_of_code.h"
+#include "common/assert.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+namespace {
+
+struct CodeBlockInfo {
+    const u8* begin;
+    const u8* end;
+    BlockOfCode::FaultCallback callback;
+};
+
+/// Process-wide SIGSEGV/SIGBUS handler shared by all BlockOfCode instances.
+/// Faults outside of emitted code are forwarded to the previously installed handler.
+class SigHandler final {
+public:
+    SigHandler();
+
+    void AddCodeBlock(CodeBlockInfo info);
+    void RemoveCodeBlock(const u8* begin);
+
+private:
+    static void SigAction(int sig, siginfo_t* info, void* raw_context);
+    static void ForwardToOldHandler(const struct sigaction& old_sa, int sig, siginfo_t* info, void* raw_context);
+
+    std::mutex mutex;
+    std::vector<CodeBlockInfo> code_blocks;
+
+    struct sigaction old_sa_segv;
+    struct sigaction old_sa_bus;
+};
+
+SigHandler& GetSigHandler() {
+    static SigHandler sig_handler;
+    return sig_handler;
+}
+
+SigHandler::SigHandler() {
+    struct sigaction sa;
+    sa.sa_sigaction = &SigHandler::SigAction;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    ASSERT_MSG(sigaction(SIGSEGV, &sa, &old_sa_segv) == 0, "Unable to install SIGSEGV handler");
+    ASSERT_MSG(sigaction(SIGBUS, &sa, &old_sa_bus) == 0, "Unable to install SIGBUS handler");
+}
+
+void SigHandler::AddCodeBlock(CodeBlockInfo info) {
+    std::lock_guard<std::mutex> lock(mutex);
+    code_blocks.emplace_back(std::move(info));
+}
+
+void SigHandler::RemoveCodeBlock(const u8* begin) {
+    std::lock_guard<std::mutex> lock(mutex);
+    code_blocks.erase(std::remove_if(code_blocks.begin(), code_blocks.end(), [begin](const auto& info) { return info.begin == begin; }), code_blocks.end());
+}
+
+void SigHandler::SigAction(int sig, siginfo_t* info, void* raw_context) {
+    ASSERT(sig == SIGSEGV || sig == SIGBUS);
+
+    auto* ucontext = static_cast<ucontext_t*>(raw_context);
+#if defined(__APPLE__)
+    auto& rip = ucontext->uc_mcontext->__ss.__rip;
+#elif defined(__linux__)
+    auto& rip = ucontext->uc_mcontext.gregs[REG_RIP];
+#elif defined(__FreeBSD__)
+    auto& rip = ucontext->uc_mcontext.mc_rip;
+#else
+#error "Unknown platform"
+#endif
+
+    SigHandler& sig_handler = GetSigHandler();
+    {
+        std::lock_guard<std::mutex> lock(sig_handler.mutex);
+
+        const u8* fault_location = reinterpret_cast<const u8*>(rip);
+        for (const auto& code_block : sig_handler.code_blocks) {
+            if (fault_location < code_block.begin || fault_location >= code_block.end)
+                continue;
+
+            if (CodePtr resume_location = code_block.callback(fault_location)) {
+                rip = reinterpret_cast<u64>(resume_location);
+                return;
+            }
+            break;
+        }
+    }
+
+    ForwardToOldHandler(sig == SIGSEGV ? sig_handler.old_sa_segv : sig_handler.old_sa_bus, sig, info, raw_context);
+}
+
+void SigHandler::ForwardToOldHandler(const struct sigaction& old_sa, int sig, siginfo_t* info, void* raw_context) {
+    if (old_sa.sa_flags & SA_SIGINFO) {
+        old_sa.sa_sigaction(sig, info, raw_context);
+        return;
+    }
+    if (old_sa.sa_handler == SIG_DFL || old_sa.sa_handler == SIG_IGN) {
+        // Returning re-executes the faulting instruction, which now takes the default action.
+        signal(sig, SIG_DFL);
+        return;
+    }
+    old_sa.sa_handler(sig);
+}
+
+} // anonymous namespace
+
+struct BlockOfCode::ExceptionHandler::Impl final {
+    Impl(const u8* code_begin, const u8* code_end, FaultCallback callback) : code_begin(code_begin) {
+        GetSigHandler().AddCodeBlock({code_begin, code_end, std::move(callback)});
+    }
+
+    ~Impl() {
+        GetSigHandler().RemoveCodeBlock(code_begin);
+    }
+
+private:
+    const u8* code_begin;
+};
+
+BlockOfCode::ExceptionHandler::ExceptionHandler() = default;
+BlockOfCode::ExceptionHandler::~ExceptionHandler() = default;
+
+void BlockOfCode::ExceptionHandler::Register(BlockOfCode* code, FaultCallback callback) {
+    impl.reset();
+    impl = std::make_unique<Impl>(code->getCode(), code->getCode() + code->maxSize_, std::move(callback));
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -0,0 +1,117 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "backend_x64/block_of_code.h"
+#include "common/assert.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+namespace {
+
+struct CodeBlockInfo {
+    const u8* begin;
+    const u8* end;
+    BlockOfCode::FaultCallback callback;
+};
+
+/// Process-wide vectored exception handler shared by all BlockOfCode instances.
+/// Exceptions outside of emitted code are left to other handlers.
+class VectoredHandler final {
+public:
+    VectoredHandler();
+    ~VectoredHandler();
+
+    void AddCodeBlock(CodeBlockInfo info);
+    void RemoveCodeBlock(const u8* begin);
+
+private:
+    static LONG CALLBACK Handler(PEXCEPTION_POINTERS exception_info);
+
+    std::mutex mutex;
+    std::vector<CodeBlockInfo> code_blocks;
+    PVOID handle = nullptr;
+};
+
+VectoredHandler& GetVectoredHandler() {
+    static VectoredHandler vectored_handler;
+    return vectored_handler;
+}
+
+VectoredHandler::VectoredHandler() {
+    handle = AddVectoredExceptionHandler(1, &VectoredHandler::Handler);
+    ASSERT_MSG(handle, "Unable to install vectored exception handler");
+}
+
+VectoredHandler::~VectoredHandler() {
+    RemoveVectoredExceptionHandler(handle);
+}
+
+void VectoredHandler::AddCodeBlock(CodeBlockInfo info) {
+    std::lock_guard<std::mutex> lock(mutex);
+    code_blocks.emplace_back(std::move(info));
+}
+
+void VectoredHandler::RemoveCodeBlock(const u8* begin) {
+    std::lock_guard<std::mutex> lock(mutex);
+    code_blocks.erase(std::remove_if(code_blocks.begin(), code_blocks.end(), [begin](const auto& info) { return info.begin == begin; }), code_blocks.end());
+}
+
+LONG CALLBACK VectoredHandler::Handler(PEXCEPTION_POINTERS exception_info) {
+    if (exception_info->ExceptionRecord->ExceptionCode != EXCEPTION_ACCESS_VIOLATION)
+        return EXCEPTION_CONTINUE_SEARCH;
+
+    VectoredHandler& vectored_handler = GetVectoredHandler();
+    std::lock_guard<std::mutex> lock(vectored_handler.mutex);
+
+    const u8* fault_location = reinterpret_cast<const u8*>(exception_info->ContextRecord->Rip);
+    for (const auto& code_block : vectored_handler.code_blocks) {
+        if (fault_location < code_block.begin || fault_location >= code_block.end)
+            continue;
+
+        if (CodePtr resume_location = code_block.callback(fault_location)) {
+            exception_info->ContextRecord->Rip = reinterpret_cast<DWORD64>(resume_location);
+            return EXCEPTION_CONTINUE_EXECUTION;
+        }
+        break;
+    }
+
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+} // anonymous namespace
+
+struct BlockOfCode::ExceptionHandler::Impl final {
+    Impl(const u8* code_begin, const u8* code_end, FaultCallback callback) : code_begin(code_begin) {
+        GetVectoredHandler().AddCodeBlock({code_begin, code_end, std::move(callback)});
+    }
+
+    ~Impl() {
+        GetVectoredHandler().RemoveCodeBlock(code_begin);
+    }
+
+private:
+    const u8* code_begin;
+};
+
+BlockOfCode::ExceptionHandler::ExceptionHandler() = default;
+BlockOfCode::ExceptionHandler::~ExceptionHandler() = default;
+
+void BlockOfCode::ExceptionHandler::Register(BlockOfCode* code, FaultCallback callback) {
+    impl.reset();
+    impl = std::make_unique<Impl>(code->getCode(), code->getCode() + code->maxSize_, std::move(callback));
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
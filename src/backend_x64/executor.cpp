@@ -0,0 +1,256 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "dynarmic/dynarmic.h"
+
+namespace Dynarmic {
+
+/**
+ * All scheduling state is guarded by one mutex, which is only taken between quanta and by the calls
+ * that change a Jit's state, so that workers never contend for it while running guest code.
+ */
+struct Executor::Impl {
+    struct Instance {
+        Jit* jit;
+        size_t quantum_cycles;
+        size_t worker;              ///< The worker that last ran this Jit, or whose queue it is in
+        bool queued = false;
+        bool running = false;
+        bool asleep = false;
+        bool removed = false;
+        std::thread::id runner;     ///< The thread running this Jit, if running
+    };
+
+    explicit Impl(size_t worker_count) : queues(worker_count) {
+        workers.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; i++) {
+            workers.emplace_back([this, i]{ WorkerMain(i); });
+        }
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stop_requested = true;
+        }
+        work_available.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void Add(Jit& jit, size_t quantum_cycles) {
+        ASSERT(quantum_cycles > 0);
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            ASSERT_MSG(instances.count(&jit) == 0, "Jit has already been added");
+            auto& instance = instances[&jit];
+            instance = std::make_unique<Instance>();
+            instance->jit = &jit;
+            instance->quantum_cycles = quantum_cycles;
+            // New Jits are spread over the workers; stealing evens out the load from then on.
+            instance->worker = next_worker++ % queues.size();
+            Enqueue(*instance);
+        }
+        work_available.notify_one();
+    }
+
+    void Remove(Jit& jit) {
+        std::unique_lock<std::mutex> lock{mutex};
+        Instance& instance = Find(jit);
+        ASSERT_MSG(instance.runner != std::this_thread::get_id(), "Cannot remove a Jit from its own callback");
+        instance.removed = true;
+        quantum_ended.wait(lock, [&]{ return !instance.running; });
+        Unqueue(instance);
+        instances.erase(&jit);
+        quantum_ended.notify_all();
+    }
+
+    void Sleep(Jit& jit) {
+        std::lock_guard<std::mutex> lock{mutex};
+        Instance& instance = Find(jit);
+        instance.asleep = true;
+        if (instance.running) {
+            if (instance.runner == std::this_thread::get_id()) {
+                jit.HaltExecution();
+            } else {
+                jit.SignalInterrupt();
+            }
+        }
+        Unqueue(instance);
+        quantum_ended.notify_all();
+    }
+
+    void Wake(Jit& jit) {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!WakeInstance(Find(jit)))
+                return;
+        }
+        work_available.notify_one();
+    }
+
+    void WakeAll() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            for (auto& entry : instances) {
+                WakeInstance(*entry.second);
+            }
+        }
+        work_available.notify_all();
+    }
+
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lock{mutex};
+        quantum_ended.wait(lock, [this]{
+            return std::all_of(instances.begin(), instances.end(), [](const auto& entry) {
+                return !entry.second->queued && !entry.second->running;
+            });
+        });
+    }
+
+    std::vector<std::thread> workers;
+
+private:
+    Instance& Find(Jit& jit) {
+        const auto iter = instances.find(&jit);
+        ASSERT_MSG(iter != instances.end(), "Jit has not been added");
+        return *iter->second;
+    }
+
+    /// Returns true if the instance was queued to run.
+    bool WakeInstance(Instance& instance) {
+        if (!instance.asleep)
+            return false;
+        instance.asleep = false;
+        if (instance.running)
+            return false; // The worker running it queues it again when its Run returns.
+        Enqueue(instance);
+        return true;
+    }
+
+    void Enqueue(Instance& instance) {
+        ASSERT(!instance.queued);
+        queues[instance.worker].push_back(&instance);
+        instance.queued = true;
+    }
+
+    void Unqueue(Instance& instance) {
+        if (!instance.queued)
+            return;
+        auto& queue = queues[instance.worker];
+        queue.erase(std::find(queue.begin(), queue.end(), &instance));
+        instance.queued = false;
+    }
+
+    /// Takes the next Jit from this worker's own queue, or failing that steals one from another worker's.
+    Instance* TakeWork(size_t worker) {
+        if (!queues[worker].empty()) {
+            Instance* instance = queues[worker].front();
+            queues[worker].pop_front();
+            return instance;
+        }
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            auto& victim = queues[(worker + offset) % queues.size()];
+            if (!victim.empty()) {
+                // The victim takes from the front of its queue, so the Jit at the back would wait the longest.
+                Instance* instance = victim.back();
+                victim.pop_back();
+                return instance;
+            }
+        }
+        return nullptr;
+    }
+
+    void WorkerMain(size_t worker) {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        while (true) {
+            Instance* instance = nullptr;
+            work_available.wait(lock, [&]{ return stop_requested || (instance = TakeWork(worker)) != nullptr; });
+            if (stop_requested)
+                return;
+
+            instance->queued = false;
+            instance->running = true;
+            instance->runner = std::this_thread::get_id();
+            instance->worker = worker;
+
+            lock.unlock();
+            instance->jit->Run(instance->quantum_cycles);
+            lock.lock();
+
+            instance->running = false;
+            instance->runner = {};
+            if (!instance->asleep && !instance->removed) {
+                Enqueue(*instance);
+                // Let an idle worker steal from this queue if there is more in it than this worker runs next.
+                if (queues[worker].size() > 1) {
+                    work_available.notify_one();
+                }
+            }
+            quantum_ended.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable quantum_ended;
+    std::vector<std::deque<Instance*>> queues; ///< One for each worker
+    std::unordered_map<Jit*, std::unique_ptr<Instance>> instances;
+    size_t next_worker = 0;
+    bool stop_requested = false;
+};
+
+Executor::Executor(size_t worker_count) {
+    if (worker_count == 0) {
+        worker_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    impl = std::make_unique<Impl>(worker_count);
+}
+
+Executor::~Executor() = default;
+
+size_t Executor::WorkerCount() const {
+    return impl->workers.size();
+}
+
+void Executor::Add(Jit& jit, size_t quantum_cycles) {
+    impl->Add(jit, quantum_cycles);
+}
+
+void Executor::Remove(Jit& jit) {
+    impl->Remove(jit);
+}
+
+void Executor::Sleep(Jit& jit) {
+    impl->Sleep(jit);
+}
+
+void Executor::Wake(Jit& jit) {
+    impl->Wake(jit);
+}
+
+void Executor::WakeAll() {
+    impl->WakeAll();
+}
+
+void Executor::WaitIdle() {
+    impl->WaitIdle();
+}
+
+} // namespace Dynarmic
@@ -22,11 +22,11 @@ Xbyak::Xmm HostLocToXmm(HostLoc loc) {
 Xbyak::Address SpillToOpArg(HostLoc loc) {
     using namespace Xbyak::util;
 
-    static_assert(std::is_same<decltype(JitState::Spill[0]), u64&>::value, "Spill must be u64");
+    static_assert(sizeof(JitState::Spill[0]) == 2 * sizeof(u64), "Spill slots must be 128-bit");
     DEBUG_ASSERT(HostLocIsSpill(loc));
 
     size_t i = static_cast<size_t>(loc) - static_cast<size_t>(HostLoc::FirstSpill);
-    return qword[r15 + offsetof(JitState, Spill) + i * sizeof(u64)];
+    return qword[r15 + offsetof(JitState, Spill) + i * sizeof(JitState::Spill[0])];
 }
 
 } // namespace BackendX64
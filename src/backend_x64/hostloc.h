@@ -53,6 +53,7 @@ inline bool HostLocIsSpill(HostLoc reg) {
 using HostLocList = std::initializer_list<HostLoc>;
 
 // RSP is preserved for function calls
+// R14 contains the guest memory base (see BlockOfCode::GenRunCode)
 // R15 contains the JitState pointer
 const HostLocList any_gpr = {
     HostLoc::RAX,
@@ -68,7 +69,6 @@ const HostLocList any_gpr = {
     HostLoc::R11,
     HostLoc::R12,
     HostLoc::R13,
-    HostLoc::R14,
 };
 
 const HostLocList any_xmm = {
@@ -4,57 +4,2033 @@
  * General Public License version 2 or any later version.
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include <boost/optional.hpp>
+#include <boost/variant/get.hpp>
 #include <fmt/format.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
 #ifdef DYNARMIC_USE_LLVM
 #include <llvm-c/Disassembler.h>
 #include <llvm-c/Target.h>
 #endif
 
+#include "backend_x64/background_translator.h"
+#include "backend_x64/block_interpreter.h"
 #include "backend_x64/block_of_code.h"
+#include "backend_x64/call_profiler.h"
 #include "backend_x64/emit_x64.h"
 #include "backend_x64/jitstate.h"
 #include "common/assert.h"
+#include "common/bit_util.h"
 #include "common/common_types.h"
+#include "common/flat_hash_map.h"
 #include "common/scope_exit.h"
 #include "dynarmic/dynarmic.h"
 #include "frontend/ir/basic_block.h"
 #include "frontend/ir/location_descriptor.h"
+#include "frontend/ir/serialized_block.h"
+#include "frontend/ir/terminal.h"
 #include "frontend/translate/translate.h"
+#include "ir_opt/pass_manager.h"
 #include "ir_opt/passes.h"
 
-namespace Dynarmic {
+namespace Dynarmic {
+
+using namespace BackendX64;
+
+static u64 NextCodeGeneration() {
+    static std::atomic<u64> next_code_generation{1};
+    return next_code_generation++;
+}
+
+static u64 NanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+static u64 ReadTimestampCounter() {
+    return __rdtsc();
+}
+
+/// Counts a duration of `ticks` in `histogram` (see LatencyBucketCount).
+static void RecordLatency(LatencyHistogram& histogram, u64 ticks) {
+    size_t bucket = 0;
+    while (ticks >>= 1)
+        bucket++;
+    histogram.counts[bucket]++;
+}
+
+/// Whether any of `guest_ranges` overlaps [start_address, start_address + length).
+static bool OverlapsGuestRanges(const std::vector<std::pair<u32, u32>>& guest_ranges, u32 start_address, size_t length) {
+    if (length == 0)
+        return false;
+
+    // Inclusive range, as in EmitX64::InvalidateCacheRange.
+    const u64 range_start = start_address;
+    const u64 range_end = std::min<u64>(range_start + length - 1, 0xFFFFFFFF);
+
+    return std::any_of(guest_ranges.begin(), guest_ranges.end(), [&](const auto& guest_range) {
+        const u64 block_start = guest_range.first;
+        const u64 block_end = u64(guest_range.second) - 1;
+        return guest_range.first != guest_range.second && block_start <= range_end && range_start <= block_end;
+    });
+}
+
+/// Appends the locations of the blocks that `terminal` may link to.
+static void GetLinkTargets(const IR::Terminal& terminal, std::vector<IR::LocationDescriptor>& targets) {
+    if (const auto* link = boost::get<IR::Term::LinkBlock>(&terminal)) {
+        targets.push_back(link->next);
+    } else if (const auto* link_fast = boost::get<IR::Term::LinkBlockFast>(&terminal)) {
+        targets.push_back(link_fast->next);
+    } else if (const auto* if_ = boost::get<IR::Term::If>(&terminal)) {
+        GetLinkTargets(if_->then_, targets);
+        GetLinkTargets(if_->else_, targets);
+    } else if (const auto* check_halt = boost::get<IR::Term::CheckHalt>(&terminal)) {
+        GetLinkTargets(check_halt->else_, targets);
+    }
+}
+
+/// Appends `str` to `out` as a JSON string literal.
+static void AppendJsonString(std::string& out, const std::string& str) {
+    out += '"';
+    for (char c : str) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<u8>(c) < 0x20) {
+                out += fmt::format("\\u{:04x}", static_cast<u8>(c));
+            } else {
+                out += c;
+            }
+            break;
+        }
+    }
+    out += '"';
+}
+
+/// Appends the `size` bytes at `data` to `out` as a JSON string of hexadecimal digits.
+static void AppendJsonHex(std::string& out, const u8* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    out += '"';
+    for (size_t i = 0; i < size; i++) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0xF];
+    }
+    out += '"';
+}
+
+/**
+ * Emitted code and the structures used to look it up, shared by all Jits attached to it.
+ * Each attached Jit (core) has its own JitState. Cores only run guest code while not holding the
+ * cache mutex; anything that modifies code another core may be running first stops all cores.
+ */
+struct CodeCache final {
+    explicit CodeCache(UserCallbacks callbacks)
+            : block_of_code(callbacks)
+            , emitter(&block_of_code, callbacks)
+            , callbacks(callbacks)
+            , interpreter(callbacks, block_of_code.GetDispatcherAddress())
+    {
+        ASSERT_MSG(callbacks.address_space_count >= 1 && callbacks.address_space_count <= IR::LocationDescriptor::MAX_ADDRESS_SPACES,
+                   "address_space_count must be between 1 and %zu", IR::LocationDescriptor::MAX_ADDRESS_SPACES);
+        // The worker thread would read guest code while the host may already have switched to another process.
+        ASSERT_MSG(callbacks.address_space_count == 1 || !callbacks.background_translation,
+                   "address_space_count cannot be combined with background_translation");
+
+        BuildPipelines();
+        emitter.SetExclusiveWriteCallback(&CodeCache::ClearOtherExclusiveMonitors, this);
+
+        if (callbacks.background_translation) {
+            background_translator = std::make_unique<BackgroundTranslator>([this](IR::LocationDescriptor descriptor, bool hot) {
+                return TranslateBlock(descriptor, hot);
+            });
+        }
+    }
+
+    struct Core {
+        JitState* jit_state;
+        bool running = false;         ///< True while this core is executing guest code.
+        bool halted_by_cache = false; ///< True if this core was halted to stop all cores.
+    };
+
+    BlockOfCode block_of_code;
+    EmitX64 emitter;
+    const UserCallbacks callbacks;
+    BlockInterpreter interpreter;
+
+    /// Optimizations applied to newly translated (cold) blocks, to hot blocks, and to step blocks.
+    Optimization::PassManager cold_passes;
+    Optimization::PassManager hot_passes;
+    Optimization::PassManager step_passes;
+
+    /// Held while looking up, translating, emitting or invalidating code, and while accessing `cores`.
+    std::mutex mutex;
+    /// Notified whenever a core stops executing guest code.
+    std::condition_variable core_stopped;
+    std::list<Core> cores;
+    size_t running_cores = 0;
+    /// Changed whenever emitted code that an RSB may point to is discarded. Unique across all caches.
+    u64 code_generation = NextCodeGeneration();
+
+    /// A translated block that is run by `interpreter` until it has executed `interpreter_threshold` times.
+    struct InterpretedBlock {
+        IR::Block ir_block;
+        bool hot;
+        /// nullptr if the block cannot be interpreted, in which case it is emitted on its next execution.
+        std::shared_ptr<const BlockInterpreter::Program> program;
+        size_t execution_count = 0;
+    };
+    /// Blocks that have been translated but not yet emitted, by location hash.
+    std::unordered_map<u64, InterpretedBlock> interpreted_blocks;
+
+    /// Guest functions replaced by host functions, and breakpoints, by address. Guarded by `host_functions_mutex`
+    /// rather than `mutex`, as they are looked up while translating on the background thread.
+    std::unordered_map<u32, HostFunction> host_functions;
+    std::unordered_set<u32> breakpoints;
+    mutable std::mutex host_functions_mutex;
+
+    /// Optimized IR of translated blocks, kept so that blocks emitted again after being discarded need
+    /// not be retranslated (see UserCallbacks::ir_cache_capacity). Guarded by `ir_cache_mutex`, as blocks
+    /// may be translated on the background thread.
+    struct RetainedBlock {
+        bool hot;
+        u64 code_hash; ///< Of the guest code and data the block was built from, see HashBlockSources
+        IR::SerializedBlock block;
+    };
+    mutable std::unordered_map<u64, RetainedBlock> retained_blocks;
+    /// Location hashes of retained_blocks, oldest first, which are discarded first when it is full.
+    mutable std::deque<u64> retained_block_order;
+    mutable std::mutex ir_cache_mutex;
+
+    /// Whether each translated block overwrites the NZCV flags before it could read them, by location hash
+    /// (see Optimization::DeadFlagStoreElimination). Guarded by `flag_summaries_mutex`, as blocks may be
+    /// translated on the background thread.
+    mutable Common::FlatHashMap<bool> flag_summaries;
+    mutable std::mutex flag_summaries_mutex;
+
+    // Counters for JitStatistics. Blocks may be translated on the background thread without `mutex`.
+    mutable std::atomic<u64> blocks_translated{0};
+    mutable std::atomic<u64> translate_time_ns{0};
+    mutable std::atomic<u64> optimize_time_ns{0};
+    mutable std::atomic<u64> ir_cache_hits{0};
+    u64 bytes_emitted = 0;
+    u64 emit_time_ns = 0;
+    u64 cache_hits = 0;
+    u64 cache_misses = 0;
+
+    /// Which of the blocks reachable from a block are to be translated ahead of their execution.
+    struct Lookahead {
+        u32 start;    ///< Blocks are only translated if their PC is in [start, end).
+        u64 end;
+        size_t depth; ///< Number of blocks to translate along each path, counting the block itself.
+    };
+    /// Blocks queued for background translation by TranslateAhead, by location hash, of which the blocks
+    /// they link to are queued in turn once they are published.
+    std::unordered_map<u64, Lookahead> lookahead_requests;
+
+    /// Tier-ups since hot blocks were last laid out (see UserCallbacks::hot_layout_interval).
+    size_t tier_ups_since_hot_layout = 0;
+    /// Samples that have fallen in each block, by location hash (see UserCallbacks::hot_block_samples).
+    /// Kept when a block is retranslated, so that hot blocks stay ordered by them for the hot layout.
+    std::unordered_map<u64, u64> block_samples;
+
+    /// The PCs of the blocks on each recorded trace, by the location hash of its first block (see
+    /// UserCallbacks::trace_instruction_budget). Guarded by `traces_mutex`, as it is read while translating.
+    std::unordered_map<u64, std::vector<u32>> traces;
+    mutable std::mutex traces_mutex;
+
+    /// The register values each block that has become hot is specialized on, by location hash (see
+    /// UserCallbacks::specialize_register_values); none for a block whose guards have failed, which stays
+    /// generic. Guarded by `register_specializations_mutex`, as it is read while translating.
+    std::unordered_map<u64, std::vector<std::pair<Arm::Reg, u32>>> register_specializations;
+    mutable std::mutex register_specializations_mutex;
+
+    /// The code of Jit::RunInstructions, which runs at most max_instructions instructions from a location and
+    /// then returns to the dispatcher (see EmitX64::EmitIsolated), by location hash. Kept apart from the
+    /// blocks of the emitter, as several blocks with different bounds may start at a location.
+    struct StepBlock {
+        size_t max_instructions;
+        CodePtr code_ptr;
+        size_t size;
+        std::vector<std::pair<u32, u32>> guest_ranges;
+
+        bool InCodeRegion(CodePtr begin, CodePtr end) const {
+            const u8* block_begin = static_cast<const u8*>(code_ptr);
+            return block_begin < static_cast<const u8*>(end) && static_cast<const u8*>(begin) < block_begin + size;
+        }
+    };
+    std::unordered_map<u64, std::vector<StepBlock>> step_blocks;
+
+    // Declared last so that the worker thread stops before anything it uses is destroyed.
+    std::unique_ptr<BackgroundTranslator> background_translator;
+
+    void BuildPipelines() {
+        using namespace Optimization;
+
+        const auto constant_propagation = [this](IR::Block& block) { ConstantPropagation(block, callbacks); };
+        const auto memory_forwarding = [this](IR::Block& block) { MemoryForwarding(block, callbacks); };
+        const auto dead_flag_store_elimination = [this](IR::Block& block) {
+            DeadFlagStoreElimination(block, [this](IR::LocationDescriptor next) {
+                std::lock_guard<std::mutex> flag_summaries_lock{flag_summaries_mutex};
+                const auto iter = flag_summaries.find(next.UniqueHash());
+                return iter != flag_summaries.end() && iter->second;
+            });
+        };
+
+        hot_passes.AddPass("RegisterSpecialization", RegisterSpecialization, callbacks.specialize_register_values);
+        hot_passes.AddPass("GetSetElimination", GetSetElimination);
+        hot_passes.AddPass("ConstantPropagation", constant_propagation);
+        hot_passes.AddPass("CommonSubexpressionElimination", CommonSubexpressionElimination);
+        hot_passes.AddPass("MemoryForwarding", memory_forwarding, callbacks.memory_forwarding);
+        // Forwarded stores may have made more values constant.
+        hot_passes.AddPass("ConstantPropagation", constant_propagation, callbacks.memory_forwarding);
+        hot_passes.AddPass("CarryChainFusion", CarryChainFusion);
+
+        for (PassManager* passes : {&cold_passes, &hot_passes, &step_passes}) {
+            // A skipped spin loop would run more instructions than a step block may.
+            passes->AddPass("SpinLoopDetection", SpinLoopDetection, callbacks.skip_spin_loops && passes != &step_passes);
+            passes->AddPass("FlagPacking", FlagPacking);
+            passes->AddPass("DeadCodeElimination", DeadCodeElimination);
+            passes->AddPass("DeadFlagStoreElimination", dead_flag_store_elimination, passes == &hot_passes);
+            passes->AddPass("MemoryAccessTracing", MemoryAccessTracing, callbacks.memory_trace_size != 0);
+            passes->AddPass("VerificationPass", [](IR::Block& block) { VerificationPass(block); });
+        }
+    }
+
+    /**
+     * Called by emitted code running on several cores when the exclusive write of `writer` succeeds:
+     * the other cores lose their reservations of the same granule, as they would have on hardware.
+     * Their reservations are cleared while they may be running, so a core that has already checked
+     * its reservation still completes its own write; global_exclusive_monitor closes that window.
+     */
+    static void ClearOtherExclusiveMonitors(void* arg, JitState* writer) {
+        CodeCache* cache = static_cast<CodeCache*>(arg);
+        std::lock_guard<std::mutex> lock{cache->mutex};
+        for (Core& core : cache->cores) {
+            JitState* other = core.jit_state;
+            if (other != writer && ((other->exclusive_address ^ writer->exclusive_address) & JitState::RESERVATION_GRANULE_MASK) == 0) {
+                other->exclusive_state = 0;
+            }
+        }
+    }
+
+    // All of the following must be called with `mutex` held.
+
+    Core* Attach(std::unique_lock<std::mutex>& lock, JitState* jit_state) {
+        cores.push_back({jit_state});
+        if (cores.size() == 2) {
+            // Code emitted so far may rely on being executed by only one thread.
+            ClearCache(lock);
+            emitter.SetConcurrentExecution(true);
+        }
+        return &cores.back();
+    }
+
+    void Detach(Core* core) {
+        ASSERT(!core->running);
+        cores.remove_if([core](const Core& c) { return &c == core; });
+    }
+
+    void EnterGuest(Core* core) {
+        core->running = true;
+        running_cores++;
+    }
+
+    /// Returns true if the core was halted by the cache rather than by its user.
+    bool LeaveGuest(Core* core) {
+        core->running = false;
+        running_cores--;
+        core_stopped.notify_all();
+        if (running_cores == 0) {
+            emitter.ApplyDeferredLinks();
+        }
+        return std::exchange(core->halted_by_cache, false);
+    }
+
+    /// Halts all cores and waits until none of them are executing guest code.
+    /// They cannot resume until `lock` is released.
+    void StopAllCores(std::unique_lock<std::mutex>& lock) {
+        for (Core& core : cores) {
+            if (core.running && !core.jit_state->halt_requested) {
+                core.halted_by_cache = true;
+                core.jit_state->halt_requested = true;
+            }
+        }
+        core_stopped.wait(lock, [this]{ return running_cores == 0; });
+        emitter.ApplyDeferredLinks();
+    }
+
+    void ResetRSBs() {
+        for (Core& core : cores) {
+            core.jit_state->ResetRSB();
+        }
+        code_generation = NextCodeGeneration();
+    }
+
+    void ClearCache(std::unique_lock<std::mutex>& lock) {
+        StopAllCores(lock);
+        if (background_translator)
+            background_translator->Discard();
+        lookahead_requests.clear();
+        {
+            std::lock_guard<std::mutex> flag_summaries_lock{flag_summaries_mutex};
+            flag_summaries.clear();
+        }
+        block_of_code.ClearCache();
+        emitter.ClearCache();
+        interpreted_blocks.clear();
+        step_blocks.clear();
+        tier_ups_since_hot_layout = 0;
+        block_samples.clear();
+        {
+            std::lock_guard<std::mutex> register_specializations_lock{register_specializations_mutex};
+            register_specializations.clear();
+        }
+        ResetRSBs();
+    }
+
+    void InvalidateCacheRanges(std::unique_lock<std::mutex>& lock, const std::vector<std::pair<u32, size_t>>& ranges) {
+        StopAllCores(lock);
+        if (background_translator)
+            background_translator->Discard();
+        lookahead_requests.clear();
+        for (const auto& range : ranges) {
+            emitter.InvalidateCacheRange(range.first, range.second);
+            InvalidateInterpretedBlocks(range.first, range.second);
+            InvalidateStepBlocks(range.first, range.second);
+        }
+        ResetRSBs();
+    }
+
+    void InvalidateInterpretedBlocks(u32 start_address, size_t length) {
+        for (auto iter = interpreted_blocks.begin(); iter != interpreted_blocks.end();) {
+            const bool overlaps = OverlapsGuestRanges(iter->second.ir_block.GuestRanges(), start_address, length);
+            iter = overlaps ? interpreted_blocks.erase(iter) : std::next(iter);
+        }
+    }
+
+    void InvalidateStepBlocks(u32 start_address, size_t length) {
+        DiscardStepBlocks([&](const StepBlock& block) { return OverlapsGuestRanges(block.guest_ranges, start_address, length); });
+    }
+
+    /// Discards the step blocks for which `predicate` returns true.
+    template <typename Predicate>
+    void DiscardStepBlocks(Predicate predicate) {
+        for (auto iter = step_blocks.begin(); iter != step_blocks.end();) {
+            auto& blocks = iter->second;
+            blocks.erase(std::remove_if(blocks.begin(), blocks.end(), predicate), blocks.end());
+            iter = blocks.empty() ? step_blocks.erase(iter) : std::next(iter);
+        }
+    }
+
+    bool HasStepBlocksInCodeRegion(CodePtr begin, CodePtr end) const {
+        for (const auto& entry : step_blocks) {
+            for (const StepBlock& block : entry.second) {
+                if (block.InCodeRegion(begin, end))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    /// Discards all code and retained IR translated from `address_space`, so that the slot can be reused for another guest process.
+    void InvalidateAddressSpace(std::unique_lock<std::mutex>& lock, size_t address_space) {
+        StopAllCores(lock);
+        if (background_translator)
+            background_translator->Discard();
+        lookahead_requests.clear();
+
+        const u64 hash_mask = IR::LocationDescriptor::AddressSpaceHash(IR::LocationDescriptor::MAX_ADDRESS_SPACES - 1);
+        const u64 hash_bits = IR::LocationDescriptor::AddressSpaceHash(address_space);
+        const auto erase_address_space = [&](auto& map) {
+            for (auto iter = map.begin(); iter != map.end();) {
+                iter = (iter->first & hash_mask) == hash_bits ? map.erase(iter) : std::next(iter);
+            }
+        };
+
+        emitter.InvalidateAddressSpace(address_space);
+        erase_address_space(interpreted_blocks);
+        erase_address_space(step_blocks);
+        erase_address_space(block_samples);
+        {
+            std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+            erase_address_space(retained_blocks);
+        }
+        {
+            std::lock_guard<std::mutex> flag_summaries_lock{flag_summaries_mutex};
+            erase_address_space(flag_summaries);
+        }
+        {
+            std::lock_guard<std::mutex> traces_lock{traces_mutex};
+            erase_address_space(traces);
+        }
+        ResetRSBs();
+    }
+
+    /// Invalidates all code on the pages written by a core (see JitState::RecordCodeWrite), which can then be unmarked.
+    void InvalidateWrittenCode(std::unique_lock<std::mutex>& lock, JitState& jit_state) {
+        const u32 first_page = jit_state.code_write_first_page;
+        const u32 last_page = jit_state.code_write_last_page;
+        jit_state.code_write_first_page = 0xFFFFFFFF;
+        jit_state.code_write_last_page = 0;
+
+        const u32 start_address = first_page << UserCallbacks::PAGE_BITS;
+        const size_t length = size_t(last_page - first_page + 1) << UserCallbacks::PAGE_BITS;
+        InvalidateCacheRanges(lock, {{start_address, length}});
+        emitter.UnmarkCodePages(first_page, last_page);
+    }
+
+    void SetHostFunction(std::unique_lock<std::mutex>& lock, u32 address, HostFunction function) {
+        {
+            std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+            if (function) {
+                host_functions[address] = function;
+            } else {
+                host_functions.erase(address);
+            }
+        }
+        // Superblocks that followed a branch to address are discarded along with the block at address.
+        DiscardRetainedBlocks(address);
+        InvalidateCacheRanges(lock, {{address, 1}});
+    }
+
+    void SetBreakpoint(std::unique_lock<std::mutex>& lock, u32 address, bool enabled) {
+        {
+            std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+            if (enabled) {
+                breakpoints.insert(address);
+            } else {
+                breakpoints.erase(address);
+            }
+        }
+        // Only the blocks containing address are retranslated, to start or stop ending before it.
+        DiscardRetainedBlocks(address);
+        InvalidateCacheRanges(lock, {{address, 1}});
+    }
+
+    bool HasBreakpoint(u32 address) const {
+        std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+        return breakpoints.count(address) != 0;
+    }
+
+    void EvictNextCodeRegion(std::unique_lock<std::mutex>& lock) {
+        StopAllCores(lock);
+        CodePtr begin, end;
+        std::tie(begin, end) = block_of_code.GetNextRegionBounds();
+        emitter.InvalidateCodeRegion(begin, end);
+        DiscardStepBlocks([&](const StepBlock& block) { return block.InCodeRegion(begin, end); });
+        // The RSB may hold pointers into the evicted region.
+        ResetRSBs();
+        block_of_code.AdvanceToNextRegion();
+    }
+
+    /**
+     * Evicts the regions other than the current one that only hold invalidated blocks, and returns the
+     * memory of all unused parts of regions to the OS. Live blocks cannot be moved, as emitted code
+     * refers to the prelude, to its far code and to other blocks by relative address.
+     */
+    void CompactCodeCache(std::unique_lock<std::mutex>& lock) {
+        StopAllCores(lock);
+        bool discarded = false;
+        for (size_t region = 0; region < block_of_code.GetRegionCount(); region++) {
+            if (region == block_of_code.GetCurrentRegion())
+                continue;
+            CodePtr begin, end;
+            std::tie(begin, end) = block_of_code.GetRegionBounds(region);
+            if (emitter.HasBlocksInCodeRegion(begin, end) || HasStepBlocksInCodeRegion(begin, end))
+                continue;
+            // Forgets any patch locations and inline caches left in the region.
+            emitter.InvalidateCodeRegion(begin, end);
+            block_of_code.DiscardRegion(region);
+            discarded = true;
+        }
+        if (discarded) {
+            // The RSB may hold return addresses in invalidated blocks.
+            ResetRSBs();
+        }
+        block_of_code.ReleaseUnusedCode();
+    }
+
+    void GetMemoryUsage(JitMemoryUsage& usage) const {
+        usage.code_space_reserved = block_of_code.GetReservedSize();
+        usage.code_space_used = block_of_code.GetUsedSize();
+        usage.prelude_bytes = block_of_code.GetPreludeSize();
+        usage.constant_bytes = block_of_code.GetConstantsSize();
+
+        const EmitX64::MemoryUsage emitter_usage = emitter.GetMemoryUsage();
+        usage.block_count = emitter_usage.block_count;
+        usage.block_descriptor_bytes = emitter_usage.block_descriptor_bytes;
+        usage.patch_site_count = emitter_usage.patch_site_count;
+        usage.patch_information_bytes = emitter_usage.patch_information_bytes;
+
+        usage.ir_bytes = 0;
+        for (const auto& entry : interpreted_blocks) {
+            usage.ir_bytes += sizeof(entry) + entry.second.ir_block.AllocatedBytes();
+        }
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        for (const auto& entry : retained_blocks) {
+            usage.ir_bytes += sizeof(entry.first) + entry.second.block.AllocatedBytes();
+        }
+    }
+
+    void ReplaceBlock(std::unique_lock<std::mutex>& lock, IR::LocationDescriptor descriptor) {
+        StopAllCores(lock);
+        emitter.InvalidateBlock(descriptor);
+        ResetRSBs();
+    }
+
+    bool IsTieringDisabled() const {
+        return callbacks.hot_block_threshold == 0 && callbacks.hot_block_samples == 0;
+    }
+
+    bool IsSampledTiering() const {
+        return callbacks.hot_block_samples != 0;
+    }
+
+    /// Whether the block is a cold translation, which is to be retranslated once it becomes hot.
+    static bool IsCold(const EmitX64::BlockDescriptor& block) {
+        return block.profiling == EmitX64::Profiling::TierUp || block.profiling == EmitX64::Profiling::Sampled;
+    }
+
+    bool IsHot(const EmitX64::BlockDescriptor& block) const {
+        return block.profiling == EmitX64::Profiling::TierUp && *block.execution_count >= callbacks.hot_block_threshold;
+    }
+
+    /// Whether the block was specialized on register values that a later entry did not have.
+    static bool HasFailedGuard(const EmitX64::BlockDescriptor& block) {
+        return block.guard_failures && *block.guard_failures != 0;
+    }
+
+    /**
+     * Specializes the block that has just become hot on the values of the registers it recorded that were
+     * the same on every entry (see UserCallbacks::specialize_register_values), unless it has been before.
+     */
+    void ChooseRegisterSpecialization(const EmitX64::BlockDescriptor& block) {
+        if (!block.register_profile)
+            return;
+
+        std::vector<std::pair<Arm::Reg, u32>> guards;
+        for (size_t i = 0; i < block.profiled_registers.size(); i++) {
+            // Recorded once on the first entry, and again on every entry where the value changed.
+            const u64 value = block.register_profile[i * 2];
+            const u64 times_recorded = block.register_profile[i * 2 + 1];
+            if (times_recorded == 1)
+                guards.emplace_back(block.profiled_registers[i], static_cast<u32>(value));
+        }
+        std::lock_guard<std::mutex> register_specializations_lock{register_specializations_mutex};
+        register_specializations.emplace(block.start_location.UniqueHash(), std::move(guards));
+    }
+
+    /// Makes the block at `descriptor`, whose guards have failed, generic from its next translation on.
+    void DiscardRegisterSpecialization(IR::LocationDescriptor descriptor) {
+        std::lock_guard<std::mutex> register_specializations_lock{register_specializations_mutex};
+        register_specializations[descriptor.UniqueHash()].clear();
+    }
+
+    bool IsTracingEnabled() const {
+        return callbacks.trace_instruction_budget != 0 && !IsTieringDisabled() && !IsSampledTiering() && !background_translator;
+    }
+
+    /**
+     * Counts the samples of emitted code taken by Jit::RecordSample, and retranslates the cold blocks that
+     * have become hot (see UserCallbacks::hot_block_samples). `host_pcs` is sorted in the process.
+     */
+    void ProcessSamples(std::unique_lock<std::mutex>& lock, std::vector<CodePtr>& host_pcs) {
+        std::sort(host_pcs.begin(), host_pcs.end(), std::less<CodePtr>());
+        for (const EmitX64::BlockSamples& sampled : emitter.CountSamples(host_pcs)) {
+            u64& samples = block_samples[sampled.location.UniqueHash()];
+            samples += sampled.samples;
+            if (sampled.profiling != EmitX64::Profiling::Sampled || samples < callbacks.hot_block_samples)
+                continue;
+
+            if (background_translator) {
+                // Replaces the cold translation when published.
+                background_translator->Enqueue(sampled.location, true);
+                continue;
+            }
+            ReplaceBlock(lock, sampled.location);
+            NoteTierUp(lock);
+            IR::Block ir_block = TranslateBlock(sampled.location, true);
+            EmitBlock(lock, ir_block, true);
+        }
+    }
+
+    /// The hot blocks to lay out, most frequently executed first: by execution count, or with sampled tiering by samples.
+    std::vector<EmitX64::BlockDescriptor> GetHotBlocksByHeat() const {
+        std::vector<EmitX64::BlockDescriptor> blocks;
+        if (!IsSampledTiering()) {
+            blocks = emitter.GetCountedBlocks();
+            blocks.erase(std::find_if(blocks.begin(), blocks.end(), [](const auto& block) { return *block.execution_count == 0; }), blocks.end());
+            return blocks;
+        }
+
+        std::vector<std::pair<u64, EmitX64::BlockDescriptor>> sampled_blocks;
+        for (EmitX64::BlockDescriptor& block : emitter.GetBlocks()) {
+            const auto samples = block_samples.find(block.start_location.UniqueHash());
+            if (!IsCold(block) && samples != block_samples.end() && samples->second != 0)
+                sampled_blocks.emplace_back(samples->second, std::move(block));
+        }
+        std::stable_sort(sampled_blocks.begin(), sampled_blocks.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (auto& sampled : sampled_blocks) {
+            blocks.push_back(std::move(sampled.second));
+        }
+        return blocks;
+    }
+
+    /// The blocks translated as hot, hottest first (see Jit::GetHotBlocks).
+    std::vector<HotBlockRecord> GetHotBlockRecords() const {
+        std::vector<HotBlockRecord> records;
+        std::unordered_set<u64> recorded;
+        for (const EmitX64::BlockDescriptor& block : GetHotBlocksByHeat()) {
+            const u64 location = block.start_location.UniqueHash();
+            const u64 heat = IsSampledTiering() ? block_samples.at(location) : *block.execution_count;
+            records.push_back({location, heat});
+            recorded.insert(location);
+        }
+        for (const EmitX64::BlockDescriptor& block : emitter.GetBlocks()) {
+            const u64 location = block.start_location.UniqueHash();
+            if (!IsCold(block) && recorded.count(location) == 0)
+                records.push_back({location, 0});
+        }
+        return records;
+    }
+
+    /// Translates the blocks of `records` as hot, in order, unless they already are (see Jit::PrecompileHotBlocks).
+    void PrecompileHotBlocks(std::unique_lock<std::mutex>& lock, const std::vector<HotBlockRecord>& records) {
+        for (const HotBlockRecord& record : records) {
+            const IR::LocationDescriptor descriptor = IR::LocationDescriptor::FromUniqueHash(record.location);
+            if (descriptor.AddressSpace() >= callbacks.address_space_count)
+                continue;
+            const auto block = emitter.GetBasicBlock(descriptor);
+            if (block && !IsCold(*block))
+                continue;
+
+            if (background_translator) {
+                // Replaces the cold translation, if any, when published.
+                background_translator->Enqueue(descriptor, true);
+                continue;
+            }
+            if (block) {
+                ReplaceBlock(lock, descriptor);
+            }
+            interpreted_blocks.erase(record.location);
+            IR::Block ir_block = TranslateBlock(descriptor, true);
+            EmitBlock(lock, ir_block, true);
+        }
+    }
+
+    /// How hot blocks are emitted: with hot_layout_interval they keep counting their executions, unless tiering is sampled.
+    EmitX64::Profiling HotProfiling() const {
+        return block_of_code.HasHotRegion() && !IsSampledTiering() ? EmitX64::Profiling::Count : EmitX64::Profiling::None;
+    }
+
+    /**
+     * Records the blocks a core executes from a block that has just become hot, which it is made to
+     * execute one at a time meanwhile, as a trace (see UserCallbacks::trace_instruction_budget).
+     * `trace` holds the locations recorded by the core so far. If execution returns to the first of them,
+     * it is retranslated along the trace; if execution goes elsewhere, it is retranslated on its own.
+     * @return true if recording starts at descriptor, whose cold translation is then to be run as it is.
+     */
+    bool RecordTrace(std::unique_lock<std::mutex>& lock, IR::LocationDescriptor descriptor, std::vector<IR::LocationDescriptor>& trace) {
+        if (trace.empty()) {
+            const auto block = emitter.GetBasicBlock(descriptor);
+            if (!block || !IsHot(*block) || descriptor.TFlag())
+                return false;
+            trace.push_back(descriptor);
+            return true;
+        }
+
+        const IR::LocationDescriptor head = trace.front();
+        if (descriptor == head) {
+            std::vector<u32> path;
+            for (const IR::LocationDescriptor& location : trace) {
+                path.push_back(location.PC());
+            }
+            trace.clear();
+            {
+                std::lock_guard<std::mutex> traces_lock{traces_mutex};
+                traces[head.UniqueHash()] = std::move(path);
+            }
+            if (RetainsIR()) {
+                // The IR retained for the block was translated without the trace.
+                DiscardRetainedBlocks(head.PC());
+            }
+
+            // Replaces the block even if another core has retranslated it as hot meanwhile.
+            if (emitter.GetBasicBlock(head)) {
+                ReplaceBlock(lock, head);
+                NoteTierUp(lock);
+            }
+            IR::Block ir_block = TranslateBlock(head, true);
+            EmitBlock(lock, ir_block, true);
+            return false;
+        }
+
+        // A trace stays in one instruction set and mode, and does not loop other than back to its start.
+        const bool revisits = std::find(trace.begin(), trace.end(), descriptor) != trace.end();
+        if (revisits || descriptor.SetPC(head.PC()) != head || trace.size() >= callbacks.trace_instruction_budget) {
+            trace.clear();
+            if (emitter.GetBasicBlock(head)) {
+                GetBasicBlock(lock, head);
+            }
+            return false;
+        }
+        trace.push_back(descriptor);
+        return false;
+    }
+
+    /// Counts a block being retranslated as hot, and lays out hot blocks anew every hot_layout_interval times.
+    void NoteTierUp(std::unique_lock<std::mutex>& lock) {
+        if (!block_of_code.HasHotRegion() || ++tier_ups_since_hot_layout < callbacks.hot_layout_interval)
+            return;
+        tier_ups_since_hot_layout = 0;
+        LayoutHotBlocks(lock);
+    }
+
+    /**
+     * Re-emits the most frequently executed hot blocks into the hot region, replacing its previous contents.
+     * Each block is followed by the hottest block it links to that has not been placed yet, so that
+     * hot paths run through adjacent code. Links to the blocks are patched to the new copies; copies
+     * outside the hot region are left in place until their region is evicted.
+     */
+    void LayoutHotBlocks(std::unique_lock<std::mutex>& lock) {
+        StopAllCores(lock);
+
+        CodePtr hot_begin, hot_end;
+        std::tie(hot_begin, hot_end) = block_of_code.GetHotRegionBounds();
+
+        // Blocks are retranslated, as their IR is not kept. Only take what is sure to fit.
+        size_t budget = static_cast<size_t>(static_cast<const u8*>(hot_end) - static_cast<const u8*>(hot_begin)) / 2;
+        std::vector<IR::Block> ir_blocks;
+        std::unordered_map<u64, size_t> index_of_block;
+        for (const EmitX64::BlockDescriptor& block : GetHotBlocksByHeat()) {
+            if (block.size > budget)
+                break;
+            budget -= block.size;
+            index_of_block.emplace(block.start_location.UniqueHash(), ir_blocks.size());
+            ir_blocks.emplace_back(TranslateBlock(block.start_location, true));
+        }
+        if (ir_blocks.empty())
+            return;
+
+        // ir_blocks is ordered hottest first.
+        std::vector<size_t> order;
+        std::vector<bool> placed(ir_blocks.size(), false);
+        size_t next_hottest = 0;
+        while (order.size() < ir_blocks.size()) {
+            while (placed[next_hottest])
+                next_hottest++;
+            boost::optional<size_t> current = next_hottest;
+            while (current) {
+                placed[*current] = true;
+                order.push_back(*current);
+
+                std::vector<IR::LocationDescriptor> targets;
+                GetLinkTargets(ir_blocks[*current].GetTerminal(), targets);
+                current = boost::none;
+                for (const IR::LocationDescriptor& target : targets) {
+                    const auto iter = index_of_block.find(target.UniqueHash());
+                    if (iter != index_of_block.end() && !placed[iter->second] && (!current || iter->second < *current))
+                        current = iter->second;
+                }
+            }
+        }
+
+        emitter.InvalidateCodeRegion(hot_begin, hot_end);
+        for (const IR::Block& ir_block : ir_blocks) {
+            emitter.InvalidateBlock(ir_block.Location());
+        }
+        ResetRSBs();
+
+        // Blocks that do not fit after all are translated again when next executed.
+        block_of_code.BeginHotRegion();
+        for (size_t index : order) {
+            if (block_of_code.IsCurrentRegionNearlyFull())
+                break;
+            const auto emit_start = std::chrono::steady_clock::now();
+            const EmitX64::BlockDescriptor block = emitter.Emit(ir_blocks[index], HotProfiling());
+            emit_time_ns += NanosecondsSince(emit_start);
+            bytes_emitted += block.size;
+        }
+        block_of_code.EndHotRegion();
+        if (running_cores == 0) {
+            emitter.ApplyDeferredLinks();
+        }
+    }
+
+    /// FNV-1a hash of the guest code words in `ranges`, read as the translator reads them, continuing from `hash`.
+    u64 HashGuestCode(const std::vector<std::pair<u32, u32>>& ranges, u64 hash = 0xCBF29CE484222325) const {
+        for (const auto& range : ranges) {
+            for (u64 vaddr = range.first & ~u32(3); vaddr < range.second; vaddr += 4) {
+                hash = (hash ^ callbacks.memory.ReadCode(static_cast<u32>(vaddr))) * 0x100000001B3;
+            }
+        }
+        return hash;
+    }
+
+    /// Hash of the guest memory that the IR of `block` (an IR::Block or IR::SerializedBlock) was built from:
+    /// its guest code and the read-only data that ConstantPropagation folded into it.
+    template <typename BlockT>
+    u64 HashBlockSources(const BlockT& block) const {
+        return HashGuestCode(block.FoldedDataRanges(), HashGuestCode(block.GuestRanges()));
+    }
+
+    /// Removes the IR of blocks containing guest code at `address` from retained_blocks.
+    void DiscardRetainedBlocks(u32 address) {
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        for (auto iter = retained_blocks.begin(); iter != retained_blocks.end();) {
+            const auto& ranges = iter->second.block.GuestRanges();
+            const bool contains_address = std::any_of(ranges.begin(), ranges.end(), [address](const auto& range) {
+                return address >= range.first && address < range.second;
+            });
+            if (contains_address || ranges.empty())
+                iter = retained_blocks.erase(iter);
+            else
+                ++iter;
+        }
+    }
+
+    /// Translates and optimizes the block at `descriptor`, or rebuilds it from retained IR if its guest
+    /// code is unchanged. Does not require `mutex`, and may be called from the background translation thread.
+    IR::Block TranslateBlock(IR::LocationDescriptor descriptor, bool hot) const {
+        const auto register_guards = RegisterGuardsOf(descriptor, hot);
+
+        // Specialized IR only holds while its guards do, so it is neither reused nor retained.
+        if (register_guards.empty()) {
+            if (auto retained = FindRetainedBlock(descriptor, hot)) {
+                ir_cache_hits++;
+                RecordFlagSummary(*retained);
+                return std::move(*retained);
+            }
+        }
+
+        Arm::TranslationOptions options = BlockTranslationOptions(descriptor, hot);
+        IR::Block ir_block = TranslateGuestCode(descriptor, options);
+        for (const auto& guard : register_guards) {
+            ir_block.AddRegisterGuard(guard.first, guard.second);
+        }
+
+        const auto optimize_start = std::chrono::steady_clock::now();
+        (hot ? hot_passes : cold_passes).Run(ir_block);
+        optimize_time_ns += NanosecondsSince(optimize_start);
+        RecordFlagSummary(ir_block);
+
+        if (RetainsIR() && register_guards.empty() && CanRetain(ir_block)) {
+            RetainBlock(ir_block, hot);
+        }
+        return ir_block;
+    }
+
+    /**
+     * Returns the IR of the block at `descriptor` as TranslateBlock would, for diagnostics. Unlike it, this
+     * has no side effects: nothing is retained, and neither statistics nor flag summaries are recorded.
+     */
+    IR::Block InspectBlock(IR::LocationDescriptor descriptor, bool hot) const {
+        const auto register_guards = RegisterGuardsOf(descriptor, hot);
+        if (register_guards.empty()) {
+            if (auto retained = FindRetainedBlock(descriptor, hot))
+                return std::move(*retained);
+        }
+
+        Arm::TranslationOptions options = BlockTranslationOptions(descriptor, hot);
+        IR::Block ir_block = TranslateWithHostFunctions(descriptor, options);
+        for (const auto& guard : register_guards) {
+            ir_block.AddRegisterGuard(guard.first, guard.second);
+        }
+        (hot ? hot_passes : cold_passes).RunUncounted(ir_block);
+        return ir_block;
+    }
+
+    /// The register values that the block at `descriptor` is specialized on, if any (see specialize_register_values).
+    std::vector<std::pair<Arm::Reg, u32>> RegisterGuardsOf(IR::LocationDescriptor descriptor, bool hot) const {
+        if (!hot || !callbacks.specialize_register_values)
+            return {};
+        std::lock_guard<std::mutex> register_specializations_lock{register_specializations_mutex};
+        const auto specialization = register_specializations.find(descriptor.UniqueHash());
+        if (specialization == register_specializations.end())
+            return {};
+        return specialization->second;
+    }
+
+    /// Rebuilds the block at `descriptor` from retained IR, if there is IR for it that may still be used.
+    boost::optional<IR::Block> FindRetainedBlock(IR::LocationDescriptor descriptor, bool hot) const {
+        if (!RetainsIR())
+            return boost::none;
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        const auto iter = retained_blocks.find(descriptor.UniqueHash());
+        if (iter == retained_blocks.end() || iter->second.hot != hot || iter->second.code_hash != HashBlockSources(iter->second.block)
+                || HasHostFunctionOrBreakpointIn(iter->second.block.GuestRanges()))
+            return boost::none;
+        return iter->second.block.Deserialize();
+    }
+
+    /// The options with which the block at `descriptor` is translated for the tier given by `hot`.
+    Arm::TranslationOptions BlockTranslationOptions(IR::LocationDescriptor descriptor, bool hot) const {
+        Arm::TranslationOptions options = BaseTranslationOptions();
+        options.cycle_costs.instruction = callbacks.cycles_per_instruction;
+        options.cycle_costs.memory_access = callbacks.cycles_per_memory_access;
+        options.cycle_costs.multiply = callbacks.cycles_per_multiply;
+        if (callbacks.GetInstructionCycles) {
+            const bool is_thumb = descriptor.TFlag();
+            options.instruction_cycles = [this, is_thumb](u32 vaddr, u32 instruction) {
+                return callbacks.GetInstructionCycles(vaddr, instruction, is_thumb, callbacks.user_arg);
+            };
+        }
+        options.max_block_instructions = MaxBlockInstructions();
+        if (hot) {
+            options.superblock_instruction_budget = callbacks.superblock_instruction_budget;
+
+            std::lock_guard<std::mutex> traces_lock{traces_mutex};
+            const auto trace = traces.find(descriptor.UniqueHash());
+            if (trace != traces.end()) {
+                options.trace = trace->second;
+                options.superblock_instruction_budget = std::max(options.superblock_instruction_budget, callbacks.trace_instruction_budget);
+            }
+        }
+        return options;
+    }
+
+    /// Whether optimized IR is retained at all. The cycle counts of blocks are part of their IR, and the costs
+    /// returned by UserCallbacks::GetInstructionCycles cannot be checked for changes as guest code is.
+    bool RetainsIR() const {
+        return callbacks.ir_cache_capacity != 0 && !callbacks.GetInstructionCycles;
+    }
+
+    /// Whether the IR of `ir_block` depends only on the guest memory it was built from, so that it may be
+    /// retained. The call of a host function holds a pointer that is only valid in this process, a block
+    /// stopping at a breakpoint only holds while the breakpoint is set, and a coprocessor register is only
+    /// declared constant for the lifetime of the Jit.
+    static bool CanRetain(const IR::Block& ir_block) {
+        if (ir_block.HasBreakpoint() || ir_block.HasFoldedCoprocessorConstant())
+            return false;
+        return std::none_of(ir_block.begin(), ir_block.end(), [](const IR::Inst& inst) {
+            return inst.GetOpcode() == IR::Opcode::CallHostFunction;
+        });
+    }
+
+    /// Whether a host function or breakpoint is set at an address in `ranges`. Retained IR translated through
+    /// such an address, e.g. loaded by LoadIRCache, would run the guest code there instead.
+    bool HasHostFunctionOrBreakpointIn(const std::vector<std::pair<u32, u32>>& ranges) const {
+        const auto in_ranges = [&ranges](u32 address) {
+            return std::any_of(ranges.begin(), ranges.end(), [address](const auto& range) {
+                return address >= range.first && address < range.second;
+            });
+        };
+
+        std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+        return std::any_of(host_functions.begin(), host_functions.end(), [&](const auto& entry) { return in_ranges(entry.first); })
+            || std::any_of(breakpoints.begin(), breakpoints.end(), in_ranges);
+    }
+
+    /// Translates and optimizes the step block at `descriptor`, which ends after at most max_instructions
+    /// instructions and counts one cycle for each (see StepBlock). Its IR is neither reused nor retained.
+    IR::Block TranslateStepBlock(IR::LocationDescriptor descriptor, size_t max_instructions) const {
+        Arm::TranslationOptions options = BaseTranslationOptions();
+        options.max_block_instructions = std::min(max_instructions, block_of_code.GetMaxBlockInstructions());
+        IR::Block ir_block = TranslateGuestCode(descriptor, options);
+
+        const auto optimize_start = std::chrono::steady_clock::now();
+        step_passes.Run(ir_block);
+        optimize_time_ns += NanosecondsSince(optimize_start);
+        return ir_block;
+    }
+
+    /// UserCallbacks::max_block_instructions, lowered to the longest block whose code is sure to fit in the
+    /// space left free in a code region (see BlockOfCode::GetMaxBlockInstructions). Superblocks and traces end there too.
+    size_t MaxBlockInstructions() const {
+        const size_t limit = block_of_code.GetMaxBlockInstructions();
+        return callbacks.max_block_instructions == 0 ? limit : std::min(callbacks.max_block_instructions, limit);
+    }
+
+    /// The translation options that do not depend on how the block is to be run.
+    Arm::TranslationOptions BaseTranslationOptions() const {
+        Arm::TranslationOptions options;
+        options.memory_get_code_page = callbacks.memory.GetCodePage;
+        options.call_hints = callbacks.CallHint != nullptr;
+        options.inline_cycle_counter = callbacks.inline_cycle_counter;
+        options.profile_calls = callbacks.profile_guest_calls;
+        // Without an inline path, 128-bit accesses are as slow as the block transfers they replace.
+        options.vector_memory_accesses = callbacks.page_table || callbacks.page_directory || callbacks.fastmem_pointer;
+        return options;
+    }
+
+    /// Translates the guest code at `descriptor` with `options`, or the call of the host function replacing it.
+    IR::Block TranslateGuestCode(IR::LocationDescriptor descriptor, Arm::TranslationOptions& options) const {
+        const auto translate_start = std::chrono::steady_clock::now();
+        IR::Block ir_block = TranslateWithHostFunctions(descriptor, options);
+        translate_time_ns += NanosecondsSince(translate_start);
+        blocks_translated++;
+        return ir_block;
+    }
+
+    /// Does what TranslateGuestCode does without counting the translation in the statistics.
+    IR::Block TranslateWithHostFunctions(IR::LocationDescriptor descriptor, Arm::TranslationOptions& options) const {
+        std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+        if (host_functions.empty() && breakpoints.empty())
+            return Arm::Translate(descriptor, callbacks.memory.ReadCode, options);
+
+        const auto host_function = host_functions.find(descriptor.PC());
+        if (host_function != host_functions.end())
+            return Arm::TranslateHostFunctionCall(descriptor, reinterpret_cast<u64>(host_function->second), options);
+
+        options.starts_own_block = [this](u32 vaddr) { return host_functions.count(vaddr) != 0 || breakpoints.count(vaddr) != 0; };
+        if (!breakpoints.empty()) {
+            options.is_breakpoint = [this](u32 vaddr) { return breakpoints.count(vaddr) != 0; };
+        }
+        return Arm::Translate(descriptor, callbacks.memory.ReadCode, options);
+    }
+
+    void RecordFlagSummary(const IR::Block& ir_block) const {
+        const bool discards_nzcv = Optimization::DiscardsNZCVOnEntry(ir_block);
+        std::lock_guard<std::mutex> flag_summaries_lock{flag_summaries_mutex};
+        flag_summaries[ir_block.Location().UniqueHash()] = discards_nzcv;
+    }
+
+    void RetainBlock(const IR::Block& ir_block, bool hot) const {
+        const u64 unique_hash = ir_block.Location().UniqueHash();
+        RetainedBlock retained{hot, HashBlockSources(ir_block), IR::SerializedBlock{ir_block}};
+
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        const auto iter = retained_blocks.find(unique_hash);
+        if (iter != retained_blocks.end()) {
+            iter->second = std::move(retained);
+            return;
+        }
+        retained_blocks.emplace(unique_hash, std::move(retained));
+        retained_block_order.push_back(unique_hash);
+        while (retained_blocks.size() > callbacks.ir_cache_capacity) {
+            retained_blocks.erase(retained_block_order.front());
+            retained_block_order.pop_front();
+        }
+    }
+
+    /// Identifies the opcodes and the translation, optimization and cycle cost settings that retained IR depends on,
+    /// so that IR saved by a different build or configuration is not loaded (see Jit::SaveIRCache).
+    u64 IRCacheSignature() const {
+        constexpr u32 format_version = 4;
+
+        u64 hash = 0xCBF29CE484222325;
+        const auto mix = [&hash](u64 value) { hash = (hash ^ value) * 0x100000001B3; };
+        const auto mix_string = [&mix](const char* str) {
+            for (; *str; str++)
+                mix(static_cast<u8>(*str));
+            mix(0);
+        };
+
+        mix(format_version);
+        for (size_t i = 0; i < IR::OpcodeCount; i++) {
+            const IR::Opcode op = static_cast<IR::Opcode>(i);
+            mix_string(IR::GetNameOf(op));
+            mix(static_cast<u64>(IR::GetTypeOf(op)));
+            for (size_t arg = 0; arg < IR::GetNumArgsOf(op); arg++)
+                mix(static_cast<u64>(IR::GetArgTypeOf(op, arg)));
+        }
+        for (const Optimization::PassManager* passes : {&cold_passes, &hot_passes}) {
+            for (const auto& pass : passes->GetStatistics())
+                mix_string(pass.name.c_str());
+            mix(0);
+        }
+        mix(callbacks.superblock_instruction_budget);
+        mix(MaxBlockInstructions());
+        mix(callbacks.trace_instruction_budget);
+        mix(callbacks.CallHint != nullptr);
+        mix(callbacks.inline_cycle_counter);
+        mix(callbacks.profile_guest_calls);
+        mix(callbacks.address_space_count > 1);
+        mix(callbacks.page_table || callbacks.page_directory || callbacks.fastmem_pointer);
+        mix(callbacks.cycles_per_instruction);
+        mix(callbacks.cycles_per_memory_access);
+        mix(callbacks.cycles_per_multiply);
+        mix(callbacks.GetInstructionCycles != nullptr);
+        return hash;
+    }
+
+    static constexpr u32 ir_cache_file_magic = 0x43524944; // "DIRC"
+
+    /// Appends the retained IR to `out` in the form read by ReadRetainedBlocks.
+    void WriteRetainedBlocks(std::vector<u8>& out) const {
+        const auto write = [&out](const auto& value) {
+            const u8* bytes = reinterpret_cast<const u8*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(value));
+        };
+
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        write(u32{ir_cache_file_magic});
+        write(IRCacheSignature());
+        write(static_cast<u64>(retained_block_order.size()));
+        for (u64 unique_hash : retained_block_order) {
+            const RetainedBlock& retained = retained_blocks.at(unique_hash);
+            write(static_cast<u8>(retained.hot));
+            write(retained.code_hash);
+            retained.block.WriteTo(out);
+        }
+    }
+
+    /**
+     * Adds the blocks in `data`, written by WriteRetainedBlocks, to the retained IR while there is room,
+     * keeping blocks that are already retained. Their guest code is only checked when they are looked up.
+     * Returns false, adding nothing, if `data` is malformed or was written by a different build or configuration.
+     */
+    bool ReadRetainedBlocks(const std::vector<u8>& data) {
+        const u8* ptr = data.data();
+        const u8* const end = ptr + data.size();
+        const auto read = [&ptr, end](auto& value) {
+            if (static_cast<size_t>(end - ptr) < sizeof(value))
+                return false;
+            std::memcpy(&value, ptr, sizeof(value));
+            ptr += sizeof(value);
+            return true;
+        };
+
+        u32 magic;
+        u64 signature, count;
+        if (!read(magic) || magic != ir_cache_file_magic || !read(signature) || signature != IRCacheSignature() || !read(count))
+            return false;
+
+        std::vector<RetainedBlock> loaded;
+        for (u64 i = 0; i < count; i++) {
+            u8 hot;
+            u64 code_hash;
+            if (!read(hot) || !read(code_hash))
+                return false;
+            auto block = IR::SerializedBlock::ReadFrom(ptr, end);
+            if (!block)
+                return false;
+            loaded.push_back({hot != 0, code_hash, std::move(*block)});
+        }
+
+        std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+        for (RetainedBlock& retained : loaded) {
+            if (retained_blocks.size() >= callbacks.ir_cache_capacity)
+                break;
+            const u64 unique_hash = retained.block.Location().UniqueHash();
+            if (retained_blocks.emplace(unique_hash, std::move(retained)).second)
+                retained_block_order.push_back(unique_hash);
+        }
+        return true;
+    }
+
+    EmitX64::BlockDescriptor EmitBlock(std::unique_lock<std::mutex>& lock, IR::Block& ir_block, bool hot) {
+        if (block_of_code.IsCurrentRegionNearlyFull()) {
+            EvictNextCodeRegion(lock);
+        }
+
+        EmitX64::Profiling profiling = IsSampledTiering() ? EmitX64::Profiling::Sampled : EmitX64::Profiling::TierUp;
+        if (hot)
+            profiling = HotProfiling();
+
+        const auto emit_start = std::chrono::steady_clock::now();
+        EmitX64::BlockDescriptor block = emitter.Emit(ir_block, profiling);
+        emit_time_ns += NanosecondsSince(emit_start);
+        bytes_emitted += block.size;
+        if (running_cores == 0) {
+            emitter.ApplyDeferredLinks();
+        }
+        return block;
+    }
+
+    /**
+     * Translates and emits the blocks reachable from `entry` by direct branches as described by `lookahead`,
+     * skipping those already translated. With background translation they are only queued, and the blocks
+     * each links to are queued when it is published.
+     */
+    void TranslateAhead(std::unique_lock<std::mutex>& lock, IR::LocationDescriptor entry, Lookahead lookahead) {
+        const bool hot = IsTieringDisabled();
+        std::unordered_set<u64> visited;
+        std::vector<IR::LocationDescriptor> targets;
+        std::vector<std::pair<IR::LocationDescriptor, size_t>> worklist{{entry, lookahead.depth}};
+        while (!worklist.empty()) {
+            const IR::LocationDescriptor descriptor = worklist.back().first;
+            const size_t depth = worklist.back().second;
+            worklist.pop_back();
+            const u64 unique_hash = descriptor.UniqueHash();
+            if (depth == 0 || descriptor.PC() < lookahead.start || descriptor.PC() >= lookahead.end || !visited.insert(unique_hash).second)
+                continue;
+            if (emitter.GetBasicBlock(descriptor) || interpreted_blocks.count(unique_hash) != 0)
+                continue;
+
+            if (background_translator) {
+                lookahead_requests[unique_hash] = {lookahead.start, lookahead.end, depth};
+                background_translator->Enqueue(descriptor, hot);
+                continue;
+            }
+            IR::Block ir_block = TranslateBlock(descriptor, hot);
+            targets.clear();
+            GetLinkTargets(ir_block.GetTerminal(), targets);
+            for (const auto& target : targets) {
+                worklist.emplace_back(target, depth - 1);
+            }
+            EmitBlock(lock, ir_block, hot);
+        }
+    }
+
+    /// Translates ahead from the blocks `ir_block` links to, which has itself been emitted.
+    void TranslateSuccessors(std::unique_lock<std::mutex>& lock, const IR::Block& ir_block, Lookahead lookahead) {
+        if (lookahead.depth <= 1)
+            return;
+        std::vector<IR::LocationDescriptor> targets;
+        GetLinkTargets(ir_block.GetTerminal(), targets);
+        for (const auto& target : targets) {
+            TranslateAhead(lock, target, {lookahead.start, lookahead.end, lookahead.depth - 1});
+        }
+    }
+
+    /// How far to translate ahead of a block translated on a cache miss (see UserCallbacks::speculative_translation_depth).
+    Lookahead SpeculativeLookahead() const {
+        return {0, u64(1) << 32, callbacks.speculative_translation_depth + 1};
+    }
+
+    /// Emits blocks finished by the background translator into the cache, replacing cold translations.
+    void PublishTranslatedBlocks(std::unique_lock<std::mutex>& lock) {
+        for (auto& translated : background_translator->TakeFinished()) {
+            const IR::LocationDescriptor descriptor = translated.block.Location();
+            bool tier_up = false;
+            if (auto block = emitter.GetBasicBlock(descriptor)) {
+                if (!translated.hot || !IsCold(*block))
+                    continue;
+                ReplaceBlock(lock, descriptor);
+                NoteTierUp(lock);
+                tier_up = true;
+            }
+            EmitBlock(lock, translated.block, translated.hot);
+
+            // Blocks not queued by TranslateAhead were queued on a cache miss, unless retranslated as hot.
+            const auto request = lookahead_requests.find(descriptor.UniqueHash());
+            if (request != lookahead_requests.end()) {
+                const Lookahead lookahead = request->second;
+                lookahead_requests.erase(request);
+                TranslateSuccessors(lock, translated.block, lookahead);
+            } else if (!tier_up) {
+                TranslateSuccessors(lock, translated.block, SpeculativeLookahead());
+            }
+        }
+    }
+
+    /// Returns the cache to the state of a newly constructed one, so it can be reused by a new Jit.
+    /// No Jit may be attached to it.
+    void Recycle(std::unique_lock<std::mutex>& lock) {
+        ASSERT(cores.empty());
+        {
+            std::lock_guard<std::mutex> host_functions_lock{host_functions_mutex};
+            host_functions.clear();
+            breakpoints.clear();
+        }
+        {
+            // The next Jit to use this cache may have different guest memory.
+            std::lock_guard<std::mutex> ir_cache_lock{ir_cache_mutex};
+            retained_blocks.clear();
+            retained_block_order.clear();
+        }
+        {
+            std::lock_guard<std::mutex> traces_lock{traces_mutex};
+            traces.clear();
+        }
+        ClearCache(lock);
+        emitter.SetConcurrentExecution(false);
+
+        blocks_translated = 0;
+        translate_time_ns = 0;
+        optimize_time_ns = 0;
+        ir_cache_hits = 0;
+        bytes_emitted = 0;
+        emit_time_ns = 0;
+        cache_hits = 0;
+        cache_misses = 0;
+        cold_passes.ResetStatistics();
+        hot_passes.ResetStatistics();
+        step_passes.ResetStatistics();
+    }
+
+    /**
+     * Returns the program to interpret for the block at `descriptor` if it should be interpreted rather
+     * than executed as emitted code, translating it if necessary. Counts the execution of the program.
+     */
+    std::shared_ptr<const BlockInterpreter::Program> GetInterpretedBlock(IR::LocationDescriptor descriptor) {
+        if (callbacks.interpreter_threshold == 0 || emitter.GetBasicBlock(descriptor))
+            return nullptr;
+
+        auto iter = interpreted_blocks.find(descriptor.UniqueHash());
+        if (iter == interpreted_blocks.end()) {
+            cache_misses++;
+            const bool hot = IsTieringDisabled();
+            IR::Block ir_block = TranslateBlock(descriptor, hot);
+            auto program = BlockInterpreter::Compile(ir_block);
+            emitter.MarkCodePages(ir_block.GuestRanges());
+            iter = interpreted_blocks.emplace(descriptor.UniqueHash(), InterpretedBlock{std::move(ir_block), hot, std::move(program)}).first;
+        } else {
+            cache_hits++;
+        }
+
+        InterpretedBlock& block = iter->second;
+        if (!block.program || block.execution_count >= callbacks.interpreter_threshold)
+            return nullptr;
+        block.execution_count++;
+        return block.program;
+    }
+
+    /**
+     * Appends the blocks in the cache to `out` in the form described at Jit::DumpCodeCache. The IR of a
+     * block is that retained for it if any, otherwise it is translated and optimized again (see InspectBlock).
+     */
+    void DumpBlocks(std::unique_lock<std::mutex>&, std::string& out) const {
+        static const char* const tier_names[] = {"hot", "cold", "counted", "cold"}; // By EmitX64::Profiling
+        static const char* const exit_reason_names[ExitReasonCount] = {"cycle_budget", "halt", "unlinked", "rsb_miss", "inline_cache_miss", "dispatch", "interpret", "tier_up", "register_guard"};
+
+        out += "{\"blocks\":[";
+        bool first_block = true;
+        for (const EmitX64::BlockDescriptor& block : emitter.GetBlocks()) {
+            const IR::LocationDescriptor location = block.start_location;
+            const IR::Block ir_block = InspectBlock(location, !IsCold(block));
+
+            out += first_block ? "\n" : ",\n";
+            first_block = false;
+            out += fmt::format("{{\"location\":\"{:016x}\",\"pc\":{},\"thumb\":{},\"tier\":\"{}\"", location.UniqueHash(), location.PC(), location.TFlag() ? "true" : "false", tier_names[static_cast<size_t>(block.profiling)]);
+            if (block.execution_count) {
+                out += fmt::format(",\"execution_count\":{}", *block.execution_count);
+            }
+
+            out += ",\"guest_ranges\":[";
+            for (size_t i = 0; i < block.guest_ranges.size(); i++) {
+                out += fmt::format("{}[{},{}]", i == 0 ? "" : ",", block.guest_ranges[i].first, block.guest_ranges[i].second);
+            }
+            out += "]";
+
+            std::vector<IR::LocationDescriptor> targets;
+            if (ir_block.GetCondition() != Arm::Cond::AL) {
+                targets.push_back(ir_block.ConditionFailedLocation());
+            }
+            GetLinkTargets(ir_block.GetTerminal(), targets);
+            std::sort(targets.begin(), targets.end(), [](const auto& a, const auto& b) { return a.UniqueHash() < b.UniqueHash(); });
+            targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+            out += ",\"links\":[";
+            for (size_t i = 0; i < targets.size(); i++) {
+                const bool linked = static_cast<bool>(emitter.GetBasicBlock(targets[i]));
+                out += fmt::format("{}{{\"location\":\"{:016x}\",\"pc\":{},\"linked\":{}", i == 0 ? "" : ",", targets[i].UniqueHash(), targets[i].PC(), linked ? "true" : "false");
+                if (callbacks.count_exits) {
+                    u64 count = 0;
+                    for (const auto& link_count : block.link_counts) {
+                        if (link_count.first == targets[i])
+                            count += *link_count.second;
+                    }
+                    out += fmt::format(",\"count\":{}", count);
+                }
+                out += "}";
+            }
+            out += "]";
+
+            if (block.exit_counts) {
+                out += ",\"exits\":{";
+                for (size_t i = 0; i < ExitReasonCount; i++) {
+                    out += fmt::format("{}\"{}\":{}", i == 0 ? "" : ",", exit_reason_names[i], block.exit_counts[i]);
+                }
+                out += "}";
+            }
+
+            out += ",\"ir\":";
+            AppendJsonString(out, IR::DumpBlock(ir_block));
+            out += fmt::format(",\"host_address\":{},\"host_size\":{},\"host_code\":", reinterpret_cast<u64>(block.code_ptr), block.size);
+            AppendJsonHex(out, static_cast<const u8*>(block.code_ptr), block.size);
+            out += "}";
+        }
+        out += "\n]}\n";
+    }
+
+    EmitX64::BlockDescriptor GetBasicBlock(std::unique_lock<std::mutex>& lock, IR::LocationDescriptor descriptor) {
+        bool hot = IsTieringDisabled();
+
+        if (auto block = emitter.GetBasicBlock(descriptor)) {
+            cache_hits++;
+            if (HasFailedGuard(*block)) {
+                // This block was specialized on register values that no longer hold; replace it with a generic translation.
+                DiscardRegisterSpecialization(descriptor);
+                ReplaceBlock(lock, descriptor);
+            } else if (IsHot(*block)) {
+                // This block has become hot; replace it with a fully optimized translation.
+                ChooseRegisterSpecialization(*block);
+                ReplaceBlock(lock, descriptor);
+                NoteTierUp(lock);
+            } else {
+                return *block;
+            }
+            hot = true;
+        }
+
+        // Blocks that have finished being interpreted have already been translated.
+        auto interpreted = interpreted_blocks.find(descriptor.UniqueHash());
+        if (interpreted != interpreted_blocks.end()) {
+            IR::Block ir_block = std::move(interpreted->second.ir_block);
+            hot = interpreted->second.hot;
+            interpreted_blocks.erase(interpreted);
+            return EmitBlock(lock, ir_block, hot);
+        }
+
+        cache_misses++;
+        IR::Block ir_block = TranslateBlock(descriptor, hot);
+        // Emitted first, as a successor may link back to it. Too few blocks follow to evict it again.
+        const EmitX64::BlockDescriptor block = EmitBlock(lock, ir_block, hot);
+        TranslateSuccessors(lock, ir_block, SpeculativeLookahead());
+        return block;
+    }
+
+    /// Returns the code of the step block at `descriptor` that runs at most max_instructions instructions, emitting it if necessary.
+    CodePtr GetStepBlock(std::unique_lock<std::mutex>& lock, IR::LocationDescriptor descriptor, size_t max_instructions) {
+        const auto blocks = step_blocks.find(descriptor.UniqueHash());
+        if (blocks != step_blocks.end()) {
+            const auto block = std::find_if(blocks->second.begin(), blocks->second.end(), [max_instructions](const StepBlock& block) {
+                return block.max_instructions == max_instructions;
+            });
+            if (block != blocks->second.end())
+                return block->code_ptr;
+        }
+
+        IR::Block ir_block = TranslateStepBlock(descriptor, max_instructions);
+        // Evicting may discard step blocks, so the block is only added to step_blocks once it has been emitted.
+        if (block_of_code.IsCurrentRegionNearlyFull()) {
+            EvictNextCodeRegion(lock);
+        }
+
+        const auto emit_start = std::chrono::steady_clock::now();
+        const EmitX64::BlockDescriptor block = emitter.EmitIsolated(ir_block);
+        emit_time_ns += NanosecondsSince(emit_start);
+        bytes_emitted += block.size;
+        step_blocks[descriptor.UniqueHash()].push_back(StepBlock{max_instructions, block.code_ptr, block.size, block.guest_ranges});
+        return block.code_ptr;
+    }
+};
+
+struct JitPool::Impl final : std::enable_shared_from_this<JitPool::Impl> {
+    Impl(UserCallbacks callbacks, size_t max_idle_caches) : callbacks(callbacks), max_idle_caches(max_idle_caches) {}
+
+    const UserCallbacks callbacks;
+    const size_t max_idle_caches;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CodeCache>> idle_caches;
+
+    /// Takes an idle cache, or constructs one if there are none. When the last Jit using it is
+    /// destroyed, the cache is returned to the pool, or destroyed if the pool no longer exists.
+    std::shared_ptr<CodeCache> Acquire() {
+        std::unique_ptr<CodeCache> cache;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!idle_caches.empty()) {
+                cache = std::move(idle_caches.back());
+                idle_caches.pop_back();
+            }
+        }
+        if (!cache) {
+            cache = std::make_unique<CodeCache>(callbacks);
+        }
+
+        std::weak_ptr<Impl> weak_pool = shared_from_this();
+        return std::shared_ptr<CodeCache>(cache.release(), [weak_pool](CodeCache* cache) {
+            std::unique_ptr<CodeCache> owned_cache{cache};
+            if (auto pool = weak_pool.lock()) {
+                pool->Release(std::move(owned_cache));
+            }
+        });
+    }
+
+    void Release(std::unique_ptr<CodeCache> cache) {
+        {
+            std::unique_lock<std::mutex> cache_lock{cache->mutex};
+            cache->Recycle(cache_lock);
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (idle_caches.size() < max_idle_caches) {
+            idle_caches.push_back(std::move(cache));
+        }
+    }
+};
+
+JitPool::JitPool(UserCallbacks callbacks, std::size_t max_idle_caches) : impl(std::make_shared<Impl>(callbacks, max_idle_caches)) {}
+
+JitPool::~JitPool() {}
+
+void JitPool::Reserve(std::size_t count) {
+    std::vector<std::unique_ptr<CodeCache>> caches;
+    {
+        std::lock_guard<std::mutex> lock{impl->mutex};
+        const size_t target = std::min(count, impl->max_idle_caches);
+        if (impl->idle_caches.size() >= target)
+            return;
+        caches.resize(target - impl->idle_caches.size());
+    }
+
+    // Constructed without the lock, so that Jits can still be constructed from the pool meanwhile.
+    for (auto& cache : caches) {
+        cache = std::make_unique<CodeCache>(impl->callbacks);
+    }
+
+    std::lock_guard<std::mutex> lock{impl->mutex};
+    for (auto& cache : caches) {
+        if (impl->idle_caches.size() >= impl->max_idle_caches)
+            break;
+        impl->idle_caches.push_back(std::move(cache));
+    }
+}
 
-using namespace BackendX64;
+struct JitContext::Impl {
+    JitState state;
+    /// The code generation of the cache when the context was saved, which determines whether the RSB is still valid.
+    u64 code_generation = 0;
+};
+
+JitContext::JitContext() : impl(std::make_unique<Impl>()) {}
+
+JitContext::JitContext(const JitContext& other) : impl(std::make_unique<Impl>(*other.impl)) {}
+
+JitContext& JitContext::operator=(const JitContext& other) {
+    *impl = *other.impl;
+    return *this;
+}
+
+JitContext::~JitContext() {}
 
 struct Jit::Impl {
-    Impl(Jit* jit, UserCallbacks callbacks)
-            : block_of_code(callbacks)
+    Impl(Jit* jit, UserCallbacks callbacks, std::shared_ptr<CodeCache> shared_cache)
+            : cache(std::move(shared_cache))
             , jit_state()
-            , emitter(&block_of_code, callbacks, jit)
             , callbacks(callbacks)
-    {}
+            , jit_interface(jit)
+    {
+        jit_state.jit_interface = jit;
+        jit_state.user_arg = callbacks.user_arg;
+        jit_state.memory_base = DefaultMemoryBase();
 
-    BlockOfCode block_of_code;
+        if (callbacks.memory_trace_size != 0) {
+            ASSERT_MSG(Common::BitCount(callbacks.memory_trace_size) == 1 && callbacks.memory_trace_size <= 0x80000000,
+                       "memory_trace_size must be a power of 2 that fits in 32 bits");
+            memory_trace = std::make_unique<MemoryAccessRecord[]>(callbacks.memory_trace_size);
+            jit_state.memory_trace = memory_trace.get();
+            jit_state.memory_trace_mask = static_cast<u32>(callbacks.memory_trace_size - 1);
+        }
+        if (callbacks.profile_guest_calls) {
+            call_profiler = std::make_unique<CallProfiler>();
+            jit_state.call_profiler = call_profiler.get();
+        }
+        if (callbacks.measure_latency) {
+            tsc_origin = ReadTimestampCounter();
+            time_origin = std::chrono::steady_clock::now();
+        }
+
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        core = cache->Attach(lock, &jit_state);
+        jit_state.code_pages = cache->emitter.GetCodePages();
+        jit_state.watched_pages = cache->emitter.GetWatchedPages();
+    }
+
+    ~Impl() {
+        std::lock_guard<std::mutex> lock{cache->mutex};
+        cache->Detach(core);
+    }
+
+    std::shared_ptr<CodeCache> cache;
+    CodeCache::Core* core;
     JitState jit_state;
-    EmitX64 emitter;
     const UserCallbacks callbacks;
+    Jit* jit_interface;
 
     bool clear_cache_required = false;
+    std::vector<std::pair<u32, size_t>> invalid_cache_ranges;
+    std::vector<size_t> invalid_address_spaces;
+    /// Set if the halt was requested through this Jit, rather than by the cache to stop all cores.
+    bool halt_requested_by_user = false;
+    /// Set by Jit::SignalInterrupt, which may be called from any thread. Cleared when Jit::Run returns.
+    std::atomic<bool> interrupt_signalled{false};
+    u64 dispatcher_exits = 0;
+    u64 blocks_interpreted = 0;
+
+    // Latency measurement (see UserCallbacks::measure_latency). The frequency of the time-stamp counter is estimated from the origin.
+    u64 tsc_origin = 0;
+    std::chrono::steady_clock::time_point time_origin;
+    /// Set by Jit::Run, at the time-stamp counter run_start, until the first block to execute has been looked up.
+    bool run_entry_pending = false;
+    u64 run_start = 0;
+    LatencyHistogram run_entry_latency;
+    LatencyHistogram dispatch_hit_latency;
+    LatencyHistogram dispatch_miss_latency;
+
+    /// See UserCallbacks::memory_trace_size. Records before memory_trace_read have been read by ReadMemoryTrace.
+    std::unique_ptr<MemoryAccessRecord[]> memory_trace;
+    u64 memory_trace_read = 0;
+
+    /// See UserCallbacks::profile_guest_calls.
+    std::unique_ptr<CallProfiler> call_profiler;
+
+    /// Set by Jit::SetAddressSpace when called during Jit::Run, which halts so that the new memory base is loaded.
+    bool address_space_switched = false;
+
+    /// Host PCs passed to Jit::RecordSample, in a ring buffer. The first samples_read of the samples_written
+    /// so far have been attributed to blocks. Samples are attributed in batches, as each batch takes a
+    /// pass over all blocks in the cache.
+    static constexpr size_t SampleBufferSize = 256;
+    static constexpr size_t SampleBatchSize = 16;
+    std::array<std::atomic<CodePtr>, SampleBufferSize> samples{};
+    std::atomic<u64> samples_written{0};
+    u64 samples_read = 0;
+    std::vector<CodePtr> sample_batch;
+
+    /// The PC of the breakpoint that the last Jit::Run stopped at, which the next Run passes if it starts there.
+    u32 breakpoint_stop_pc = 0xFFFFFFFF;
+
+    // Cycle accounting of the current Jit::Run. The targets are adjusted by Jit::SetCyclesRemaining.
+    size_t cycles_to_run = 0;
+    /// Cycles executed by the previous calls to Execute during this Run.
+    size_t cycles_executed = 0;
+    /// Cycles the current call to Execute started with; jit_state.cycles_remaining counts down from it.
+    s64 execute_cycle_budget = 0;
+
+    /// The guest cycle counter, not counting the cycles of the current call to Execute.
+    u64 cycle_counter = 0;
+
+    /// The blocks recorded so far of the trace being recorded, if any (see CodeCache::RecordTrace).
+    std::vector<IR::LocationDescriptor> trace;
+
+    /// The memory base of address space 0, and of contexts that have none (see JitState::memory_base).
+    void* DefaultMemoryBase() const {
+        if (callbacks.fastmem_pointer)
+            return callbacks.fastmem_pointer;
+        if (callbacks.page_table)
+            return callbacks.page_table;
+        return callbacks.page_directory;
+    }
+
+    void SetAddressSpace(size_t address_space, void* memory_base) {
+        ASSERT_MSG(address_space < callbacks.address_space_count, "address_space must be less than address_space_count");
+        ASSERT_MSG((memory_base != nullptr) == (DefaultMemoryBase() != nullptr),
+                   "memory_base must be given exactly when fastmem_pointer, page_table or page_directory is");
+        jit_state.address_space = static_cast<u32>(address_space);
+        jit_state.address_space_hash = static_cast<u32>(IR::LocationDescriptor::AddressSpaceHash(address_space) >> 32);
+        jit_state.memory_base = memory_base;
+    }
+
+    void RecordSample(CodePtr host_pc) {
+        // Only one writer at a time, which may interrupt the reader.
+        const u64 count = samples_written.load(std::memory_order_relaxed);
+        samples[count % SampleBufferSize].store(host_pc, std::memory_order_relaxed);
+        samples_written.store(count + 1, std::memory_order_release);
+    }
+
+    /// Passes the samples recorded since the last call to the cache, once there are enough of them for a batch.
+    void ProcessSamples(std::unique_lock<std::mutex>& lock) {
+        const u64 end = samples_written.load(std::memory_order_acquire);
+        if (end - samples_read < SampleBatchSize)
+            return;
+
+        // Samples older than the buffer holds have been overwritten.
+        const u64 begin = std::max<u64>(samples_read, end > SampleBufferSize ? end - SampleBufferSize : 0);
+        sample_batch.clear();
+        for (u64 i = begin; i < end; i++) {
+            sample_batch.push_back(samples[i % SampleBufferSize].load(std::memory_order_relaxed));
+        }
+        samples_read = end;
+        cache->ProcessSamples(lock, sample_batch);
+    }
+
+    size_t GetCyclesExecuted() const {
+        return cycles_executed + static_cast<size_t>(execute_cycle_budget - jit_state.cycles_remaining);
+    }
+
+    void SetCyclesRemaining(size_t cycle_count) {
+        ASSERT(cycle_count <= static_cast<size_t>(std::numeric_limits<s64>::max()));
+        const size_t executed = GetCyclesExecuted();
+        execute_cycle_budget += static_cast<s64>(cycle_count) - jit_state.cycles_remaining;
+        jit_state.cycles_remaining = static_cast<s64>(cycle_count);
+        cycles_to_run = executed + cycle_count;
+        UpdateCycleCounterBase();
+    }
+
+    u64 GetCycleCounter() const {
+        return cycle_counter + static_cast<u64>(execute_cycle_budget - jit_state.cycles_remaining);
+    }
+
+    void SetCycleCounter(u64 value) {
+        cycle_counter = value - static_cast<u64>(execute_cycle_budget - jit_state.cycles_remaining);
+        UpdateCycleCounterBase();
+    }
+
+    /// Keeps the counter read by emitted code, cycle_counter_base - cycles_remaining, equal to GetCycleCounter.
+    void UpdateCycleCounterBase() {
+        jit_state.cycle_counter_base = cycle_counter + static_cast<u64>(execute_cycle_budget);
+    }
+
+    /// Counts the latency of the lookup of the block to execute, begun at lookup_start, and of entering Jit::Run if it is the first.
+    /// A miss is a lookup during which cache_misses was counted.
+    void RecordDispatchLatency(u64 lookup_start, u64 misses_before) {
+        const u64 now = ReadTimestampCounter();
+        RecordLatency(cache->cache_misses != misses_before ? dispatch_miss_latency : dispatch_hit_latency, now - lookup_start);
+        if (run_entry_pending) {
+            run_entry_pending = false;
+            RecordLatency(run_entry_latency, now - run_start);
+        }
+    }
 
     size_t Execute(size_t cycle_count) {
+        const bool measure_latency = callbacks.measure_latency;
+        const u64 lookup_start = measure_latency ? ReadTimestampCounter() : 0;
+
         u32 pc = jit_state.Reg[15];
+        IR::LocationDescriptor descriptor{pc, Arm::PSR{jit_state.Cpsr}, Arm::FPSCR{jit_state.FPSCR_mode}, jit_state.address_space};
+
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        const u64 misses_before = cache->cache_misses;
+
+        if (cache->IsSampledTiering()) {
+            ProcessSamples(lock);
+        }
+
+        bool trace_starts = false;
+        if (cache->IsTracingEnabled()) {
+            trace_starts = cache->RecordTrace(lock, descriptor, trace);
+            if (!trace.empty()) {
+                // Blocks finish with no cycles left, so each returns to here to be recorded.
+                cycle_count = 1;
+            }
+        }
+
+        // Set before any callback can be called, so that the cycle accounting is valid within them.
+        execute_cycle_budget = static_cast<s64>(cycle_count);
+        jit_state.cycles_remaining = execute_cycle_budget;
+        UpdateCycleCounterBase();
+
+        CodePtr code_ptr;
+        if (trace_starts) {
+            code_ptr = cache->emitter.GetBasicBlock(descriptor)->code_ptr;
+        } else if (cache->background_translator) {
+            cache->PublishTranslatedBlocks(lock);
+
+            auto block = cache->emitter.GetBasicBlock(descriptor);
+            if (!block && cache->HasBreakpoint(pc)) {
+                // InterpreterFallback would not stop at the breakpoint.
+                block = cache->GetBasicBlock(lock, descriptor);
+            }
+            if (!block) {
+                cache->cache_misses++;
+                cache->background_translator->Enqueue(descriptor, cache->IsTieringDisabled());
+                if (measure_latency)
+                    RecordDispatchLatency(lookup_start, misses_before);
+                lock.unlock();
+                // Make progress while the block is being translated.
+                jit_state.interpreter_fallback_count++;
+                callbacks.InterpreterFallback(pc, jit_interface, callbacks.user_arg);
+                return 1;
+            }
+            cache->cache_hits++;
+            if (cache->HasFailedGuard(*block)) {
+                // Retranslated here, as a background translation does not replace a block that is already hot.
+                block = cache->GetBasicBlock(lock, descriptor);
+            } else if (cache->IsHot(*block)) {
+                // Keep running the cold translation until the hot one is ready.
+                cache->ChooseRegisterSpecialization(*block);
+                cache->background_translator->Enqueue(descriptor, true);
+            }
+            code_ptr = block->code_ptr;
+        } else if (auto program = cache->GetInterpretedBlock(descriptor)) {
+            if (measure_latency)
+                RecordDispatchLatency(lookup_start, misses_before);
+            lock.unlock();
+            blocks_interpreted++;
+            const size_t cycles = cache->interpreter.Run(*program, jit_state);
+            if (HasWrittenCode()) {
+                lock.lock();
+                InvalidateWrittenCode(lock);
+            }
+            // A skipped spin loop or a callback may have used up the budget.
+            return std::max(cycles, static_cast<size_t>(execute_cycle_budget - jit_state.cycles_remaining));
+        } else {
+            code_ptr = cache->GetBasicBlock(lock, descriptor).code_ptr;
+        }
+
+        if (measure_latency)
+            RecordDispatchLatency(lookup_start, misses_before);
+        RunCode(lock, code_ptr, cycle_count);
+
+        // Not the value returned by RunCode, as callbacks may have changed the budget.
+        return static_cast<size_t>(execute_cycle_budget - jit_state.cycles_remaining);
+    }
+
+    /// Most instructions a step block runs (see CodeCache::StepBlock). Bounds are powers of two up to this,
+    /// so that few step blocks start at each location.
+    static constexpr size_t MaxStepBlockInstructions = 32;
+
+    /// Runs at most instruction_count instructions for Jit::RunInstructions, in one step block, and returns
+    /// the number run. Each counts for one cycle.
+    size_t ExecuteInstructions(size_t instruction_count) {
+        const u32 pc = jit_state.Reg[15];
+        const IR::LocationDescriptor descriptor{pc, Arm::PSR{jit_state.Cpsr}, Arm::FPSCR{jit_state.FPSCR_mode}, jit_state.address_space};
+
+        size_t max_instructions = MaxStepBlockInstructions;
+        while (max_instructions > instruction_count)
+            max_instructions /= 2;
+
+        std::unique_lock<std::mutex> lock{cache->mutex};
+
+        execute_cycle_budget = static_cast<s64>(max_instructions);
+        jit_state.cycles_remaining = execute_cycle_budget;
+        UpdateCycleCounterBase();
+
+        const CodePtr code_ptr = cache->GetStepBlock(lock, descriptor, max_instructions);
+        RunCode(lock, code_ptr, max_instructions);
+
+        return static_cast<size_t>(execute_cycle_budget - jit_state.cycles_remaining);
+    }
+
+    /// Runs the emitted code at code_ptr, with `lock` held before and after, then deals with why execution stopped.
+    void RunCode(std::unique_lock<std::mutex>& lock, CodePtr code_ptr, size_t cycle_count) {
+        cache->EnterGuest(core);
+        lock.unlock();
+
+        cache->block_of_code.RunCode(&jit_state, code_ptr, cycle_count);
+        dispatcher_exits++;
+
+        if (jit_state.breakpoint_hit) {
+            // Stopped before the instruction at the breakpoint, which Run returns at as if halted by the user.
+            jit_state.breakpoint_hit = false;
+            breakpoint_stop_pc = jit_state.Reg[15];
+            jit_state.halt_requested = true;
+            halt_requested_by_user = true;
+        }
+
+        lock.lock();
+        if (cache->LeaveGuest(core) && !halt_requested_by_user && !interrupt_signalled) {
+            jit_state.halt_requested = false;
+        }
+        if (HasWrittenCode()) {
+            InvalidateWrittenCode(lock);
+        }
+    }
+
+    /**
+     * Runs the loop of Jit::Run and Jit::RunInstructions, calling `execute` until `count` cycles have been
+     * executed or execution is halted, and then applies the invalidations requested meanwhile.
+     */
+    size_t Run(size_t count, size_t (Impl::*execute)(size_t)) {
+        jit_state.halt_requested = false;
+        halt_requested_by_user = false;
+        // Checked after clearing halt_requested, as SignalInterrupt sets them in the opposite order.
+        if (interrupt_signalled)
+            jit_state.halt_requested = true;
+
+        // Starting where the previous Run stopped at a breakpoint executes the instruction there.
+        if (jit_state.Reg[15] == breakpoint_stop_pc)
+            jit_state.breakpoint_resume_pc = breakpoint_stop_pc;
+        breakpoint_stop_pc = 0xFFFFFFFF;
+
+        cycles_to_run = count;
+        cycles_executed = 0;
+        while (cycles_executed < cycles_to_run && !jit_state.halt_requested) {
+            const size_t executed = (this->*execute)(cycles_to_run - cycles_executed);
+            cycles_executed += executed;
+            cycle_counter += executed;
+            execute_cycle_budget = 0;
+            jit_state.cycles_remaining = 0;
+            jit_state.breakpoint_resume_pc = 0xFFFFFFFF;
+
+            // Halted to reload the memory base; execution continues unless it was also halted otherwise.
+            if (address_space_switched) {
+                address_space_switched = false;
+                if (!halt_requested_by_user && !interrupt_signalled)
+                    jit_state.halt_requested = false;
+            }
+        }
+
+        if (clear_cache_required) {
+            ClearCache();
+        } else {
+            if (!invalid_cache_ranges.empty())
+                InvalidateCacheRanges();
+            if (!invalid_address_spaces.empty())
+                InvalidateAddressSpaces();
+        }
+
+        interrupt_signalled = false;
+        return cycles_executed;
+    }
+
+    std::uint64_t ReadMemoryTrace(std::vector<MemoryAccessRecord>& records) {
+        records.clear();
+        if (!memory_trace)
+            return 0;
+
+        const u64 size = callbacks.memory_trace_size;
+        const auto load_count = [this] {
+            // Written by emitted code, possibly on another thread, after the record it counts.
+            const u64 count = *static_cast<const volatile u64*>(&jit_state.memory_trace_count);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return count;
+        };
+
+        const u64 end = load_count();
+        const u64 begin = std::max(memory_trace_read, end > size ? end - size : 0);
+        for (u64 i = begin; i < end; i++) {
+            records.push_back(memory_trace[i & (size - 1)]);
+        }
+
+        // Records may have been overwritten while they were copied, including the one being written now.
+        const u64 next = load_count();
+        const u64 first_intact = next + 1 > size ? next + 1 - size : 0;
+        const u64 overwritten = std::min<u64>(first_intact > begin ? first_intact - begin : 0, records.size());
+        records.erase(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(overwritten));
+
+        const u64 lost = begin + overwritten - memory_trace_read;
+        memory_trace_read = end;
+        return lost;
+    }
 
-        IR::LocationDescriptor descriptor{pc, Arm::PSR{jit_state.Cpsr}, Arm::FPSCR{jit_state.FPSCR_mode}};
+    /// Whether the guest has written to pages holding translated code (see UserCallbacks::detect_self_modifying_code).
+    bool HasWrittenCode() const {
+        return jit_state.code_write_first_page <= jit_state.code_write_last_page;
+    }
 
-        CodePtr code_ptr = GetBasicBlock(descriptor).code_ptr;
-        return block_of_code.RunCode(&jit_state, code_ptr, cycle_count);
+    /// Invalidates the code the guest has written to. Execution then continues unless it was also halted otherwise.
+    void InvalidateWrittenCode(std::unique_lock<std::mutex>& lock) {
+        cache->InvalidateWrittenCode(lock, jit_state);
+        if (!halt_requested_by_user && !interrupt_signalled) {
+            jit_state.halt_requested = false;
+        }
     }
 
     std::string Disassemble(const IR::LocationDescriptor& descriptor) {
-        auto block = GetBasicBlock(descriptor);
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        auto block = cache->GetBasicBlock(lock, descriptor);
+        lock.unlock();
+
         std::string result = fmt::format("address: {}\nsize: {} bytes\n", block.code_ptr, block.size);
 
 #ifdef DYNARMIC_USE_LLVM
@@ -90,29 +2066,141 @@ struct Jit::Impl {
         return result;
     }
 
+    JitStatistics GetStatistics() const {
+        JitStatistics statistics;
+        {
+            std::lock_guard<std::mutex> lock{cache->mutex};
+            statistics.bytes_emitted = cache->bytes_emitted;
+            statistics.emit_time_ns = cache->emit_time_ns;
+            statistics.cache_hits = cache->cache_hits;
+            statistics.cache_misses = cache->cache_misses;
+        }
+        statistics.blocks_translated = cache->blocks_translated;
+        statistics.translate_time_ns = cache->translate_time_ns;
+        statistics.optimize_time_ns = cache->optimize_time_ns;
+        statistics.ir_cache_hits = cache->ir_cache_hits;
+        statistics.dispatcher_exits = dispatcher_exits;
+        statistics.interpreter_fallbacks = jit_state.interpreter_fallback_count;
+        statistics.spin_loops_skipped = jit_state.spin_loops_skipped;
+        std::copy(jit_state.exit_counts.begin(), jit_state.exit_counts.end(), statistics.exits.begin());
+        statistics.blocks_interpreted = blocks_interpreted;
+
+        if (callbacks.measure_latency) {
+            const u64 elapsed_ns = NanosecondsSince(time_origin);
+            if (elapsed_ns != 0)
+                statistics.tsc_frequency = static_cast<u64>(static_cast<double>(ReadTimestampCounter() - tsc_origin) * 1e9 / static_cast<double>(elapsed_ns));
+            statistics.run_entry = run_entry_latency;
+            statistics.dispatch_hits = dispatch_hit_latency;
+            statistics.dispatch_misses = dispatch_miss_latency;
+            for (size_t kind = 0; kind < CallbackKindCount; kind++) {
+                const auto& counts = jit_state.callback_latency[kind];
+                std::copy(counts.begin(), counts.end(), statistics.callbacks[kind].counts.begin());
+            }
+        }
+
+        const auto append_pass_statistics = [&statistics](const char* pipeline, const Optimization::PassManager& passes) {
+            for (const auto& pass : passes.GetStatistics()) {
+                statistics.passes.push_back({fmt::format("{}.{}", pipeline, pass.name), pass.runs, pass.time_ns, pass.instructions_before, pass.instructions_after});
+            }
+        };
+        append_pass_statistics("cold", cache->cold_passes);
+        append_pass_statistics("hot", cache->hot_passes);
+        append_pass_statistics("step", cache->step_passes);
+        return statistics;
+    }
+
+    JitMemoryUsage GetMemoryUsage() const {
+        JitMemoryUsage usage;
+        {
+            std::lock_guard<std::mutex> lock{cache->mutex};
+            cache->GetMemoryUsage(usage);
+        }
+        usage.jit_state_bytes = sizeof(jit_state) + callbacks.memory_trace_size * sizeof(MemoryAccessRecord);
+        return usage;
+    }
+
+    void CompactCodeCache() {
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        cache->CompactCodeCache(lock);
+    }
+
+    boost::optional<u32> HostPcToGuestPc(CodePtr host_pc) const {
+        std::lock_guard<std::mutex> lock{cache->mutex};
+        return cache->emitter.HostPcToGuestPc(host_pc);
+    }
+
+    void SaveContext(JitContext::Impl& context) const {
+        context.state = jit_state;
+
+        std::lock_guard<std::mutex> lock{cache->mutex};
+        context.code_generation = cache->code_generation;
+    }
+
+    void LoadContext(const JitContext::Impl& context) {
+        // Keep the fields that belong to this Jit rather than to the guest.
+        const u64 interpreter_fallback_count = jit_state.interpreter_fallback_count;
+        const u64 spin_loops_skipped = jit_state.spin_loops_skipped;
+        const auto exit_counts = jit_state.exit_counts;
+        const auto callback_latency = jit_state.callback_latency;
+        const u64 memory_trace_count = jit_state.memory_trace_count;
+        jit_state = context.state;
+        jit_state.interpreter_fallback_count = interpreter_fallback_count;
+        jit_state.spin_loops_skipped = spin_loops_skipped;
+        jit_state.exit_counts = exit_counts;
+        jit_state.callback_latency = callback_latency;
+        jit_state.jit_interface = jit_interface;
+        jit_state.user_arg = callbacks.user_arg;
+        jit_state.code_pages = cache->emitter.GetCodePages();
+        jit_state.watched_pages = cache->emitter.GetWatchedPages();
+        jit_state.breakpoint_resume_pc = 0xFFFFFFFF;
+        jit_state.breakpoint_hit = false;
+        breakpoint_stop_pc = 0xFFFFFFFF;
+        jit_state.memory_trace = memory_trace.get();
+        jit_state.memory_trace_mask = static_cast<u32>(callbacks.memory_trace_size - 1);
+        jit_state.memory_trace_count = memory_trace_count;
+        jit_state.call_profiler = call_profiler.get();
+        if (!jit_state.memory_base) {
+            // Never run: Nothing has set its address space.
+            jit_state.memory_base = DefaultMemoryBase();
+        }
+        jit_state.guest_MXCSR_active = false;
+        jit_state.halt_requested = false;
+        jit_state.cycles_remaining = 0;
+
+        std::lock_guard<std::mutex> lock{cache->mutex};
+        if (context.code_generation != cache->code_generation) {
+            jit_state.ResetRSB();
+        }
+    }
+
     void ClearCache() {
-        block_of_code.ClearCache();
-        emitter.ClearCache();
-        jit_state.ResetRSB();
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        cache->ClearCache(lock);
         clear_cache_required = false;
+        invalid_cache_ranges.clear();
+        invalid_address_spaces.clear();
     }
 
-private:
-    EmitX64::BlockDescriptor GetBasicBlock(IR::LocationDescriptor descriptor) {
-        auto block = emitter.GetBasicBlock(descriptor);
-        if (block)
-            return *block;
+    void InvalidateCacheRanges() {
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        cache->InvalidateCacheRanges(lock, invalid_cache_ranges);
+        invalid_cache_ranges.clear();
+    }
 
-        IR::Block ir_block = Arm::Translate(descriptor, callbacks.memory.ReadCode);
-        Optimization::GetSetElimination(ir_block);
-        Optimization::ConstantPropagation(ir_block, callbacks.memory);
-        Optimization::DeadCodeElimination(ir_block);
-        Optimization::VerificationPass(ir_block);
-        return emitter.Emit(ir_block);
+    void InvalidateAddressSpaces() {
+        std::unique_lock<std::mutex> lock{cache->mutex};
+        for (size_t address_space : invalid_address_spaces) {
+            cache->InvalidateAddressSpace(lock, address_space);
+        }
+        invalid_address_spaces.clear();
     }
 };
 
-Jit::Jit(UserCallbacks callbacks) : impl(std::make_unique<Impl>(this, callbacks)) {}
+Jit::Jit(UserCallbacks callbacks) : impl(std::make_unique<Impl>(this, callbacks, std::make_shared<CodeCache>(callbacks))) {}
+
+Jit::Jit(UserCallbacks callbacks, Jit& other) : impl(std::make_unique<Impl>(this, callbacks, other.impl->cache)) {}
+
+Jit::Jit(UserCallbacks callbacks, JitPool& pool) : impl(std::make_unique<Impl>(this, callbacks, pool.impl->Acquire())) {}
 
 Jit::~Jit() {}
 
@@ -121,23 +2209,53 @@ size_t Jit::Run(size_t cycle_count) {
     is_executing = true;
     SCOPE_EXIT({ this->is_executing = false; });
 
-    impl->jit_state.halt_requested = false;
-
-    size_t cycles_executed = 0;
-    while (cycles_executed < cycle_count && !impl->jit_state.halt_requested) {
-        cycles_executed += impl->Execute(cycle_count - cycles_executed);
+    if (impl->callbacks.measure_latency) {
+        impl->run_start = ReadTimestampCounter();
+        impl->run_entry_pending = true;
     }
 
-    if (impl->clear_cache_required) {
-        impl->ClearCache();
-    }
+    return impl->Run(cycle_count, &Impl::Execute);
+}
+
+std::size_t Jit::RunInstructions(std::size_t instruction_count) {
+    ASSERT(!is_executing);
+    is_executing = true;
+    SCOPE_EXIT({ this->is_executing = false; });
+
+    return impl->Run(instruction_count, &Impl::ExecuteInstructions);
+}
+
+bool Jit::Step() {
+    return RunInstructions(1) == 1;
+}
+
+std::size_t Jit::GetCyclesExecuted() const {
+    ASSERT(is_executing);
+    return impl->GetCyclesExecuted();
+}
+
+std::size_t Jit::GetCyclesRemaining() const {
+    ASSERT(is_executing);
+    return static_cast<size_t>(std::max<s64>(impl->jit_state.cycles_remaining, 0));
+}
+
+void Jit::SetCyclesRemaining(std::size_t cycle_count) {
+    ASSERT(is_executing);
+    impl->SetCyclesRemaining(cycle_count);
+}
+
+std::uint64_t Jit::GetCycleCounter() const {
+    return impl->GetCycleCounter();
+}
 
-    return cycles_executed;
+void Jit::SetCycleCounter(std::uint64_t value) {
+    impl->SetCycleCounter(value);
 }
 
 void Jit::ClearCache() {
     if (is_executing) {
         impl->jit_state.halt_requested = true;
+        impl->halt_requested_by_user = true;
         impl->clear_cache_required = true;
         return;
     }
@@ -145,18 +2263,185 @@ void Jit::ClearCache() {
     impl->ClearCache();
 }
 
+void Jit::InvalidateCacheRange(std::uint32_t start_address, std::size_t length) {
+    impl->invalid_cache_ranges.emplace_back(start_address, length);
+
+    if (is_executing) {
+        impl->jit_state.halt_requested = true;
+        impl->halt_requested_by_user = true;
+        return;
+    }
+
+    impl->InvalidateCacheRanges();
+}
+
+void Jit::SetAddressSpace(std::size_t address_space, void* memory_base) {
+    impl->SetAddressSpace(address_space, memory_base);
+
+    if (is_executing) {
+        impl->jit_state.halt_requested = true;
+        impl->address_space_switched = true;
+    }
+}
+
+std::size_t Jit::GetAddressSpace() const {
+    return impl->jit_state.address_space;
+}
+
+void Jit::InvalidateAddressSpace(std::size_t address_space) {
+    ASSERT_MSG(address_space < impl->callbacks.address_space_count, "address_space must be less than address_space_count");
+    impl->invalid_address_spaces.emplace_back(address_space);
+
+    if (is_executing) {
+        impl->jit_state.halt_requested = true;
+        impl->halt_requested_by_user = true;
+        return;
+    }
+
+    impl->InvalidateAddressSpaces();
+}
+
 void Jit::Reset() {
     ASSERT(!is_executing);
+    const u64 interpreter_fallback_count = impl->jit_state.interpreter_fallback_count;
+    const u64 spin_loops_skipped = impl->jit_state.spin_loops_skipped;
+    const auto exit_counts = impl->jit_state.exit_counts;
+    const auto callback_latency = impl->jit_state.callback_latency;
+    const u64 memory_trace_count = impl->jit_state.memory_trace_count;
     impl->jit_state = {};
+    impl->jit_state.interpreter_fallback_count = interpreter_fallback_count;
+    impl->jit_state.spin_loops_skipped = spin_loops_skipped;
+    impl->jit_state.exit_counts = exit_counts;
+    impl->jit_state.callback_latency = callback_latency;
+    impl->jit_state.jit_interface = this;
+    impl->jit_state.user_arg = impl->callbacks.user_arg;
+    impl->jit_state.code_pages = impl->cache->emitter.GetCodePages();
+    impl->jit_state.watched_pages = impl->cache->emitter.GetWatchedPages();
+    impl->breakpoint_stop_pc = 0xFFFFFFFF;
+    impl->jit_state.memory_trace = impl->memory_trace.get();
+    impl->jit_state.memory_trace_mask = static_cast<u32>(impl->callbacks.memory_trace_size - 1);
+    impl->jit_state.memory_trace_count = memory_trace_count;
+    impl->jit_state.call_profiler = impl->call_profiler.get();
+    impl->jit_state.memory_base = impl->DefaultMemoryBase();
+}
+
+JitContext Jit::SaveContext() const {
+    JitContext context;
+    SaveContext(context);
+    return context;
+}
+
+void Jit::SaveContext(JitContext& context) const {
+    impl->SaveContext(*context.impl);
+}
+
+void Jit::LoadContext(const JitContext& context) {
+    ASSERT(!is_executing);
+    impl->LoadContext(*context.impl);
+}
+
+void Jit::SetHostFunction(std::uint32_t address, HostFunction function) {
+    ASSERT(!is_executing);
+    std::unique_lock<std::mutex> lock{impl->cache->mutex};
+    impl->cache->SetHostFunction(lock, address, function);
+}
+
+void Jit::SetBreakpoint(std::uint32_t address, bool enabled) {
+    ASSERT(!is_executing);
+    std::unique_lock<std::mutex> lock{impl->cache->mutex};
+    impl->cache->SetBreakpoint(lock, address, enabled);
+}
+
+bool Jit::SaveIRCache(const std::string& path) const {
+    std::vector<u8> data;
+    impl->cache->WriteRetainedBlocks(data);
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool Jit::DumpCodeCache(const std::string& path) {
+    ASSERT(!is_executing);
+    std::string dump;
+    {
+        std::unique_lock<std::mutex> lock{impl->cache->mutex};
+        impl->cache->DumpBlocks(lock, dump);
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    const bool written = std::fwrite(dump.data(), 1, dump.size(), file) == dump.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool Jit::LoadIRCache(const std::string& path) {
+    ASSERT(!is_executing);
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    SCOPE_EXIT({ std::fclose(file); });
+
+    std::vector<u8> data;
+    u8 buffer[64 * 1024];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) != 0)
+        data.insert(data.end(), buffer, buffer + read);
+    if (std::ferror(file))
+        return false;
+
+    return impl->cache->ReadRetainedBlocks(data);
+}
+
+void Jit::Precompile(std::uint32_t entry_point, std::uint32_t start_address, std::size_t length) {
+    ASSERT(!is_executing);
+    const IR::LocationDescriptor entry{entry_point, Arm::PSR{impl->jit_state.Cpsr}, Arm::FPSCR{impl->jit_state.FPSCR_mode}, impl->jit_state.address_space};
+    std::unique_lock<std::mutex> lock{impl->cache->mutex};
+    impl->cache->TranslateAhead(lock, entry, {start_address, u64(start_address) + length, std::numeric_limits<size_t>::max()});
+}
+
+std::vector<HotBlockRecord> Jit::GetHotBlocks() const {
+    ASSERT(!is_executing);
+    std::lock_guard<std::mutex> lock{impl->cache->mutex};
+    return impl->cache->GetHotBlockRecords();
+}
+
+void Jit::PrecompileHotBlocks(const std::vector<HotBlockRecord>& blocks) {
+    ASSERT(!is_executing);
+    std::unique_lock<std::mutex> lock{impl->cache->mutex};
+    impl->cache->PrecompileHotBlocks(lock, blocks);
+}
+
+void Jit::SetWatchpoint(std::uint32_t start_address, std::size_t length, WatchpointKind kind) {
+    if (length == 0)
+        return;
+
+    const u64 last_address = std::min<u64>(u64(start_address) + length - 1, 0xFFFFFFFF);
+    std::lock_guard<std::mutex> lock{impl->cache->mutex};
+    impl->cache->emitter.SetWatchedPages(start_address >> UserCallbacks::PAGE_BITS, static_cast<u32>(last_address >> UserCallbacks::PAGE_BITS), kind);
+}
+
+void Jit::SignalInterrupt() {
+    // Set in this order so that a Run starting concurrently either keeps halt_requested or sets it itself.
+    impl->interrupt_signalled = true;
+    impl->jit_state.halt_requested = true;
 }
 
 void Jit::HaltExecution() {
     ASSERT(is_executing);
     impl->jit_state.halt_requested = true;
+    impl->halt_requested_by_user = true;
 
     // TODO: Uh do other stuff to JitState pls.
 }
 
+void Jit::ClearExclusiveState() {
+    impl->jit_state.exclusive_state = 0;
+}
+
 std::array<u32, 16>& Jit::Regs() {
     return impl->jit_state.Reg;
 }
@@ -180,6 +2465,36 @@ u32 Jit::Cpsr() const {
     return impl->jit_state.Cpsr;
 }
 
+u32& Jit::Spsr() {
+    return impl->jit_state.Spsr;
+}
+
+u32 Jit::Spsr() const {
+    return impl->jit_state.Spsr;
+}
+
+void Jit::SetMode(u32 mode) {
+    ASSERT(!is_executing);
+    JitState& jit_state = impl->jit_state;
+    jit_state.SetCpsrAndSwitchMode((jit_state.Cpsr & ~u32(0x1F)) | (mode & 0x1F));
+}
+
+void Jit::TakeException(u32 mode, u32 vector_address, u32 return_address) {
+    ASSERT(!is_executing);
+    JitState& jit_state = impl->jit_state;
+    const u32 old_cpsr = jit_state.Cpsr;
+
+    // Clear IT<7:0>, J, T and M, then disable IRQs (and FIQs when entering FIQ mode). E is left as it was.
+    u32 new_cpsr = (old_cpsr & ~u32(0x0700FC3F)) | (mode & 0x1F) | 0x80;
+    if ((new_cpsr & 0x1F) == static_cast<u32>(Arm::PSR::Mode::FIQ))
+        new_cpsr |= 0x40;
+
+    jit_state.SetCpsrAndSwitchMode(new_cpsr);
+    jit_state.Spsr = old_cpsr;
+    jit_state.Reg[14] = return_address;
+    jit_state.Reg[15] = vector_address;
+}
+
 u32 Jit::Fpscr() const {
     return impl->jit_state.Fpscr();
 }
@@ -189,7 +2504,66 @@ void Jit::SetFpscr(u32 value) const {
 }
 
 std::string Jit::Disassemble(const IR::LocationDescriptor& descriptor) {
+    ASSERT(!is_executing);
     return impl->Disassemble(descriptor);
 }
 
+JitStatistics Jit::GetStatistics() const {
+    return impl->GetStatistics();
+}
+
+JitMemoryUsage Jit::GetMemoryUsage() const {
+    return impl->GetMemoryUsage();
+}
+
+void Jit::CompactCodeCache() {
+    ASSERT(!is_executing);
+    impl->CompactCodeCache();
+}
+
+std::uint64_t Jit::ReadMemoryTrace(std::vector<MemoryAccessRecord>& records) {
+    return impl->ReadMemoryTrace(records);
+}
+
+std::vector<GuestFunctionProfile> Jit::GetCallProfile() const {
+    if (!impl->call_profiler)
+        return {};
+    return impl->call_profiler->GetProfile();
+}
+
+void Jit::ResetCallProfile() {
+    if (impl->call_profiler) {
+        impl->call_profiler->Reset();
+    }
+}
+
+void Jit::RecordSample(const void* host_pc) {
+    impl->RecordSample(host_pc);
+}
+
+bool Jit::HostPcToGuestPc(const void* host_pc, u32& guest_pc) const {
+    const auto result = impl->HostPcToGuestPc(host_pc);
+    if (!result)
+        return false;
+    guest_pc = *result;
+    return true;
+}
+
+size_t RunLockstep(const std::vector<Jit*>& cores, size_t cycle_count, size_t slice_cycles) {
+    ASSERT(slice_cycles > 0);
+    size_t cycles_run = 0;
+    while (cycles_run < cycle_count) {
+        const size_t slice = std::min(slice_cycles, cycle_count - cycles_run);
+        bool stopped_early = false;
+        for (Jit* core : cores) {
+            if (core->Run(slice) < slice)
+                stopped_early = true;
+        }
+        cycles_run += slice;
+        if (stopped_early)
+            break;
+    }
+    return cycles_run;
+}
+
 } // namespace Dynarmic
@@ -0,0 +1,64 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include "common/assert.h"
+#include "dynarmic/config.h"
+
+namespace Dynarmic {
+
+JitConfig::JitConfig(OptimizationLevel level) {
+    // Settings that no preset changes keep the defaults of UserCallbacks.
+    const UserCallbacks defaults{};
+    max_block_instructions = defaults.max_block_instructions;
+    superblock_instruction_budget = defaults.superblock_instruction_budget;
+    trace_instruction_budget = defaults.trace_instruction_budget;
+    speculative_translation_depth = defaults.speculative_translation_depth;
+    interpreter_threshold = defaults.interpreter_threshold;
+    hot_block_threshold = defaults.hot_block_threshold;
+    hot_layout_interval = defaults.hot_layout_interval;
+    accurate_nan = defaults.accurate_nan;
+    code_cache_size = defaults.code_cache_size;
+    ir_cache_capacity = defaults.ir_cache_capacity;
+    rsb_size = defaults.rsb_size;
+
+    switch (level) {
+    case OptimizationLevel::FastCompile:
+        max_block_instructions = 32;
+        interpreter_threshold = 16;
+        hot_block_threshold = 4096;
+        break;
+    case OptimizationLevel::Balanced:
+        superblock_instruction_budget = 64;
+        hot_block_threshold = 256;
+        break;
+    case OptimizationLevel::MaxThroughput:
+        superblock_instruction_budget = 256;
+        speculative_translation_depth = 2;
+        // Blocks evicted from the cache are rebuilt without being optimized again.
+        ir_cache_capacity = 4096;
+        break;
+    default:
+        ASSERT_MSG(false, "Unknown optimization level %zu", static_cast<size_t>(level));
+        break;
+    }
+}
+
+UserCallbacks JitConfig::ApplyTo(UserCallbacks callbacks) const {
+    callbacks.max_block_instructions = max_block_instructions;
+    callbacks.superblock_instruction_budget = superblock_instruction_budget;
+    callbacks.trace_instruction_budget = trace_instruction_budget;
+    callbacks.speculative_translation_depth = speculative_translation_depth;
+    callbacks.interpreter_threshold = interpreter_threshold;
+    callbacks.hot_block_threshold = hot_block_threshold;
+    callbacks.hot_layout_interval = hot_layout_interval;
+    callbacks.accurate_nan = accurate_nan;
+    callbacks.code_cache_size = code_cache_size;
+    callbacks.ir_cache_capacity = ir_cache_capacity;
+    callbacks.rsb_size = rsb_size;
+    return callbacks;
+}
+
+} // namespace Dynarmic
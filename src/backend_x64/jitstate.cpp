@@ -4,11 +4,17 @@
  * General Public License version 2 or any later version.
  */
 
+#include <algorithm>
+#include <atomic>
+
 #include "backend_x64/block_of_code.h"
+#include "backend_x64/call_profiler.h"
 #include "backend_x64/jitstate.h"
 #include "common/assert.h"
 #include "common/bit_util.h"
 #include "common/common_types.h"
+#include "frontend/arm/PSR.h"
+#include "dynarmic/callbacks.h"
 #include "frontend/ir/location_descriptor.h"
 
 namespace Dynarmic {
@@ -19,6 +25,70 @@ void JitState::ResetRSB() {
     rsb_codeptrs.fill(0);
 }
 
+void JitState::RecordCodeWrite(u32 vaddr, size_t size) {
+    if (!code_pages)
+        return;
+    // The pages of the first and of the last byte written, which are the same unless the write crosses a page.
+    for (const u32 page : {vaddr >> 12, static_cast<u32>(vaddr + size - 1) >> 12}) {
+        if (!code_pages[page])
+            continue;
+        code_write_first_page = std::min(code_write_first_page, page);
+        code_write_last_page = std::max(code_write_last_page, page);
+        halt_requested = true;
+    }
+}
+
+void JitState::TraceMemoryAccess(u32 pc, u32 vaddr, u8 size, bool is_write) {
+    memory_trace[memory_trace_count & memory_trace_mask] = {pc, vaddr, size, is_write};
+    // Readers on other threads must see the record before the count that includes it.
+    std::atomic_signal_fence(std::memory_order_release);
+    memory_trace_count++;
+}
+
+void JitState::ProfileCall(u32 function, u32 return_address, u32 cycles_before) {
+    call_profiler->Call(function, return_address, cycle_counter_base - static_cast<u64>(cycles_remaining) + cycles_before);
+}
+
+void JitState::ProfileReturn(u32 target, u32 cycles_before) {
+    call_profiler->Return(target, cycle_counter_base - static_cast<u64>(cycles_remaining) + cycles_before);
+}
+
+size_t JitState::BankIndex(u32 mode) {
+    switch (static_cast<Arm::PSR::Mode>(mode & 0x1F)) {
+    case Arm::PSR::Mode::FIQ:
+        return 1;
+    case Arm::PSR::Mode::IRQ:
+        return 2;
+    case Arm::PSR::Mode::Supervisor:
+        return 3;
+    case Arm::PSR::Mode::Abort:
+        return 4;
+    case Arm::PSR::Mode::Undefined:
+        return 5;
+    default:
+        // User, System, and the Monitor and Hypervisor modes of extensions that are not emulated.
+        return 0;
+    }
+}
+
+void JitState::SetCpsrAndSwitchMode(u32 new_cpsr) {
+    constexpr size_t fiq_bank = 1;
+    const size_t old_bank = BankIndex(Cpsr);
+    const size_t new_bank = BankIndex(new_cpsr);
+    Cpsr = new_cpsr;
+    if (old_bank == new_bank)
+        return;
+
+    BankedR13R14[old_bank] = {Reg[13], Reg[14]};
+    BankedSpsr[old_bank] = Spsr;
+    if ((old_bank == fiq_bank) != (new_bank == fiq_bank)) {
+        std::swap_ranges(Reg.begin() + 8, Reg.begin() + 13, BankedR8R12.begin());
+    }
+    Reg[13] = BankedR13R14[new_bank][0];
+    Reg[14] = BankedR13R14[new_bank][1];
+    Spsr = BankedSpsr[new_bank];
+}
+
 /**
  * Comparing MXCSR and FPSCR
  * =========================
@@ -119,7 +189,7 @@ void JitState::SetFpscr(u32 FPSCR) {
 
     if (Common::Bit<24>(FPSCR)) {
         // VFP Flush to Zero
-        //guest_MXCSR |= (1 << 15); // SSE Flush to Zero
+        guest_MXCSR |= (1 << 15); // SSE Flush to Zero
         guest_MXCSR |= (1 << 6);  // SSE Denormals are Zero
     }
 }
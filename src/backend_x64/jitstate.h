@@ -7,13 +7,20 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 
 #include "common/common_types.h"
+#include "dynarmic/callbacks.h"
 
 namespace Dynarmic {
+
+class Jit;
+struct MemoryAccessRecord;
+
 namespace BackendX64 {
 
 class BlockOfCode;
+class CallProfiler;
 
 constexpr size_t SpillCount = 64;
 
@@ -25,31 +32,21 @@ constexpr size_t SpillCount = 64;
 struct JitState {
     JitState() { ResetRSB(); }
 
+    // The fields most blocks use come first, so that emitted code reaches them from r15 with an 8-bit
+    // displacement. Those of every link (cycle and halt checks, RSB pushes) share the first cache line.
+    s64 cycles_remaining = 0;
+    bool halt_requested = false;
+    bool guest_MXCSR_active = false; ///< Whether guest_MXCSR is currently loaded into MXCSR.
+    u32 rsb_ptr = 0;
     u32 Cpsr = 0;
     std::array<u32, 16> Reg{}; // Current register file.
-    // TODO: Mode-specific register sets unimplemented.
-
-    alignas(u64) std::array<u32, 64> ExtReg{}; // Extension registers.
-
-    std::array<u64, SpillCount> Spill{}; // Spill.
-
-    // For internal use (See: BlockOfCode::RunCode)
     u32 guest_MXCSR = 0x00001f80;
-    u32 save_host_MXCSR = 0;
-    s64 cycles_remaining = 0;
-    bool halt_requested = false;
 
     // Exclusive state
     static constexpr u32 RESERVATION_GRANULE_MASK = 0xFFFFFFF8;
     u32 exclusive_state = 0;
     u32 exclusive_address = 0;
 
-    static constexpr size_t RSBSize = 8; // MUST be a power of 2.
-    u32 rsb_ptr = 0;
-    std::array<u64, RSBSize> rsb_location_descriptors;
-    std::array<u64, RSBSize> rsb_codeptrs;
-    void ResetRSB();
-
     u32 FPSCR_IDC = 0;
     u32 FPSCR_UFC = 0;
     u32 FPSCR_mode = 0;
@@ -57,8 +54,80 @@ struct JitState {
     u32 old_FPSCR = 0;
     u32 Fpscr() const;
     void SetFpscr(u32 FPSCR);
+    u32 address_space_hash = 0; ///< Upper half of IR::LocationDescriptor::AddressSpaceHash(address_space)
+
+    u32 Spsr = 0; ///< SPSR of the current mode. User and System modes have none, so it is unused in them.
+
+    // Banked registers of the modes that are not current; those of the current mode are in Reg and Spsr.
+    // Indexed by BankIndex. Modes that are not listed there share the User mode bank.
+    static constexpr size_t NumBanks = 6;
+    std::array<std::array<u32, 2>, NumBanks> BankedR13R14{};
+    std::array<u32, NumBanks> BankedSpsr{};
+    std::array<u32, 5> BankedR8R12{}; ///< R8-R12 of FIQ mode when not in FIQ mode, and of other modes when in it.
+    static size_t BankIndex(u32 mode);
+    /// Writes the whole CPSR, including the mode bits, swapping banked registers if the mode changes.
+    void SetCpsrAndSwitchMode(u32 new_cpsr);
+
+    alignas(u64) std::array<u32, 64> ExtReg{}; // Extension registers.
+
+    std::array<std::array<u64, 2>, SpillCount> Spill{}; // Spill. Each slot is large enough to hold a vector.
+
+    // For internal use (See: BlockOfCode::RunCode)
+    u32 save_host_MXCSR = 0;
+    u64 interpreter_fallback_count = 0; ///< Counted by emitted code for JitStatistics::interpreter_fallbacks.
+    u64 spin_loops_skipped = 0;         ///< Counted by emitted code for JitStatistics::spin_loops_skipped.
+    std::array<u64, ExitReasonCount> exit_counts{}; ///< Counted by emitted code for JitStatistics::exits.
+    u64 cycle_counter_base = 0; ///< The guest cycle counter is this minus cycles_remaining (see Jit::GetCycleCounter).
+
+    // Passed to callbacks from emitted code, which may be shared between several Jits.
+    Jit* jit_interface = nullptr;
+    void* user_arg = nullptr;
+
+    u64 exclusive_value = 0; ///< Value read by the last exclusive read, used by the global exclusive monitor.
+
+    // Address spaces (see Jit::SetAddressSpace)
+    u32 address_space = 0;
+    void* memory_base = nullptr; ///< Loaded into r14 on entry: the fastmem_pointer, page_table or page_directory of address_space
+
+    // Self-modifying code detection (see UserCallbacks::detect_self_modifying_code)
+    const u8* code_pages = nullptr;         ///< Nonzero for each guest page that may hold translated code (see EmitX64::GetCodePages)
+    u32 code_write_first_page = 0xFFFFFFFF; ///< Guest pages holding code that have been written since the code was last
+    u32 code_write_last_page = 0;           ///< invalidated, from first to last. Empty if first > last.
+    /// Records a guest write of `size` bytes at vaddr if a page it touches may hold translated code, and halts
+    /// execution so that the code is invalidated.
+    void RecordCodeWrite(u32 vaddr, size_t size);
+
+    // Memory access tracing (see UserCallbacks::memory_trace_size)
+    MemoryAccessRecord* memory_trace = nullptr; ///< Ring buffer of memory_trace_mask + 1 records
+    u32 memory_trace_mask = 0;
+    u64 memory_trace_count = 0;                 ///< Records written so far; the next one goes at index (count & mask)
+    void TraceMemoryAccess(u32 pc, u32 vaddr, u8 size, bool is_write);
+
+    // Guest call profiling (see UserCallbacks::profile_guest_calls)
+    CallProfiler* call_profiler = nullptr;
+    /// Passes a call or return to call_profiler, timestamped with the cycle counter plus cycles_before.
+    void ProfileCall(u32 function, u32 return_address, u32 cycles_before);
+    void ProfileReturn(u32 target, u32 cycles_before);
+
+    // Latency measurement (see UserCallbacks::measure_latency)
+    u64 callback_start = 0; ///< Time-stamp counter when the callback being measured was called
+    /// Counted by emitted code for JitStatistics::callbacks, indexed by CallbackKind and then by bucket.
+    std::array<std::array<u64, LatencyBucketCount>, CallbackKindCount> callback_latency{};
+
+    // Debugging (see Jit::SetWatchpoint and Jit::SetBreakpoint)
+    const u8* watched_pages = nullptr;     ///< The WatchpointKind of each guest page (see EmitX64::GetWatchedPages)
+    u32 breakpoint_resume_pc = 0xFFFFFFFF; ///< The breakpoint at this PC is passed once, to resume after stopping at it
+    bool breakpoint_hit = false;           ///< Set by emitted code when it stops at a breakpoint
+
+    static constexpr size_t MaxRSBSize = 64; // Upper bound of UserCallbacks::rsb_size.
+    std::array<u64, MaxRSBSize> rsb_location_descriptors;
+    std::array<u64, MaxRSBSize> rsb_codeptrs;
+    void ResetRSB();
 };
 
+static_assert(offsetof(JitState, address_space_hash) + sizeof(u32) <= 128, "Frequently used JitState fields must be within disp8 range of r15");
+static_assert(offsetof(JitState, Cpsr) + sizeof(u32) <= 64, "The JitState fields used by every link must share the first cache line");
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -0,0 +1,22 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+/**
+ * Records that the size bytes of host code at start are called name, in the map file that perf reads
+ * symbols for JITted code from (/tmp/perf-<pid>.map). Does nothing on hosts other than Linux.
+ */
+void PerfMapRegister(const void* start, std::size_t size, const std::string& name);
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -0,0 +1,17 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include "backend_x64/perf_map.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+void PerfMapRegister(const void*, std::size_t, const std::string&) {
+    // Do nothing
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -0,0 +1,43 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include "backend_x64/perf_map.h"
+
+namespace Dynarmic {
+namespace BackendX64 {
+
+namespace {
+
+/// The map file is per process and shared by all Jits, so it is opened once and written to under a lock.
+std::mutex perf_map_mutex;
+std::FILE* perf_map_file = nullptr;
+
+} // anonymous namespace
+
+void PerfMapRegister(const void* start, std::size_t size, const std::string& name) {
+    std::lock_guard<std::mutex> lock{perf_map_mutex};
+
+    if (!perf_map_file) {
+        const std::string filename = fmt::format("/tmp/perf-{}.map", getpid());
+        perf_map_file = std::fopen(filename.c_str(), "w");
+        if (!perf_map_file)
+            return;
+        std::setvbuf(perf_map_file, nullptr, _IOLBF, 0);
+    }
+
+    const std::string line = fmt::format("{:x} {:x} {}\n", reinterpret_cast<std::uintptr_t>(start), size, name);
+    std::fputs(line.c_str(), perf_map_file);
+}
+
+} // namespace BackendX64
+} // namespace Dynarmic
@@ -5,6 +5,8 @@
  */
 
 #include <algorithm>
+#include <iterator>
+#include <limits>
 
 #include <xbyak.h>
 
@@ -33,7 +35,7 @@ static u64 ImmediateToU64(const IR::Value& imm) {
 
 static Xbyak::Reg HostLocToX64(HostLoc hostloc) {
     if (HostLocIsGPR(hostloc)) {
-        DEBUG_ASSERT(hostloc != HostLoc::RSP && hostloc != HostLoc::R15);
+        DEBUG_ASSERT(hostloc != HostLoc::RSP && hostloc != HostLoc::R14 && hostloc != HostLoc::R15);
         return HostLocToReg64(hostloc);
     }
     if (HostLocIsXMM(hostloc)) {
@@ -42,11 +44,100 @@ static Xbyak::Reg HostLocToX64(HostLoc hostloc) {
     ASSERT_MSG(false, "This should never happen.");
 }
 
+/// Whether a value at `loc` wanted in one of `desired_locations` is a general-purpose value spilled to an XMM register (see SpillRegister).
+static bool IsSpilledToXmm(HostLoc loc, HostLocList desired_locations) {
+    return HostLocIsXMM(loc) && HostLocIsGPR(*desired_locations.begin());
+}
+
+/// Whether a value at `loc` has to be moved into one of `desired_locations` before it can be used, as from a spill slot.
+static bool IsSpillFor(HostLoc loc, HostLocList desired_locations) {
+    return HostLocIsSpill(loc) || IsSpilledToXmm(loc, desired_locations);
+}
+
+static bool IsPseudoOperation(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::GetCarryFromOp:
+    case IR::Opcode::GetOverflowFromOp:
+    case IR::Opcode::GetGEFromOp:
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr size_t NoFurtherUse = std::numeric_limits<size_t>::max();
+constexpr std::array<HostLoc, 4> host_call_args_hostloc = { ABI_PARAM1, ABI_PARAM2, ABI_PARAM3, ABI_PARAM4 };
+
+void RegAlloc::AnalyzeBlock(IR::Block& block, const std::function<bool(const IR::Inst&)>& is_host_call) {
+    size_t position = 0;
+    for (auto& inst : block) {
+        positions[&inst] = position;
+
+        // Pseudo-operations are emitted as part of the instruction they refer to.
+        if (!IsPseudoOperation(inst)) {
+            const bool host_call = is_host_call(inst);
+            if (host_call) {
+                host_call_positions.push_back(position);
+            }
+
+            for (size_t i = 0; i < inst.NumArgs(); i++) {
+                const IR::Value arg = inst.GetArg(i);
+                if (arg.IsImmediate() || arg.IsEmpty())
+                    continue;
+
+                std::vector<size_t>& uses = use_positions[arg.GetInst()];
+                if (host_call && uses.empty() && i < host_call_args_hostloc.size()) {
+                    host_call_argument_locations[arg.GetInst()] = host_call_args_hostloc[i];
+                }
+                uses.push_back(position);
+            }
+        }
+
+        position++;
+    }
+}
+
+void RegAlloc::SetCurrentInstruction(const IR::Inst* inst) {
+    auto iter = positions.find(inst);
+    if (iter != positions.end()) {
+        current_position = iter->second;
+    }
+}
+
+/// The position of the next use of inst by an instruction that has not been emitted yet.
+size_t RegAlloc::NextUse(const IR::Inst* inst) const {
+    auto iter = use_positions.find(inst);
+    if (iter == use_positions.end())
+        return NoFurtherUse;
+
+    auto next = std::lower_bound(iter->second.begin(), iter->second.end(), current_position);
+    return next != iter->second.end() ? *next : NoFurtherUse;
+}
+
+/// The position at which a value held in loc is next needed.
+size_t RegAlloc::NextUse(HostLoc loc) const {
+    size_t next_use = NoFurtherUse;
+    for (const IR::Inst* value : LocInfo(loc).values) {
+        next_use = std::min(next_use, NextUse(value));
+    }
+    return next_use;
+}
+
+/// Whether a host call is emitted between the definition of inst and its last use.
+bool RegAlloc::LivesAcrossHostCall(const IR::Inst* inst) const {
+    auto uses = use_positions.find(inst);
+    if (uses == use_positions.end() || uses->second.empty())
+        return false;
+
+    auto next_host_call = std::upper_bound(host_call_positions.begin(), host_call_positions.end(), current_position);
+    return next_host_call != host_call_positions.end() && *next_host_call < uses->second.back();
+}
+
 HostLoc RegAlloc::DefHostLocReg(IR::Inst* def_inst, HostLocList desired_locations) {
     DEBUG_ASSERT(std::all_of(desired_locations.begin(), desired_locations.end(), HostLocIsRegister));
     DEBUG_ASSERT_MSG(!ValueLocation(def_inst), "def_inst has already been defined");
 
-    HostLoc location = SelectARegister(desired_locations);
+    HostLoc location = SelectARegister(desired_locations, def_inst);
 
     if (IsRegisterOccupied(location)) {
         SpillRegister(location);
@@ -94,7 +185,7 @@ HostLoc RegAlloc::UseDefHostLocReg(IR::Inst* use_inst, IR::Inst* def_inst, HostL
             loc_info.is_being_used = true;
             loc_info.def = def_inst;
             DEBUG_ASSERT(loc_info.IsUseDef());
-            if (HostLocIsSpill(current_location)) {
+            if (IsSpillFor(current_location, desired_locations)) {
                 HostLoc new_location = SelectARegister(desired_locations);
                 if (IsRegisterOccupied(new_location)) {
                     SpillRegister(new_location);
@@ -111,7 +202,7 @@ HostLoc RegAlloc::UseDefHostLocReg(IR::Inst* use_inst, IR::Inst* def_inst, HostL
 
     bool is_floating_point = HostLocIsXMM(*desired_locations.begin());
     if (is_floating_point) {
-        DEBUG_ASSERT(use_inst->GetType() == IR::Type::F32 || use_inst->GetType() == IR::Type::F64);
+        DEBUG_ASSERT(use_inst->GetType() == IR::Type::F32 || use_inst->GetType() == IR::Type::F64 || use_inst->GetType() == IR::Type::U128);
     }
     HostLoc use_reg = UseHostLocReg(use_inst, is_floating_point ? any_xmm : any_gpr);
     HostLoc def_reg = DefHostLocReg(def_inst, desired_locations);
@@ -126,12 +217,12 @@ HostLoc RegAlloc::UseDefHostLocReg(IR::Inst* use_inst, IR::Inst* def_inst, HostL
 std::tuple<OpArg, HostLoc> RegAlloc::UseDefOpArgHostLocReg(IR::Value use_value, IR::Inst* def_inst, HostLocList desired_locations) {
     DEBUG_ASSERT(std::all_of(desired_locations.begin(), desired_locations.end(), HostLocIsRegister));
     DEBUG_ASSERT_MSG(!ValueLocation(def_inst), "def_inst has already been defined");
-    DEBUG_ASSERT_MSG(use_value.IsImmediate() || ValueLocation(use_value.GetInst()), "use_inst has not been defined");
+    DEBUG_ASSERT_MSG(use_value.IsImmediate() || ValueLocation(use_value.GetInst()) || folded_values.count(use_value.GetInst()), "use_inst has not been defined");
 
-    if (!use_value.IsImmediate()) {
+    if (!use_value.IsImmediate() && folded_values.count(use_value.GetInst()) == 0) {
         const IR::Inst* use_inst = use_value.GetInst();
 
-        if (IsLastUse(use_inst)) {
+        if (IsLastUse(use_inst) && !IsSpilledToXmm(*ValueLocation(use_inst), desired_locations)) {
             HostLoc current_location = *ValueLocation(use_inst);
             auto& loc_info = LocInfo(current_location);
             if (!loc_info.IsIdle()) {
@@ -167,9 +258,7 @@ HostLoc RegAlloc::UseHostLocReg(IR::Inst* use_inst, HostLocList desired_location
     bool was_being_used;
     std::tie(current_location, was_being_used) = UseHostLoc(use_inst, desired_locations);
 
-    if (HostLocIsRegister(current_location)) {
-        return current_location;
-    } else if (HostLocIsSpill(current_location)) {
+    if (IsSpillFor(current_location, desired_locations)) {
         HostLoc new_location = SelectARegister(desired_locations);
         if (IsRegisterOccupied(new_location)) {
             SpillRegister(new_location);
@@ -184,6 +273,8 @@ HostLoc RegAlloc::UseHostLocReg(IR::Inst* use_inst, HostLocList desired_location
             DEBUG_ASSERT(LocInfo(new_location).IsScratch());
         }
         return new_location;
+    } else if (HostLocIsRegister(current_location)) {
+        return current_location;
     }
 
     ASSERT_MSG(false, "Unknown current_location type");
@@ -197,6 +288,19 @@ OpArg RegAlloc::UseOpArg(IR::Value use_value, HostLocList desired_locations) {
 
     IR::Inst* use_inst = use_value.GetInst();
 
+    const auto folded = folded_values.find(use_inst);
+    if (folded != folded_values.end()) {
+        const Xbyak::Address address = folded->second;
+        folded_values.erase(folded);
+        use_inst->DecrementRemainingUses();
+        return address;
+    }
+
+    if (IsSpilledToXmm(*ValueLocation(use_inst), desired_locations)) {
+        // An XMM register is not an operand of general-purpose instructions.
+        return HostLocToX64(UseHostLocReg(use_inst, desired_locations));
+    }
+
     HostLoc current_location;
     bool was_being_used;
     std::tie(current_location, was_being_used) = UseHostLoc(use_inst, desired_locations);
@@ -273,14 +377,10 @@ HostLoc RegAlloc::ScratchHostLocReg(HostLocList desired_locations) {
 }
 
 void RegAlloc::HostCall(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1_use, IR::Value arg2_use, IR::Value arg3_use) {
-    constexpr size_t args_count = 4;
-    constexpr std::array<HostLoc, args_count> args_hostloc = { ABI_PARAM1, ABI_PARAM2, ABI_PARAM3, ABI_PARAM4 };
-    const std::array<IR::Value*, args_count> args = {&arg0_use, &arg1_use, &arg2_use, &arg3_use};
-
-    const static std::vector<HostLoc> other_caller_save = [args_hostloc](){
+    const static std::vector<HostLoc> other_caller_save = [](){
         std::vector<HostLoc> ret(ABI_ALL_CALLER_SAVE.begin(), ABI_ALL_CALLER_SAVE.end());
 
-        for (auto hostloc : args_hostloc)
+        for (auto hostloc : host_call_args_hostloc)
             ret.erase(std::find(ret.begin(), ret.end(), hostloc));
 
         return ret;
@@ -288,6 +388,32 @@ void RegAlloc::HostCall(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1
 
     // TODO: This works but almost certainly leads to suboptimal generated code.
 
+    AllocateHostCallArguments(result_def, arg0_use, arg1_use, arg2_use, arg3_use);
+
+    for (HostLoc caller_saved : other_caller_save) {
+        ScratchHostLocReg({caller_saved});
+    }
+}
+
+std::vector<HostLoc> RegAlloc::HostCallSavingLiveRegisters(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1_use, IR::Value arg2_use, IR::Value arg3_use) {
+    AllocateHostCallArguments(result_def, arg0_use, arg1_use, arg2_use, arg3_use);
+    return LiveCallerSaveRegisters();
+}
+
+std::vector<HostLoc> RegAlloc::LiveCallerSaveRegisters() const {
+    std::vector<HostLoc> live;
+    for (HostLoc caller_saved : ABI_ALL_CALLER_SAVE) {
+        if (IsRegisterOccupied(caller_saved)) {
+            live.push_back(caller_saved);
+        }
+    }
+    return live;
+}
+
+void RegAlloc::AllocateHostCallArguments(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1_use, IR::Value arg2_use, IR::Value arg3_use) {
+    constexpr size_t args_count = host_call_args_hostloc.size();
+    const std::array<IR::Value*, args_count> args = {&arg0_use, &arg1_use, &arg2_use, &arg3_use};
+
     if (result_def) {
         DefHostLocReg(result_def, {ABI_RETURN});
     } else {
@@ -296,18 +422,29 @@ void RegAlloc::HostCall(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1
 
     for (size_t i = 0; i < args_count; i++) {
         if (!args[i]->IsEmpty()) {
-            UseScratchHostLocReg(*args[i], {args_hostloc[i]});
+            UseScratchHostLocReg(*args[i], {host_call_args_hostloc[i]});
         } else {
-            ScratchHostLocReg({args_hostloc[i]});
+            ScratchHostLocReg({host_call_args_hostloc[i]});
         }
     }
+}
 
-    for (HostLoc caller_saved : other_caller_save) {
-        ScratchHostLocReg({caller_saved});
-    }
+void RegAlloc::RegisterEntryValue(IR::Inst* inst, HostLoc location) {
+    DEBUG_ASSERT(HostLocIsRegister(location));
+    DEBUG_ASSERT_MSG(!ValueLocation(inst), "inst has already been defined");
+    DEBUG_ASSERT_MSG(!IsRegisterOccupied(location), "location is already occupied");
+
+    LocInfo(location).values.emplace_back(inst);
+}
+
+void RegAlloc::RegisterFoldedValue(IR::Inst* inst, const Xbyak::Address& address) {
+    DEBUG_ASSERT_MSG(!ValueLocation(inst), "inst has already been defined");
+    DEBUG_ASSERT_MSG(inst->UseCount() == 1, "Only a value with a single use can be folded into it");
+
+    folded_values.emplace(inst, address);
 }
 
-HostLoc RegAlloc::SelectARegister(HostLocList desired_locations) const {
+HostLoc RegAlloc::SelectARegister(HostLocList desired_locations, const IR::Inst* def_inst) const {
     std::vector<HostLoc> candidates = desired_locations;
 
     // Find all locations that have not been allocated..
@@ -317,14 +454,32 @@ HostLoc RegAlloc::SelectARegister(HostLocList desired_locations) const {
     candidates.erase(allocated_locs, candidates.end());
     ASSERT_MSG(!candidates.empty(), "All candidate registers have already been allocated");
 
-    // Selects the best location out of the available locations.
-    // TODO: Actually do LRU or something. Currently we just try to pick something without a value if possible.
+    const auto is_free = [this](HostLoc loc) { return !this->IsRegisterOccupied(loc); };
+    const auto is_candidate = [&candidates](HostLoc loc) { return std::find(candidates.begin(), candidates.end(), loc) != candidates.end(); };
 
-    std::partition(candidates.begin(), candidates.end(), [this](auto loc){
-        return !this->IsRegisterOccupied(loc);
-    });
+    if (def_inst) {
+        // A value that is first used by a host call is defined where that call needs it.
+        auto argument_location = host_call_argument_locations.find(def_inst);
+        if (argument_location != host_call_argument_locations.end() && is_candidate(argument_location->second) && is_free(argument_location->second))
+            return argument_location->second;
+
+        // A value that lives across a host call is kept in a callee-saved register, so it need not be spilled for the call.
+        if (LivesAcrossHostCall(def_inst)) {
+            for (HostLoc loc : ABI_ALL_CALLEE_SAVE) {
+                if (is_candidate(loc) && is_free(loc))
+                    return loc;
+            }
+        }
+    }
+
+    // Prefer a location without a value. Otherwise evict the value that is needed furthest in the future.
+    auto free_loc = std::find_if(candidates.begin(), candidates.end(), is_free);
+    if (free_loc != candidates.end())
+        return *free_loc;
 
-    return candidates.front();
+    return *std::max_element(candidates.begin(), candidates.end(), [this](HostLoc a, HostLoc b) {
+        return this->NextUse(a) < this->NextUse(b);
+    });
 }
 
 boost::optional<HostLoc> RegAlloc::ValueLocation(const IR::Inst* value) const {
@@ -357,11 +512,44 @@ void RegAlloc::SpillRegister(HostLoc loc) {
     ASSERT_MSG(IsRegisterOccupied(loc), "There is no need to spill unoccupied registers");
     ASSERT_MSG(!IsRegisterAllocated(loc), "Registers that have been allocated must not be spilt");
 
-    HostLoc new_loc = FindFreeSpill();
+    const auto is_free = [this](HostLoc reg) { return !IsRegisterOccupied(reg) && !IsRegisterAllocated(reg); };
+    const auto is_callee_saved = [](HostLoc reg) {
+        return std::find(ABI_ALL_CALLEE_SAVE.begin(), ABI_ALL_CALLEE_SAVE.end(), reg) != ABI_ALL_CALLEE_SAVE.end();
+    };
+
+    // A free callee-saved register is cheaper than memory, and survives host calls.
+    boost::optional<HostLoc> new_loc;
+    for (HostLoc callee_saved : ABI_ALL_CALLEE_SAVE) {
+        if (callee_saved == HostLoc::R14 || callee_saved == HostLoc::R15 || HostLocIsGPR(callee_saved) != HostLocIsGPR(loc))
+            continue;
+        if (is_free(callee_saved)) {
+            new_loc = callee_saved;
+            break;
+        }
+    }
+
+    // Failing that, general-purpose values go to a free XMM register, which MOVQ reaches in a few cycles
+    // without a round trip through the store buffer. Those used after a host call need a callee-saved one.
+    // XMM registers are taken from the top, as emitters ask for the low ones by name.
+    if (!new_loc && HostLocIsGPR(loc)) {
+        const auto& values = LocInfo(loc).values;
+        const bool lives_across_host_call = std::binary_search(host_call_positions.begin(), host_call_positions.end(), current_position)
+                || std::any_of(values.begin(), values.end(), [this](const IR::Inst* value) { return LivesAcrossHostCall(value); });
+        for (auto iter = std::rbegin(any_xmm); iter != std::rend(any_xmm); ++iter) {
+            if (is_free(*iter) && (!lives_across_host_call || is_callee_saved(*iter))) {
+                new_loc = *iter;
+                break;
+            }
+        }
+    }
+
+    if (!new_loc) {
+        new_loc = FindFreeSpill();
+    }
 
-    EmitMove(new_loc, loc);
+    EmitMove(*new_loc, loc);
 
-    LocInfo(new_loc) = LocInfo(loc);
+    LocInfo(*new_loc) = LocInfo(loc);
     LocInfo(loc) = {};
 }
 
@@ -391,17 +579,19 @@ void RegAlloc::EndOfAllocScope() {
 
 void RegAlloc::AssertNoMoreUses() {
     ASSERT(std::all_of(hostloc_info.begin(), hostloc_info.end(), [](const auto& i){ return i.values.empty(); }));
+    ASSERT(folded_values.empty());
 }
 
 void RegAlloc::Reset() {
     hostloc_info.fill({});
+    folded_values.clear();
 }
 
 void RegAlloc::EmitMove(HostLoc to, HostLoc from) {
     if (HostLocIsXMM(to) && HostLocIsSpill(from)) {
-        code->movsd(HostLocToXmm(to), SpillToOpArg(from));
+        code->movups(HostLocToXmm(to), SpillToOpArg(from));
     } else if (HostLocIsSpill(to) && HostLocIsXMM(from)) {
-        code->movsd(SpillToOpArg(to), HostLocToXmm(from));
+        code->movups(SpillToOpArg(to), HostLocToXmm(from));
     } else if (HostLocIsXMM(to) && HostLocIsXMM(from)) {
         code->movaps(HostLocToXmm(to), HostLocToXmm(from));
     } else if (HostLocIsGPR(to) && HostLocIsSpill(from)) {
@@ -410,6 +600,10 @@ void RegAlloc::EmitMove(HostLoc to, HostLoc from) {
         code->mov(SpillToOpArg(to), HostLocToReg64(from));
     } else if (HostLocIsGPR(to) && HostLocIsGPR(from)){
         code->mov(HostLocToReg64(to), HostLocToReg64(from));
+    } else if (HostLocIsGPR(to) && HostLocIsXMM(from)) {
+        code->movq(HostLocToReg64(to), HostLocToXmm(from));
+    } else if (HostLocIsXMM(to) && HostLocIsGPR(from)) {
+        code->movq(HostLocToXmm(to), HostLocToReg64(from));
     } else {
         ASSERT_MSG(false, "Invalid RegAlloc::EmitMove");
     }
@@ -453,7 +647,7 @@ std::tuple<HostLoc, bool> RegAlloc::UseHostLoc(IR::Inst* use_inst, HostLocList d
         }
     }
 
-    if (HostLocIsSpill(current_location)) {
+    if (IsSpillFor(current_location, desired_locations)) {
         bool was_being_used = LocInfo(current_location).is_being_used;
         LocInfo(current_location).is_being_used = true;
         use_inst->DecrementRemainingUses();
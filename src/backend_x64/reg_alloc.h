@@ -7,6 +7,8 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -15,6 +17,7 @@
 #include "backend_x64/block_of_code.h"
 #include "backend_x64/hostloc.h"
 #include "common/common_types.h"
+#include "frontend/ir/basic_block.h"
 #include "frontend/ir/microinstruction.h"
 #include "frontend/ir/value.h"
 
@@ -88,6 +91,16 @@ class RegAlloc final {
 public:
     explicit RegAlloc(BlockOfCode* code) : code(code) {}
 
+    /**
+     * Precomputes where in `block` each value is used, so that allocation can look ahead: registers whose
+     * values are needed furthest in the future are evicted first, and values used by a later host call
+     * are placed where that call needs them. `is_host_call` determines which instructions are emitted as
+     * a host call taking the instruction's arguments in order.
+     */
+    void AnalyzeBlock(IR::Block& block, const std::function<bool(const IR::Inst&)>& is_host_call);
+    /// Informs the allocator that the instructions from here on are emitted for `inst`.
+    void SetCurrentInstruction(const IR::Inst* inst);
+
     /// Late-def
     Xbyak::Reg64 DefGpr(IR::Inst* def_inst, HostLocList desired_locations = any_gpr) {
         return HostLocToReg64(DefHostLocReg(def_inst, desired_locations));
@@ -140,6 +153,19 @@ public:
 
     /// Late-def for result register, Early-use for all arguments, Each value is placed into registers according to host ABI.
     void HostCall(IR::Inst* result_def = nullptr, IR::Value arg0_use = {}, IR::Value arg1_use = {}, IR::Value arg2_use = {}, IR::Value arg3_use = {});
+    /**
+     * As HostCall, except that values are left in the other caller-saved registers. Returns the registers
+     * holding values, which the call must preserve (see BlockOfCode::CallSavingRegisters).
+     */
+    std::vector<HostLoc> HostCallSavingLiveRegisters(IR::Inst* result_def = nullptr, IR::Value arg0_use = {}, IR::Value arg1_use = {}, IR::Value arg2_use = {}, IR::Value arg3_use = {});
+    /// The caller-saved registers that currently hold values, including those defined by the current instruction.
+    std::vector<HostLoc> LiveCallerSaveRegisters() const;
+
+    /// Records that the value of `inst` is already in the register `location` at the start of the block.
+    void RegisterEntryValue(IR::Inst* inst, HostLoc location);
+    /// Records that the value of `inst` is to be read from `address` by its only use, which must be through
+    /// UseOpArg or UseDefOpArgGpr/Xmm.
+    void RegisterFoldedValue(IR::Inst* inst, const Xbyak::Address& address);
 
     // TODO: Values in host flags
 
@@ -150,7 +176,11 @@ public:
     void Reset();
 
 private:
-    HostLoc SelectARegister(HostLocList desired_locations) const;
+    HostLoc SelectARegister(HostLocList desired_locations, const IR::Inst* def_inst = nullptr) const;
+    size_t NextUse(const IR::Inst* inst) const;
+    size_t NextUse(HostLoc loc) const;
+    bool LivesAcrossHostCall(const IR::Inst* inst) const;
+    void AllocateHostCallArguments(IR::Inst* result_def, IR::Value arg0_use, IR::Value arg1_use, IR::Value arg2_use, IR::Value arg3_use);
     boost::optional<HostLoc> ValueLocation(const IR::Inst* value) const;
     bool IsRegisterOccupied(HostLoc loc) const;
     bool IsRegisterAllocated(HostLoc loc) const;
@@ -176,6 +206,15 @@ private:
 
     BlockOfCode* code = nullptr;
 
+    // Lookahead information from AnalyzeBlock. Positions are indices of instructions in the block.
+    size_t current_position = 0;
+    std::unordered_map<const IR::Inst*, size_t> positions;
+    std::unordered_map<const IR::Inst*, std::vector<size_t>> use_positions; ///< In ascending order
+    std::unordered_map<const IR::Inst*, HostLoc> host_call_argument_locations;
+    std::vector<size_t> host_call_positions;                                 ///< In ascending order
+
+    std::unordered_map<const IR::Inst*, Xbyak::Address> folded_values;
+
     struct HostLocInfo {
         std::vector<IR::Inst*> values; // early value
         IR::Inst* def = nullptr; // late value
@@ -199,11 +238,11 @@ private:
     };
     std::array<HostLocInfo, HostLocCount> hostloc_info;
     HostLocInfo& LocInfo(HostLoc loc) {
-        DEBUG_ASSERT(loc != HostLoc::RSP && loc != HostLoc::R15);
+        DEBUG_ASSERT(loc != HostLoc::RSP && loc != HostLoc::R14 && loc != HostLoc::R15);
         return hostloc_info[static_cast<size_t>(loc)];
     }
     const HostLocInfo& LocInfo(HostLoc loc) const {
-        DEBUG_ASSERT(loc != HostLoc::RSP && loc != HostLoc::R15);
+        DEBUG_ASSERT(loc != HostLoc::RSP && loc != HostLoc::R14 && loc != HostLoc::R15);
         return hostloc_info[static_cast<size_t>(loc)];
     }
 };
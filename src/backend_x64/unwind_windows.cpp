@@ -193,7 +193,7 @@ void BlockOfCode::UnwindHandler::Register(BlockOfCode* code) {
     RUNTIME_FUNCTION* rfuncs = static_cast<RUNTIME_FUNCTION*>(code->AllocateFromCodeSpace(sizeof(RUNTIME_FUNCTION)));
     rfuncs->BeginAddress = static_cast<DWORD>(reinterpret_cast<u8*>(code->run_code) - code->getCode());
     rfuncs->EndAddress = static_cast<DWORD>(code->maxSize_);
-    rfuncs->UnwindData = static_cast<DWORD>(reinterpret_cast<u8*>(unwind_info) - code->getCode());
+    rfuncs->UnwindData = static_cast<DWORD>(static_cast<const u8*>(code->GetExecutablePointer(unwind_info)) - code->getCode());
 
     impl = std::make_unique<Impl>(rfuncs, code->getCode());
 }
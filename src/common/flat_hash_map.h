@@ -0,0 +1,179 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace Dynarmic {
+namespace Common {
+
+/**
+ * A hash map from u64 keys, such as location hashes, to values of type T. Entries are kept contiguously
+ * in insertion order (until erasure moves the last entry into the gap) and are found through an index of
+ * linearly probed slots, each holding a key and the position of its entry. A lookup reads one or two slots
+ * and then the entry itself, and inserting allocates nothing unless the map grows.
+ * Inserting or erasing invalidates all iterators and references to entries.
+ */
+template <typename T>
+class FlatHashMap final {
+public:
+    using value_type = std::pair<u64, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    /// Bytes allocated for entries and slots, not counting memory owned by the values themselves.
+    size_t AllocatedBytes() const { return entries.capacity() * sizeof(value_type) + slots.capacity() * sizeof(Slot); }
+
+    iterator find(u64 key) {
+        const size_t slot = FindSlot(key);
+        return slot == NotFound ? entries.end() : entries.begin() + slots[slot].index;
+    }
+    const_iterator find(u64 key) const {
+        const size_t slot = FindSlot(key);
+        return slot == NotFound ? entries.end() : entries.begin() + slots[slot].index;
+    }
+
+    size_t count(u64 key) const {
+        return FindSlot(key) == NotFound ? 0 : 1;
+    }
+
+    T& at(u64 key) {
+        const auto iter = find(key);
+        ASSERT(iter != entries.end());
+        return iter->second;
+    }
+    const T& at(u64 key) const {
+        const auto iter = find(key);
+        ASSERT(iter != entries.end());
+        return iter->second;
+    }
+
+    T& operator[](u64 key) {
+        return emplace(key, T{}).first->second;
+    }
+
+    /// Inserts `value` at `key` unless there is already an entry there. Returns the entry at `key`,
+    /// and whether it was inserted.
+    std::pair<iterator, bool> emplace(u64 key, T value) {
+        const size_t existing = FindSlot(key);
+        if (existing != NotFound)
+            return {entries.begin() + slots[existing].index, false};
+
+        // Kept at most half full, so that probe sequences stay short.
+        if (2 * (entries.size() + 1) > slots.size())
+            Rehash(std::max<size_t>(2 * slots.size(), 16));
+
+        slots[FreeSlot(key)] = {key, static_cast<u32>(entries.size())};
+        entries.emplace_back(key, std::move(value));
+        return {std::prev(entries.end()), true};
+    }
+
+    /// Erases the entry at `iter`, moving the last entry into its place. Returns an iterator to the
+    /// entry now at that position, so that iterating over all entries while erasing visits each once.
+    iterator erase(const_iterator iter) {
+        const size_t index = static_cast<size_t>(iter - entries.cbegin());
+        RemoveSlot(FindSlot(iter->first));
+        if (index != entries.size() - 1) {
+            entries[index] = std::move(entries.back());
+            slots[FindSlot(entries[index].first)].index = static_cast<u32>(index);
+        }
+        entries.pop_back();
+        return entries.begin() + index;
+    }
+
+    size_t erase(u64 key) {
+        const auto iter = find(key);
+        if (iter == entries.end())
+            return 0;
+        erase(iter);
+        return 1;
+    }
+
+    /// Erases all entries, keeping the memory allocated for them.
+    void clear() {
+        entries.clear();
+        std::fill(slots.begin(), slots.end(), Slot{0, EmptySlot});
+    }
+
+private:
+    static constexpr u32 EmptySlot = 0xFFFFFFFF;
+    static constexpr size_t NotFound = ~size_t(0);
+
+    struct Slot {
+        u64 key;
+        u32 index; ///< Of the entry in `entries`, or EmptySlot
+    };
+
+    size_t HomeSlot(u64 key) const {
+        // Location hashes differ mostly in their low bits; Fibonacci hashing spreads them over the slots.
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15) >> shift);
+    }
+
+    size_t FindSlot(u64 key) const {
+        if (slots.empty())
+            return NotFound;
+        const size_t mask = slots.size() - 1;
+        for (size_t slot = HomeSlot(key);; slot = (slot + 1) & mask) {
+            if (slots[slot].index == EmptySlot)
+                return NotFound;
+            if (slots[slot].key == key)
+                return slot;
+        }
+    }
+
+    size_t FreeSlot(u64 key) const {
+        const size_t mask = slots.size() - 1;
+        size_t slot = HomeSlot(key);
+        while (slots[slot].index != EmptySlot)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    /// Empties `hole`, shifting back the slots after it whose probe sequences pass through it.
+    void RemoveSlot(size_t hole) {
+        const size_t mask = slots.size() - 1;
+        for (size_t slot = (hole + 1) & mask; slots[slot].index != EmptySlot; slot = (slot + 1) & mask) {
+            const size_t home = HomeSlot(slots[slot].key);
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                slots[hole] = slots[slot];
+                hole = slot;
+            }
+        }
+        slots[hole].index = EmptySlot;
+    }
+
+    void Rehash(size_t slot_count) {
+        ASSERT((slot_count & (slot_count - 1)) == 0);
+        slots.assign(slot_count, Slot{0, EmptySlot});
+        shift = 64;
+        for (size_t count = slot_count; count > 1; count >>= 1)
+            shift--;
+        for (size_t index = 0; index < entries.size(); index++) {
+            slots[FreeSlot(entries[index].first)] = {entries[index].first, static_cast<u32>(index)};
+        }
+    }
+
+    std::vector<value_type> entries;
+    std::vector<Slot> slots; ///< A power of two in number, or none
+    unsigned shift = 64;     ///< 64 - log2(slots.size())
+};
+
+} // namespace Common
+} // namespace Dynarmic
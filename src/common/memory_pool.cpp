@@ -13,11 +13,10 @@ namespace Common {
 
 Pool::Pool(size_t object_size, size_t initial_pool_size) : object_size(object_size), slab_size(initial_pool_size) {
     AllocateNewSlab();
+    UseSlab(0);
 }
 
 Pool::~Pool() {
-    std::free(current_slab);
-
     for (char* slab : slabs) {
         std::free(slab);
     }
@@ -25,8 +24,10 @@ Pool::~Pool() {
 
 void* Pool::Alloc() {
     if (remaining == 0) {
-        slabs.emplace_back(current_slab);
-        AllocateNewSlab();
+        if (current_slab_index + 1 == slabs.size()) {
+            AllocateNewSlab();
+        }
+        UseSlab(current_slab_index + 1);
     }
 
     void* ret = static_cast<void*>(current_ptr);
@@ -36,12 +37,31 @@ void* Pool::Alloc() {
     return ret;
 }
 
+void Pool::Reset() {
+    UseSlab(0);
+}
+
+void Pool::Shrink() {
+    for (size_t i = 1; i < slabs.size(); i++) {
+        std::free(slabs[i]);
+    }
+    slabs.resize(1);
+    UseSlab(0);
+}
+
+size_t Pool::AllocatedBytes() const {
+    return slabs.size() * slab_size * object_size;
+}
+
 void Pool::AllocateNewSlab() {
-    current_slab = static_cast<char*>(std::malloc(object_size * slab_size));
-    current_ptr = current_slab;
-    remaining = slab_size;
+    slabs.emplace_back(static_cast<char*>(std::malloc(object_size * slab_size)));
 }
 
+void Pool::UseSlab(size_t index) {
+    current_slab_index = index;
+    current_ptr = slabs[index];
+    remaining = slab_size;
+}
 
 } // namespace Common
 } // namespace Dynarmic
@@ -27,15 +27,26 @@ public:
     /// Returns a pointer to an `object_size`-bytes block of memory.
     void* Alloc();
 
+    /// Makes all memory handed out by Alloc available again, keeping the slabs for reuse.
+    /// Objects allocated from this pool must no longer be in use.
+    void Reset();
+    /// As Reset, but also frees all slabs but the first.
+    void Shrink();
+
+    /// Bytes allocated for slabs.
+    size_t AllocatedBytes() const;
+
 private:
     // Allocates a completely new memory slab.
     // Used when an entirely new slab is needed
     // due the current one running out of usable space.
     void AllocateNewSlab();
+    // Makes the slab at `index` the one objects are allocated from.
+    void UseSlab(size_t index);
 
     size_t object_size;
     size_t slab_size;
-    char* current_slab;
+    size_t current_slab_index;
     char* current_ptr;
     size_t remaining;
     std::vector<char*> slabs;
@@ -0,0 +1,78 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include "common/bit_util.h"
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+/**
+ * Representation of the If-Then execution state of the Thumb instruction set.
+ *
+ * IT[7:5] holds the base condition of the current IT block. IT[4:0] holds the lowest bit of
+ * the condition of each remaining instruction of the block, followed by a terminating one bit.
+ */
+class ITState final
+{
+public:
+    ITState() = default;
+    ITState(const ITState&) = default;
+    ITState(ITState&&) = default;
+    explicit ITState(u8 data) : value{data} {}
+
+    ITState& operator=(const ITState&) = default;
+    ITState& operator=(ITState&&) = default;
+    ITState& operator=(u8 data) {
+        value = data;
+        return *this;
+    }
+
+    /// Condition of the current instruction.
+    Cond Condition() const {
+        return static_cast<Cond>(Common::Bits<4, 7>(value));
+    }
+
+    /// Whether the current instruction is within an IT block.
+    bool IsInITBlock() const {
+        return Common::Bits<0, 3>(value) != 0;
+    }
+
+    /// Whether the current instruction is the last instruction of an IT block.
+    bool IsLastInITBlock() const {
+        return Common::Bits<0, 3>(value) == 0b1000;
+    }
+
+    /// The state for the instruction after the current one.
+    ITState Advance() const {
+        if (Common::Bits<0, 2>(value) == 0) {
+            return ITState{0};
+        }
+        return ITState{static_cast<u8>((value & 0b11100000) | ((value << 1) & 0b00011111))};
+    }
+
+    /// Gets the underlying raw value within the ITSTATE.
+    u8 Value() const {
+        return value;
+    }
+
+private:
+    u8 value = 0;
+};
+
+inline bool operator==(ITState lhs, ITState rhs) {
+    return lhs.Value() == rhs.Value();
+}
+
+inline bool operator!=(ITState lhs, ITState rhs) {
+    return !operator==(lhs, rhs);
+}
+
+} // namespace Arm
+} // namespace Dynarmic
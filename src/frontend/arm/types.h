@@ -39,13 +39,18 @@ enum class ExtReg {
     D8, D9, D10, D11, D12, D13, D14, D15,
     D16, D17, D18, D19, D20, D21, D22, D23,
     D24, D25, D26, D27, D28, D29, D30, D31,
+    Q0, Q1, Q2, Q3, Q4, Q5, Q6, Q7,
+    Q8, Q9, Q10, Q11, Q12, Q13, Q14, Q15,
 };
 
+using Imm2 = u8;
 using Imm3 = u8;
 using Imm4 = u8;
 using Imm5 = u8;
+using Imm6 = u8;
 using Imm7 = u8;
 using Imm8 = u8;
+using Imm10 = u16;
 using Imm11 = u16;
 using Imm12 = u16;
 using Imm24 = u32;
@@ -84,6 +89,10 @@ constexpr bool IsDoubleExtReg(ExtReg reg) {
     return reg >= ExtReg::D0 && reg <= ExtReg::D31;
 }
 
+constexpr bool IsQuadExtReg(ExtReg reg) {
+    return reg >= ExtReg::Q0 && reg <= ExtReg::Q15;
+}
+
 inline size_t RegNumber(Reg reg) {
     ASSERT(reg != Reg::INVALID_REG);
     return static_cast<size_t>(reg);
@@ -98,6 +107,10 @@ inline size_t RegNumber(ExtReg reg) {
         return static_cast<size_t>(reg) - static_cast<size_t>(ExtReg::D0);
     }
 
+    if (IsQuadExtReg(reg)) {
+        return static_cast<size_t>(reg) - static_cast<size_t>(ExtReg::Q0);
+    }
+
     ASSERT_MSG(false, "Invalid extended register");
 }
 
@@ -114,7 +127,8 @@ inline ExtReg operator+(ExtReg reg, size_t number) {
     ExtReg new_reg = static_cast<ExtReg>(static_cast<size_t>(reg) + number);
 
     ASSERT((IsSingleExtReg(reg) && IsSingleExtReg(new_reg)) ||
-           (IsDoubleExtReg(reg) && IsDoubleExtReg(new_reg)));
+           (IsDoubleExtReg(reg) && IsDoubleExtReg(new_reg)) ||
+           (IsQuadExtReg(reg) && IsQuadExtReg(new_reg)));
 
     return new_reg;
 }
@@ -16,6 +16,7 @@
 
 #include "common/bit_util.h"
 #include "common/common_types.h"
+#include "frontend/decoder/decode_table.h"
 #include "frontend/decoder/decoder_detail.h"
 #include "frontend/decoder/matcher.h"
 
@@ -73,6 +74,8 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_MOV_imm,     "MOV (imm)",           "cccc0011101S0000ddddrrrrvvvvvvvv"), // all
         INST(&V::arm_MOV_reg,     "MOV (reg)",           "cccc0001101S0000ddddvvvvvrr0mmmm"), // all
         INST(&V::arm_MOV_rsr,     "MOV (rsr)",           "cccc0001101S0000ddddssss0rr1mmmm"), // all
+        INST(&V::arm_MOVT,        "MOVT",                "cccc00110100vvvvddddvvvvvvvvvvvv"), // v6T2
+        INST(&V::arm_MOVW,        "MOVW",                "cccc00110000vvvvddddvvvvvvvvvvvv"), // v6T2
         INST(&V::arm_MVN_imm,     "MVN (imm)",           "cccc0011111S0000ddddrrrrvvvvvvvv"), // all
         INST(&V::arm_MVN_reg,     "MVN (reg)",           "cccc0001111S0000ddddvvvvvrr0mmmm"), // all
         INST(&V::arm_MVN_rsr,     "MVN (rsr)",           "cccc0001111S0000ddddssss0rr1mmmm"), // all
@@ -98,6 +101,12 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_TST_reg,     "TST (reg)",           "cccc00010001nnnn0000vvvvvrr0mmmm"), // all
         INST(&V::arm_TST_rsr,     "TST (rsr)",           "cccc00010001nnnn0000ssss0rr1mmmm"), // all
 
+        // Bitfield instructions
+        INST(&V::arm_BFC,         "BFC",                 "cccc0111110vvvvvddddvvvvv0011111"), // v6T2
+        INST(&V::arm_BFI,         "BFI",                 "cccc0111110vvvvvddddvvvvv001nnnn"), // v6T2
+        INST(&V::arm_SBFX,        "SBFX",                "cccc0111101wwwwwddddvvvvv101nnnn"), // v6T2
+        INST(&V::arm_UBFX,        "UBFX",                "cccc0111111wwwwwddddvvvvv101nnnn"), // v6T2
+
         // Exception Generating instructions
         INST(&V::arm_BKPT,        "BKPT",                "cccc00010010vvvvvvvvvvvv0111vvvv"), // v5
         INST(&V::arm_SVC,         "SVC",                 "cccc1111vvvvvvvvvvvvvvvvvvvvvvvv"), // all
@@ -119,10 +128,15 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
 
         // Hint instructions
         INST(&V::arm_PLD,         "PLD",                 "111101-1-101----1111------------"), // v5E; different on v7
-        INST(&V::arm_SEV,         "SEV",                 "----0011001000001111000000000100"), // v6K
-        INST(&V::arm_WFE,         "WFE",                 "----0011001000001111000000000010"), // v6K
-        INST(&V::arm_WFI,         "WFI",                 "----0011001000001111000000000011"), // v6K
-        INST(&V::arm_YIELD,       "YIELD",               "----0011001000001111000000000001"), // v6K
+        INST(&V::arm_SEV,         "SEV",                 "cccc0011001000001111000000000100"), // v6K
+        INST(&V::arm_WFE,         "WFE",                 "cccc0011001000001111000000000010"), // v6K
+        INST(&V::arm_WFI,         "WFI",                 "cccc0011001000001111000000000011"), // v6K
+        INST(&V::arm_YIELD,       "YIELD",               "cccc0011001000001111000000000001"), // v6K
+
+        // Barrier instructions
+        INST(&V::arm_DMB,         "DMB",                 "1111010101111111111100000101oooo"), // v7
+        INST(&V::arm_DSB,         "DSB",                 "1111010101111111111100000100oooo"), // v7
+        INST(&V::arm_ISB,         "ISB",                 "1111010101111111111100000110oooo"), // v7
 
         // Synchronization Primitive instructions
         INST(&V::arm_CLREX,       "CLREX",               "11110101011111111111000000011111"), // v6K
@@ -186,8 +200,8 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_LDMDA,       "LDMDA",               "cccc100000w1nnnnxxxxxxxxxxxxxxxx"), // all
         INST(&V::arm_LDMDB,       "LDMDB",               "cccc100100w1nnnnxxxxxxxxxxxxxxxx"), // all
         INST(&V::arm_LDMIB,       "LDMIB",               "cccc100110w1nnnnxxxxxxxxxxxxxxxx"), // all
+        INST(&V::arm_LDM_eret,    "LDM (exce ret)",      "cccc100pu1w1nnnn1xxxxxxxxxxxxxxx"), // all
         INST(&V::arm_LDM_usr,     "LDM (usr reg)",       "----100--101--------------------"), // all
-        INST(&V::arm_LDM_eret,    "LDM (exce ret)",      "----100--1-1----1---------------"), // all
         INST(&V::arm_STM,         "STM",                 "cccc100010w0nnnnxxxxxxxxxxxxxxxx"), // all
         INST(&V::arm_STMDA,       "STMDA",               "cccc100000w0nnnnxxxxxxxxxxxxxxxx"), // all
         INST(&V::arm_STMDB,       "STMDB",               "cccc100100w0nnnnxxxxxxxxxxxxxxxx"), // all
@@ -211,6 +225,7 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_REV,         "REV",                 "cccc011010111111dddd11110011mmmm"), // v6
         INST(&V::arm_REV16,       "REV16",               "cccc011010111111dddd11111011mmmm"), // v6
         INST(&V::arm_REVSH,       "REVSH",               "cccc011011111111dddd11111011mmmm"), // v6
+        INST(&V::arm_RBIT,        "RBIT",                "cccc011011111111dddd11110011mmmm"), // v6T2
 
         // Saturation instructions
         INST(&V::arm_SSAT,        "SSAT",                "cccc0110101vvvvvddddvvvvvr01nnnn"), // v6
@@ -220,6 +235,7 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
 
         // Multiply (Normal) instructions
         INST(&V::arm_MLA,         "MLA",                 "cccc0000001Sddddaaaammmm1001nnnn"), // v2
+        INST(&V::arm_MLS,         "MLS",                 "cccc00000110ddddaaaammmm1001nnnn"), // v6T2
         INST(&V::arm_MUL,         "MUL",                 "cccc0000000Sdddd0000mmmm1001nnnn"), // v2
 
         // Multiply (Long) instructions
@@ -251,6 +267,10 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_SMUAD,       "SMUAD",               "cccc01110000dddd1111mmmm00M1nnnn"), // v6
         INST(&V::arm_SMUSD,       "SMUSD",               "cccc01110000dddd1111mmmm01M1nnnn"), // v6
 
+        // Divide instructions
+        INST(&V::arm_SDIV,        "SDIV",                "cccc01110001dddd1111mmmm0001nnnn"), // v7VE
+        INST(&V::arm_UDIV,        "UDIV",                "cccc01110011dddd1111mmmm0001nnnn"), // v7VE
+
         // Parallel Add/Subtract (Modulo) instructions
         INST(&V::arm_SADD8,       "SADD8",               "cccc01100001nnnndddd11111001mmmm"), // v6
         INST(&V::arm_SADD16,      "SADD16",              "cccc01100001nnnndddd11110001mmmm"), // v6
@@ -300,12 +320,12 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
         INST(&V::arm_QDSUB,       "QDSUB",               "cccc00010110nnnndddd00000101mmmm"), // v5xP
 
         // Status Register Access instructions
-        INST(&V::arm_CPS,         "CPS",                 "111100010000---00000000---0-----"), // v6
+        INST(&V::arm_CPS,         "CPS",                 "111100010000mmM00000000aif0ddddd"), // v6
         INST(&V::arm_SETEND,      "SETEND",              "1111000100000001000000e000000000"), // v6
-        INST(&V::arm_MRS,         "MRS",                 "cccc000100001111dddd000000000000"), // v3
-        INST(&V::arm_MSR_imm,     "MSR (imm)",           "cccc00110010mm001111rrrrvvvvvvvv"), // v3
-        INST(&V::arm_MSR_reg,     "MSR (reg)",           "cccc00010010mm00111100000000nnnn"), // v3
-        INST(&V::arm_RFE,         "RFE",                 "1111100--0-1----0000101000000000"), // v6
+        INST(&V::arm_MRS,         "MRS",                 "cccc00010R001111dddd000000000000"), // v3
+        INST(&V::arm_MSR_imm,     "MSR (imm)",           "cccc00110R10mmmm1111rrrrvvvvvvvv"), // v3
+        INST(&V::arm_MSR_reg,     "MSR (reg)",           "cccc00010R10mmmm111100000000nnnn"), // v3
+        INST(&V::arm_RFE,         "RFE",                 "1111100pu0w1nnnn0000101000000000"), // v6
         INST(&V::arm_SRS,         "SRS",                 "0000011--0-00000000000000001----"), // v6
 
 #undef INST
@@ -322,12 +342,10 @@ std::vector<ArmMatcher<V>> GetArmDecodeTable() {
 
 template<typename V>
 boost::optional<const ArmMatcher<V>&> DecodeArm(u32 instruction) {
-    const static auto table = GetArmDecodeTable<V>();
-
-    const auto matches_instruction = [instruction](const auto& matcher) { return matcher.Matches(instruction); };
+    // Bits 27:20 and 7:4 discriminate between almost all ARM instructions.
+    const static DecodeTable<ArmMatcher<V>> table{GetArmDecodeTable<V>(), 0x0FF000F0};
 
-    auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-    return iter != table.end() ? boost::make_optional<const ArmMatcher<V>&>(*iter) : boost::none;
+    return table.Decode(instruction);
 }
 
 } // namespace Arm
@@ -0,0 +1,68 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "common/common_types.h"
+#include "frontend/decoder/decode_table.h"
+#include "frontend/decoder/decoder_detail.h"
+#include "frontend/decoder/matcher.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+template <typename Visitor>
+using ASIMDMatcher = Matcher<Visitor, u32>;
+
+template<typename V>
+std::vector<ASIMDMatcher<V>> GetASIMDDecodeTable() {
+    return {
+
+#define INST(fn, name, bitstring) detail::detail<ASIMDMatcher<V>>::GetMatcher(fn, name, bitstring)
+
+    // 1111001_________________________
+
+    // Three registers of the same length
+    INST(&V::asimd_VAND_reg,      "VAND (register)",         "111100100D00nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VBIC_reg,      "VBIC (register)",         "111100100D01nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VORR_reg,      "VORR (register)",         "111100100D10nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VORN_reg,      "VORN (register)",         "111100100D11nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VEOR_reg,      "VEOR (register)",         "111100110D00nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VBSL,          "VBSL",                    "111100110D01nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VBIT,          "VBIT",                    "111100110D10nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VBIF,          "VBIF",                    "111100110D11nnnndddd0001NQM1mmmm"),
+    INST(&V::asimd_VADD_int,      "VADD (integer)",          "111100100Dzznnnndddd1000NQM0mmmm"),
+    INST(&V::asimd_VSUB_int,      "VSUB (integer)",          "111100110Dzznnnndddd1000NQM0mmmm"),
+    INST(&V::asimd_VMUL_int,      "VMUL (integer)",          "111100100Dzznnnndddd1001NQM1mmmm"),
+
+    // 11110100________________________
+
+    // Element and structure load/store instructions
+    INST(&V::asimd_VST1_multiple, "VST1 (multiple)",         "111101000D00nnnnddddttttzzaammmm"),
+    INST(&V::asimd_VLD1_multiple, "VLD1 (multiple)",         "111101000D10nnnnddddttttzzaammmm"),
+
+#undef INST
+
+    };
+}
+
+template<typename V>
+boost::optional<const ASIMDMatcher<V>&> DecodeASIMD(u32 instruction) {
+    // Bits 27:20, 11:8 and 4 discriminate between all of the above instructions.
+    const static DecodeTable<ASIMDMatcher<V>> table{GetASIMDDecodeTable<V>(), 0x0FF00F10};
+
+    if ((instruction & 0xFE000000) != 0xF2000000 && (instruction & 0xFF100000) != 0xF4000000)
+        return boost::none; // Only match Advanced SIMD data-processing and element/structure load/store instructions.
+
+    return table.Decode(instruction);
+}
+
+} // namespace Arm
+} // namespace Dynarmic
@@ -0,0 +1,118 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "common/assert.h"
+#include "common/bit_util.h"
+#include "common/common_types.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+/**
+ * A table of matchers indexed by a subset of the bits of an instruction.
+ *
+ * Each entry of the table lists, in their original order, only the matchers which could match an
+ * instruction with those index bits, so that decoding does not have to try every matcher. Any matcher
+ * that is fully determined by the index bits ends its list, so if every bit of the instruction is
+ * an index bit each list holds at most one matcher and decoding is a single lookup.
+ *
+ * @tparam MatcherT The type of the Matcher to use.
+ */
+template <typename MatcherT>
+class DecodeTable {
+public:
+    using opcode_type = typename MatcherT::opcode_type;
+
+    /**
+     * @param matchers The matchers to decode with. Earlier matchers take precedence over later ones.
+     * @param index_bits The instruction bits used to index the table, which has 2^BitCount(index_bits) entries.
+     */
+    DecodeTable(std::vector<MatcherT> matchers, opcode_type index_bits) : matchers(std::move(matchers)), index_bits(index_bits) {
+        ASSERT(Common::BitCount(index_bits) <= 16);
+
+        // Split index_bits into runs of contiguous bits.
+        size_t index_position = 0;
+        for (size_t bit = 0; bit < Common::BitSize<opcode_type>(); bit++) {
+            if (!Common::Bit(bit, index_bits))
+                continue;
+            if (bit == 0 || !Common::Bit(bit - 1, index_bits)) {
+                runs.push_back({bit, 0, index_position});
+            }
+            runs.back().mask = static_cast<opcode_type>((runs.back().mask << 1) | 1);
+            index_position++;
+        }
+
+        const size_t entry_count = size_t(1) << index_position;
+        entry_begin.reserve(entry_count + 1);
+        for (size_t index = 0; index < entry_count; index++) {
+            const opcode_type instruction_bits = GetInstructionBits(index);
+            entry_begin.push_back(static_cast<u32>(candidates.size()));
+            for (const MatcherT& matcher : this->matchers) {
+                const opcode_type known_mask = matcher.GetMask() & index_bits;
+                if ((instruction_bits & known_mask) != (matcher.GetExpected() & known_mask))
+                    continue;
+                candidates.push_back(&matcher);
+                if (known_mask == matcher.GetMask())
+                    break; // This matcher will always match, so no later one will be reached.
+            }
+        }
+        entry_begin.push_back(static_cast<u32>(candidates.size()));
+    }
+
+    // Entries point into matchers.
+    DecodeTable(const DecodeTable&) = delete;
+    DecodeTable& operator=(const DecodeTable&) = delete;
+
+    /// Returns the first matcher that matches `instruction`, if any.
+    boost::optional<const MatcherT&> Decode(opcode_type instruction) const {
+        const size_t index = GetIndex(instruction);
+        for (u32 i = entry_begin[index]; i < entry_begin[index + 1]; i++) {
+            if (candidates[i]->Matches(instruction)) {
+                return *candidates[i];
+            }
+        }
+        return boost::none;
+    }
+
+private:
+    struct Run {
+        size_t instruction_position;
+        opcode_type mask;
+        size_t index_position;
+    };
+
+    size_t GetIndex(opcode_type instruction) const {
+        size_t index = 0;
+        for (const Run& run : runs) {
+            index |= static_cast<size_t>((instruction >> run.instruction_position) & run.mask) << run.index_position;
+        }
+        return index;
+    }
+
+    opcode_type GetInstructionBits(size_t index) const {
+        opcode_type instruction = 0;
+        for (const Run& run : runs) {
+            instruction |= static_cast<opcode_type>(((index >> run.index_position) & run.mask) << run.instruction_position);
+        }
+        return instruction;
+    }
+
+    const std::vector<MatcherT> matchers;
+    const opcode_type index_bits;
+    std::vector<Run> runs;
+    std::vector<u32> entry_begin;            ///< Index into candidates of the first candidate of each entry
+    std::vector<const MatcherT*> candidates; ///< Candidate matchers of all entries, in order
+};
+
+} // namespace Arm
+} // namespace Dynarmic
@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "common/common_types.h"
+#include "frontend/decoder/decode_table.h"
 #include "frontend/decoder/decoder_detail.h"
 #include "frontend/decoder/matcher.h"
 
@@ -21,8 +22,8 @@ template <typename Visitor>
 using Thumb16Matcher = Matcher<Visitor, u16>;
 
 template<typename V>
-boost::optional<const Thumb16Matcher<V>&> DecodeThumb16(u16 instruction) {
-    const static std::vector<Thumb16Matcher<V>> table = {
+std::vector<Thumb16Matcher<V>> GetThumb16DecodeTable() {
+    return {
 
 #define INST(fn, name, bitstring) detail::detail<Thumb16Matcher<V>>::GetMatcher(fn, name, bitstring)
 
@@ -99,6 +100,7 @@ boost::optional<const Thumb16Matcher<V>&> DecodeThumb16(u16 instruction) {
         INST(&V::thumb16_REV,            "REV",                      "1011101000mmmddd"), // v6
         INST(&V::thumb16_REV16,          "REV16",                    "1011101001mmmddd"), // v6
         INST(&V::thumb16_REVSH,          "REVSH",                    "1011101011mmmddd"), // v6
+        INST(&V::thumb16_IT,             "IT",                       "10111111ccccmmmm"), // v6T2
         //INST(&V::thumb16_BKPT,           "BKPT",                     "10111110xxxxxxxx"), // v5
 
         // Store/Load multiple registers
@@ -116,11 +118,14 @@ boost::optional<const Thumb16Matcher<V>&> DecodeThumb16(u16 instruction) {
 #undef INST
 
     };
+}
 
-    const auto matches_instruction = [instruction](const auto& matcher){ return matcher.Matches(instruction); };
+template<typename V>
+boost::optional<const Thumb16Matcher<V>&> DecodeThumb16(u16 instruction) {
+    // Every bit is an index bit, so this is a direct lookup.
+    const static DecodeTable<Thumb16Matcher<V>> table{GetThumb16DecodeTable<V>(), 0xFFFF};
 
-    auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-    return iter != table.end() ? boost::make_optional<const Thumb16Matcher<V>&>(*iter) : boost::none;
+    return table.Decode(instruction);
 }
 
 } // namespace Arm
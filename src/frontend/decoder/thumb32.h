@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "common/common_types.h"
+#include "frontend/decoder/decode_table.h"
 #include "frontend/decoder/decoder_detail.h"
 #include "frontend/decoder/matcher.h"
 
@@ -21,12 +22,135 @@ template <typename Visitor>
 using Thumb32Matcher = Matcher<Visitor, u32>;
 
 template<typename V>
-boost::optional<const Thumb32Matcher<V>&> DecodeThumb32(u32 instruction) {
-    const static std::vector<Thumb32Matcher<V>> table = {
+std::vector<Thumb32Matcher<V>> GetThumb32DecodeTable() {
+    return {
 
 #define INST(fn, name, bitstring) detail::detail<Thumb32Matcher<V>>::GetMatcher(fn, name, bitstring)
 
+        // Data processing (modified immediate) instructions
+        INST(&V::thumb32_TST_imm,        "TST (imm)",                "11110i000001nnnn0vvv1111xxxxxxxx"), // v6T2
+        INST(&V::thumb32_AND_imm,        "AND (imm)",                "11110i00000Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_BIC_imm,        "BIC (imm)",                "11110i00001Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_MOV_imm,        "MOV (imm)",                "11110i00010S11110vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_ORR_imm,        "ORR (imm)",                "11110i00010Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_MVN_imm,        "MVN (imm)",                "11110i00011S11110vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_ORN_imm,        "ORN (imm)",                "11110i00011Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_TEQ_imm,        "TEQ (imm)",                "11110i001001nnnn0vvv1111xxxxxxxx"), // v6T2
+        INST(&V::thumb32_EOR_imm,        "EOR (imm)",                "11110i00100Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_CMN_imm,        "CMN (imm)",                "11110i010001nnnn0vvv1111xxxxxxxx"), // v6T2
+        INST(&V::thumb32_ADD_imm,        "ADD (imm)",                "11110i01000Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_ADC_imm,        "ADC (imm)",                "11110i01010Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_SBC_imm,        "SBC (imm)",                "11110i01011Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_CMP_imm,        "CMP (imm)",                "11110i011011nnnn0vvv1111xxxxxxxx"), // v6T2
+        INST(&V::thumb32_SUB_imm,        "SUB (imm)",                "11110i01101Snnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_RSB_imm,        "RSB (imm)",                "11110i01110Snnnn0vvvddddxxxxxxxx"), // v6T2
+
+        // Data processing (plain binary immediate) instructions
+        INST(&V::thumb32_ADR_t3,         "ADR (T3)",                 "11110i10000011110vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_ADDW_imm,       "ADDW (imm)",               "11110i100000nnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_MOVW_imm,       "MOVW (imm)",               "11110i100100vvvv0xxxddddyyyyyyyy"), // v6T2
+        INST(&V::thumb32_ADR_t2,         "ADR (T2)",                 "11110i10101011110vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_SUBW_imm,       "SUBW (imm)",               "11110i101010nnnn0vvvddddxxxxxxxx"), // v6T2
+        INST(&V::thumb32_MOVT,           "MOVT",                     "11110i101100vvvv0xxxddddyyyyyyyy"), // v6T2
+        INST(&V::thumb32_SBFX,           "SBFX",                     "111100110100nnnn0vvvddddvv0wwwww"), // v6T2
+        INST(&V::thumb32_BFC,            "BFC",                      "11110011011011110vvvddddvv0mmmmm"), // v6T2
+        INST(&V::thumb32_BFI,            "BFI",                      "111100110110nnnn0vvvddddvv0mmmmm"), // v6T2
+        INST(&V::thumb32_UBFX,           "UBFX",                     "111100111100nnnn0vvvddddvv0wwwww"), // v6T2
+
+        // Data processing (shifted register) instructions
+        INST(&V::thumb32_TST_reg,        "TST (reg)",                "111010100001nnnn0vvv1111vvttmmmm"), // v6T2
+        INST(&V::thumb32_AND_reg,        "AND (reg)",                "11101010000Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_BIC_reg,        "BIC (reg)",                "11101010001Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_MOV_reg,        "MOV (reg)",                "11101010010S11110vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_ORR_reg,        "ORR (reg)",                "11101010010Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_MVN_reg,        "MVN (reg)",                "11101010011S11110vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_ORN_reg,        "ORN (reg)",                "11101010011Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_TEQ_reg,        "TEQ (reg)",                "111010101001nnnn0vvv1111vvttmmmm"), // v6T2
+        INST(&V::thumb32_EOR_reg,        "EOR (reg)",                "11101010100Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_CMN_reg,        "CMN (reg)",                "111010110001nnnn0vvv1111vvttmmmm"), // v6T2
+        INST(&V::thumb32_ADD_reg,        "ADD (reg)",                "11101011000Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_ADC_reg,        "ADC (reg)",                "11101011010Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_SBC_reg,        "SBC (reg)",                "11101011011Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_CMP_reg,        "CMP (reg)",                "111010111011nnnn0vvv1111vvttmmmm"), // v6T2
+        INST(&V::thumb32_SUB_reg,        "SUB (reg)",                "11101011101Snnnn0vvvddddvvttmmmm"), // v6T2
+        INST(&V::thumb32_RSB_reg,        "RSB (reg)",                "11101011110Snnnn0vvvddddvvttmmmm"), // v6T2
+
+        // Register shift, extension and miscellaneous instructions
+        INST(&V::thumb32_LSL_reg,        "LSL (reg)",                "11111010000Snnnn1111dddd0000mmmm"), // v6T2
+        INST(&V::thumb32_LSR_reg,        "LSR (reg)",                "11111010001Snnnn1111dddd0000mmmm"), // v6T2
+        INST(&V::thumb32_ASR_reg,        "ASR (reg)",                "11111010010Snnnn1111dddd0000mmmm"), // v6T2
+        INST(&V::thumb32_ROR_reg,        "ROR (reg)",                "11111010011Snnnn1111dddd0000mmmm"), // v6T2
+        INST(&V::thumb32_SXTH,           "SXTH",                     "11111010000011111111dddd10rrmmmm"), // v6T2
+        INST(&V::thumb32_UXTH,           "UXTH",                     "11111010000111111111dddd10rrmmmm"), // v6T2
+        INST(&V::thumb32_SXTB,           "SXTB",                     "11111010010011111111dddd10rrmmmm"), // v6T2
+        INST(&V::thumb32_UXTB,           "UXTB",                     "11111010010111111111dddd10rrmmmm"), // v6T2
+        INST(&V::thumb32_REV,            "REV",                      "111110101001mmmm1111dddd1000xxxx"), // v6T2
+        INST(&V::thumb32_REV16,          "REV16",                    "111110101001mmmm1111dddd1001xxxx"), // v6T2
+        INST(&V::thumb32_REVSH,          "REVSH",                    "111110101001mmmm1111dddd1011xxxx"), // v6T2
+        INST(&V::thumb32_RBIT,           "RBIT",                     "111110101001mmmm1111dddd1010xxxx"), // v6T2
+        INST(&V::thumb32_CLZ,            "CLZ",                      "111110101011mmmm1111dddd1000xxxx"), // v6T2
+
+        // Multiply instructions
+        INST(&V::thumb32_MUL,            "MUL",                      "111110110000nnnn1111dddd0000mmmm"), // v6T2
+        INST(&V::thumb32_MLA,            "MLA",                      "111110110000nnnnaaaadddd0000mmmm"), // v6T2
+        INST(&V::thumb32_MLS,            "MLS",                      "111110110000nnnnaaaadddd0001mmmm"), // v6T2
+        INST(&V::thumb32_SMULL,          "SMULL",                    "111110111000nnnnllllhhhh0000mmmm"), // v6T2
+        INST(&V::thumb32_UMULL,          "UMULL",                    "111110111010nnnnllllhhhh0000mmmm"), // v6T2
+        INST(&V::thumb32_SMLAL,          "SMLAL",                    "111110111100nnnnllllhhhh0000mmmm"), // v6T2
+        INST(&V::thumb32_UMLAL,          "UMLAL",                    "111110111110nnnnllllhhhh0000mmmm"), // v6T2
+        INST(&V::thumb32_SDIV,           "SDIV",                     "111110111001nnnn1111dddd1111mmmm"), // v7VE
+        INST(&V::thumb32_UDIV,           "UDIV",                     "111110111011nnnn1111dddd1111mmmm"), // v7VE
+
+        // Load/Store single data item instructions
+        INST(&V::thumb32_LDR_lit,        "LDR (lit)",                "11111000u1011111ttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDR_imm12,      "LDR (imm12)",              "111110001101nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDR_imm8,       "LDR (imm8)",               "111110000101nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDR_reg,        "LDR (reg)",                "111110000101nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_LDRB_lit,       "LDRB (lit)",               "11111000u0011111ttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRB_imm12,     "LDRB (imm12)",             "111110001001nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRB_imm8,      "LDRB (imm8)",              "111110000001nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRB_reg,       "LDRB (reg)",               "111110000001nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_LDRH_lit,       "LDRH (lit)",               "11111000u0111111ttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRH_imm12,     "LDRH (imm12)",             "111110001011nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRH_imm8,      "LDRH (imm8)",              "111110000011nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRH_reg,       "LDRH (reg)",               "111110000011nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_LDRSB_lit,      "LDRSB (lit)",              "11111001u0011111ttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSB_imm12,    "LDRSB (imm12)",            "111110011001nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSB_imm8,     "LDRSB (imm8)",             "111110010001nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSB_reg,      "LDRSB (reg)",              "111110010001nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_LDRSH_lit,      "LDRSH (lit)",              "11111001u0111111ttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSH_imm12,    "LDRSH (imm12)",            "111110011011nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSH_imm8,     "LDRSH (imm8)",             "111110010011nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDRSH_reg,      "LDRSH (reg)",              "111110010011nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_STR_imm12,      "STR (imm12)",              "111110001100nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STR_imm8,       "STR (imm8)",               "111110000100nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STR_reg,        "STR (reg)",                "111110000100nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_STRB_imm12,     "STRB (imm12)",             "111110001000nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STRB_imm8,      "STRB (imm8)",              "111110000000nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STRB_reg,       "STRB (reg)",               "111110000000nnnntttt000000vvmmmm"), // v6T2
+        INST(&V::thumb32_STRH_imm12,     "STRH (imm12)",             "111110001010nnnnttttxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STRH_imm8,      "STRH (imm8)",              "111110000010nnnntttt1puwxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STRH_reg,       "STRH (reg)",               "111110000010nnnntttt000000vvmmmm"), // v6T2
+
+        // Load/Store multiple, dual and table branch instructions
+        INST(&V::thumb32_TBB,            "TBB",                      "111010001101nnnn111100000000mmmm"), // v6T2
+        INST(&V::thumb32_TBH,            "TBH",                      "111010001101nnnn111100000001mmmm"), // v6T2
+        INST(&V::thumb32_LDRD_imm,       "LDRD (imm)",               "1110100pu1w1nnnnttttssssxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STRD_imm,       "STRD (imm)",               "1110100pu1w0nnnnttttssssxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDM,            "LDM",                      "1110100010w1nnnnxxxxxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_LDMDB,          "LDMDB",                    "1110100100w1nnnnxxxxxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STM,            "STM",                      "1110100010w0nnnnxxxxxxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_STMDB,          "STMDB",                    "1110100100w0nnnnxxxxxxxxxxxxxxxx"), // v6T2
+
+        // Barrier instructions (before B (T3), whose AL encodings they share)
+        INST(&V::thumb32_DMB,            "DMB",                      "1111001110111111100011110101oooo"), // v7
+        INST(&V::thumb32_DSB,            "DSB",                      "1111001110111111100011110100oooo"), // v7
+        INST(&V::thumb32_ISB,            "ISB",                      "1111001110111111100011110110oooo"), // v7
+
         // Branch instructions
+        INST(&V::thumb32_NOP,            "NOP",                      "11110011101011111000000000000000"), // v6T2
+        INST(&V::thumb32_B_t3,           "B (T3)",                   "11110Sccccvvvvvv10j0jxxxxxxxxxxx"), // v6T2
+        INST(&V::thumb32_B_t4,           "B (T4)",                   "11110Svvvvvvvvvv10j1jxxxxxxxxxxx"), // v6T2
         INST(&V::thumb32_BL_imm,         "BL (imm)",                 "11110vvvvvvvvvvv11111vvvvvvvvvvv"), // v4T
         INST(&V::thumb32_BLX_imm,        "BLX (imm)",                "11110vvvvvvvvvvv11101vvvvvvvvvvv"), // v5T
 
@@ -36,11 +160,14 @@ boost::optional<const Thumb32Matcher<V>&> DecodeThumb32(u32 instruction) {
 #undef INST
 
     };
+}
 
-    const auto matches_instruction = [instruction](const auto& matcher){ return matcher.Matches(instruction); };
+template<typename V>
+boost::optional<const Thumb32Matcher<V>&> DecodeThumb32(u32 instruction) {
+    // Bits 31:27 and 15:11 discriminate between the Thumb32 instructions we decode.
+    const static DecodeTable<Thumb32Matcher<V>> table{GetThumb32DecodeTable<V>(), 0xF800F800};
 
-    auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-    return iter != table.end() ? boost::make_optional<const Thumb32Matcher<V>&>(*iter) : boost::none;
+    return table.Decode(instruction);
 }
 
 } // namespace Arm
@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "common/common_types.h"
+#include "frontend/decoder/decode_table.h"
 #include "frontend/decoder/decoder_detail.h"
 #include "frontend/decoder/matcher.h"
 
@@ -21,8 +22,8 @@ template <typename Visitor>
 using VFP2Matcher = Matcher<Visitor, u32>;
 
 template<typename V>
-boost::optional<const VFP2Matcher<V>&> DecodeVFP2(u32 instruction) {
-    const static std::vector<VFP2Matcher<V>> table = {
+std::vector<VFP2Matcher<V>> GetVFP2DecodeTable() {
+    return {
 
 #define INST(fn, name, bitstring) detail::detail<VFP2Matcher<V>>::GetMatcher(fn, name, bitstring)
 
@@ -38,6 +39,10 @@ boost::optional<const VFP2Matcher<V>&> DecodeVFP2(u32 instruction) {
     INST(&V::vfp2_VADD,           "VADD",                    "cccc11100D11nnnndddd101zN0M0mmmm"),
     INST(&V::vfp2_VSUB,           "VSUB",                    "cccc11100D11nnnndddd101zN1M0mmmm"),
     INST(&V::vfp2_VDIV,           "VDIV",                    "cccc11101D00nnnndddd101zN0M0mmmm"),
+    INST(&V::vfp2_VFNMS,          "VFNMS",                   "cccc11101D01nnnndddd101zN0M0mmmm"),
+    INST(&V::vfp2_VFNMA,          "VFNMA",                   "cccc11101D01nnnndddd101zN1M0mmmm"),
+    INST(&V::vfp2_VFMA,           "VFMA",                    "cccc11101D10nnnndddd101zN0M0mmmm"),
+    INST(&V::vfp2_VFMS,           "VFMS",                    "cccc11101D10nnnndddd101zN1M0mmmm"),
 
     // Floating-point move instructions
     INST(&V::vfp2_VMOV_u32_f64,   "VMOV (core to f64)",      "cccc11100000ddddtttt1011D0010000"),
@@ -78,14 +83,17 @@ boost::optional<const VFP2Matcher<V>&> DecodeVFP2(u32 instruction) {
 #undef INST
 
     };
+}
+
+template<typename V>
+boost::optional<const VFP2Matcher<V>&> DecodeVFP2(u32 instruction) {
+    // Bits 27:20 and 11:8 discriminate between almost all VFP instructions.
+    const static DecodeTable<VFP2Matcher<V>> table{GetVFP2DecodeTable<V>(), 0x0FF00F00};
 
     if ((instruction & 0xF0000000) == 0xF0000000)
         return boost::none; // Don't try matching any unconditional instructions.
 
-    const auto matches_instruction = [instruction](const auto& matcher){ return matcher.Matches(instruction); };
-
-    auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-    return iter != table.end() ? boost::make_optional<const VFP2Matcher<V>&>(*iter) : boost::none;
+    return table.Decode(instruction);
 }
 
 } // namespace Arm
@@ -14,6 +14,7 @@
 #include "common/string_util.h"
 #include "frontend/arm/types.h"
 #include "frontend/decoder/arm.h"
+#include "frontend/decoder/asimd.h"
 #include "frontend/decoder/vfp2.h"
 #include "frontend/disassembler/disassembler.h"
 
@@ -107,6 +108,29 @@ public:
         return cond == Cond::NV ? "2" : CondToString(cond);
     }
 
+    std::string BarrierOptionStr(Imm4 option) {
+        switch (option) {
+        case 0b0010:
+            return "oshst";
+        case 0b0011:
+            return "osh";
+        case 0b0110:
+            return "nshst";
+        case 0b0111:
+            return "nsh";
+        case 0b1010:
+            return "ishst";
+        case 0b1011:
+            return "ish";
+        case 0b1110:
+            return "st";
+        case 0b1111:
+            return "sy";
+        default:
+            return fmt::format("#{}", option);
+        }
+    }
+
     // Branch instructions
     std::string arm_B(Cond cond, Imm24 imm24) {
         s32 offset = Common::SignExtend<26, s32>(imm24 << 2) + 8;
@@ -252,6 +276,12 @@ public:
     std::string arm_MOV_rsr(Cond cond, bool S, Reg d, Reg s, ShiftType shift, Reg m) {
         return fmt::format("mov{}{} {}, {}", CondToString(cond), S ? "s" : "", d, RsrStr(s, shift, m));
     }
+    std::string arm_MOVT(Cond cond, Imm4 imm4, Reg d, Imm12 imm12) {
+        return fmt::format("movt{} {}, #{}", CondToString(cond), d, (imm4 << 12) | imm12);
+    }
+    std::string arm_MOVW(Cond cond, Imm4 imm4, Reg d, Imm12 imm12) {
+        return fmt::format("movw{} {}, #{}", CondToString(cond), d, (imm4 << 12) | imm12);
+    }
     std::string arm_MVN_imm(Cond cond, bool S, Reg d, int rotate, Imm8 imm8) {
         return fmt::format("mvn{}{} {}, #{}", CondToString(cond), S ? "s" : "", d, ArmExpandImm(rotate, imm8));
     }
@@ -325,6 +355,20 @@ public:
         return fmt::format("tst{} {}, {}", CondToString(cond), n, RsrStr(s, shift, m));
     }
 
+    // Bitfield instructions
+    std::string arm_BFC(Cond cond, Imm5 msb, Reg d, Imm5 lsb) {
+        return fmt::format("bfc{} {}, #{}, #{}", CondToString(cond), d, lsb, msb - lsb + 1);
+    }
+    std::string arm_BFI(Cond cond, Imm5 msb, Reg d, Imm5 lsb, Reg n) {
+        return fmt::format("bfi{} {}, {}, #{}, #{}", CondToString(cond), d, n, lsb, msb - lsb + 1);
+    }
+    std::string arm_SBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n) {
+        return fmt::format("sbfx{} {}, {}, #{}, #{}", CondToString(cond), d, n, lsb, widthm1 + 1);
+    }
+    std::string arm_UBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n) {
+        return fmt::format("ubfx{} {}, {}, #{}, #{}", CondToString(cond), d, n, lsb, widthm1 + 1);
+    }
+
     // Exception generation instructions
     std::string arm_BKPT(Cond cond, Imm12 imm12, Imm4 imm4) {
         return fmt::format("bkpt{} #{}", CondToString(cond), imm12 << 4 | imm4);
@@ -376,10 +420,15 @@ public:
 
     // Hint instructions
     std::string arm_PLD() { return "pld <unimplemented>"; }
-    std::string arm_SEV() { return "sev <unimplemented>"; }
-    std::string arm_WFE() { return "wfe <unimplemented>"; }
-    std::string arm_WFI() { return "wfi <unimplemented>"; }
-    std::string arm_YIELD() { return "yield <unimplemented>"; }
+    std::string arm_SEV(Cond cond) { return fmt::format("sev{}", CondToString(cond)); }
+    std::string arm_WFE(Cond cond) { return fmt::format("wfe{}", CondToString(cond)); }
+    std::string arm_WFI(Cond cond) { return fmt::format("wfi{}", CondToString(cond)); }
+    std::string arm_YIELD(Cond cond) { return fmt::format("yield{}", CondToString(cond)); }
+
+    // Barrier instructions
+    std::string arm_DMB(Imm4 option) { return fmt::format("dmb {}", BarrierOptionStr(option)); }
+    std::string arm_DSB(Imm4 option) { return fmt::format("dsb {}", BarrierOptionStr(option)); }
+    std::string arm_ISB(Imm4 option) { return option == 0b1111 ? "isb sy" : fmt::format("isb #{}", option); }
 
     // Load/Store instructions
     std::string arm_LDR_lit(Cond cond, bool U, Reg t, Imm12 imm12) {
@@ -574,7 +623,10 @@ public:
         return fmt::format("ldmib{} {}{}, {{{}}}", CondToString(cond), n, W ? "!" : "", list);
     }
     std::string arm_LDM_usr() { return "ice"; }
-    std::string arm_LDM_eret() { return "ice"; }
+    std::string arm_LDM_eret(Cond cond, bool P, bool U, bool W, Reg n, RegList list) {
+        const char* mode = U ? (P ? "ib" : "") : (P ? "db" : "da");
+        return fmt::format("ldm{}{} {}{}, {{{}}}^", mode, CondToString(cond), n, W ? "!" : "", RegListToString(list | 0x8000));
+    }
     std::string arm_STM(Cond cond, bool W, Reg n, RegList list) {
         return fmt::format("stm{} {}{}, {{{}}}", CondToString(cond), n, W ? "!" : "", list);
     }
@@ -626,6 +678,9 @@ public:
     std::string arm_REVSH(Cond cond, Reg d, Reg m) {
         return fmt::format("revsh{} {}, {}", CondToString(cond), d, m);
     }
+    std::string arm_RBIT(Cond cond, Reg d, Reg m) {
+        return fmt::format("rbit{} {}, {}", CondToString(cond), d, m);
+    }
 
     // Saturation instructions
     std::string arm_SSAT(Cond cond, Imm5 sat_imm, Reg d, Imm5 imm5, bool sh, Reg n) {
@@ -645,6 +700,9 @@ public:
     std::string arm_MLA(Cond cond, bool S, Reg d, Reg a, Reg m, Reg n) {
         return fmt::format("mla{}{} {}, {}, {}, {}", S ? "s" : "", CondToString(cond), d, n, m, a);
     }
+    std::string arm_MLS(Cond cond, Reg d, Reg a, Reg m, Reg n) {
+        return fmt::format("mls{} {}, {}, {}, {}", CondToString(cond), d, n, m, a);
+    }
     std::string arm_MUL(Cond cond, bool S, Reg d, Reg m, Reg n) {
         return fmt::format("mul{}{} {}, {}, {}", S ? "s" : "", CondToString(cond), d, n, m);
     }
@@ -716,6 +774,14 @@ public:
         return fmt::format("smusd{}{} {}, {}, {}", M ? "x" : "", CondToString(cond), d, n, m);
     }
 
+    // Divide instructions
+    std::string arm_SDIV(Cond cond, Reg d, Reg m, Reg n) {
+        return fmt::format("sdiv{} {}, {}, {}", CondToString(cond), d, n, m);
+    }
+    std::string arm_UDIV(Cond cond, Reg d, Reg m, Reg n) {
+        return fmt::format("udiv{} {}, {}, {}", CondToString(cond), d, n, m);
+    }
+
     // Parallel Add/Subtract (Modulo arithmetic) instructions
     std::string arm_SADD8(Cond cond, Reg n, Reg d, Reg m) {
         return fmt::format("sadd8{} {}, {}, {}", CondToString(cond), d, n, m);
@@ -880,21 +946,36 @@ public:
     }
 
     // Status register access instructions
-    std::string arm_CPS() { return "ice"; }
-    std::string arm_MRS(Cond cond, Reg d) {
-        return fmt::format("mrs{} {}, apsr", CondToString(cond), d);
+    std::string arm_CPS(int imod, bool M, bool A, bool I, bool F, int mode) {
+        const char* effect = imod == 0b10 ? "ie" : imod == 0b11 ? "id" : "";
+        const std::string flags = fmt::format("{}{}{}", A ? "a" : "", I ? "i" : "", F ? "f" : "");
+        if (!M)
+            return fmt::format("cps{} {}", effect, flags);
+        if (flags.empty())
+            return fmt::format("cps #{}", mode);
+        return fmt::format("cps{} {}, #{}", effect, flags, mode);
+    }
+    std::string arm_MRS(Cond cond, bool R, Reg d) {
+        return fmt::format("mrs{} {}, {}", CondToString(cond), d, R ? "spsr" : "apsr");
+    }
+    static std::string PsrFieldsToString(bool R, int mask) {
+        if (!R && (mask & 0b0011) == 0) {
+            bool write_nzcvq = Common::Bit<3>(mask);
+            bool write_g = Common::Bit<2>(mask);
+            return fmt::format("apsr_{}{}", write_nzcvq ? "nzcvq" : "", write_g ? "g" : "");
+        }
+        return fmt::format("{}_{}{}{}{}", R ? "spsr" : "cpsr", Common::Bit<3>(mask) ? "f" : "", Common::Bit<2>(mask) ? "s" : "", Common::Bit<1>(mask) ? "x" : "", Common::Bit<0>(mask) ? "c" : "");
+    }
+    std::string arm_MSR_imm(Cond cond, bool R, int mask, int rotate, Imm8 imm8) {
+        return fmt::format("msr{} {}, #{}", CondToString(cond), PsrFieldsToString(R, mask), ArmExpandImm(rotate, imm8));
     }
-    std::string arm_MSR_imm(Cond cond, int mask, int rotate, Imm8 imm8) {
-        bool write_nzcvq = Common::Bit<1>(mask);
-        bool write_g = Common::Bit<0>(mask);
-        return fmt::format("msr{} apsr_{}{}, #{}", CondToString(cond), write_nzcvq ? "nzcvq" : "", write_g ? "g" : "", ArmExpandImm(rotate, imm8));
+    std::string arm_MSR_reg(Cond cond, bool R, int mask, Reg n) {
+        return fmt::format("msr{} {}, {}", CondToString(cond), PsrFieldsToString(R, mask), n);
     }
-    std::string arm_MSR_reg(Cond cond, int mask, Reg n) {
-        bool write_nzcvq = Common::Bit<1>(mask);
-        bool write_g = Common::Bit<0>(mask);
-        return fmt::format("msr{} apsr_{}{}, {}", CondToString(cond), write_nzcvq ? "nzcvq" : "", write_g ? "g" : "", n);
+    std::string arm_RFE(bool P, bool U, bool W, Reg n) {
+        const char* mode = U ? (P ? "ib" : "ia") : (P ? "db" : "da");
+        return fmt::format("rfe{} {}{}", mode, n, W ? "!" : "");
     }
-    std::string arm_RFE() { return "ice"; }
     std::string arm_SETEND(bool E) {
         return E ? "setend be" : "setend le";
     }
@@ -937,6 +1018,22 @@ public:
         return fmt::format("vdiv{}.{} {}, {}, {}", CondToString(cond), sz ? "f64" : "f32", FPRegStr(sz, Vd, D), FPRegStr(sz, Vn, N), FPRegStr(sz, Vm, M));
     }
 
+    std::string vfp2_VFMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+        return fmt::format("vfma{}.{} {}, {}, {}", CondToString(cond), sz ? "f64" : "f32", FPRegStr(sz, Vd, D), FPRegStr(sz, Vn, N), FPRegStr(sz, Vm, M));
+    }
+
+    std::string vfp2_VFMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+        return fmt::format("vfms{}.{} {}, {}, {}", CondToString(cond), sz ? "f64" : "f32", FPRegStr(sz, Vd, D), FPRegStr(sz, Vn, N), FPRegStr(sz, Vm, M));
+    }
+
+    std::string vfp2_VFNMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+        return fmt::format("vfnma{}.{} {}, {}, {}", CondToString(cond), sz ? "f64" : "f32", FPRegStr(sz, Vd, D), FPRegStr(sz, Vn, N), FPRegStr(sz, Vm, M));
+    }
+
+    std::string vfp2_VFNMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+        return fmt::format("vfnms{}.{} {}, {}, {}", CondToString(cond), sz ? "f64" : "f32", FPRegStr(sz, Vd, D), FPRegStr(sz, Vn, N), FPRegStr(sz, Vm, M));
+    }
+
     std::string vfp2_VMOV_u32_f64(Cond cond, size_t Vd, Reg t, bool D){
         return fmt::format("vmov{}.32 {}, {}", CondToString(cond), FPRegStr(true, Vd, D), t);
     }
@@ -1066,12 +1163,67 @@ public:
         return fmt::format("vldm{}{}.f32 {}{}, {}(+{})", mode, CondToString(cond), n, w ? "!" : "", FPRegStr(false, Vd, D), imm8);
     }
 
+    // Advanced SIMD three register instructions
+    static std::string VectorStr(bool Q, size_t base, bool bit) {
+        return Q ? fmt::format("q{}", (base >> 1) + (bit ? 8 : 0)) : fmt::format("d{}", base + (bit ? 16 : 0));
+    }
+
+    std::string asimd_VAND_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vand {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VBIC_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vbic {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VORR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vorr {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VORN_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vorn {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VEOR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("veor {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VBSL(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vbsl {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VBIT(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vbit {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VBIF(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vbif {}, {}, {}", VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VADD_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vadd.i{} {}, {}, {}", 8 << sz, VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VSUB_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vsub.i{} {}, {}, {}", 8 << sz, VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+    std::string asimd_VMUL_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+        return fmt::format("vmul.i{} {}, {}, {}", 8 << sz, VectorStr(Q, Vd, D), VectorStr(Q, Vn, N), VectorStr(Q, Vm, M));
+    }
+
+    // Advanced SIMD load-store instructions
+    std::string asimd_VST1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m) {
+        const char* writeback = m == Reg::SP ? "!" : "";
+        if (m != Reg::PC && m != Reg::SP)
+            return fmt::format("vst1.{} {{{}}}(type {}), [{}], {}", 8 << sz, VectorStr(false, Vd, D), type, n, m);
+        return fmt::format("vst1.{} {{{}}}(type {}), [{}]{}", 8 << sz, VectorStr(false, Vd, D), type, n, writeback);
+    }
+    std::string asimd_VLD1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m) {
+        const char* writeback = m == Reg::SP ? "!" : "";
+        if (m != Reg::PC && m != Reg::SP)
+            return fmt::format("vld1.{} {{{}}}(type {}), [{}], {}", 8 << sz, VectorStr(false, Vd, D), type, n, m);
+        return fmt::format("vld1.{} {{{}}}(type {}), [{}]{}", 8 << sz, VectorStr(false, Vd, D), type, n, writeback);
+    }
+
 };
 
 std::string DisassembleArm(u32 instruction) {
     DisassemblerVisitor visitor;
     if (auto vfp_decoder = DecodeVFP2<DisassemblerVisitor>(instruction)) {
         return vfp_decoder->call(visitor, instruction);
+    } else if (auto asimd_decoder = DecodeASIMD<DisassemblerVisitor>(instruction)) {
+        return asimd_decoder->call(visitor, instruction);
     } else if (auto decoder = DecodeArm<DisassemblerVisitor>(instruction)) {
         return decoder->call(visitor, instruction);
     } else {
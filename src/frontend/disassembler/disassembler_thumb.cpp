@@ -290,6 +290,21 @@ public:
         return fmt::format("revsh {}, {}", d, m);
     }
 
+    std::string thumb16_IT(Cond firstcond, Imm4 mask) {
+        if (mask == 0) {
+            static const char* const hints[] = {"nop", "yield", "wfe", "wfi", "sev"};
+            const size_t hint = static_cast<size_t>(firstcond);
+            return hint < 5 ? hints[hint] : fmt::format("hint #{}", hint);
+        }
+
+        std::string suffix;
+        const bool firstcond0 = Common::Bit<0>(static_cast<u32>(firstcond));
+        for (size_t i = 3; (mask & ((1u << i) - 1)) != 0; i--) {
+            suffix += Common::Bit(i, mask) == firstcond0 ? 't' : 'e';
+        }
+        return fmt::format("it{} {}", suffix, CondToString(firstcond));
+    }
+
     std::string thumb16_STMIA(Reg n, RegList reg_list) {
         return fmt::format("stm {}!, {}", n, reg_list);
     }
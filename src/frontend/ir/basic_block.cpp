@@ -7,7 +7,10 @@
 #include <algorithm>
 #include <initializer_list>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -19,6 +22,36 @@
 namespace Dynarmic {
 namespace IR {
 
+// Number of instructions per slab of an instruction pool. Blocks rarely need more than one slab.
+constexpr size_t instruction_pool_slab_size = 4096;
+// More pools than this are freed rather than kept, e.g. after many blocks were alive at once.
+constexpr size_t max_recycled_instruction_pools = 8;
+
+static std::vector<std::unique_ptr<Common::Pool>>& RecycledInstructionPools() {
+    thread_local std::vector<std::unique_ptr<Common::Pool>> pools;
+    return pools;
+}
+
+Block::InstructionPool Block::AcquireInstructionPool() {
+    auto& pools = RecycledInstructionPools();
+    if (pools.empty())
+        return InstructionPool{new Common::Pool(sizeof(Inst), instruction_pool_slab_size)};
+    InstructionPool pool{pools.back().release()};
+    pools.pop_back();
+    return pool;
+}
+
+void Block::InstructionPoolDeleter::operator()(Common::Pool* pool) const {
+    auto& pools = RecycledInstructionPools();
+    if (pools.size() >= max_recycled_instruction_pools) {
+        delete pool;
+        return;
+    }
+    // Instructions are never destroyed individually, so their memory can simply be reused.
+    pool->Shrink();
+    pools.emplace_back(pool);
+}
+
 void Block::AppendNewInst(Opcode opcode, std::initializer_list<IR::Value> args) {
     IR::Inst* inst = new(instruction_alloc_pool->Alloc()) IR::Inst(opcode);
     DEBUG_ASSERT(args.size() == inst->NumArgs());
@@ -31,10 +64,59 @@ void Block::AppendNewInst(Opcode opcode, std::initializer_list<IR::Value> args)
     instructions.push_back(inst);
 }
 
+Block::iterator Block::PrependNewInst(iterator insertion_point, Opcode opcode, std::initializer_list<IR::Value> args) {
+    IR::Inst* inst = new(instruction_alloc_pool->Alloc()) IR::Inst(opcode);
+    DEBUG_ASSERT(args.size() == inst->NumArgs());
+
+    std::for_each(args.begin(), args.end(), [&inst, index = size_t(0)](const auto& arg) mutable {
+        inst->SetArg(index, arg);
+        index++;
+    });
+
+    // The new instruction takes the place of, and so belongs to the same guest instruction as, its neighbour.
+    if (insertion_point != instructions.end()) {
+        inst->SetGuestPC(insertion_point->GuestPC());
+    } else if (!instructions.empty()) {
+        inst->SetGuestPC(instructions.back().GuestPC());
+    }
+
+    return instructions.insert_before(insertion_point, inst);
+}
+
 LocationDescriptor Block::Location() const {
     return location;
 }
 
+const std::vector<std::pair<u32, u32>>& Block::GuestRanges() const {
+    return guest_ranges;
+}
+
+void Block::AppendGuestRange(u32 start_pc, u32 end_pc) {
+    guest_ranges.emplace_back(start_pc, end_pc);
+}
+
+bool Block::ContainsGuestAddress(u32 pc) const {
+    return std::any_of(guest_ranges.begin(), guest_ranges.end(), [pc](const auto& range) {
+        return pc >= range.first && pc < range.second;
+    });
+}
+
+const std::vector<std::pair<u32, u32>>& Block::FoldedDataRanges() const {
+    return folded_data_ranges;
+}
+
+void Block::AppendFoldedDataRange(u32 start, u32 end) {
+    folded_data_ranges.emplace_back(start, end);
+}
+
+bool Block::HasFoldedCoprocessorConstant() const {
+    return folded_coprocessor_constant;
+}
+
+void Block::SetFoldedCoprocessorConstant() {
+    folded_coprocessor_constant = true;
+}
+
 Arm::Cond Block::GetCondition() const {
     return cond;
 }
@@ -51,6 +133,22 @@ void Block::SetConditionFailedLocation(LocationDescriptor fail_location) {
     cond_failed = fail_location;
 }
 
+bool Block::HasBreakpoint() const {
+    return breakpoint;
+}
+
+void Block::SetBreakpoint() {
+    breakpoint = true;
+}
+
+const std::vector<std::pair<Arm::Reg, u32>>& Block::RegisterGuards() const {
+    return register_guards;
+}
+
+void Block::AddRegisterGuard(Arm::Reg reg, u32 value) {
+    register_guards.emplace_back(reg, value);
+}
+
 size_t& Block::ConditionFailedCycleCount() {
     return cond_failed_cycle_count;
 }
@@ -71,13 +169,18 @@ const Block::InstructionList& Block::Instructions() const {
     return instructions;
 }
 
-Terminal Block::GetTerminal() const {
+const Terminal& Block::GetTerminal() const {
     return terminal;
 }
 
 void Block::SetTerminal(Terminal term) {
     ASSERT_MSG(!HasTerminal(), "Terminal has already been set.");
-    terminal = term;
+    terminal = std::move(term);
+}
+
+void Block::ReplaceTerminal(Terminal term) {
+    ASSERT_MSG(HasTerminal(), "Terminal has not been set.");
+    terminal = std::move(term);
 }
 
 bool Block::HasTerminal() const {
@@ -92,6 +195,11 @@ const size_t& Block::CycleCount() const {
     return cycle_count;
 }
 
+size_t Block::AllocatedBytes() const {
+    return instruction_alloc_pool->AllocatedBytes() + guest_ranges.capacity() * sizeof(guest_ranges[0])
+           + folded_data_ranges.capacity() * sizeof(folded_data_ranges[0]);
+}
+
 static std::string TerminalToString(const Terminal& terminal_variant) {
     switch (terminal_variant.which()) {
     case 1: {
@@ -134,6 +242,12 @@ std::string DumpBlock(const IR::Block& block) {
     if (block.GetCondition() != Arm::Cond::AL) {
         ret += fmt::format(", cond_fail={}", block.ConditionFailedLocation());
     }
+    if (block.HasBreakpoint()) {
+        ret += ", breakpoint";
+    }
+    for (const auto& guard : block.RegisterGuards()) {
+        ret += fmt::format(", {}=#{:#x}", Arm::RegToString(guard.first), guard.second);
+    }
     ret += '\n';
 
     std::map<const IR::Inst*, size_t> inst_to_index;
@@ -9,6 +9,8 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/optional.hpp>
 
@@ -76,8 +78,35 @@ public:
      */
     void AppendNewInst(Opcode op, std::initializer_list<Value> args);
 
+    /**
+     * Prepends a new instruction to this basic block before the insertion point,
+     * handling any allocations necessary to do so.
+     *
+     * @param insertion_point Where to insert the new instruction.
+     * @param op              Opcode representing the instruction to add.
+     * @param args            A sequence of Value instances used as arguments for the instruction.
+     * @returns Iterator to the newly created instruction.
+     */
+    iterator PrependNewInst(iterator insertion_point, Opcode op, std::initializer_list<Value> args);
+
     /// Gets the starting location for this basic block.
     LocationDescriptor Location() const;
+    /// Gets the ranges [first, second) of guest addresses translated into this basic block, in translation order.
+    /// A block has more than one range if translation continued at the target of a branch.
+    const std::vector<std::pair<u32, u32>>& GuestRanges() const;
+    /// Records that guest code in [start_pc, end_pc) was translated into this basic block.
+    void AppendGuestRange(u32 start_pc, u32 end_pc);
+    /// Determines whether or not the guest instruction at `pc` was translated into this basic block.
+    bool ContainsGuestAddress(u32 pc) const;
+
+    /// Gets the ranges [first, second) of read-only guest memory read at translation time and folded into this basic block.
+    const std::vector<std::pair<u32, u32>>& FoldedDataRanges() const;
+    /// Records that the read-only guest memory in [start, end) was folded into this basic block.
+    void AppendFoldedDataRange(u32 start, u32 end);
+    /// Determines whether or not the value of a coprocessor register declared constant was folded into this basic block.
+    bool HasFoldedCoprocessorConstant() const;
+    /// Records that the value of a coprocessor register declared constant was folded into this basic block.
+    void SetFoldedCoprocessorConstant();
 
     /// Gets the condition required to pass in order to execute this block.
     Arm::Cond GetCondition() const;
@@ -91,6 +120,16 @@ public:
     /// Determines whether or not a prediated condition failure block is present.
     bool HasConditionFailedLocation() const;
 
+    /// Determines whether or not execution stops at a breakpoint on entering this block, before its condition is tested.
+    bool HasBreakpoint() const;
+    /// Makes execution stop at a breakpoint on entering this block.
+    void SetBreakpoint();
+
+    /// Gets the values that guest registers are assumed to hold on entering this block (see Optimization::RegisterSpecialization).
+    const std::vector<std::pair<Arm::Reg, u32>>& RegisterGuards() const;
+    /// Assumes `reg` holds `value` on entering this block. Entering it otherwise leaves it before it has done anything.
+    void AddRegisterGuard(Arm::Reg reg, u32 value);
+
     /// Gets a mutable reference to the condition failed cycle count.
     size_t& ConditionFailedCycleCount();
     /// Gets an immutable reference to the condition failed cycle count.
@@ -102,9 +141,11 @@ public:
     const InstructionList& Instructions() const;
 
     /// Gets the terminal instruction for this basic block.
-    Terminal GetTerminal() const;
+    const Terminal& GetTerminal() const;
     /// Sets the terminal instruction for this basic block.
     void SetTerminal(Terminal term);
+    /// Replaces the terminal instruction for this basic block.
+    void ReplaceTerminal(Terminal term);
     /// Determines whether or not this basic block has a terminal instruction.
     bool HasTerminal() const;
 
@@ -113,20 +154,41 @@ public:
     /// Gets an immutable reference to the cycle count for this basic block.
     const size_t& CycleCount() const;
 
+    /// Bytes allocated for the instructions of this block.
+    size_t AllocatedBytes() const;
+
 private:
     /// Description of the starting location of this block
     LocationDescriptor location;
+    /// Ranges of guest code translated into this block
+    std::vector<std::pair<u32, u32>> guest_ranges;
+    /// Ranges of read-only guest memory folded into this block
+    std::vector<std::pair<u32, u32>> folded_data_ranges;
+    /// Whether a constant coprocessor register was folded into this block
+    bool folded_coprocessor_constant = false;
     /// Conditional to pass in order to execute this block
     Arm::Cond cond = Arm::Cond::AL;
     /// Block to execute next if `cond` did not pass.
     boost::optional<LocationDescriptor> cond_failed = {};
     /// Number of cycles this block takes to execute if the conditional fails.
     size_t cond_failed_cycle_count = 0;
+    /// Whether execution stops at a breakpoint on entering this block.
+    bool breakpoint = false;
+    /// Values guest registers are assumed to hold on entering this block.
+    std::vector<std::pair<Arm::Reg, u32>> register_guards;
+
+    /// Instruction pools are recycled: that of a destroyed block is reset and kept for the next block
+    /// constructed on the same thread, so translation does not allocate in steady state.
+    struct InstructionPoolDeleter {
+        void operator()(Common::Pool* pool) const;
+    };
+    using InstructionPool = std::unique_ptr<Common::Pool, InstructionPoolDeleter>;
+    static InstructionPool AcquireInstructionPool();
 
     /// List of instructions in this block.
     InstructionList instructions;
     /// Memory pool for instruction list
-    std::unique_ptr<Common::Pool> instruction_alloc_pool = std::make_unique<Common::Pool>(sizeof(Inst), 4096);
+    InstructionPool instruction_alloc_pool = AcquireInstructionPool();
     /// Terminal instruction of this block.
     Terminal terminal = Term::Invalid{};
 
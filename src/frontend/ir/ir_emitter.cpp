@@ -5,6 +5,7 @@
  */
 
 #include "common/assert.h"
+#include "common/bit_util.h"
 #include "frontend/ir/ir_emitter.h"
 #include "frontend/ir/opcodes.h"
 
@@ -75,6 +76,16 @@ void IREmitter::SetExtendedRegister(const Arm::ExtReg reg, const Value& value) {
     }
 }
 
+Value IREmitter::GetVector(Arm::ExtReg reg) {
+    ASSERT(Arm::IsDoubleExtReg(reg) || Arm::IsQuadExtReg(reg));
+    return Inst(Opcode::GetVector, {Value(reg)});
+}
+
+void IREmitter::SetVector(const Arm::ExtReg reg, const Value& value) {
+    ASSERT(Arm::IsDoubleExtReg(reg) || Arm::IsQuadExtReg(reg));
+    Inst(Opcode::SetVector, {Value(reg), value});
+}
+
 void IREmitter::ALUWritePC(const Value& value) {
     // This behaviour is ARM version-dependent.
     // The below implementation is for ARMv6k
@@ -91,6 +102,13 @@ void IREmitter::BranchWritePC(const Value& value) {
     }
 }
 
+void IREmitter::ExceptionReturnWritePC(const Value& value, const Value& new_cpsr) {
+    // The new PC is aligned according to the instruction set being returned to.
+    auto is_arm = IsZero(And(new_cpsr, Imm32(0x00000020)));
+    auto new_pc = ConditionalSelect32(is_arm, And(value, Imm32(0xFFFFFFFC)), And(value, Imm32(0xFFFFFFFE)));
+    Inst(Opcode::SetRegister, { Value(Arm::Reg::PC), new_pc });
+}
+
 void IREmitter::BXWritePC(const Value& value) {
     Inst(Opcode::BXWritePC, {value});
 }
@@ -105,10 +123,35 @@ void IREmitter::CallSupervisor(const Value& value) {
     Inst(Opcode::CallSupervisor, {value});
 }
 
+void IREmitter::CallHostFunction(const Value& host_function) {
+    Inst(Opcode::CallHostFunction, {host_function});
+}
+
+void IREmitter::CallHint(Hint hint) {
+    Inst(Opcode::CallHint, {Imm8(static_cast<u8>(hint))});
+}
+
+Value IREmitter::GetCycleCounter(const Value& cycles_before) {
+    return Inst(Opcode::GetCycleCounter, {cycles_before});
+}
+
+void IREmitter::SideExit(const Value& taken, const LocationDescriptor& target, const Value& cycles) {
+    ASSERT(target.SetPC(block.Location().PC()) == block.Location());
+    Inst(Opcode::SideExit, {taken, Imm32(target.PC()), cycles});
+}
+
 void IREmitter::PushRSB(const LocationDescriptor& return_location) {
     Inst(Opcode::PushRSB, {Value(return_location.UniqueHash())});
 }
 
+void IREmitter::ProfileCall(const Value& function, const Value& return_address, const Value& cycles_before) {
+    Inst(Opcode::ProfileCall, {function, return_address, cycles_before});
+}
+
+void IREmitter::ProfileReturn(const Value& target, const Value& cycles_before) {
+    Inst(Opcode::ProfileReturn, {target, cycles_before});
+}
+
 Value IREmitter::GetCpsr() {
     return Inst(Opcode::GetCpsr, {});
 }
@@ -117,6 +160,18 @@ void IREmitter::SetCpsr(const Value& value) {
     Inst(Opcode::SetCpsr, {value});
 }
 
+void IREmitter::SetCpsrAndSwitchMode(const Value& value) {
+    Inst(Opcode::SetCpsrAndSwitchMode, {value});
+}
+
+Value IREmitter::GetSpsr() {
+    return Inst(Opcode::GetSpsr, {});
+}
+
+void IREmitter::SetSpsr(const Value& value) {
+    Inst(Opcode::SetSpsr, {value});
+}
+
 Value IREmitter::GetCFlag() {
     return Inst(Opcode::GetCFlag, {});
 }
@@ -149,6 +204,10 @@ void IREmitter::SetGEFlags(const Value& value) {
     Inst(Opcode::SetGEFlags, {value});
 }
 
+Value IREmitter::TestCondition(Arm::Cond cond) {
+    return Inst(Opcode::TestCondition, {Imm8(static_cast<u8>(cond))});
+}
+
 Value IREmitter::GetFpscr() {
     return Inst(Opcode::GetFpscr, {});
 }
@@ -199,6 +258,14 @@ Value IREmitter::IsZero64(const Value& value) {
     return Inst(Opcode::IsZero64, {value});
 }
 
+Value IREmitter::ConditionalSelect32(const Value& cond, const Value& then_, const Value& else_) {
+    return Inst(Opcode::ConditionalSelect32, {cond, then_, else_});
+}
+
+Value IREmitter::ConditionalSelect1(const Value& cond, const Value& then_, const Value& else_) {
+    return Inst(Opcode::ConditionalSelect1, {cond, then_, else_});
+}
+
 IREmitter::ResultAndCarry IREmitter::LogicalShiftLeft(const Value& value_in, const Value& shift_amount, const Value& carry_in) {
     auto result = Inst(Opcode::LogicalShiftLeft, {value_in, shift_amount, carry_in});
     auto carry_out = Inst(Opcode::GetCarryFromOp, {result});
@@ -272,10 +339,22 @@ Value IREmitter::Mul64(const Value& a, const Value& b) {
     return Inst(Opcode::Mul64, {a, b});
 }
 
+Value IREmitter::SignedDiv(const Value& a, const Value& b) {
+    return Inst(Opcode::SignedDiv, {a, b});
+}
+
+Value IREmitter::UnsignedDiv(const Value& a, const Value& b) {
+    return Inst(Opcode::UnsignedDiv, {a, b});
+}
+
 Value IREmitter::And(const Value& a, const Value& b) {
     return Inst(Opcode::And, {a, b});
 }
 
+Value IREmitter::AndNot(const Value& a, const Value& b) {
+    return Inst(Opcode::AndNot, {a, b});
+}
+
 Value IREmitter::Eor(const Value& a, const Value& b) {
     return Inst(Opcode::Eor, {a, b});
 }
@@ -324,6 +403,10 @@ Value IREmitter::ByteReverseDual(const Value& a) {
     return Inst(Opcode::ByteReverseDual, {a});
 }
 
+Value IREmitter::BitReverseWord(const Value& a) {
+    return Inst(Opcode::BitReverseWord, {a});
+}
+
 Value IREmitter::CountLeadingZeros(const Value& a) {
     return Inst(Opcode::CountLeadingZeros, {a});
 }
@@ -402,6 +485,18 @@ IREmitter::ResultAndGE IREmitter::PackedSubS16(const Value& a, const Value& b) {
     return {result, ge};
 }
 
+IREmitter::ResultAndGE IREmitter::PackedSubAddU16(const Value& a, const Value& b, bool asx) {
+    auto result = Inst(Opcode::PackedSubAddU16, {a, b, Imm1(asx)});
+    auto ge = Inst(Opcode::GetGEFromOp, {result});
+    return {result, ge};
+}
+
+IREmitter::ResultAndGE IREmitter::PackedSubAddS16(const Value& a, const Value& b, bool asx) {
+    auto result = Inst(Opcode::PackedSubAddS16, {a, b, Imm1(asx)});
+    auto ge = Inst(Opcode::GetGEFromOp, {result});
+    return {result, ge};
+}
+
 Value IREmitter::PackedHalvingAddU8(const Value& a, const Value& b) {
     return Inst(Opcode::PackedHalvingAddU8, {a, b});
 }
@@ -478,6 +573,62 @@ Value IREmitter::PackedAbsDiffSumS8(const Value& a, const Value& b) {
     return Inst(Opcode::PackedAbsDiffSumS8, {a, b});
 }
 
+Value IREmitter::VectorAdd8(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorAdd8, {a, b});
+}
+
+Value IREmitter::VectorAdd16(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorAdd16, {a, b});
+}
+
+Value IREmitter::VectorAdd32(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorAdd32, {a, b});
+}
+
+Value IREmitter::VectorAdd64(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorAdd64, {a, b});
+}
+
+Value IREmitter::VectorSub8(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorSub8, {a, b});
+}
+
+Value IREmitter::VectorSub16(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorSub16, {a, b});
+}
+
+Value IREmitter::VectorSub32(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorSub32, {a, b});
+}
+
+Value IREmitter::VectorSub64(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorSub64, {a, b});
+}
+
+Value IREmitter::VectorMultiply16(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorMultiply16, {a, b});
+}
+
+Value IREmitter::VectorMultiply32(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorMultiply32, {a, b});
+}
+
+Value IREmitter::VectorAnd(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorAnd, {a, b});
+}
+
+Value IREmitter::VectorOr(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorOr, {a, b});
+}
+
+Value IREmitter::VectorEor(const Value& a, const Value& b) {
+    return Inst(Opcode::VectorEor, {a, b});
+}
+
+Value IREmitter::VectorNot(const Value& a) {
+    return Inst(Opcode::VectorNot, {a});
+}
+
 Value IREmitter::TransferToFP32(const Value& a) {
     return Inst(Opcode::TransferToFP32, {a});
 }
@@ -494,6 +645,18 @@ Value IREmitter::TransferFromFP64(const Value& a) {
     return Inst(Opcode::TransferFromFP64, {a});
 }
 
+Value IREmitter::FPPack2x32To1x64(const Value& lo, const Value& hi) {
+    return Inst(Opcode::FPPack2x32To1x64, {lo, hi});
+}
+
+Value IREmitter::FPLeastSignificantWord(const Value& a) {
+    return Inst(Opcode::FPLeastSignificantWord, {a});
+}
+
+Value IREmitter::FPMostSignificantWord(const Value& a) {
+    return Inst(Opcode::FPMostSignificantWord, {a});
+}
+
 Value IREmitter::FPAbs32(const Value& a) {
     return Inst(Opcode::FPAbs32, {a});
 }
@@ -542,6 +705,16 @@ Value IREmitter::FPMul64(const Value& a, const Value& b, bool fpscr_controlled)
     return Inst(Opcode::FPMul64, {a, b});
 }
 
+Value IREmitter::FPMulAdd32(const Value& addend, const Value& a, const Value& b, bool fpscr_controlled) {
+    ASSERT(fpscr_controlled);
+    return Inst(Opcode::FPMulAdd32, {addend, a, b});
+}
+
+Value IREmitter::FPMulAdd64(const Value& addend, const Value& a, const Value& b, bool fpscr_controlled) {
+    ASSERT(fpscr_controlled);
+    return Inst(Opcode::FPMulAdd64, {addend, a, b});
+}
+
 Value IREmitter::FPNeg32(const Value& a) {
     return Inst(Opcode::FPNeg32, {a});
 }
@@ -622,6 +795,10 @@ void IREmitter::ClearExclusive() {
     Inst(Opcode::ClearExclusive, {});
 }
 
+void IREmitter::DataMemoryBarrier() {
+    Inst(Opcode::DataMemoryBarrier, {});
+}
+
 void IREmitter::SetExclusive(const Value& vaddr, size_t byte_size) {
     ASSERT(byte_size == 1 || byte_size == 2 || byte_size == 4 || byte_size == 8 || byte_size == 16);
     Inst(Opcode::SetExclusive, {vaddr, Imm8(u8(byte_size))});
@@ -646,6 +823,11 @@ Value IREmitter::ReadMemory64(const Value& vaddr) {
     return current_location.EFlag() ? ByteReverseDual(value) : value;
 }
 
+Value IREmitter::ReadMemory128(const Value& vaddr) {
+    ASSERT(!current_location.EFlag());
+    return Inst(Opcode::ReadMemory128, {vaddr});
+}
+
 void IREmitter::WriteMemory8(const Value& vaddr, const Value& value) {
     Inst(Opcode::WriteMemory8, {vaddr, value});
 }
@@ -677,6 +859,117 @@ void IREmitter::WriteMemory64(const Value& vaddr, const Value& value) {
     }
 }
 
+void IREmitter::WriteMemory128(const Value& vaddr, const Value& value) {
+    ASSERT(!current_location.EFlag());
+    Inst(Opcode::WriteMemory128, {vaddr, value});
+}
+
+void IREmitter::ReadMemoryToRegisters(const Value& vaddr, Arm::RegList list) {
+    ASSERT(list != 0 && !Common::Bit<15>(list));
+    if (!current_location.EFlag()) {
+        Inst(Opcode::ReadMemoryToRegisters, {vaddr, Imm32(list)});
+        return;
+    }
+
+    // Big-endian accesses are byte-reversed one word at a time.
+    auto address = vaddr;
+    for (size_t i = 0; i <= 14; i++) {
+        if (Common::Bit(i, list)) {
+            SetRegister(static_cast<Arm::Reg>(i), ReadMemory32(address));
+            address = Add(address, Imm32(4));
+        }
+    }
+}
+
+void IREmitter::WriteMemoryFromRegisters(const Value& vaddr, Arm::RegList list) {
+    ASSERT(list != 0 && !Common::Bit<15>(list));
+    if (!current_location.EFlag()) {
+        Inst(Opcode::WriteMemoryFromRegisters, {vaddr, Imm32(list)});
+        return;
+    }
+
+    // Big-endian accesses are byte-reversed one word at a time.
+    auto address = vaddr;
+    for (size_t i = 0; i <= 14; i++) {
+        if (Common::Bit(i, list)) {
+            WriteMemory32(address, GetRegister(static_cast<Arm::Reg>(i)));
+            address = Add(address, Imm32(4));
+        }
+    }
+}
+
+void IREmitter::ReadMemoryToExtRegisters(const Value& vaddr, Arm::ExtReg first, size_t count) {
+    ASSERT(count != 0 && count <= 32);
+    if (!current_location.EFlag()) {
+        Inst(Opcode::ReadMemoryToExtRegisters, {vaddr, Value(first), Imm8(static_cast<u8>(count))});
+        return;
+    }
+
+    // Big-endian accesses are byte-reversed one word at a time, and the words of a double are swapped.
+    auto address = vaddr;
+    for (size_t i = 0; i < count; i++) {
+        if (Arm::IsDoubleExtReg(first)) {
+            auto hi = ReadMemory32(address);
+            address = Add(address, Imm32(4));
+            auto lo = ReadMemory32(address);
+            address = Add(address, Imm32(4));
+            SetExtendedRegister(first + i, TransferToFP64(Pack2x32To1x64(lo, hi)));
+        } else {
+            SetExtendedRegister(first + i, TransferToFP32(ReadMemory32(address)));
+            address = Add(address, Imm32(4));
+        }
+    }
+}
+
+void IREmitter::WriteMemoryFromExtRegisters(const Value& vaddr, Arm::ExtReg first, size_t count) {
+    ASSERT(count != 0 && count <= 32);
+    if (!current_location.EFlag()) {
+        Inst(Opcode::WriteMemoryFromExtRegisters, {vaddr, Value(first), Imm8(static_cast<u8>(count))});
+        return;
+    }
+
+    // Big-endian accesses are byte-reversed one word at a time, and the words of a double are swapped.
+    auto address = vaddr;
+    for (size_t i = 0; i < count; i++) {
+        if (Arm::IsDoubleExtReg(first)) {
+            auto value = TransferFromFP64(GetExtendedRegister(first + i));
+            WriteMemory32(address, MostSignificantWord(value).result);
+            address = Add(address, Imm32(4));
+            WriteMemory32(address, LeastSignificantWord(value));
+            address = Add(address, Imm32(4));
+        } else {
+            WriteMemory32(address, TransferFromFP32(GetExtendedRegister(first + i)));
+            address = Add(address, Imm32(4));
+        }
+    }
+}
+
+Value IREmitter::ExclusiveReadMemory8(const Value& vaddr) {
+    return Inst(Opcode::ExclusiveReadMemory8, {vaddr});
+}
+
+Value IREmitter::ExclusiveReadMemory16(const Value& vaddr) {
+    auto value = Inst(Opcode::ExclusiveReadMemory16, {vaddr});
+    return current_location.EFlag() ? ByteReverseHalf(value) : value;
+}
+
+Value IREmitter::ExclusiveReadMemory32(const Value& vaddr) {
+    auto value = Inst(Opcode::ExclusiveReadMemory32, {vaddr});
+    return current_location.EFlag() ? ByteReverseWord(value) : value;
+}
+
+std::pair<Value, Value> IREmitter::ExclusiveReadMemory64(const Value& vaddr) {
+    auto value = Inst(Opcode::ExclusiveReadMemory64, {vaddr});
+    auto lo = LeastSignificantWord(value);
+    auto hi = MostSignificantWord(value).result;
+    if (current_location.EFlag()) {
+        // DO NOT SWAP hi AND lo IN BIG ENDIAN MODE, THIS IS CORRECT BEHAVIOUR
+        lo = ByteReverseWord(lo);
+        hi = ByteReverseWord(hi);
+    }
+    return std::make_pair(lo, hi);
+}
+
 Value IREmitter::ExclusiveWriteMemory8(const Value& vaddr, const Value& value) {
     return Inst(Opcode::ExclusiveWriteMemory8, {vaddr, value});
 }
@@ -793,6 +1086,7 @@ void IREmitter::SetTerm(const Terminal& terminal) {
 
 Value IREmitter::Inst(Opcode op, std::initializer_list<Value> args) {
     block.AppendNewInst(op, args);
+    block.back().SetGuestPC(current_location.PC());
     return Value(&block.back());
 }
 
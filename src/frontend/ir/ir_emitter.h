@@ -7,7 +7,9 @@
 #pragma once
 
 #include <initializer_list>
+#include <utility>
 
+#include <dynarmic/callbacks.h>
 #include <dynarmic/coprocessor_util.h>
 
 #include "common/common_types.h"
@@ -74,16 +76,37 @@ public:
     Value GetExtendedRegister(Arm::ExtReg source_reg);
     void SetRegister(const Arm::Reg dest_reg, const Value& value);
     void SetExtendedRegister(const Arm::ExtReg dest_reg, const Value& value);
+    /// Reads a D or Q register as a vector. The upper half of the vector read from a D register is zero.
+    Value GetVector(Arm::ExtReg source_reg);
+    /// Writes a vector to a D or Q register. Only the lower half of the vector is written to a D register.
+    void SetVector(Arm::ExtReg dest_reg, const Value& value);
 
     void ALUWritePC(const Value& value);
     void BranchWritePC(const Value& value);
     void BXWritePC(const Value& value);
     void LoadWritePC(const Value& value);
+    /// Writes PC for a return to the instruction set state in new_cpsr, as for an exception return.
+    void ExceptionReturnWritePC(const Value& value, const Value& new_cpsr);
     void CallSupervisor(const Value& value);
+    void CallHostFunction(const Value& host_function);
+    void CallHint(Hint hint);
+    /// The low word of the guest cycle counter, plus cycles_before: the cycles of the block before this instruction.
+    Value GetCycleCounter(const Value& cycles_before);
+    /// Leaves the block for `target`, which differs from the block's location only in its PC, if `taken`
+    /// is true. The guest state is then that of this point, and `cycles` those of the block up to here.
+    void SideExit(const Value& taken, const LocationDescriptor& target, const Value& cycles);
     void PushRSB(const LocationDescriptor& return_location);
+    /// For call profiling: a call to `function` that returns to return_address, made after cycles_before
+    /// cycles of the block.
+    void ProfileCall(const Value& function, const Value& return_address, const Value& cycles_before);
+    /// For call profiling: a return to target, made after cycles_before cycles of the block.
+    void ProfileReturn(const Value& target, const Value& cycles_before);
 
     Value GetCpsr();
     void SetCpsr(const Value& value);
+    void SetCpsrAndSwitchMode(const Value& value);
+    Value GetSpsr();
+    void SetSpsr(const Value& value);
     Value GetCFlag();
     void SetNFlag(const Value& value);
     void SetZFlag(const Value& value);
@@ -92,6 +115,8 @@ public:
     void OrQFlag(const Value& value);
     Value GetGEFlags();
     void SetGEFlags(const Value& value);
+    /// Evaluates `cond` against the current NZCV flags.
+    Value TestCondition(Arm::Cond cond);
 
     Value GetFpscr();
     void SetFpscr(const Value& new_fpscr);
@@ -106,6 +131,9 @@ public:
     Value MostSignificantBit(const Value& value);
     Value IsZero(const Value& value);
     Value IsZero64(const Value& value);
+    /// Returns `then_` if `cond` is set, otherwise `else_`.
+    Value ConditionalSelect32(const Value& cond, const Value& then_, const Value& else_);
+    Value ConditionalSelect1(const Value& cond, const Value& then_, const Value& else_);
 
     ResultAndCarry LogicalShiftLeft(const Value& value_in, const Value& shift_amount, const Value& carry_in);
     ResultAndCarry LogicalShiftRight(const Value& value_in, const Value& shift_amount, const Value& carry_in);
@@ -121,7 +149,10 @@ public:
     Value Sub64(const Value& a, const Value& b);
     Value Mul(const Value& a, const Value& b);
     Value Mul64(const Value& a, const Value& b);
+    Value SignedDiv(const Value& a, const Value& b);
+    Value UnsignedDiv(const Value& a, const Value& b);
     Value And(const Value& a, const Value& b);
+    Value AndNot(const Value& a, const Value& b);
     Value Eor(const Value& a, const Value& b);
     Value Or(const Value& a, const Value& b);
     Value Not(const Value& a);
@@ -134,6 +165,7 @@ public:
     Value ByteReverseWord(const Value& a);
     Value ByteReverseHalf(const Value& a);
     Value ByteReverseDual(const Value& a);
+    Value BitReverseWord(const Value& a);
     Value CountLeadingZeros(const Value& a);
 
     ResultAndOverflow SignedSaturatedAdd(const Value& a, const Value& b);
@@ -149,6 +181,8 @@ public:
     ResultAndGE PackedSubS8(const Value& a, const Value& b);
     ResultAndGE PackedSubU16(const Value& a, const Value& b);
     ResultAndGE PackedSubS16(const Value& a, const Value& b);
+    ResultAndGE PackedSubAddU16(const Value& a, const Value& b, bool asx);
+    ResultAndGE PackedSubAddS16(const Value& a, const Value& b, bool asx);
     Value PackedHalvingAddU8(const Value& a, const Value& b);
     Value PackedHalvingAddS8(const Value& a, const Value& b);
     Value PackedHalvingSubU8(const Value& a, const Value& b);
@@ -169,10 +203,28 @@ public:
     Value PackedSaturatedSubS16(const Value& a, const Value& b);
     Value PackedAbsDiffSumS8(const Value& a, const Value& b);
 
+    Value VectorAdd8(const Value& a, const Value& b);
+    Value VectorAdd16(const Value& a, const Value& b);
+    Value VectorAdd32(const Value& a, const Value& b);
+    Value VectorAdd64(const Value& a, const Value& b);
+    Value VectorSub8(const Value& a, const Value& b);
+    Value VectorSub16(const Value& a, const Value& b);
+    Value VectorSub32(const Value& a, const Value& b);
+    Value VectorSub64(const Value& a, const Value& b);
+    Value VectorMultiply16(const Value& a, const Value& b);
+    Value VectorMultiply32(const Value& a, const Value& b);
+    Value VectorAnd(const Value& a, const Value& b);
+    Value VectorOr(const Value& a, const Value& b);
+    Value VectorEor(const Value& a, const Value& b);
+    Value VectorNot(const Value& a);
+
     Value TransferToFP32(const Value& a);
     Value TransferToFP64(const Value& a);
     Value TransferFromFP32(const Value& a);
     Value TransferFromFP64(const Value& a);
+    Value FPPack2x32To1x64(const Value& lo, const Value& hi);
+    Value FPLeastSignificantWord(const Value& a);
+    Value FPMostSignificantWord(const Value& a);
     Value FPAbs32(const Value& a);
     Value FPAbs64(const Value& a);
     Value FPAdd32(const Value& a, const Value& b, bool fpscr_controlled);
@@ -183,6 +235,9 @@ public:
     Value FPDiv64(const Value& a, const Value& b, bool fpscr_controlled);
     Value FPMul32(const Value& a, const Value& b, bool fpscr_controlled);
     Value FPMul64(const Value& a, const Value& b, bool fpscr_controlled);
+    /// Computes addend + a * b with a single rounding.
+    Value FPMulAdd32(const Value& addend, const Value& a, const Value& b, bool fpscr_controlled);
+    Value FPMulAdd64(const Value& addend, const Value& a, const Value& b, bool fpscr_controlled);
     Value FPNeg32(const Value& a);
     Value FPNeg64(const Value& a);
     Value FPSqrt32(const Value& a);
@@ -201,15 +256,32 @@ public:
     Value FPU32ToDouble(const Value& a, bool round_to_nearest, bool fpscr_controlled);
 
     void ClearExclusive();
+    void DataMemoryBarrier();
     void SetExclusive(const Value& vaddr, size_t byte_size);
     Value ReadMemory8(const Value& vaddr);
     Value ReadMemory16(const Value& vaddr);
     Value ReadMemory32(const Value& vaddr);
     Value ReadMemory64(const Value& vaddr);
+    /// Little-endian only: big-endian vector transfers reverse each element, whose size the access does not know.
+    Value ReadMemory128(const Value& vaddr);
     void WriteMemory8(const Value& vaddr, const Value& value);
     void WriteMemory16(const Value& vaddr, const Value& value);
     void WriteMemory32(const Value& vaddr, const Value& value);
     void WriteMemory64(const Value& vaddr, const Value& value);
+    /// Little-endian only, as ReadMemory128.
+    void WriteMemory128(const Value& vaddr, const Value& value);
+    /// Loads consecutive words at vaddr into the core registers in `list` (R0-R14), lowest-numbered register first.
+    void ReadMemoryToRegisters(const Value& vaddr, Arm::RegList list);
+    /// Stores the core registers in `list` (R0-R14) to consecutive words at vaddr, lowest-numbered register first.
+    void WriteMemoryFromRegisters(const Value& vaddr, Arm::RegList list);
+    /// Loads `count` consecutive extension registers starting at `first` from consecutive memory at vaddr.
+    void ReadMemoryToExtRegisters(const Value& vaddr, Arm::ExtReg first, size_t count);
+    /// Stores `count` consecutive extension registers starting at `first` to consecutive memory at vaddr.
+    void WriteMemoryFromExtRegisters(const Value& vaddr, Arm::ExtReg first, size_t count);
+    Value ExclusiveReadMemory8(const Value& vaddr);
+    Value ExclusiveReadMemory16(const Value& vaddr);
+    Value ExclusiveReadMemory32(const Value& vaddr);
+    std::pair<Value, Value> ExclusiveReadMemory64(const Value& vaddr);
     Value ExclusiveWriteMemory8(const Value& vaddr, const Value& value);
     Value ExclusiveWriteMemory16(const Value& vaddr, const Value& value);
     Value ExclusiveWriteMemory32(const Value& vaddr, const Value& value);
@@ -12,11 +12,15 @@ namespace Dynarmic {
 namespace IR {
 
 std::ostream& operator<<(std::ostream& o, const LocationDescriptor& loc) {
-    o << fmt::format("{{{},{},{},{}}}",
+    o << fmt::format("{{{},{},{},{},IT:{:02x},M:{:02x}}}",
                      loc.PC(),
                      loc.TFlag() ? "T" : "!T",
                      loc.EFlag() ? "E" : "!E",
-                     loc.FPSCR().Value());
+                     loc.FPSCR().Value(),
+                     loc.IT().Value(),
+                     static_cast<u32>(loc.Mode()));
+    if (loc.AddressSpace() != 0)
+        o << fmt::format("@{}", loc.AddressSpace());
     return o;
 }
 
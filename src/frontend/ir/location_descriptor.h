@@ -9,8 +9,10 @@
 #include <functional>
 #include <iosfwd>
 #include <tuple>
+#include "common/assert.h"
 #include "common/common_types.h"
 #include "frontend/arm/FPSCR.h"
+#include "frontend/arm/ITState.h"
 #include "frontend/arm/PSR.h"
 
 namespace Dynarmic {
@@ -20,26 +22,37 @@ namespace IR {
  * LocationDescriptor describes the location of a basic block.
  * The location is not solely based on the PC because other flags influence the way
  * instructions should be translated. The CPSR.T flag is most notable since it
- * tells us if the processor is in Thumb or Arm mode.
+ * tells us if the processor is in Thumb or Arm mode. The If-Then state is also part of the
+ * location, as it decides which Thumb instructions are predicated and on what. So is the processor
+ * mode, which decides which registers are banked and whether privileged instructions take effect.
+ * The address space distinguishes the same address in different guest processes (see Jit::SetAddressSpace).
  */
 class LocationDescriptor {
 public:
     // Indicates bits that should be preserved within descriptors.
-    static constexpr u32 CPSR_MODE_MASK  = 0x00000220;
+    // Only M[3:0] of the mode is kept: M[4] is set in every valid mode, and is assumed to be set.
+    static constexpr u32 CPSR_MODE_MASK  = 0x0600FE2F;
     static constexpr u32 FPSCR_MODE_MASK = 0x03F79F00;
+    // Limited by the bits of UniqueHash left free by the other fields.
+    static constexpr size_t MAX_ADDRESS_SPACES = 8;
 
-    LocationDescriptor(u32 arm_pc, Arm::PSR cpsr, Arm::FPSCR fpscr)
-            : arm_pc(arm_pc), cpsr(cpsr.Value() & CPSR_MODE_MASK), fpscr(fpscr.Value() & FPSCR_MODE_MASK) {}
+    LocationDescriptor(u32 arm_pc, Arm::PSR cpsr, Arm::FPSCR fpscr, size_t address_space = 0)
+            : arm_pc(arm_pc), cpsr(cpsr.Value() & CPSR_MODE_MASK), fpscr(fpscr.Value() & FPSCR_MODE_MASK), address_space(static_cast<u8>(address_space)) {
+        DEBUG_ASSERT(address_space < MAX_ADDRESS_SPACES);
+    }
 
     u32 PC() const { return arm_pc; }
     bool TFlag() const { return cpsr.T(); }
     bool EFlag() const { return cpsr.E(); }
+    Arm::ITState IT() const { return Arm::ITState{static_cast<u8>(cpsr.IT())}; }
+    Arm::PSR::Mode Mode() const { return static_cast<Arm::PSR::Mode>(0x10 | (cpsr.Value() & 0xF)); }
 
     Arm::PSR CPSR() const { return cpsr; }
     Arm::FPSCR FPSCR() const { return fpscr; }
+    size_t AddressSpace() const { return address_space; }
 
     bool operator == (const LocationDescriptor& o) const {
-        return std::tie(arm_pc, cpsr, fpscr) == std::tie(o.arm_pc, o.cpsr, o.fpscr);
+        return std::tie(arm_pc, cpsr, fpscr, address_space) == std::tie(o.arm_pc, o.cpsr, o.fpscr, o.address_space);
     }
 
     bool operator != (const LocationDescriptor& o) const {
@@ -47,45 +60,93 @@ public:
     }
 
     LocationDescriptor SetPC(u32 new_arm_pc) const {
-        return LocationDescriptor(new_arm_pc, cpsr, fpscr);
+        return LocationDescriptor(new_arm_pc, cpsr, fpscr, address_space);
     }
 
     LocationDescriptor AdvancePC(int amount) const {
-        return LocationDescriptor(static_cast<u32>(arm_pc + amount), cpsr, fpscr);
+        return LocationDescriptor(static_cast<u32>(arm_pc + amount), cpsr, fpscr, address_space);
     }
 
     LocationDescriptor SetTFlag(bool new_tflag) const {
         Arm::PSR new_cpsr = cpsr;
         new_cpsr.T(new_tflag);
 
-        return LocationDescriptor(arm_pc, new_cpsr, fpscr);
+        return LocationDescriptor(arm_pc, new_cpsr, fpscr, address_space);
     }
 
     LocationDescriptor SetEFlag(bool new_eflag) const {
         Arm::PSR new_cpsr = cpsr;
         new_cpsr.E(new_eflag);
 
-        return LocationDescriptor(arm_pc, new_cpsr, fpscr);
+        return LocationDescriptor(arm_pc, new_cpsr, fpscr, address_space);
+    }
+
+    LocationDescriptor SetIT(Arm::ITState new_it) const {
+        Arm::PSR new_cpsr = cpsr;
+        new_cpsr.IT(new_it.Value());
+
+        return LocationDescriptor(arm_pc, new_cpsr, fpscr, address_space);
+    }
+
+    LocationDescriptor SetMode(Arm::PSR::Mode new_mode) const {
+        Arm::PSR new_cpsr = cpsr;
+        new_cpsr.M(new_mode);
+
+        return LocationDescriptor(arm_pc, new_cpsr, fpscr, address_space);
+    }
+
+    LocationDescriptor AdvanceIT() const {
+        return SetIT(IT().Advance());
     }
 
     LocationDescriptor SetFPSCR(u32 new_fpscr) const {
-        return LocationDescriptor(arm_pc, cpsr, Arm::FPSCR{new_fpscr & FPSCR_MODE_MASK});
+        return LocationDescriptor(arm_pc, cpsr, Arm::FPSCR{new_fpscr & FPSCR_MODE_MASK}, address_space);
+    }
+
+    LocationDescriptor SetAddressSpace(size_t new_address_space) const {
+        return LocationDescriptor(arm_pc, cpsr, fpscr, new_address_space);
     }
 
     u64 UniqueHash() const {
         // This value MUST BE UNIQUE.
-        // This calculation has to match up with EmitX64::EmitTerminalPopRSBHint
+        // This calculation has to match up with BlockOfCode::CalculateUniqueHash
         u64 pc_u64 = u64(arm_pc);
         u64 fpscr_u64 = u64(fpscr.Value()) << 32;
         u64 t_u64 = cpsr.T() ? (1ull << 35) : 0;
         u64 e_u64 = cpsr.E() ? (1ull << 39) : 0;
-        return pc_u64 | fpscr_u64 | t_u64 | e_u64;
+        // IT[7:2] occupies bits 58-63 and IT[1:0] bits 32-33, both unused by the FPSCR mode bits.
+        u64 it_u64 = (u64(cpsr.Value() & 0x0000FC00) << 48) | (u64(cpsr.Value() & 0x06000000) << 7);
+        // M[0] occupies bit 34 and M[3:1] bits 36-38, either side of the T flag.
+        u64 mode_u64 = (u64(cpsr.Value() & 0x1) << 34) | (u64(cpsr.Value() & 0xE) << 35);
+        return pc_u64 | fpscr_u64 | t_u64 | e_u64 | it_u64 | mode_u64 | AddressSpaceHash(address_space);
+    }
+
+    /// Returns the descriptor whose UniqueHash is `hash`. Every bit of the hash is used, so every value has one.
+    static LocationDescriptor FromUniqueHash(u64 hash) {
+        const u32 pc = static_cast<u32>(hash);
+        const u32 fpscr = static_cast<u32>(hash >> 32) & FPSCR_MODE_MASK;
+        u32 cpsr = 0;
+        cpsr |= u32((hash >> 35) & 1) << 5;    // T
+        cpsr |= u32((hash >> 39) & 1) << 9;    // E
+        cpsr |= u32((hash >> 58) & 0x3F) << 10; // IT[7:2]
+        cpsr |= u32((hash >> 32) & 0x3) << 25;  // IT[1:0]
+        cpsr |= u32((hash >> 34) & 1);          // M[0]
+        cpsr |= u32((hash >> 36) & 0x7) << 1;   // M[3:1]
+        const size_t address_space = static_cast<size_t>(((hash >> 45) & 0x3) | ((hash >> 49) & 0x4));
+        return LocationDescriptor(pc, Arm::PSR{cpsr}, Arm::FPSCR{fpscr}, address_space);
+    }
+
+    /// The bits of UniqueHash that hold address_space: bits 45-46 and 51, which are FPSCR bits 13, 14 and 19,
+    /// none of which is in FPSCR_MODE_MASK.
+    static constexpr u64 AddressSpaceHash(size_t address_space) {
+        return (u64(address_space & 0x3) << 45) | (u64(address_space & 0x4) << 49);
     }
 
 private:
     u32 arm_pc;       ///< Current program counter value.
     Arm::PSR cpsr;    ///< Current program status register.
     Arm::FPSCR fpscr; ///< Floating point status control register.
+    u8 address_space; ///< Guest address space the code was translated from.
 };
 
 /**
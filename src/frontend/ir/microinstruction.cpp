@@ -45,6 +45,9 @@ bool Inst::IsSharedMemoryRead() const {
     case Opcode::ReadMemory16:
     case Opcode::ReadMemory32:
     case Opcode::ReadMemory64:
+    case Opcode::ReadMemory128:
+    case Opcode::ReadMemoryToRegisters:
+    case Opcode::ReadMemoryToExtRegisters:
         return true;
 
     default:
@@ -58,6 +61,9 @@ bool Inst::IsSharedMemoryWrite() const {
     case Opcode::WriteMemory16:
     case Opcode::WriteMemory32:
     case Opcode::WriteMemory64:
+    case Opcode::WriteMemory128:
+    case Opcode::WriteMemoryFromRegisters:
+    case Opcode::WriteMemoryFromExtRegisters:
         return true;
 
     default:
@@ -69,6 +75,19 @@ bool Inst::IsSharedMemoryReadOrWrite() const {
     return IsSharedMemoryRead() || IsSharedMemoryWrite();
 }
 
+bool Inst::IsExclusiveMemoryRead() const {
+    switch (op) {
+    case Opcode::ExclusiveReadMemory8:
+    case Opcode::ExclusiveReadMemory16:
+    case Opcode::ExclusiveReadMemory32:
+    case Opcode::ExclusiveReadMemory64:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
 bool Inst::IsExclusiveMemoryWrite() const {
     switch (op) {
     case Opcode::ExclusiveWriteMemory8:
@@ -83,7 +102,7 @@ bool Inst::IsExclusiveMemoryWrite() const {
 }
 
 bool Inst::IsMemoryRead() const {
-    return IsSharedMemoryRead();
+    return IsSharedMemoryRead() || IsExclusiveMemoryRead();
 }
 
 bool Inst::IsMemoryWrite() const {
@@ -94,6 +113,10 @@ bool Inst::IsMemoryReadOrWrite() const {
     return IsMemoryRead() || IsMemoryWrite();
 }
 
+bool Inst::IsMemoryBarrier() const {
+    return op == Opcode::DataMemoryBarrier;
+}
+
 bool Inst::ReadsFromCPSR() const {
     switch (op) {
     case Opcode::GetCpsr:
@@ -102,6 +125,8 @@ bool Inst::ReadsFromCPSR() const {
     case Opcode::GetCFlag:
     case Opcode::GetVFlag:
     case Opcode::GetGEFlags:
+    case Opcode::TestCondition:
+    case Opcode::SideExit: // Leaves the CPSR as it is at this point to the next block
         return true;
 
     default:
@@ -112,10 +137,15 @@ bool Inst::ReadsFromCPSR() const {
 bool Inst::WritesToCPSR() const {
     switch (op) {
     case Opcode::SetCpsr:
+    case Opcode::SetCpsrAndSwitchMode:
     case Opcode::SetNFlag:
     case Opcode::SetZFlag:
     case Opcode::SetCFlag:
     case Opcode::SetVFlag:
+    case Opcode::SetNZFlags:
+    case Opcode::SetNZCFlags:
+    case Opcode::SetNZCVFlags:
+    case Opcode::SetNZCVFlagsAtExit:
     case Opcode::OrQFlag:
     case Opcode::SetGEFlags:
         return true;
@@ -125,11 +155,24 @@ bool Inst::WritesToCPSR() const {
     }
 }
 
+bool Inst::ReadsFromSPSR() const {
+    // A mode switch changes which SPSR is current.
+    return op == Opcode::GetSpsr || op == Opcode::SetCpsrAndSwitchMode;
+}
+
+bool Inst::WritesToSPSR() const {
+    return op == Opcode::SetSpsr || op == Opcode::SetCpsrAndSwitchMode;
+}
+
 bool Inst::ReadsFromCoreRegister() const {
     switch (op) {
     case Opcode::GetRegister:
+    case Opcode::SetCpsrAndSwitchMode:
     case Opcode::GetExtendedRegister32:
     case Opcode::GetExtendedRegister64:
+    case Opcode::GetVector:
+    case Opcode::WriteMemoryFromRegisters:
+    case Opcode::WriteMemoryFromExtRegisters:
         return true;
 
     default:
@@ -142,7 +185,11 @@ bool Inst::WritesToCoreRegister() const {
     case Opcode::SetRegister:
     case Opcode::SetExtendedRegister32:
     case Opcode::SetExtendedRegister64:
+    case Opcode::SetVector:
     case Opcode::BXWritePC:
+    case Opcode::SetCpsrAndSwitchMode:
+    case Opcode::ReadMemoryToRegisters:
+    case Opcode::ReadMemoryToExtRegisters:
         return true;
 
     default:
@@ -164,6 +211,8 @@ bool Inst::ReadsFromFPSCR() const {
     case Opcode::FPDiv64:
     case Opcode::FPMul32:
     case Opcode::FPMul64:
+    case Opcode::FPMulAdd32:
+    case Opcode::FPMulAdd64:
     case Opcode::FPNeg32:
     case Opcode::FPNeg64:
     case Opcode::FPSqrt32:
@@ -191,6 +240,8 @@ bool Inst::WritesToFPSCR() const {
     case Opcode::FPDiv64:
     case Opcode::FPMul32:
     case Opcode::FPMul64:
+    case Opcode::FPMulAdd32:
+    case Opcode::FPMulAdd64:
     case Opcode::FPNeg32:
     case Opcode::FPNeg64:
     case Opcode::FPSqrt32:
@@ -205,13 +256,16 @@ bool Inst::WritesToFPSCR() const {
 }
 
 bool Inst::CausesCPUException() const {
-    return op == Opcode::Breakpoint ||
-           op == Opcode::CallSupervisor;
+    return op == Opcode::Breakpoint     ||
+           op == Opcode::CallSupervisor ||
+           op == Opcode::CallHostFunction ||
+           op == Opcode::CallHint;
 }
 
 bool Inst::AltersExclusiveState() const {
     return op == Opcode::ClearExclusive ||
            op == Opcode::SetExclusive   ||
+           IsExclusiveMemoryRead()      ||
            IsExclusiveMemoryWrite();
 }
 
@@ -232,13 +286,20 @@ bool Inst::IsCoprocessorInstruction() const {
 }
 
 bool Inst::MayHaveSideEffects() const {
-    return op == Opcode::PushRSB  ||
-           CausesCPUException()   ||
-           WritesToCoreRegister() ||
-           WritesToCPSR()         ||
-           WritesToFPSCR()        ||
-           AltersExclusiveState() ||
-           IsMemoryWrite()        ||
+    return op == Opcode::PushRSB           ||
+           op == Opcode::ProfileCall       ||
+           op == Opcode::ProfileReturn     ||
+           op == Opcode::SkipSpinLoop      ||
+           op == Opcode::TraceMemoryAccess ||
+           op == Opcode::SideExit          ||
+           CausesCPUException()            ||
+           WritesToCoreRegister()          ||
+           WritesToCPSR()                  ||
+           WritesToSPSR()                  ||
+           WritesToFPSCR()                 ||
+           AltersExclusiveState()          ||
+           IsMemoryWrite()                 ||
+           IsMemoryBarrier()               ||
            IsCoprocessorInstruction();
 }
 
@@ -251,18 +312,21 @@ void Inst::DecrementRemainingUses() {
     use_count--;
 }
 
+void Inst::IncrementRemainingUses() {
+    use_count++;
+}
+
 Inst* Inst::GetAssociatedPseudoOperation(Opcode opcode) {
     // This is faster than doing a search through the block.
     switch (opcode) {
+    // carry_inst and ge_inst share storage, so either may hold the other kind of pseudo-operation.
     case IR::Opcode::GetCarryFromOp:
-        DEBUG_ASSERT(!carry_inst || carry_inst->GetOpcode() == Opcode::GetCarryFromOp);
-        return carry_inst;
+        return carry_inst && carry_inst->GetOpcode() == Opcode::GetCarryFromOp ? carry_inst : nullptr;
     case IR::Opcode::GetOverflowFromOp:
         DEBUG_ASSERT(!overflow_inst || overflow_inst->GetOpcode() == Opcode::GetOverflowFromOp);
         return overflow_inst;
     case IR::Opcode::GetGEFromOp:
-        DEBUG_ASSERT(!ge_inst || ge_inst->GetOpcode() == Opcode::GetGEFromOp);
-        return ge_inst;
+        return ge_inst && ge_inst->GetOpcode() == Opcode::GetGEFromOp ? ge_inst : nullptr;
     default:
         break;
     }
@@ -39,6 +39,8 @@ public:
     bool IsSharedMemoryWrite() const;
     /// Determines whether or not this instruction performs a shared memory read or write.
     bool IsSharedMemoryReadOrWrite() const;
+    /// Determines whether or not this instruction performs an exclusive memory read.
+    bool IsExclusiveMemoryRead() const;
     /// Determines whether or not this instruction performs an atomic memory write.
     bool IsExclusiveMemoryWrite() const;
 
@@ -48,12 +50,19 @@ public:
     bool IsMemoryWrite() const;
     /// Determines whether or not this instruction performs any kind of memory access.
     bool IsMemoryReadOrWrite() const;
+    /// Determines whether or not this instruction orders the memory accesses before it against those after it.
+    bool IsMemoryBarrier() const;
 
     /// Determines whether or not this instruction reads from the CPSR.
     bool ReadsFromCPSR() const;
     /// Determines whether or not this instruction writes to the CPSR.
     bool WritesToCPSR() const;
 
+    /// Determines whether or not this instruction reads from the SPSR of the current mode.
+    bool ReadsFromSPSR() const;
+    /// Determines whether or not this instruction writes to the SPSR of the current mode.
+    bool WritesToSPSR() const;
+
     /// Determines whether or not this instruction reads from a core register.
     bool ReadsFromCoreRegister() const;
     /// Determines whether or not this instruction writes to a core register.
@@ -82,6 +91,8 @@ public:
     size_t UseCount() const { return use_count; }
     bool HasUses() const { return use_count > 0; }
     void DecrementRemainingUses();
+    /// Adds a use that is not an argument of any instruction, such as a use by the block's terminal in the backend.
+    void IncrementRemainingUses();
 
     /// Gets a pseudo-operation associated with this instruction.
     Inst* GetAssociatedPseudoOperation(Opcode opcode);
@@ -93,6 +104,11 @@ public:
     /// Get the number of arguments this instruction has.
     size_t NumArgs() const { return GetNumArgsOf(op); }
 
+    /// Get the address of the guest instruction this microinstruction was translated from.
+    u32 GuestPC() const { return guest_pc; }
+    /// Set the address of the guest instruction this microinstruction was translated from.
+    void SetGuestPC(u32 pc) { guest_pc = pc; }
+
     Value GetArg(size_t index) const;
     void SetArg(size_t index, Value value);
 
@@ -105,8 +121,9 @@ private:
     void UndoUse(const Value& value);
 
     Opcode op;
+    u32 guest_pc = 0;
     size_t use_count = 0;
-    std::array<Value, 3> args;
+    std::array<Value, 4> args;
 
     // Pointers to related pseudooperations:
     // Since not all combinations are possible, we use a union to save space
@@ -5,9 +5,9 @@
  */
 
 #include <array>
-#include <map>
-#include <vector>
+#include <initializer_list>
 
+#include "common/assert.h"
 #include "frontend/ir/opcodes.h"
 
 namespace Dynarmic {
@@ -19,39 +19,60 @@ namespace OpcodeInfo {
 
 using T = Dynarmic::IR::Type;
 
+constexpr size_t max_arg_count = 4;
+
 struct Meta {
     const char* name;
     Type type;
-    std::vector<Type> arg_types;
+    size_t num_args;
+    Type arg_types[max_arg_count];
 };
 
-static const std::map<Opcode, Meta> opcode_info {{
-#define OPCODE(name, type, ...) { Opcode::name, { #name, type, { __VA_ARGS__ } } },
+constexpr Meta MakeMeta(const char* name, Type type, std::initializer_list<Type> arg_types) {
+    Meta meta{name, type, arg_types.size(), {}};
+    size_t index = 0;
+    for (Type arg_type : arg_types) {
+        meta.arg_types[index++] = arg_type;
+    }
+    return meta;
+}
+
+// Indexed by opcode, so that looking up an opcode's signature is a single load.
+constexpr std::array<Meta, OpcodeCount> opcode_info {{
+#define OPCODE(name, type, ...) MakeMeta(#name, type, { __VA_ARGS__ }),
 #include "opcodes.inc"
 #undef OPCODE
 }};
 
+static_assert(opcode_info[static_cast<size_t>(Opcode::Breakpoint)].num_args == 0, "opcode_info must be in the order of opcodes.inc");
+
+static const Meta& Get(Opcode op) {
+    return opcode_info[static_cast<size_t>(op)];
+}
+
 } // namespace OpcodeInfo
 
 Type GetTypeOf(Opcode op) {
-    return OpcodeInfo::opcode_info.at(op).type;
+    return OpcodeInfo::Get(op).type;
 }
 
 size_t GetNumArgsOf(Opcode op) {
-    return OpcodeInfo::opcode_info.at(op).arg_types.size();
+    return OpcodeInfo::Get(op).num_args;
 }
 
 Type GetArgTypeOf(Opcode op, size_t arg_index) {
-    return OpcodeInfo::opcode_info.at(op).arg_types.at(arg_index);
+    const OpcodeInfo::Meta& meta = OpcodeInfo::Get(op);
+    ASSERT(arg_index < meta.num_args);
+    return meta.arg_types[arg_index];
 }
 
 const char* GetNameOf(Opcode op) {
-    return OpcodeInfo::opcode_info.at(op).name;
+    return OpcodeInfo::Get(op).name;
 }
 
 const char* GetNameOf(Type type) {
-    const static std::array<const char*, 12> names = {
-        "Void", "RegRef", "ExtRegRef", "Opaque", "U1", "U8", "U16", "U32", "U64", "F32", "F64", "CoprocInfo"
+    const static std::array<const char*, 13> names = {
+        "Void", "RegRef", "ExtRegRef", "Opaque", "U1", "U8", "U16", "U32", "U64", "U128", "F32", "F64", "CoprocInfo"
     };
     return names.at(static_cast<size_t>(type));
 }
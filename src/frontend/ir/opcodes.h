@@ -37,6 +37,7 @@ enum class Type {
     U16,
     U32,
     U64,
+    U128,
     F32,
     F64,
     CoprocInfo,
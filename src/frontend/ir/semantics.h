@@ -0,0 +1,184 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+
+#include "common/bit_util.h"
+#include "common/common_types.h"
+
+/**
+ * The results of IR operations on known values, shared by those that compute them outside of
+ * emitted code: constant propagation at translation time, and the block interpreter at run time.
+ */
+
+namespace Dynarmic {
+namespace IR {
+namespace Semantics {
+
+/// A value and the carry out of the operation that produced it.
+struct ResultAndCarry {
+    u32 result;
+    bool carry;
+};
+
+/// Shifting by zero leaves the value unchanged, and the carry-in becomes the carry-out.
+inline ResultAndCarry LogicalShiftLeft(u32 value, u8 shift, bool carry_in) {
+    if (shift == 0)
+        return {value, carry_in};
+    if (shift < 32)
+        return {value << shift, Common::Bit(32 - shift, value)};
+    return {0, shift == 32 && Common::Bit<0>(value)};
+}
+
+inline ResultAndCarry LogicalShiftRight(u32 value, u8 shift, bool carry_in) {
+    if (shift == 0)
+        return {value, carry_in};
+    if (shift < 32)
+        return {value >> shift, Common::Bit(shift - 1, value)};
+    return {0, shift == 32 && Common::Bit<31>(value)};
+}
+
+inline ResultAndCarry ArithmeticShiftRight(u32 value, u8 shift, bool carry_in) {
+    if (shift == 0)
+        return {value, carry_in};
+    const u32 result = static_cast<u32>(static_cast<s32>(value) >> std::min<u8>(shift, 31));
+    return {result, shift < 32 ? Common::Bit(shift - 1, value) : Common::Bit<31>(value)};
+}
+
+inline ResultAndCarry RotateRight(u32 value, u8 shift, bool carry_in) {
+    if (shift == 0)
+        return {value, carry_in};
+    const size_t rotate = shift & 0x1F;
+    const u32 result = rotate == 0 ? value : (value >> rotate) | (value << (32 - rotate));
+    return {result, Common::Bit<31>(result)};
+}
+
+inline ResultAndCarry RotateRightExtended(u32 value, bool carry_in) {
+    return {(value >> 1) | (carry_in ? 0x80000000 : 0), Common::Bit<0>(value)};
+}
+
+inline u32 ByteReverse(u32 value) {
+    return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+}
+
+inline u32 BitReverse(u32 value) {
+    u32 result = 0;
+    for (size_t i = 0; i < 32; i++) {
+        result |= ((value >> i) & 1) << (31 - i);
+    }
+    return result;
+}
+
+/// ARM division: dividing by zero gives zero, and INT_MIN / -1 gives INT_MIN.
+inline u32 SignedDivide(u32 a, u32 b) {
+    if (b == 0)
+        return 0;
+    return static_cast<u32>(s64(static_cast<s32>(a)) / static_cast<s32>(b));
+}
+
+/// Extracts lane `i` of the packed `value`, sign- or zero-extended to 32 bits.
+template <size_t lane_bits, bool is_signed>
+s32 GetLane(u32 value, size_t i) {
+    const u32 lane = (value >> (i * lane_bits)) & ((1u << lane_bits) - 1);
+    return is_signed ? static_cast<s32>(Common::SignExtend<lane_bits>(lane)) : static_cast<s32>(lane);
+}
+
+/// The exact result of one lane of a packed operation, and whether it sets the GE flags of that lane.
+struct LaneResult {
+    s32 value;
+    bool ge;
+};
+
+/// A packed result and its GE flags.
+struct PackedResult {
+    u32 result;
+    u32 ge;
+};
+
+/// Computes a packed operation, where `fn(i)` computes lane i.
+template <size_t lane_bits, typename Fn>
+PackedResult Packed(Fn fn) {
+    constexpr size_t lane_count = 32 / lane_bits;
+    constexpr u32 lane_mask = (1u << lane_bits) - 1;
+    constexpr u32 ge_mask = (1u << (lane_bits / 8)) - 1;
+
+    PackedResult packed{0, 0};
+    for (size_t i = 0; i < lane_count; i++) {
+        const LaneResult lane = fn(i);
+        packed.result |= (static_cast<u32>(lane.value) & lane_mask) << (i * lane_bits);
+        if (lane.ge) {
+            packed.ge |= ge_mask << (i * lane_bits / 8);
+        }
+    }
+    return packed;
+}
+
+template <size_t lane_bits, bool is_signed>
+PackedResult PackedAdd(u32 a, u32 b) {
+    return Packed<lane_bits>([a, b](size_t i) {
+        const s32 sum = GetLane<lane_bits, is_signed>(a, i) + GetLane<lane_bits, is_signed>(b, i);
+        return LaneResult{sum, is_signed ? sum >= 0 : sum >= (1 << lane_bits)};
+    });
+}
+
+template <size_t lane_bits, bool is_signed>
+PackedResult PackedSub(u32 a, u32 b) {
+    return Packed<lane_bits>([a, b](size_t i) {
+        const s32 difference = GetLane<lane_bits, is_signed>(a, i) - GetLane<lane_bits, is_signed>(b, i);
+        return LaneResult{difference, difference >= 0};
+    });
+}
+
+/// If asx is true, the high halfword is a_hi + b_lo and the low halfword a_lo - b_hi; if false, the reverse.
+template <bool is_signed>
+PackedResult PackedSubAdd16(u32 a, u32 b, bool asx, bool halving) {
+    return Packed<16>([=](size_t i) {
+        const bool is_sum = (i == 1) == asx;
+        const s32 lane_a = GetLane<16, is_signed>(a, i);
+        const s32 lane_b = GetLane<16, is_signed>(b, 1 - i);
+        const s32 value = is_sum ? lane_a + lane_b : lane_a - lane_b;
+        const bool ge = is_sum && !is_signed ? value >= 0x10000 : value >= 0;
+        return LaneResult{halving ? value >> 1 : value, ge};
+    });
+}
+
+template <size_t lane_bits, bool is_signed>
+u32 PackedHalving(u32 a, u32 b, bool is_sub) {
+    return Packed<lane_bits>([=](size_t i) {
+        const s32 lane_a = GetLane<lane_bits, is_signed>(a, i);
+        const s32 lane_b = GetLane<lane_bits, is_signed>(b, i);
+        return LaneResult{(is_sub ? lane_a - lane_b : lane_a + lane_b) >> 1, false};
+    }).result;
+}
+
+template <size_t lane_bits, bool is_signed>
+u32 PackedSaturated(u32 a, u32 b, bool is_sub) {
+    constexpr s32 min = is_signed ? -(1 << (lane_bits - 1)) : 0;
+    constexpr s32 max = is_signed ? (1 << (lane_bits - 1)) - 1 : (1 << lane_bits) - 1;
+    return Packed<lane_bits>([=](size_t i) {
+        const s32 lane_a = GetLane<lane_bits, is_signed>(a, i);
+        const s32 lane_b = GetLane<lane_bits, is_signed>(b, i);
+        const s32 value = is_sub ? lane_a - lane_b : lane_a + lane_b;
+        return LaneResult{std::max(min, std::min(value, max)), false};
+    }).result;
+}
+
+/// The sum of the absolute differences of the unsigned bytes of a and b.
+inline u32 PackedAbsDiffSum8(u32 a, u32 b) {
+    u32 sum = 0;
+    for (size_t i = 0; i < 4; i++) {
+        sum += static_cast<u32>(std::abs(GetLane<8, false>(a, i) - GetLane<8, false>(b, i)));
+    }
+    return sum;
+}
+
+} // namespace Semantics
+} // namespace IR
+} // namespace Dynarmic
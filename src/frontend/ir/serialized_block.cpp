@@ -0,0 +1,449 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include <boost/variant/get.hpp>
+
+#include "common/assert.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/serialized_block.h"
+
+namespace Dynarmic {
+namespace IR {
+
+SerializedBlock::SerializedBlock(const Block& block)
+        : location(block.Location())
+        , guest_ranges(block.GuestRanges())
+        , folded_data_ranges(block.FoldedDataRanges())
+        , folded_coprocessor_constant(block.HasFoldedCoprocessorConstant())
+        , cond(block.GetCondition())
+        , cond_failed_cycle_count(block.ConditionFailedCycleCount())
+        , breakpoint(block.HasBreakpoint())
+        , terminal(block.GetTerminal())
+        , cycle_count(block.CycleCount())
+{
+    if (block.HasConditionFailedLocation())
+        cond_failed = block.ConditionFailedLocation();
+
+    std::unordered_map<const Inst*, u32> index_of_inst;
+    instructions.reserve(block.size());
+    for (const Inst& inst : block) {
+        index_of_inst.emplace(&inst, static_cast<u32>(instructions.size()));
+        instructions.push_back({inst.GetOpcode(), inst.GuestPC()});
+
+        for (size_t i = 0; i < inst.NumArgs(); i++) {
+            const Value arg = inst.GetArg(i);
+            if (arg.IsInst()) {
+                const auto iter = index_of_inst.find(arg.GetInst());
+                ASSERT_MSG(iter != index_of_inst.end(), "Argument is not the result of an earlier instruction");
+                arguments.push_back({iter->second, {}});
+            } else {
+                arguments.push_back({NotAnInst, arg});
+            }
+        }
+    }
+}
+
+Block SerializedBlock::Deserialize() const {
+    Block block{location};
+    for (const auto& range : guest_ranges) {
+        block.AppendGuestRange(range.first, range.second);
+    }
+    for (const auto& range : folded_data_ranges) {
+        block.AppendFoldedDataRange(range.first, range.second);
+    }
+    if (folded_coprocessor_constant)
+        block.SetFoldedCoprocessorConstant();
+    block.SetCondition(cond);
+    if (cond_failed)
+        block.SetConditionFailedLocation(*cond_failed);
+    block.ConditionFailedCycleCount() = cond_failed_cycle_count;
+    if (breakpoint)
+        block.SetBreakpoint();
+    block.CycleCount() = cycle_count;
+
+    std::vector<Inst*> insts;
+    insts.reserve(instructions.size());
+    auto next_argument = arguments.begin();
+    for (const Instruction& instruction : instructions) {
+        std::array<Value, 4> args;
+        const size_t num_args = GetNumArgsOf(instruction.opcode);
+        for (size_t i = 0; i < num_args; i++, ++next_argument) {
+            args[i] = next_argument->inst_index == NotAnInst ? next_argument->immediate : Value(insts[next_argument->inst_index]);
+        }
+
+        switch (num_args) {
+        case 0:
+            block.AppendNewInst(instruction.opcode, {});
+            break;
+        case 1:
+            block.AppendNewInst(instruction.opcode, {args[0]});
+            break;
+        case 2:
+            block.AppendNewInst(instruction.opcode, {args[0], args[1]});
+            break;
+        case 3:
+            block.AppendNewInst(instruction.opcode, {args[0], args[1], args[2]});
+            break;
+        case 4:
+            block.AppendNewInst(instruction.opcode, {args[0], args[1], args[2], args[3]});
+            break;
+        default:
+            ASSERT_MSG(false, "Unsupported number of arguments");
+            break;
+        }
+
+        Inst& inst = block.back();
+        inst.SetGuestPC(instruction.guest_pc);
+        insts.push_back(&inst);
+    }
+
+    if (terminal.which() != 0)
+        block.SetTerminal(terminal);
+    return block;
+}
+
+template <typename T>
+static void Write(std::vector<u8>& out, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written");
+    const size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static bool Read(const u8*& ptr, const u8* end, T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read");
+    if (static_cast<size_t>(end - ptr) < sizeof(T))
+        return false;
+    std::memcpy(&value, ptr, sizeof(T));
+    ptr += sizeof(T);
+    return true;
+}
+
+static void WriteRanges(std::vector<u8>& out, const std::vector<std::pair<u32, u32>>& ranges) {
+    Write<u32>(out, static_cast<u32>(ranges.size()));
+    for (const auto& range : ranges) {
+        Write(out, range.first);
+        Write(out, range.second);
+    }
+}
+
+static bool ReadRanges(const u8*& ptr, const u8* end, std::vector<std::pair<u32, u32>>& ranges) {
+    u32 num_ranges;
+    if (!Read(ptr, end, num_ranges) || num_ranges > static_cast<size_t>(end - ptr) / sizeof(std::pair<u32, u32>))
+        return false;
+    ranges.resize(num_ranges);
+    for (auto& range : ranges) {
+        if (!Read(ptr, end, range.first) || !Read(ptr, end, range.second))
+            return false;
+    }
+    return true;
+}
+
+static void WriteLocation(std::vector<u8>& out, const LocationDescriptor& location) {
+    Write<u32>(out, location.PC());
+    Write<u32>(out, location.CPSR().Value());
+    Write<u32>(out, location.FPSCR().Value());
+    Write<u8>(out, static_cast<u8>(location.AddressSpace()));
+}
+
+static boost::optional<LocationDescriptor> ReadLocation(const u8*& ptr, const u8* end) {
+    u32 pc, cpsr, fpscr;
+    u8 address_space;
+    if (!Read(ptr, end, pc) || !Read(ptr, end, cpsr) || !Read(ptr, end, fpscr) || !Read(ptr, end, address_space))
+        return boost::none;
+    if (address_space >= LocationDescriptor::MAX_ADDRESS_SPACES)
+        return boost::none;
+    return LocationDescriptor{pc, Arm::PSR{cpsr}, Arm::FPSCR{fpscr}, address_space};
+}
+
+static void WriteImmediate(std::vector<u8>& out, const Value& value) {
+    const Type type = value.GetType();
+    Write<u8>(out, static_cast<u8>(type));
+    switch (type) {
+    case Type::Void:
+        break;
+    case Type::RegRef:
+        Write<u8>(out, static_cast<u8>(value.GetRegRef()));
+        break;
+    case Type::ExtRegRef:
+        Write<u8>(out, static_cast<u8>(value.GetExtRegRef()));
+        break;
+    case Type::U1:
+        Write<u8>(out, value.GetU1());
+        break;
+    case Type::U8:
+        Write(out, value.GetU8());
+        break;
+    case Type::U16:
+        Write(out, value.GetU16());
+        break;
+    case Type::U32:
+        Write(out, value.GetU32());
+        break;
+    case Type::U64:
+        Write(out, value.GetU64());
+        break;
+    case Type::CoprocInfo:
+        Write(out, value.GetCoprocInfo());
+        break;
+    default:
+        ASSERT_MSG(false, "Not an immediate type");
+        break;
+    }
+}
+
+static boost::optional<Value> ReadImmediate(const u8*& ptr, const u8* end) {
+    u8 type;
+    if (!Read(ptr, end, type))
+        return boost::none;
+    switch (static_cast<Type>(type)) {
+    case Type::Void:
+        return Value{};
+    case Type::RegRef: {
+        u8 reg;
+        if (!Read(ptr, end, reg) || reg > static_cast<u8>(Arm::Reg::R15))
+            return boost::none;
+        return Value{static_cast<Arm::Reg>(reg)};
+    }
+    case Type::ExtRegRef: {
+        u8 reg;
+        if (!Read(ptr, end, reg) || reg > static_cast<u8>(Arm::ExtReg::D31))
+            return boost::none;
+        return Value{static_cast<Arm::ExtReg>(reg)};
+    }
+    case Type::U1: {
+        u8 value;
+        if (!Read(ptr, end, value) || value > 1)
+            return boost::none;
+        return Value{value != 0};
+    }
+    case Type::U8: {
+        u8 value;
+        if (!Read(ptr, end, value))
+            return boost::none;
+        return Value{value};
+    }
+    case Type::U16: {
+        u16 value;
+        if (!Read(ptr, end, value))
+            return boost::none;
+        return Value{value};
+    }
+    case Type::U32: {
+        u32 value;
+        if (!Read(ptr, end, value))
+            return boost::none;
+        return Value{value};
+    }
+    case Type::U64: {
+        u64 value;
+        if (!Read(ptr, end, value))
+            return boost::none;
+        return Value{value};
+    }
+    case Type::CoprocInfo: {
+        std::array<u8, 8> value;
+        if (!Read(ptr, end, value))
+            return boost::none;
+        return Value{value};
+    }
+    default:
+        return boost::none;
+    }
+}
+
+static void WriteTerminal(std::vector<u8>& out, const Terminal& terminal_variant) {
+    Write<u8>(out, static_cast<u8>(terminal_variant.which()));
+    switch (terminal_variant.which()) {
+    case 1:
+        WriteLocation(out, boost::get<Term::Interpret>(terminal_variant).next);
+        break;
+    case 3:
+        WriteLocation(out, boost::get<Term::LinkBlock>(terminal_variant).next);
+        break;
+    case 4:
+        WriteLocation(out, boost::get<Term::LinkBlockFast>(terminal_variant).next);
+        break;
+    case 6: {
+        const auto& terminal = boost::get<Term::If>(terminal_variant);
+        Write<u8>(out, static_cast<u8>(terminal.if_));
+        WriteTerminal(out, terminal.then_);
+        WriteTerminal(out, terminal.else_);
+        break;
+    }
+    case 7:
+        WriteTerminal(out, boost::get<Term::CheckHalt>(terminal_variant).else_);
+        break;
+    default:
+        break;
+    }
+}
+
+static bool ReadCond(const u8*& ptr, const u8* end, Arm::Cond& cond) {
+    u8 value;
+    if (!Read(ptr, end, value) || value > static_cast<u8>(Arm::Cond::NV))
+        return false;
+    cond = static_cast<Arm::Cond>(value);
+    return true;
+}
+
+static boost::optional<Terminal> ReadTerminal(const u8*& ptr, const u8* end) {
+    u8 which;
+    if (!Read(ptr, end, which))
+        return boost::none;
+    switch (which) {
+    case 0:
+        return Terminal{Term::Invalid{}};
+    case 1:
+        if (auto next = ReadLocation(ptr, end))
+            return Terminal{Term::Interpret{*next}};
+        return boost::none;
+    case 2:
+        return Terminal{Term::ReturnToDispatch{}};
+    case 3:
+        if (auto next = ReadLocation(ptr, end))
+            return Terminal{Term::LinkBlock{*next}};
+        return boost::none;
+    case 4:
+        if (auto next = ReadLocation(ptr, end))
+            return Terminal{Term::LinkBlockFast{*next}};
+        return boost::none;
+    case 5:
+        return Terminal{Term::PopRSBHint{}};
+    case 6: {
+        Arm::Cond cond;
+        if (!ReadCond(ptr, end, cond))
+            return boost::none;
+        auto then_ = ReadTerminal(ptr, end);
+        if (!then_)
+            return boost::none;
+        auto else_ = ReadTerminal(ptr, end);
+        if (!else_)
+            return boost::none;
+        return Terminal{Term::If{cond, *then_, *else_}};
+    }
+    case 7:
+        if (auto else_ = ReadTerminal(ptr, end))
+            return Terminal{Term::CheckHalt{*else_}};
+        return boost::none;
+    default:
+        return boost::none;
+    }
+}
+
+size_t SerializedBlock::AllocatedBytes() const {
+    return sizeof(*this) + guest_ranges.capacity() * sizeof(guest_ranges[0])
+           + folded_data_ranges.capacity() * sizeof(folded_data_ranges[0])
+           + instructions.capacity() * sizeof(Instruction) + arguments.capacity() * sizeof(Argument);
+}
+
+void SerializedBlock::WriteTo(std::vector<u8>& out) const {
+    WriteLocation(out, location);
+    WriteRanges(out, guest_ranges);
+    WriteRanges(out, folded_data_ranges);
+    Write<u8>(out, folded_coprocessor_constant ? 1 : 0);
+    Write<u8>(out, static_cast<u8>(cond));
+    Write<u8>(out, cond_failed ? 1 : 0);
+    if (cond_failed)
+        WriteLocation(out, *cond_failed);
+    Write<u64>(out, cond_failed_cycle_count);
+    Write<u8>(out, breakpoint ? 1 : 0);
+    WriteTerminal(out, terminal);
+    Write<u64>(out, cycle_count);
+
+    // Each instruction is followed by its arguments.
+    Write<u32>(out, static_cast<u32>(instructions.size()));
+    auto next_argument = arguments.begin();
+    for (const Instruction& instruction : instructions) {
+        Write<u32>(out, static_cast<u32>(instruction.opcode));
+        Write(out, instruction.guest_pc);
+        const size_t num_args = GetNumArgsOf(instruction.opcode);
+        for (size_t i = 0; i < num_args; i++, ++next_argument) {
+            Write(out, next_argument->inst_index);
+            if (next_argument->inst_index == NotAnInst)
+                WriteImmediate(out, next_argument->immediate);
+        }
+    }
+}
+
+boost::optional<SerializedBlock> SerializedBlock::ReadFrom(const u8*& ptr, const u8* end) {
+    const auto location = ReadLocation(ptr, end);
+    if (!location)
+        return boost::none;
+    SerializedBlock block{*location};
+
+    u8 folded_coprocessor_constant;
+    if (!ReadRanges(ptr, end, block.guest_ranges) || !ReadRanges(ptr, end, block.folded_data_ranges) || !Read(ptr, end, folded_coprocessor_constant))
+        return boost::none;
+    block.folded_coprocessor_constant = folded_coprocessor_constant != 0;
+
+    u8 has_cond_failed, breakpoint;
+    u64 cond_failed_cycle_count, cycle_count;
+    if (!ReadCond(ptr, end, block.cond) || !Read(ptr, end, has_cond_failed))
+        return boost::none;
+    if (has_cond_failed) {
+        block.cond_failed = ReadLocation(ptr, end);
+        if (!block.cond_failed)
+            return boost::none;
+    }
+    if (!Read(ptr, end, cond_failed_cycle_count) || !Read(ptr, end, breakpoint))
+        return boost::none;
+    auto terminal = ReadTerminal(ptr, end);
+    if (!terminal || !Read(ptr, end, cycle_count))
+        return boost::none;
+    block.cond_failed_cycle_count = static_cast<size_t>(cond_failed_cycle_count);
+    block.breakpoint = breakpoint != 0;
+    block.terminal = std::move(*terminal);
+    block.cycle_count = static_cast<size_t>(cycle_count);
+
+    // Arguments must have the types their opcodes expect, as Deserialize relies on it.
+    u32 num_instructions;
+    if (!Read(ptr, end, num_instructions) || num_instructions > static_cast<size_t>(end - ptr) / (2 * sizeof(u32)))
+        return boost::none;
+    block.instructions.reserve(num_instructions);
+    for (u32 index = 0; index < num_instructions; index++) {
+        u32 opcode;
+        Instruction instruction;
+        if (!Read(ptr, end, opcode) || opcode >= OpcodeCount || !Read(ptr, end, instruction.guest_pc))
+            return boost::none;
+        instruction.opcode = static_cast<Opcode>(opcode);
+
+        const size_t num_args = GetNumArgsOf(instruction.opcode);
+        for (size_t i = 0; i < num_args; i++) {
+            Argument argument;
+            if (!Read(ptr, end, argument.inst_index))
+                return boost::none;
+            Type type;
+            if (argument.inst_index == NotAnInst) {
+                const auto immediate = ReadImmediate(ptr, end);
+                if (!immediate)
+                    return boost::none;
+                argument.immediate = *immediate;
+                type = immediate->GetType();
+            } else if (argument.inst_index < index) {
+                type = GetTypeOf(block.instructions[argument.inst_index].opcode);
+            } else {
+                return boost::none;
+            }
+            if (!AreTypesCompatible(type, GetArgTypeOf(instruction.opcode, i)))
+                return boost::none;
+            block.arguments.push_back(argument);
+        }
+        block.instructions.push_back(instruction);
+    }
+
+    return block;
+}
+
+} // namespace IR
+} // namespace Dynarmic
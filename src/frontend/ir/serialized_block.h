@@ -0,0 +1,95 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+#include "frontend/ir/location_descriptor.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/terminal.h"
+#include "frontend/ir/value.h"
+
+namespace Dynarmic {
+namespace IR {
+
+class Block;
+
+/**
+ * A copy of a Block in a compact form that does not depend on an instruction pool, from which an
+ * identical Block can be rebuilt without translating and optimizing guest code again.
+ * Instructions refer to the results of earlier instructions by index.
+ */
+class SerializedBlock final {
+public:
+    explicit SerializedBlock(const Block& block);
+
+    /// Rebuilds the block.
+    Block Deserialize() const;
+
+    /// Appends the block to `out` in a binary form for ReadFrom, e.g. to save it to a file. The form
+    /// is that of the host's byte order and of this build's opcodes.
+    void WriteTo(std::vector<u8>& out) const;
+
+    /// Reads a block written by WriteTo from [ptr, end), advancing ptr past it. Returns boost::none if
+    /// the data is truncated or is not a well-formed block.
+    static boost::optional<SerializedBlock> ReadFrom(const u8*& ptr, const u8* end);
+
+    const LocationDescriptor& Location() const {
+        return location;
+    }
+
+    /// Ranges [first, second) of guest code translated into the block.
+    const std::vector<std::pair<u32, u32>>& GuestRanges() const {
+        return guest_ranges;
+    }
+
+    /// Ranges [first, second) of read-only guest memory folded into the block.
+    const std::vector<std::pair<u32, u32>>& FoldedDataRanges() const {
+        return folded_data_ranges;
+    }
+
+    /// Bytes allocated for the block, including this object.
+    size_t AllocatedBytes() const;
+
+private:
+    static constexpr u32 NotAnInst = 0xFFFFFFFF;
+
+    explicit SerializedBlock(const LocationDescriptor& location) : location(location) {}
+
+    struct Instruction {
+        Opcode opcode;
+        u32 guest_pc;
+    };
+    /// Either the result of the instruction at inst_index, or an immediate.
+    struct Argument {
+        u32 inst_index;
+        Value immediate;
+    };
+
+    LocationDescriptor location;
+    std::vector<std::pair<u32, u32>> guest_ranges;
+    std::vector<std::pair<u32, u32>> folded_data_ranges;
+    bool folded_coprocessor_constant;
+    Arm::Cond cond;
+    boost::optional<LocationDescriptor> cond_failed;
+    size_t cond_failed_cycle_count;
+    bool breakpoint;
+    Terminal terminal;
+    size_t cycle_count;
+
+    std::vector<Instruction> instructions;
+    /// Arguments of all instructions, those of each instruction following those of the previous one.
+    std::vector<Argument> arguments;
+};
+
+} // namespace IR
+} // namespace Dynarmic
@@ -33,6 +33,8 @@ public:
 
     bool IsEmpty() const;
     bool IsImmediate() const;
+    /// Whether this value is the result of an instruction. Unlike IsImmediate, does not look through Identity.
+    bool IsInst() const;
     Type GetType() const;
 
     Inst* GetInst() const;
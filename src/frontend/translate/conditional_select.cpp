@@ -0,0 +1,97 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <boost/optional.hpp>
+
+#include "frontend/arm/types.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/translate/conditional_select.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+static bool IsSelectable(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::SetRegister:
+        return inst.GetArg(0).GetRegRef() != Reg::PC;
+    case IR::Opcode::SetNFlag:
+    case IR::Opcode::SetZFlag:
+    case IR::Opcode::SetCFlag:
+    case IR::Opcode::SetVFlag:
+    case IR::Opcode::SetGEFlags:
+        return true;
+    default:
+        return !inst.MayHaveSideEffects() && !inst.IsMemoryRead();
+    }
+}
+
+bool CanPredicateWithSelects(IR::Block& block, IR::Block::iterator first) {
+    return std::all_of(first, block.end(), IsSelectable);
+}
+
+void PredicateWithSelects(IR::Block& block, IR::Block::iterator first, IR::Value passed) {
+    for (auto iter = first; iter != block.end(); ++iter) {
+        boost::optional<IR::Opcode> get_opcode;
+        IR::Opcode select_opcode = IR::Opcode::ConditionalSelect1;
+        size_t value_index = 0;
+        switch (iter->GetOpcode()) {
+        case IR::Opcode::SetRegister:
+            get_opcode = IR::Opcode::GetRegister;
+            select_opcode = IR::Opcode::ConditionalSelect32;
+            value_index = 1;
+            break;
+        case IR::Opcode::SetNFlag:
+            get_opcode = IR::Opcode::GetNFlag;
+            break;
+        case IR::Opcode::SetZFlag:
+            get_opcode = IR::Opcode::GetZFlag;
+            break;
+        case IR::Opcode::SetCFlag:
+            get_opcode = IR::Opcode::GetCFlag;
+            break;
+        case IR::Opcode::SetVFlag:
+            get_opcode = IR::Opcode::GetVFlag;
+            break;
+        case IR::Opcode::SetGEFlags:
+            get_opcode = IR::Opcode::GetGEFlags;
+            select_opcode = IR::Opcode::ConditionalSelect32;
+            break;
+        default:
+            break;
+        }
+        if (!get_opcode)
+            continue;
+
+        // New instructions go before iter, so the loop does not visit them.
+        const auto old_value = *get_opcode == IR::Opcode::GetRegister
+                               ? block.PrependNewInst(iter, *get_opcode, {iter->GetArg(0)})
+                               : block.PrependNewInst(iter, *get_opcode, {});
+        const auto selected = block.PrependNewInst(iter, select_opcode, {passed, iter->GetArg(value_index), IR::Value(&*old_value)});
+        iter->SetArg(value_index, IR::Value(&*selected));
+    }
+}
+
+void EraseInstructionsFrom(IR::Block& block, IR::Block::iterator first) {
+    if (first == block.end())
+        return;
+
+    // Erase in reverse so that every instruction has no remaining uses when it is erased.
+    while (true) {
+        const auto last = std::prev(block.end());
+        const bool done = last == first;
+        last->Invalidate();
+        block.Instructions().erase(last);
+        if (done)
+            break;
+    }
+}
+
+} // namespace Arm
+} // namespace Dynarmic
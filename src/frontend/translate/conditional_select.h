@@ -0,0 +1,32 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/value.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+/**
+ * Determines whether the instructions from `first` to the end of `block` can be predicated with
+ * PredicateWithSelects, that is whether they only compute values and write core registers other
+ * than the PC and flags.
+ */
+bool CanPredicateWithSelects(IR::Block& block, IR::Block::iterator first);
+
+/**
+ * Makes each write to a core register or flag from `first` to the end of `block` select between the
+ * value written and the value it replaces, so that it only takes effect if `passed` is set.
+ */
+void PredicateWithSelects(IR::Block& block, IR::Block::iterator first, IR::Value passed);
+
+/// Removes the instructions from `first` to the end of `block`.
+void EraseInstructionsFrom(IR::Block& block, IR::Block::iterator first);
+
+} // namespace Arm
+} // namespace Dynarmic
@@ -4,18 +4,105 @@
  * General Public License version 2 or any later version.
  */
 
+#include <cstring>
+
+#include "common/bit_util.h"
 #include "frontend/ir/basic_block.h"
+#include "frontend/ir/ir_emitter.h"
 #include "frontend/ir/location_descriptor.h"
 #include "frontend/translate/translate.h"
 
 namespace Dynarmic {
 namespace Arm {
 
-IR::Block TranslateArm(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code);
-IR::Block TranslateThumb(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code);
+u32 CodeReader::ReadWord(u32 vaddr) {
+    constexpr u32 page_mask = 0xFFF;
+
+    if (memory_get_code_page) {
+        const u32 page_vaddr = vaddr & ~page_mask;
+        if (!has_cached_page || page_vaddr != cached_page_vaddr) {
+            cached_page = memory_get_code_page(page_vaddr);
+            cached_page_vaddr = page_vaddr;
+            has_cached_page = true;
+        }
+        if (cached_page) {
+            u32 word;
+            std::memcpy(&word, cached_page + (vaddr & page_mask), sizeof(word));
+            return word;
+        }
+    }
+    return memory_read_code(vaddr);
+}
+
+size_t InstructionCycles(const IR::Block& block, u32 vaddr, u32 instruction, const TranslationOptions& options) {
+    if (options.instruction_cycles)
+        return options.instruction_cycles(vaddr, instruction);
+
+    const CycleCosts& costs = options.cycle_costs;
+    if (costs.memory_access == 0 && costs.multiply == 0)
+        return costs.instruction;
+
+    size_t memory_accesses = 0;
+    size_t multiplies = 0;
+    for (auto iter = block.end(); iter != block.begin();) {
+        --iter;
+        if (iter->GuestPC() != vaddr)
+            break;
+
+        switch (iter->GetOpcode()) {
+        case IR::Opcode::ReadMemoryToRegisters:
+        case IR::Opcode::WriteMemoryFromRegisters:
+            memory_accesses += Common::BitCount(iter->GetArg(1).GetU32());
+            break;
+        case IR::Opcode::ReadMemoryToExtRegisters:
+        case IR::Opcode::WriteMemoryFromExtRegisters:
+            memory_accesses += iter->GetArg(2).GetU8();
+            break;
+        case IR::Opcode::ReadMemory128:
+        case IR::Opcode::WriteMemory128:
+            // Counted as the two double registers it transfers.
+            memory_accesses += 2;
+            break;
+        case IR::Opcode::Mul:
+        case IR::Opcode::Mul64:
+            multiplies++;
+            break;
+        default:
+            if (iter->IsMemoryReadOrWrite()) {
+                memory_accesses++;
+            }
+            break;
+        }
+    }
+    return costs.instruction + memory_accesses * costs.memory_access + multiplies * costs.multiply;
+}
+
+IR::Block TranslateArm(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options);
+IR::Block TranslateThumb(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options);
+
+IR::Block Translate(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options) {
+    IR::Block block = (descriptor.TFlag() ? TranslateThumb : TranslateArm)(descriptor, memory_read_code, options);
+    if (options.is_breakpoint && options.is_breakpoint(descriptor.PC())) {
+        block.SetBreakpoint();
+    }
+    return block;
+}
+
+IR::Block TranslateHostFunctionCall(IR::LocationDescriptor descriptor, u64 host_function, const TranslationOptions& options) {
+    IR::IREmitter ir{descriptor};
+
+    // The return address is read first so that the host function is free to use LR.
+    const IR::Value return_address = ir.GetRegister(Reg::LR);
+    ir.CallHostFunction(ir.Imm64(host_function));
+    ir.BXWritePC(return_address);
+    if (options.profile_calls) {
+        ir.ProfileReturn(return_address, ir.Imm32(0));
+    }
+    ir.SetTerm(IR::Term::CheckHalt{IR::Term::PopRSBHint{}});
 
-IR::Block Translate(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code) {
-    return (descriptor.TFlag() ? TranslateThumb : TranslateArm)(descriptor, memory_read_code);
+    ir.block.CycleCount() = 1;
+    ir.block.AppendGuestRange(descriptor.PC(), descriptor.PC() + 1);
+    return std::move(ir.block);
 }
 
 } // namespace Arm
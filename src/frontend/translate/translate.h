@@ -5,6 +5,9 @@
  */
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include "common/common_types.h"
 
 namespace Dynarmic {
@@ -19,14 +22,98 @@ namespace Arm {
 struct LocationDescriptor;
 
 using MemoryReadCodeFuncType = u32 (*)(u32 vaddr);
+using MemoryGetCodePageFuncType = const u8* (*)(u32 vaddr);
+
+/// The cycles each guest instruction counts for, by what it does (see TranslationOptions::cycle_costs).
+struct CycleCosts {
+    /// Counted for every instruction.
+    size_t instruction = 1;
+    /// Added for each memory access; LDM, STM, VLDM and VSTM add it for each register they transfer.
+    size_t memory_access = 0;
+    /// Added for each multiply, including those of multiply-accumulates and long multiplies.
+    size_t multiply = 0;
+};
+
+struct TranslationOptions {
+    /// If nonzero, translation continues at the target of unconditional direct branches (B, BL)
+    /// instead of ending the block, as long as the block has fewer than this many instructions.
+    size_t superblock_instruction_budget = 0;
+    /// The PCs of the blocks on a path recorded through the code, starting at the block being translated.
+    /// Where a conditional branch goes on to the next of them, translation continues in that direction,
+    /// as it does for superblocks, and a SideExit leaves the block if the branch goes the other way.
+    /// Only the ARM translator follows a trace.
+    std::vector<u32> trace;
+    /// If nonzero, the block ends after this many instructions, linking to the one that follows them.
+    size_t max_block_instructions = 0;
+    /// If not nullptr, returns a host pointer to the 4 KiB page of code containing vaddr, or nullptr.
+    /// Instructions in such pages are read directly instead of through memory_read_code.
+    MemoryGetCodePageFuncType memory_get_code_page = nullptr;
+    /// If set, returns true for addresses whose guest code must start a block of its own, e.g. because
+    /// it is replaced by a host function. Branches to such addresses are not followed.
+    std::function<bool(u32 vaddr)> starts_own_block;
+    /// If set, returns true for addresses with a breakpoint. Translation of a block stops before such an
+    /// address, and a block starting at one is marked with IR::Block::SetBreakpoint. Branches to these
+    /// addresses should not be followed either (see starts_own_block).
+    std::function<bool(u32 vaddr)> is_breakpoint;
+    /// If set, the hint instructions YIELD, WFE, WFI and SEV end the block with a CallHint instruction
+    /// instead of being translated as NOPs.
+    bool call_hints = false;
+    /// If set, the pairs of double registers that make up quad registers are transferred by VLD1, VST1, VLDM,
+    /// VSTM, VPUSH and VPOP with a ReadMemory128 or WriteMemory128 each, rather than by a block transfer.
+    bool vector_memory_accesses = false;
+    /// If set, MRC reads of the PMU cycle counter PMCCNTR are translated as GetCycleCounter instead of CoprocGetOneWord.
+    bool inline_cycle_counter = false;
+    /// If set, BL and BLX are followed by a ProfileCall instruction, and returns (BX LR, pops of PC, and
+    /// the return of TranslateHostFunctionCall) by a ProfileReturn.
+    bool profile_calls = false;
+    /// The cycles that each translated instruction adds to IR::Block::CycleCount. An instruction whose
+    /// condition fails always counts for one cycle.
+    CycleCosts cycle_costs;
+    /// If set, returns the cycles the instruction at vaddr counts for, in place of cycle_costs. For a
+    /// 32-bit Thumb instruction, `instruction` holds its first halfword in its upper half.
+    std::function<size_t(u32 vaddr, u32 instruction)> instruction_cycles;
+};
+
+/// Reads the instruction words of a block, directly from host memory where possible.
+class CodeReader {
+public:
+    CodeReader(MemoryReadCodeFuncType memory_read_code, MemoryGetCodePageFuncType memory_get_code_page)
+        : memory_read_code(memory_read_code), memory_get_code_page(memory_get_code_page) {}
+
+    /// Reads the little-endian word at the 4-byte aligned address vaddr.
+    u32 ReadWord(u32 vaddr);
+
+private:
+    MemoryReadCodeFuncType memory_read_code;
+    MemoryGetCodePageFuncType memory_get_code_page;
+
+    bool has_cached_page = false;
+    u32 cached_page_vaddr = 0;
+    const u8* cached_page = nullptr;
+};
+
+/**
+ * The cycles that the instruction at vaddr counts for, according to options. Its IR must be the last
+ * instructions of block.
+ */
+size_t InstructionCycles(const IR::Block& block, u32 vaddr, u32 instruction, const TranslationOptions& options);
 
 /**
  * This function translates instructions in memory into our intermediate representation.
  * @param descriptor The starting location of the basic block. Includes information like PC, Thumb state, &c.
  * @param memory_read_code The function we should use to read emulated memory.
+ * @param options Options that control how code is read and how much of it is translated into the block.
  * @return A translated basic block in the intermediate representation.
  */
-IR::Block Translate(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code);
+IR::Block Translate(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options = {});
+
+/**
+ * Builds a block that calls a host function in place of the guest function at descriptor, then returns
+ * to the address that was in LR on entry. The block is one cycle long.
+ * @param host_function Opaque to the frontend; passed to the CallHostFunction instruction.
+ * @param options Only profile_calls is used.
+ */
+IR::Block TranslateHostFunctionCall(IR::LocationDescriptor descriptor, u64 host_function, const TranslationOptions& options = {});
 
 } // namespace Arm
 } // namespace Dynarmic
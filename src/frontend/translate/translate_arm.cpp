@@ -5,13 +5,17 @@
  */
 
 #include <algorithm>
+#include <iterator>
 
 #include "common/assert.h"
+#include "common/bit_util.h"
 #include "frontend/arm/types.h"
 #include "frontend/decoder/arm.h"
+#include "frontend/decoder/asimd.h"
 #include "frontend/decoder/vfp2.h"
 #include "frontend/ir/basic_block.h"
 #include "frontend/ir/location_descriptor.h"
+#include "frontend/translate/conditional_select.h"
 #include "frontend/translate/translate.h"
 #include "frontend/translate/translate_arm/translate_arm.h"
 
@@ -28,28 +32,110 @@ static bool CondCanContinue(ConditionalState cond_state, const IR::IREmitter& ir
     return std::all_of(ir.block.begin(), ir.block.end(), [](const IR::Inst& inst) { return !inst.WritesToCPSR(); });
 }
 
-IR::Block TranslateArm(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code) {
-    ArmTranslatorVisitor visitor{descriptor};
+/**
+ * Whether a conditional instruction would end the block, so should rather be translated inline with
+ * TranslateWithSelects. A run of instructions with the condition of the block stays as it is.
+ */
+static bool ShouldTranslateWithSelects(Cond cond, const ArmTranslatorVisitor& visitor) {
+    if (cond == Cond::AL || cond == Cond::NV || visitor.ir.block.empty())
+        return false;
+    return visitor.cond_state != ConditionalState::Translating
+           || visitor.ir.block.ConditionFailedLocation() != visitor.ir.current_location
+           || visitor.ir.block.GetCondition() != cond;
+}
+
+/**
+ * Translates a conditional instruction inline, making each register and flag it writes select between
+ * its new and old values depending on `cond`. An instruction that does anything else is removed again,
+ * and false is returned to have it predicated some other way.
+ */
+template <typename TranslateFn>
+bool ArmTranslatorVisitor::TranslateWithSelects(Cond cond, TranslateFn translate, bool& should_continue) {
+    IR::Block& block = ir.block;
+    const auto passed = ir.TestCondition(cond);
+    const auto test_inst = std::prev(block.end());
+
+    translating_with_selects = true;
+    should_continue = translate();
+    translating_with_selects = false;
+
+    const bool selectable = should_continue && !branch_target && !block.HasTerminal()
+                            && CanPredicateWithSelects(block, std::next(test_inst));
+    if (!selectable) {
+        EraseInstructionsFrom(block, test_inst);
+        if (block.HasTerminal())
+            block.ReplaceTerminal(IR::Term::Invalid{});
+        branch_target = boost::none;
+        return false;
+    }
+
+    PredicateWithSelects(block, std::next(test_inst), passed);
+    return true;
+}
+
+IR::Block TranslateArm(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options) {
+    ArmTranslatorVisitor visitor{descriptor, options};
+    CodeReader code_reader{memory_read_code, options.memory_get_code_page};
 
     bool should_continue = true;
     while (should_continue && CondCanContinue(visitor.cond_state, visitor.ir)) {
         const u32 arm_pc = visitor.ir.current_location.PC();
-        const u32 arm_instruction = memory_read_code(arm_pc);
+        if (visitor.trace_position + 1 < options.trace.size() && arm_pc == options.trace[visitor.trace_position + 1]) {
+            visitor.trace_position++;
+        }
 
-        if (auto vfp_decoder = DecodeVFP2<ArmTranslatorVisitor>(arm_instruction)) {
-            should_continue = vfp_decoder->call(visitor, arm_instruction);
-        } else if (auto decoder = DecodeArm<ArmTranslatorVisitor>(arm_instruction)) {
-            should_continue = decoder->call(visitor, arm_instruction);
-        } else {
-            should_continue = visitor.arm_UDF();
+        // A breakpoint starts a block of its own, so that execution can stop before it.
+        if (visitor.instruction_count != 0 && options.is_breakpoint && options.is_breakpoint(arm_pc)) {
+            if (visitor.cond_state == ConditionalState::None) {
+                visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+            }
+            break;
+        }
+
+        const u32 arm_instruction = code_reader.ReadWord(arm_pc);
+
+        const auto translate_instruction = [&]{
+            if (auto vfp_decoder = DecodeVFP2<ArmTranslatorVisitor>(arm_instruction)) {
+                return vfp_decoder->call(visitor, arm_instruction);
+            } else if (auto asimd_decoder = DecodeASIMD<ArmTranslatorVisitor>(arm_instruction)) {
+                return asimd_decoder->call(visitor, arm_instruction);
+            } else if (auto decoder = DecodeArm<ArmTranslatorVisitor>(arm_instruction)) {
+                return decoder->call(visitor, arm_instruction);
+            }
+            return visitor.arm_UDF();
+        };
+
+        const Cond cond = static_cast<Cond>(Common::Bits<28, 31>(arm_instruction));
+        if (!ShouldTranslateWithSelects(cond, visitor) || !visitor.TranslateWithSelects(cond, translate_instruction, should_continue)) {
+            should_continue = translate_instruction();
         }
 
         if (visitor.cond_state == ConditionalState::Break) {
             break;
         }
 
-        visitor.ir.current_location = visitor.ir.current_location.AdvancePC(4);
-        visitor.ir.block.CycleCount()++;
+        if (visitor.branch_target) {
+            visitor.ir.block.AppendGuestRange(visitor.range_start, arm_pc + 4);
+            visitor.ir.current_location = *visitor.branch_target;
+            visitor.range_start = visitor.ir.current_location.PC();
+            visitor.branch_target = boost::none;
+        } else {
+            visitor.ir.current_location = visitor.ir.current_location.AdvancePC(4);
+        }
+        visitor.ir.block.CycleCount() += InstructionCycles(visitor.ir.block, arm_pc, arm_instruction, options);
+        visitor.instruction_count++;
+        if (visitor.side_exit) {
+            // Taking the exit counts the cycles of the branch too.
+            visitor.side_exit->SetArg(2, IR::Value(static_cast<u32>(visitor.ir.block.CycleCount())));
+            visitor.side_exit = nullptr;
+        }
+
+        if (should_continue && options.max_block_instructions != 0 && visitor.instruction_count >= options.max_block_instructions) {
+            if (visitor.cond_state == ConditionalState::None) {
+                visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+            }
+            break;
+        }
     }
 
     if (visitor.cond_state == ConditionalState::Translating || visitor.cond_state == ConditionalState::Trailing) {
@@ -60,10 +146,15 @@ IR::Block TranslateArm(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType
 
     ASSERT_MSG(visitor.ir.block.HasTerminal(), "Terminal has not been set");
 
+    visitor.ir.block.AppendGuestRange(visitor.range_start, visitor.ir.current_location.PC());
+
     return std::move(visitor.ir.block);
 }
 
 bool ArmTranslatorVisitor::ConditionPassed(Cond cond) {
+    if (translating_with_selects)
+        return true;
+
     ASSERT_MSG(cond_state != ConditionalState::Break,
                "This should never happen. We requested a break but that wasn't honored.");
     ASSERT_MSG(cond != Cond::NV, "NV conditional is obsolete");
@@ -109,6 +200,69 @@ bool ArmTranslatorVisitor::ConditionPassed(Cond cond) {
     return true;
 }
 
+bool ArmTranslatorVisitor::FollowBranch(IR::LocationDescriptor target) {
+    if (cond_state != ConditionalState::None)
+        return false;
+    if (instruction_count + 1 >= options.superblock_instruction_budget)
+        return false;
+    // Don't translate the same code twice; loops remain separate blocks.
+    const u32 target_pc = target.PC();
+    if (ir.block.ContainsGuestAddress(target_pc) || (target_pc >= range_start && target_pc <= ir.current_location.PC()))
+        return false;
+    if (options.starts_own_block && options.starts_own_block(target_pc))
+        return false;
+
+    branch_target = target;
+    return true;
+}
+
+/// Records a call or return of the instruction being translated, if options.profile_calls is set.
+void ArmTranslatorVisitor::ProfileCall(IR::Value function, u32 return_address) {
+    if (options.profile_calls) {
+        ir.ProfileCall(function, ir.Imm32(return_address), ir.Imm32(static_cast<u32>(ir.block.CycleCount())));
+    }
+}
+
+void ArmTranslatorVisitor::ProfileReturn(IR::Value target) {
+    if (options.profile_calls) {
+        ir.ProfileReturn(target, ir.Imm32(static_cast<u32>(ir.block.CycleCount())));
+    }
+}
+
+/**
+ * Whether translation should continue past a conditional branch in the direction that the trace being
+ * translated took (see TranslationOptions::trace), rather than ending the block. If so, a SideExit
+ * leaves the block for the other direction, and translation continues as for FollowBranch.
+ */
+bool ArmTranslatorVisitor::FollowTrace(Cond cond, IR::LocationDescriptor taken, IR::LocationDescriptor not_taken) {
+    if (trace_position + 1 >= options.trace.size())
+        return false;
+
+    const u32 next_pc = options.trace[trace_position + 1];
+    if (next_pc != taken.PC() && next_pc != not_taken.PC())
+        return false;
+    const bool follow_taken = next_pc == taken.PC();
+    if (!FollowBranch(follow_taken ? taken : not_taken))
+        return false;
+
+    // Conditions come in inverse pairs.
+    const Cond exit_cond = follow_taken ? static_cast<Cond>(static_cast<size_t>(cond) ^ 1) : cond;
+    ir.SideExit(ir.TestCondition(exit_cond), follow_taken ? not_taken : taken, ir.Imm32(0));
+    side_exit = &ir.block.back();
+    return true;
+}
+
+/**
+ * Whether a conditional branch can end the current block with an If terminal, rather than ending the
+ * block before it so the branch starts a conditional block of its own. This keeps a flag-setting
+ * instruction and the branch that tests its result in the same block.
+ */
+bool ArmTranslatorVisitor::CanBranchWithIf(Cond cond) const {
+    if (cond == Cond::AL || cond == Cond::NV || translating_with_selects || ir.block.empty())
+        return false;
+    return cond_state == ConditionalState::None || cond_state == ConditionalState::Trailing;
+}
+
 bool ArmTranslatorVisitor::InterpretThisInstruction() {
     ir.SetTerm(IR::Term::Interpret(ir.current_location));
     return false;
@@ -119,6 +273,31 @@ bool ArmTranslatorVisitor::UnpredictableInstruction() {
     return false;
 }
 
+bool ArmTranslatorVisitor::InPrivilegedMode() const {
+    return ir.current_location.Mode() != Arm::PSR::Mode::User;
+}
+
+/// Ends the block with an exception return to new_pc, restoring CPSR from the current mode's SPSR.
+bool ArmTranslatorVisitor::ExceptionReturn(IR::Value new_pc) {
+    return ExceptionReturn(new_pc, ir.GetSpsr());
+}
+
+/// Ends the block with an exception return to new_pc in the state given by new_cpsr.
+bool ArmTranslatorVisitor::ExceptionReturn(IR::Value new_pc, IR::Value new_cpsr) {
+    const auto mode = ir.current_location.Mode();
+    if (mode == Arm::PSR::Mode::User || mode == Arm::PSR::Mode::System)
+        return UnpredictableInstruction();
+
+    ir.SetCpsrAndSwitchMode(new_cpsr);
+    ir.ExceptionReturnWritePC(new_pc, new_cpsr);
+    ir.SetTerm(IR::Term::ReturnToDispatch{});
+    return false;
+}
+
+IR::Value ArmTranslatorVisitor::WritePsrMasked(IR::Value old_psr, IR::Value value, u32 mask) {
+    return ir.Or(ir.And(old_psr, ir.Imm32(~mask)), ir.And(value, ir.Imm32(mask)));
+}
+
 IR::IREmitter::ResultAndCarry ArmTranslatorVisitor::EmitImmShift(IR::Value value, ShiftType type, Imm5 imm5, IR::Value carry_in) {
     switch (type) {
     case ShiftType::LSL:
@@ -0,0 +1,330 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include "common/bit_util.h"
+
+#include "translate_arm.h"
+
+namespace Dynarmic {
+namespace Arm {
+
+static ExtReg ToVector(bool Q, size_t base, bool bit) {
+    if (Q) {
+        return static_cast<ExtReg>(static_cast<size_t>(ExtReg::Q0) + (base >> 1) + (bit ? 8 : 0));
+    } else {
+        return static_cast<ExtReg>(static_cast<size_t>(ExtReg::D0) + base + (bit ? 16 : 0));
+    }
+}
+
+// Advanced SIMD three register instructions
+
+bool ArmTranslatorVisitor::asimd_VAND_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VAND <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorAnd(reg_n, reg_m));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VBIC_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VBIC <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorAnd(reg_n, ir.VectorNot(reg_m)));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VORR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VORR <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorOr(reg_n, reg_m));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VORN_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VORN <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorOr(reg_n, ir.VectorNot(reg_m)));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VEOR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VEOR <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorEor(reg_n, reg_m));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VBSL(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VBSL <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_d = ir.GetVector(d);
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorOr(ir.VectorAnd(reg_n, reg_d), ir.VectorAnd(reg_m, ir.VectorNot(reg_d))));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VBIT(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VBIT <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_d = ir.GetVector(d);
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorOr(ir.VectorAnd(reg_n, reg_m), ir.VectorAnd(reg_d, ir.VectorNot(reg_m))));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VBIF(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VBIF <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_d = ir.GetVector(d);
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    ir.SetVector(d, ir.VectorOr(ir.VectorAnd(reg_d, reg_m), ir.VectorAnd(reg_n, ir.VectorNot(reg_m))));
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VADD_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VADD.I<size> <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    switch (sz) {
+    case 0b00:
+        ir.SetVector(d, ir.VectorAdd8(reg_n, reg_m));
+        break;
+    case 0b01:
+        ir.SetVector(d, ir.VectorAdd16(reg_n, reg_m));
+        break;
+    case 0b10:
+        ir.SetVector(d, ir.VectorAdd32(reg_n, reg_m));
+        break;
+    case 0b11:
+        ir.SetVector(d, ir.VectorAdd64(reg_n, reg_m));
+        break;
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VSUB_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VSUB.I<size> <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    switch (sz) {
+    case 0b00:
+        ir.SetVector(d, ir.VectorSub8(reg_n, reg_m));
+        break;
+    case 0b01:
+        ir.SetVector(d, ir.VectorSub16(reg_n, reg_m));
+        break;
+    case 0b10:
+        ir.SetVector(d, ir.VectorSub32(reg_n, reg_m));
+        break;
+    case 0b11:
+        ir.SetVector(d, ir.VectorSub64(reg_n, reg_m));
+        break;
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VMUL_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm) {
+    if (sz == 0b11)
+        return arm_UDF();
+    if (Q && ((Vd | Vn | Vm) & 1))
+        return arm_UDF();
+    if (sz == 0b00)
+        return InterpretThisInstruction(); // TODO: There is no x64 instruction for byte multiplication.
+
+    ExtReg d = ToVector(Q, Vd, D);
+    ExtReg n = ToVector(Q, Vn, N);
+    ExtReg m = ToVector(Q, Vm, M);
+    // VMUL.I<size> <{D,Q}d>, <{D,Q}n>, <{D,Q}m>
+    auto reg_n = ir.GetVector(n);
+    auto reg_m = ir.GetVector(m);
+    auto result = sz == 0b01
+                  ? ir.VectorMultiply16(reg_n, reg_m)
+                  : ir.VectorMultiply32(reg_n, reg_m);
+    ir.SetVector(d, result);
+    return true;
+}
+
+// Advanced SIMD load-store instructions
+
+/// Whether the transfer of `count` extension registers from `first` can be made by 128-bit accesses.
+static bool IsQuadTransfer(ExtReg first, size_t count) {
+    return IsDoubleExtReg(first) && RegNumber(first) % 2 == 0 && count >= 2;
+}
+
+void ArmTranslatorVisitor::ReadExtRegisters(IR::Value vaddr, ExtReg first, size_t count) {
+    if (!options.vector_memory_accesses || ir.current_location.EFlag() || !IsQuadTransfer(first, count)) {
+        ir.ReadMemoryToExtRegisters(vaddr, first, count);
+        return;
+    }
+
+    const ExtReg first_q = ExtReg::Q0 + RegNumber(first) / 2;
+    for (size_t i = 0; i < count / 2; i++) {
+        auto address = i == 0 ? vaddr : ir.Add(vaddr, ir.Imm32(static_cast<u32>(16 * i)));
+        ir.SetVector(first_q + i, ir.ReadMemory128(address));
+    }
+    if (count % 2 != 0) {
+        ir.ReadMemoryToExtRegisters(ir.Add(vaddr, ir.Imm32(static_cast<u32>(8 * (count - 1)))), first + (count - 1), 1);
+    }
+}
+
+void ArmTranslatorVisitor::WriteExtRegisters(IR::Value vaddr, ExtReg first, size_t count) {
+    if (!options.vector_memory_accesses || ir.current_location.EFlag() || !IsQuadTransfer(first, count)) {
+        ir.WriteMemoryFromExtRegisters(vaddr, first, count);
+        return;
+    }
+
+    const ExtReg first_q = ExtReg::Q0 + RegNumber(first) / 2;
+    for (size_t i = 0; i < count / 2; i++) {
+        auto address = i == 0 ? vaddr : ir.Add(vaddr, ir.Imm32(static_cast<u32>(16 * i)));
+        ir.WriteMemory128(address, ir.GetVector(first_q + i));
+    }
+    if (count % 2 != 0) {
+        ir.WriteMemoryFromExtRegisters(ir.Add(vaddr, ir.Imm32(static_cast<u32>(8 * (count - 1)))), first + (count - 1), 1);
+    }
+}
+
+/// Number of registers transferred by VLD1 and VST1 (multiple single elements), or 0 if the encoding is UNDEFINED.
+static size_t GetVLD1RegisterCount(size_t type, size_t align) {
+    switch (type) {
+    case 0b0111:
+        return Common::Bit<1>(align) ? 0 : 1;
+    case 0b1010:
+        return align == 0b11 ? 0 : 2;
+    case 0b0110:
+        return Common::Bit<1>(align) ? 0 : 3;
+    case 0b0010:
+        return 4;
+    }
+    ASSERT_MSG(false, "Not a VLD1 or VST1 type");
+    return 0;
+}
+
+static bool IsVLD1Type(size_t type) {
+    return type == 0b0111 || type == 0b1010 || type == 0b0110 || type == 0b0010;
+}
+
+bool ArmTranslatorVisitor::asimd_VST1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m) {
+    if (!IsVLD1Type(type))
+        return InterpretThisInstruction(); // TODO: Other element and structure load-store instructions
+
+    const size_t regs = GetVLD1RegisterCount(type, align);
+    if (regs == 0)
+        return arm_UDF();
+
+    ExtReg d = ToVector(false, Vd, D);
+    if (n == Reg::PC || RegNumber(d) + regs > 32)
+        return UnpredictableInstruction();
+
+    // Only little-endian transfers are word-for-word. Big-endian ones reverse each element of size sz.
+    UNUSED(sz);
+    if (ir.current_location.EFlag())
+        return InterpretThisInstruction();
+
+    // VST1.<size> <list>, [<Rn>{:<align>}]{!}
+    // VST1.<size> <list>, [<Rn>{:<align>}], <Rm>
+    auto address = ir.GetRegister(n);
+    WriteExtRegisters(address, d, regs);
+    if (m != Reg::PC) {
+        auto offset = m == Reg::SP ? ir.Imm32(static_cast<u32>(8 * regs)) : ir.GetRegister(m);
+        ir.SetRegister(n, ir.Add(address, offset));
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::asimd_VLD1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m) {
+    if (!IsVLD1Type(type))
+        return InterpretThisInstruction(); // TODO: Other element and structure load-store instructions
+
+    const size_t regs = GetVLD1RegisterCount(type, align);
+    if (regs == 0)
+        return arm_UDF();
+
+    ExtReg d = ToVector(false, Vd, D);
+    if (n == Reg::PC || RegNumber(d) + regs > 32)
+        return UnpredictableInstruction();
+
+    // Only little-endian transfers are word-for-word. Big-endian ones reverse each element of size sz.
+    UNUSED(sz);
+    if (ir.current_location.EFlag())
+        return InterpretThisInstruction();
+
+    // VLD1.<size> <list>, [<Rn>{:<align>}]{!}
+    // VLD1.<size> <list>, [<Rn>{:<align>}], <Rm>
+    auto address = ir.GetRegister(n);
+    ReadExtRegisters(address, d, regs);
+    if (m != Reg::PC) {
+        auto offset = m == Reg::SP ? ir.Imm32(static_cast<u32>(8 * regs)) : ir.GetRegister(m);
+        ir.SetRegister(n, ir.Add(address, offset));
+    }
+    return true;
+}
+
+} // namespace Arm
+} // namespace Dynarmic
@@ -14,8 +14,18 @@ namespace Arm {
 bool ArmTranslatorVisitor::arm_B(Cond cond, Imm24 imm24) {
     u32 imm32 = Common::SignExtend<26, u32>(imm24 << 2) + 8;
     // B <label>
+    if (CanBranchWithIf(cond)) {
+        auto then_location = ir.current_location.AdvancePC(imm32);
+        auto else_location = ir.current_location.AdvancePC(4);
+        if (FollowTrace(cond, then_location, else_location))
+            return true;
+        ir.SetTerm(IR::Term::If{cond, IR::Term::LinkBlock{then_location}, IR::Term::LinkBlock{else_location}});
+        return false;
+    }
     if (ConditionPassed(cond)) {
         auto new_location = ir.current_location.AdvancePC(imm32);
+        if (cond == Cond::AL && FollowBranch(new_location))
+            return true;
         ir.SetTerm(IR::Term::LinkBlock{ new_location });
         return false;
     }
@@ -29,6 +39,9 @@ bool ArmTranslatorVisitor::arm_BL(Cond cond, Imm24 imm24) {
         ir.PushRSB(ir.current_location.AdvancePC(4));
         ir.SetRegister(Reg::LR, ir.Imm32(ir.current_location.PC() + 4));
         auto new_location = ir.current_location.AdvancePC(imm32);
+        ProfileCall(ir.Imm32(new_location.PC()), ir.current_location.PC() + 4);
+        if (cond == Cond::AL && FollowBranch(new_location))
+            return true;
         ir.SetTerm(IR::Term::LinkBlock{ new_location });
         return false;
     }
@@ -41,6 +54,7 @@ bool ArmTranslatorVisitor::arm_BLX_imm(bool H, Imm24 imm24) {
     ir.PushRSB(ir.current_location.AdvancePC(4));
     ir.SetRegister(Reg::LR, ir.Imm32(ir.current_location.PC() + 4));
     auto new_location = ir.current_location.AdvancePC(imm32).SetTFlag(true);
+    ProfileCall(ir.Imm32(new_location.PC()), ir.current_location.PC() + 4);
     ir.SetTerm(IR::Term::LinkBlock{ new_location });
     return false;
 }
@@ -51,8 +65,10 @@ bool ArmTranslatorVisitor::arm_BLX_reg(Cond cond, Reg m) {
     // BLX <Rm>
     if (ConditionPassed(cond)) {
         ir.PushRSB(ir.current_location.AdvancePC(4));
-        ir.BXWritePC(ir.GetRegister(m));
+        const auto target = ir.GetRegister(m);
+        ir.BXWritePC(target);
         ir.SetRegister(Reg::LR, ir.Imm32(ir.current_location.PC() + 4));
+        ProfileCall(target, ir.current_location.PC() + 4);
         ir.SetTerm(IR::Term::ReturnToDispatch{});
         return false;
     }
@@ -62,11 +78,14 @@ bool ArmTranslatorVisitor::arm_BLX_reg(Cond cond, Reg m) {
 bool ArmTranslatorVisitor::arm_BX(Cond cond, Reg m) {
     // BX <Rm>
     if (ConditionPassed(cond)) {
-        ir.BXWritePC(ir.GetRegister(m));
-        if (m == Reg::R14)
+        const auto target = ir.GetRegister(m);
+        ir.BXWritePC(target);
+        if (m == Reg::R14) {
+            ProfileReturn(target);
             ir.SetTerm(IR::Term::PopRSBHint{});
-        else
+        } else {
             ir.SetTerm(IR::Term::ReturnToDispatch{});
+        }
         return false;
     }
     return true;
@@ -88,7 +88,11 @@ bool ArmTranslatorVisitor::arm_MRC(Cond cond, size_t opc1, CoprocReg CRn, Reg t,
 
     // MRC{2} <coproc_no>, #<opc1>, <Rt>, <CRn>, <CRm>, #<opc2>
     if (two || ConditionPassed(cond)) {
-        auto word = ir.CoprocGetOneWord(coproc_no, two, opc1, CRn, CRm, opc2);
+        const bool is_pmccntr = coproc_no == 15 && !two && opc1 == 0 && CRn == CoprocReg::C9 && CRm == CoprocReg::C13 && opc2 == 0;
+        // The cycles of this block are only counted when it ends, so add those of the instructions before this one.
+        auto word = is_pmccntr && options.inline_cycle_counter
+                  ? ir.GetCycleCounter(ir.Imm32(static_cast<u32>(ir.block.CycleCount())))
+                  : ir.CoprocGetOneWord(coproc_no, two, opc1, CRn, CRm, opc2);
         if (t != Reg::PC) {
             ir.SetRegister(t, word);
         } else {
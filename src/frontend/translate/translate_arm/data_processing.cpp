@@ -16,7 +16,8 @@ bool ArmTranslatorVisitor::arm_ADC_imm(Cond cond, bool S, Reg n, Reg d, int rota
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.GetCFlag());
 
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -38,7 +39,8 @@ bool ArmTranslatorVisitor::arm_ADC_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.AddWithCarry(ir.GetRegister(n), shifted.result, ir.GetCFlag());
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -78,7 +80,8 @@ bool ArmTranslatorVisitor::arm_ADD_imm(Cond cond, bool S, Reg n, Reg d, int rota
         u32 imm32 = ArmExpandImm(rotate, imm8);
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(0));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -99,7 +102,8 @@ bool ArmTranslatorVisitor::arm_ADD_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.AddWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(0));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -139,7 +143,8 @@ bool ArmTranslatorVisitor::arm_AND_imm(Cond cond, bool S, Reg n, Reg d, int rota
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.And(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -160,7 +165,8 @@ bool ArmTranslatorVisitor::arm_AND_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
         auto result = ir.And(ir.GetRegister(n), shifted.result);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -198,7 +204,8 @@ bool ArmTranslatorVisitor::arm_BIC_imm(Cond cond, bool S, Reg n, Reg d, int rota
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.And(ir.GetRegister(n), ir.Not(ir.Imm32(imm_carry.imm32)));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -217,9 +224,10 @@ bool ArmTranslatorVisitor::arm_BIC_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
     if (ConditionPassed(cond)) {
         auto carry_in = ir.GetCFlag();
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
-        auto result = ir.And(ir.GetRegister(n), ir.Not(shifted.result));
+        auto result = ir.AndNot(ir.GetRegister(n), shifted.result);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -241,7 +249,7 @@ bool ArmTranslatorVisitor::arm_BIC_rsr(Cond cond, bool S, Reg n, Reg d, Reg s, S
         auto shift_n = ir.LeastSignificantByte(ir.GetRegister(s));
         auto carry_in = ir.GetCFlag();
         auto shifted = EmitRegShift(ir.GetRegister(m), shift, shift_n, carry_in);
-        auto result = ir.And(ir.GetRegister(n), ir.Not(shifted.result));
+        auto result = ir.AndNot(ir.GetRegister(n), shifted.result);
         ir.SetRegister(d, result);
         if (S) {
             ir.SetNFlag(ir.MostSignificantBit(result));
@@ -338,7 +346,8 @@ bool ArmTranslatorVisitor::arm_EOR_imm(Cond cond, bool S, Reg n, Reg d, int rota
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.Eor(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -359,7 +368,8 @@ bool ArmTranslatorVisitor::arm_EOR_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
         auto result = ir.Eor(ir.GetRegister(n), shifted.result);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -397,7 +407,8 @@ bool ArmTranslatorVisitor::arm_MOV_imm(Cond cond, bool S, Reg d, int rotate, Imm
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.Imm32(imm_carry.imm32);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -418,7 +429,8 @@ bool ArmTranslatorVisitor::arm_MOV_reg(Cond cond, bool S, Reg d, Imm5 imm5, Shif
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
         auto result = shifted.result;
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -451,12 +463,36 @@ bool ArmTranslatorVisitor::arm_MOV_rsr(Cond cond, bool S, Reg d, Reg s, ShiftTyp
     return true;
 }
 
+bool ArmTranslatorVisitor::arm_MOVT(Cond cond, Imm4 imm4, Reg d, Imm12 imm12) {
+    if (d == Reg::PC)
+        return UnpredictableInstruction();
+    // MOVT<c> <Rd>, #<imm16>
+    if (ConditionPassed(cond)) {
+        u32 imm16 = (imm4 << 12) | imm12;
+        auto lower_half = ir.And(ir.GetRegister(d), ir.Imm32(0x0000FFFF));
+        ir.SetRegister(d, ir.Or(lower_half, ir.Imm32(imm16 << 16)));
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_MOVW(Cond cond, Imm4 imm4, Reg d, Imm12 imm12) {
+    if (d == Reg::PC)
+        return UnpredictableInstruction();
+    // MOVW<c> <Rd>, #<imm16>
+    if (ConditionPassed(cond)) {
+        u32 imm16 = (imm4 << 12) | imm12;
+        ir.SetRegister(d, ir.Imm32(imm16));
+    }
+    return true;
+}
+
 bool ArmTranslatorVisitor::arm_MVN_imm(Cond cond, bool S, Reg d, int rotate, Imm8 imm8) {
     if (ConditionPassed(cond)) {
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.Not(ir.Imm32(imm_carry.imm32));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -477,7 +513,8 @@ bool ArmTranslatorVisitor::arm_MVN_reg(Cond cond, bool S, Reg d, Imm5 imm5, Shif
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
         auto result = ir.Not(shifted.result);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -515,7 +552,8 @@ bool ArmTranslatorVisitor::arm_ORR_imm(Cond cond, bool S, Reg n, Reg d, int rota
         auto imm_carry = ArmExpandImm_C(rotate, imm8, ir.GetCFlag());
         auto result = ir.Or(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -536,7 +574,8 @@ bool ArmTranslatorVisitor::arm_ORR_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, carry_in);
         auto result = ir.Or(ir.GetRegister(n), shifted.result);
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result);
             ir.ALUWritePC(result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -574,7 +613,8 @@ bool ArmTranslatorVisitor::arm_RSB_imm(Cond cond, bool S, Reg n, Reg d, int rota
         u32 imm32 = ArmExpandImm(rotate, imm8);
         auto result = ir.SubWithCarry(ir.Imm32(imm32), ir.GetRegister(n), ir.Imm1(1));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -595,7 +635,8 @@ bool ArmTranslatorVisitor::arm_RSB_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.SubWithCarry(shifted.result, ir.GetRegister(n), ir.Imm1(1));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -635,7 +676,8 @@ bool ArmTranslatorVisitor::arm_RSC_imm(Cond cond, bool S, Reg n, Reg d, int rota
         u32 imm32 = ArmExpandImm(rotate, imm8);
         auto result = ir.SubWithCarry(ir.Imm32(imm32), ir.GetRegister(n), ir.GetCFlag());
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -656,7 +698,8 @@ bool ArmTranslatorVisitor::arm_RSC_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.SubWithCarry(shifted.result, ir.GetRegister(n), ir.GetCFlag());
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -696,7 +739,8 @@ bool ArmTranslatorVisitor::arm_SBC_imm(Cond cond, bool S, Reg n, Reg d, int rota
         u32 imm32 = ArmExpandImm(rotate, imm8);
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.GetCFlag());
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -717,7 +761,8 @@ bool ArmTranslatorVisitor::arm_SBC_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.SubWithCarry(ir.GetRegister(n), shifted.result, ir.GetCFlag());
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -757,7 +802,8 @@ bool ArmTranslatorVisitor::arm_SUB_imm(Cond cond, bool S, Reg n, Reg d, int rota
         u32 imm32 = ArmExpandImm(rotate, imm8);
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(1));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -778,7 +824,8 @@ bool ArmTranslatorVisitor::arm_SUB_reg(Cond cond, bool S, Reg n, Reg d, Imm5 imm
         auto shifted = EmitImmShift(ir.GetRegister(m), shift, imm5, ir.GetCFlag());
         auto result = ir.SubWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(1));
         if (d == Reg::PC) {
-            ASSERT(!S);
+            if (S)
+                return ExceptionReturn(result.result);
             ir.ALUWritePC(result.result);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
@@ -889,5 +936,54 @@ bool ArmTranslatorVisitor::arm_TST_rsr(Cond cond, Reg n, Reg s, ShiftType shift,
     return true;
 }
 
+bool ArmTranslatorVisitor::arm_BFC(Cond cond, Imm5 msb, Reg d, Imm5 lsb) {
+    if (d == Reg::PC || msb < lsb)
+        return UnpredictableInstruction();
+    // BFC<c> <Rd>, #<lsb>, #<width>
+    if (ConditionPassed(cond)) {
+        const u32 mask = static_cast<u32>((u64(1) << (msb - lsb + 1)) - 1) << lsb;
+        ir.SetRegister(d, ir.And(ir.GetRegister(d), ir.Imm32(~mask)));
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_BFI(Cond cond, Imm5 msb, Reg d, Imm5 lsb, Reg n) {
+    if (d == Reg::PC || msb < lsb)
+        return UnpredictableInstruction();
+    // BFI<c> <Rd>, <Rn>, #<lsb>, #<width>
+    if (ConditionPassed(cond)) {
+        const u32 mask = static_cast<u32>((u64(1) << (msb - lsb + 1)) - 1) << lsb;
+        auto inserted = ir.LogicalShiftLeft(ir.GetRegister(n), ir.Imm8(lsb), ir.Imm1(false)).result;
+        auto result = ir.Or(ir.And(ir.GetRegister(d), ir.Imm32(~mask)), ir.And(inserted, ir.Imm32(mask)));
+        ir.SetRegister(d, result);
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_SBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n) {
+    const size_t msb = lsb + widthm1;
+    if (d == Reg::PC || n == Reg::PC || msb > 31)
+        return UnpredictableInstruction();
+    // SBFX<c> <Rd>, <Rn>, #<lsb>, #<width>
+    if (ConditionPassed(cond)) {
+        auto shifted = ir.LogicalShiftLeft(ir.GetRegister(n), ir.Imm8(static_cast<u8>(31 - msb)), ir.Imm1(false)).result;
+        auto result = ir.ArithmeticShiftRight(shifted, ir.Imm8(static_cast<u8>(31 - widthm1)), ir.Imm1(false)).result;
+        ir.SetRegister(d, result);
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_UBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n) {
+    if (d == Reg::PC || n == Reg::PC || lsb + widthm1 > 31)
+        return UnpredictableInstruction();
+    // UBFX<c> <Rd>, <Rn>, #<lsb>, #<width>
+    if (ConditionPassed(cond)) {
+        const u32 mask = static_cast<u32>((u64(1) << (widthm1 + 1)) - 1);
+        auto shifted = ir.LogicalShiftRight(ir.GetRegister(n), ir.Imm8(lsb), ir.Imm1(false)).result;
+        ir.SetRegister(d, ir.And(shifted, ir.Imm32(mask)));
+    }
+    return true;
+}
+
 } // namespace Arm
 } // namespace Dynarmic
@@ -40,8 +40,19 @@ bool ArmTranslatorVisitor::arm_SXTAB(Cond cond, Reg n, Reg d, SignExtendRotation
 }
 
 bool ArmTranslatorVisitor::arm_SXTAB16(Cond cond, Reg n, Reg d, SignExtendRotation rotate, Reg m) {
-    UNUSED(cond, n, d, rotate, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || m == Reg::PC || n == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto rotated = SignZeroExtendRor(m, rotate);
+        auto low_byte = ir.SignExtendByteToWord(ir.LeastSignificantByte(rotated));
+        auto high_byte = ir.SignExtendByteToWord(ir.LeastSignificantByte(ir.LogicalShiftRight(rotated, ir.Imm8(16), ir.Imm1(0)).result));
+        auto lower_half = ir.And(low_byte, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(high_byte, ir.Imm8(16), ir.Imm1(0)).result;
+        auto reg_n = ir.GetRegister(n);
+        auto result = ir.PackedAddU16(reg_n, ir.Or(lower_half, upper_half)).result;
+        ir.SetRegister(d, result);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_SXTAH(Cond cond, Reg n, Reg d, SignExtendRotation rotate, Reg m) {
@@ -68,8 +79,18 @@ bool ArmTranslatorVisitor::arm_SXTB(Cond cond, Reg d, SignExtendRotation rotate,
 }
 
 bool ArmTranslatorVisitor::arm_SXTB16(Cond cond, Reg d, SignExtendRotation rotate, Reg m) {
-    UNUSED(cond, d, rotate, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto rotated = SignZeroExtendRor(m, rotate);
+        auto low_byte = ir.SignExtendByteToWord(ir.LeastSignificantByte(rotated));
+        auto high_byte = ir.SignExtendByteToWord(ir.LeastSignificantByte(ir.LogicalShiftRight(rotated, ir.Imm8(16), ir.Imm1(0)).result));
+        auto lower_half = ir.And(low_byte, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(high_byte, ir.Imm8(16), ir.Imm1(0)).result;
+        auto result = ir.Or(lower_half, upper_half);
+        ir.SetRegister(d, result);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_SXTH(Cond cond, Reg d, SignExtendRotation rotate, Reg m) {
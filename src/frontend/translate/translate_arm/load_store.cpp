@@ -100,10 +100,12 @@ bool ArmTranslatorVisitor::arm_LDR_imm(Cond cond, bool P, bool U, bool W, Reg n,
 
         if (t == Reg::PC) {
             ir.BXWritePC(data);
-            if (!P && W && n == Reg::R13)
+            if (!P && W && n == Reg::R13) {
+                ProfileReturn(data);
                 ir.SetTerm(IR::Term::PopRSBHint{});
-            else
+            } else {
                 ir.SetTerm(IR::Term::ReturnToDispatch{});
+            }
             return false;
         }
 
@@ -696,23 +698,27 @@ bool ArmTranslatorVisitor::arm_STRH_reg(Cond cond, bool P, bool U, bool W, Reg n
     return true;
 }
 
-static bool LDMHelper(IR::IREmitter& ir, bool W, Reg n, RegList list, IR::Value start_address, IR::Value writeback_address) {
+static bool LDMHelper(IR::IREmitter& ir, bool profile_calls, bool W, Reg n, RegList list, IR::Value start_address, IR::Value writeback_address) {
+    const RegList list_without_pc = list & 0x7FFF;
     auto address = start_address;
-    for (size_t i = 0; i <= 14; i++) {
-        if (Common::Bit(i, list)) {
-            ir.SetRegister(static_cast<Reg>(i), ir.ReadMemory32(address));
-            address = ir.Add(address, ir.Imm32(4));
-        }
+    if (list_without_pc != 0) {
+        ir.ReadMemoryToRegisters(start_address, list_without_pc);
+        address = ir.Add(address, ir.Imm32(u32(Common::BitCount(list_without_pc) * 4)));
     }
     if (W && !Common::Bit(RegNumber(n), list)) {
         ir.SetRegister(n, writeback_address);
     }
     if (Common::Bit<15>(list)) {
-        ir.LoadWritePC(ir.ReadMemory32(address));
-        if (n == Reg::R13)
+        const auto new_pc = ir.ReadMemory32(address);
+        ir.LoadWritePC(new_pc);
+        if (n == Reg::R13) {
+            if (profile_calls) {
+                ir.ProfileReturn(new_pc, ir.Imm32(static_cast<u32>(ir.block.CycleCount())));
+            }
             ir.SetTerm(IR::Term::PopRSBHint{});
-        else
+        } else {
             ir.SetTerm(IR::Term::ReturnToDispatch{});
+        }
         return false;
     }
     return true;
@@ -725,7 +731,7 @@ bool ArmTranslatorVisitor::arm_LDM(Cond cond, bool W, Reg n, RegList list) {
     if (ConditionPassed(cond)) {
         auto start_address = ir.GetRegister(n);
         auto writeback_address = ir.Add(start_address, ir.Imm32(u32(Common::BitCount(list) * 4)));
-        return LDMHelper(ir, W, n, list, start_address, writeback_address);
+        return LDMHelper(ir, options.profile_calls, W, n, list, start_address, writeback_address);
     }
     return true;
 }
@@ -737,7 +743,7 @@ bool ArmTranslatorVisitor::arm_LDMDA(Cond cond, bool W, Reg n, RegList list) {
     if (ConditionPassed(cond)) {
         auto start_address = ir.Sub(ir.GetRegister(n), ir.Imm32(u32(4 * Common::BitCount(list) - 4)));
         auto writeback_address = ir.Sub(start_address, ir.Imm32(4));
-        return LDMHelper(ir, W, n, list, start_address, writeback_address);
+        return LDMHelper(ir, options.profile_calls, W, n, list, start_address, writeback_address);
     }
     return true;
 }
@@ -749,7 +755,7 @@ bool ArmTranslatorVisitor::arm_LDMDB(Cond cond, bool W, Reg n, RegList list) {
     if (ConditionPassed(cond)) {
         auto start_address = ir.Sub(ir.GetRegister(n), ir.Imm32(u32(4 * Common::BitCount(list))));
         auto writeback_address = start_address;
-        return LDMHelper(ir, W, n, list, start_address, writeback_address);
+        return LDMHelper(ir, options.profile_calls, W, n, list, start_address, writeback_address);
     }
     return true;
 }
@@ -761,7 +767,7 @@ bool ArmTranslatorVisitor::arm_LDMIB(Cond cond, bool W, Reg n, RegList list) {
     if (ConditionPassed(cond)) {
         auto start_address = ir.Add(ir.GetRegister(n), ir.Imm32(4));
         auto writeback_address = ir.Add(ir.GetRegister(n), ir.Imm32(u32(4 * Common::BitCount(list))));
-        return LDMHelper(ir, W, n, list, start_address, writeback_address);
+        return LDMHelper(ir, options.profile_calls, W, n, list, start_address, writeback_address);
     }
     return true;
 }
@@ -770,17 +776,33 @@ bool ArmTranslatorVisitor::arm_LDM_usr() {
     return InterpretThisInstruction();
 }
 
-bool ArmTranslatorVisitor::arm_LDM_eret() {
-    return InterpretThisInstruction();
+bool ArmTranslatorVisitor::arm_LDM_eret(Cond cond, bool P, bool U, bool W, Reg n, RegList list) {
+    // The decoded list excludes PC, which is always loaded.
+    if (n == Reg::PC || (W && Common::Bit(RegNumber(n), list)))
+        return UnpredictableInstruction();
+    // LDM{IA,IB,DA,DB} <Rn>{!}, <reg_list_with_pc>^
+    if (ConditionPassed(cond)) {
+        const u32 length = u32(Common::BitCount(list) + 1) * 4;
+        const auto base = ir.GetRegister(n);
+        auto start_address = U ? base : ir.Sub(base, ir.Imm32(length));
+        if (P == U)
+            start_address = ir.Add(start_address, ir.Imm32(4));
+        if (list != 0)
+            ir.ReadMemoryToRegisters(start_address, list);
+        const auto new_pc = ir.ReadMemory32(ir.Add(start_address, ir.Imm32(length - 4)));
+        if (W)
+            ir.SetRegister(n, U ? ir.Add(base, ir.Imm32(length)) : ir.Sub(base, ir.Imm32(length)));
+        return ExceptionReturn(new_pc);
+    }
+    return true;
 }
 
 static bool STMHelper(IR::IREmitter& ir, bool W, Reg n, RegList list, IR::Value start_address, IR::Value writeback_address) {
+    const RegList list_without_pc = list & 0x7FFF;
     auto address = start_address;
-    for (size_t i = 0; i <= 14; i++) {
-        if (Common::Bit(i, list)) {
-            ir.WriteMemory32(address, ir.GetRegister(static_cast<Reg>(i)));
-            address = ir.Add(address, ir.Imm32(4));
-        }
+    if (list_without_pc != 0) {
+        ir.WriteMemoryFromRegisters(start_address, list_without_pc);
+        address = ir.Add(address, ir.Imm32(u32(Common::BitCount(list_without_pc) * 4)));
     }
     if (W) {
         ir.SetRegister(n, writeback_address);
@@ -18,5 +18,61 @@ bool ArmTranslatorVisitor::arm_CLZ(Cond cond, Reg d, Reg m) {
     return true;
 }
 
+/// Hints are NOPs unless they are reported to UserCallbacks::CallHint, in which case they end the block.
+bool ArmTranslatorVisitor::TranslateHint(Cond cond, Hint hint) {
+    if (!options.call_hints)
+        return true;
+    if (ConditionPassed(cond)) {
+        ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 4));
+        ir.CallHint(hint);
+        ir.SetTerm(IR::Term::CheckHalt{IR::Term::LinkBlock{ir.current_location.AdvancePC(4)}});
+        return false;
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_SEV(Cond cond) {
+    // SEV<c>
+    return TranslateHint(cond, Hint::SendEvent);
+}
+
+bool ArmTranslatorVisitor::arm_WFE(Cond cond) {
+    // WFE<c>
+    return TranslateHint(cond, Hint::WaitForEvent);
+}
+
+bool ArmTranslatorVisitor::arm_WFI(Cond cond) {
+    // WFI<c>
+    return TranslateHint(cond, Hint::WaitForInterrupt);
+}
+
+bool ArmTranslatorVisitor::arm_YIELD(Cond cond) {
+    // YIELD<c>
+    return TranslateHint(cond, Hint::Yield);
+}
+
+// Fastmem and page table accesses bypass the callbacks, and other cores may be running the same code,
+// so the data barriers are emitted as full barriers. An ISB ends the block, so that the instructions
+// after it are fetched afresh.
+
+bool ArmTranslatorVisitor::arm_DMB(Imm4 /*option*/) {
+    // DMB #<option>
+    ir.DataMemoryBarrier();
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_DSB(Imm4 /*option*/) {
+    // DSB #<option>
+    ir.DataMemoryBarrier();
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_ISB(Imm4 /*option*/) {
+    // ISB #<option>
+    ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 4));
+    ir.SetTerm(IR::Term::ReturnToDispatch{});
+    return false;
+}
+
 } // namespace Arm
 } // namespace Dynarmic
@@ -24,6 +24,17 @@ bool ArmTranslatorVisitor::arm_MLA(Cond cond, bool S, Reg d, Reg a, Reg m, Reg n
     return true;
 }
 
+bool ArmTranslatorVisitor::arm_MLS(Cond cond, Reg d, Reg a, Reg m, Reg n) {
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC || a == Reg::PC)
+        return UnpredictableInstruction();
+    // MLS<c> <Rd>, <Rn>, <Rm>, <Ra>
+    if (ConditionPassed(cond)) {
+        auto result = ir.Sub(ir.GetRegister(a), ir.Mul(ir.GetRegister(n), ir.GetRegister(m)));
+        ir.SetRegister(d, result);
+    }
+    return true;
+}
+
 bool ArmTranslatorVisitor::arm_MUL(Cond cond, bool S, Reg d, Reg m, Reg n) {
     if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
         return UnpredictableInstruction();
@@ -430,5 +441,25 @@ bool ArmTranslatorVisitor::arm_SMUSD(Cond cond, Reg d, Reg m, bool M, Reg n) {
     return true;
 }
 
+bool ArmTranslatorVisitor::arm_SDIV(Cond cond, Reg d, Reg m, Reg n) {
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    // SDIV<c> <Rd>, <Rn>, <Rm>
+    if (ConditionPassed(cond)) {
+        ir.SetRegister(d, ir.SignedDiv(ir.GetRegister(n), ir.GetRegister(m)));
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::arm_UDIV(Cond cond, Reg d, Reg m, Reg n) {
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    // UDIV<c> <Rd>, <Rn>, <Rm>
+    if (ConditionPassed(cond)) {
+        ir.SetRegister(d, ir.UnsignedDiv(ir.GetRegister(n), ir.GetRegister(m)));
+    }
+    return true;
+}
+
 } // namespace Arm
 } // namespace Dynarmic
@@ -33,13 +33,25 @@ bool ArmTranslatorVisitor::arm_SADD16(Cond cond, Reg n, Reg d, Reg m) {
 }
 
 bool ArmTranslatorVisitor::arm_SASX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto result = ir.PackedSubAddS16(ir.GetRegister(n), ir.GetRegister(m), true);
+        ir.SetRegister(d, result.result);
+        ir.SetGEFlags(result.ge);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_SSAX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto result = ir.PackedSubAddS16(ir.GetRegister(n), ir.GetRegister(m), false);
+        ir.SetRegister(d, result.result);
+        ir.SetGEFlags(result.ge);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_SSUB8(Cond cond, Reg n, Reg d, Reg m) {
@@ -87,13 +99,25 @@ bool ArmTranslatorVisitor::arm_UADD16(Cond cond, Reg n, Reg d, Reg m) {
 }
 
 bool ArmTranslatorVisitor::arm_UASX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto result = ir.PackedSubAddU16(ir.GetRegister(n), ir.GetRegister(m), true);
+        ir.SetRegister(d, result.result);
+        ir.SetGEFlags(result.ge);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_USAX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto result = ir.PackedSubAddU16(ir.GetRegister(n), ir.GetRegister(m), false);
+        ir.SetRegister(d, result.result);
+        ir.SetGEFlags(result.ge);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_USAD8(Cond cond, Reg d, Reg m, Reg n) {
@@ -161,13 +185,37 @@ bool ArmTranslatorVisitor::arm_QADD16(Cond cond, Reg n, Reg d, Reg m) {
 }
 
 bool ArmTranslatorVisitor::arm_QASX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto reg_m = ir.GetRegister(m);
+        auto n_lo = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto n_hi = ir.ArithmeticShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto m_lo = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_m));
+        auto m_hi = ir.ArithmeticShiftRight(reg_m, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lower_half = ir.And(ir.SignedSaturation(ir.Sub(n_lo, m_hi), 16).result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(ir.SignedSaturation(ir.Add(n_hi, m_lo), 16).result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_QSAX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto reg_m = ir.GetRegister(m);
+        auto n_lo = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto n_hi = ir.ArithmeticShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto m_lo = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_m));
+        auto m_hi = ir.ArithmeticShiftRight(reg_m, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lower_half = ir.And(ir.SignedSaturation(ir.Add(n_lo, m_hi), 16).result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(ir.SignedSaturation(ir.Sub(n_hi, m_lo), 16).result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_QSUB8(Cond cond, Reg n, Reg d, Reg m) {
@@ -207,13 +255,37 @@ bool ArmTranslatorVisitor::arm_UQADD16(Cond cond, Reg n, Reg d, Reg m) {
 }
 
 bool ArmTranslatorVisitor::arm_UQASX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto reg_m = ir.GetRegister(m);
+        auto n_lo = ir.ZeroExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto n_hi = ir.LogicalShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto m_lo = ir.ZeroExtendHalfToWord(ir.LeastSignificantHalf(reg_m));
+        auto m_hi = ir.LogicalShiftRight(reg_m, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lower_half = ir.And(ir.UnsignedSaturation(ir.Sub(n_lo, m_hi), 16).result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(ir.UnsignedSaturation(ir.Add(n_hi, m_lo), 16).result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_UQSAX(Cond cond, Reg n, Reg d, Reg m) {
-    UNUSED(cond, n, d, m);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto reg_m = ir.GetRegister(m);
+        auto n_lo = ir.ZeroExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto n_hi = ir.LogicalShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto m_lo = ir.ZeroExtendHalfToWord(ir.LeastSignificantHalf(reg_m));
+        auto m_hi = ir.LogicalShiftRight(reg_m, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lower_half = ir.And(ir.UnsignedSaturation(ir.Add(n_lo, m_hi), 16).result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(ir.UnsignedSaturation(ir.Sub(n_hi, m_lo), 16).result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_UQSUB8(Cond cond, Reg n, Reg d, Reg m) {
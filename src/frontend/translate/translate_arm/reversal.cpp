@@ -47,5 +47,16 @@ bool ArmTranslatorVisitor::arm_REVSH(Cond cond, Reg d, Reg m) {
     return true;
 }
 
+bool ArmTranslatorVisitor::arm_RBIT(Cond cond, Reg d, Reg m) {
+    // RBIT<c> <Rd>, <Rm>
+    if (d == Reg::PC || m == Reg::PC)
+        return UnpredictableInstruction();
+
+    if (ConditionPassed(cond)) {
+        ir.SetRegister(d, ir.BitReverseWord(ir.GetRegister(m)));
+    }
+    return true;
+}
+
 } // namespace Arm
 } // namespace Dynarmic
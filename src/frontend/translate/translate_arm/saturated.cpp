@@ -29,8 +29,25 @@ bool ArmTranslatorVisitor::arm_SSAT(Cond cond, Imm5 sat_imm, Reg d, Imm5 imm5, b
 }
 
 bool ArmTranslatorVisitor::arm_SSAT16(Cond cond, Imm4 sat_imm, Reg d, Reg n) {
-    UNUSED(cond, sat_imm, d, n);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC)
+        return UnpredictableInstruction();
+
+    size_t saturate_to = static_cast<size_t>(sat_imm) + 1;
+
+    // SSAT16 <Rd>, #<saturate_to>, <Rn>
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto lo_operand = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto hi_operand = ir.ArithmeticShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lo_result = ir.SignedSaturation(lo_operand, saturate_to);
+        auto hi_result = ir.SignedSaturation(hi_operand, saturate_to);
+        auto lower_half = ir.And(lo_result.result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(hi_result.result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+        ir.OrQFlag(lo_result.overflow);
+        ir.OrQFlag(hi_result.overflow);
+    }
+    return true;
 }
 
 bool ArmTranslatorVisitor::arm_USAT(Cond cond, Imm5 sat_imm, Reg d, Imm5 imm5, bool sh, Reg n) {
@@ -51,8 +68,25 @@ bool ArmTranslatorVisitor::arm_USAT(Cond cond, Imm5 sat_imm, Reg d, Imm5 imm5, b
 }
 
 bool ArmTranslatorVisitor::arm_USAT16(Cond cond, Imm4 sat_imm, Reg d, Reg n) {
-    UNUSED(cond, sat_imm, d, n);
-    return InterpretThisInstruction();
+    if (d == Reg::PC || n == Reg::PC)
+        return UnpredictableInstruction();
+
+    size_t saturate_to = static_cast<size_t>(sat_imm);
+
+    // USAT16 <Rd>, #<saturate_to>, <Rn>
+    if (ConditionPassed(cond)) {
+        auto reg_n = ir.GetRegister(n);
+        auto lo_operand = ir.SignExtendHalfToWord(ir.LeastSignificantHalf(reg_n));
+        auto hi_operand = ir.ArithmeticShiftRight(reg_n, ir.Imm8(16), ir.Imm1(0)).result;
+        auto lo_result = ir.UnsignedSaturation(lo_operand, saturate_to);
+        auto hi_result = ir.UnsignedSaturation(hi_operand, saturate_to);
+        auto lower_half = ir.And(lo_result.result, ir.Imm32(0x0000FFFF));
+        auto upper_half = ir.LogicalShiftLeft(hi_result.result, ir.Imm8(16), ir.Imm1(0)).result;
+        ir.SetRegister(d, ir.Or(lower_half, upper_half));
+        ir.OrQFlag(lo_result.overflow);
+        ir.OrQFlag(hi_result.overflow);
+    }
+    return true;
 }
 
 // Saturated Add/Subtract instructions
@@ -9,62 +9,138 @@
 namespace Dynarmic {
 namespace Arm {
 
-bool ArmTranslatorVisitor::arm_CPS() {
-    return InterpretThisInstruction();
+bool ArmTranslatorVisitor::arm_CPS(int imod, bool M, bool A, bool I, bool F, int mode) {
+    if ((imod == 0b00 && !M) || imod == 0b01)
+        return UnpredictableInstruction();
+    if (imod == 0b00 && (A || I || F))
+        return UnpredictableInstruction();
+    if (imod != 0b00 && !A && !I && !F)
+        return UnpredictableInstruction();
+    // CPS{IE,ID} <a,i,f>{, #<mode>}
+    // A CPS is treated as a NOP in User mode.
+    if (!InPrivilegedMode())
+        return true;
+
+    u32 aif_mask = 0;
+    if (A)
+        aif_mask |= 0x00000100;
+    if (I)
+        aif_mask |= 0x00000080;
+    if (F)
+        aif_mask |= 0x00000040;
+
+    auto cpsr = ir.GetCpsr();
+    if (imod == 0b10)
+        cpsr = ir.And(cpsr, ir.Imm32(~aif_mask));
+    else if (imod == 0b11)
+        cpsr = ir.Or(cpsr, ir.Imm32(aif_mask));
+
+    auto next_location = ir.current_location.AdvancePC(4);
+    if (M) {
+        const auto new_mode = static_cast<PSR::Mode>(0x10 | mode);
+        cpsr = WritePsrMasked(cpsr, ir.Imm32(static_cast<u32>(new_mode)), 0x0000001F);
+        ir.SetCpsrAndSwitchMode(cpsr);
+        next_location = next_location.SetMode(new_mode);
+    } else {
+        ir.SetCpsr(cpsr);
+    }
+    ir.SetTerm(IR::Term::LinkBlock{next_location});
+    return false;
 }
 
-bool ArmTranslatorVisitor::arm_MRS(Cond cond, Reg d) {
+bool ArmTranslatorVisitor::arm_MRS(Cond cond, bool R, Reg d) {
     if (d == Reg::PC)
         return UnpredictableInstruction();
-    // MRS <Rd>, APSR
+    if (R && !InPrivilegedMode())
+        return UnpredictableInstruction();
+    // MRS <Rd>, {APSR,SPSR}
     if (ConditionPassed(cond)) {
-        ir.SetRegister(d, ir.GetCpsr());
+        ir.SetRegister(d, R ? ir.GetSpsr() : ir.GetCpsr());
     }
     return true;
 }
 
-bool ArmTranslatorVisitor::arm_MSR_imm(Cond cond, int mask, int rotate, Imm8 imm8) {
-    bool write_nzcvq = Common::Bit<1>(mask);
-    bool write_g = Common::Bit<0>(mask);
+/**
+ * Writes value to the fields of CPSR (or SPSR if R is set) selected by the four bits of mask, which are
+ * the f (bits 31:24), s (bits 23:16), x (bits 15:8) and c (bits 7:0) fields from most to least significant.
+ * Only the bits of CPSR that can be written in the current mode are affected. Writing the x or c fields
+ * of CPSR can change the mode or instruction set state, so execution then continues through the dispatcher.
+ */
+static bool MSRHelper(ArmTranslatorVisitor& v, bool R, int mask, IR::Value value) {
+    IR::IREmitter& ir = v.ir;
+    const bool privileged = v.InPrivilegedMode();
+
+    if (R) {
+        if (!privileged)
+            return v.UnpredictableInstruction();
+        u32 spsr_mask = 0;
+        for (size_t field = 0; field < 4; field++) {
+            if (Common::Bit(field, mask))
+                spsr_mask |= 0xFFu << (field * 8);
+        }
+        ir.SetSpsr(v.WritePsrMasked(ir.GetSpsr(), value, spsr_mask));
+        return true;
+    }
+
+    u32 cpsr_mask = 0;
+    if (Common::Bit<3>(mask))
+        cpsr_mask |= 0xF8000000;
+    if (Common::Bit<2>(mask))
+        cpsr_mask |= 0x000F0000;
+    if (Common::Bit<1>(mask))
+        cpsr_mask |= privileged ? 0x00000300 : 0x00000200;
+    if (Common::Bit<0>(mask) && privileged)
+        cpsr_mask |= 0x000000DF;
+
+    auto new_cpsr = v.WritePsrMasked(ir.GetCpsr(), value, cpsr_mask);
+    if ((cpsr_mask & 0x0000FFFF) == 0) {
+        ir.SetCpsr(new_cpsr);
+        return true;
+    }
+
+    ir.SetCpsrAndSwitchMode(new_cpsr);
+    ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 4));
+    ir.SetTerm(IR::Term::ReturnToDispatch{});
+    return false;
+}
+
+bool ArmTranslatorVisitor::arm_MSR_imm(Cond cond, bool R, int mask, int rotate, Imm8 imm8) {
+    ASSERT_MSG(mask != 0, "Decode error");
     u32 imm32 = ArmExpandImm(rotate, imm8);
-    ASSERT_MSG(write_nzcvq || write_g, "Decode error");
     // MSR <spec_reg>, #<imm32>
     if (ConditionPassed(cond)) {
-        u32 cpsr_mask = 0;
-        if (write_nzcvq)
-            cpsr_mask |= 0xF8000000;
-        if (write_g)
-            cpsr_mask |= 0x000F0000;
-        auto old_cpsr = ir.And(ir.GetCpsr(), ir.Imm32(~cpsr_mask));
-        auto new_cpsr = ir.Imm32(imm32 & cpsr_mask);
-        ir.SetCpsr(ir.Or(old_cpsr, new_cpsr));
+        return MSRHelper(*this, R, mask, ir.Imm32(imm32));
     }
     return true;
 }
 
-bool ArmTranslatorVisitor::arm_MSR_reg(Cond cond, int mask, Reg n) {
-    bool write_nzcvq = Common::Bit<1>(mask);
-    bool write_g = Common::Bit<0>(mask);
-    if (!write_nzcvq && !write_g)
+bool ArmTranslatorVisitor::arm_MSR_reg(Cond cond, bool R, int mask, Reg n) {
+    if (mask == 0)
         return UnpredictableInstruction();
     if (n == Reg::PC)
         return UnpredictableInstruction();
-    // MSR <spec_reg>, #<imm32>
+    // MSR <spec_reg>, <Rn>
     if (ConditionPassed(cond)) {
-        u32 cpsr_mask = 0;
-        if (write_nzcvq)
-            cpsr_mask |= 0xF8000000;
-        if (write_g)
-            cpsr_mask |= 0x000F0000;
-        auto old_cpsr = ir.And(ir.GetCpsr(), ir.Imm32(~cpsr_mask));
-        auto new_cpsr = ir.And(ir.GetRegister(n), ir.Imm32(cpsr_mask));
-        ir.SetCpsr(ir.Or(old_cpsr, new_cpsr));
+        return MSRHelper(*this, R, mask, ir.GetRegister(n));
     }
     return true;
 }
 
-bool ArmTranslatorVisitor::arm_RFE() {
-    return InterpretThisInstruction();
+bool ArmTranslatorVisitor::arm_RFE(bool P, bool U, bool W, Reg n) {
+    if (n == Reg::PC)
+        return UnpredictableInstruction();
+    if (!InPrivilegedMode())
+        return UnpredictableInstruction();
+    // RFE{IA,IB,DA,DB} <Rn>{!}
+    const auto base = ir.GetRegister(n);
+    auto address = U ? base : ir.Sub(base, ir.Imm32(8));
+    if (P == U)
+        address = ir.Add(address, ir.Imm32(4));
+    const auto new_pc = ir.ReadMemory32(address);
+    const auto new_cpsr = ir.ReadMemory32(ir.Add(address, ir.Imm32(4)));
+    if (W)
+        ir.SetRegister(n, U ? ir.Add(base, ir.Imm32(8)) : ir.Sub(base, ir.Imm32(8)));
+    return ExceptionReturn(new_pc, new_cpsr);
 }
 
 bool ArmTranslatorVisitor::arm_SETEND(bool E) {
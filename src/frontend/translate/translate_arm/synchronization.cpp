@@ -22,7 +22,7 @@ bool ArmTranslatorVisitor::arm_LDREX(Cond cond, Reg n, Reg d) {
     if (ConditionPassed(cond)) {
         auto address = ir.GetRegister(n);
         ir.SetExclusive(address, 4);
-        ir.SetRegister(d, ir.ReadMemory32(address));
+        ir.SetRegister(d, ir.ExclusiveReadMemory32(address));
     }
     return true;
 }
@@ -34,7 +34,7 @@ bool ArmTranslatorVisitor::arm_LDREXB(Cond cond, Reg n, Reg d) {
     if (ConditionPassed(cond)) {
         auto address = ir.GetRegister(n);
         ir.SetExclusive(address, 1);
-        ir.SetRegister(d, ir.ZeroExtendByteToWord(ir.ReadMemory8(address)));
+        ir.SetRegister(d, ir.ZeroExtendByteToWord(ir.ExclusiveReadMemory8(address)));
     }
     return true;
 }
@@ -46,11 +46,9 @@ bool ArmTranslatorVisitor::arm_LDREXD(Cond cond, Reg n, Reg d) {
     if (ConditionPassed(cond)) {
         auto address = ir.GetRegister(n);
         ir.SetExclusive(address, 8);
-        // DO NOT SWAP hi AND lo IN BIG ENDIAN MODE, THIS IS CORRECT BEHAVIOUR
-        auto lo = ir.ReadMemory32(address);
-        ir.SetRegister(d, lo);
-        auto hi = ir.ReadMemory32(ir.Add(address, ir.Imm32(4)));
-        ir.SetRegister(d+1, hi);
+        auto value = ir.ExclusiveReadMemory64(address);
+        ir.SetRegister(d, value.first);
+        ir.SetRegister(d+1, value.second);
     }
     return true;
 }
@@ -62,7 +60,7 @@ bool ArmTranslatorVisitor::arm_LDREXH(Cond cond, Reg n, Reg d) {
     if (ConditionPassed(cond)) {
         auto address = ir.GetRegister(n);
         ir.SetExclusive(address, 2);
-        ir.SetRegister(d, ir.ZeroExtendHalfToWord(ir.ReadMemory16(address)));
+        ir.SetRegister(d, ir.ZeroExtendHalfToWord(ir.ExclusiveReadMemory16(address)));
     }
     return true;
 }
@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include "frontend/ir/ir_emitter.h"
 #include "frontend/ir/location_descriptor.h"
+#include "frontend/translate/translate.h"
 
 namespace Dynarmic {
 namespace Arm {
@@ -26,16 +29,42 @@ enum class ConditionalState {
 struct ArmTranslatorVisitor final {
     using instruction_return_type = bool;
 
-    explicit ArmTranslatorVisitor(IR::LocationDescriptor descriptor) : ir(descriptor) {
+    ArmTranslatorVisitor(IR::LocationDescriptor descriptor, const TranslationOptions& options) : ir(descriptor), options(options), range_start(descriptor.PC()) {
         ASSERT_MSG(!descriptor.TFlag(), "The processor must be in Arm mode");
     }
 
     IR::IREmitter ir;
     ConditionalState cond_state = ConditionalState::None;
+    const TranslationOptions options;
+
+    /// Start of the range of guest code currently being translated.
+    u32 range_start;
+    /// Set when translation should continue at a branch target rather than the next instruction.
+    boost::optional<IR::LocationDescriptor> branch_target;
+    /// Set while translating an instruction whose condition is applied by TranslateWithSelects.
+    bool translating_with_selects = false;
+    /// Guest instructions translated so far; the block's cycle count depends on their costs.
+    size_t instruction_count = 0;
+    /// Index in options.trace of the last block of the trace that translation has reached.
+    size_t trace_position = 0;
+    /// The SideExit of the instruction being translated, which is given its cycles once they are known.
+    IR::Inst* side_exit = nullptr;
 
     bool ConditionPassed(Cond cond);
+    template <typename TranslateFn>
+    bool TranslateWithSelects(Cond cond, TranslateFn translate, bool& should_continue);
+    bool FollowBranch(IR::LocationDescriptor target);
+    bool FollowTrace(Cond cond, IR::LocationDescriptor taken, IR::LocationDescriptor not_taken);
+    bool CanBranchWithIf(Cond cond) const;
     bool InterpretThisInstruction();
     bool UnpredictableInstruction();
+    bool TranslateHint(Cond cond, Hint hint);
+    void ProfileCall(IR::Value function, u32 return_address);
+    void ProfileReturn(IR::Value target);
+    bool InPrivilegedMode() const;
+    bool ExceptionReturn(IR::Value new_pc);
+    bool ExceptionReturn(IR::Value new_pc, IR::Value new_cpsr);
+    IR::Value WritePsrMasked(IR::Value old_psr, IR::Value value, u32 mask);
 
     static u32 rotr(u32 x, int shift) {
         shift &= 31;
@@ -66,6 +95,20 @@ struct ArmTranslatorVisitor final {
     IR::IREmitter::ResultAndCarry EmitRegShift(IR::Value value, ShiftType type, IR::Value amount, IR::Value carry_in);
     IR::Value SignZeroExtendRor(Reg m, SignExtendRotation rotate);
 
+    /// Whether the current FPSCR vector length and stride can be translated for an operation of precision `sz`.
+    bool IsVfpVectorModeTranslatable(bool sz) const;
+    /// Emits `fn` once for each element of a VFP short vector operation, as determined by FPSCR.{LEN,STRIDE}.
+    template <typename FnT>
+    void EmitVfpVectorOperation(bool sz, ExtReg d, ExtReg n, ExtReg m, const FnT& fn);
+    template <typename FnT>
+    void EmitVfpVectorOperation(bool sz, ExtReg d, ExtReg m, const FnT& fn);
+
+    /// As IREmitter::ReadMemoryToExtRegisters, but loads each pair of double registers that makes up a quad
+    /// register with one ReadMemory128 if options.vector_memory_accesses is set.
+    void ReadExtRegisters(IR::Value vaddr, ExtReg first, size_t count);
+    /// As IREmitter::WriteMemoryFromExtRegisters, with WriteMemory128 as in ReadExtRegisters.
+    void WriteExtRegisters(IR::Value vaddr, ExtReg first, size_t count);
+
     // Branch instructions
     bool arm_B(Cond cond, Imm24 imm24);
     bool arm_BL(Cond cond, Imm24 imm24);
@@ -108,6 +151,8 @@ struct ArmTranslatorVisitor final {
     bool arm_MOV_imm(Cond cond, bool S, Reg d, int rotate, Imm8 imm8);
     bool arm_MOV_reg(Cond cond, bool S, Reg d, Imm5 imm5, ShiftType shift, Reg m);
     bool arm_MOV_rsr(Cond cond, bool S, Reg d, Reg s, ShiftType shift, Reg m);
+    bool arm_MOVT(Cond cond, Imm4 imm4, Reg d, Imm12 imm12);
+    bool arm_MOVW(Cond cond, Imm4 imm4, Reg d, Imm12 imm12);
     bool arm_MVN_imm(Cond cond, bool S, Reg d, int rotate, Imm8 imm8);
     bool arm_MVN_reg(Cond cond, bool S, Reg d, Imm5 imm5, ShiftType shift, Reg m);
     bool arm_MVN_rsr(Cond cond, bool S, Reg d, Reg s, ShiftType shift, Reg m);
@@ -133,6 +178,12 @@ struct ArmTranslatorVisitor final {
     bool arm_TST_reg(Cond cond, Reg n, Imm5 imm5, ShiftType shift, Reg m);
     bool arm_TST_rsr(Cond cond, Reg n, Reg s, ShiftType shift, Reg m);
 
+    // Bitfield instructions
+    bool arm_BFC(Cond cond, Imm5 msb, Reg d, Imm5 lsb);
+    bool arm_BFI(Cond cond, Imm5 msb, Reg d, Imm5 lsb, Reg n);
+    bool arm_SBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n);
+    bool arm_UBFX(Cond cond, Imm5 widthm1, Reg d, Imm5 lsb, Reg n);
+
     // Exception generating instructions
     bool arm_BKPT(Cond cond, Imm12 imm12, Imm4 imm4);
     bool arm_SVC(Cond cond, Imm24 imm24);
@@ -154,10 +205,15 @@ struct ArmTranslatorVisitor final {
 
     // Hint instructions
     bool arm_PLD() { return true; }
-    bool arm_SEV() { return true; }
-    bool arm_WFE() { return true; }
-    bool arm_WFI() { return true; }
-    bool arm_YIELD() { return true; }
+    bool arm_SEV(Cond cond);
+    bool arm_WFE(Cond cond);
+    bool arm_WFI(Cond cond);
+    bool arm_YIELD(Cond cond);
+
+    // Barrier instructions
+    bool arm_DMB(Imm4 option);
+    bool arm_DSB(Imm4 option);
+    bool arm_ISB(Imm4 option);
 
     // Load/Store
     bool arm_LDRBT();
@@ -201,7 +257,7 @@ struct ArmTranslatorVisitor final {
     bool arm_LDMDB(Cond cond, bool W, Reg n, RegList list);
     bool arm_LDMIB(Cond cond, bool W, Reg n, RegList list);
     bool arm_LDM_usr();
-    bool arm_LDM_eret();
+    bool arm_LDM_eret(Cond cond, bool P, bool U, bool W, Reg n, RegList list);
     bool arm_STM(Cond cond, bool W, Reg n, RegList list);
     bool arm_STMDA(Cond cond, bool W, Reg n, RegList list);
     bool arm_STMDB(Cond cond, bool W, Reg n, RegList list);
@@ -225,6 +281,7 @@ struct ArmTranslatorVisitor final {
     bool arm_REV(Cond cond, Reg d, Reg m);
     bool arm_REV16(Cond cond, Reg d, Reg m);
     bool arm_REVSH(Cond cond, Reg d, Reg m);
+    bool arm_RBIT(Cond cond, Reg d, Reg m);
 
     // Saturation instructions
     bool arm_SSAT(Cond cond, Imm5 sat_imm, Reg d, Imm5 imm5, bool sh, Reg n);
@@ -234,6 +291,7 @@ struct ArmTranslatorVisitor final {
 
     // Multiply (Normal) instructions
     bool arm_MLA(Cond cond, bool S, Reg d, Reg a, Reg m, Reg n);
+    bool arm_MLS(Cond cond, Reg d, Reg a, Reg m, Reg n);
     bool arm_MUL(Cond cond, bool S, Reg d, Reg m, Reg n);
 
     // Multiply (Long) instructions
@@ -265,6 +323,10 @@ struct ArmTranslatorVisitor final {
     bool arm_SMUAD(Cond cond, Reg d, Reg m, bool M, Reg n);
     bool arm_SMUSD(Cond cond, Reg d, Reg m, bool M, Reg n);
 
+    // Divide instructions
+    bool arm_SDIV(Cond cond, Reg d, Reg m, Reg n);
+    bool arm_UDIV(Cond cond, Reg d, Reg m, Reg n);
+
     // Parallel Add/Subtract (Modulo arithmetic) instructions
     bool arm_SADD8(Cond cond, Reg n, Reg d, Reg m);
     bool arm_SADD16(Cond cond, Reg n, Reg d, Reg m);
@@ -327,11 +389,11 @@ struct ArmTranslatorVisitor final {
     bool arm_SWPB(Cond cond, Reg n, Reg d, Reg m);
 
     // Status register access instructions
-    bool arm_CPS();
-    bool arm_MRS(Cond cond, Reg d);
-    bool arm_MSR_imm(Cond cond, int mask, int rotate, Imm8 imm8);
-    bool arm_MSR_reg(Cond cond, int mask, Reg n);
-    bool arm_RFE();
+    bool arm_CPS(int imod, bool M, bool A, bool I, bool F, int mode);
+    bool arm_MRS(Cond cond, bool R, Reg d);
+    bool arm_MSR_imm(Cond cond, bool R, int mask, int rotate, Imm8 imm8);
+    bool arm_MSR_reg(Cond cond, bool R, int mask, Reg n);
+    bool arm_RFE(bool P, bool U, bool W, Reg n);
     bool arm_SETEND(bool E);
     bool arm_SRS();
 
@@ -345,6 +407,10 @@ struct ArmTranslatorVisitor final {
     bool vfp2_VNMLA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
     bool vfp2_VNMLS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
     bool vfp2_VDIV(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
+    bool vfp2_VFMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
+    bool vfp2_VFMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
+    bool vfp2_VFNMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
+    bool vfp2_VFNMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm);
 
     // Floating-point move instructions
     bool vfp2_VMOV_u32_f64(Cond cond, size_t Vd, Reg t, bool D);
@@ -381,6 +447,23 @@ struct ArmTranslatorVisitor final {
     bool vfp2_VSTM_a2(Cond cond, bool p, bool u, bool D, bool w, Reg n, size_t Vd, Imm8 imm8);
     bool vfp2_VLDM_a1(Cond cond, bool p, bool u, bool D, bool w, Reg n, size_t Vd, Imm8 imm8);
     bool vfp2_VLDM_a2(Cond cond, bool p, bool u, bool D, bool w, Reg n, size_t Vd, Imm8 imm8);
+
+    // Advanced SIMD three register instructions
+    bool asimd_VAND_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VBIC_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VORR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VORN_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VEOR_reg(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VBSL(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VBIT(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VBIF(bool D, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VADD_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VSUB_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+    bool asimd_VMUL_int(bool D, size_t sz, size_t Vn, size_t Vd, bool N, bool Q, bool M, size_t Vm);
+
+    // Advanced SIMD load-store instructions
+    bool asimd_VST1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m);
+    bool asimd_VLD1_multiple(bool D, Reg n, size_t Vd, size_t type, size_t sz, size_t align, Reg m);
 };
 
 } // namespace Arm
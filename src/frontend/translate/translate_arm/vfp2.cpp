@@ -17,177 +17,338 @@ static ExtReg ToExtReg(bool sz, size_t base, bool bit) {
     }
 }
 
+// VFP register banks are eight single-precision or four double-precision registers in size.
+static size_t RegisterBankSize(bool sz) {
+    return sz ? 4 : 8;
+}
+
+bool ArmTranslatorVisitor::IsVfpVectorModeTranslatable(bool sz) const {
+    const auto length = ir.current_location.FPSCR().Len();
+    const auto stride = ir.current_location.FPSCR().Stride();
+    if (!stride)
+        return false;
+    if (length == 1)
+        return *stride == 1;
+    // A vector which would wrap around onto its own elements is UNPREDICTABLE.
+    return length * *stride <= RegisterBankSize(sz);
+}
+
+template <typename FnT>
+void ArmTranslatorVisitor::EmitVfpVectorOperation(bool sz, ExtReg d, ExtReg n, ExtReg m, const FnT& fn) {
+    const size_t length = ir.current_location.FPSCR().Len();
+    const size_t stride = *ir.current_location.FPSCR().Stride();
+    const size_t bank_size = RegisterBankSize(sz);
+
+    const auto is_in_first_bank = [bank_size](ExtReg reg) {
+        return RegNumber(reg) < bank_size;
+    };
+    const auto next_in_bank = [sz, stride, bank_size](ExtReg reg) {
+        const size_t number = RegNumber(reg);
+        const size_t bank_start = number - number % bank_size;
+        return (sz ? ExtReg::D0 : ExtReg::S0) + (bank_start + (number + stride) % bank_size);
+    };
+
+    // An operation with a destination in the first bank is always scalar.
+    if (length == 1 || is_in_first_bank(d)) {
+        fn(d, n, m);
+        return;
+    }
+
+    // An m operand in the first bank is a scalar which is used for every element.
+    const bool m_is_scalar = is_in_first_bank(m);
+    for (size_t i = 0; i < length; i++) {
+        fn(d, n, m);
+        d = next_in_bank(d);
+        n = next_in_bank(n);
+        if (!m_is_scalar)
+            m = next_in_bank(m);
+    }
+}
+
+template <typename FnT>
+void ArmTranslatorVisitor::EmitVfpVectorOperation(bool sz, ExtReg d, ExtReg m, const FnT& fn) {
+    EmitVfpVectorOperation(sz, d, d, m, [&fn](ExtReg d, ExtReg, ExtReg m) {
+        fn(d, m);
+    });
+}
+
 bool ArmTranslatorVisitor::vfp2_VADD(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VADD.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPAdd64(reg_n, reg_m, true)
-                      : ir.FPAdd32(reg_n, reg_m, true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPAdd64(reg_n, reg_m, true)
+                          : ir.FPAdd32(reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VSUB(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VSUB.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPSub64(reg_n, reg_m, true)
-                      : ir.FPSub32(reg_n, reg_m, true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPSub64(reg_n, reg_m, true)
+                          : ir.FPSub32(reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VMUL(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VMUL.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPMul64(reg_n, reg_m, true)
-                      : ir.FPMul32(reg_n, reg_m, true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPMul64(reg_n, reg_m, true)
+                          : ir.FPMul32(reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VMLA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VMLA.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto reg_d = ir.GetExtendedRegister(d);
-        auto result = sz
-                      ? ir.FPAdd64(reg_d, ir.FPMul64(reg_n, reg_m, true), true)
-                      : ir.FPAdd32(reg_d, ir.FPMul32(reg_n, reg_m, true), true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPAdd64(reg_d, ir.FPMul64(reg_n, reg_m, true), true)
+                          : ir.FPAdd32(reg_d, ir.FPMul32(reg_n, reg_m, true), true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VMLS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VMLS.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto reg_d = ir.GetExtendedRegister(d);
-        auto result = sz
-                      ? ir.FPAdd64(reg_d, ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true)), true)
-                      : ir.FPAdd32(reg_d, ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true)), true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPAdd64(reg_d, ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true)), true)
+                          : ir.FPAdd32(reg_d, ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true)), true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VNMUL(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VNMUL.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true))
-                      : ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true));
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true))
+                          : ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true));
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VNMLA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VNMLA.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto reg_d = ir.GetExtendedRegister(d);
-        auto result = sz
-                      ? ir.FPAdd64(ir.FPNeg64(reg_d), ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true)), true)
-                      : ir.FPAdd32(ir.FPNeg32(reg_d), ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true)), true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPAdd64(ir.FPNeg64(reg_d), ir.FPNeg64(ir.FPMul64(reg_n, reg_m, true)), true)
+                          : ir.FPAdd32(ir.FPNeg32(reg_d), ir.FPNeg32(ir.FPMul32(reg_n, reg_m, true)), true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VNMLS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VNMLS.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto reg_d = ir.GetExtendedRegister(d);
-        auto result = sz
-                      ? ir.FPAdd64(ir.FPNeg64(reg_d), ir.FPMul64(reg_n, reg_m, true), true)
-                      : ir.FPAdd32(ir.FPNeg32(reg_d), ir.FPMul32(reg_n, reg_m, true), true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPAdd64(ir.FPNeg64(reg_d), ir.FPMul64(reg_n, reg_m, true), true)
+                          : ir.FPAdd32(ir.FPNeg32(reg_d), ir.FPMul32(reg_n, reg_m, true), true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VDIV(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg n = ToExtReg(sz, Vn, N);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VDIV.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_n = ir.GetExtendedRegister(n);
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPDiv64(reg_n, reg_m, true)
-                      : ir.FPDiv32(reg_n, reg_m, true);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPDiv64(reg_n, reg_m, true)
+                          : ir.FPDiv32(reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::vfp2_VFMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
+
+    ExtReg d = ToExtReg(sz, Vd, D);
+    ExtReg n = ToExtReg(sz, Vn, N);
+    ExtReg m = ToExtReg(sz, Vm, M);
+    // VFMA.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
+    if (ConditionPassed(cond)) {
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPMulAdd64(reg_d, reg_n, reg_m, true)
+                          : ir.FPMulAdd32(reg_d, reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::vfp2_VFMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
+
+    ExtReg d = ToExtReg(sz, Vd, D);
+    ExtReg n = ToExtReg(sz, Vn, N);
+    ExtReg m = ToExtReg(sz, Vm, M);
+    // VFMS.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
+    if (ConditionPassed(cond)) {
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPMulAdd64(reg_d, ir.FPNeg64(reg_n), reg_m, true)
+                          : ir.FPMulAdd32(reg_d, ir.FPNeg32(reg_n), reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::vfp2_VFNMA(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
+
+    ExtReg d = ToExtReg(sz, Vd, D);
+    ExtReg n = ToExtReg(sz, Vn, N);
+    ExtReg m = ToExtReg(sz, Vm, M);
+    // VFNMA.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
+    if (ConditionPassed(cond)) {
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPMulAdd64(ir.FPNeg64(reg_d), ir.FPNeg64(reg_n), reg_m, true)
+                          : ir.FPMulAdd32(ir.FPNeg32(reg_d), ir.FPNeg32(reg_n), reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
+    }
+    return true;
+}
+
+bool ArmTranslatorVisitor::vfp2_VFNMS(Cond cond, bool D, size_t Vn, size_t Vd, bool sz, bool N, bool M, size_t Vm) {
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
+
+    ExtReg d = ToExtReg(sz, Vd, D);
+    ExtReg n = ToExtReg(sz, Vn, N);
+    ExtReg m = ToExtReg(sz, Vm, M);
+    // VFNMS.{F32,F64} <{S,D}d>, <{S,D}n>, <{S,D}m>
+    if (ConditionPassed(cond)) {
+        EmitVfpVectorOperation(sz, d, n, m, [this, sz](ExtReg d, ExtReg n, ExtReg m) {
+            auto reg_n = ir.GetExtendedRegister(n);
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto reg_d = ir.GetExtendedRegister(d);
+            auto result = sz
+                          ? ir.FPMulAdd64(ir.FPNeg64(reg_d), reg_n, reg_m, true)
+                          : ir.FPMulAdd32(ir.FPNeg32(reg_d), reg_n, reg_m, true);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
@@ -297,65 +458,73 @@ bool ArmTranslatorVisitor::vfp2_VMOV_f64_2u32(Cond cond, Reg t2, Reg t, bool M,
 }
 
 bool ArmTranslatorVisitor::vfp2_VMOV_reg(Cond cond, bool D, size_t Vd, bool sz, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VMOV.{F32,F64} <{S,D}d>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        ir.SetExtendedRegister(d, ir.GetExtendedRegister(m));
+        EmitVfpVectorOperation(sz, d, m, [this, sz](ExtReg d, ExtReg m) {
+            ir.SetExtendedRegister(d, ir.GetExtendedRegister(m));
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VABS(Cond cond, bool D, size_t Vd, bool sz, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VABS.{F32,F64} <{S,D}d>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPAbs64(reg_m)
-                      : ir.FPAbs32(reg_m);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, m, [this, sz](ExtReg d, ExtReg m) {
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPAbs64(reg_m)
+                          : ir.FPAbs32(reg_m);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VNEG(Cond cond, bool D, size_t Vd, bool sz, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VNEG.{F32,F64} <{S,D}d>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPNeg64(reg_m)
-                      : ir.FPNeg32(reg_m);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, m, [this, sz](ExtReg d, ExtReg m) {
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPNeg64(reg_m)
+                          : ir.FPNeg32(reg_m);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
 
 bool ArmTranslatorVisitor::vfp2_VSQRT(Cond cond, bool D, size_t Vd, bool sz, bool M, size_t Vm) {
-    if (ir.current_location.FPSCR().Len() != 1 || ir.current_location.FPSCR().Stride() != boost::optional<size_t>{1})
-        return InterpretThisInstruction(); // TODO: Vectorised floating point instructions
+    if (!IsVfpVectorModeTranslatable(sz))
+        return InterpretThisInstruction();
 
     ExtReg d = ToExtReg(sz, Vd, D);
     ExtReg m = ToExtReg(sz, Vm, M);
     // VSQRT.{F32,F64} <{S,D}d>, <{S,D}m>
     if (ConditionPassed(cond)) {
-        auto reg_m = ir.GetExtendedRegister(m);
-        auto result = sz
-                      ? ir.FPSqrt64(reg_m)
-                      : ir.FPSqrt32(reg_m);
-        ir.SetExtendedRegister(d, result);
+        EmitVfpVectorOperation(sz, d, m, [this, sz](ExtReg d, ExtReg m) {
+            auto reg_m = ir.GetExtendedRegister(m);
+            auto result = sz
+                          ? ir.FPSqrt64(reg_m)
+                          : ir.FPSqrt32(reg_m);
+            ir.SetExtendedRegister(d, result);
+        });
     }
     return true;
 }
@@ -504,23 +673,8 @@ bool ArmTranslatorVisitor::vfp2_VPOP(Cond cond, bool D, size_t Vd, bool sz, Imm8
     // VPOP.{F32,F64} <list>
     if (ConditionPassed(cond)) {
         auto address = ir.GetRegister(Reg::SP);
-
-        for (size_t i = 0; i < regs; ++i) {
-            if (sz) {
-                auto lo = ir.ReadMemory32(address);
-                address = ir.Add(address, ir.Imm32(4));
-                auto hi = ir.ReadMemory32(address);
-                address = ir.Add(address, ir.Imm32(4));
-                if (ir.current_location.EFlag()) std::swap(lo, hi);
-                ir.SetExtendedRegister(d + i, ir.TransferToFP64(ir.Pack2x32To1x64(lo, hi)));
-            } else {
-                auto res = ir.ReadMemory32(address);
-                ir.SetExtendedRegister(d + i, ir.TransferToFP32(res));
-                address = ir.Add(address, ir.Imm32(4));
-            }
-        }
-
-        ir.SetRegister(Reg::SP, address);
+        ReadExtRegisters(address, d, regs);
+        ir.SetRegister(Reg::SP, ir.Add(address, ir.Imm32(u32(regs * (sz ? 8 : 4)))));
     }
     return true;
 }
@@ -539,22 +693,7 @@ bool ArmTranslatorVisitor::vfp2_VPUSH(Cond cond, bool D, size_t Vd, bool sz, Imm
     if (ConditionPassed(cond)) {
         auto address = ir.Sub(ir.GetRegister(Reg::SP), ir.Imm32(imm32));
         ir.SetRegister(Reg::SP, address);
-
-        for (size_t i = 0; i < regs; ++i) {
-            if (sz) {
-                const auto d_u64 = ir.TransferFromFP64(ir.GetExtendedRegister(d + i));
-                auto lo = ir.LeastSignificantWord(d_u64);
-                auto hi = ir.MostSignificantWord(d_u64).result;
-                if (ir.current_location.EFlag()) std::swap(lo, hi);
-                ir.WriteMemory32(address, lo);
-                address = ir.Add(address, ir.Imm32(4));
-                ir.WriteMemory32(address, hi);
-                address = ir.Add(address, ir.Imm32(4));
-            } else {
-                ir.WriteMemory32(address, ir.TransferFromFP32(ir.GetExtendedRegister(d + i)));
-                address = ir.Add(address, ir.Imm32(4));
-            }
-        }
+        WriteExtRegisters(address, d, regs);
     }
     return true;
 }
@@ -621,16 +760,7 @@ bool ArmTranslatorVisitor::vfp2_VSTM_a1(Cond cond, bool p, bool u, bool D, bool
         auto address = u ? ir.GetRegister(n) : ir.Sub(ir.GetRegister(n), ir.Imm32(imm32));
         if (w)
             ir.SetRegister(n, u ? ir.Add(address, ir.Imm32(imm32)) : address);
-        for (size_t i = 0; i < regs; i++) {
-            auto value = ir.TransferFromFP64(ir.GetExtendedRegister(d + i));
-            auto word1 = ir.LeastSignificantWord(value);
-            auto word2 = ir.MostSignificantWord(value).result;
-            if (ir.current_location.EFlag()) std::swap(word1, word2);
-            ir.WriteMemory32(address, word1);
-            address = ir.Add(address, ir.Imm32(4));
-            ir.WriteMemory32(address, word2);
-            address = ir.Add(address, ir.Imm32(4));
-        }
+        WriteExtRegisters(address, d, regs);
     }
     return true;
 }
@@ -657,11 +787,7 @@ bool ArmTranslatorVisitor::vfp2_VSTM_a2(Cond cond, bool p, bool u, bool D, bool
         auto address = u ? ir.GetRegister(n) : ir.Sub(ir.GetRegister(n), ir.Imm32(imm32));
         if (w)
             ir.SetRegister(n, u ? ir.Add(address, ir.Imm32(imm32)) : address);
-        for (size_t i = 0; i < regs; i++) {
-            auto word = ir.TransferFromFP32(ir.GetExtendedRegister(d + i));
-            ir.WriteMemory32(address, word);
-            address = ir.Add(address, ir.Imm32(4));
-        }
+        WriteExtRegisters(address, d, regs);
     }
     return true;
 }
@@ -688,14 +814,7 @@ bool ArmTranslatorVisitor::vfp2_VLDM_a1(Cond cond, bool p, bool u, bool D, bool
         auto address = u ? ir.GetRegister(n) : ir.Sub(ir.GetRegister(n), ir.Imm32(imm32));
         if (w)
             ir.SetRegister(n, u ? ir.Add(address, ir.Imm32(imm32)) : address);
-        for (size_t i = 0; i < regs; i++) {
-            auto word1 = ir.ReadMemory32(address);
-            address = ir.Add(address, ir.Imm32(4));
-            auto word2 = ir.ReadMemory32(address);
-            address = ir.Add(address, ir.Imm32(4));
-            if (ir.current_location.EFlag()) std::swap(word1, word2);
-            ir.SetExtendedRegister(d + i, ir.TransferToFP64(ir.Pack2x32To1x64(word1, word2)));
-        }
+        ReadExtRegisters(address, d, regs);
     }
     return true;
 }
@@ -722,11 +841,7 @@ bool ArmTranslatorVisitor::vfp2_VLDM_a2(Cond cond, bool p, bool u, bool D, bool
         auto address = u ? ir.GetRegister(n) : ir.Sub(ir.GetRegister(n), ir.Imm32(imm32));
         if (w)
             ir.SetRegister(n, u ? ir.Add(address, ir.Imm32(imm32)) : address);
-        for (size_t i = 0; i < regs; i++) {
-            auto word = ir.ReadMemory32(address);
-            address = ir.Add(address, ir.Imm32(4));
-            ir.SetExtendedRegister(d + i, ir.TransferToFP32(word));
-        }
+        ReadExtRegisters(address, d, regs);
     }
     return true;
 }
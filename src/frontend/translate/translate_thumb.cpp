@@ -4,15 +4,20 @@
  * General Public License version 2 or any later version.
  */
 
+#include <iterator>
 #include <tuple>
 
+#include <boost/optional.hpp>
+
 #include "common/assert.h"
 #include "common/bit_util.h"
+#include "frontend/arm/ITState.h"
 #include "frontend/arm/types.h"
 #include "frontend/decoder/thumb16.h"
 #include "frontend/decoder/thumb32.h"
 #include "frontend/ir/ir_emitter.h"
 #include "frontend/ir/location_descriptor.h"
+#include "frontend/translate/conditional_select.h"
 #include "frontend/translate/translate.h"
 
 namespace Dynarmic {
@@ -23,11 +28,48 @@ namespace {
 struct ThumbTranslatorVisitor final {
     using instruction_return_type = bool;
 
-    explicit ThumbTranslatorVisitor(IR::LocationDescriptor descriptor) : ir(descriptor) {
+    ThumbTranslatorVisitor(IR::LocationDescriptor descriptor, const TranslationOptions& options) : ir(descriptor), options(options), range_start(descriptor.PC()) {
         ASSERT_MSG(descriptor.TFlag(), "The processor must be in Thumb mode");
     }
 
     IR::IREmitter ir;
+    const TranslationOptions options;
+
+    /// Start of the range of guest code currently being translated.
+    u32 range_start;
+    /// Set when translation should continue at a branch target rather than the next instruction.
+    boost::optional<IR::LocationDescriptor> branch_target;
+    /// Set by an IT instruction to the If-Then state of the instructions that follow it.
+    boost::optional<ITState> next_it_state;
+    /// Guest instructions translated so far; the block's cycle count depends on their costs.
+    size_t instruction_count = 0;
+
+    bool FollowBranch(IR::LocationDescriptor target, u32 inst_size) {
+        if (instruction_count + 1 >= options.superblock_instruction_budget)
+            return false;
+        // Don't translate the same code twice; loops remain separate blocks.
+        const u32 target_pc = target.PC();
+        if (ir.block.ContainsGuestAddress(target_pc) || (target_pc >= range_start && target_pc < ir.current_location.PC() + inst_size))
+            return false;
+        if (options.starts_own_block && options.starts_own_block(target_pc))
+            return false;
+
+        branch_target = target;
+        return true;
+    }
+
+    /// Records a call or return of the instruction being translated, if options.profile_calls is set.
+    void ProfileCall(IR::Value function, u32 return_address) {
+        if (options.profile_calls) {
+            ir.ProfileCall(function, ir.Imm32(return_address), ir.Imm32(static_cast<u32>(ir.block.CycleCount())));
+        }
+    }
+
+    void ProfileReturn(IR::Value target) {
+        if (options.profile_calls) {
+            ir.ProfileReturn(target, ir.Imm32(static_cast<u32>(ir.block.CycleCount())));
+        }
+    }
 
     bool InterpretThisInstruction() {
         ir.SetTerm(IR::Term::Interpret(ir.current_location));
@@ -39,15 +81,287 @@ struct ThumbTranslatorVisitor final {
         return false;
     }
 
+    bool TranslateHint(Hint hint) {
+        ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 2));
+        ir.CallHint(hint);
+        ir.SetTerm(IR::Term::CheckHalt{IR::Term::LinkBlock{ir.current_location.AdvancePC(2)}});
+        return false;
+    }
+
+    bool InITBlock() const {
+        return ir.current_location.IT().IsInITBlock();
+    }
+
+    /**
+     * Translates an instruction of an IT block inline, making each register and flag it writes select
+     * between its new and old values depending on `cond`. An instruction that does anything else is
+     * removed again, and false is returned to have it predicated some other way.
+     */
+    template <typename TranslateFn>
+    bool TranslateWithSelects(Cond cond, TranslateFn translate, bool& should_continue) {
+        IR::Block& block = ir.block;
+        const auto passed = ir.TestCondition(cond);
+        const auto test_inst = std::prev(block.end());
+
+        should_continue = translate();
+
+        const bool selectable = should_continue && !branch_target && !block.HasTerminal()
+                                && CanPredicateWithSelects(block, std::next(test_inst));
+        if (!selectable) {
+            EraseInstructionsFrom(block, test_inst);
+            if (block.HasTerminal())
+                block.ReplaceTerminal(IR::Term::Invalid{});
+            branch_target = boost::none;
+            next_it_state = boost::none;
+            return false;
+        }
+
+        PredicateWithSelects(block, std::next(test_inst), passed);
+        return true;
+    }
+
+    static u32 rotr(u32 x, int shift) {
+        shift &= 31;
+        if (!shift) return x;
+        return (x >> shift) | (x << (32 - shift));
+    }
+
+    struct ImmAndCarry {
+        u32 imm32;
+        IR::Value carry;
+    };
+
+    ImmAndCarry ThumbExpandImm_C(bool i, Imm3 imm3, Imm8 imm8, IR::Value carry_in) {
+        const u32 imm12 = (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        if (Common::Bits<10, 11>(imm12) == 0) {
+            switch (Common::Bits<8, 9>(imm12)) {
+            case 0:
+                return {imm8, carry_in};
+            case 1:
+                return {imm8 * 0x00010001u, carry_in};
+            case 2:
+                return {imm8 * 0x01000100u, carry_in};
+            case 3:
+                return {imm8 * 0x01010101u, carry_in};
+            }
+        }
+        const u32 imm32 = rotr(0x80 | Common::Bits<0, 6>(imm12), Common::Bits<7, 11>(imm12));
+        return {imm32, ir.Imm1(Common::Bit<31>(imm32))};
+    }
+
+    u32 ThumbExpandImm(bool i, Imm3 imm3, Imm8 imm8) {
+        return ThumbExpandImm_C(i, imm3, imm8, ir.Imm1(false)).imm32;
+    }
+
+    IR::IREmitter::ResultAndCarry EmitImmShift(IR::Value value, ShiftType type, Imm3 imm3, Imm2 imm2, IR::Value carry_in) {
+        u8 imm5 = static_cast<u8>((imm3 << 2) | imm2);
+        switch (type) {
+        case ShiftType::LSL:
+            return ir.LogicalShiftLeft(value, ir.Imm8(imm5), carry_in);
+        case ShiftType::LSR:
+            imm5 = imm5 ? imm5 : 32;
+            return ir.LogicalShiftRight(value, ir.Imm8(imm5), carry_in);
+        case ShiftType::ASR:
+            imm5 = imm5 ? imm5 : 32;
+            return ir.ArithmeticShiftRight(value, ir.Imm8(imm5), carry_in);
+        case ShiftType::ROR:
+            if (imm5)
+                return ir.RotateRight(value, ir.Imm8(imm5), carry_in);
+            else
+                return ir.RotateRightExtended(value, carry_in);
+        }
+        ASSERT_MSG(false, "Unreachable");
+        return {};
+    }
+
+    IR::Value SignZeroExtendRor(Reg m, SignExtendRotation rotate) {
+        auto reg_m = ir.GetRegister(m);
+        if (rotate == SignExtendRotation::ROR_0)
+            return reg_m;
+        return ir.RotateRight(reg_m, ir.Imm8(static_cast<u8>(8 * static_cast<size_t>(rotate))), ir.Imm1(false)).result;
+    }
+
+    /// Writes the result of a logical data processing instruction, setting N, Z and C if S is set.
+    bool SetLogicalResult(bool S, Reg d, IR::Value result, IR::Value carry) {
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, result);
+        if (S) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+            ir.SetCFlag(carry);
+        }
+        return true;
+    }
+
+    /// Writes the result of an arithmetic data processing instruction, setting N, Z, C and V if S is set.
+    bool SetArithmeticResult(bool S, Reg d, IR::IREmitter::ResultAndCarryAndOverflow result) {
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, result.result);
+        if (S) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
+        return true;
+    }
+
+    void SetTestFlags(IR::Value result, IR::Value carry) {
+        ir.SetNFlag(ir.MostSignificantBit(result));
+        ir.SetZFlag(ir.IsZero(result));
+        ir.SetCFlag(carry);
+    }
+
+    void SetCompareFlags(IR::IREmitter::ResultAndCarryAndOverflow result) {
+        ir.SetNFlag(ir.MostSignificantBit(result.result));
+        ir.SetZFlag(ir.IsZero(result.result));
+        ir.SetCFlag(result.carry);
+        ir.SetVFlag(result.overflow);
+    }
+
+    IR::Value GetAddressingMode(bool P, bool U, bool W, Reg n, IR::Value offset) {
+        auto offset_address = U ? ir.Add(ir.GetRegister(n), offset) : ir.Sub(ir.GetRegister(n), offset);
+        auto address = P ? offset_address : ir.GetRegister(n);
+        if (W) {
+            ir.SetRegister(n, offset_address);
+        }
+        return address;
+    }
+
+    IR::Value ReadMemory(size_t bit_size, bool sign_extend, IR::Value address) {
+        switch (bit_size) {
+        case 8: {
+            auto data = ir.ReadMemory8(address);
+            return sign_extend ? ir.SignExtendByteToWord(data) : ir.ZeroExtendByteToWord(data);
+        }
+        case 16: {
+            auto data = ir.ReadMemory16(address);
+            return sign_extend ? ir.SignExtendHalfToWord(data) : ir.ZeroExtendHalfToWord(data);
+        }
+        case 32:
+            return ir.ReadMemory32(address);
+        }
+        ASSERT_MSG(false, "Unreachable");
+        return {};
+    }
+
+    void WriteMemory(size_t bit_size, IR::Value address, IR::Value data) {
+        switch (bit_size) {
+        case 8:
+            ir.WriteMemory8(address, ir.LeastSignificantByte(data));
+            return;
+        case 16:
+            ir.WriteMemory16(address, ir.LeastSignificantHalf(data));
+            return;
+        case 32:
+            ir.WriteMemory32(address, data);
+            return;
+        }
+        ASSERT_MSG(false, "Unreachable");
+    }
+
+    /// Writes loaded data to Rt. Loading into the PC is an interworking branch.
+    bool LoadRegister(Reg t, IR::Value data, bool is_pop) {
+        if (t == Reg::PC) {
+            ir.LoadWritePC(data);
+            if (is_pop) {
+                ProfileReturn(data);
+                ir.SetTerm(IR::Term::PopRSBHint{});
+            } else {
+                ir.SetTerm(IR::Term::ReturnToDispatch{});
+            }
+            return false;
+        }
+        ir.SetRegister(t, data);
+        return true;
+    }
+
+    // Byte and halfword loads into the PC encode preload hints, which we treat as NOPs.
+
+    bool LoadLiteral(size_t bit_size, bool sign_extend, bool U, Reg t, Imm12 imm12) {
+        if (t == Reg::PC && bit_size != 32)
+            return true;
+        const u32 address = U ? ir.AlignPC(4) + imm12 : ir.AlignPC(4) - imm12;
+        return LoadRegister(t, ReadMemory(bit_size, sign_extend, ir.Imm32(address)), false);
+    }
+
+    bool LoadImm12(size_t bit_size, bool sign_extend, Reg n, Reg t, Imm12 imm12) {
+        if (t == Reg::PC && bit_size != 32)
+            return true;
+        auto address = ir.Add(ir.GetRegister(n), ir.Imm32(imm12));
+        return LoadRegister(t, ReadMemory(bit_size, sign_extend, address), false);
+    }
+
+    bool LoadImm8(size_t bit_size, bool sign_extend, Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        if (!P && !W)
+            return thumb32_UDF();
+        if (P && U && !W)
+            return InterpretThisInstruction(); // Unprivileged (LDRT) form
+        if (t == Reg::PC && bit_size != 32)
+            return true;
+        if (W && n == t)
+            return UnpredictableInstruction();
+        auto address = GetAddressingMode(P, U, W, n, ir.Imm32(imm8));
+        return LoadRegister(t, ReadMemory(bit_size, sign_extend, address), !P && W && n == Reg::SP);
+    }
+
+    bool LoadReg(size_t bit_size, bool sign_extend, Reg n, Reg t, Imm2 imm2, Reg m) {
+        if (m == Reg::PC || m == Reg::SP)
+            return UnpredictableInstruction();
+        if (t == Reg::PC && bit_size != 32)
+            return true;
+        auto offset = ir.LogicalShiftLeft(ir.GetRegister(m), ir.Imm8(imm2), ir.Imm1(false)).result;
+        auto address = ir.Add(ir.GetRegister(n), offset);
+        return LoadRegister(t, ReadMemory(bit_size, sign_extend, address), false);
+    }
+
+    bool StoreImm12(size_t bit_size, Reg n, Reg t, Imm12 imm12) {
+        if (n == Reg::PC)
+            return thumb32_UDF();
+        if (t == Reg::PC)
+            return UnpredictableInstruction();
+        auto address = ir.Add(ir.GetRegister(n), ir.Imm32(imm12));
+        WriteMemory(bit_size, address, ir.GetRegister(t));
+        return true;
+    }
+
+    bool StoreImm8(size_t bit_size, Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        if (n == Reg::PC || (!P && !W))
+            return thumb32_UDF();
+        if (P && U && !W)
+            return InterpretThisInstruction(); // Unprivileged (STRT) form
+        if (t == Reg::PC || (W && n == t))
+            return UnpredictableInstruction();
+        auto data = ir.GetRegister(t);
+        auto address = GetAddressingMode(P, U, W, n, ir.Imm32(imm8));
+        WriteMemory(bit_size, address, data);
+        return true;
+    }
+
+    bool StoreReg(size_t bit_size, Reg n, Reg t, Imm2 imm2, Reg m) {
+        if (n == Reg::PC)
+            return thumb32_UDF();
+        if (t == Reg::PC || m == Reg::PC || m == Reg::SP)
+            return UnpredictableInstruction();
+        auto offset = ir.LogicalShiftLeft(ir.GetRegister(m), ir.Imm8(imm2), ir.Imm1(false)).result;
+        auto address = ir.Add(ir.GetRegister(n), offset);
+        WriteMemory(bit_size, address, ir.GetRegister(t));
+        return true;
+    }
+
     bool thumb16_LSL_imm(Imm5 imm5, Reg m, Reg d) {
         u8 shift_n = imm5;
         // LSLS <Rd>, <Rm>, #<imm5>
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.LogicalShiftLeft(ir.GetRegister(m), ir.Imm8(shift_n), cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -57,9 +371,11 @@ struct ThumbTranslatorVisitor final {
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.LogicalShiftRight(ir.GetRegister(m), ir.Imm8(shift_n), cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -69,9 +385,11 @@ struct ThumbTranslatorVisitor final {
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.ArithmeticShiftRight(ir.GetRegister(m), ir.Imm8(shift_n), cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -80,10 +398,12 @@ struct ThumbTranslatorVisitor final {
         // Note that it is not possible to encode Rd == R15.
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.GetRegister(m), ir.Imm1(0));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -92,10 +412,12 @@ struct ThumbTranslatorVisitor final {
         // Note that it is not possible to encode Rd == R15.
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.GetRegister(m), ir.Imm1(1));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -105,10 +427,12 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(0));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -118,10 +442,12 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(1));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -131,8 +457,10 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.Imm32(imm32);
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -154,10 +482,12 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(0));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -168,10 +498,12 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(1));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -181,8 +513,10 @@ struct ThumbTranslatorVisitor final {
         // Note that it is not possible to encode Rdn == R15.
         auto result = ir.And(ir.GetRegister(n), ir.GetRegister(m));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -192,8 +526,10 @@ struct ThumbTranslatorVisitor final {
         // Note that it is not possible to encode Rdn == R15.
         auto result = ir.Eor(ir.GetRegister(n), ir.GetRegister(m));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -204,9 +540,11 @@ struct ThumbTranslatorVisitor final {
         auto apsr_c = ir.GetCFlag();
         auto result_carry = ir.LogicalShiftLeft(ir.GetRegister(n), shift_n, apsr_c);
         ir.SetRegister(d, result_carry.result);
-        ir.SetNFlag(ir.MostSignificantBit(result_carry.result));
-        ir.SetZFlag(ir.IsZero(result_carry.result));
-        ir.SetCFlag(result_carry.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result_carry.result));
+            ir.SetZFlag(ir.IsZero(result_carry.result));
+            ir.SetCFlag(result_carry.carry);
+        }
         return true;
     }
 
@@ -217,9 +555,11 @@ struct ThumbTranslatorVisitor final {
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.LogicalShiftRight(ir.GetRegister(n), shift_n, cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -230,9 +570,11 @@ struct ThumbTranslatorVisitor final {
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.ArithmeticShiftRight(ir.GetRegister(n), shift_n, cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -243,10 +585,12 @@ struct ThumbTranslatorVisitor final {
         auto aspr_c = ir.GetCFlag();
         auto result = ir.AddWithCarry(ir.GetRegister(n), ir.GetRegister(m), aspr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -257,10 +601,12 @@ struct ThumbTranslatorVisitor final {
         auto aspr_c = ir.GetCFlag();
         auto result = ir.SubWithCarry(ir.GetRegister(n), ir.GetRegister(m), aspr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -271,9 +617,11 @@ struct ThumbTranslatorVisitor final {
         auto cpsr_c = ir.GetCFlag();
         auto result = ir.RotateRight(ir.GetRegister(n), shift_n, cpsr_c);
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+        }
         return true;
     }
 
@@ -290,10 +638,12 @@ struct ThumbTranslatorVisitor final {
         // Rd can never encode R15.
         auto result = ir.SubWithCarry(ir.Imm32(0), ir.GetRegister(n), ir.Imm1(1));
         ir.SetRegister(d, result.result);
-        ir.SetNFlag(ir.MostSignificantBit(result.result));
-        ir.SetZFlag(ir.IsZero(result.result));
-        ir.SetCFlag(result.carry);
-        ir.SetVFlag(result.overflow);
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result.result));
+            ir.SetZFlag(ir.IsZero(result.result));
+            ir.SetCFlag(result.carry);
+            ir.SetVFlag(result.overflow);
+        }
         return true;
     }
 
@@ -323,8 +673,10 @@ struct ThumbTranslatorVisitor final {
         // Rd cannot encode R15.
         auto result = ir.Or(ir.GetRegister(m), ir.GetRegister(n));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -334,8 +686,10 @@ struct ThumbTranslatorVisitor final {
         // Rd cannot encode R15.
         auto result = ir.Mul(ir.GetRegister(m), ir.GetRegister(n));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -343,10 +697,12 @@ struct ThumbTranslatorVisitor final {
         Reg d = d_n, n = d_n;
         // BICS <Rdn>, <Rm>
         // Rd cannot encode R15.
-        auto result = ir.And(ir.GetRegister(n), ir.Not(ir.GetRegister(m)));
+        auto result = ir.AndNot(ir.GetRegister(n), ir.GetRegister(m));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -355,8 +711,10 @@ struct ThumbTranslatorVisitor final {
         // Rd cannot encode R15.
         auto result = ir.Not(ir.GetRegister(m));
         ir.SetRegister(d, result);
-        ir.SetNFlag(ir.MostSignificantBit(result));
-        ir.SetZFlag(ir.IsZero(result));
+        if (!InITBlock()) {
+            ir.SetNFlag(ir.MostSignificantBit(result));
+            ir.SetZFlag(ir.IsZero(result));
+        }
         return true;
     }
 
@@ -647,15 +1005,8 @@ struct ThumbTranslatorVisitor final {
         // reg_list cannot encode for R15.
         const u32 num_bytes_to_push = static_cast<u32>(4 * Common::BitCount(reg_list));
         const auto final_address = ir.Sub(ir.GetRegister(Reg::SP), ir.Imm32(num_bytes_to_push));
-        auto address = final_address;
-        for (size_t i = 0; i < 16; i++) {
-            if (Common::Bit(i, reg_list)) {
-                // TODO: Deal with alignment
-                auto Ri = ir.GetRegister(static_cast<Reg>(i));
-                ir.WriteMemory32(address, Ri);
-                address = ir.Add(address, ir.Imm32(4));
-            }
-        }
+        // TODO: Deal with alignment
+        ir.WriteMemoryFromRegisters(final_address, reg_list);
         ir.SetRegister(Reg::SP, final_address);
         // TODO(optimization): Possible location for an RSB push.
         return true;
@@ -667,14 +1018,12 @@ struct ThumbTranslatorVisitor final {
             return UnpredictableInstruction();
         }
         // POP <reg_list>
+        const RegList reg_list_without_pc = reg_list & 0x7FFF;
         auto address = ir.GetRegister(Reg::SP);
-        for (size_t i = 0; i < 15; i++) {
-            if (Common::Bit(i, reg_list)) {
-                // TODO: Deal with alignment
-                auto data = ir.ReadMemory32(address);
-                ir.SetRegister(static_cast<Reg>(i), data);
-                address = ir.Add(address, ir.Imm32(4));
-            }
+        if (reg_list_without_pc != 0) {
+            // TODO: Deal with alignment
+            ir.ReadMemoryToRegisters(address, reg_list_without_pc);
+            address = ir.Add(address, ir.Imm32(static_cast<u32>(4 * Common::BitCount(reg_list_without_pc))));
         }
         if (Common::Bit<15>(reg_list)) {
             // TODO(optimization): Possible location for an RSB pop.
@@ -682,6 +1031,7 @@ struct ThumbTranslatorVisitor final {
             ir.LoadWritePC(data);
             address = ir.Add(address, ir.Imm32(4));
             ir.SetRegister(Reg::SP, address);
+            ProfileReturn(data);
             ir.SetTerm(IR::Term::ReturnToDispatch{});
             return false;
         } else {
@@ -695,7 +1045,7 @@ struct ThumbTranslatorVisitor final {
         if (E == ir.current_location.EFlag()) {
             return true;
         }
-        ir.SetTerm(IR::Term::LinkBlock{ir.current_location.AdvancePC(2).SetEFlag(E)});
+        ir.SetTerm(IR::Term::LinkBlock{ir.current_location.AdvancePC(2).AdvanceIT().SetEFlag(E)});
         return false;
     }
 
@@ -735,33 +1085,53 @@ struct ThumbTranslatorVisitor final {
         return true;
     }
 
-    bool thumb16_STMIA(Reg n, RegList reg_list) {
-        // STM <Rn>!, <reg_list>
-        auto address = ir.GetRegister(n);
-        for (size_t i = 0; i < 8; i++) {
-            if (Common::Bit(i, reg_list)) {
-                auto Ri = ir.GetRegister(static_cast<Reg>(i));
-                ir.WriteMemory32(address, Ri);
-                address = ir.Add(address, ir.Imm32(4));
+    bool thumb16_IT(Cond firstcond, Imm4 mask) {
+        if (mask == 0) {
+            // NOP, YIELD, WFE, WFI and SEV. Hints are NOPs unless they are reported to UserCallbacks::CallHint.
+            if (!options.call_hints || InITBlock())
+                return true;
+            switch (static_cast<size_t>(firstcond)) {
+            case 1:
+                return TranslateHint(Hint::Yield);
+            case 2:
+                return TranslateHint(Hint::WaitForEvent);
+            case 3:
+                return TranslateHint(Hint::WaitForInterrupt);
+            case 4:
+                return TranslateHint(Hint::SendEvent);
+            default:
+                return true;
             }
         }
-        ir.SetRegister(n, address);
+        if (firstcond == Cond::NV || (firstcond == Cond::AL && Common::BitCount(mask) != 1) || InITBlock()) {
+            return UnpredictableInstruction();
+        }
+        // IT{<x>{<y>{<z>}}} <firstcond>
+        next_it_state = ITState{static_cast<u8>((static_cast<u8>(firstcond) << 4) | mask)};
+        return true;
+    }
+
+    bool thumb16_STMIA(Reg n, RegList reg_list) {
+        if (Common::BitCount(reg_list) < 1) {
+            return UnpredictableInstruction();
+        }
+        // STM <Rn>!, <reg_list>
+        const auto start_address = ir.GetRegister(n);
+        ir.WriteMemoryFromRegisters(start_address, reg_list);
+        ir.SetRegister(n, ir.Add(start_address, ir.Imm32(static_cast<u32>(4 * Common::BitCount(reg_list)))));
         return true;
     }
 
     bool thumb16_LDMIA(Reg n, RegList reg_list) {
+        if (Common::BitCount(reg_list) < 1) {
+            return UnpredictableInstruction();
+        }
         bool write_back = !Dynarmic::Common::Bit(static_cast<size_t>(n), reg_list);
         // STM <Rn>!, <reg_list>
-        auto address = ir.GetRegister(n);
-        for (size_t i = 0; i < 8; i++) {
-            if (Common::Bit(i, reg_list)) {
-                auto data = ir.ReadMemory32(address);
-                ir.SetRegister(static_cast<Reg>(i), data);
-                address = ir.Add(address, ir.Imm32(4));
-            }
-        }
+        const auto start_address = ir.GetRegister(n);
+        ir.ReadMemoryToRegisters(start_address, reg_list);
         if (write_back) {
-            ir.SetRegister(n, address);
+            ir.SetRegister(n, ir.Add(start_address, ir.Imm32(static_cast<u32>(4 * Common::BitCount(reg_list)))));
         }
         return true;
     }
@@ -772,28 +1142,37 @@ struct ThumbTranslatorVisitor final {
 
     bool thumb16_BX(Reg m) {
         // BX <Rm>
-        ir.BXWritePC(ir.GetRegister(m));
-        if (m == Reg::R14)
+        const auto target = ir.GetRegister(m);
+        ir.BXWritePC(target);
+        if (m == Reg::R14) {
+            ProfileReturn(target);
             ir.SetTerm(IR::Term::PopRSBHint{});
-        else
+        } else {
             ir.SetTerm(IR::Term::ReturnToDispatch{});
+        }
         return false;
     }
 
     bool thumb16_BLX_reg(Reg m) {
         // BLX <Rm>
-        ir.PushRSB(ir.current_location.AdvancePC(2));
-        ir.BXWritePC(ir.GetRegister(m));
+        ir.PushRSB(ir.current_location.AdvancePC(2).AdvanceIT());
+        const auto target = ir.GetRegister(m);
+        ir.BXWritePC(target);
         ir.SetRegister(Reg::LR, ir.Imm32((ir.current_location.PC() + 2) | 1));
+        ProfileCall(target, ir.current_location.PC() + 2);
         ir.SetTerm(IR::Term::ReturnToDispatch{});
         return false;
     }
 
     bool thumb16_SVC(Imm8 imm8) {
         u32 imm32 = imm8;
+        if (InITBlock() && !ir.current_location.IT().IsLastInITBlock()) {
+            // Returning from the supervisor call to the middle of an IT block is left to the interpreter.
+            return InterpretThisInstruction();
+        }
         // SVC #<imm8>
         ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 2));
-        ir.PushRSB(ir.current_location.AdvancePC(2));
+        ir.PushRSB(ir.current_location.AdvancePC(2).AdvanceIT());
         ir.CallSupervisor(ir.Imm32(imm32));
         ir.SetTerm(IR::Term::CheckHalt{IR::Term::PopRSBHint{}});
         return false;
@@ -805,8 +1184,8 @@ struct ThumbTranslatorVisitor final {
             return thumb16_UDF();
         }
         // B<cond> <label>
-        auto then_location = ir.current_location.AdvancePC(imm32);
-        auto else_location = ir.current_location.AdvancePC(2);
+        auto then_location = ir.current_location.AdvancePC(imm32).AdvanceIT();
+        auto else_location = ir.current_location.AdvancePC(2).AdvanceIT();
         ir.SetTerm(IR::Term::If{cond, IR::Term::LinkBlock{then_location}, IR::Term::LinkBlock{else_location}});
         return false;
     }
@@ -814,101 +1193,1000 @@ struct ThumbTranslatorVisitor final {
     bool thumb16_B_t2(Imm11 imm11) {
         s32 imm32 = Common::SignExtend<12, s32>(imm11 << 1) + 4;
         // B <label>
-        auto next_location = ir.current_location.AdvancePC(imm32);
+        auto next_location = ir.current_location.AdvancePC(imm32).AdvanceIT();
+        if (FollowBranch(next_location, 2))
+            return true;
         ir.SetTerm(IR::Term::LinkBlock{next_location});
         return false;
     }
 
-    bool thumb32_BL_imm(Imm11 hi, Imm11 lo) {
-        s32 imm32 = Common::SignExtend<23, s32>((hi << 12) | (lo << 1)) + 4;
-        // BL <label>
-        ir.PushRSB(ir.current_location.AdvancePC(4));
-        ir.SetRegister(Reg::LR, ir.Imm32((ir.current_location.PC() + 4) | 1));
-        auto new_location = ir.current_location.AdvancePC(imm32);
-        ir.SetTerm(IR::Term::LinkBlock{new_location});
-        return false;
+    bool thumb32_TST_imm(bool i, Reg n, Imm3 imm3, Imm8 imm8) {
+        // TST <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.And(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
+        SetTestFlags(result, imm_carry.carry);
+        return true;
     }
 
-    bool thumb32_BLX_imm(Imm11 hi, Imm11 lo) {
-        s32 imm32 = Common::SignExtend<23, s32>((hi << 12) | (lo << 1));
-        if ((lo & 1) != 0) {
-            return UnpredictableInstruction();
-        }
-        // BLX <label>
-        ir.PushRSB(ir.current_location.AdvancePC(4));
-        ir.SetRegister(Reg::LR, ir.Imm32((ir.current_location.PC() + 4) | 1));
-        auto new_location = ir.current_location
-                              .SetPC(ir.AlignPC(4) + imm32)
-                              .SetTFlag(false);
-        ir.SetTerm(IR::Term::LinkBlock{new_location});
-        return false;
+    bool thumb32_AND_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // AND{S} <Rd>, <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.And(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
+        return SetLogicalResult(S, d, result, imm_carry.carry);
     }
 
-    bool thumb32_UDF() {
-        return thumb16_UDF();
+    bool thumb32_BIC_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // BIC{S} <Rd>, <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.And(ir.GetRegister(n), ir.Imm32(~imm_carry.imm32));
+        return SetLogicalResult(S, d, result, imm_carry.carry);
     }
-};
 
-enum class ThumbInstSize {
-    Thumb16, Thumb32
-};
+    bool thumb32_MOV_imm(bool i, bool S, Imm3 imm3, Reg d, Imm8 imm8) {
+        // MOV{S} <Rd>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        return SetLogicalResult(S, d, ir.Imm32(imm_carry.imm32), imm_carry.carry);
+    }
 
-std::tuple<u32, ThumbInstSize> ReadThumbInstruction(u32 arm_pc, MemoryReadCodeFuncType memory_read_code) {
-    u32 first_part = memory_read_code(arm_pc & 0xFFFFFFFC);
-    if ((arm_pc & 0x2) != 0)
-        first_part >>= 16;
-    first_part &= 0xFFFF;
+    bool thumb32_ORR_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // ORR{S} <Rd>, <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.Or(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
+        return SetLogicalResult(S, d, result, imm_carry.carry);
+    }
 
-    if ((first_part & 0xF800) <= 0xE800) {
-        // 16-bit thumb instruction
-        return std::make_tuple(first_part, ThumbInstSize::Thumb16);
+    bool thumb32_MVN_imm(bool i, bool S, Imm3 imm3, Reg d, Imm8 imm8) {
+        // MVN{S} <Rd>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        return SetLogicalResult(S, d, ir.Imm32(~imm_carry.imm32), imm_carry.carry);
     }
 
-    // 32-bit thumb instruction
-    // These always start with 0b11101, 0b11110 or 0b11111.
+    bool thumb32_ORN_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // ORN{S} <Rd>, <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.Or(ir.GetRegister(n), ir.Imm32(~imm_carry.imm32));
+        return SetLogicalResult(S, d, result, imm_carry.carry);
+    }
 
-    u32 second_part = memory_read_code((arm_pc + 2) & 0xFFFFFFFC);
-    if (((arm_pc + 2) & 0x2) != 0)
-        second_part >>= 16;
-    second_part &= 0xFFFF;
+    bool thumb32_TEQ_imm(bool i, Reg n, Imm3 imm3, Imm8 imm8) {
+        // TEQ <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.Eor(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
+        SetTestFlags(result, imm_carry.carry);
+        return true;
+    }
+
+    bool thumb32_EOR_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // EOR{S} <Rd>, <Rn>, #<const>
+        auto imm_carry = ThumbExpandImm_C(i, imm3, imm8, ir.GetCFlag());
+        auto result = ir.Eor(ir.GetRegister(n), ir.Imm32(imm_carry.imm32));
+        return SetLogicalResult(S, d, result, imm_carry.carry);
+    }
+
+    bool thumb32_CMN_imm(bool i, Reg n, Imm3 imm3, Imm8 imm8) {
+        // CMN <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        SetCompareFlags(ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(false)));
+        return true;
+    }
+
+    bool thumb32_ADD_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // ADD{S} <Rd>, <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(false));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_ADC_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // ADC{S} <Rd>, <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        auto result = ir.AddWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.GetCFlag());
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_SBC_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // SBC{S} <Rd>, <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.GetCFlag());
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_CMP_imm(bool i, Reg n, Imm3 imm3, Imm8 imm8) {
+        // CMP <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        SetCompareFlags(ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(true)));
+        return true;
+    }
+
+    bool thumb32_SUB_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // SUB{S} <Rd>, <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        auto result = ir.SubWithCarry(ir.GetRegister(n), ir.Imm32(imm32), ir.Imm1(true));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_RSB_imm(bool i, bool S, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        // RSB{S} <Rd>, <Rn>, #<const>
+        u32 imm32 = ThumbExpandImm(i, imm3, imm8);
+        auto result = ir.SubWithCarry(ir.Imm32(imm32), ir.GetRegister(n), ir.Imm1(true));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_ADR_t3(bool i, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm32 = (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // ADR <Rd>, <label>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, ir.Imm32(ir.AlignPC(4) + imm32));
+        return true;
+    }
+
+    bool thumb32_ADDW_imm(bool i, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm32 = (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // ADDW <Rd>, <Rn>, #<imm12>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, ir.Add(ir.GetRegister(n), ir.Imm32(imm32)));
+        return true;
+    }
+
+    bool thumb32_MOVW_imm(bool i, Imm4 imm4, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm32 = (imm4 << 12) | (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // MOVW <Rd>, #<imm16>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, ir.Imm32(imm32));
+        return true;
+    }
+
+    bool thumb32_ADR_t2(bool i, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm32 = (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // ADR <Rd>, <label>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, ir.Imm32(ir.AlignPC(4) - imm32));
+        return true;
+    }
+
+    bool thumb32_SUBW_imm(bool i, Reg n, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm32 = (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // SUBW <Rd>, <Rn>, #<imm12>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        ir.SetRegister(d, ir.Sub(ir.GetRegister(n), ir.Imm32(imm32)));
+        return true;
+    }
+
+    bool thumb32_MOVT(bool i, Imm4 imm4, Imm3 imm3, Reg d, Imm8 imm8) {
+        u32 imm16 = (imm4 << 12) | (static_cast<u32>(i) << 11) | (imm3 << 8) | imm8;
+        // MOVT <Rd>, #<imm16>
+        if (d == Reg::PC)
+            return UnpredictableInstruction();
+        auto lower_half = ir.And(ir.GetRegister(d), ir.Imm32(0x0000FFFF));
+        ir.SetRegister(d, ir.Or(lower_half, ir.Imm32(imm16 << 16)));
+        return true;
+    }
+
+    bool thumb32_SBFX(Reg n, Imm3 imm3, Reg d, Imm2 imm2, Imm5 widthm1) {
+        const size_t lsb = (imm3 << 2) | imm2;
+        const size_t msb = lsb + widthm1;
+        if (d == Reg::PC || n == Reg::PC || msb > 31)
+            return UnpredictableInstruction();
+        // SBFX <Rd>, <Rn>, #<lsb>, #<width>
+        auto shifted = ir.LogicalShiftLeft(ir.GetRegister(n), ir.Imm8(static_cast<u8>(31 - msb)), ir.Imm1(false)).result;
+        auto result = ir.ArithmeticShiftRight(shifted, ir.Imm8(static_cast<u8>(31 - widthm1)), ir.Imm1(false)).result;
+        ir.SetRegister(d, result);
+        return true;
+    }
+
+    bool thumb32_BFC(Imm3 imm3, Reg d, Imm2 imm2, Imm5 msb) {
+        const size_t lsb = (imm3 << 2) | imm2;
+        if (d == Reg::PC || msb < lsb)
+            return UnpredictableInstruction();
+        // BFC <Rd>, #<lsb>, #<width>
+        const u32 mask = static_cast<u32>((u64(1) << (msb - lsb + 1)) - 1) << lsb;
+        ir.SetRegister(d, ir.And(ir.GetRegister(d), ir.Imm32(~mask)));
+        return true;
+    }
+
+    bool thumb32_BFI(Reg n, Imm3 imm3, Reg d, Imm2 imm2, Imm5 msb) {
+        const size_t lsb = (imm3 << 2) | imm2;
+        if (d == Reg::PC || msb < lsb)
+            return UnpredictableInstruction();
+        // BFI <Rd>, <Rn>, #<lsb>, #<width>
+        const u32 mask = static_cast<u32>((u64(1) << (msb - lsb + 1)) - 1) << lsb;
+        auto inserted = ir.LogicalShiftLeft(ir.GetRegister(n), ir.Imm8(static_cast<u8>(lsb)), ir.Imm1(false)).result;
+        auto result = ir.Or(ir.And(ir.GetRegister(d), ir.Imm32(~mask)), ir.And(inserted, ir.Imm32(mask)));
+        ir.SetRegister(d, result);
+        return true;
+    }
+
+    bool thumb32_UBFX(Reg n, Imm3 imm3, Reg d, Imm2 imm2, Imm5 widthm1) {
+        const size_t lsb = (imm3 << 2) | imm2;
+        if (d == Reg::PC || n == Reg::PC || lsb + widthm1 > 31)
+            return UnpredictableInstruction();
+        // UBFX <Rd>, <Rn>, #<lsb>, #<width>
+        const u32 mask = static_cast<u32>((u64(1) << (widthm1 + 1)) - 1);
+        auto shifted = ir.LogicalShiftRight(ir.GetRegister(n), ir.Imm8(static_cast<u8>(lsb)), ir.Imm1(false)).result;
+        ir.SetRegister(d, ir.And(shifted, ir.Imm32(mask)));
+        return true;
+    }
+
+    bool thumb32_TST_reg(Reg n, Imm3 imm3, Imm2 imm2, ShiftType type, Reg m) {
+        // TST.W <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.And(ir.GetRegister(n), shifted.result);
+        SetTestFlags(result, shifted.carry);
+        return true;
+    }
+
+    bool thumb32_AND_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // AND{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.And(ir.GetRegister(n), shifted.result);
+        return SetLogicalResult(S, d, result, shifted.carry);
+    }
+
+    bool thumb32_BIC_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // BIC{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.AndNot(ir.GetRegister(n), shifted.result);
+        return SetLogicalResult(S, d, result, shifted.carry);
+    }
+
+    bool thumb32_MOV_reg(bool S, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // MOV{S}.W <Rd>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        return SetLogicalResult(S, d, shifted.result, shifted.carry);
+    }
+
+    bool thumb32_ORR_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // ORR{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.Or(ir.GetRegister(n), shifted.result);
+        return SetLogicalResult(S, d, result, shifted.carry);
+    }
+
+    bool thumb32_MVN_reg(bool S, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // MVN{S}.W <Rd>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        return SetLogicalResult(S, d, ir.Not(shifted.result), shifted.carry);
+    }
+
+    bool thumb32_ORN_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // ORN{S} <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.Or(ir.GetRegister(n), ir.Not(shifted.result));
+        return SetLogicalResult(S, d, result, shifted.carry);
+    }
+
+    bool thumb32_TEQ_reg(Reg n, Imm3 imm3, Imm2 imm2, ShiftType type, Reg m) {
+        // TEQ <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.Eor(ir.GetRegister(n), shifted.result);
+        SetTestFlags(result, shifted.carry);
+        return true;
+    }
+
+    bool thumb32_EOR_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // EOR{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.Eor(ir.GetRegister(n), shifted.result);
+        return SetLogicalResult(S, d, result, shifted.carry);
+    }
+
+    bool thumb32_CMN_reg(Reg n, Imm3 imm3, Imm2 imm2, ShiftType type, Reg m) {
+        // CMN.W <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        SetCompareFlags(ir.AddWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(false)));
+        return true;
+    }
+
+    bool thumb32_ADD_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // ADD{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.AddWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(false));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_ADC_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // ADC{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.AddWithCarry(ir.GetRegister(n), shifted.result, ir.GetCFlag());
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_SBC_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // SBC{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.SubWithCarry(ir.GetRegister(n), shifted.result, ir.GetCFlag());
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_CMP_reg(Reg n, Imm3 imm3, Imm2 imm2, ShiftType type, Reg m) {
+        // CMP.W <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        SetCompareFlags(ir.SubWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(true)));
+        return true;
+    }
+
+    bool thumb32_SUB_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // SUB{S}.W <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.SubWithCarry(ir.GetRegister(n), shifted.result, ir.Imm1(true));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_RSB_reg(bool S, Reg n, Imm3 imm3, Reg d, Imm2 imm2, ShiftType type, Reg m) {
+        // RSB{S} <Rd>, <Rn>, <Rm>{, <shift>}
+        auto shifted = EmitImmShift(ir.GetRegister(m), type, imm3, imm2, ir.GetCFlag());
+        auto result = ir.SubWithCarry(shifted.result, ir.GetRegister(n), ir.Imm1(true));
+        return SetArithmeticResult(S, d, result);
+    }
+
+    bool thumb32_LSL_reg(bool S, Reg n, Reg d, Reg m) {
+        // LSL{S}.W <Rd>, <Rn>, <Rm>
+        auto shift_n = ir.LeastSignificantByte(ir.GetRegister(m));
+        auto result = ir.LogicalShiftLeft(ir.GetRegister(n), shift_n, ir.GetCFlag());
+        return SetLogicalResult(S, d, result.result, result.carry);
+    }
+
+    bool thumb32_LSR_reg(bool S, Reg n, Reg d, Reg m) {
+        // LSR{S}.W <Rd>, <Rn>, <Rm>
+        auto shift_n = ir.LeastSignificantByte(ir.GetRegister(m));
+        auto result = ir.LogicalShiftRight(ir.GetRegister(n), shift_n, ir.GetCFlag());
+        return SetLogicalResult(S, d, result.result, result.carry);
+    }
+
+    bool thumb32_ASR_reg(bool S, Reg n, Reg d, Reg m) {
+        // ASR{S}.W <Rd>, <Rn>, <Rm>
+        auto shift_n = ir.LeastSignificantByte(ir.GetRegister(m));
+        auto result = ir.ArithmeticShiftRight(ir.GetRegister(n), shift_n, ir.GetCFlag());
+        return SetLogicalResult(S, d, result.result, result.carry);
+    }
+
+    bool thumb32_ROR_reg(bool S, Reg n, Reg d, Reg m) {
+        // ROR{S}.W <Rd>, <Rn>, <Rm>
+        auto shift_n = ir.LeastSignificantByte(ir.GetRegister(m));
+        auto result = ir.RotateRight(ir.GetRegister(n), shift_n, ir.GetCFlag());
+        return SetLogicalResult(S, d, result.result, result.carry);
+    }
+
+    bool thumb32_SXTH(Reg d, SignExtendRotation rotate, Reg m) {
+        if (d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // SXTH.W <Rd>, <Rm>{, <rotation>}
+        auto half = ir.LeastSignificantHalf(SignZeroExtendRor(m, rotate));
+        ir.SetRegister(d, ir.SignExtendHalfToWord(half));
+        return true;
+    }
+
+    bool thumb32_UXTH(Reg d, SignExtendRotation rotate, Reg m) {
+        if (d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // UXTH.W <Rd>, <Rm>{, <rotation>}
+        auto half = ir.LeastSignificantHalf(SignZeroExtendRor(m, rotate));
+        ir.SetRegister(d, ir.ZeroExtendHalfToWord(half));
+        return true;
+    }
+
+    bool thumb32_SXTB(Reg d, SignExtendRotation rotate, Reg m) {
+        if (d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // SXTB.W <Rd>, <Rm>{, <rotation>}
+        auto byte = ir.LeastSignificantByte(SignZeroExtendRor(m, rotate));
+        ir.SetRegister(d, ir.SignExtendByteToWord(byte));
+        return true;
+    }
+
+    bool thumb32_UXTB(Reg d, SignExtendRotation rotate, Reg m) {
+        if (d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // UXTB.W <Rd>, <Rm>{, <rotation>}
+        auto byte = ir.LeastSignificantByte(SignZeroExtendRor(m, rotate));
+        ir.SetRegister(d, ir.ZeroExtendByteToWord(byte));
+        return true;
+    }
+
+    bool thumb32_REV(Reg m, Reg d, Reg m2) {
+        if (m != m2 || d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        return thumb16_REV(m, d);
+    }
+
+    bool thumb32_REV16(Reg m, Reg d, Reg m2) {
+        if (m != m2 || d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        return thumb16_REV16(m, d);
+    }
+
+    bool thumb32_REVSH(Reg m, Reg d, Reg m2) {
+        if (m != m2 || d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        return thumb16_REVSH(m, d);
+    }
+
+    bool thumb32_RBIT(Reg m, Reg d, Reg m2) {
+        if (m != m2 || d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // RBIT <Rd>, <Rm>
+        ir.SetRegister(d, ir.BitReverseWord(ir.GetRegister(m)));
+        return true;
+    }
+
+    bool thumb32_CLZ(Reg m, Reg d, Reg m2) {
+        if (m != m2 || d == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // CLZ <Rd>, <Rm>
+        ir.SetRegister(d, ir.CountLeadingZeros(ir.GetRegister(m)));
+        return true;
+    }
+
+    bool thumb32_MUL(Reg n, Reg d, Reg m) {
+        if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // MUL <Rd>, <Rn>, <Rm>
+        ir.SetRegister(d, ir.Mul(ir.GetRegister(n), ir.GetRegister(m)));
+        return true;
+    }
+
+    bool thumb32_MLA(Reg n, Reg a, Reg d, Reg m) {
+        if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // MLA <Rd>, <Rn>, <Rm>, <Ra>
+        auto result = ir.Add(ir.Mul(ir.GetRegister(n), ir.GetRegister(m)), ir.GetRegister(a));
+        ir.SetRegister(d, result);
+        return true;
+    }
+
+    bool thumb32_MLS(Reg n, Reg a, Reg d, Reg m) {
+        if (d == Reg::PC || n == Reg::PC || m == Reg::PC || a == Reg::PC)
+            return UnpredictableInstruction();
+        // MLS <Rd>, <Rn>, <Rm>, <Ra>
+        auto result = ir.Sub(ir.GetRegister(a), ir.Mul(ir.GetRegister(n), ir.GetRegister(m)));
+        ir.SetRegister(d, result);
+        return true;
+    }
+
+    bool thumb32_SMULL(Reg n, Reg dLo, Reg dHi, Reg m) {
+        if (dLo == Reg::PC || dHi == Reg::PC || n == Reg::PC || m == Reg::PC || dLo == dHi)
+            return UnpredictableInstruction();
+        // SMULL <RdLo>, <RdHi>, <Rn>, <Rm>
+        auto n64 = ir.SignExtendWordToLong(ir.GetRegister(n));
+        auto m64 = ir.SignExtendWordToLong(ir.GetRegister(m));
+        auto result = ir.Mul64(n64, m64);
+        ir.SetRegister(dLo, ir.LeastSignificantWord(result));
+        ir.SetRegister(dHi, ir.MostSignificantWord(result).result);
+        return true;
+    }
+
+    bool thumb32_UMULL(Reg n, Reg dLo, Reg dHi, Reg m) {
+        if (dLo == Reg::PC || dHi == Reg::PC || n == Reg::PC || m == Reg::PC || dLo == dHi)
+            return UnpredictableInstruction();
+        // UMULL <RdLo>, <RdHi>, <Rn>, <Rm>
+        auto n64 = ir.ZeroExtendWordToLong(ir.GetRegister(n));
+        auto m64 = ir.ZeroExtendWordToLong(ir.GetRegister(m));
+        auto result = ir.Mul64(n64, m64);
+        ir.SetRegister(dLo, ir.LeastSignificantWord(result));
+        ir.SetRegister(dHi, ir.MostSignificantWord(result).result);
+        return true;
+    }
+
+    bool thumb32_SMLAL(Reg n, Reg dLo, Reg dHi, Reg m) {
+        if (dLo == Reg::PC || dHi == Reg::PC || n == Reg::PC || m == Reg::PC || dLo == dHi)
+            return UnpredictableInstruction();
+        // SMLAL <RdLo>, <RdHi>, <Rn>, <Rm>
+        auto addend = ir.Pack2x32To1x64(ir.GetRegister(dLo), ir.GetRegister(dHi));
+        auto n64 = ir.SignExtendWordToLong(ir.GetRegister(n));
+        auto m64 = ir.SignExtendWordToLong(ir.GetRegister(m));
+        auto result = ir.Add64(ir.Mul64(n64, m64), addend);
+        ir.SetRegister(dLo, ir.LeastSignificantWord(result));
+        ir.SetRegister(dHi, ir.MostSignificantWord(result).result);
+        return true;
+    }
+
+    bool thumb32_UMLAL(Reg n, Reg dLo, Reg dHi, Reg m) {
+        if (dLo == Reg::PC || dHi == Reg::PC || n == Reg::PC || m == Reg::PC || dLo == dHi)
+            return UnpredictableInstruction();
+        // UMLAL <RdLo>, <RdHi>, <Rn>, <Rm>
+        auto addend = ir.Pack2x32To1x64(ir.GetRegister(dLo), ir.GetRegister(dHi));
+        auto n64 = ir.ZeroExtendWordToLong(ir.GetRegister(n));
+        auto m64 = ir.ZeroExtendWordToLong(ir.GetRegister(m));
+        auto result = ir.Add64(ir.Mul64(n64, m64), addend);
+        ir.SetRegister(dLo, ir.LeastSignificantWord(result));
+        ir.SetRegister(dHi, ir.MostSignificantWord(result).result);
+        return true;
+    }
+
+    bool thumb32_SDIV(Reg n, Reg d, Reg m) {
+        if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // SDIV <Rd>, <Rn>, <Rm>
+        ir.SetRegister(d, ir.SignedDiv(ir.GetRegister(n), ir.GetRegister(m)));
+        return true;
+    }
+
+    bool thumb32_UDIV(Reg n, Reg d, Reg m) {
+        if (d == Reg::PC || n == Reg::PC || m == Reg::PC)
+            return UnpredictableInstruction();
+        // UDIV <Rd>, <Rn>, <Rm>
+        ir.SetRegister(d, ir.UnsignedDiv(ir.GetRegister(n), ir.GetRegister(m)));
+        return true;
+    }
+
+    bool thumb32_LDR_lit(bool U, Reg t, Imm12 imm12) {
+        // LDR.W <Rt>, <label>
+        return LoadLiteral(32, false, U, t, imm12);
+    }
+
+    bool thumb32_LDR_imm12(Reg n, Reg t, Imm12 imm12) {
+        // LDR.W <Rt>, [<Rn>, #<imm12>]
+        return LoadImm12(32, false, n, t, imm12);
+    }
+
+    bool thumb32_LDR_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // LDR <Rt>, [<Rn>, #-<imm8>]
+        // LDR <Rt>, [<Rn>], #+/-<imm8>
+        // LDR <Rt>, [<Rn>, #+/-<imm8>]!
+        return LoadImm8(32, false, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_LDR_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // LDR.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return LoadReg(32, false, n, t, imm2, m);
+    }
+
+    bool thumb32_LDRB_lit(bool U, Reg t, Imm12 imm12) {
+        // LDRB.W <Rt>, <label>
+        return LoadLiteral(8, false, U, t, imm12);
+    }
+
+    bool thumb32_LDRB_imm12(Reg n, Reg t, Imm12 imm12) {
+        // LDRB.W <Rt>, [<Rn>, #<imm12>]
+        return LoadImm12(8, false, n, t, imm12);
+    }
+
+    bool thumb32_LDRB_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // LDRB <Rt>, [<Rn>, #-<imm8>]
+        // LDRB <Rt>, [<Rn>], #+/-<imm8>
+        // LDRB <Rt>, [<Rn>, #+/-<imm8>]!
+        return LoadImm8(8, false, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_LDRB_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // LDRB.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return LoadReg(8, false, n, t, imm2, m);
+    }
+
+    bool thumb32_LDRH_lit(bool U, Reg t, Imm12 imm12) {
+        // LDRH.W <Rt>, <label>
+        return LoadLiteral(16, false, U, t, imm12);
+    }
+
+    bool thumb32_LDRH_imm12(Reg n, Reg t, Imm12 imm12) {
+        // LDRH.W <Rt>, [<Rn>, #<imm12>]
+        return LoadImm12(16, false, n, t, imm12);
+    }
+
+    bool thumb32_LDRH_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // LDRH <Rt>, [<Rn>, #-<imm8>]
+        // LDRH <Rt>, [<Rn>], #+/-<imm8>
+        // LDRH <Rt>, [<Rn>, #+/-<imm8>]!
+        return LoadImm8(16, false, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_LDRH_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // LDRH.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return LoadReg(16, false, n, t, imm2, m);
+    }
+
+    bool thumb32_LDRSB_lit(bool U, Reg t, Imm12 imm12) {
+        // LDRSB.W <Rt>, <label>
+        return LoadLiteral(8, true, U, t, imm12);
+    }
+
+    bool thumb32_LDRSB_imm12(Reg n, Reg t, Imm12 imm12) {
+        // LDRSB.W <Rt>, [<Rn>, #<imm12>]
+        return LoadImm12(8, true, n, t, imm12);
+    }
+
+    bool thumb32_LDRSB_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // LDRSB <Rt>, [<Rn>, #-<imm8>]
+        // LDRSB <Rt>, [<Rn>], #+/-<imm8>
+        // LDRSB <Rt>, [<Rn>, #+/-<imm8>]!
+        return LoadImm8(8, true, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_LDRSB_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // LDRSB.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return LoadReg(8, true, n, t, imm2, m);
+    }
+
+    bool thumb32_LDRSH_lit(bool U, Reg t, Imm12 imm12) {
+        // LDRSH.W <Rt>, <label>
+        return LoadLiteral(16, true, U, t, imm12);
+    }
+
+    bool thumb32_LDRSH_imm12(Reg n, Reg t, Imm12 imm12) {
+        // LDRSH.W <Rt>, [<Rn>, #<imm12>]
+        return LoadImm12(16, true, n, t, imm12);
+    }
+
+    bool thumb32_LDRSH_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // LDRSH <Rt>, [<Rn>, #-<imm8>]
+        // LDRSH <Rt>, [<Rn>], #+/-<imm8>
+        // LDRSH <Rt>, [<Rn>, #+/-<imm8>]!
+        return LoadImm8(16, true, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_LDRSH_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // LDRSH.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return LoadReg(16, true, n, t, imm2, m);
+    }
+
+    bool thumb32_STR_imm12(Reg n, Reg t, Imm12 imm12) {
+        // STR.W <Rt>, [<Rn>, #<imm12>]
+        return StoreImm12(32, n, t, imm12);
+    }
+
+    bool thumb32_STR_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // STR <Rt>, [<Rn>, #-<imm8>]
+        // STR <Rt>, [<Rn>], #+/-<imm8>
+        // STR <Rt>, [<Rn>, #+/-<imm8>]!
+        return StoreImm8(32, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_STR_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // STR.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return StoreReg(32, n, t, imm2, m);
+    }
+
+    bool thumb32_STRB_imm12(Reg n, Reg t, Imm12 imm12) {
+        // STRB.W <Rt>, [<Rn>, #<imm12>]
+        return StoreImm12(8, n, t, imm12);
+    }
+
+    bool thumb32_STRB_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // STRB <Rt>, [<Rn>, #-<imm8>]
+        // STRB <Rt>, [<Rn>], #+/-<imm8>
+        // STRB <Rt>, [<Rn>, #+/-<imm8>]!
+        return StoreImm8(8, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_STRB_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // STRB.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return StoreReg(8, n, t, imm2, m);
+    }
+
+    bool thumb32_STRH_imm12(Reg n, Reg t, Imm12 imm12) {
+        // STRH.W <Rt>, [<Rn>, #<imm12>]
+        return StoreImm12(16, n, t, imm12);
+    }
+
+    bool thumb32_STRH_imm8(Reg n, Reg t, bool P, bool U, bool W, Imm8 imm8) {
+        // STRH <Rt>, [<Rn>, #-<imm8>]
+        // STRH <Rt>, [<Rn>], #+/-<imm8>
+        // STRH <Rt>, [<Rn>, #+/-<imm8>]!
+        return StoreImm8(16, n, t, P, U, W, imm8);
+    }
+
+    bool thumb32_STRH_reg(Reg n, Reg t, Imm2 imm2, Reg m) {
+        // STRH.W <Rt>, [<Rn>, <Rm>{, LSL #<imm2>}]
+        return StoreReg(16, n, t, imm2, m);
+    }
+
+
+    bool thumb32_TBB(Reg n, Reg m) {
+        if (m == Reg::SP || m == Reg::PC)
+            return UnpredictableInstruction();
+        // TBB [<Rn>, <Rm>]
+        auto halfwords = ir.ZeroExtendByteToWord(ir.ReadMemory8(ir.Add(ir.GetRegister(n), ir.GetRegister(m))));
+        auto offset = ir.LogicalShiftLeft(halfwords, ir.Imm8(1), ir.Imm1(false)).result;
+        ir.BranchWritePC(ir.Add(ir.Imm32(ir.PC()), offset));
+        ir.SetTerm(IR::Term::ReturnToDispatch{});
+        return false;
+    }
+
+    bool thumb32_TBH(Reg n, Reg m) {
+        if (m == Reg::SP || m == Reg::PC)
+            return UnpredictableInstruction();
+        // TBH [<Rn>, <Rm>, LSL #1]
+        auto index = ir.LogicalShiftLeft(ir.GetRegister(m), ir.Imm8(1), ir.Imm1(false)).result;
+        auto halfwords = ir.ZeroExtendHalfToWord(ir.ReadMemory16(ir.Add(ir.GetRegister(n), index)));
+        auto offset = ir.LogicalShiftLeft(halfwords, ir.Imm8(1), ir.Imm1(false)).result;
+        ir.BranchWritePC(ir.Add(ir.Imm32(ir.PC()), offset));
+        ir.SetTerm(IR::Term::ReturnToDispatch{});
+        return false;
+    }
+
+    bool thumb32_LDRD_imm(bool P, bool U, bool W, Reg n, Reg t, Reg t2, Imm8 imm8) {
+        u32 imm32 = imm8 << 2;
+        if (!P && !W)
+            return thumb32_UDF(); // Load/store exclusive
+        if (t == Reg::PC || t2 == Reg::PC || t == t2 || (W && (n == t || n == t2 || n == Reg::PC)))
+            return UnpredictableInstruction();
+        // LDRD <Rt>, <Rt2>, [<Rn>{, #+/-<imm>}]
+        // LDRD <Rt>, <Rt2>, [<Rn>], #+/-<imm>
+        // LDRD <Rt>, <Rt2>, [<Rn>, #+/-<imm>]!
+        IR::Value address;
+        if (n == Reg::PC) {
+            address = ir.Imm32(U ? ir.AlignPC(4) + imm32 : ir.AlignPC(4) - imm32);
+        } else {
+            address = GetAddressingMode(P, U, W, n, ir.Imm32(imm32));
+        }
+        ir.SetRegister(t, ir.ReadMemory32(address));
+        ir.SetRegister(t2, ir.ReadMemory32(ir.Add(address, ir.Imm32(4))));
+        return true;
+    }
+
+    bool thumb32_STRD_imm(bool P, bool U, bool W, Reg n, Reg t, Reg t2, Imm8 imm8) {
+        u32 imm32 = imm8 << 2;
+        if (!P && !W)
+            return thumb32_UDF(); // Load/store exclusive
+        if (n == Reg::PC || t == Reg::PC || t2 == Reg::PC || (W && (n == t || n == t2)))
+            return UnpredictableInstruction();
+        // STRD <Rt>, <Rt2>, [<Rn>{, #+/-<imm>}]
+        // STRD <Rt>, <Rt2>, [<Rn>], #+/-<imm>
+        // STRD <Rt>, <Rt2>, [<Rn>, #+/-<imm>]!
+        auto data = ir.GetRegister(t);
+        auto data2 = ir.GetRegister(t2);
+        auto address = GetAddressingMode(P, U, W, n, ir.Imm32(imm32));
+        ir.WriteMemory32(address, data);
+        ir.WriteMemory32(ir.Add(address, ir.Imm32(4)), data2);
+        return true;
+    }
+
+    bool LDMHelper(bool W, Reg n, RegList list, IR::Value start_address, IR::Value writeback_address) {
+        const RegList list_without_pc = list & 0x7FFF;
+        if (list_without_pc != 0) {
+            ir.ReadMemoryToRegisters(start_address, list_without_pc);
+        }
+        if (W && !Common::Bit(RegNumber(n), list)) {
+            ir.SetRegister(n, writeback_address);
+        }
+        if (Common::Bit<15>(list)) {
+            auto address = ir.Add(start_address, ir.Imm32(u32(Common::BitCount(list_without_pc) * 4)));
+            return LoadRegister(Reg::PC, ir.ReadMemory32(address), n == Reg::SP);
+        }
+        return true;
+    }
+
+    bool STMHelper(bool W, Reg n, RegList list, IR::Value start_address, IR::Value writeback_address) {
+        ir.WriteMemoryFromRegisters(start_address, list);
+        if (W) {
+            ir.SetRegister(n, writeback_address);
+        }
+        return true;
+    }
+
+    bool thumb32_LDM(bool W, Reg n, RegList list) {
+        if (n == Reg::PC || Common::BitCount(list) < 2 || Common::Bit<13>(list) || (Common::Bit<14>(list) && Common::Bit<15>(list)))
+            return UnpredictableInstruction();
+        // LDM.W <Rn>{!}, <reg_list>
+        auto start_address = ir.GetRegister(n);
+        auto writeback_address = ir.Add(start_address, ir.Imm32(u32(Common::BitCount(list) * 4)));
+        return LDMHelper(W, n, list, start_address, writeback_address);
+    }
+
+    bool thumb32_LDMDB(bool W, Reg n, RegList list) {
+        if (n == Reg::PC || Common::BitCount(list) < 2 || Common::Bit<13>(list) || (Common::Bit<14>(list) && Common::Bit<15>(list)))
+            return UnpredictableInstruction();
+        // LDMDB <Rn>{!}, <reg_list>
+        auto start_address = ir.Sub(ir.GetRegister(n), ir.Imm32(u32(Common::BitCount(list) * 4)));
+        return LDMHelper(W, n, list, start_address, start_address);
+    }
+
+    bool thumb32_STM(bool W, Reg n, RegList list) {
+        if (n == Reg::PC || Common::BitCount(list) < 2 || Common::Bit<13>(list) || Common::Bit<15>(list))
+            return UnpredictableInstruction();
+        // STM.W <Rn>{!}, <reg_list>
+        auto start_address = ir.GetRegister(n);
+        auto writeback_address = ir.Add(start_address, ir.Imm32(u32(Common::BitCount(list) * 4)));
+        return STMHelper(W, n, list, start_address, writeback_address);
+    }
+
+    bool thumb32_STMDB(bool W, Reg n, RegList list) {
+        if (n == Reg::PC || Common::BitCount(list) < 2 || Common::Bit<13>(list) || Common::Bit<15>(list))
+            return UnpredictableInstruction();
+        // STMDB <Rn>{!}, <reg_list>
+        auto start_address = ir.Sub(ir.GetRegister(n), ir.Imm32(u32(Common::BitCount(list) * 4)));
+        return STMHelper(W, n, list, start_address, start_address);
+    }
+
+    // As in ARM state, the data barriers are full barriers and an ISB ends the block.
+    bool thumb32_DMB(Imm4 /*option*/) {
+        // DMB #<option>
+        ir.DataMemoryBarrier();
+        return true;
+    }
+
+    bool thumb32_DSB(Imm4 /*option*/) {
+        // DSB #<option>
+        ir.DataMemoryBarrier();
+        return true;
+    }
+
+    bool thumb32_ISB(Imm4 /*option*/) {
+        // ISB #<option>
+        if (InITBlock())
+            return true;
+        ir.BranchWritePC(ir.Imm32(ir.current_location.PC() + 4));
+        ir.SetTerm(IR::Term::ReturnToDispatch{});
+        return false;
+    }
+
+    bool thumb32_NOP() {
+        // NOP.W
+        return true;
+    }
+
+    bool thumb32_B_t3(bool S, Cond cond, Imm6 imm6, bool j1, bool j2, Imm11 imm11) {
+        if (cond == Cond::AL || cond == Cond::NV)
+            return thumb32_UDF(); // Miscellaneous control instructions
+        u32 imm21 = (static_cast<u32>(S) << 20) | (static_cast<u32>(j2) << 19) | (static_cast<u32>(j1) << 18) | (imm6 << 12) | (imm11 << 1);
+        s32 imm32 = Common::SignExtend<21, s32>(imm21) + 4;
+        // B<cond>.W <label>
+        auto then_location = ir.current_location.AdvancePC(imm32).AdvanceIT();
+        auto else_location = ir.current_location.AdvancePC(4).AdvanceIT();
+        ir.SetTerm(IR::Term::If{cond, IR::Term::LinkBlock{then_location}, IR::Term::LinkBlock{else_location}});
+        return false;
+    }
+
+    bool thumb32_B_t4(bool S, Imm10 imm10, bool j1, bool j2, Imm11 imm11) {
+        const bool i1 = j1 == S;
+        const bool i2 = j2 == S;
+        u32 imm25 = (static_cast<u32>(S) << 24) | (static_cast<u32>(i1) << 23) | (static_cast<u32>(i2) << 22) | (imm10 << 12) | (imm11 << 1);
+        s32 imm32 = Common::SignExtend<25, s32>(imm25) + 4;
+        // B.W <label>
+        auto next_location = ir.current_location.AdvancePC(imm32).AdvanceIT();
+        if (FollowBranch(next_location, 4))
+            return true;
+        ir.SetTerm(IR::Term::LinkBlock{next_location});
+        return false;
+    }
+
+    bool thumb32_BL_imm(Imm11 hi, Imm11 lo) {
+        s32 imm32 = Common::SignExtend<23, s32>((hi << 12) | (lo << 1)) + 4;
+        // BL <label>
+        ir.PushRSB(ir.current_location.AdvancePC(4).AdvanceIT());
+        ir.SetRegister(Reg::LR, ir.Imm32((ir.current_location.PC() + 4) | 1));
+        auto new_location = ir.current_location.AdvancePC(imm32).AdvanceIT();
+        ProfileCall(ir.Imm32(new_location.PC()), ir.current_location.PC() + 4);
+        if (FollowBranch(new_location, 4))
+            return true;
+        ir.SetTerm(IR::Term::LinkBlock{new_location});
+        return false;
+    }
+
+    bool thumb32_BLX_imm(Imm11 hi, Imm11 lo) {
+        s32 imm32 = Common::SignExtend<23, s32>((hi << 12) | (lo << 1));
+        if ((lo & 1) != 0) {
+            return UnpredictableInstruction();
+        }
+        // BLX <label>
+        ir.PushRSB(ir.current_location.AdvancePC(4).AdvanceIT());
+        ir.SetRegister(Reg::LR, ir.Imm32((ir.current_location.PC() + 4) | 1));
+        auto new_location = ir.current_location
+                              .SetPC(ir.AlignPC(4) + imm32)
+                              .SetTFlag(false)
+                              .AdvanceIT();
+        ProfileCall(ir.Imm32(new_location.PC()), ir.current_location.PC() + 4);
+        ir.SetTerm(IR::Term::LinkBlock{new_location});
+        return false;
+    }
+
+    bool thumb32_UDF() {
+        return thumb16_UDF();
+    }
+};
+
+enum class ThumbInstSize {
+    Thumb16, Thumb32
+};
+
+std::tuple<u32, ThumbInstSize> ReadThumbInstruction(u32 arm_pc, CodeReader& code_reader) {
+    u32 first_part = code_reader.ReadWord(arm_pc & 0xFFFFFFFC);
+    if ((arm_pc & 0x2) != 0)
+        first_part >>= 16;
+    first_part &= 0xFFFF;
+
+    if ((first_part & 0xF800) < 0xE800) {
+        // 16-bit thumb instruction
+        return std::make_tuple(first_part, ThumbInstSize::Thumb16);
+    }
+
+    // 32-bit thumb instruction
+    // These always start with 0b11101, 0b11110 or 0b11111.
+
+    u32 second_part = code_reader.ReadWord((arm_pc + 2) & 0xFFFFFFFC);
+    if (((arm_pc + 2) & 0x2) != 0)
+        second_part >>= 16;
+    second_part &= 0xFFFF;
 
     return std::make_tuple(static_cast<u32>((first_part << 16) | second_part), ThumbInstSize::Thumb32);
 }
 
 } // local namespace
 
-IR::Block TranslateThumb(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code) {
-    ThumbTranslatorVisitor visitor{descriptor};
+IR::Block TranslateThumb(IR::LocationDescriptor descriptor, MemoryReadCodeFuncType memory_read_code, const TranslationOptions& options) {
+    ThumbTranslatorVisitor visitor{descriptor, options};
+    CodeReader code_reader{memory_read_code, options.memory_get_code_page};
 
     bool should_continue = true;
     while (should_continue) {
         const u32 arm_pc = visitor.ir.current_location.PC();
 
+        // A breakpoint starts a block of its own, so that execution can stop before it.
+        if (visitor.instruction_count != 0 && options.is_breakpoint && options.is_breakpoint(arm_pc)) {
+            visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+            break;
+        }
+
         u32 thumb_instruction;
         ThumbInstSize inst_size;
-        std::tie(thumb_instruction, inst_size) = ReadThumbInstruction(arm_pc, memory_read_code);
-
-        if (inst_size == ThumbInstSize::Thumb16) {
-            auto decoder = DecodeThumb16<ThumbTranslatorVisitor>(static_cast<u16>(thumb_instruction));
-            if (decoder) {
-                should_continue = decoder->call(visitor, static_cast<u16>(thumb_instruction));
-            } else {
-                should_continue = visitor.thumb16_UDF();
+        std::tie(thumb_instruction, inst_size) = ReadThumbInstruction(arm_pc, code_reader);
+        const s32 advance_pc = (inst_size == ThumbInstSize::Thumb16) ? 2 : 4;
+
+        const auto translate_instruction = [&]{
+            if (inst_size == ThumbInstSize::Thumb16) {
+                auto decoder = DecodeThumb16<ThumbTranslatorVisitor>(static_cast<u16>(thumb_instruction));
+                if (decoder) {
+                    return decoder->call(visitor, static_cast<u16>(thumb_instruction));
+                }
+                return visitor.thumb16_UDF();
             }
-        } else {
             auto decoder = DecodeThumb32<ThumbTranslatorVisitor>(thumb_instruction);
             if (decoder) {
-                should_continue = decoder->call(visitor, thumb_instruction);
-            } else {
-                should_continue = visitor.thumb32_UDF();
+                return decoder->call(visitor, thumb_instruction);
             }
+            return visitor.thumb32_UDF();
+        };
+
+        // Instructions of an IT block that only write registers and flags are predicated inline.
+        // Anything else is predicated with the condition of its block, so has to start a block.
+        bool end_after_instruction = false;
+        const ITState it = visitor.ir.current_location.IT();
+        if (!it.IsInITBlock() || it.Condition() == Cond::AL) {
+            should_continue = translate_instruction();
+        } else if (!visitor.TranslateWithSelects(it.Condition(), translate_instruction, should_continue)) {
+            if (visitor.instruction_count != 0) {
+                visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+                break;
+            }
+            visitor.ir.block.SetCondition(it.Condition());
+            visitor.ir.block.SetConditionFailedLocation(visitor.ir.current_location.AdvancePC(advance_pc).AdvanceIT());
+            visitor.ir.block.ConditionFailedCycleCount() = 1;
+            should_continue = translate_instruction();
+            end_after_instruction = should_continue && !visitor.branch_target;
         }
 
-        s32 advance_pc = (inst_size == ThumbInstSize::Thumb16) ? 2 : 4;
-        visitor.ir.current_location = visitor.ir.current_location.AdvancePC(advance_pc);
-        visitor.ir.block.CycleCount()++;
+        if (visitor.branch_target) {
+            visitor.ir.block.AppendGuestRange(visitor.range_start, arm_pc + advance_pc);
+            visitor.ir.current_location = *visitor.branch_target;
+            visitor.range_start = visitor.ir.current_location.PC();
+            visitor.branch_target = boost::none;
+        } else if (visitor.next_it_state) {
+            visitor.ir.current_location = visitor.ir.current_location.AdvancePC(advance_pc).SetIT(*visitor.next_it_state);
+            visitor.next_it_state = boost::none;
+        } else {
+            visitor.ir.current_location = visitor.ir.current_location.AdvancePC(advance_pc).AdvanceIT();
+        }
+        visitor.ir.block.CycleCount() += InstructionCycles(visitor.ir.block, arm_pc, thumb_instruction, options);
+        visitor.instruction_count++;
+
+        if (end_after_instruction) {
+            visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+            should_continue = false;
+        }
+
+        if (should_continue && options.max_block_instructions != 0 && visitor.instruction_count >= options.max_block_instructions) {
+            visitor.ir.SetTerm(IR::Term::LinkBlock{visitor.ir.current_location});
+            break;
+        }
     }
 
+    visitor.ir.block.AppendGuestRange(visitor.range_start, visitor.ir.current_location.PC());
+
     return std::move(visitor.ir.block);
 }
 
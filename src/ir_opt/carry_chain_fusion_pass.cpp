@@ -0,0 +1,149 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <unordered_set>
+#include <vector>
+
+#include "frontend/arm/types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+static IR::Value SkipIdentities(IR::Value value) {
+    while (!value.IsImmediate() && value.GetInst()->GetOpcode() == IR::Opcode::Identity) {
+        value = value.GetInst()->GetArg(0);
+    }
+    return value;
+}
+
+static bool IsPseudoOperationOf(const IR::Inst& inst, const IR::Inst& of) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::GetCarryFromOp:
+    case IR::Opcode::GetOverflowFromOp:
+    case IR::Opcode::GetGEFromOp:
+        return inst.GetArg(0).GetInst() == &of;
+    default:
+        return false;
+    }
+}
+
+/// Whether inst may change guest core registers other than through SetRegister.
+static bool MayChangeCoreRegisters(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::BXWritePC:
+    case IR::Opcode::ReadMemoryToRegisters:
+    case IR::Opcode::SetCpsrAndSwitchMode:
+        return true;
+    default:
+        return inst.CausesCPUException() || inst.IsCoprocessorInstruction();
+    }
+}
+
+/**
+ * Finds the pairs of AddWithCarry (or SubWithCarry) in which the second takes its carry in from the
+ * first, as in 64-bit arithmetic done with `adds r0, r0, r2; adc r1, r1, r3`, and moves the second to
+ * directly after the first. The backend then emits the pair as one `add; adc` (or `sub; sbb`), with
+ * the carry passed in the host carry flag rather than materialized and tested again. The carry is
+ * only stored if something else, such as the guest C flag, still uses it.
+ *
+ * The second operation is only moved if its operands are available before the first: they must be
+ * immediates, values defined before it, or guest register reads that can be hoisted above it.
+ * Run after GetSetElimination, which forwards the carry from the first to the second.
+ */
+void CarryChainFusion(IR::Block& block) {
+    for (auto iter = block.begin(); iter != block.end(); ++iter) {
+        IR::Inst& first = *iter;
+        if (first.GetOpcode() != IR::Opcode::AddWithCarry && first.GetOpcode() != IR::Opcode::SubWithCarry)
+            continue;
+        IR::Inst* const carry = first.GetAssociatedPseudoOperation(IR::Opcode::GetCarryFromOp);
+        if (!carry)
+            continue;
+
+        auto after_first = std::next(iter);
+        while (after_first != block.end() && IsPseudoOperationOf(*after_first, first))
+            ++after_first;
+
+        // Instructions from there to the second operation, and which of them are register reads that can be hoisted.
+        IR::Inst* second = nullptr;
+        std::unordered_set<const IR::Inst*> between;
+        std::unordered_set<const IR::Inst*> hoistable;
+        std::array<bool, 16> written{};
+        bool registers_changed = false;
+        for (auto scan = after_first; scan != block.end(); ++scan) {
+            const IR::Value carry_in = scan->GetOpcode() == first.GetOpcode() ? SkipIdentities(scan->GetArg(2)) : IR::Value{};
+            if (!carry_in.IsEmpty() && !carry_in.IsImmediate() && carry_in.GetInst() == carry) {
+                second = &*scan;
+                break;
+            }
+
+            if (scan->GetOpcode() == IR::Opcode::GetRegister) {
+                if (!registers_changed && !written[Arm::RegNumber(scan->GetArg(0).GetRegRef())]) {
+                    hoistable.insert(&*scan);
+                }
+            } else if (scan->GetOpcode() == IR::Opcode::SetRegister) {
+                written[Arm::RegNumber(scan->GetArg(0).GetRegRef())] = true;
+            } else if (MayChangeCoreRegisters(*scan)) {
+                registers_changed = true;
+            }
+            between.insert(&*scan);
+        }
+        if (!second)
+            continue;
+
+        std::vector<IR::Inst*> to_hoist;
+        bool can_move = true;
+        for (size_t i = 0; i < 2 && can_move; i++) {
+            const IR::Value arg = SkipIdentities(second->GetArg(i));
+            if (arg.IsImmediate())
+                continue;
+
+            IR::Inst* const def = arg.GetInst();
+            if (def == &first || IsPseudoOperationOf(*def, first)) {
+                can_move = false;
+            } else if (between.count(def) != 0) {
+                if (hoistable.count(def) != 0) {
+                    if (std::find(to_hoist.begin(), to_hoist.end(), def) == to_hoist.end()) {
+                        to_hoist.push_back(def);
+                    }
+                } else {
+                    can_move = false;
+                }
+            }
+        }
+        if (!can_move)
+            continue;
+
+        for (size_t i = 0; i < 3; i++) {
+            const IR::Value arg = second->GetArg(i);
+            if (!arg.IsImmediate() && arg.GetInst()->GetOpcode() == IR::Opcode::Identity) {
+                second->SetArg(i, SkipIdentities(arg));
+            }
+        }
+        for (IR::Inst* def : to_hoist) {
+            block.Instructions().remove(def);
+            block.Instructions().insert(iter, def);
+        }
+
+        after_first = std::next(iter);
+        while (after_first != block.end() && IsPseudoOperationOf(*after_first, first))
+            ++after_first;
+        if (&*after_first != second) {
+            block.Instructions().remove(second);
+            block.Instructions().insert(after_first, second);
+        }
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -0,0 +1,139 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <vector>
+
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+namespace {
+
+constexpr std::array<IR::Opcode, 3> pseudo_operations {{
+    IR::Opcode::GetCarryFromOp,
+    IR::Opcode::GetOverflowFromOp,
+    IR::Opcode::GetGEFromOp,
+}};
+
+IR::Inst* SkipIdentities(IR::Inst* inst) {
+    while (inst->GetOpcode() == IR::Opcode::Identity && !inst->GetArg(0).IsImmediate()) {
+        inst = inst->GetArg(0).GetInst();
+    }
+    return inst;
+}
+
+bool AreValuesEqual(const IR::Value& a, const IR::Value& b) {
+    if (a.IsImmediate() != b.IsImmediate())
+        return false;
+    if (!a.IsImmediate())
+        return SkipIdentities(a.GetInst()) == SkipIdentities(b.GetInst());
+    if (a.GetType() != b.GetType())
+        return false;
+
+    switch (a.GetType()) {
+    case IR::Type::RegRef:
+        return a.GetRegRef() == b.GetRegRef();
+    case IR::Type::ExtRegRef:
+        return a.GetExtRegRef() == b.GetExtRegRef();
+    case IR::Type::U1:
+        return a.GetU1() == b.GetU1();
+    case IR::Type::U8:
+        return a.GetU8() == b.GetU8();
+    case IR::Type::U16:
+        return a.GetU16() == b.GetU16();
+    case IR::Type::U32:
+        return a.GetU32() == b.GetU32();
+    case IR::Type::U64:
+        return a.GetU64() == b.GetU64();
+    case IR::Type::CoprocInfo:
+        return a.GetCoprocInfo() == b.GetCoprocInfo();
+    default:
+        return false;
+    }
+}
+
+bool AreArgsEqual(const IR::Inst& a, const IR::Inst& b) {
+    DEBUG_ASSERT(a.GetOpcode() == b.GetOpcode());
+    for (size_t i = 0; i < a.NumArgs(); i++) {
+        if (!AreValuesEqual(a.GetArg(i), b.GetArg(i)))
+            return false;
+    }
+    return true;
+}
+
+/// Whether the result of inst depends only on its arguments, so another instruction with the same arguments computes the same value.
+bool IsPure(const IR::Inst& inst) {
+    const IR::Opcode opcode = inst.GetOpcode();
+    if (opcode == IR::Opcode::Identity || IR::GetTypeOf(opcode) == IR::Type::Void)
+        return false;
+    if (std::find(pseudo_operations.begin(), pseudo_operations.end(), opcode) != pseudo_operations.end())
+        return false;
+
+    return !inst.MayHaveSideEffects()
+           && !inst.ReadsFromCoreRegister()
+           && !inst.ReadsFromCPSR()
+           && !inst.ReadsFromSPSR()
+           && !inst.ReadsFromFPSCR()
+           && !inst.IsMemoryRead()
+           && !inst.IsCoprocessorInstruction();
+}
+
+/// Replaces the later instruction `duplicate` with `original`, moving or merging its pseudo-operations over too.
+void Merge(IR::Inst* original, IR::Inst* duplicate) {
+    for (IR::Opcode pseudo_operation : pseudo_operations) {
+        IR::Inst* duplicate_pseudo = duplicate->GetAssociatedPseudoOperation(pseudo_operation);
+        if (!duplicate_pseudo)
+            continue;
+
+        if (IR::Inst* original_pseudo = original->GetAssociatedPseudoOperation(pseudo_operation)) {
+            duplicate_pseudo->ReplaceUsesWith(IR::Value(original_pseudo));
+        } else {
+            duplicate_pseudo->SetArg(0, IR::Value(original));
+        }
+    }
+
+    duplicate->ReplaceUsesWith(IR::Value(original));
+}
+
+} // anonymous namespace
+
+/**
+ * Local value numbering: An instruction that computes the same pure function of the same arguments
+ * as an earlier instruction in the block is replaced by that earlier instruction.
+ * Memory reads are never pure, so nothing is merged across a memory write or a DataMemoryBarrier.
+ */
+void CommonSubexpressionElimination(IR::Block& block) {
+    std::map<IR::Opcode, std::vector<IR::Inst*>> available;
+
+    for (auto& inst : block) {
+        if (!IsPure(inst))
+            continue;
+
+        std::vector<IR::Inst*>& candidates = available[inst.GetOpcode()];
+        const auto original = std::find_if(candidates.begin(), candidates.end(), [&inst](IR::Inst* candidate) {
+            return AreArgsEqual(*candidate, inst);
+        });
+
+        if (original != candidates.end()) {
+            Merge(*original, &inst);
+        } else {
+            candidates.push_back(&inst);
+        }
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
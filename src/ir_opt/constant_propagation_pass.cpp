@@ -4,53 +4,447 @@
  * General Public License version 2 or any later version.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include <boost/optional.hpp>
+
 #include <dynarmic/callbacks.h>
+#include <dynarmic/coprocessor.h>
 
+#include "common/bit_util.h"
+#include "common/common_types.h"
 #include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
 #include "frontend/ir/opcodes.h"
+#include "frontend/ir/semantics.h"
+#include "frontend/ir/value.h"
 #include "ir_opt/passes.h"
 
 namespace Dynarmic {
 namespace Optimization {
 
-void ConstantPropagation(IR::Block& block, const UserCallbacks::Memory& memory_callbacks) {
+/// Determines whether every byte of the `size` byte access at `vaddr` is read-only memory.
+/// Device pages (see UserCallbacks::mmio_pages) never are, as reading them calls their handler.
+static bool IsReadOnlyMemory(const UserCallbacks& callbacks, u32 vaddr, size_t size) {
+    const u32 first_page = vaddr >> UserCallbacks::PAGE_BITS;
+    const u32 last_page = static_cast<u32>(vaddr + size - 1) >> UserCallbacks::PAGE_BITS;
+    if (callbacks.mmio_pages && ((*callbacks.mmio_pages)[first_page] || (*callbacks.mmio_pages)[last_page]))
+        return false;
+    if (callbacks.read_only_pages) {
+        return callbacks.read_only_pages->test(first_page) && callbacks.read_only_pages->test(last_page);
+    }
+    return callbacks.memory.IsReadOnlyMemory && callbacks.memory.IsReadOnlyMemory(vaddr);
+}
+
+/// The host page holding vaddr in UserCallbacks::page_table or UserCallbacks::page_directory, if mapped.
+/// Those only describe the first address space, so pages are not looked up when there are several.
+static const u8* GetHostPage(const UserCallbacks& callbacks, u32 vaddr) {
+    if (callbacks.address_space_count > 1)
+        return nullptr;
+    const u32 page = vaddr >> UserCallbacks::PAGE_BITS;
+    if (callbacks.page_table)
+        return (*callbacks.page_table)[page];
+    if (!callbacks.page_directory)
+        return nullptr;
+    const auto* second_level = (*callbacks.page_directory)[page / UserCallbacks::NUM_SECOND_LEVEL_PAGE_TABLE_ENTRIES];
+    return second_level ? (*second_level)[page % UserCallbacks::NUM_SECOND_LEVEL_PAGE_TABLE_ENTRIES] : nullptr;
+}
+
+/// Reads read-only memory at translation time, directly from the page table where possible.
+template <typename T>
+static T ReadReadOnlyMemory(const UserCallbacks& callbacks, u32 vaddr, T (*read_fn)(u32), T (*read_with_user_arg_fn)(void*, u32)) {
+    constexpr u32 page_mask = (1u << UserCallbacks::PAGE_BITS) - 1;
+    if (callbacks.read_only_pages && (vaddr & page_mask) <= page_mask + 1 - sizeof(T)) {
+        const u8* page = GetHostPage(callbacks, vaddr);
+        if (page) {
+            T value;
+            std::memcpy(&value, page + (vaddr & page_mask), sizeof(T));
+            return value;
+        }
+    }
+    if (read_with_user_arg_fn) {
+        return read_with_user_arg_fn(callbacks.user_arg, vaddr);
+    }
+    return read_fn(vaddr);
+}
+
+/// The value of the coprocessor register read by a CoprocGetOneWord with coproc_info, if the coprocessor declares it constant.
+static boost::optional<u32> GetConstantCoprocessorWord(const UserCallbacks& callbacks, const IR::Value& coproc_info_value) {
+    const auto coproc_info = coproc_info_value.GetCoprocInfo();
+    const std::shared_ptr<Coprocessor>& coproc = callbacks.coprocessors[coproc_info[0]];
+    if (!coproc)
+        return boost::none;
+
+    return coproc->GetConstantOneWord(coproc_info[1] != 0,
+                                      static_cast<unsigned>(coproc_info[2]),
+                                      static_cast<Arm::CoprocReg>(coproc_info[3]),
+                                      static_cast<Arm::CoprocReg>(coproc_info[4]),
+                                      static_cast<unsigned>(coproc_info[5]));
+}
+
+/// Replaces the uses of the pseudo-operation `opcode` associated with inst, if there is one, with `value`.
+static void ReplacePseudoOperation(IR::Inst& inst, IR::Opcode opcode, IR::Value value) {
+    if (IR::Inst* pseudo_operation = inst.GetAssociatedPseudoOperation(opcode)) {
+        pseudo_operation->ReplaceUsesWith(value);
+    }
+}
+
+/// Replaces inst with the immediate `result`, and its carry-out pseudo-operation with `carry`.
+static void ReplaceWithResultAndCarry(IR::Inst& inst, u32 result, IR::Value carry) {
+    ReplacePseudoOperation(inst, IR::Opcode::GetCarryFromOp, carry);
+    inst.ReplaceUsesWith(IR::Value{result});
+}
+
+/// Folds the 32-bit addition a + b + carry_in, including its carry and overflow pseudo-operations.
+static void FoldAddWithCarry(IR::Inst& inst, u32 a, u32 b, bool carry_in) {
+    const u64 sum = u64(a) + u64(b) + (carry_in ? 1 : 0);
+    const u32 result = static_cast<u32>(sum);
+    const bool carry = (sum >> 32) != 0;
+    const bool overflow = Common::Bit<31>(~(a ^ b) & (a ^ result));
+
+    ReplacePseudoOperation(inst, IR::Opcode::GetOverflowFromOp, IR::Value{overflow});
+    ReplaceWithResultAndCarry(inst, result, IR::Value{carry});
+}
+
+/// Folds a signed saturating operation whose exact result is `value`, including its overflow pseudo-operation.
+static void FoldSaturation(IR::Inst& inst, s64 value, s64 min, s64 max) {
+    const s64 result = std::max(min, std::min(value, max));
+    ReplacePseudoOperation(inst, IR::Opcode::GetOverflowFromOp, IR::Value{result != value});
+    inst.ReplaceUsesWith(IR::Value{static_cast<u32>(result)});
+}
+
+/// Replaces a packed operation with `packed`, and its GE pseudo-operation with its GE flags.
+static void FoldPacked(IR::Inst& inst, IR::Semantics::PackedResult packed) {
+    ReplacePseudoOperation(inst, IR::Opcode::GetGEFromOp, IR::Value{packed.ge});
+    inst.ReplaceUsesWith(IR::Value{packed.result});
+}
+
+/**
+ * Replaces instructions whose result can be computed at translation time with that result.
+ *
+ * Instructions are visited in program order and a folded instruction becomes an immediate, so every
+ * use of it is already visited with an immediate argument: a single pass reaches a fixed point.
+ */
+void ConstantPropagation(IR::Block& block, const UserCallbacks& callbacks) {
     for (auto& inst : block) {
+        // These only need some of their arguments to be immediates.
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::ConditionalSelect32:
+        case IR::Opcode::ConditionalSelect1:
+            if (inst.GetArg(0).IsImmediate()) {
+                inst.ReplaceUsesWith(inst.GetArg(0).GetU1() ? inst.GetArg(1) : inst.GetArg(2));
+            }
+            continue;
+        case IR::Opcode::LogicalShiftLeft:
+        case IR::Opcode::LogicalShiftRight:
+        case IR::Opcode::ArithmeticShiftRight:
+        case IR::Opcode::RotateRight: {
+            if (!inst.GetArg(1).IsImmediate())
+                continue;
+
+            const u8 shift = inst.GetArg(1).GetU8();
+            // Shifting by nothing leaves any value unchanged, as the carry-in is the carry-out. Neither need be an immediate.
+            if (shift == 0) {
+                ReplacePseudoOperation(inst, IR::Opcode::GetCarryFromOp, inst.GetArg(2));
+                inst.ReplaceUsesWith(inst.GetArg(0));
+                continue;
+            }
+
+            if (!inst.GetArg(0).IsImmediate())
+                continue;
+            const u32 value = inst.GetArg(0).GetU32();
+
+            const bool carry_in = false; // Only the carry-out of a shift by zero, handled above, depends on it.
+            IR::Semantics::ResultAndCarry shifted;
+            switch (inst.GetOpcode()) {
+            case IR::Opcode::LogicalShiftLeft:
+                shifted = IR::Semantics::LogicalShiftLeft(value, shift, carry_in);
+                break;
+            case IR::Opcode::LogicalShiftRight:
+                shifted = IR::Semantics::LogicalShiftRight(value, shift, carry_in);
+                break;
+            case IR::Opcode::ArithmeticShiftRight:
+                shifted = IR::Semantics::ArithmeticShiftRight(value, shift, carry_in);
+                break;
+            default:
+                shifted = IR::Semantics::RotateRight(value, shift, carry_in);
+                break;
+            }
+            ReplaceWithResultAndCarry(inst, shifted.result, IR::Value{shifted.carry});
+            continue;
+        }
+        default:
+            break;
+        }
+
         if (!inst.AreAllArgsImmediates())
             continue;
 
         switch (inst.GetOpcode()) {
         case IR::Opcode::ReadMemory8: {
             u32 vaddr = inst.GetArg(0).GetU32();
-            if (memory_callbacks.IsReadOnlyMemory(vaddr)) {
-                u8 value_from_memory = memory_callbacks.Read8(vaddr);
+            if (IsReadOnlyMemory(callbacks, vaddr, sizeof(u8))) {
+                u8 value_from_memory = ReadReadOnlyMemory(callbacks, vaddr, callbacks.memory.Read8, callbacks.memory_with_user_arg.Read8);
                 inst.ReplaceUsesWith(IR::Value{value_from_memory});
+                block.AppendFoldedDataRange(vaddr, static_cast<u32>(vaddr + sizeof(u8)));
             }
             break;
         }
         case IR::Opcode::ReadMemory16: {
             u32 vaddr = inst.GetArg(0).GetU32();
-            if (memory_callbacks.IsReadOnlyMemory(vaddr)) {
-                u16 value_from_memory = memory_callbacks.Read16(vaddr);
+            if (IsReadOnlyMemory(callbacks, vaddr, sizeof(u16))) {
+                u16 value_from_memory = ReadReadOnlyMemory(callbacks, vaddr, callbacks.memory.Read16, callbacks.memory_with_user_arg.Read16);
                 inst.ReplaceUsesWith(IR::Value{value_from_memory});
+                block.AppendFoldedDataRange(vaddr, static_cast<u32>(vaddr + sizeof(u16)));
             }
             break;
         }
         case IR::Opcode::ReadMemory32: {
             u32 vaddr = inst.GetArg(0).GetU32();
-            if (memory_callbacks.IsReadOnlyMemory(vaddr)) {
-                u32 value_from_memory = memory_callbacks.Read32(vaddr);
+            if (IsReadOnlyMemory(callbacks, vaddr, sizeof(u32))) {
+                u32 value_from_memory = ReadReadOnlyMemory(callbacks, vaddr, callbacks.memory.Read32, callbacks.memory_with_user_arg.Read32);
                 inst.ReplaceUsesWith(IR::Value{value_from_memory});
+                block.AppendFoldedDataRange(vaddr, static_cast<u32>(vaddr + sizeof(u32)));
             }
             break;
         }
         case IR::Opcode::ReadMemory64: {
             u32 vaddr = inst.GetArg(0).GetU32();
-            if (memory_callbacks.IsReadOnlyMemory(vaddr)) {
-                u64 value_from_memory = memory_callbacks.Read64(vaddr);
+            if (IsReadOnlyMemory(callbacks, vaddr, sizeof(u64))) {
+                u64 value_from_memory = ReadReadOnlyMemory(callbacks, vaddr, callbacks.memory.Read64, callbacks.memory_with_user_arg.Read64);
                 inst.ReplaceUsesWith(IR::Value{value_from_memory});
+                block.AppendFoldedDataRange(vaddr, static_cast<u32>(vaddr + sizeof(u64)));
+            }
+            break;
+        }
+        case IR::Opcode::CoprocGetOneWord:
+            if (const auto value = GetConstantCoprocessorWord(callbacks, inst.GetArg(0))) {
+                inst.ReplaceUsesWith(IR::Value{*value});
+                block.SetFoldedCoprocessorConstant();
+            }
+            break;
+        case IR::Opcode::Pack2x32To1x64:
+            inst.ReplaceUsesWith(IR::Value{(u64(inst.GetArg(1).GetU32()) << 32) | inst.GetArg(0).GetU32()});
+            break;
+        case IR::Opcode::LeastSignificantWord:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u32>(inst.GetArg(0).GetU64())});
+            break;
+        case IR::Opcode::MostSignificantWord: {
+            const u64 value = inst.GetArg(0).GetU64();
+            ReplaceWithResultAndCarry(inst, static_cast<u32>(value >> 32), IR::Value{Common::Bit<31>(value)});
+            break;
+        }
+        case IR::Opcode::LeastSignificantHalf:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u16>(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::LeastSignificantByte:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u8>(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::MostSignificantBit:
+            inst.ReplaceUsesWith(IR::Value{Common::Bit<31>(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::IsZero:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() == 0});
+            break;
+        case IR::Opcode::IsZero64:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU64() == 0});
+            break;
+        case IR::Opcode::LogicalShiftRight64: {
+            const u8 shift = inst.GetArg(1).GetU8();
+            if (shift < 64) {
+                inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU64() >> shift});
+            }
+            break;
+        }
+        case IR::Opcode::RotateRightExtended: {
+            const auto rotated = IR::Semantics::RotateRightExtended(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU1());
+            ReplaceWithResultAndCarry(inst, rotated.result, IR::Value{rotated.carry});
+            break;
+        }
+        case IR::Opcode::AddWithCarry:
+            FoldAddWithCarry(inst, inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1());
+            break;
+        case IR::Opcode::SubWithCarry:
+            FoldAddWithCarry(inst, inst.GetArg(0).GetU32(), ~inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1());
+            break;
+        case IR::Opcode::Add64:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU64() + inst.GetArg(1).GetU64()});
+            break;
+        case IR::Opcode::Sub64:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU64() - inst.GetArg(1).GetU64()});
+            break;
+        case IR::Opcode::Mul:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() * inst.GetArg(1).GetU32()});
+            break;
+        case IR::Opcode::Mul64:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU64() * inst.GetArg(1).GetU64()});
+            break;
+        case IR::Opcode::SignedDiv:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::SignedDivide(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32())});
+            break;
+        case IR::Opcode::UnsignedDiv: {
+            const u32 divisor = inst.GetArg(1).GetU32();
+            inst.ReplaceUsesWith(IR::Value{divisor == 0 ? 0 : inst.GetArg(0).GetU32() / divisor});
+            break;
+        }
+        case IR::Opcode::And:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() & inst.GetArg(1).GetU32()});
+            break;
+        case IR::Opcode::AndNot:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() & ~inst.GetArg(1).GetU32()});
+            break;
+        case IR::Opcode::Eor:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() ^ inst.GetArg(1).GetU32()});
+            break;
+        case IR::Opcode::Or:
+            inst.ReplaceUsesWith(IR::Value{inst.GetArg(0).GetU32() | inst.GetArg(1).GetU32()});
+            break;
+        case IR::Opcode::Not:
+            inst.ReplaceUsesWith(IR::Value{~inst.GetArg(0).GetU32()});
+            break;
+        case IR::Opcode::SignExtendWordToLong:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u64>(static_cast<s64>(static_cast<s32>(inst.GetArg(0).GetU32())))});
+            break;
+        case IR::Opcode::SignExtendHalfToWord:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u32>(static_cast<s32>(static_cast<s16>(inst.GetArg(0).GetU16())))});
+            break;
+        case IR::Opcode::SignExtendByteToWord:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u32>(static_cast<s32>(static_cast<s8>(inst.GetArg(0).GetU8())))});
+            break;
+        case IR::Opcode::ZeroExtendWordToLong:
+            inst.ReplaceUsesWith(IR::Value{static_cast<u64>(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::ByteReverseWord:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::ByteReverse(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::ByteReverseHalf: {
+            const u16 half = inst.GetArg(0).GetU16();
+            inst.ReplaceUsesWith(IR::Value{static_cast<u16>((half >> 8) | (half << 8))});
+            break;
+        }
+        case IR::Opcode::ByteReverseDual: {
+            const u64 value = inst.GetArg(0).GetU64();
+            inst.ReplaceUsesWith(IR::Value{(u64(IR::Semantics::ByteReverse(static_cast<u32>(value))) << 32) | IR::Semantics::ByteReverse(static_cast<u32>(value >> 32))});
+            break;
+        }
+        case IR::Opcode::BitReverseWord:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::BitReverse(inst.GetArg(0).GetU32())});
+            break;
+        case IR::Opcode::CountLeadingZeros: {
+            const u32 value = inst.GetArg(0).GetU32();
+            u32 count = 0;
+            while (count < 32 && !Common::Bit(31 - count, value)) {
+                count++;
             }
+            inst.ReplaceUsesWith(IR::Value{count});
+            break;
+        }
+        case IR::Opcode::SignedSaturatedAdd:
+            FoldSaturation(inst, s64(static_cast<s32>(inst.GetArg(0).GetU32())) + static_cast<s32>(inst.GetArg(1).GetU32()), std::numeric_limits<s32>::min(), std::numeric_limits<s32>::max());
+            break;
+        case IR::Opcode::SignedSaturatedSub:
+            FoldSaturation(inst, s64(static_cast<s32>(inst.GetArg(0).GetU32())) - static_cast<s32>(inst.GetArg(1).GetU32()), std::numeric_limits<s32>::min(), std::numeric_limits<s32>::max());
+            break;
+        case IR::Opcode::UnsignedSaturation: {
+            const size_t n = inst.GetArg(1).GetU8();
+            FoldSaturation(inst, static_cast<s32>(inst.GetArg(0).GetU32()), 0, (s64(1) << n) - 1);
+            break;
+        }
+        case IR::Opcode::SignedSaturation: {
+            const size_t n = inst.GetArg(1).GetU8();
+            FoldSaturation(inst, static_cast<s32>(inst.GetArg(0).GetU32()), -(s64(1) << (n - 1)), (s64(1) << (n - 1)) - 1);
             break;
         }
+        case IR::Opcode::PackedAddU8:
+            FoldPacked(inst, IR::Semantics::PackedAdd<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedAddS8:
+            FoldPacked(inst, IR::Semantics::PackedAdd<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedSubU8:
+            FoldPacked(inst, IR::Semantics::PackedSub<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedSubS8:
+            FoldPacked(inst, IR::Semantics::PackedSub<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedAddU16:
+            FoldPacked(inst, IR::Semantics::PackedAdd<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedAddS16:
+            FoldPacked(inst, IR::Semantics::PackedAdd<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedSubU16:
+            FoldPacked(inst, IR::Semantics::PackedSub<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedSubS16:
+            FoldPacked(inst, IR::Semantics::PackedSub<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32()));
+            break;
+        case IR::Opcode::PackedSubAddU16:
+            FoldPacked(inst, IR::Semantics::PackedSubAdd16<false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1(), false));
+            break;
+        case IR::Opcode::PackedSubAddS16:
+            FoldPacked(inst, IR::Semantics::PackedSubAdd16<true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1(), false));
+            break;
+        case IR::Opcode::PackedHalvingAddU8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedHalvingAddS8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedHalvingSubU8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedHalvingSubS8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedHalvingAddU16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedHalvingAddS16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedHalvingSubU16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedHalvingSubS16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedHalving<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedHalvingSubAddU16:
+            FoldPacked(inst, IR::Semantics::PackedSubAdd16<false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1(), true));
+            break;
+        case IR::Opcode::PackedHalvingSubAddS16:
+            FoldPacked(inst, IR::Semantics::PackedSubAdd16<true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), inst.GetArg(2).GetU1(), true));
+            break;
+        case IR::Opcode::PackedSaturatedAddU8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedSaturatedAddS8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedSaturatedSubU8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<8, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedSaturatedSubS8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<8, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedSaturatedAddU16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedSaturatedAddS16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), false)});
+            break;
+        case IR::Opcode::PackedSaturatedSubU16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<16, false>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedSaturatedSubS16:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedSaturated<16, true>(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32(), true)});
+            break;
+        case IR::Opcode::PackedAbsDiffSumS8:
+            inst.ReplaceUsesWith(IR::Value{IR::Semantics::PackedAbsDiffSum8(inst.GetArg(0).GetU32(), inst.GetArg(1).GetU32())});
+            break;
         case IR::Opcode::ZeroExtendByteToWord: {
             u8 byte = inst.GetArg(0).GetU8();
             u32 value = static_cast<u32>(byte);
@@ -0,0 +1,123 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <boost/variant/get.hpp>
+
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/terminal.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+/// Whether inst may let user code see the guest state, e.g. through a memory callback or an exception.
+static bool MayObserveGuestState(const IR::Inst& inst) {
+    return inst.IsMemoryReadOrWrite() || inst.CausesCPUException() || inst.IsCoprocessorInstruction()
+           || inst.GetOpcode() == IR::Opcode::SkipSpinLoop;
+}
+
+bool DiscardsNZCVOnEntry(const IR::Block& block) {
+    if (block.GetCondition() != Arm::Cond::AL || block.HasBreakpoint())
+        return false;
+
+    enum : unsigned { V = 1, C = 2, Z = 4, N = 8, NZCV = 15 };
+    unsigned written = 0;
+    for (const auto& inst : block) {
+        if (MayObserveGuestState(inst))
+            return false;
+
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::GetNFlag:
+            if (!(written & N))
+                return false;
+            break;
+        case IR::Opcode::GetZFlag:
+            if (!(written & Z))
+                return false;
+            break;
+        case IR::Opcode::GetCFlag:
+            if (!(written & C))
+                return false;
+            break;
+        case IR::Opcode::GetVFlag:
+            if (!(written & V))
+                return false;
+            break;
+        case IR::Opcode::SetNFlag:
+            written |= N;
+            break;
+        case IR::Opcode::SetZFlag:
+            written |= Z;
+            break;
+        case IR::Opcode::SetCFlag:
+            written |= C;
+            break;
+        case IR::Opcode::SetVFlag:
+            written |= V;
+            break;
+        case IR::Opcode::SetNZFlags:
+            written |= N | Z;
+            break;
+        case IR::Opcode::SetNZCFlags:
+            written |= N | Z | C;
+            break;
+        case IR::Opcode::SetNZCVFlags:
+        case IR::Opcode::SetNZCVFlagsAtExit:
+        case IR::Opcode::SetCpsr:
+        case IR::Opcode::SetCpsrAndSwitchMode:
+            written = NZCV;
+            break;
+        default:
+            if (inst.ReadsFromCPSR() && written != NZCV)
+                return false;
+            break;
+        }
+
+        if (written == NZCV)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Turns the SetNZCVFlags that leaves a block's final flags into SetNZCVFlagsAtExit when the block
+ * links to a block that overwrites them before reading them. The backend then only stores them on
+ * exits that return to the dispatcher, where they can be seen, rather than on the jump to the
+ * linked block. It never links such an exit to a block that may read them, so `discards_nzcv`
+ * only has to be right for the code to be fast, not for it to be correct.
+ * Run after FlagPacking.
+ */
+void DeadFlagStoreElimination(IR::Block& block, const std::function<bool(IR::LocationDescriptor)>& discards_nzcv) {
+    const IR::Terminal& terminal = block.GetTerminal();
+    boost::optional<IR::LocationDescriptor> next;
+    if (const auto* link_block = boost::get<IR::Term::LinkBlock>(&terminal)) {
+        next = link_block->next;
+    } else if (const auto* link_block_fast = boost::get<IR::Term::LinkBlockFast>(&terminal)) {
+        next = link_block_fast->next;
+    } else {
+        return;
+    }
+
+    // The last instruction to touch the flags must set them all, and nothing after it may see them.
+    for (auto iter = block.end(); iter != block.begin();) {
+        --iter;
+        if (iter->GetOpcode() == IR::Opcode::SetNZCVFlags) {
+            if (!discards_nzcv(*next))
+                return;
+            block.PrependNewInst(iter, IR::Opcode::SetNZCVFlagsAtExit, {iter->GetArg(0), iter->GetArg(1), iter->GetArg(2), iter->GetArg(3)});
+            iter->Invalidate();
+            block.Instructions().erase(iter);
+            return;
+        }
+        if (iter->ReadsFromCPSR() || iter->WritesToCPSR() || MayObserveGuestState(*iter))
+            return;
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
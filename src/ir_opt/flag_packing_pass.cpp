@@ -0,0 +1,99 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <array>
+
+#include <boost/optional.hpp>
+
+#include "common/common_types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+/**
+ * Combines the SetNFlag, SetZFlag, SetCFlag and SetVFlag instructions between two accesses to the CPSR
+ * into a single SetNZFlags, SetNZCFlags or SetNZCVFlags instruction, so the CPSR is only written once.
+ * A flag set that is overwritten before the CPSR is next accessed is removed, allowing dead code
+ * elimination to remove the computation of its value too.
+ */
+void FlagPacking(IR::Block& block) {
+    using Iterator = IR::Block::iterator;
+    enum : size_t { N, Z, C, V };
+
+    std::array<boost::optional<Iterator>, 4> pending_sets;
+    Iterator last_set;
+
+    const auto erase = [&block](Iterator inst) {
+        inst->Invalidate();
+        block.Instructions().erase(inst);
+    };
+
+    const auto pack = [&]() {
+        const auto is_pending = [&pending_sets](size_t flag) { return static_cast<bool>(pending_sets[flag]); };
+        const auto value_of = [&pending_sets](size_t flag) { return (*pending_sets[flag])->GetArg(0); };
+
+        if (is_pending(N) && is_pending(Z)) {
+            if (is_pending(C) && is_pending(V)) {
+                block.PrependNewInst(last_set, IR::Opcode::SetNZCVFlags, {value_of(N), value_of(Z), value_of(C), value_of(V)});
+                erase(*pending_sets[C]);
+                erase(*pending_sets[V]);
+            } else if (is_pending(C)) {
+                block.PrependNewInst(last_set, IR::Opcode::SetNZCFlags, {value_of(N), value_of(Z), value_of(C)});
+                erase(*pending_sets[C]);
+            } else {
+                // A pending SetVFlag is left as it is.
+                block.PrependNewInst(last_set, IR::Opcode::SetNZFlags, {value_of(N), value_of(Z)});
+            }
+            erase(*pending_sets[N]);
+            erase(*pending_sets[Z]);
+        }
+
+        pending_sets = {};
+    };
+
+    const auto do_set = [&](size_t flag, Iterator inst) {
+        if (pending_sets[flag]) {
+            erase(*pending_sets[flag]);
+        }
+        pending_sets[flag] = inst;
+        last_set = inst;
+    };
+
+    for (auto iter = block.begin(); iter != block.end();) {
+        // Packing may erase the current instruction, so advance the iterator first.
+        auto inst = iter++;
+
+        switch (inst->GetOpcode()) {
+        case IR::Opcode::SetNFlag:
+            do_set(N, inst);
+            break;
+        case IR::Opcode::SetZFlag:
+            do_set(Z, inst);
+            break;
+        case IR::Opcode::SetCFlag:
+            do_set(C, inst);
+            break;
+        case IR::Opcode::SetVFlag:
+            do_set(V, inst);
+            break;
+        default:
+            if (inst->ReadsFromCPSR() || inst->WritesToCPSR() || inst->CausesCPUException() || inst->IsCoprocessorInstruction()) {
+                pack();
+            }
+            break;
+        }
+    }
+
+    pack();
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -5,10 +5,13 @@
  */
 
 #include <array>
+#include <initializer_list>
 
 #include "common/assert.h"
+#include "common/bit_util.h"
 #include "common/common_types.h"
 #include "frontend/ir/basic_block.h"
+#include "frontend/ir/opcodes.h"
 #include "frontend/ir/value.h"
 #include "ir_opt/passes.h"
 
@@ -52,6 +55,16 @@ void GetSetElimination(IR::Block& block) {
         get_inst->ReplaceUsesWith(info.register_value);
     };
 
+    // Single-precision registers S(2n) and S(2n+1) are the low and high halves of D(n), for n < 16.
+    // Values of one view are derived from known values of the other, so that mixing the views
+    // does not need a store and reload.
+    const auto insert_before = [&block](Iterator inst, IR::Opcode opcode, std::initializer_list<IR::Value> args) {
+        return IR::Value(&*block.PrependNewInst(inst, opcode, args));
+    };
+    const auto split_double = [&insert_before](Iterator inst, IR::Value double_value, bool high_half) {
+        return insert_before(inst, high_half ? IR::Opcode::FPMostSignificantWord : IR::Opcode::FPLeastSignificantWord, {double_value});
+    };
+
     for (auto inst = block.begin(); inst != block.end(); ++inst) {
         switch (inst->GetOpcode()) {
         case IR::Opcode::SetRegister: {
@@ -72,23 +85,33 @@ void GetSetElimination(IR::Block& block) {
         case IR::Opcode::SetExtendedRegister32: {
             Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
             size_t reg_index = Arm::RegNumber(reg);
-            do_set(ext_reg_singles_info[reg_index], inst->GetArg(1), inst);
+            RegisterInfo& double_info = ext_reg_doubles_info[reg_index / 2];
 
-            size_t doubles_reg_index = reg_index / 2;
-            if (doubles_reg_index < ext_reg_doubles_info.size()) {
-                ext_reg_doubles_info[doubles_reg_index] = {};
+            // The other half of the double keeps its value.
+            RegisterInfo& other_half_info = ext_reg_singles_info[reg_index ^ 1];
+            if (other_half_info.register_value.IsEmpty() && !double_info.register_value.IsEmpty()) {
+                other_half_info.register_value = split_double(inst, double_info.register_value, (reg_index ^ 1) % 2 == 1);
             }
+
+            do_set(ext_reg_singles_info[reg_index], inst->GetArg(1), inst);
+            double_info = {};
             break;
         }
         case IR::Opcode::GetExtendedRegister32: {
             Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
             size_t reg_index = Arm::RegNumber(reg);
-            do_get(ext_reg_singles_info[reg_index], inst);
+            RegisterInfo& info = ext_reg_singles_info[reg_index];
+            RegisterInfo& double_info = ext_reg_doubles_info[reg_index / 2];
 
-            size_t doubles_reg_index = reg_index / 2;
-            if (doubles_reg_index < ext_reg_doubles_info.size()) {
-                ext_reg_doubles_info[doubles_reg_index] = {};
+            if (info.register_value.IsEmpty() && !double_info.register_value.IsEmpty()) {
+                info.register_value = split_double(inst, double_info.register_value, reg_index % 2 == 1);
             }
+
+            if (info.register_value.IsEmpty()) {
+                // This is read from the guest state, so a pending set of the double must stay.
+                double_info.set_instruction_present = false;
+            }
+            do_get(info, inst);
             break;
         }
         case IR::Opcode::SetExtendedRegister64: {
@@ -98,20 +121,51 @@ void GetSetElimination(IR::Block& block) {
 
             size_t singles_reg_index = reg_index * 2;
             if (singles_reg_index < ext_reg_singles_info.size()) {
-                ext_reg_singles_info[singles_reg_index] = {};
-                ext_reg_singles_info[singles_reg_index+1] = {};
+                // Both halves are overwritten, so pending sets of them are dead.
+                for (size_t i = singles_reg_index; i < singles_reg_index + 2; i++) {
+                    if (ext_reg_singles_info[i].set_instruction_present) {
+                        ext_reg_singles_info[i].last_set_instruction->Invalidate();
+                        block.Instructions().erase(ext_reg_singles_info[i].last_set_instruction);
+                    }
+                    ext_reg_singles_info[i] = {};
+                }
             }
             break;
         }
         case IR::Opcode::GetExtendedRegister64: {
             Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
             size_t reg_index = Arm::RegNumber(reg);
-            do_get(ext_reg_doubles_info[reg_index], inst);
+            RegisterInfo& info = ext_reg_doubles_info[reg_index];
 
             size_t singles_reg_index = reg_index * 2;
             if (singles_reg_index < ext_reg_singles_info.size()) {
-                ext_reg_singles_info[singles_reg_index] = {};
-                ext_reg_singles_info[singles_reg_index+1] = {};
+                RegisterInfo& lo_info = ext_reg_singles_info[singles_reg_index];
+                RegisterInfo& hi_info = ext_reg_singles_info[singles_reg_index + 1];
+                if (info.register_value.IsEmpty() && !lo_info.register_value.IsEmpty() && !hi_info.register_value.IsEmpty()) {
+                    info.register_value = insert_before(inst, IR::Opcode::FPPack2x32To1x64, {lo_info.register_value, hi_info.register_value});
+                }
+                if (info.register_value.IsEmpty()) {
+                    // This is read from the guest state, so pending sets of the halves must stay.
+                    lo_info.set_instruction_present = false;
+                    hi_info.set_instruction_present = false;
+                }
+            }
+
+            do_get(info, inst);
+            break;
+        }
+        case IR::Opcode::GetVector:
+        case IR::Opcode::SetVector: {
+            // Vectors are not tracked, so forget everything known about the registers they overlap.
+            Arm::ExtReg reg = inst->GetArg(0).GetExtRegRef();
+            size_t doubles_reg_index = Arm::IsQuadExtReg(reg) ? Arm::RegNumber(reg) * 2 : Arm::RegNumber(reg);
+            size_t doubles_count = Arm::IsQuadExtReg(reg) ? 2 : 1;
+            for (size_t i = doubles_reg_index; i < doubles_reg_index + doubles_count; i++) {
+                ext_reg_doubles_info[i] = {};
+                if (i * 2 < ext_reg_singles_info.size()) {
+                    ext_reg_singles_info[i * 2] = {};
+                    ext_reg_singles_info[i * 2 + 1] = {};
+                }
             }
             break;
         }
@@ -155,6 +209,45 @@ void GetSetElimination(IR::Block& block) {
             do_get(cpsr_info.ge, inst);
             break;
         }
+        case IR::Opcode::ReadMemoryToRegisters:
+        case IR::Opcode::WriteMemoryFromRegisters: {
+            // These access the registers in the list directly: Neither known values nor pending sets carry across.
+            const u32 list = inst->GetArg(1).GetU32();
+            for (size_t i = 0; i < reg_info.size(); i++) {
+                if (Common::Bit(i, list)) {
+                    reg_info[i] = {};
+                }
+            }
+            break;
+        }
+        case IR::Opcode::ReadMemoryToExtRegisters:
+        case IR::Opcode::WriteMemoryFromExtRegisters: {
+            ext_reg_singles_info = {};
+            ext_reg_doubles_info = {};
+            break;
+        }
+        case IR::Opcode::SetCpsrAndSwitchMode: {
+            // Banks R8-R14, so no known register value or pending set carries across.
+            reg_info = {};
+            cpsr_info = {};
+            break;
+        }
+        case IR::Opcode::SideExit: {
+            // The next block sees the guest state of this point if the exit is taken, so the sets before it
+            // must stay. Known values still hold after it.
+            const auto keep_pending_sets = [](auto& infos) {
+                for (RegisterInfo& info : infos) {
+                    info.set_instruction_present = false;
+                }
+            };
+            keep_pending_sets(reg_info);
+            keep_pending_sets(ext_reg_singles_info);
+            keep_pending_sets(ext_reg_doubles_info);
+            for (RegisterInfo* info : {&cpsr_info.n, &cpsr_info.z, &cpsr_info.c, &cpsr_info.v, &cpsr_info.ge}) {
+                info->set_instruction_present = false;
+            }
+            break;
+        }
         default: {
             if (inst->ReadsFromCPSR() || inst->WritesToCPSR()) {
                 cpsr_info = {};
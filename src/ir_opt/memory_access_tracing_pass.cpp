@@ -0,0 +1,105 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include "common/bit_util.h"
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+/// Determines the number of bytes `inst` accesses and whether it writes them. Returns false if it is not a memory access.
+static bool GetMemoryAccess(const IR::Inst& inst, u8& size, bool& is_write) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::ReadMemory8:
+    case IR::Opcode::ExclusiveReadMemory8:
+        size = 1;
+        is_write = false;
+        return true;
+    case IR::Opcode::ReadMemory16:
+    case IR::Opcode::ExclusiveReadMemory16:
+        size = 2;
+        is_write = false;
+        return true;
+    case IR::Opcode::ReadMemory32:
+    case IR::Opcode::ExclusiveReadMemory32:
+        size = 4;
+        is_write = false;
+        return true;
+    case IR::Opcode::ReadMemory64:
+    case IR::Opcode::ExclusiveReadMemory64:
+        size = 8;
+        is_write = false;
+        return true;
+    case IR::Opcode::ReadMemory128:
+        size = 16;
+        is_write = false;
+        return true;
+    case IR::Opcode::WriteMemory8:
+    case IR::Opcode::ExclusiveWriteMemory8:
+        size = 1;
+        is_write = true;
+        return true;
+    case IR::Opcode::WriteMemory16:
+    case IR::Opcode::ExclusiveWriteMemory16:
+        size = 2;
+        is_write = true;
+        return true;
+    case IR::Opcode::WriteMemory32:
+    case IR::Opcode::ExclusiveWriteMemory32:
+        size = 4;
+        is_write = true;
+        return true;
+    case IR::Opcode::WriteMemory64:
+    case IR::Opcode::ExclusiveWriteMemory64:
+        size = 8;
+        is_write = true;
+        return true;
+    case IR::Opcode::WriteMemory128:
+        size = 16;
+        is_write = true;
+        return true;
+    case IR::Opcode::ReadMemoryToRegisters:
+    case IR::Opcode::WriteMemoryFromRegisters:
+        // R0-R14; PC is loaded by a separate ReadMemory32.
+        size = static_cast<u8>(Common::BitCount(inst.GetArg(1).GetU32() & 0x7FFF) * 4);
+        is_write = inst.GetOpcode() == IR::Opcode::WriteMemoryFromRegisters;
+        return true;
+    case IR::Opcode::ReadMemoryToExtRegisters:
+    case IR::Opcode::WriteMemoryFromExtRegisters: {
+        const size_t reg_size = Arm::IsSingleExtReg(inst.GetArg(1).GetExtRegRef()) ? 4 : 8;
+        size = static_cast<u8>(inst.GetArg(2).GetU8() * reg_size);
+        is_write = inst.GetOpcode() == IR::Opcode::WriteMemoryFromExtRegisters;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * Inserts a TraceMemoryAccess instruction before each memory access, which records the access in the
+ * Jit's memory trace (see UserCallbacks::memory_trace_size). Runs after the optimizations, so that only
+ * the accesses that are actually made are recorded.
+ */
+void MemoryAccessTracing(IR::Block& block) {
+    for (auto iter = block.begin(); iter != block.end(); ++iter) {
+        u8 size;
+        bool is_write;
+        if (!GetMemoryAccess(*iter, size, is_write))
+            continue;
+
+        block.PrependNewInst(iter, IR::Opcode::TraceMemoryAccess, {iter->GetArg(0), IR::Value(iter->GuestPC()), IR::Value(size), IR::Value(is_write)});
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -0,0 +1,162 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <dynarmic/callbacks.h>
+
+#include "common/common_types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+namespace {
+
+/// An address of the form base + offset. base is nullptr for absolute addresses.
+struct Address {
+    IR::Inst* base;
+    u32 offset;
+};
+
+IR::Inst* SkipIdentities(IR::Inst* inst) {
+    while (inst->GetOpcode() == IR::Opcode::Identity && !inst->GetArg(0).IsImmediate()) {
+        inst = inst->GetArg(0).GetInst();
+    }
+    return inst;
+}
+
+Address DecomposeAddress(const IR::Value& vaddr) {
+    if (vaddr.IsImmediate()) {
+        return {nullptr, vaddr.GetU32()};
+    }
+
+    IR::Inst* inst = SkipIdentities(vaddr.GetInst());
+    switch (inst->GetOpcode()) {
+    case IR::Opcode::AddWithCarry:
+        if (inst->GetArg(1).IsImmediate() && inst->GetArg(2).IsImmediate()) {
+            Address address = DecomposeAddress(inst->GetArg(0));
+            address.offset += inst->GetArg(1).GetU32() + (inst->GetArg(2).GetU1() ? 1 : 0);
+            return address;
+        }
+        break;
+    case IR::Opcode::SubWithCarry:
+        if (inst->GetArg(1).IsImmediate() && inst->GetArg(2).IsImmediate()) {
+            Address address = DecomposeAddress(inst->GetArg(0));
+            address.offset += ~inst->GetArg(1).GetU32() + (inst->GetArg(2).GetU1() ? 1 : 0);
+            return address;
+        }
+        break;
+    default:
+        break;
+    }
+    return {inst, 0};
+}
+
+size_t AccessSize(IR::Opcode opcode) {
+    switch (opcode) {
+    case IR::Opcode::ReadMemory8:
+    case IR::Opcode::WriteMemory8:
+        return 1;
+    case IR::Opcode::ReadMemory16:
+    case IR::Opcode::WriteMemory16:
+        return 2;
+    case IR::Opcode::ReadMemory32:
+    case IR::Opcode::WriteMemory32:
+        return 4;
+    case IR::Opcode::ReadMemory64:
+    case IR::Opcode::WriteMemory64:
+        return 8;
+    case IR::Opcode::ReadMemory128:
+    case IR::Opcode::WriteMemory128:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+/// Whether the `size` byte access at `address` reaches a device of UserCallbacks::mmio_pages.
+/// Only absolute addresses can be checked when translating.
+bool IsMmioAccess(const UserCallbacks& callbacks, const Address& address, size_t size) {
+    if (!callbacks.mmio_pages || address.base)
+        return false;
+    const u32 first_page = address.offset >> UserCallbacks::PAGE_BITS;
+    const u32 last_page = static_cast<u32>(address.offset + size - 1) >> UserCallbacks::PAGE_BITS;
+    return (*callbacks.mmio_pages)[first_page] || (*callbacks.mmio_pages)[last_page];
+}
+
+/// A value known to be in memory at `address`.
+struct KnownValue {
+    Address address;
+    size_t size;
+    IR::Value value;
+
+    bool IsAt(const Address& other, size_t other_size) const {
+        return address.base == other.base && address.offset == other.offset && size == other_size;
+    }
+
+    /// Only accesses relative to the same base can be proven not to overlap.
+    bool MayOverlap(const Address& other, size_t other_size) const {
+        if (address.base != other.base)
+            return true;
+        return static_cast<u32>(other.offset - address.offset) < size ||
+               static_cast<u32>(address.offset - other.offset) < other_size;
+    }
+};
+
+} // anonymous namespace
+
+void MemoryForwarding(IR::Block& block, const UserCallbacks& callbacks) {
+    std::vector<KnownValue> known_values;
+
+    for (auto& inst : block) {
+        const IR::Opcode opcode = inst.GetOpcode();
+
+        if (inst.IsSharedMemoryReadOrWrite() && AccessSize(opcode) != 0) {
+            // A device access calls its handler, which may have side effects and need not return the last write.
+            if (IsMmioAccess(callbacks, DecomposeAddress(inst.GetArg(0)), AccessSize(opcode))) {
+                known_values.clear();
+                continue;
+            }
+        }
+
+        if (inst.IsSharedMemoryRead() && AccessSize(opcode) != 0) {
+            const Address address = DecomposeAddress(inst.GetArg(0));
+            const size_t size = AccessSize(opcode);
+
+            auto iter = std::find_if(known_values.begin(), known_values.end(), [&](const auto& known) { return known.IsAt(address, size); });
+            if (iter != known_values.end()) {
+                inst.ReplaceUsesWith(iter->value);
+            } else {
+                known_values.push_back({address, size, IR::Value(&inst)});
+            }
+            continue;
+        }
+
+        if (inst.IsSharedMemoryWrite() && AccessSize(opcode) != 0) {
+            const Address address = DecomposeAddress(inst.GetArg(0));
+            const size_t size = AccessSize(opcode);
+
+            known_values.erase(std::remove_if(known_values.begin(), known_values.end(), [&](const auto& known) { return known.MayOverlap(address, size); }), known_values.end());
+            known_values.push_back({address, size, inst.GetArg(1)});
+            continue;
+        }
+
+        // Anything else that may write memory, or that may call back into the user, which may modify it.
+        // Past a barrier, another core's stores may become visible.
+        if (inst.IsMemoryWrite() || inst.IsMemoryBarrier() || inst.AltersExclusiveState() || inst.IsCoprocessorInstruction() || inst.CausesCPUException()) {
+            known_values.clear();
+        }
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
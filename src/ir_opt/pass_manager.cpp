@@ -0,0 +1,68 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <chrono>
+#include <utility>
+
+#include "frontend/ir/basic_block.h"
+#include "ir_opt/pass_manager.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+void PassManager::AddPass(std::string name, Pass pass, bool enabled) {
+    if (!enabled)
+        return;
+    passes.emplace_back(std::move(name), std::move(pass));
+}
+
+void PassManager::Run(IR::Block& block) const {
+    u64 instruction_count = block.Instructions().size();
+
+    for (const Entry& entry : passes) {
+        const auto start = std::chrono::steady_clock::now();
+        entry.pass(block);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        entry.runs++;
+        entry.time_ns += static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        entry.instructions_before += instruction_count;
+        instruction_count = block.Instructions().size();
+        entry.instructions_after += instruction_count;
+    }
+}
+
+void PassManager::RunUncounted(IR::Block& block) const {
+    for (const Entry& entry : passes) {
+        entry.pass(block);
+    }
+}
+
+std::vector<PassStatistics> PassManager::GetStatistics() const {
+    std::vector<PassStatistics> result;
+    for (const Entry& entry : passes) {
+        PassStatistics statistics;
+        statistics.name = entry.name;
+        statistics.runs = entry.runs;
+        statistics.time_ns = entry.time_ns;
+        statistics.instructions_before = entry.instructions_before;
+        statistics.instructions_after = entry.instructions_after;
+        result.push_back(std::move(statistics));
+    }
+    return result;
+}
+
+void PassManager::ResetStatistics() {
+    for (Entry& entry : passes) {
+        entry.runs = 0;
+        entry.time_ns = 0;
+        entry.instructions_before = 0;
+        entry.instructions_after = 0;
+    }
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -0,0 +1,73 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Dynarmic {
+namespace IR {
+class Block;
+}
+}
+
+namespace Dynarmic {
+namespace Optimization {
+
+/// Totals over all runs of one pass in a pipeline.
+struct PassStatistics {
+    std::string name;
+    u64 runs = 0;
+    u64 time_ns = 0;
+    u64 instructions_before = 0; ///< Sum over all runs of the number of instructions in the block before the pass
+    u64 instructions_after = 0;  ///< Sum over all runs of the number of instructions in the block after the pass
+};
+
+/**
+ * An ordered pipeline of optimization passes, which records the time taken by each pass and the
+ * number of instructions before and after it. Run may be called from several threads at once.
+ */
+class PassManager final {
+public:
+    using Pass = std::function<void(IR::Block&)>;
+
+    /// Appends pass to the pipeline if enabled is true; otherwise the pipeline is left unchanged.
+    void AddPass(std::string name, Pass pass, bool enabled = true);
+
+    /// Runs every pass in the pipeline on block, in the order they were added.
+    void Run(IR::Block& block) const;
+    /// Does what Run does without recording statistics, e.g. to show the IR of a block for diagnostics.
+    void RunUncounted(IR::Block& block) const;
+
+    std::vector<PassStatistics> GetStatistics() const;
+    /// Sets the totals of every pass back to zero. Must not be called while Run is.
+    void ResetStatistics();
+
+private:
+    struct Entry {
+        Entry(std::string name, Pass pass) : name(std::move(name)), pass(std::move(pass)) {}
+
+        std::string name;
+        Pass pass;
+        mutable std::atomic<u64> runs{0};
+        mutable std::atomic<u64> time_ns{0};
+        mutable std::atomic<u64> instructions_before{0};
+        mutable std::atomic<u64> instructions_after{0};
+    };
+
+    // A deque, as entries are neither copyable nor movable.
+    std::deque<Entry> passes;
+};
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -6,8 +6,14 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <dynarmic/callbacks.h>
 
+#include "frontend/arm/types.h"
+#include "frontend/ir/location_descriptor.h"
+
 namespace Dynarmic {
 namespace IR {
 class Block;
@@ -17,10 +23,25 @@ class Block;
 namespace Dynarmic {
 namespace Optimization {
 
+void RegisterSpecialization(IR::Block& block);
 void GetSetElimination(IR::Block& block);
-void ConstantPropagation(IR::Block& block, const UserCallbacks::Memory& memory_callbacks);
+void ConstantPropagation(IR::Block& block, const UserCallbacks& callbacks);
+void CommonSubexpressionElimination(IR::Block& block);
+void CarryChainFusion(IR::Block& block);
 void DeadCodeElimination(IR::Block& block);
+void FlagPacking(IR::Block& block);
+void DeadFlagStoreElimination(IR::Block& block, const std::function<bool(IR::LocationDescriptor)>& discards_nzcv);
+void MemoryForwarding(IR::Block& block, const UserCallbacks& callbacks);
+void MemoryAccessTracing(IR::Block& block);
+void SpinLoopDetection(IR::Block& block);
 void VerificationPass(const IR::Block& block);
 
+/// Whether `block` overwrites all of N, Z, C and V before reading any of them or letting user code see them.
+bool DiscardsNZCVOnEntry(const IR::Block& block);
+
+/// The registers that `block` reads on entry, before anything in it may change their values, in the order first read.
+/// Guards on these are what RegisterSpecialization can make use of.
+std::vector<Arm::Reg> FindEntryRegisters(const IR::Block& block);
+
 } // namespace Optimization
 } // namespace Dynarmic
@@ -0,0 +1,80 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+/// Whether `inst` may change guest registers other than through SetRegister: by switching the banked
+/// registers, by loading several at once, or by calling user code that can write them through the Jit.
+static bool MayChangeRegisters(const IR::Inst& inst) {
+    return inst.GetOpcode() == IR::Opcode::SetCpsrAndSwitchMode ||
+           inst.GetOpcode() == IR::Opcode::ReadMemoryToRegisters ||
+           inst.CausesCPUException() ||
+           inst.IsCoprocessorInstruction();
+}
+
+/**
+ * Calls `on_entry_read` with each GetRegister of `block` that reads the value its register had on entry,
+ * i.e. comes before any SetRegister of that register and anything else that may change it.
+ */
+template <typename Block, typename OnEntryRead>
+static void ForEachEntryRead(Block& block, OnEntryRead on_entry_read) {
+    std::array<bool, 16> written{};
+    for (auto& inst : block) {
+        if (MayChangeRegisters(inst))
+            return;
+
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::SetRegister:
+            written[static_cast<size_t>(inst.GetArg(0).GetRegRef())] = true;
+            break;
+        case IR::Opcode::GetRegister:
+            if (!written[static_cast<size_t>(inst.GetArg(0).GetRegRef())])
+                on_entry_read(inst);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+std::vector<Arm::Reg> FindEntryRegisters(const IR::Block& block) {
+    std::vector<Arm::Reg> registers;
+    ForEachEntryRead(block, [&registers](const IR::Inst& inst) {
+        const Arm::Reg reg = inst.GetArg(0).GetRegRef();
+        if (std::find(registers.begin(), registers.end(), reg) == registers.end())
+            registers.push_back(reg);
+    });
+    return registers;
+}
+
+void RegisterSpecialization(IR::Block& block) {
+    const auto& guards = block.RegisterGuards();
+    if (guards.empty())
+        return;
+
+    ForEachEntryRead(block, [&guards](IR::Inst& inst) {
+        const Arm::Reg reg = inst.GetArg(0).GetRegRef();
+        const auto guard = std::find_if(guards.begin(), guards.end(), [reg](const auto& guard) { return guard.first == reg; });
+        if (guard != guards.end())
+            inst.ReplaceUsesWith(IR::Value{guard->second});
+    });
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
@@ -0,0 +1,154 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <array>
+
+#include <boost/optional.hpp>
+#include <boost/variant/get.hpp>
+
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/microinstruction.h"
+#include "frontend/ir/opcodes.h"
+#include "frontend/ir/terminal.h"
+#include "frontend/ir/value.h"
+#include "ir_opt/passes.h"
+
+namespace Dynarmic {
+namespace Optimization {
+
+/// The guest state a spin loop may read and write, as long as it never writes what it has read.
+class LoopState final {
+public:
+    enum : size_t { N = 16, Z, C, V, GE, Count };
+
+    void Read(size_t index) {
+        if (!written[index])
+            read[index] = true;
+    }
+
+    /// Returns false if the value written may depend on the previous iteration.
+    bool Write(size_t index) {
+        written[index] = true;
+        return !read[index];
+    }
+
+    void ReadFlags() {
+        for (size_t flag : {N, Z, C, V, GE})
+            Read(flag);
+    }
+
+private:
+    std::array<bool, Count> read{};
+    std::array<bool, Count> written{};
+};
+
+static bool IsBackEdge(const IR::Terminal& terminal, const IR::LocationDescriptor& start) {
+    const auto* link = boost::get<IR::Term::LinkBlock>(&terminal);
+    return link && link->next == start;
+}
+
+/// Returns true if running the block again would have the same effect as last time, unless memory has changed.
+static bool IsSpinLoopBody(IR::Block& block) {
+    LoopState state;
+    for (const auto& inst : block) {
+        switch (inst.GetOpcode()) {
+        case IR::Opcode::GetRegister:
+            state.Read(static_cast<size_t>(inst.GetArg(0).GetRegRef()));
+            break;
+        case IR::Opcode::SetRegister: {
+            const Arm::Reg reg = inst.GetArg(0).GetRegRef();
+            if (reg == Arm::Reg::PC || !state.Write(static_cast<size_t>(reg)))
+                return false;
+            break;
+        }
+        case IR::Opcode::GetNFlag:
+            state.Read(LoopState::N);
+            break;
+        case IR::Opcode::GetZFlag:
+            state.Read(LoopState::Z);
+            break;
+        case IR::Opcode::GetCFlag:
+            state.Read(LoopState::C);
+            break;
+        case IR::Opcode::GetVFlag:
+            state.Read(LoopState::V);
+            break;
+        case IR::Opcode::GetGEFlags:
+            state.Read(LoopState::GE);
+            break;
+        case IR::Opcode::SetNFlag:
+            if (!state.Write(LoopState::N))
+                return false;
+            break;
+        case IR::Opcode::SetZFlag:
+            if (!state.Write(LoopState::Z))
+                return false;
+            break;
+        case IR::Opcode::SetCFlag:
+            if (!state.Write(LoopState::C))
+                return false;
+            break;
+        case IR::Opcode::SetVFlag:
+            if (!state.Write(LoopState::V))
+                return false;
+            break;
+        case IR::Opcode::SetGEFlags:
+            if (!state.Write(LoopState::GE))
+                return false;
+            break;
+        default:
+            // Memory reads and computations are allowed; anything else with an effect is not.
+            if (inst.MayHaveSideEffects())
+                return false;
+            if (inst.ReadsFromCPSR())
+                state.ReadFlags();
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Finds blocks that branch back to their own start without writing memory or carrying any register or
+ * flag value over from one iteration to the next, such as loops polling memory for a change (see
+ * UserCallbacks::skip_spin_loops). A SkipSpinLoop instruction is appended to such a block, which uses
+ * up the remaining cycle budget whenever the back edge is taken, so the block does not iterate again
+ * until the next call to Jit::Run.
+ */
+void SpinLoopDetection(IR::Block& block) {
+    if (block.GetCondition() != Arm::Cond::AL || !block.HasTerminal())
+        return;
+
+    const IR::Terminal& terminal = block.GetTerminal();
+    const IR::LocationDescriptor start = block.Location();
+
+    boost::optional<Arm::Cond> back_edge_cond;
+    if (IsBackEdge(terminal, start)) {
+        back_edge_cond = Arm::Cond::AL;
+    } else if (const auto* if_ = boost::get<IR::Term::If>(&terminal)) {
+        if (if_->if_ != Arm::Cond::AL && if_->if_ != Arm::Cond::NV) {
+            if (IsBackEdge(if_->then_, start))
+                back_edge_cond = if_->if_;
+            else if (IsBackEdge(if_->else_, start))
+                back_edge_cond = static_cast<Arm::Cond>(static_cast<size_t>(if_->if_) ^ 1); // Conditions come in inverse pairs
+        }
+    }
+
+    if (!back_edge_cond || !IsSpinLoopBody(block))
+        return;
+
+    if (*back_edge_cond == Arm::Cond::AL) {
+        block.AppendNewInst(IR::Opcode::SkipSpinLoop, {IR::Value(true)});
+        return;
+    }
+    block.AppendNewInst(IR::Opcode::TestCondition, {IR::Value(static_cast<u8>(*back_edge_cond))});
+    block.AppendNewInst(IR::Opcode::SkipSpinLoop, {IR::Value(&block.Instructions().back())});
+}
+
+} // namespace Optimization
+} // namespace Dynarmic
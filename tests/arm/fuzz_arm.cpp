@@ -10,6 +10,8 @@
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <tuple>
 #include <vector>
 
@@ -24,6 +26,7 @@
 #include "frontend/ir/location_descriptor.h"
 #include "frontend/translate/translate.h"
 #include "ir_opt/passes.h"
+#include "parallel_fuzz.h"
 #include "rand_int.h"
 #include "skyeye_interpreter/dyncom/arm_dyncom_interpreter.h"
 #include "skyeye_interpreter/skyeye_common/armstate.h"
@@ -44,8 +47,9 @@ static bool operator==(const WriteRecord& a, const WriteRecord& b) {
     return std::tie(a.size, a.address, a.data) == std::tie(b.size, b.address, b.data);
 }
 
-static std::array<u32, 3000> code_mem{};
-static std::vector<WriteRecord> write_records;
+// Each fuzzing thread has its own guest memory.
+static thread_local std::array<u32, 3000> code_mem{};
+static thread_local std::vector<WriteRecord> write_records;
 
 static bool IsReadOnlyMemory(u32 vaddr);
 static u8 MemoryRead8(u32 vaddr);
@@ -197,7 +201,7 @@ static bool DoesBehaviorMatch(const ARMul_State& interp, const Dynarmic::Jit& ji
            && interp_write_records == jit_write_records;
 }
 
-void FuzzJitArm(const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, const std::function<u32()> instruction_generator) {
+static bool FuzzJitArmBatch(const size_t worker_index, const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, std::function<u32()> instruction_generator) {
     // Prepare memory
     code_mem.fill(0xEAFFFFFE); // b +#0
 
@@ -235,7 +239,7 @@ void FuzzJitArm(const size_t instruction_count, const size_t instructions_to_exe
         jit.ExtRegs() = initial_extregs;
         jit.SetFpscr(initial_fpscr);
 
-        std::generate_n(code_mem.begin(), instruction_count, instruction_generator);
+        std::generate_n(code_mem.begin(), instruction_count, std::ref(instruction_generator));
 
         // Run interpreter
         write_records.clear();
@@ -254,6 +258,7 @@ void FuzzJitArm(const size_t instruction_count, const size_t instructions_to_exe
 
         // Compare
         if (!DoesBehaviorMatch(interp, jit, interp_write_records, jit_write_records)) {
+            std::lock_guard<std::mutex> lock{FuzzReportMutex()};
             printf("Failed at execution number %zu\n", run_number);
 
             printf("\nInstruction Listing: \n");
@@ -312,11 +317,21 @@ void FuzzJitArm(const size_t instruction_count, const size_t instructions_to_exe
 #ifdef __unix__
             raise(SIGTRAP);
 #endif
-            FAIL();
+            return false;
         }
 
-        if (run_number % 10 == 0) printf("%zu\r", run_number);
+        if (worker_index == 0 && run_number % 10 == 0) printf("%zu\r", run_number);
     }
+
+    return true;
+}
+
+void FuzzJitArm(const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, const std::function<u32()> instruction_generator) {
+    // Each worker gets its own copy of instruction_generator.
+    const bool passed = RunFuzzBatches(run_count, [&](size_t worker_index, size_t batch_run_count) {
+        return FuzzJitArmBatch(worker_index, instruction_count, instructions_to_execute_count, batch_run_count, instruction_generator);
+    });
+    REQUIRE(passed);
 }
 
 TEST_CASE( "arm: Optimization Failure (Randomized test case)", "[arm]" ) {
@@ -440,6 +455,30 @@ TEST_CASE( "arm: uasx (Edge-case)", "[arm]" ) {
     REQUIRE( jit.Cpsr() == 0x000301d0 );
 }
 
+TEST_CASE( "arm: cmp, movne, moveq, addsne", "[arm]" ) {
+    // Instructions with differing conditions are translated into one block.
+
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xe3500001; // cmp r0, #1
+    code_mem[1] = 0x13a01001; // movne r1, #1
+    code_mem[2] = 0x03a01002; // moveq r1, #2
+    code_mem[3] = 0x12922001; // addsne r2, r2, #1
+    code_mem[4] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 1;
+    jit.Regs()[2] = 0xffffffff;
+    jit.Regs()[15] = 0x00000000;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(5);
+
+    REQUIRE( jit.Regs()[1] == 2 );
+    REQUIRE( jit.Regs()[2] == 0xffffffff );
+    REQUIRE( jit.Regs()[15] == 0x00000010 );
+    REQUIRE( jit.Cpsr() == 0x600001d0 );
+}
+
 struct VfpTest {
     u32 initial_fpscr;
     u32 a;
@@ -448,6 +487,404 @@ struct VfpTest {
     u32 final_fpscr;
 };
 
+TEST_CASE("arm: subs, bne (loop)", "[arm]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xe2500001; // subs r0, r0, #1
+    code_mem[1] = 0x1afffffd; // bne -#12
+    code_mem[2] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 5;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(20);
+
+    REQUIRE( jit.Regs()[0] == 0 );
+    REQUIRE( jit.Regs()[15] == 8 );
+    REQUIRE( jit.Cpsr() == 0x600001d0 ); // Z, C
+}
+
+TEST_CASE("arm: loop over two blocks (passing registers across links)", "[arm]") {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.pass_registers_across_links = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xe0811000; // add r1, r1, r0
+    code_mem[1] = 0xeaffffff; // b +#0
+    code_mem[2] = 0xe2500001; // subs r0, r0, #1
+    code_mem[3] = 0x1afffffb; // bne -#20
+    code_mem[4] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 5;
+    jit.Regs()[1] = 0;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(40);
+
+    REQUIRE( jit.Regs()[0] == 0 );
+    REQUIRE( jit.Regs()[1] == 15 );
+    REQUIRE( jit.Regs()[15] == 16 );
+}
+
+TEST_CASE("arm: ldrex, strex through the page table", "[arm]") {
+    static std::array<u8, 0x1000> memory;
+    memory.fill(0);
+    memory[0] = 42;
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[1] = memory.data();
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xe3a01a01; // mov r1, #0x1000
+    code_mem[1] = 0xe1910f9f; // ldrex r0, [r1]
+    code_mem[2] = 0xe2800001; // add r0, r0, #1
+    code_mem[3] = 0xe1812f90; // strex r2, r0, [r1]
+    code_mem[4] = 0xe1813f90; // strex r3, r0, [r1]
+    code_mem[5] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    write_records.clear();
+    jit.Run(6);
+
+    REQUIRE( jit.Regs()[0] == 43 );
+    REQUIRE( jit.Regs()[2] == 0 );
+    REQUIRE( jit.Regs()[3] == 1 ); // No longer exclusive
+    REQUIRE( memory[0] == 43 );
+    REQUIRE( write_records.empty() );
+}
+
+TEST_CASE("vfp: vldm, vstm of register pairs through the page table", "[vfp]") {
+    static std::array<u8, 0x1000> memory;
+    memory.fill(0);
+    for (size_t i = 0; i < 32; i++) {
+        memory[i] = static_cast<u8>(i);
+    }
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[1] = memory.data();
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xec900b08; // vldmia r0, {d0-d3}
+    code_mem[1] = 0xec810b08; // vstmia r1, {d0-d3}
+    code_mem[2] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 0x1000;
+    jit.Regs()[1] = 0x1020;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    write_records.clear();
+    jit.Run(3);
+
+    REQUIRE( jit.ExtRegs()[0] == 0x03020100 );
+    REQUIRE( jit.ExtRegs()[7] == 0x1F1E1D1C );
+    REQUIRE( std::equal(memory.begin(), memory.begin() + 32, memory.begin() + 32) );
+    REQUIRE( write_records.empty() );
+}
+
+TEST_CASE("arm: loads through the page table of each address space", "[arm]") {
+    static std::array<u8, 0x1000> memory_a;
+    static std::array<u8, 0x1000> memory_b;
+    memory_a.fill(0);
+    memory_b.fill(0);
+    memory_a[0] = 1;
+    memory_b[0] = 2;
+    auto page_table_a = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    auto page_table_b = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table_a->fill(nullptr);
+    page_table_b->fill(nullptr);
+    (*page_table_a)[1] = memory_a.data();
+    (*page_table_b)[1] = memory_b.data();
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table_a.get();
+    callbacks.address_space_count = 2;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xe3a01a01; // mov r1, #0x1000
+    code_mem[1] = 0xe5910000; // ldr r0, [r1]
+    code_mem[2] = 0xeafffffe; // b +#0
+
+    const auto run = [&jit] {
+        jit.Regs()[0] = 0;
+        jit.Regs()[15] = 0;
+        jit.Cpsr() = 0x000001d0; // User-mode
+        jit.Run(2);
+        return jit.Regs()[0];
+    };
+
+    REQUIRE( run() == 1 );
+    jit.SetAddressSpace(1, page_table_b.get());
+    REQUIRE( jit.GetAddressSpace() == 1 );
+    REQUIRE( run() == 2 );
+    jit.SetAddressSpace(0, page_table_a.get());
+    REQUIRE( run() == 1 );
+}
+
+TEST_CASE("arm: inline cycle counter", "[arm]") {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.inline_cycle_counter = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xee191f1d; // mrc p15, 0, r1, c9, c13, 0
+    code_mem[1] = 0xe3a00001; // mov r0, #1
+    code_mem[2] = 0xee192f1d; // mrc p15, 0, r2, c9, c13, 0
+    code_mem[3] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+    jit.SetCycleCounter(100);
+
+    jit.Run(4);
+
+    REQUIRE( jit.Regs()[1] == 100 );
+    REQUIRE( jit.Regs()[2] == 102 );
+    REQUIRE( jit.GetCycleCounter() == 104 );
+}
+
+TEST_CASE("arm: trace leaving through a side exit", "[arm]") {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.hot_block_threshold = 2;
+    callbacks.trace_instruction_budget = 32;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xe3a00000; // mov r0, #0
+    code_mem[1] = 0xe3a01000; // mov r1, #0
+    code_mem[2] = 0xe2800001; // add r0, r0, #1
+    code_mem[3] = 0xe3500014; // cmp r0, #20
+    code_mem[4] = 0xca000000; // bgt +#0
+    code_mem[5] = 0xe2811001; // add r1, r1, #1
+    code_mem[6] = 0xe3500028; // cmp r0, #40
+    code_mem[7] = 0xbafffff9; // blt -#20
+    code_mem[8] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    // The trace from the loop head records bgt as not taken, until r0 passes 20.
+    jit.Run(500);
+
+    REQUIRE( jit.Regs()[0] == 40 );
+    REQUIRE( jit.Regs()[1] == 20 );
+    REQUIRE( jit.Regs()[15] == 32 );
+}
+
+TEST_CASE("arm: call profile of a guest function", "[arm]") {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.profile_guest_calls = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xe3a00003; // mov r0, #3
+    code_mem[1] = 0xeb000002; // bl +#8
+    code_mem[2] = 0xe2500001; // subs r0, r0, #1
+    code_mem[3] = 0x1afffffc; // bne -#16
+    code_mem[4] = 0xeafffffe; // b +#0
+    code_mem[5] = 0xe2811001; // add r1, r1, #1
+    code_mem[6] = 0xe12fff1e; // bx lr
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(100);
+
+    REQUIRE( jit.Regs()[1] == 3 );
+    const auto profile = jit.GetCallProfile();
+    REQUIRE( profile.size() == 1 );
+    REQUIRE( profile[0].entry == 20 );
+    REQUIRE( profile[0].calls == 3 );
+    // Each call counts from the bl to the bx lr.
+    REQUIRE( profile[0].inclusive_cycles == 6 );
+    REQUIRE( profile[0].exclusive_cycles == 6 );
+
+    jit.ResetCallProfile();
+    REQUIRE( jit.GetCallProfile().empty() );
+}
+
+TEST_CASE("arm: Executor runs cores until they wait for an interrupt", "[arm]") {
+    Dynarmic::Executor executor{2};
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.user_arg = &executor;
+    callbacks.CallHint = [](Dynarmic::Hint hint, Dynarmic::Jit* jit, void* user_arg) {
+        if (hint == Dynarmic::Hint::WaitForInterrupt)
+            static_cast<Dynarmic::Executor*>(user_arg)->Sleep(*jit);
+    };
+    code_mem.fill({});
+    code_mem[0] = 0xe2500001; // subs r0, r0, #1
+    code_mem[1] = 0x1afffffd; // bne -#12
+    code_mem[2] = 0xe320f003; // wfi
+    code_mem[3] = 0xeafffffe; // b +#0
+
+    Dynarmic::Jit first_core{callbacks};
+    std::vector<std::unique_ptr<Dynarmic::Jit>> cores;
+    for (size_t i = 0; i < 4; i++) {
+        cores.push_back(std::make_unique<Dynarmic::Jit>(callbacks, first_core));
+        cores.back()->Regs()[0] = static_cast<u32>(100 * (i + 1));
+        cores.back()->Regs()[15] = 0;
+        cores.back()->Cpsr() = 0x000001d0; // User-mode
+        executor.Add(*cores.back(), 16);
+    }
+    executor.WaitIdle();
+
+    for (const auto& core : cores) {
+        REQUIRE( core->Regs()[0] == 0 );
+        REQUIRE( core->Regs()[15] == 12 );
+        executor.Remove(*core);
+    }
+}
+
+TEST_CASE("arm: ARMv7 bitfield, divide and reversal instructions", "[arm]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xe3050678;  // movw r0, #0x5678
+    code_mem[1] = 0xe3410234;  // movt r0, #0x1234
+    code_mem[2] = 0xe3a01007;  // mov r1, #7
+    code_mem[3] = 0xe732f110;  // udiv r2, r0, r1
+    code_mem[4] = 0xe3a03000;  // mov r3, #0
+    code_mem[5] = 0xe714f310;  // sdiv r4, r0, r3
+    code_mem[6] = 0xe6ff5f30;  // rbit r5, r0
+    code_mem[7] = 0xe7e76250;  // ubfx r6, r0, #4, #8
+    code_mem[8] = 0xe3e07000;  // mvn r7, #0
+    code_mem[9] = 0xe7cb7411;  // bfi r7, r1, #8, #4
+    code_mem[10] = 0xe7a38650; // sbfx r8, r0, #12, #4
+    code_mem[11] = 0xe0690291; // mls r9, r1, r2, r0
+    code_mem[12] = 0xf57ff05b; // dmb ish
+    code_mem[13] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(14);
+
+    REQUIRE( jit.Regs()[0] == 0x12345678 );
+    REQUIRE( jit.Regs()[2] == 0x12345678 / 7 );
+    REQUIRE( jit.Regs()[4] == 0 ); // Division by zero gives zero
+    REQUIRE( jit.Regs()[5] == 0x1E6A2C48 );
+    REQUIRE( jit.Regs()[6] == 0x67 );
+    REQUIRE( jit.Regs()[7] == 0xFFFFF7FF );
+    REQUIRE( jit.Regs()[8] == 5 );
+    REQUIRE( jit.Regs()[9] == 0x12345678 % 7 );
+    REQUIRE( jit.Regs()[15] == 0x34 );
+}
+
+TEST_CASE("arm: banked registers across an exception and its return", "[arm]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xe3a00001; // mov r0, #1
+    code_mem[1] = 0xeafffffe; // b +#0
+    code_mem[8] = 0xe1a0100d; // mov r1, sp
+    code_mem[9] = 0xe25ef004; // subs pc, lr, #4
+
+    jit.Regs()[13] = 0x1000;
+    jit.Regs()[14] = 0x1111;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.SetMode(0x13); // Supervisor
+    jit.Regs()[13] = 0x2000;
+    jit.SetMode(0x10); // User
+
+    REQUIRE( jit.Regs()[13] == 0x1000 );
+    REQUIRE( jit.Regs()[14] == 0x1111 );
+
+    jit.TakeException(0x13, 0x20, 4);
+
+    REQUIRE( jit.Cpsr() == 0x000001d3 ); // Supervisor-mode
+    REQUIRE( jit.Spsr() == 0x000001d0 );
+    REQUIRE( jit.Regs()[13] == 0x2000 );
+    REQUIRE( jit.Regs()[14] == 4 );
+    REQUIRE( jit.Regs()[15] == 0x20 );
+
+    // The exception return restores CPSR from SPSR and switches back to the User registers.
+    jit.Run(4);
+
+    REQUIRE( jit.Regs()[0] == 1 );
+    REQUIRE( jit.Regs()[1] == 0x2000 );
+    REQUIRE( jit.Regs()[13] == 0x1000 );
+    REQUIRE( jit.Regs()[14] == 0x1111 );
+    REQUIRE( jit.Regs()[15] == 4 );
+    REQUIRE( jit.Cpsr() == 0x000001d0 ); // User-mode
+}
+
+TEST_CASE("vfp: vmov between single- and double-precision views of a register", "[vfp]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xee000a10; // vmov.32 s0, r0
+    code_mem[1] = 0xee001a90; // vmov.32 s1, r1
+    code_mem[2] = 0xec532b10; // vmov r2, r3, d0
+    code_mem[3] = 0xeeb01b40; // vmov.f64 d1, d0
+    code_mem[4] = 0xee114a10; // vmov.32 r4, s2
+    code_mem[5] = 0xee115a90; // vmov.32 r5, s3
+    code_mem[6] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 0x11111111;
+    jit.Regs()[1] = 0x22222222;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(7);
+
+    REQUIRE( jit.Regs()[2] == 0x11111111 );
+    REQUIRE( jit.Regs()[3] == 0x22222222 );
+    REQUIRE( jit.Regs()[4] == 0x11111111 );
+    REQUIRE( jit.Regs()[5] == 0x22222222 );
+    REQUIRE( jit.ExtRegs()[2] == 0x11111111 );
+    REQUIRE( jit.ExtRegs()[3] == 0x22222222 );
+}
+
+TEST_CASE("vfp: vcmp, vmrs APSR_nzcv and a conditional branch", "[vfp]") {
+    struct Operands {
+        u32 a;
+        u32 b;
+        u32 nzcv;
+    };
+    const std::array<Operands, 4> operands {{
+        {0x3f800000, 0x3f800000, 0b0110}, // equal
+        {0x3f800000, 0x40000000, 0b1000}, // less
+        {0x40000000, 0x3f800000, 0b0010}, // greater
+        {0x7fc00000, 0x3f800000, 0b0011}, // unordered
+    }};
+    const auto condition_passed = [](u32 cond, u32 nzcv) {
+        const bool n = (nzcv & 8) != 0, z = (nzcv & 4) != 0, c = (nzcv & 2) != 0, v = (nzcv & 1) != 0;
+        const std::array<bool, 14> passed {{z, !z, c, !c, n, !n, v, !v, c && !z, !c || z, n == v, n != v, !z && n == v, z || n != v}};
+        return passed[cond];
+    };
+
+    for (u32 cond = 0; cond < 14; cond++) {
+        Dynarmic::Jit jit{GetUserCallbacks()};
+        code_mem.fill({});
+        code_mem[0] = 0xeeb40a60; // vcmp.f32 s0, s1
+        code_mem[1] = 0xeef1fa10; // vmrs APSR_nzcv, fpscr
+        code_mem[2] = (cond << 28) | 0x0a000001; // b<cond> +#4
+        code_mem[3] = 0xe3a00000; // mov r0, #0
+        code_mem[4] = 0xeafffffe; // b +#0
+        code_mem[5] = 0xe3a00001; // mov r0, #1
+        code_mem[6] = 0xeafffffe; // b +#0
+
+        for (const auto& test : operands) {
+            jit.Regs()[0] = 2;
+            jit.Regs()[15] = 0;
+            jit.Cpsr() = 0x000001d0; // User-mode
+            jit.ExtRegs()[0] = test.a;
+            jit.ExtRegs()[1] = test.b;
+
+            jit.Run(5);
+
+            REQUIRE( jit.Regs()[0] == (condition_passed(cond, test.nzcv) ? 1 : 0) );
+            REQUIRE( (jit.Cpsr() >> 28) == test.nzcv );
+        }
+    }
+}
+
 TEST_CASE("vfp: vadd", "[vfp]") {
     Dynarmic::Jit jit{GetUserCallbacks()};
     code_mem.fill({});
@@ -476,6 +913,108 @@ TEST_CASE("vfp: vadd", "[vfp]") {
     }
 }
 
+TEST_CASE("vfp: vadd (short vector)", "[vfp]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xee386a0c; // vadd.f32 s12, s16, s24
+    code_mem[1] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+    jit.ExtRegs().fill(0);
+    jit.ExtRegs()[16] = 0x3f800000; // 1.0
+    jit.ExtRegs()[18] = 0x40000000; // 2.0
+    jit.ExtRegs()[20] = 0x40400000; // 3.0
+    jit.ExtRegs()[22] = 0x40800000; // 4.0
+    jit.ExtRegs()[24] = jit.ExtRegs()[26] = jit.ExtRegs()[28] = jit.ExtRegs()[30] = 0x3f000000; // 0.5
+    jit.SetFpscr(0x00330000); // LEN = 4, STRIDE = 2
+
+    jit.Run(2);
+
+    // The destination wraps around within its bank: s12, s14, s8, s10.
+    REQUIRE( jit.ExtRegs()[12] == 0x3fc00000 );
+    REQUIRE( jit.ExtRegs()[14] == 0x40200000 );
+    REQUIRE( jit.ExtRegs()[8] == 0x40600000 );
+    REQUIRE( jit.ExtRegs()[10] == 0x40900000 );
+    REQUIRE( jit.ExtRegs()[9] == 0 );
+    REQUIRE( jit.ExtRegs()[11] == 0 );
+    REQUIRE( jit.ExtRegs()[13] == 0 );
+    REQUIRE( jit.ExtRegs()[15] == 0 );
+    REQUIRE( jit.Regs()[15] == 4 );
+    REQUIRE( jit.Fpscr() == 0x00330000 );
+}
+
+TEST_CASE("arm: Flags set by consecutive instructions", "[arm]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xe0900001; // adds r0, r0, r1
+    code_mem[1] = 0xe0122003; // ands r2, r2, r3
+    code_mem[2] = 0xe0140695; // muls r4, r5, r6
+    code_mem[3] = 0xeafffffe; // b +#0
+
+    jit.Regs()[0] = 0x80000000;
+    jit.Regs()[1] = 0x80000000;
+    jit.Regs()[2] = 0xF0;
+    jit.Regs()[3] = 0x0F;
+    jit.Regs()[5] = 2;
+    jit.Regs()[6] = 3;
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+
+    jit.Run(4);
+
+    REQUIRE( jit.Regs()[0] == 0 );
+    REQUIRE( jit.Regs()[2] == 0 );
+    REQUIRE( jit.Regs()[4] == 6 );
+    REQUIRE( jit.Regs()[15] == 12 );
+    // N and Z come from muls, C from ands (the shifter carry, which is the carry from adds) and V from adds.
+    REQUIRE( jit.Cpsr() == 0x300001d0 );
+}
+
+TEST_CASE("vfp: vfma (fused)", "[vfp]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xeea00a81; // vfma.f32 s0, s1, s2
+    code_mem[1] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+    jit.ExtRegs().fill(0);
+    jit.ExtRegs()[0] = 0xbf800000; // -1.0
+    jit.ExtRegs()[1] = 0x3f800001; // 1 + 2^-23
+    jit.ExtRegs()[2] = 0x3f7ffffe; // 1 - 2^-23
+    jit.SetFpscr(0);
+
+    jit.Run(2);
+
+    // A separate multiply would round the product to 1.0, giving 0.0 instead.
+    REQUIRE( jit.ExtRegs()[0] == 0xa8800000 ); // -2^-46
+    REQUIRE( jit.Regs()[15] == 4 );
+}
+
+TEST_CASE("asimd: vadd.i32 q0, q1, q2", "[asimd]") {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xf2220844; // vadd.i32 q0, q1, q2
+    code_mem[1] = 0xeafffffe; // b +#0
+
+    jit.Regs()[15] = 0;
+    jit.Cpsr() = 0x000001d0; // User-mode
+    jit.ExtRegs().fill(0);
+    for (size_t i = 0; i < 4; i++) {
+        jit.ExtRegs()[4 + i] = static_cast<u32>(i + 1);
+        jit.ExtRegs()[8 + i] = 0xFFFFFFFF;
+    }
+
+    jit.Run(2);
+
+    REQUIRE( jit.ExtRegs()[0] == 0 );
+    REQUIRE( jit.ExtRegs()[1] == 1 );
+    REQUIRE( jit.ExtRegs()[2] == 2 );
+    REQUIRE( jit.ExtRegs()[3] == 3 );
+    REQUIRE( jit.Regs()[15] == 4 );
+}
+
 TEST_CASE("VFP: VMOV", "[JitX64][vfp]") {
     const auto is_valid = [](u32 instr) -> bool {
         return Bits<0, 6>(instr) != 0b111111
@@ -637,6 +1176,49 @@ TEST_CASE("Fuzz ARM data processing instructions", "[JitX64]") {
     }
 }
 
+TEST_CASE("Fuzz ARM carry chains (ADDS/ADC, SUBS/SBC, RSBS/RSC)", "[JitX64]") {
+    const auto is_valid = [](u32 inst) -> bool {
+        // R15 as Rd would branch.
+        return Bits<12, 15>(inst) != 0b1111;
+    };
+
+    // The first of each pair sets C and the second consumes it, so CarryChainFusion emits them together.
+    const std::array<std::array<InstructionGenerator, 2>, 6> pairs = {{
+        {{InstructionGenerator("cccc00101001nnnnddddrrrrvvvvvvvv", is_valid), InstructionGenerator("cccc0010101Snnnnddddrrrrvvvvvvvv", is_valid)}}, // ADDS, ADC (imm)
+        {{InstructionGenerator("cccc00001001nnnnddddvvvvvrr0mmmm", is_valid), InstructionGenerator("cccc0000101Snnnnddddvvvvvrr0mmmm", is_valid)}}, // ADDS, ADC (reg)
+        {{InstructionGenerator("cccc00100101nnnnddddrrrrvvvvvvvv", is_valid), InstructionGenerator("cccc0010110Snnnnddddrrrrvvvvvvvv", is_valid)}}, // SUBS, SBC (imm)
+        {{InstructionGenerator("cccc00000101nnnnddddvvvvvrr0mmmm", is_valid), InstructionGenerator("cccc0000110Snnnnddddvvvvvrr0mmmm", is_valid)}}, // SUBS, SBC (reg)
+        {{InstructionGenerator("cccc00100111nnnnddddrrrrvvvvvvvv", is_valid), InstructionGenerator("cccc0010111Snnnnddddrrrrvvvvvvvv", is_valid)}}, // RSBS, RSC (imm)
+        {{InstructionGenerator("cccc00000111nnnnddddvvvvvrr0mmmm", is_valid), InstructionGenerator("cccc0000111Snnnnddddvvvvvrr0mmmm", is_valid)}}, // RSBS, RSC (reg)
+    }};
+    // Leaves the flags alone, but may overwrite an operand of the second half.
+    const InstructionGenerator mov_imm("cccc001110100000ddddrrrrvvvvvvvv", is_valid);
+
+    // Emits the halves of random pairs, one time in four with a MOV between them.
+    const auto instruction_select = [&pairs, &mov_imm, pair = size_t(0), step = 0]() mutable -> u32 {
+        switch (step) {
+        case 0:
+            pair = RandInt<size_t>(0, pairs.size() - 1);
+            step = RandInt(1, 4) == 1 ? 1 : 2;
+            return pairs[pair][0].Generate();
+        case 1:
+            step = 2;
+            return mov_imm.Generate();
+        default:
+            step = 0;
+            return pairs[pair][1].Generate();
+        }
+    };
+
+    SECTION("short blocks") {
+        FuzzJitArm(6, 7, 10000, instruction_select);
+    }
+
+    SECTION("long blocks") {
+        FuzzJitArm(1024, 1025, 200, instruction_select);
+    }
+}
+
 TEST_CASE("Fuzz ARM load/store instructions (byte, half-word, word)", "[JitX64]") {
     auto EXD_valid = [](u32 inst) -> bool {
         return Bits<0, 3>(inst) % 2 == 0 && Bits<0, 3>(inst) != 14 && Bits<12, 15>(inst) != (Bits<0, 3>(inst) + 1);
@@ -1079,8 +1661,7 @@ TEST_CASE("Test ARM misc instructions", "[JitX64]") {
 
     SECTION("Fuzz SEL") {
         // Alternate between a SEL and a MSR to change the CPSR, thus changing the expected result of the next SEL
-        bool set_cpsr = true;
-        FuzzJitArm(5, 6, 10000, [&sel_instr, &cpsr_setter, &set_cpsr]() -> u32 {
+        FuzzJitArm(5, 6, 10000, [&sel_instr, &cpsr_setter, set_cpsr = true]() mutable -> u32 {
             set_cpsr ^= true;
             if (set_cpsr)
                 return cpsr_setter.Generate(false);
@@ -10,6 +10,7 @@
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <mutex>
 #include <tuple>
 
 #include <catch.hpp>
@@ -22,6 +23,7 @@
 #include "frontend/ir/basic_block.h"
 #include "frontend/translate/translate.h"
 #include "ir_opt/passes.h"
+#include "parallel_fuzz.h"
 #include "rand_int.h"
 #include "skyeye_interpreter/dyncom/arm_dyncom_interpreter.h"
 #include "skyeye_interpreter/skyeye_common/armstate.h"
@@ -36,8 +38,9 @@ static bool operator==(const WriteRecord& a, const WriteRecord& b) {
     return std::tie(a.size, a.address, a.data) == std::tie(b.size, b.address, b.data);
 }
 
-static std::array<u16, 3000> code_mem{};
-static std::vector<WriteRecord> write_records;
+// Each fuzzing thread has its own guest memory.
+static thread_local std::array<u16, 3000> code_mem{};
+static thread_local std::vector<WriteRecord> write_records;
 
 static bool IsReadOnlyMemory(u32 vaddr);
 static u8 MemoryRead8(u32 vaddr);
@@ -179,7 +182,7 @@ static bool DoesBehaviorMatch(const ARMul_State& interp, const Dynarmic::Jit& ji
             && interp_write_records == jit_write_records;
 }
 
-void FuzzJitThumb(const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, const std::function<u16()> instruction_generator) {
+static bool FuzzJitThumbBatch(const size_t worker_index, const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, std::function<u16()> instruction_generator) {
     // Prepare memory
     code_mem.fill(0xE7FE); // b +#0
 
@@ -204,7 +207,7 @@ void FuzzJitThumb(const size_t instruction_count, const size_t instructions_to_e
         jit.Cpsr() = 0x000001F0;
         jit.Regs() = initial_regs;
 
-        std::generate_n(code_mem.begin(), instruction_count, instruction_generator);
+        std::generate_n(code_mem.begin(), instruction_count, std::ref(instruction_generator));
 
         // Run interpreter
         write_records.clear();
@@ -223,6 +226,7 @@ void FuzzJitThumb(const size_t instruction_count, const size_t instructions_to_e
 
         // Compare
         if (!DoesBehaviorMatch(interp, jit, interp_write_records, jit_write_records)) {
+            std::lock_guard<std::mutex> lock{FuzzReportMutex()};
             printf("Failed at execution number %zu\n", run_number);
 
             printf("\nInstruction Listing: \n");
@@ -264,11 +268,21 @@ void FuzzJitThumb(const size_t instruction_count, const size_t instructions_to_e
 #ifdef _MSC_VER
             __debugbreak();
 #endif
-            FAIL();
+            return false;
         }
 
-        if (run_number % 10 == 0) printf("%zu\r", run_number);
+        if (worker_index == 0 && run_number % 10 == 0) printf("%zu\r", run_number);
     }
+
+    return true;
+}
+
+void FuzzJitThumb(const size_t instruction_count, const size_t instructions_to_execute_count, const size_t run_count, const std::function<u16()> instruction_generator) {
+    // Each worker gets its own copy of instruction_generator.
+    const bool passed = RunFuzzBatches(run_count, [&](size_t worker_index, size_t batch_run_count) {
+        return FuzzJitThumbBatch(worker_index, instruction_count, instructions_to_execute_count, batch_run_count, instruction_generator);
+    });
+    REQUIRE(passed);
 }
 
 TEST_CASE("Fuzz Thumb instructions set 1", "[JitX64][Thumb]") {
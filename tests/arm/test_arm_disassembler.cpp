@@ -345,7 +345,7 @@ TEST_CASE("Disassemble multiply and multiply accumulate instructions", "[arm][di
     REQUIRE(DisassembleArm(0xE0010392) == "mul r1, r2, r3");
     REQUIRE(DisassembleArm(0xE0110392) == "muls r1, r2, r3");
 
-    // TODO: MLS should be here whenever it's supported.
+    REQUIRE(DisassembleArm(0xE0614392) == "mls r1, r2, r3, r4");
 
     REQUIRE(DisassembleArm(0xE0E21493) == "smlal r1, r2, r3, r4");
     REQUIRE(DisassembleArm(0xE0F21493) == "smlals r1, r2, r3, r4");
@@ -4,6 +4,15 @@
  * General Public License version 2 or any later version.
  */
 
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 #include <catch.hpp>
 
 #include <dynarmic/dynarmic.h>
@@ -174,3 +183,1174 @@ TEST_CASE( "thumb: bl -#42", "[thumb]" ) {
     REQUIRE( jit.Regs()[15] == 0xFFFFFFD6 );
     REQUIRE( jit.Cpsr() == 0x00000030 ); // Thumb, User-mode
 }
+
+TEST_CASE( "thumb: movw, movt, add.w", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0xF245; code_mem[1] = 0x6078; // movw r0, #0x5678
+    code_mem[2] = 0xF2C1; code_mem[3] = 0x2034; // movt r0, #0x1234
+    code_mem[4] = 0xEB00; code_mem[5] = 0x0140; // add.w r1, r0, r0, lsl #1
+    code_mem[6] = 0xE7FE; // b +#0
+
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(3);
+
+    REQUIRE( jit.Regs()[0] == 0x12345678 );
+    REQUIRE( jit.Regs()[1] == 0x369D0368 );
+    REQUIRE( jit.Regs()[15] == 12 );
+    REQUIRE( jit.Cpsr() == 0x00000030 ); // Thumb, User-mode
+}
+
+TEST_CASE( "thumb: cmp.w, bne.w loop", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x2000; // movs r0, #0
+    code_mem[1] = 0x3001; // adds r0, #1
+    code_mem[2] = 0xF1B0; code_mem[3] = 0x0F05; // cmp.w r0, #5
+    code_mem[4] = 0xF47F; code_mem[5] = 0xAFFC; // bne.w -#8
+    code_mem[6] = 0xE7FE; // b +#0
+
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(16);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.Regs()[15] == 10 );
+    REQUIRE( (jit.Cpsr() & 0x40000000) != 0 ); // Z
+}
+
+TEST_CASE( "thumb: ite eq, itt ne", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x2800; // cmp r0, #0
+    code_mem[1] = 0xBF0C; // ite eq
+    code_mem[2] = 0x2101; // moveq r1, #1
+    code_mem[3] = 0x2102; // movne r1, #2
+    code_mem[4] = 0xBF1C; // itt ne
+    code_mem[5] = 0x681A; // ldrne r2, [r3]
+    code_mem[6] = 0x3201; // addne r2, #1
+    code_mem[7] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[2] = 7;
+    jit.Regs()[3] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(16);
+
+    REQUIRE( jit.Regs()[1] == 1 );
+    REQUIRE( jit.Regs()[2] == 7 );
+    REQUIRE( jit.Regs()[15] == 14 );
+    REQUIRE( (jit.Cpsr() & 0x0600FC00) == 0 ); // IT
+    REQUIRE( (jit.Cpsr() & 0x40000000) != 0 ); // Z
+}
+
+TEST_CASE( "thumb: InvalidateCacheRange", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x0088; // lsls r0, r1, #2
+    code_mem[1] = 0xE7FE; // b +#0
+
+    jit.Regs()[1] = 1;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    REQUIRE( jit.Regs()[0] == 4 );
+    REQUIRE( jit.Regs()[15] == 2 );
+
+    code_mem[0] = 0x07C8; // lsls r0, r1, #31
+    jit.InvalidateCacheRange(0, 2);
+
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    REQUIRE( jit.Regs()[0] == 0x80000000 );
+    REQUIRE( jit.Regs()[15] == 2 );
+}
+
+TEST_CASE( "thumb: GetMemoryUsage, CompactCodeCache", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x0088; // lsls r0, r1, #2
+    code_mem[1] = 0xE7FE; // b +#0
+
+    jit.Regs()[1] = 1;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    const Dynarmic::JitMemoryUsage usage = jit.GetMemoryUsage();
+    REQUIRE( usage.block_count == 1 );
+    REQUIRE( usage.constant_bytes != 0 );
+    REQUIRE( usage.prelude_bytes >= usage.constant_bytes );
+    REQUIRE( usage.code_space_used > usage.prelude_bytes );
+    REQUIRE( usage.code_space_reserved > usage.code_space_used );
+
+    jit.InvalidateCacheRange(0, 2);
+    jit.CompactCodeCache();
+    REQUIRE( jit.GetMemoryUsage().block_count == 0 );
+
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    REQUIRE( jit.Regs()[0] == 4 );
+    REQUIRE( jit.Regs()[15] == 2 );
+    REQUIRE( jit.GetMemoryUsage().block_count == 1 );
+}
+
+TEST_CASE( "thumb: count_exits", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.count_exits = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+    jit.Run(10);
+
+    const auto exits = jit.GetStatistics().exits;
+    REQUIRE( jit.Regs()[0] == 10 );
+    REQUIRE( exits[static_cast<size_t>(Dynarmic::ExitReason::CycleBudget)] == 2 );
+    REQUIRE( exits[static_cast<size_t>(Dynarmic::ExitReason::Halt)] == 0 );
+    REQUIRE( exits[static_cast<size_t>(Dynarmic::ExitReason::Unlinked)] == 0 );
+}
+
+TEST_CASE( "thumb: measure_latency", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.measure_latency = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[1] = 0x100;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+    jit.Run(10);
+
+    const auto total = [](const Dynarmic::LatencyHistogram& histogram) {
+        u64 count = 0;
+        for (u64 bucket_count : histogram.counts)
+            count += bucket_count;
+        return count;
+    };
+    const Dynarmic::JitStatistics statistics = jit.GetStatistics();
+    REQUIRE( jit.Regs()[0] == 0x100 );
+    REQUIRE( total(statistics.run_entry) == 2 );
+    REQUIRE( total(statistics.dispatch_misses) == 1 );
+    REQUIRE( total(statistics.dispatch_hits) >= 1 );
+    REQUIRE( total(statistics.callbacks[static_cast<size_t>(Dynarmic::CallbackKind::Memory)]) != 0 );
+    REQUIRE( total(statistics.callbacks[static_cast<size_t>(Dynarmic::CallbackKind::Supervisor)]) == 0 );
+    REQUIRE( statistics.tsc_frequency != 0 );
+}
+
+TEST_CASE( "thumb: JitConfig max_block_instructions", "[thumb]" ) {
+    Dynarmic::JitConfig config{Dynarmic::OptimizationLevel::Balanced};
+    config.max_block_instructions = 1;
+    Dynarmic::Jit jit{config.ApplyTo(GetUserCallbacks())};
+    code_mem.fill({});
+    code_mem[0] = 0x2001; // movs r0, #1
+    code_mem[1] = 0x3002; // adds r0, #2
+    code_mem[2] = 0x3003; // adds r0, #3
+    code_mem[3] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(3);
+
+    REQUIRE( jit.Regs()[0] == 6 );
+    REQUIRE( jit.Regs()[15] == 6 );
+    REQUIRE( jit.GetMemoryUsage().block_count == 3 );
+}
+
+TEST_CASE( "thumb: hot block retranslation", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.hot_block_threshold = 2;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.Regs()[15] == 0 );
+}
+
+TEST_CASE( "thumb: warm start from hot blocks", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.hot_block_threshold = 2;
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    std::vector<Dynarmic::HotBlockRecord> hot_blocks;
+    {
+        Dynarmic::Jit jit{callbacks};
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(10);
+        hot_blocks = jit.GetHotBlocks();
+    }
+    REQUIRE( hot_blocks.size() == 1 );
+
+    Dynarmic::Jit jit{callbacks};
+    jit.PrecompileHotBlocks(hot_blocks);
+    REQUIRE( jit.GetStatistics().blocks_translated == 1 );
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.GetStatistics().cache_misses == 0 );
+    REQUIRE( jit.GetHotBlocks().size() == 1 );
+}
+
+TEST_CASE( "thumb: specialize_register_values", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.hot_block_threshold = 2;
+    callbacks.specialize_register_values = true;
+    callbacks.count_exits = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x1C48; // adds r0, r1, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[1] = 5;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 6 );
+
+    jit.Regs()[1] = 7;
+    jit.Run(10);
+
+    const auto exits = jit.GetStatistics().exits;
+    REQUIRE( jit.Regs()[0] == 8 );
+    REQUIRE( exits[static_cast<size_t>(Dynarmic::ExitReason::RegisterGuard)] == 1 );
+}
+
+TEST_CASE( "thumb: RunInstructions", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0x3001; // adds r0, #1
+    code_mem[2] = 0x3001; // adds r0, #1
+    code_mem[3] = 0xE7FB; // b -#10
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    REQUIRE( jit.Step() );
+    REQUIRE( jit.Regs()[0] == 1 );
+    REQUIRE( jit.Regs()[15] == 2 );
+
+    REQUIRE( jit.RunInstructions(5) == 5 );
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.Regs()[15] == 4 );
+    REQUIRE( jit.GetCycleCounter() == 6 );
+    REQUIRE( jit.GetStatistics().cache_misses == 0 );
+
+    jit.Run(1);
+
+    REQUIRE( jit.Regs()[0] == 6 );
+    REQUIRE( jit.Regs()[15] == 0 );
+}
+
+TEST_CASE( "thumb: superblock across b", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.superblock_instruction_budget = 16;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xE000; // b +#0
+    code_mem[1] = 0x07C8; // lsls r0, r1, #31 (skipped)
+    code_mem[2] = 0x3001; // adds r0, #1
+    code_mem[3] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[1] = 1;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(3);
+
+    REQUIRE( jit.Regs()[0] == 1 );
+    REQUIRE( jit.Regs()[15] == 6 );
+
+    code_mem[2] = 0x3002; // adds r0, #2
+    jit.InvalidateCacheRange(4, 2);
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(3);
+
+    REQUIRE( jit.Regs()[0] == 2 );
+    REQUIRE( jit.Regs()[15] == 6 );
+}
+
+TEST_CASE( "thumb: background translation", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.background_translation = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    // Whether each iteration is interpreted or run as a translated block depends on timing,
+    // but the result must not.
+    for (int i = 0; i < 100; i++) {
+        jit.Run(10);
+    }
+
+    REQUIRE( jit.Regs()[0] == 500 );
+    REQUIRE( jit.Regs()[15] == 0 );
+}
+
+TEST_CASE( "thumb: shared code cache", "[thumb]" ) {
+    Dynarmic::Jit jit0{GetUserCallbacks()};
+    Dynarmic::Jit jit1{GetUserCallbacks(), jit0};
+    code_mem.fill({});
+    code_mem[0] = 0x0088; // lsls r0, r1, #2
+    code_mem[1] = 0xE7FE; // b +#0
+
+    jit0.Regs()[1] = 1;
+    jit0.Regs()[15] = 0; // PC = 0
+    jit0.Cpsr() = 0x00000030; // Thumb, User-mode
+    jit1.Regs()[1] = 2;
+    jit1.Regs()[15] = 0; // PC = 0
+    jit1.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit0.Run(1);
+    jit1.Run(1);
+
+    REQUIRE( jit0.Regs()[0] == 4 );
+    REQUIRE( jit1.Regs()[0] == 8 );
+
+    code_mem[0] = 0x07C8; // lsls r0, r1, #31
+    jit1.InvalidateCacheRange(0, 2);
+
+    jit0.Regs()[15] = 0; // PC = 0
+    jit0.Run(1);
+
+    REQUIRE( jit0.Regs()[0] == 0x80000000 );
+    REQUIRE( jit0.Regs()[15] == 2 );
+}
+
+TEST_CASE( "thumb: page table access crossing a page", "[thumb]" ) {
+    static std::array<u8, 0x2000> memory;
+    memory.fill(0xFF);
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[1] = memory.data();
+    (*page_table)[2] = memory.data() + 0x1000;
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0xE7FE; // b +#0
+
+    auto run_ldr = [&](u32 address) {
+        jit.Regs()[1] = address;
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(1);
+        return jit.Regs()[0];
+    };
+
+    REQUIRE( run_ldr(0x1FFC) == 0xFFFFFFFF );
+    // Crosses from page 1 into page 2, so is done by the callback.
+    REQUIRE( run_ldr(0x1FFE) == 0x1FFE );
+}
+
+TEST_CASE( "thumb: push and pop through page table", "[thumb]" ) {
+    static std::array<u8, 0x1000> memory;
+    memory.fill(0);
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[1] = memory.data();
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0xB503; // push {r0, r1, lr}
+    code_mem[1] = 0xBC1C; // pop {r2, r3, r4}
+    code_mem[2] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0x11111111;
+    jit.Regs()[1] = 0x22222222;
+    jit.Regs()[13] = 0x2000;
+    jit.Regs()[14] = 0x33333333;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(2);
+
+    u32 pushed_lr;
+    std::memcpy(&pushed_lr, memory.data() + 0xFFC, sizeof(pushed_lr));
+    REQUIRE( pushed_lr == 0x33333333 );
+    REQUIRE( jit.Regs()[2] == 0x11111111 );
+    REQUIRE( jit.Regs()[3] == 0x22222222 );
+    REQUIRE( jit.Regs()[4] == 0x33333333 );
+    REQUIRE( jit.Regs()[13] == 0x2000 );
+    REQUIRE( jit.Regs()[15] == 4 );
+}
+
+TEST_CASE( "thumb: code read through GetCodePage", "[thumb]" ) {
+    static std::array<u16, 0x800> code_page;
+    code_page.fill(0xE7FE); // b +#0
+    code_page[0] = 0x1C48; // adds r0, r1, #1
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.memory.GetCodePage = [](u32 vaddr) -> const u8* {
+        return vaddr == 0 ? reinterpret_cast<const u8*>(code_page.data()) : nullptr;
+    };
+    Dynarmic::Jit jit{callbacks};
+    // ReadCode must not be used for page 0.
+    code_mem.fill(0xDE00); // udf #0
+
+    jit.Regs()[1] = 1;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(2);
+
+    REQUIRE( jit.Regs()[0] == 2 );
+    REQUIRE( jit.Regs()[15] == 2 );
+}
+
+TEST_CASE( "thumb: memory callbacks with user_arg", "[thumb]" ) {
+    u32 base = 0x1000;
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.memory_with_user_arg.Read32 = [](void* user_arg, u32 vaddr) { return *static_cast<u32*>(user_arg) + vaddr; };
+    callbacks.user_arg = &base;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0xE7FE; // b +#0
+
+    jit.Regs()[1] = 0x10;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    REQUIRE( jit.Regs()[0] == 0x1010 );
+}
+
+TEST_CASE( "thumb: literal load from read-only page", "[thumb]" ) {
+    static std::array<u8, 0x1000> memory;
+    memory.fill(0);
+    const u32 literal = 0xDEADBEEF;
+    std::memcpy(memory.data() + 4, &literal, sizeof(literal));
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[0] = memory.data();
+    auto read_only_pages = std::make_unique<std::bitset<Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    read_only_pages->set(0);
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    callbacks.read_only_pages = read_only_pages.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x4800; // ldr r0, [pc, #0]
+    code_mem[1] = 0xE7FE; // b +#0
+
+    auto run_ldr = [&] {
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(1);
+        return jit.Regs()[0];
+    };
+
+    REQUIRE( run_ldr() == 0xDEADBEEF );
+    // The load was folded into the translated block, so changing memory behind the JIT's back is not seen.
+    memory.fill(0);
+    REQUIRE( run_ldr() == 0xDEADBEEF );
+}
+
+TEST_CASE( "thumb: store-to-load forwarding", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    // Memory.Read32 returns the address, so a forwarded value is distinguishable from a read.
+    callbacks.memory.Write32 = [](u32, u32) {};
+    callbacks.memory_forwarding = true;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6008; // str r0, [r1]
+    code_mem[1] = 0x680A; // ldr r2, [r1]
+    code_mem[2] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0x12345678;
+    jit.Regs()[1] = 0x100;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(2);
+
+    REQUIRE( jit.Regs()[2] == 0x12345678 );
+    REQUIRE( jit.Regs()[15] == 4 );
+}
+
+#ifdef __linux__
+TEST_CASE( "thumb: fastmem", "[thumb]" ) {
+    constexpr size_t fastmem_size = 0x100000000;
+    void* fastmem = mmap(nullptr, fastmem_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    REQUIRE( fastmem != MAP_FAILED );
+    u8* fastmem_pointer = static_cast<u8*>(fastmem);
+    REQUIRE( mprotect(fastmem_pointer + 0x1000, 0x1000, PROT_READ | PROT_WRITE) == 0 );
+    const u32 value = 0x12345678;
+    std::memcpy(fastmem_pointer + 0x1000, &value, sizeof(value));
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.fastmem_pointer = fastmem_pointer;
+    {
+        Dynarmic::Jit jit{callbacks};
+        code_mem.fill({});
+        code_mem[0] = 0x6808; // ldr r0, [r1]
+        code_mem[1] = 0xE7FE; // b +#0
+
+        auto run_ldr = [&](u32 address) {
+            jit.Regs()[1] = address;
+            jit.Regs()[15] = 0; // PC = 0
+            jit.Cpsr() = 0x00000030; // Thumb, User-mode
+            jit.Run(1);
+            return jit.Regs()[0];
+        };
+
+        REQUIRE( run_ldr(0x1000) == 0x12345678 );
+        // Inaccessible: the access faults and falls back to the callback.
+        REQUIRE( run_ldr(0x8000) == 0x8000 );
+        // The access has been backpatched to always use the callback.
+        REQUIRE( run_ldr(0x8004) == 0x8004 );
+        REQUIRE( run_ldr(0x1000) == 0x1000 );
+    }
+
+    munmap(fastmem, fastmem_size);
+}
+#endif
+
+TEST_CASE( "thumb: SaveContext and LoadContext", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    const Dynarmic::JitContext context = jit.SaveContext();
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 10 );
+
+    jit.LoadContext(context);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.Regs()[15] == 0 );
+    REQUIRE( jit.Cpsr() == 0x00000030 ); // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 10 );
+    REQUIRE( jit.Regs()[15] == 0 );
+}
+
+TEST_CASE( "thumb: SetHostFunction", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x4790; // blx r2
+    code_mem[1] = 0x3001; // adds r0, #1
+    code_mem[2] = 0xE7FE; // b +#0
+    code_mem[0x80] = 0x2042; // movs r0, #0x42
+    code_mem[0x81] = 0x4770; // bx lr
+
+    jit.SetHostFunction(0x100, [](Dynarmic::Jit* jit, void*) {
+        jit->Regs()[0] += jit->Regs()[1];
+    });
+
+    auto run_call = [&] {
+        jit.Regs()[0] = 3;
+        jit.Regs()[1] = 4;
+        jit.Regs()[2] = 0x101;
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(4);
+        return jit.Regs()[0];
+    };
+
+    REQUIRE( run_call() == 8 );
+    REQUIRE( jit.Regs()[14] == 3 );
+    REQUIRE( jit.Regs()[15] == 4 );
+
+    // Removing the host function runs the guest function again.
+    jit.SetHostFunction(0x100, nullptr);
+
+    REQUIRE( run_call() == 0x43 );
+    REQUIRE( jit.Regs()[15] == 4 );
+}
+
+TEST_CASE( "thumb: interpreter tier", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.interpreter_threshold = 3;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FD; // b -#6
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 5 );
+    REQUIRE( jit.Regs()[15] == 0 );
+    // Emitted only once it has been interpreted interpreter_threshold times.
+    REQUIRE( jit.GetStatistics().blocks_interpreted == 3 );
+    REQUIRE( jit.GetMemoryUsage().block_count == 1 );
+}
+
+TEST_CASE( "thumb: SignalInterrupt", "[thumb]" ) {
+    Dynarmic::Jit* jit_pointer = nullptr;
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.memory_with_user_arg.Read32 = [](void* user_arg, u32 vaddr) {
+        (*static_cast<Dynarmic::Jit**>(user_arg))->SignalInterrupt();
+        return vaddr;
+    };
+    callbacks.user_arg = &jit_pointer;
+    Dynarmic::Jit jit{callbacks};
+    jit_pointer = &jit;
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0x3201; // adds r2, #1
+    code_mem[2] = 0xE7FC; // b -#8
+
+    jit.Regs()[1] = 0x100;
+    jit.Regs()[2] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    // Returns once the block signalling the interrupt ends.
+    REQUIRE( jit.Run(100) == 3 );
+    REQUIRE( jit.Regs()[0] == 0x100 );
+    REQUIRE( jit.Regs()[2] == 1 );
+    REQUIRE( jit.Regs()[15] == 0 );
+
+    // Signalled while not running: the next Run executes nothing.
+    jit.SignalInterrupt();
+
+    REQUIRE( jit.Run(100) == 0 );
+    REQUIRE( jit.Regs()[2] == 1 );
+    REQUIRE( jit.Regs()[15] == 0 );
+}
+
+TEST_CASE( "thumb: mmio_pages", "[thumb]" ) {
+    struct Device {
+        u32 written_vaddr = 0;
+        u32 written_value = 0;
+    } device;
+    Dynarmic::MmioHandler handler{};
+    handler.device = &device;
+    handler.Read32 = [](void*, u32 vaddr) -> u32 {
+        return 0xCAFE0000 | (vaddr & 0xFFFF);
+    };
+    handler.Write32 = [](void* device, u32 vaddr, u32 value) {
+        static_cast<Device*>(device)->written_vaddr = vaddr;
+        static_cast<Device*>(device)->written_value = value;
+    };
+    auto mmio_pages = std::make_unique<std::array<const Dynarmic::MmioHandler*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    mmio_pages->fill(nullptr);
+    (*mmio_pages)[2] = &handler;
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.mmio_pages = mmio_pages.get();
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0x604A; // str r2, [r1, #4]
+    code_mem[2] = 0x6823; // ldr r3, [r4]
+    code_mem[3] = 0xE7FE; // b +#0
+
+    jit.Regs()[1] = 0x2010;
+    jit.Regs()[2] = 0x12345678;
+    jit.Regs()[4] = 0x100;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(3);
+
+    REQUIRE( jit.Regs()[0] == 0xCAFE2010 );
+    REQUIRE( device.written_vaddr == 0x2014 );
+    REQUIRE( device.written_value == 0x12345678 );
+    // Other pages are read through the callbacks as usual.
+    REQUIRE( jit.Regs()[3] == 0x100 );
+}
+
+TEST_CASE( "thumb: detect_self_modifying_code", "[thumb]" ) {
+    // Page 3 holds code and is only written through the callback. Page 2 holds data in the page table.
+    static std::array<u8, 0x1000> code_page;
+    static std::array<u8, 0x1000> data_page;
+    code_page.fill(0);
+    data_page.fill(0);
+    const u32 code = 0xE7FE0088; // lsls r0, r1, #2; b +#0
+    std::memcpy(code_page.data(), &code, sizeof(code));
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[2] = data_page.data();
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    callbacks.detect_self_modifying_code = true;
+    callbacks.memory.GetCodePage = [](u32 vaddr) -> const u8* {
+        return vaddr == 0x3000 ? code_page.data() : nullptr;
+    };
+    callbacks.memory.Write32 = [](u32 vaddr, u32 value) {
+        for (u32 i = 0; i < 4; i++) {
+            if (((vaddr + i) >> 12) == 3)
+                code_page[(vaddr + i) & 0xFFF] = static_cast<u8>(value >> (i * 8));
+        }
+    };
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x601A; // str r2, [r3]
+    code_mem[1] = 0xE7FE; // b +#0
+
+    auto run_at = [&](u32 pc) {
+        jit.Regs()[15] = pc;
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(1);
+    };
+
+    jit.Regs()[1] = 1;
+    run_at(0x3000);
+    REQUIRE( jit.Regs()[0] == 4 );
+
+    jit.Regs()[2] = 0xE7FE07C8; // lsls r0, r1, #31; b +#0
+    jit.Regs()[3] = 0x3000;
+    run_at(0);
+    run_at(0x3000);
+    REQUIRE( jit.Regs()[0] == 0x80000000 );
+
+    // Starts in page 2, which holds no code, and ends in page 3.
+    jit.Regs()[2] = 0x00880000; // lsls r0, r1, #2
+    jit.Regs()[3] = 0x2FFE;
+    run_at(0);
+    run_at(0x3000);
+    REQUIRE( jit.Regs()[0] == 4 );
+}
+
+#ifdef __linux__
+TEST_CASE( "thumb: detect_self_modifying_code with fastmem", "[thumb]" ) {
+    constexpr size_t fastmem_size = 0x100000000;
+    void* fastmem = mmap(nullptr, fastmem_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    REQUIRE( fastmem != MAP_FAILED );
+    static u8* fastmem_pointer;
+    fastmem_pointer = static_cast<u8*>(fastmem);
+    REQUIRE( mprotect(fastmem_pointer + 0x2000, 0x2000, PROT_READ | PROT_WRITE) == 0 );
+    const u32 code = 0xE7FE0088; // lsls r0, r1, #2; b +#0
+    std::memcpy(fastmem_pointer + 0x3000, &code, sizeof(code));
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.fastmem_pointer = fastmem_pointer;
+    callbacks.detect_self_modifying_code = true;
+    callbacks.memory.GetCodePage = [](u32 vaddr) -> const u8* {
+        return vaddr == 0x3000 ? fastmem_pointer + 0x3000 : nullptr;
+    };
+    // Writes to code pages, and writes that may cross into one, are made through the callback.
+    callbacks.memory.Write32 = [](u32 vaddr, u32 value) {
+        std::memcpy(fastmem_pointer + vaddr, &value, sizeof(value));
+    };
+    {
+        Dynarmic::Jit jit{callbacks};
+        code_mem.fill({});
+        code_mem[0] = 0x601A; // str r2, [r3]
+        code_mem[1] = 0xE7FE; // b +#0
+
+        auto run_at = [&](u32 pc) {
+            jit.Regs()[15] = pc;
+            jit.Cpsr() = 0x00000030; // Thumb, User-mode
+            jit.Run(1);
+        };
+
+        jit.Regs()[1] = 1;
+        run_at(0x3000);
+        REQUIRE( jit.Regs()[0] == 4 );
+
+        jit.Regs()[2] = 0xE7FE07C8; // lsls r0, r1, #31; b +#0
+        jit.Regs()[3] = 0x3000;
+        run_at(0);
+        run_at(0x3000);
+        REQUIRE( jit.Regs()[0] == 0x80000000 );
+
+        // Starts in page 2, which holds no code, and ends in page 3.
+        jit.Regs()[2] = 0x00880000; // lsls r0, r1, #2
+        jit.Regs()[3] = 0x2FFE;
+        run_at(0);
+        run_at(0x3000);
+        REQUIRE( jit.Regs()[0] == 4 );
+    }
+
+    munmap(fastmem, fastmem_size);
+}
+#endif
+
+TEST_CASE( "thumb: memory access tracing", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.memory.Write32 = [](u32, u32) {};
+    callbacks.memory_trace_size = 4;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0x6010; // str r0, [r2]
+    code_mem[2] = 0xE7FE; // b +#0
+
+    auto run = [&] {
+        jit.Regs()[1] = 0x100;
+        jit.Regs()[2] = 0x200;
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(3);
+    };
+
+    run();
+
+    std::vector<Dynarmic::MemoryAccessRecord> records;
+    REQUIRE( jit.ReadMemoryTrace(records) == 0 );
+    REQUIRE( records.size() == 2 );
+    REQUIRE( records[0].pc == 0 );
+    REQUIRE( records[0].vaddr == 0x100 );
+    REQUIRE( records[0].size == 4 );
+    REQUIRE( !records[0].is_write );
+    REQUIRE( records[1].pc == 2 );
+    REQUIRE( records[1].vaddr == 0x200 );
+    REQUIRE( records[1].size == 4 );
+    REQUIRE( records[1].is_write );
+
+    REQUIRE( jit.ReadMemoryTrace(records) == 0 );
+    REQUIRE( records.empty() );
+
+    // Six more accesses overflow the buffer of four; those lost are counted rather than returned.
+    run();
+    run();
+    run();
+
+    const u64 lost = jit.ReadMemoryTrace(records);
+    REQUIRE( lost >= 2 );
+    REQUIRE( lost + records.size() == 6 );
+    REQUIRE( records.back().vaddr == 0x200 );
+}
+
+TEST_CASE( "thumb: SetWatchpoint", "[thumb]" ) {
+    static std::vector<std::pair<u32, bool>> hits;
+    hits.clear();
+    static std::array<u8, 0x2000> memory;
+    memory.fill(0);
+    auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+    page_table->fill(nullptr);
+    (*page_table)[0] = memory.data();
+    (*page_table)[1] = memory.data() + 0x1000;
+
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.page_table = page_table.get();
+    callbacks.memory.Write32 = [](u32, u32) {};
+    callbacks.WatchpointHit = [](u32 vaddr, bool is_write, Dynarmic::Jit*, void*) {
+        hits.emplace_back(vaddr, is_write);
+    };
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0x6010; // str r0, [r2]
+    code_mem[2] = 0x6823; // ldr r3, [r4]
+    code_mem[3] = 0xE7FE; // b +#0
+
+    auto run = [&] {
+        jit.Regs()[1] = 0x0FFE;
+        jit.Regs()[2] = 0x1800;
+        jit.Regs()[4] = 0x0100;
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(4);
+    };
+
+    jit.SetWatchpoint(0x1000, 0x1000, Dynarmic::WatchpointKind::ReadWrite);
+    run();
+
+    // The first load starts in page 0 and crosses into the watched page 1. Page 0 is not watched.
+    REQUIRE( hits.size() == 2 );
+    REQUIRE( hits[0] == std::make_pair(u32(0x0FFE), false) );
+    REQUIRE( hits[1] == std::make_pair(u32(0x1800), true) );
+    REQUIRE( jit.Regs()[0] == 0x0FFE );
+
+    hits.clear();
+    jit.SetWatchpoint(0x1000, 0x1000, Dynarmic::WatchpointKind::None);
+    run();
+
+    REQUIRE( hits.empty() );
+}
+
+TEST_CASE( "thumb: SetBreakpoint", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0x3001; // adds r0, #1
+    code_mem[2] = 0x3001; // adds r0, #1
+    code_mem[3] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.SetBreakpoint(2, true);
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 1 );
+    REQUIRE( jit.Regs()[15] == 2 );
+
+    // Resuming at the breakpoint executes the instruction there.
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 3 );
+    REQUIRE( jit.Regs()[15] == 6 );
+
+    jit.SetBreakpoint(2, false);
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Run(10);
+
+    REQUIRE( jit.Regs()[0] == 3 );
+    REQUIRE( jit.Regs()[15] == 6 );
+}
+
+TEST_CASE( "thumb: retained IR with folded read-only data", "[thumb]" ) {
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.memory.Read32 = &MemoryReadCode;
+    callbacks.memory.IsReadOnlyMemory = [](u32 vaddr) { return vaddr < code_mem.size() * sizeof(u16); };
+    callbacks.ir_cache_capacity = 16;
+    Dynarmic::Jit jit{callbacks};
+    code_mem.fill({});
+    code_mem[0] = 0x4801; // ldr r0, [pc, #4]
+    code_mem[1] = 0xE7FE; // b +#0
+    code_mem[4] = 0xBEEF;
+    code_mem[5] = 0xDEAD;
+
+    auto run_ldr = [&] {
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(1);
+        return jit.Regs()[0];
+    };
+
+    REQUIRE( run_ldr() == 0xDEADBEEF );
+    REQUIRE( jit.GetStatistics().ir_cache_hits == 0 );
+
+    // Emitted again from the retained IR.
+    jit.ClearCache();
+    REQUIRE( run_ldr() == 0xDEADBEEF );
+    REQUIRE( jit.GetStatistics().ir_cache_hits == 1 );
+
+    // The literal folded into the IR has changed, though the code has not, so the block is translated again.
+    code_mem[5] = 0x1234;
+    jit.ClearCache();
+    REQUIRE( run_ldr() == 0x1234BEEF );
+    REQUIRE( jit.GetStatistics().ir_cache_hits == 1 );
+}
+
+TEST_CASE( "thumb: SaveIRCache and LoadIRCache", "[thumb]" ) {
+    const std::string path = "dynarmic_test_ir_cache.bin";
+    Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+    callbacks.ir_cache_capacity = 16;
+    code_mem.fill({});
+    code_mem[0] = 0x0088; // lsls r0, r1, #2
+    code_mem[1] = 0xE7FE; // b +#0
+
+    auto run = [](Dynarmic::Jit& jit) {
+        jit.Regs()[1] = 1;
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        jit.Run(1);
+        return jit.Regs()[0];
+    };
+
+    {
+        Dynarmic::Jit jit{callbacks};
+        REQUIRE( run(jit) == 4 );
+        REQUIRE( jit.SaveIRCache(path) );
+    }
+
+    {
+        Dynarmic::Jit jit{callbacks};
+        REQUIRE( jit.LoadIRCache(path) );
+        REQUIRE( run(jit) == 4 );
+        REQUIRE( jit.GetStatistics().ir_cache_hits == 1 );
+        REQUIRE( jit.GetStatistics().blocks_translated == 0 );
+    }
+
+    {
+        // Saved with different cycle costs.
+        Dynarmic::UserCallbacks other_callbacks = callbacks;
+        other_callbacks.cycles_per_memory_access = 2;
+        Dynarmic::Jit jit{other_callbacks};
+        REQUIRE( !jit.LoadIRCache(path) );
+    }
+
+    {
+        // The guest code has changed since the IR was saved.
+        code_mem[0] = 0x07C8; // lsls r0, r1, #31
+        Dynarmic::Jit jit{callbacks};
+        REQUIRE( jit.LoadIRCache(path) );
+        REQUIRE( run(jit) == 0x80000000 );
+        REQUIRE( jit.GetStatistics().ir_cache_hits == 0 );
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE( "thumb: Precompile", "[thumb]" ) {
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x3001; // adds r0, #1
+    code_mem[1] = 0xE7FF; // b -#2
+    code_mem[2] = 0x3001; // adds r0, #1
+    code_mem[3] = 0xE7FE; // b +#0
+
+    jit.Regs()[0] = 0;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    // All three blocks are reached from the entry point by direct branches.
+    jit.Precompile(0, 0, 8);
+
+    REQUIRE( jit.GetMemoryUsage().block_count == 3 );
+
+    jit.Run(5);
+
+    REQUIRE( jit.Regs()[0] == 2 );
+    REQUIRE( jit.Regs()[15] == 6 );
+    REQUIRE( jit.GetStatistics().cache_misses == 0 );
+}
+
+TEST_CASE( "thumb: cycle costs", "[thumb]" ) {
+    code_mem.fill({});
+    code_mem[0] = 0x6808; // ldr r0, [r1]
+    code_mem[1] = 0x3201; // adds r2, #1
+    code_mem[2] = 0xE7FE; // b +#0
+
+    auto run = [](Dynarmic::Jit& jit) {
+        jit.Regs()[15] = 0; // PC = 0
+        jit.Cpsr() = 0x00000030; // Thumb, User-mode
+        return jit.Run(1);
+    };
+
+    {
+        Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+        callbacks.cycles_per_instruction = 2;
+        callbacks.cycles_per_memory_access = 3;
+        Dynarmic::Jit jit{callbacks};
+
+        REQUIRE( run(jit) == 9 );
+        REQUIRE( jit.GetCycleCounter() == 9 );
+    }
+
+    {
+        Dynarmic::UserCallbacks callbacks = GetUserCallbacks();
+        callbacks.GetInstructionCycles = [](u32 pc, u32 instruction, bool is_thumb, void*) -> size_t {
+            return pc == 0 && instruction == 0x6808 && is_thumb ? 10 : 1;
+        };
+        callbacks.ir_cache_capacity = 16;
+        Dynarmic::Jit jit{callbacks};
+
+        REQUIRE( run(jit) == 12 );
+
+        // The costs are part of the IR, which is not retained as they may change.
+        jit.ClearCache();
+        REQUIRE( run(jit) == 12 );
+        REQUIRE( jit.GetStatistics().ir_cache_hits == 0 );
+    }
+}
+
+TEST_CASE( "thumb: DumpCodeCache", "[thumb]" ) {
+    const std::string path = "dynarmic_test_code_cache.json";
+    Dynarmic::Jit jit{GetUserCallbacks()};
+    code_mem.fill({});
+    code_mem[0] = 0x0088; // lsls r0, r1, #2
+    code_mem[1] = 0xE7FE; // b +#0
+
+    jit.Regs()[1] = 1;
+    jit.Regs()[15] = 0; // PC = 0
+    jit.Cpsr() = 0x00000030; // Thumb, User-mode
+
+    jit.Run(1);
+
+    const Dynarmic::JitStatistics before = jit.GetStatistics();
+    REQUIRE( jit.DumpCodeCache(path) );
+    const Dynarmic::JitStatistics after = jit.GetStatistics();
+
+    // Translating the IR to dump is not counted as work done by the Jit.
+    REQUIRE( after.blocks_translated == before.blocks_translated );
+    REQUIRE( after.translate_time_ns == before.translate_time_ns );
+    REQUIRE( after.optimize_time_ns == before.optimize_time_ns );
+    REQUIRE( after.passes.size() == before.passes.size() );
+    for (size_t i = 0; i < after.passes.size(); i++) {
+        REQUIRE( after.passes[i].runs == before.passes[i].runs );
+        REQUIRE( after.passes[i].instructions_before == before.passes[i].instructions_before );
+    }
+
+    std::string dump;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    REQUIRE( file != nullptr );
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) != 0)
+        dump.append(buffer, read);
+    std::fclose(file);
+    std::remove(path.c_str());
+
+    REQUIRE( dump.compare(0, 11, "{\"blocks\":[") == 0 );
+    REQUIRE( dump.find("\"pc\":0,\"thumb\":true") != std::string::npos );
+    REQUIRE( dump.find("\"ir\":") != std::string::npos );
+}
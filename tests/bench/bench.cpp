@@ -0,0 +1,68 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <dynarmic/dynarmic.h>
+
+#include "bench/kernels.h"
+#include "common/common_types.h"
+
+// Runs a fixed set of guest kernels through Jit::Run and prints one JSON object per kernel
+// to stdout, so that results can be compared between builds.
+// Usage: dynarmic_bench [guest instructions per kernel]
+
+namespace {
+
+void InterpreterFallback(u32 pc, Dynarmic::Jit*, void*) {
+    std::fprintf(stderr, "unexpected interpreter fallback at pc=%08x\n", pc);
+    std::exit(1);
+}
+
+void CallSVC(u32 swi) {
+    std::fprintf(stderr, "unexpected svc #%u\n", swi);
+    std::exit(1);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const size_t instructions_to_run = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 100000000;
+
+    Dynarmic::UserCallbacks callbacks = Bench::GetMemoryCallbacks();
+    callbacks.InterpreterFallback = &InterpreterFallback;
+    callbacks.CallSVC = &CallSVC;
+
+    for (const Bench::Kernel& kernel : Bench::kernels) {
+        Bench::LoadKernel(kernel);
+
+        Dynarmic::Jit jit{callbacks};
+        jit.Regs()[15] = 0;
+        jit.Cpsr() = kernel.InitialCpsr();
+
+        const auto start = std::chrono::steady_clock::now();
+        size_t instructions_executed = 0;
+        while (instructions_executed < instructions_to_run) {
+            instructions_executed += jit.Run(instructions_to_run - instructions_executed);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const Dynarmic::JitStatistics statistics = jit.GetStatistics();
+        const unsigned long long translation_ns = statistics.translate_time_ns + statistics.optimize_time_ns + statistics.emit_time_ns;
+
+        std::printf("{\"kernel\": \"%s\", \"guest_instructions\": %zu, \"seconds\": %.6f, \"guest_mips\": %.2f, "
+                    "\"blocks_translated\": %llu, \"bytes_emitted\": %llu, \"translation_ns\": %llu, \"dispatcher_exits\": %llu}\n",
+                    kernel.name, instructions_executed, seconds, static_cast<double>(instructions_executed) / seconds / 1e6,
+                    static_cast<unsigned long long>(statistics.blocks_translated),
+                    static_cast<unsigned long long>(statistics.bytes_emitted),
+                    translation_ns,
+                    static_cast<unsigned long long>(statistics.dispatcher_exits));
+    }
+
+    return 0;
+}
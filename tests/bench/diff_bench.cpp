@@ -0,0 +1,167 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <dynarmic/dynarmic.h>
+
+#include "bench/kernels.h"
+#include "common/bit_util.h"
+#include "common/common_types.h"
+#include "skyeye_interpreter/dyncom/arm_dyncom_interpreter.h"
+#include "skyeye_interpreter/skyeye_common/armstate.h"
+
+// Runs each of the benchmark kernels for the same number of guest instructions under the JIT and
+// under the skyeye interpreter, checks that both end in the same state, and prints one JSON object
+// per kernel with the speedup of the JIT over the interpreter. Exits with a non-zero status if
+// any kernel's final state differs.
+// Usage: dynarmic_diff_bench [guest instructions per kernel]
+
+namespace {
+
+Dynarmic::UserCallbacks GetUserCallbacks();
+
+void InterpreterFallback(u32 pc, Dynarmic::Jit* jit, void*) {
+    ARMul_State interp_state{USER32MODE};
+    interp_state.user_callbacks = GetUserCallbacks();
+    interp_state.NumInstrsToExecute = 1;
+
+    interp_state.Reg = jit->Regs();
+    interp_state.ExtReg = jit->ExtRegs();
+    interp_state.Cpsr = jit->Cpsr();
+    interp_state.VFP[VFP_FPSCR] = jit->Fpscr();
+    interp_state.Reg[15] = pc;
+
+    InterpreterClearCache();
+    InterpreterMainLoop(&interp_state);
+
+    bool T = Dynarmic::Common::Bit<5>(interp_state.Cpsr);
+    interp_state.Reg[15] &= T ? 0xFFFFFFFE : 0xFFFFFFFC;
+
+    jit->Regs() = interp_state.Reg;
+    jit->ExtRegs() = interp_state.ExtReg;
+    jit->Cpsr() = interp_state.Cpsr;
+    jit->SetFpscr(interp_state.VFP[VFP_FPSCR]);
+}
+
+void CallSVC(u32 swi) {
+    std::fprintf(stderr, "unexpected svc #%u\n", swi);
+    std::exit(1);
+}
+
+Dynarmic::UserCallbacks GetUserCallbacks() {
+    Dynarmic::UserCallbacks callbacks = Bench::GetMemoryCallbacks();
+    callbacks.InterpreterFallback = &InterpreterFallback;
+    callbacks.CallSVC = &CallSVC;
+    return callbacks;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Prints the differences between the final states to stderr. Returns true if there are none.
+bool CompareFinalState(const Bench::Kernel& kernel, const ARMul_State& interp, const Dynarmic::Jit& jit, const std::vector<u8>& interp_memory, const std::vector<u8>& jit_memory) {
+    bool matches = true;
+
+    for (size_t i = 0; i < 16; i++) {
+        if (interp.Reg[i] != jit.Regs()[i]) {
+            std::fprintf(stderr, "%s: r%zu: interp %08x jit %08x\n", kernel.name, i, interp.Reg[i], jit.Regs()[i]);
+            matches = false;
+        }
+    }
+    for (size_t i = 0; i < 64; i++) {
+        if (interp.ExtReg[i] != jit.ExtRegs()[i]) {
+            std::fprintf(stderr, "%s: s%zu: interp %08x jit %08x\n", kernel.name, i, interp.ExtReg[i], jit.ExtRegs()[i]);
+            matches = false;
+        }
+    }
+    if (interp.Cpsr != jit.Cpsr()) {
+        std::fprintf(stderr, "%s: cpsr: interp %08x jit %08x\n", kernel.name, interp.Cpsr, jit.Cpsr());
+        matches = false;
+    }
+    if (interp.VFP[VFP_FPSCR] != jit.Fpscr()) {
+        std::fprintf(stderr, "%s: fpscr: interp %08x jit %08x\n", kernel.name, interp.VFP[VFP_FPSCR], jit.Fpscr());
+        matches = false;
+    }
+    for (size_t vaddr = 0; vaddr < interp_memory.size(); vaddr++) {
+        if (interp_memory[vaddr] != jit_memory[vaddr]) {
+            std::fprintf(stderr, "%s: first differing byte of memory at %08zx: interp %02x jit %02x\n", kernel.name, vaddr, interp_memory[vaddr], jit_memory[vaddr]);
+            matches = false;
+            break;
+        }
+    }
+
+    return matches;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const size_t instructions_to_run = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 10000000;
+
+    bool all_match = true;
+
+    for (const Bench::Kernel& kernel : Bench::kernels) {
+        // Run the JIT first. It may run past instructions_to_run to the end of a block, so the
+        // interpreter is then run for the number of instructions the JIT actually executed.
+        Bench::LoadKernel(kernel);
+
+        Dynarmic::Jit jit{GetUserCallbacks()};
+        jit.Regs()[15] = 0;
+        jit.Cpsr() = kernel.InitialCpsr();
+        jit.SetFpscr(0);
+
+        const auto jit_start = std::chrono::steady_clock::now();
+        size_t instructions_executed = 0;
+        while (instructions_executed < instructions_to_run) {
+            instructions_executed += jit.Run(instructions_to_run - instructions_executed);
+        }
+        const double jit_seconds = SecondsSince(jit_start);
+        const std::vector<u8> jit_memory = Bench::memory;
+
+        Bench::LoadKernel(kernel);
+
+        ARMul_State interp{USER32MODE};
+        interp.user_callbacks = GetUserCallbacks();
+        interp.Reg[15] = 0;
+        interp.Cpsr = kernel.InitialCpsr();
+        interp.VFP[VFP_FPSCR] = 0;
+        interp.instruction_cache.clear();
+        InterpreterClearCache();
+
+        const auto interp_start = std::chrono::steady_clock::now();
+        size_t interp_instructions_executed = 0;
+        while (interp_instructions_executed < instructions_executed) {
+            interp.NumInstrsToExecute = static_cast<unsigned>(instructions_executed - interp_instructions_executed);
+            const unsigned executed = InterpreterMainLoop(&interp);
+            if (executed == 0)
+                break;
+            interp_instructions_executed += executed;
+        }
+        const double interp_seconds = SecondsSince(interp_start);
+        {
+            bool T = Dynarmic::Common::Bit<5>(interp.Cpsr);
+            interp.Reg[15] &= T ? 0xFFFFFFFE : 0xFFFFFFFC;
+        }
+
+        const bool matches = CompareFinalState(kernel, interp, jit, Bench::memory, jit_memory);
+        all_match = all_match && matches;
+
+        std::printf("{\"kernel\": \"%s\", \"guest_instructions\": %zu, \"matches\": %s, \"jit_mips\": %.2f, \"interpreter_mips\": %.2f, "
+                    "\"speedup\": %.2f, \"interpreter_fallbacks\": %llu}\n",
+                    kernel.name, instructions_executed, matches ? "true" : "false",
+                    static_cast<double>(instructions_executed) / jit_seconds / 1e6,
+                    static_cast<double>(instructions_executed) / interp_seconds / 1e6,
+                    interp_seconds / jit_seconds,
+                    static_cast<unsigned long long>(jit.GetStatistics().interpreter_fallbacks));
+    }
+
+    return all_match ? 0 : 1;
+}
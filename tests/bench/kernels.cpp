@@ -0,0 +1,233 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bench/kernels.h"
+
+namespace Bench {
+
+std::vector<u8> memory(memory_size);
+
+namespace {
+
+const u8* GetCodePage(u32 vaddr) {
+    return vaddr < memory_size ? &memory[vaddr] : nullptr;
+}
+
+void FillRandomWords() {
+    std::mt19937 rng{42};
+    for (u32 vaddr = data_address; vaddr < data_address + 0x2000; vaddr += 4) {
+        Write<u32>(vaddr, static_cast<u32>(rng()));
+    }
+}
+
+void FillMatrices() {
+    for (u32 i = 0; i < 32; i++) {
+        const float value = 0.25f * static_cast<float>(i % 7) - 0.5f;
+        u32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Write<u32>(data_address + i * 4, bits);
+    }
+}
+
+void FillBytecode() {
+    std::mt19937 rng{42};
+    for (u32 i = 0; i < 0xFFF; i++) {
+        Write<u8>(data_address + i, static_cast<u8>(rng() % 4));
+    }
+    Write<u8>(data_address + 0xFFF, 4); // Restart
+}
+
+} // anonymous namespace
+
+const std::vector<Kernel> kernels{
+    // Dhrystone/CoreMark-style integer arithmetic and conditional execution.
+    {"integer", false, {
+        // start:
+        0xe3a00000, // mov r0, #0
+        0xe3a01c01, // mov r1, #256
+        // loop:
+        0xe0802181, // add r2, r0, r1, lsl #3
+        0xe02203e0, // eor r0, r2, r0, ror #7
+        0xe0030291, // mul r3, r1, r2
+        0xe20340ff, // and r4, r3, #0xFF
+        0xe3540080, // cmp r4, #0x80
+        0x80800004, // addhi r0, r0, r4
+        0x904000a4, // subls r0, r0, r4, lsr #1
+        0xe1805001, // orr r5, r0, r1
+        0xe3c550f0, // bic r5, r5, #0xF0
+        0xe16f6f15, // clz r6, r5
+        0xe0800006, // add r0, r0, r6
+        0xe2511001, // subs r1, r1, #1
+        0x1afffff2, // bne loop
+        0xeaffffef, // b start
+    }, {}, nullptr},
+    // Copying 4 KiB at a time with LDM/STM.
+    {"memcpy", false, {
+        // start:
+        0xe3a00801, // mov r0, #0x10000
+        0xe3a01802, // mov r1, #0x20000
+        0xe3a02a01, // mov r2, #4096
+        // loop:
+        0xe8b007f8, // ldmia r0!, {r3-r10}
+        0xe8a107f8, // stmia r1!, {r3-r10}
+        0xe2522020, // subs r2, r2, #32
+        0xcafffffb, // bgt loop
+        0xeafffff7, // b start
+    }, {}, FillRandomWords},
+    // 4x4 single precision matrix multiply with VFP.
+    {"vfp_matrix_multiply", false, {
+        // start:
+        0xe3a00801, // mov r0, #0x10000
+        0xe2801040, // add r1, r0, #0x40
+        0xe2802080, // add r2, r0, #0x80
+        0xec918a10, // vldmia r1, {s16-s31}
+        0xe3a03004, // mov r3, #4
+        // row:
+        0xecb00a04, // vldmia r0!, {s0-s3}
+        0xee202a08, // vmul.f32 s4, s0, s16
+        0xee002a8a, // vmla.f32 s4, s1, s20
+        0xee012a0c, // vmla.f32 s4, s2, s24
+        0xee012a8e, // vmla.f32 s4, s3, s28
+        0xee602a28, // vmul.f32 s5, s0, s17
+        0xee402aaa, // vmla.f32 s5, s1, s21
+        0xee412a2c, // vmla.f32 s5, s2, s25
+        0xee412aae, // vmla.f32 s5, s3, s29
+        0xee203a09, // vmul.f32 s6, s0, s18
+        0xee003a8b, // vmla.f32 s6, s1, s22
+        0xee013a0d, // vmla.f32 s6, s2, s26
+        0xee013a8f, // vmla.f32 s6, s3, s30
+        0xee603a29, // vmul.f32 s7, s0, s19
+        0xee403aab, // vmla.f32 s7, s1, s23
+        0xee413a2d, // vmla.f32 s7, s2, s27
+        0xee413aaf, // vmla.f32 s7, s3, s31
+        0xeca22a04, // vstmia r2!, {s4-s7}
+        0xe2533001, // subs r3, r3, #1
+        0x1affffeb, // bne row
+        0xeaffffe5, // b start
+    }, {}, FillMatrices},
+    // ARMv6 SIMD and DSP multiplies over two buffers.
+    {"armv6_simd", false, {
+        // start:
+        0xe3a00801, // mov r0, #0x10000
+        0xe280ba01, // add r11, r0, #0x1000
+        0xe3a01b01, // mov r1, #1024
+        0xe3a08000, // mov r8, #0
+        0xe3a09000, // mov r9, #0
+        // loop:
+        0xe49b3004, // ldr r3, [r11], #4
+        0xe4902004, // ldr r2, [r0], #4
+        0xe6524f93, // uadd8 r4, r2, r3
+        0xe6225f13, // qadd16 r5, r2, r3
+        0xe786f312, // usad8 r6, r2, r3
+        0xe0888006, // add r8, r8, r6
+        0xe6847fb5, // sel r7, r4, r5
+        0xe6377f12, // shadd16 r7, r7, r2
+        0xe7099312, // smlad r9, r2, r3, r9
+        0xe664aff3, // uqsub8 r10, r4, r3
+        0xe029900a, // eor r9, r9, r10
+        0xe2511001, // subs r1, r1, #1
+        0x1afffff2, // bne loop
+        0xeaffffec, // b start
+    }, {}, FillRandomWords},
+    // A bytecode interpreter dispatching through a table of handlers.
+    {"bytecode_interpreter", false, {
+        // start:
+        0xe3a04801, // mov r4, #0x10000
+        0xe3a06a11, // mov r6, #0x11000
+        0xe28f7028, // adr r7, op0
+        0xe5867000, // str r7, [r6, #0]
+        0xe28f7028, // adr r7, op1
+        0xe5867004, // str r7, [r6, #4]
+        0xe28f7028, // adr r7, op2
+        0xe5867008, // str r7, [r6, #8]
+        0xe28f7030, // adr r7, op3
+        0xe586700c, // str r7, [r6, #12]
+        0xe24f7030, // adr r7, start
+        0xe5867010, // str r7, [r6, #16]
+        // dispatch:
+        0xe4d42001, // ldrb r2, [r4], #1
+        0xe796f102, // ldr pc, [r6, r2, lsl #2]
+        // op0:
+        0xe2800001, // add r0, r0, #1
+        0xeafffffb, // b dispatch
+        // op1:
+        0xe0200180, // eor r0, r0, r0, lsl #3
+        0xeafffff9, // b dispatch
+        // op2:
+        0xe3100001, // tst r0, #1
+        0x12400003, // subne r0, r0, #3
+        0x02800005, // addeq r0, r0, #5
+        0xeafffff5, // b dispatch
+        // op3:
+        0xe1a01120, // mov r1, r0, lsr #2
+        0xe0810080, // add r0, r1, r0, lsl #1
+        0xeafffff2, // b dispatch
+    }, {}, FillBytecode},
+    // A byte checksum in Thumb.
+    {"thumb_checksum", true, {}, {
+        // start:
+        0x2000, // movs r0, #0
+        0x2100, // movs r1, #0
+        0x2201, // movs r2, #1
+        0x0412, // lsls r2, r2, #16
+        0x23ff, // movs r3, #255
+        // loop:
+        0x5c54, // ldrb r4, [r2, r1]
+        0x1900, // adds r0, r0, r4
+        0x0145, // lsls r5, r0, #5
+        0x4068, // eors r0, r5
+        0x3101, // adds r1, #1
+        0x4299, // cmp r1, r3
+        0xd3f8, // bcc loop
+        0xe7f2, // b start
+    }, FillRandomWords},
+};
+
+void LoadKernel(const Kernel& kernel) {
+    std::fill(memory.begin(), memory.end(), 0);
+    if (kernel.thumb) {
+        std::memcpy(memory.data(), kernel.thumb_code.data(), kernel.thumb_code.size() * sizeof(u16));
+    } else {
+        std::memcpy(memory.data(), kernel.arm_code.data(), kernel.arm_code.size() * sizeof(u32));
+    }
+    if (kernel.init_data) {
+        kernel.init_data();
+    }
+}
+
+Dynarmic::UserCallbacks GetMemoryCallbacks() {
+    static const auto page_table = [] {
+        auto page_table = std::make_unique<std::array<u8*, Dynarmic::UserCallbacks::NUM_PAGE_TABLE_ENTRIES>>();
+        page_table->fill(nullptr);
+        for (u32 page = 0; page < memory_size >> Dynarmic::UserCallbacks::PAGE_BITS; page++) {
+            (*page_table)[page] = &memory[page << Dynarmic::UserCallbacks::PAGE_BITS];
+        }
+        return page_table;
+    }();
+
+    Dynarmic::UserCallbacks callbacks{};
+    callbacks.memory.ReadCode = &Read<u32>;
+    callbacks.memory.GetCodePage = &GetCodePage;
+    callbacks.memory.Read8 = &Read<u8>;
+    callbacks.memory.Read16 = &Read<u16>;
+    callbacks.memory.Read32 = &Read<u32>;
+    callbacks.memory.Read64 = &Read<u64>;
+    callbacks.memory.Write8 = &Write<u8>;
+    callbacks.memory.Write16 = &Write<u16>;
+    callbacks.memory.Write32 = &Write<u32>;
+    callbacks.memory.Write64 = &Write<u64>;
+    callbacks.page_table = page_table.get();
+    return callbacks;
+}
+
+} // namespace Bench
@@ -0,0 +1,60 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include <dynarmic/callbacks.h>
+
+#include "common/common_types.h"
+
+// The guest kernels shared by the benchmarks in this directory, and the flat guest memory they run in.
+
+namespace Bench {
+
+constexpr u32 memory_size = 0x100000; // Mapped at guest address 0 through the page table.
+constexpr u32 data_address = 0x10000;
+
+extern std::vector<u8> memory;
+
+template <typename T>
+T Read(u32 vaddr) {
+    T value = 0;
+    if (vaddr <= memory_size - sizeof(T))
+        std::memcpy(&value, &memory[vaddr], sizeof(T));
+    return value;
+}
+
+template <typename T>
+void Write(u32 vaddr, T value) {
+    if (vaddr <= memory_size - sizeof(T))
+        std::memcpy(&memory[vaddr], &value, sizeof(T));
+}
+
+struct Kernel {
+    const char* name;
+    bool thumb;
+    std::vector<u32> arm_code;
+    std::vector<u16> thumb_code;
+    void (*init_data)();
+
+    /// The CPSR to start the kernel with, in user mode.
+    u32 InitialCpsr() const { return thumb ? 0x00000030 : 0x00000010; }
+};
+
+extern const std::vector<Kernel> kernels;
+
+/// Clears memory, then writes the code of kernel at address 0 and its initial data.
+void LoadKernel(const Kernel& kernel);
+
+/// Callbacks that access memory, with the whole of it mapped through the page table.
+/// InterpreterFallback and CallSVC are left for the caller to set.
+Dynarmic::UserCallbacks GetMemoryCallbacks();
+
+} // namespace Bench
@@ -0,0 +1,325 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <dynarmic/callbacks.h>
+
+#include "backend_x64/block_of_code.h"
+#include "backend_x64/emit_x64.h"
+#include "common/common_types.h"
+#include "frontend/arm/types.h"
+#include "frontend/decoder/arm.h"
+#include "frontend/decoder/vfp2.h"
+#include "frontend/ir/basic_block.h"
+#include "frontend/ir/location_descriptor.h"
+#include "frontend/translate/translate.h"
+#include "frontend/translate/translate_arm/translate_arm.h"
+#include "ir_opt/pass_manager.h"
+#include "ir_opt/passes.h"
+
+// Times the stages of translation separately: decoding, Arm::Translate, each optimization pass and
+// EmitX64::Emit, on synthetic guest code, and measures the size of the emitted code. Prints one JSON
+// object per benchmark to stdout.
+// Usage: dynarmic_micro_bench [number of blocks per benchmark]
+// Encodings the translator rejects while the instruction pools are generated print assertion messages to stderr.
+
+using namespace Dynarmic;
+
+namespace {
+
+constexpr size_t block_length = 32;   // Guest instructions in each synthetic block
+constexpr u32 block_stride = 0x100;   // Synthetic blocks are laid out one per 256 bytes of guest code
+
+std::vector<u32> code_memory;
+
+u32 ReadCode(u32 vaddr) {
+    const size_t index = vaddr / sizeof(u32);
+    return index < code_memory.size() ? code_memory[index] : 0xEAFFFFFE; // b +#0
+}
+
+template <typename Fn>
+double TimeNanoseconds(Fn fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Report(const std::string& name, size_t items, double total_ns, const char* item_name) {
+    std::printf("{\"benchmark\": \"%s\", \"%s\": %zu, \"ns_per_item\": %.2f}\n", name.c_str(), item_name, items, total_ns / static_cast<double>(items));
+}
+
+enum class InstructionClass {
+    DataProcessing,
+    Multiply,
+    ParallelAndSaturating,
+    LoadStore,
+    VFP,
+};
+
+const std::vector<std::pair<InstructionClass, const char*>> instruction_classes {
+    {InstructionClass::DataProcessing, "data_processing"},
+    {InstructionClass::Multiply, "multiply"},
+    {InstructionClass::ParallelAndSaturating, "parallel_and_saturating"},
+    {InstructionClass::LoadStore, "load_store"},
+    {InstructionClass::VFP, "vfp"},
+};
+
+bool NameStartsWithAnyOf(const std::string& name, std::initializer_list<const char*> prefixes) {
+    for (const char* prefix : prefixes) {
+        if (name.compare(0, std::strlen(prefix), prefix) == 0)
+            return true;
+    }
+    return false;
+}
+
+boost::optional<InstructionClass> ClassifyArm(u32 instruction) {
+    if (Arm::DecodeVFP2<Arm::ArmTranslatorVisitor>(instruction))
+        return InstructionClass::VFP;
+
+    const auto decoder = Arm::DecodeArm<Arm::ArmTranslatorVisitor>(instruction);
+    if (!decoder)
+        return boost::none;
+
+    const std::string name = decoder->GetName();
+    if (NameStartsWithAnyOf(name, {"ADC", "ADD", "AND", "BIC", "CMN", "CMP", "EOR", "MOV", "MVN", "ORR", "RSB", "RSC", "SBC", "SUB", "TEQ", "TST", "CLZ", "SXT", "UXT", "REV", "PKH"}))
+        return InstructionClass::DataProcessing;
+    if (NameStartsWithAnyOf(name, {"MLA", "MUL", "SMLA", "SMUL", "SMMUL", "SMMLA", "SMMLS", "SMUAD", "SMUSD", "SMLS", "UMAAL", "UMLAL", "UMULL"}))
+        return InstructionClass::Multiply;
+    if (NameStartsWithAnyOf(name, {"SADD", "SASX", "SSAX", "SSUB", "UADD", "UASX", "USAX", "USUB", "QADD", "QASX", "QSAX", "QSUB", "QDADD", "QDSUB", "UQ", "SH", "UH", "SEL", "USAD", "SSAT", "USAT"}))
+        return InstructionClass::ParallelAndSaturating;
+    if (NameStartsWithAnyOf(name, {"LDR (imm)", "LDR (reg)", "LDRB (imm)", "LDRB (reg)", "LDRH (imm)", "LDRH (reg)", "LDRS", "STR (imm)", "STR (reg)", "STRB (imm)", "STRB (reg)", "STRH (imm)", "STRH (reg)", "LDM", "STM"}))
+        return InstructionClass::LoadStore;
+    return boost::none;
+}
+
+IR::LocationDescriptor BlockLocation(size_t block, bool thumb = false) {
+    return IR::LocationDescriptor{static_cast<u32>(block * block_stride), Arm::PSR{thumb ? 0x000001F0u : 0x000001D0u}, Arm::FPSCR{}};
+}
+
+/// Whether the instruction in the first word of code is translated without ending the block, so it can be
+/// placed at any point in one. code is the instruction followed by a branch to itself.
+bool TranslatesInline(std::initializer_list<u32> code, bool thumb) {
+    code_memory.assign(code);
+    try {
+        return Arm::Translate(BlockLocation(0, thumb), &ReadCode).CycleCount() == 2;
+    } catch (...) {
+        // The translator asserts on UNPREDICTABLE encodings.
+        return false;
+    }
+}
+
+/// Random unconditional ARM instructions of each class that can be placed anywhere in a block.
+std::vector<std::vector<u32>> GenerateInstructionPools(std::mt19937& rng, size_t pool_size) {
+    std::vector<std::vector<u32>> pools(instruction_classes.size());
+
+    bool all_full = false;
+    while (!all_full) {
+        const u32 instruction = (rng() & 0x0FFFFFFF) | 0xE0000000;
+        if (const auto instruction_class = ClassifyArm(instruction)) {
+            auto& pool = pools[static_cast<size_t>(*instruction_class)];
+            if (pool.size() < pool_size && TranslatesInline({instruction, 0xEAFFFFFE}, false)) {
+                pool.push_back(instruction);
+            }
+        }
+
+        all_full = true;
+        for (const auto& pool : pools) {
+            all_full = all_full && pool.size() >= pool_size;
+        }
+    }
+
+    return pools;
+}
+
+/// Lays out block_count blocks of instructions drawn from pool, each ending in a branch to itself.
+void LayOutBlocks(std::mt19937& rng, const std::vector<u32>& pool, size_t block_count) {
+    code_memory.assign(block_count * block_stride / sizeof(u32), 0xEAFFFFFE);
+    for (size_t block = 0; block < block_count; block++) {
+        for (size_t i = 0; i < block_length; i++) {
+            code_memory[block * block_stride / sizeof(u32) + i] = pool[rng() % pool.size()];
+        }
+    }
+}
+
+/// Random 16-bit Thumb instructions that can be placed anywhere in a block.
+std::vector<u16> GenerateThumbPool(std::mt19937& rng, size_t pool_size) {
+    std::vector<u16> pool;
+    while (pool.size() < pool_size) {
+        const u16 instruction = static_cast<u16>(rng());
+        if ((instruction & 0xF800) < 0xE800 && TranslatesInline({0xE7FE0000u | instruction}, true)) {
+            pool.push_back(instruction);
+        }
+    }
+    return pool;
+}
+
+/// As LayOutBlocks, for Thumb blocks.
+void LayOutThumbBlocks(std::mt19937& rng, const std::vector<u16>& pool, size_t block_count) {
+    code_memory.assign(block_count * block_stride / sizeof(u32), 0xE7FEE7FE);
+    for (size_t block = 0; block < block_count; block++) {
+        for (size_t i = 0; i < block_length; i += 2) {
+            code_memory[(block * block_stride + i * sizeof(u16)) / sizeof(u32)] = pool[rng() % pool.size()] | (pool[rng() % pool.size()] << 16);
+        }
+    }
+}
+
+std::vector<IR::Block> TranslateBlocks(size_t block_count) {
+    std::vector<IR::Block> blocks;
+    blocks.reserve(block_count);
+    for (size_t block = 0; block < block_count; block++) {
+        blocks.push_back(Arm::Translate(BlockLocation(block), &ReadCode));
+    }
+    return blocks;
+}
+
+Optimization::PassManager BuildHotPipeline(const UserCallbacks& callbacks) {
+    using namespace Optimization;
+
+    // This matches the pipeline for hot blocks with memory forwarding enabled (see interface_x64.cpp).
+    const auto constant_propagation = [callbacks](IR::Block& block) { ConstantPropagation(block, callbacks); };
+    const auto memory_forwarding = [callbacks](IR::Block& block) { MemoryForwarding(block, callbacks); };
+
+    PassManager passes;
+    passes.AddPass("GetSetElimination", GetSetElimination);
+    passes.AddPass("ConstantPropagation", constant_propagation);
+    passes.AddPass("CommonSubexpressionElimination", CommonSubexpressionElimination);
+    passes.AddPass("MemoryForwarding", memory_forwarding);
+    passes.AddPass("ConstantPropagation", constant_propagation);
+    passes.AddPass("CarryChainFusion", CarryChainFusion);
+    passes.AddPass("FlagPacking", FlagPacking);
+    passes.AddPass("DeadCodeElimination", DeadCodeElimination);
+    passes.AddPass("VerificationPass", [](IR::Block& block) { VerificationPass(block); });
+    return passes;
+}
+
+void BenchmarkDecode(std::mt19937& rng, size_t count) {
+    std::vector<u32> instructions(count);
+    for (u32& instruction : instructions) {
+        instruction = static_cast<u32>(rng());
+    }
+
+    size_t matched = 0;
+    const double arm_ns = TimeNanoseconds([&] {
+        for (u32 instruction : instructions) {
+            matched += static_cast<bool>(Arm::DecodeArm<Arm::ArmTranslatorVisitor>(instruction));
+        }
+    });
+    const double vfp_ns = TimeNanoseconds([&] {
+        for (u32 instruction : instructions) {
+            matched += static_cast<bool>(Arm::DecodeVFP2<Arm::ArmTranslatorVisitor>(instruction));
+        }
+    });
+
+    Report("decode_arm", count, arm_ns, "instructions");
+    Report("decode_vfp2", count, vfp_ns, "instructions");
+    std::fprintf(stderr, "(%zu matched)\n", matched);
+}
+
+void BenchmarkTranslate(std::mt19937& rng, const std::vector<std::vector<u32>>& pools, size_t block_count) {
+    std::vector<u32> mixed_pool;
+    for (const auto& pool : pools) {
+        mixed_pool.insert(mixed_pool.end(), pool.begin(), pool.end());
+    }
+    LayOutBlocks(rng, mixed_pool, block_count);
+
+    size_t instructions = 0;
+    const double arm_ns = TimeNanoseconds([&] {
+        for (const IR::Block& block : TranslateBlocks(block_count)) {
+            instructions += block.CycleCount();
+        }
+    });
+    Report("translate_arm", instructions, arm_ns, "instructions");
+
+    // The Thumb decoders are private to the Thumb translator, so Thumb decoding is only measured as part of translation.
+    LayOutThumbBlocks(rng, GenerateThumbPool(rng, 256), block_count);
+    instructions = 0;
+    const double thumb_ns = TimeNanoseconds([&] {
+        for (size_t block = 0; block < block_count; block++) {
+            instructions += Arm::Translate(BlockLocation(block, true), &ReadCode).CycleCount();
+        }
+    });
+    Report("translate_thumb", instructions, thumb_ns, "instructions");
+}
+
+void BenchmarkPasses(std::mt19937& rng, const std::vector<std::vector<u32>>& pools, size_t block_count, const UserCallbacks& callbacks) {
+    const Optimization::PassManager passes = BuildHotPipeline(callbacks);
+
+    for (size_t i = 0; i < instruction_classes.size(); i++) {
+        LayOutBlocks(rng, pools[i], block_count);
+        for (IR::Block& block : TranslateBlocks(block_count)) {
+            passes.Run(block);
+        }
+    }
+
+    for (const auto& pass : passes.GetStatistics()) {
+        std::printf("{\"benchmark\": \"pass.%s\", \"runs\": %llu, \"ns_per_run\": %.2f, \"instructions_before\": %llu, \"instructions_after\": %llu}\n",
+                    pass.name.c_str(), static_cast<unsigned long long>(pass.runs), static_cast<double>(pass.time_ns) / static_cast<double>(pass.runs),
+                    static_cast<unsigned long long>(pass.instructions_before), static_cast<unsigned long long>(pass.instructions_after));
+    }
+}
+
+void BenchmarkEmit(std::mt19937& rng, const std::vector<std::vector<u32>>& pools, size_t block_count, const UserCallbacks& callbacks) {
+    const Optimization::PassManager passes = BuildHotPipeline(callbacks);
+    BackendX64::BlockOfCode block_of_code{callbacks};
+    BackendX64::EmitX64 emitter{&block_of_code, callbacks};
+
+    for (size_t i = 0; i < instruction_classes.size(); i++) {
+        LayOutBlocks(rng, pools[i], block_count);
+        std::vector<IR::Block> blocks = TranslateBlocks(block_count);
+        size_t instructions = 0;
+        for (IR::Block& block : blocks) {
+            passes.Run(block);
+            instructions += block.CycleCount();
+        }
+
+        block_of_code.ClearCache();
+        emitter.ClearCache();
+
+        double ns = 0;
+        size_t code_bytes = 0;
+        for (IR::Block& block : blocks) {
+            if (block_of_code.IsCurrentRegionNearlyFull()) {
+                block_of_code.ClearCache();
+                emitter.ClearCache();
+            }
+            ns += TimeNanoseconds([&] { code_bytes += emitter.Emit(block, BackendX64::EmitX64::Profiling::None).size; });
+        }
+
+        Report(std::string("emit.") + instruction_classes[i].second, instructions, ns, "instructions");
+        std::printf("{\"benchmark\": \"code_size.%s\", \"instructions\": %zu, \"bytes_per_item\": %.2f}\n",
+                    instruction_classes[i].second, instructions, static_cast<double>(code_bytes) / static_cast<double>(instructions));
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const size_t block_count = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 1000;
+
+    std::mt19937 rng{42};
+
+    UserCallbacks callbacks{};
+    callbacks.memory.ReadCode = &ReadCode;
+
+    BenchmarkDecode(rng, block_count * block_length * 16);
+
+    const auto pools = GenerateInstructionPools(rng, 256);
+    BenchmarkTranslate(rng, pools, block_count);
+    BenchmarkPasses(rng, pools, block_count, callbacks);
+    BenchmarkEmit(rng, pools, block_count, callbacks);
+
+    return 0;
+}
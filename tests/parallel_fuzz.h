@@ -0,0 +1,63 @@
+/* This file is part of the dynarmic project.
+ * Copyright (c) 2016 MerryMage
+ * This software may be used and distributed according to the terms of the GNU
+ * General Public License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fuzz tests can be scaled up for long runs with two environment variables:
+//   DYNARMIC_FUZZ_THREADS: The number of worker threads each fuzz test is split across (default 1).
+//   DYNARMIC_FUZZ_RUN_MULTIPLIER: A factor to multiply the number of runs of each fuzz test by (default 1).
+// Each worker thread has its own Jit and interpreter, which it reuses for all of its runs.
+
+inline size_t GetEnvironmentSize(const char* name, size_t default_value) {
+    const char* value = std::getenv(name);
+    if (!value)
+        return default_value;
+    const size_t parsed = std::strtoull(value, nullptr, 0);
+    return parsed != 0 ? parsed : default_value;
+}
+
+/// Held by a worker thread while it prints a failure report, so that reports are not interleaved.
+inline std::mutex& FuzzReportMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/**
+ * Splits run_count runs between the worker threads. run_batch(worker_index, batch_run_count) is called
+ * once per worker, and returns false if it found a failure. Returns true if no worker found a failure.
+ * When there is only one worker, run_batch is called on the calling thread.
+ */
+template <typename RunBatchFn>
+bool RunFuzzBatches(size_t run_count, RunBatchFn run_batch) {
+    run_count *= GetEnvironmentSize("DYNARMIC_FUZZ_RUN_MULTIPLIER", 1);
+    const size_t worker_count = std::min(GetEnvironmentSize("DYNARMIC_FUZZ_THREADS", 1), run_count);
+
+    if (worker_count <= 1)
+        return run_batch(0, run_count);
+
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for (size_t worker_index = 0; worker_index < worker_count; worker_index++) {
+        const size_t batch_run_count = run_count / worker_count + (worker_index < run_count % worker_count ? 1 : 0);
+        workers.emplace_back([&run_batch, &failed, worker_index, batch_run_count] {
+            if (!run_batch(worker_index, batch_run_count)) {
+                failed = true;
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    return !failed;
+}
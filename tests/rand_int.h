@@ -13,8 +13,9 @@ T RandInt(T min, T max) {
     static_assert(!std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value,
                   "Using char with uniform_int_distribution is undefined behavior.");
 
-    static std::random_device rd;
-    static std::mt19937 mt(rd());
+    // Each thread has its own generator with its own seed, so fuzz tests can run on several threads.
+    thread_local std::random_device rd;
+    thread_local std::mt19937 mt(rd());
     std::uniform_int_distribution<T> rand(min, max);
     return rand(mt);
 }
@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <memory>
 
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -12,10 +13,17 @@
 #define LOG_INFO(...) do{}while(0)
 #define LOG_TRACE(...) do{}while(0)
 
-char trans_cache_buf[TRANS_CACHE_SIZE];
-size_t trans_cache_buf_top = 0;
+// Each thread has its own translation cache, so interpreters can run on several threads at once.
+static thread_local std::unique_ptr<char[]> trans_cache_storage;
+thread_local char* trans_cache_buf = nullptr;
+thread_local size_t trans_cache_buf_top = 0;
 
 static void* AllocBuffer(size_t size) {
+    if (!trans_cache_buf) {
+        trans_cache_storage.reset(new char[TRANS_CACHE_SIZE]);
+        trans_cache_buf = trans_cache_storage.get();
+    }
+
     size_t start = trans_cache_buf_top;
     trans_cache_buf_top += size;
     ASSERT_MSG(trans_cache_buf_top <= TRANS_CACHE_SIZE, "Translation cache is full!");
@@ -495,5 +495,5 @@ extern const transop_fp_t arm_instruction_trans[];
 extern const size_t arm_instruction_trans_len;
 
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
-extern char trans_cache_buf[TRANS_CACHE_SIZE];
-extern size_t trans_cache_buf_top;
+extern thread_local char* trans_cache_buf;
+extern thread_local size_t trans_cache_buf_top;